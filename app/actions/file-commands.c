@@ -294,6 +294,7 @@ file_save_cmd_callback (GimpAction *action,
                                                    GIMP_RUN_WITH_LAST_VALS,
                                                    TRUE, FALSE, FALSE,
                                                    gimp_image_get_xcf_compression (image),
+                                                   gimp_image_get_xcf_mipmaps (image),
                                                    TRUE);
               break;
             }
@@ -369,7 +370,7 @@ file_save_cmd_callback (GimpAction *action,
                                                  GIMP_RUN_WITH_LAST_VALS,
                                                  FALSE,
                                                  overwrite, ! overwrite,
-                                                 FALSE, TRUE);
+                                                 FALSE, FALSE, TRUE);
           }
       }
       break;
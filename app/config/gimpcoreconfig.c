@@ -98,6 +98,7 @@ enum
   PROP_DEFAULT_GRID,
   PROP_UNDO_LEVELS,
   PROP_UNDO_SIZE,
+  PROP_UNDO_COMPRESSION,
   PROP_UNDO_PREVIEW_SIZE,
   PROP_FILTER_HISTORY_SIZE,
   PROP_PLUGINRC_PATH,
@@ -106,8 +107,13 @@ enum
   PROP_LAYER_PREVIEW_SIZE,
   PROP_THUMBNAIL_SIZE,
   PROP_THUMBNAIL_FILESIZE_LIMIT,
+  PROP_PROJECTION_RENDER_ASYNC,
   PROP_COLOR_MANAGEMENT,
   PROP_SAVE_DOCUMENT_HISTORY,
+  PROP_XCF_ZSTD_COMPRESSION,
+  PROP_XCF_ZSTD_LEVEL,
+  PROP_XCF_LAZY_LOAD,
+  PROP_XCF_PROGRESSIVE_LOAD,
   PROP_QUICK_MASK_COLOR,
   PROP_IMPORT_PROMOTE_FLOAT,
   PROP_IMPORT_PROMOTE_DITHER,
@@ -575,6 +581,13 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                             GIMP_PARAM_STATIC_STRINGS |
                             GIMP_CONFIG_PARAM_CONFIRM);
 
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_UNDO_COMPRESSION,
+                            "undo-compression",
+                            "Undo compression",
+                            UNDO_COMPRESSION_BLURB,
+                            TRUE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_ENUM (object_class, PROP_UNDO_PREVIEW_SIZE,
                          "undo-preview-size",
                          "Undo preview size",
@@ -639,6 +652,13 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                             0, GIMP_MAX_MEMSIZE, 1 << 22,
                             GIMP_PARAM_STATIC_STRINGS);
 
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_PROJECTION_RENDER_ASYNC,
+                            "projection-render-async",
+                            "Render the image in the background",
+                            PROJECTION_RENDER_ASYNC_BLURB,
+                            FALSE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_OBJECT (object_class, PROP_COLOR_MANAGEMENT,
                            "color-management",
                            "Color management",
@@ -696,6 +716,34 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                             TRUE,
                             GIMP_PARAM_STATIC_STRINGS);
 
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_XCF_ZSTD_COMPRESSION,
+                            "xcf-zstd-compression",
+                            "Use zstd for XCF compression",
+                            XCF_ZSTD_COMPRESSION_BLURB,
+                            FALSE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_INT (object_class, PROP_XCF_ZSTD_LEVEL,
+                        "xcf-zstd-level",
+                        "XCF zstd compression level",
+                        XCF_ZSTD_LEVEL_BLURB,
+                        1, 19, 3,
+                        GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_XCF_LAZY_LOAD,
+                            "xcf-lazy-load",
+                            "Load XCF files lazily",
+                            XCF_LAZY_LOAD_BLURB,
+                            FALSE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
+  GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_XCF_PROGRESSIVE_LOAD,
+                            "xcf-progressive-load",
+                            "Load XCF files progressively",
+                            XCF_PROGRESSIVE_LOAD_BLURB,
+                            TRUE,
+                            GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_RGB (object_class, PROP_QUICK_MASK_COLOR,
                         "quick-mask-color",
                         "Quick mask color",
@@ -1076,6 +1124,9 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_UNDO_SIZE:
       core_config->undo_size = g_value_get_uint64 (value);
       break;
+    case PROP_UNDO_COMPRESSION:
+      core_config->undo_compression = g_value_get_boolean (value);
+      break;
     case PROP_UNDO_PREVIEW_SIZE:
       core_config->undo_preview_size = g_value_get_enum (value);
       break;
@@ -1098,6 +1149,9 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_THUMBNAIL_FILESIZE_LIMIT:
       core_config->thumbnail_filesize_limit = g_value_get_uint64 (value);
       break;
+    case PROP_PROJECTION_RENDER_ASYNC:
+      core_config->projection_render_async = g_value_get_boolean (value);
+      break;
     case PROP_COLOR_MANAGEMENT:
       if (g_value_get_object (value))
         gimp_config_sync (g_value_get_object (value),
@@ -1130,6 +1184,18 @@ gimp_core_config_set_property (GObject      *object,
     case PROP_SAVE_DOCUMENT_HISTORY:
       core_config->save_document_history = g_value_get_boolean (value);
       break;
+    case PROP_XCF_ZSTD_COMPRESSION:
+      core_config->xcf_zstd_compression = g_value_get_boolean (value);
+      break;
+    case PROP_XCF_ZSTD_LEVEL:
+      core_config->xcf_zstd_level = g_value_get_int (value);
+      break;
+    case PROP_XCF_LAZY_LOAD:
+      core_config->xcf_lazy_load = g_value_get_boolean (value);
+      break;
+    case PROP_XCF_PROGRESSIVE_LOAD:
+      core_config->xcf_progressive_load = g_value_get_boolean (value);
+      break;
     case PROP_QUICK_MASK_COLOR:
       gimp_value_get_rgb (value, &core_config->quick_mask_color);
       break;
@@ -1348,6 +1414,9 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_UNDO_SIZE:
       g_value_set_uint64 (value, core_config->undo_size);
       break;
+    case PROP_UNDO_COMPRESSION:
+      g_value_set_boolean (value, core_config->undo_compression);
+      break;
     case PROP_UNDO_PREVIEW_SIZE:
       g_value_set_enum (value, core_config->undo_preview_size);
       break;
@@ -1369,6 +1438,9 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_THUMBNAIL_FILESIZE_LIMIT:
       g_value_set_uint64 (value, core_config->thumbnail_filesize_limit);
       break;
+    case PROP_PROJECTION_RENDER_ASYNC:
+      g_value_set_boolean (value, core_config->projection_render_async);
+      break;
     case PROP_COLOR_MANAGEMENT:
       g_value_set_object (value, core_config->color_management);
       break;
@@ -1396,6 +1468,18 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_SAVE_DOCUMENT_HISTORY:
       g_value_set_boolean (value, core_config->save_document_history);
       break;
+    case PROP_XCF_ZSTD_COMPRESSION:
+      g_value_set_boolean (value, core_config->xcf_zstd_compression);
+      break;
+    case PROP_XCF_ZSTD_LEVEL:
+      g_value_set_int (value, core_config->xcf_zstd_level);
+      break;
+    case PROP_XCF_LAZY_LOAD:
+      g_value_set_boolean (value, core_config->xcf_lazy_load);
+      break;
+    case PROP_XCF_PROGRESSIVE_LOAD:
+      g_value_set_boolean (value, core_config->xcf_progressive_load);
+      break;
     case PROP_QUICK_MASK_COLOR:
       gimp_value_set_rgb (value, &core_config->quick_mask_color);
       break;
@@ -82,6 +82,7 @@ struct _GimpCoreConfig
   GimpGrid               *default_grid;
   gint                    levels_of_undo;
   guint64                 undo_size;
+  gboolean                undo_compression;
   GimpViewSize            undo_preview_size;
   gint                    filter_history_size;
   gchar                  *plug_in_rc_path;
@@ -90,8 +91,13 @@ struct _GimpCoreConfig
   GimpViewSize            layer_preview_size;
   GimpThumbnailSize       thumbnail_size;
   guint64                 thumbnail_filesize_limit;
+  gboolean                projection_render_async;
   GimpColorConfig        *color_management;
   gboolean                save_document_history;
+  gboolean                xcf_zstd_compression;
+  gint                    xcf_zstd_level;
+  gboolean                xcf_lazy_load;
+  gboolean                xcf_progressive_load;
   GimpRGB                 quick_mask_color;
   gboolean                import_promote_float;
   gboolean                import_promote_dither;
@@ -377,6 +377,12 @@ _("Sets whether GIMP should create previews of layer groups. " \
 _("Sets the preview size used for layers and channel previews in newly " \
   "created dialogs.")
 
+#define PROJECTION_RENDER_ASYNC_BLURB \
+_("Render the image on a worker thread, instead of between other tasks " \
+  "of the user interface.  This is experimental: changes made to the " \
+  "image while a part of it is being rendered can show up in that part " \
+  "only partially, until it is rendered again.")
+
 #define QUICK_MASK_COLOR_BLURB \
 _("Sets the default quick mask color.")
 
@@ -758,6 +764,10 @@ _("Sets an upper limit to the memory that is used per image to keep " \
   "operations on the undo stack. Regardless of this setting, at least " \
   "as many undo-levels as configured can be undone.")
 
+#define UNDO_COMPRESSION_BLURB \
+_("When enabled, the pixel data of undo steps is compressed in the " \
+  "background, so that more undo steps fit into the undo-size limit.")
+
 #define UNDO_PREVIEW_SIZE_BLURB \
 _("Sets the size of the previews in the Undo History.")
 
@@ -775,6 +785,25 @@ _("When enabled, uses OpenCL for some operations.")
 "The location of the online user manual. This is used if " \
 "'user-manual-online' is enabled."
 
+#define XCF_ZSTD_COMPRESSION_BLURB \
+_("When saving XCF files with compression, use the zstd codec, which " \
+  "compresses and decompresses faster than zlib.  Such files can't be " \
+  "opened with GIMP versions older than 3.0.")
+
+#define XCF_ZSTD_LEVEL_BLURB \
+_("The zstd compression level used for XCF files.  Higher levels compress " \
+  "better, but save more slowly.")
+
+#define XCF_LAZY_LOAD_BLURB \
+_("When opening XCF files, only read the pixels of a layer once they are " \
+  "needed, instead of loading them in the background.  This uses less " \
+  "memory for large files, which are kept open while they are edited.")
+
+#define XCF_PROGRESSIVE_LOAD_BLURB \
+_("When opening XCF files saved with mipmap levels, show the image from " \
+  "the levels right away and load the full resolution pixels in the " \
+  "background.")
+
 #define ZOOM_QUALITY_BLURB \
 "There's a tradeoff between speed and quality of the zoomed-out display."
 
@@ -196,6 +196,7 @@ typedef struct _GimpAsync                       GimpAsync;
 typedef struct _GimpAsyncSet                    GimpAsyncSet;
 typedef struct _GimpBuffer                      GimpBuffer;
 typedef struct _GimpDrawableFilter              GimpDrawableFilter;
+typedef struct _GimpDrawableHistogram           GimpDrawableHistogram;
 typedef struct _GimpEnvironTable                GimpEnvironTable;
 typedef struct _GimpExtension                   GimpExtension;
 typedef struct _GimpExtensionManager            GimpExtensionManager;
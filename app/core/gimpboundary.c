@@ -26,12 +26,16 @@
 
 #include "core-types.h"
 
+#include "gimp-atomic.h"
 #include "gimpboundary.h"
 
 
 /* GimpBoundSeg array growth parameter */
 #define MAX_SEGS_INC  2048
 
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 128.0 * 128.0 /* pixels */)
+
 
 typedef struct _GimpBoundary GimpBoundary;
 
@@ -52,6 +56,53 @@ struct _GimpBoundary
   gint          max_empty_segs;
 };
 
+typedef struct
+{
+  GeglBuffer          *buffer;
+  const GeglRectangle *region;
+  const Babl          *format;
+  GimpBoundaryType     type;
+  gint                 x1;
+  gint                 y1;
+  gint                 x2;
+  gint                 y2;
+  gfloat               threshold;
+
+  /*  The scanlines to process  */
+  gint                 start;
+  gint                 end;
+
+  /*  The processed bands of scanlines, in no particular order  */
+  GSList              *bands;
+} BoundaryData;
+
+typedef struct
+{
+  gint          start;     /*  The first scanline of the band  */
+  GimpBoundary *boundary;  /*  The band's horizontal segments  */
+} BoundaryBand;
+
+typedef struct
+{
+  gint x;
+  gint y;
+  gint first;  /*  The first node of the point's list, or -1  */
+  gint last;   /*  The last node of the point's list          */
+} SegPoint;
+
+typedef struct
+{
+  /*  The segment endpoints, hashed by their coordinates  */
+  SegPoint *points;
+  guint     mask;
+
+  /*  For each endpoint, the next endpoint at the same point, or -1.
+   *  Endpoint "i" is the start (i even) or the end (i odd) of segment
+   *  "i / 2", and the lists are sorted by segment.
+   */
+  gint     *next;
+} SegPointTable;
+
 
 /*  local function prototypes  */
 
@@ -91,6 +142,11 @@ static void           make_horiz_segs          (GimpBoundary        *boundary,
                                                 gint                 empty[],
                                                 gint                 num_empty,
                                                 gint                 top);
+static void           generate_boundary_band   (gsize                offset,
+                                                gsize                size,
+                                                BoundaryData        *data);
+static gint           boundary_band_compare    (const BoundaryBand  *band1,
+                                                const BoundaryBand  *band2);
 static GimpBoundary * generate_boundary        (GeglBuffer          *buffer,
                                                 const GeglRectangle *region,
                                                 const Babl          *format,
@@ -99,29 +155,23 @@ static GimpBoundary * generate_boundary        (GeglBuffer          *buffer,
                                                 gint                 y1,
                                                 gint                 x2,
                                                 gint                 y2,
-                                                gfloat               threshold);
-
-static gint       cmp_segptr_xy1_addr     (const GimpBoundSeg **seg_ptr_a,
-                                           const GimpBoundSeg **seg_ptr_b);
-static gint       cmp_segptr_xy2_addr     (const GimpBoundSeg **seg_ptr_a,
-                                           const GimpBoundSeg **seg_ptr_b);
-
-static gint       cmp_segptr_xy1          (const GimpBoundSeg **seg_ptr_a,
-                                           const GimpBoundSeg **seg_ptr_b);
-static gint       cmp_segptr_xy2          (const GimpBoundSeg **seg_ptr_a,
-                                           const GimpBoundSeg **seg_ptr_b);
+                                                gfloat               threshold,
+                                                GimpBoundaryFind     find);
+
+static void       seg_point_table_init    (SegPointTable       *table,
+                                           const GimpBoundSeg  *segs,
+                                           gint                 num_segs);
+static void       seg_point_table_clear   (SegPointTable       *table);
+static SegPoint * seg_point_table_lookup  (SegPointTable       *table,
+                                           gint                 x,
+                                           gint                 y,
+                                           gboolean             insert);
 
-static const GimpBoundSeg * find_segment  (const GimpBoundSeg **segs_by_xy1,
-                                           const GimpBoundSeg **segs_by_xy2,
-                                           gint                 num_segs,
+static const GimpBoundSeg * find_segment  (SegPointTable       *table,
+                                           const GimpBoundSeg  *segs,
                                            gint                 x,
                                            gint                 y);
 
-static const GimpBoundSeg * find_segment_with_func (const GimpBoundSeg **segs,
-                                                    gint                 num_segs,
-                                                    const GimpBoundSeg  *search_seg,
-                                                    GCompareFunc         cmp_func);
-
 static void       simplify_subdivide  (const GimpBoundSeg  *segs,
                                        gint                 start_idx,
                                        gint                 end_idx,
@@ -163,6 +213,25 @@ gimp_boundary_find (GeglBuffer          *buffer,
                     int                  y2,
                     gfloat               threshold,
                     int                 *num_segs)
+{
+  return gimp_boundary_find_with_method (buffer, region, format, type,
+                                         x1, y1, x2, y2, threshold,
+                                         GIMP_BOUNDARY_FIND_AUTO,
+                                         num_segs);
+}
+
+GimpBoundSeg *
+gimp_boundary_find_with_method (GeglBuffer          *buffer,
+                                const GeglRectangle *region,
+                                const Babl          *format,
+                                GimpBoundaryType     type,
+                                gint                 x1,
+                                gint                 y1,
+                                gint                 x2,
+                                gint                 y2,
+                                gfloat               threshold,
+                                GimpBoundaryFind     find,
+                                gint                *num_segs)
 {
   GimpBoundary  *boundary;
   GeglRectangle  rect = { 0, };
@@ -184,7 +253,7 @@ gimp_boundary_find (GeglBuffer          *buffer,
     }
 
   boundary = generate_boundary (buffer, &rect, format, type,
-                                x1, y1, x2, y2, threshold);
+                                x1, y1, x2, y2, threshold, find);
 
   *num_segs = boundary->num_segs;
 
@@ -210,8 +279,7 @@ gimp_boundary_sort (const GimpBoundSeg *segs,
                     gint               *num_groups)
 {
   GimpBoundary        *boundary;
-  const GimpBoundSeg **segs_ptrs_by_xy1;
-  const GimpBoundSeg **segs_ptrs_by_xy2;
+  SegPointTable        table;
   gint                 index;
   gint                 x, y;
   gint                 startx, starty;
@@ -225,22 +293,10 @@ gimp_boundary_sort (const GimpBoundSeg *segs,
   if (num_segs == 0)
     return NULL;
 
-  /* prepare arrays with GimpBoundSeg pointers sorted by xy1 and xy2
-   * accordingly
+  /* hash the segments by their endpoints, so that we can find the
+   * segments connected to a point in constant time
    */
-  segs_ptrs_by_xy1 = g_new (const GimpBoundSeg *, num_segs);
-  segs_ptrs_by_xy2 = g_new (const GimpBoundSeg *, num_segs);
-
-  for (index = 0; index < num_segs; index++)
-    {
-      segs_ptrs_by_xy1[index] = segs + index;
-      segs_ptrs_by_xy2[index] = segs + index;
-    }
-
-  qsort (segs_ptrs_by_xy1, num_segs, sizeof (GimpBoundSeg *),
-         (GCompareFunc) cmp_segptr_xy1_addr);
-  qsort (segs_ptrs_by_xy2, num_segs, sizeof (GimpBoundSeg *),
-         (GCompareFunc) cmp_segptr_xy2_addr);
+  seg_point_table_init (&table, segs, num_segs);
 
   for (index = 0; index < num_segs; index++)
     ((GimpBoundSeg *) segs)[index].visited = FALSE;
@@ -266,8 +322,7 @@ gimp_boundary_sort (const GimpBoundSeg *segs,
       x = segs[index].x2;
       y = segs[index].y2;
 
-      while ((cur_seg = find_segment (segs_ptrs_by_xy1, segs_ptrs_by_xy2,
-                                      num_segs, x, y)) != NULL)
+      while ((cur_seg = find_segment (&table, segs, x, y)) != NULL)
         {
           /*  make sure ordering is correct  */
           if (x == cur_seg->x1 && y == cur_seg->y1)
@@ -300,8 +355,7 @@ gimp_boundary_sort (const GimpBoundSeg *segs,
       gimp_boundary_add_seg (boundary, -1, -1, -1, -1, 0);
   }
 
-  g_free (segs_ptrs_by_xy1);
-  g_free (segs_ptrs_by_xy2);
+  seg_point_table_clear (&table);
 
   return gimp_boundary_free (boundary, FALSE);
 }
@@ -650,32 +704,28 @@ make_horiz_segs (GimpBoundary *boundary,
 
       if (e_s <= start && e_e >= end)
         {
-          process_horiz_seg (boundary,
-                             start, scanline, end, scanline, top);
+          gimp_boundary_add_seg (boundary,
+                                 start, scanline, end, scanline, top);
         }
       else if ((e_s > start && e_s < end) ||
                (e_e < end && e_e > start))
         {
-          process_horiz_seg (boundary,
-                             MAX (e_s, start), scanline,
-                             MIN (e_e, end), scanline, top);
+          gimp_boundary_add_seg (boundary,
+                                 MAX (e_s, start), scanline,
+                                 MIN (e_e, end), scanline, top);
         }
     }
 }
 
-static GimpBoundary *
-generate_boundary (GeglBuffer          *buffer,
-                   const GeglRectangle *region,
-                   const Babl          *format,
-                   GimpBoundaryType     type,
-                   gint                 x1,
-                   gint                 y1,
-                   gint                 x2,
-                   gint                 y2,
-                   gfloat               threshold)
+static void
+generate_boundary_band (gsize         offset,
+                        gsize         size,
+                        BoundaryData *data)
 {
+  BoundaryBand  *band;
   GimpBoundary  *boundary;
   GeglRectangle  line_rect = { 0, };
+  gfloat        *line_buf;
   gfloat        *line_data;
   gint           scanline;
   gint           i;
@@ -686,61 +736,67 @@ generate_boundary (GeglBuffer          *buffer,
   gint          num_empty_c = 0;
   gint          num_empty_l = 0;
 
-  boundary = gimp_boundary_new (region);
+  boundary = gimp_boundary_new (data->region);
 
-  line_rect.width  = gegl_buffer_get_width (buffer);
+  line_rect.width  = gegl_buffer_get_width (data->buffer);
   line_rect.height = 1;
 
-  line_data = g_alloca (sizeof (gfloat) * line_rect.width);
+  line_buf  = g_new (gfloat, line_rect.width);
+  line_data = line_buf;
 
-  start = 0;
-  end   = 0;
+  start = data->start + offset;
+  end   = start + size;
 
-  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
+  /*  Find the empty segments for the previous and current scanlines  */
+  if (start == data->start)
     {
-      start = y1;
-      end   = y2;
+      find_empty_segs (data->region, NULL,
+                       start - 1, boundary->empty_segs_l,
+                       boundary->max_empty_segs, &num_empty_l,
+                       data->type, data->x1, data->y1, data->x2, data->y2,
+                       data->threshold);
     }
-  else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
+  else
     {
-      start = region->y;
-      end   = region->y + region->height;
+      line_rect.y = start - 1;
+      gegl_buffer_get (data->buffer, &line_rect, 1.0, data->format,
+                       line_data, GEGL_AUTO_ROWSTRIDE,
+                       GEGL_ABYSS_NONE);
+
+      find_empty_segs (data->region, line_data,
+                       start - 1, boundary->empty_segs_l,
+                       boundary->max_empty_segs, &num_empty_l,
+                       data->type, data->x1, data->y1, data->x2, data->y2,
+                       data->threshold);
     }
 
-  /*  Find the empty segments for the previous and current scanlines  */
-  find_empty_segs (region, NULL,
-                   start - 1, boundary->empty_segs_l,
-                   boundary->max_empty_segs, &num_empty_l,
-                   type, x1, y1, x2, y2,
-                   threshold);
-
   line_rect.y = start;
-  gegl_buffer_get (buffer, &line_rect, 1.0, format,
+  gegl_buffer_get (data->buffer, &line_rect, 1.0, data->format,
                    line_data, GEGL_AUTO_ROWSTRIDE,
                    GEGL_ABYSS_NONE);
 
-  find_empty_segs (region, line_data,
+  find_empty_segs (data->region, line_data,
                    start, boundary->empty_segs_c,
                    boundary->max_empty_segs, &num_empty_c,
-                   type, x1, y1, x2, y2,
-                   threshold);
+                   data->type, data->x1, data->y1, data->x2, data->y2,
+                   data->threshold);
 
   for (scanline = start; scanline < end; scanline++)
     {
       /*  find the empty segment list for the next scanline  */
       line_rect.y = scanline + 1;
-      if (scanline + 1 == end)
+      if (scanline + 1 == data->end)
         line_data = NULL;
       else
-        gegl_buffer_get (buffer, &line_rect, 1.0, format,
+        gegl_buffer_get (data->buffer, &line_rect, 1.0, data->format,
                          line_data, GEGL_AUTO_ROWSTRIDE,
                          GEGL_ABYSS_NONE);
 
-      find_empty_segs (region, line_data,
+      find_empty_segs (data->region, line_data,
                        scanline + 1, boundary->empty_segs_n,
                        boundary->max_empty_segs, &num_empty_n,
-                       type, x1, y1, x2, y2,
-                       threshold);
+                       data->type, data->x1, data->y1, data->x2, data->y2,
+                       data->threshold);
 
       /*  process the segments on the current scanline  */
       for (i = 1; i < num_empty_c - 1; i += 2)
@@ -766,175 +822,233 @@ generate_boundary (GeglBuffer          *buffer,
       boundary->empty_segs_n = tmp_segs;
     }
 
-  return boundary;
+  g_free (line_buf);
+
+  band = g_slice_new (BoundaryBand);
+
+  band->start    = start;
+  band->boundary = boundary;
+
+  gimp_atomic_slist_push_head (&data->bands, band);
 }
 
-/*  sorting utility functions  */
+static gint
+boundary_band_compare (const BoundaryBand *band1,
+                       const BoundaryBand *band2)
+{
+  return band1->start - band2->start;
+}
 
-static inline gint
-cmp_xy (const gint ax,
-        const gint ay,
-        const gint bx,
-        const gint by)
+static GimpBoundary *
+generate_boundary (GeglBuffer          *buffer,
+                   const GeglRectangle *region,
+                   const Babl          *format,
+                   GimpBoundaryType     type,
+                   gint                 x1,
+                   gint                 y1,
+                   gint                 x2,
+                   gint                 y2,
+                   gfloat               threshold,
+                   GimpBoundaryFind     find)
 {
-  if (ay < by)
-    {
-      return -1;
-    }
-  else if (ay > by)
+  GimpBoundary *boundary;
+  BoundaryData  data;
+  GSList       *iter;
+
+  data.buffer    = buffer;
+  data.region    = region;
+  data.format    = format;
+  data.type      = type;
+  data.x1        = x1;
+  data.y1        = y1;
+  data.x2        = x2;
+  data.y2        = y2;
+  data.threshold = threshold;
+  data.start     = 0;
+  data.end       = 0;
+  data.bands     = NULL;
+
+  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
     {
-      return 1;
+      data.start = y1;
+      data.end   = y2;
     }
-  else if (ax < bx)
+  else if (type == GIMP_BOUNDARY_IGNORE_BOUNDS)
     {
-      return -1;
+      data.start = region->y;
+      data.end   = region->y + region->height;
     }
-  else if (ax > bx)
+
+  /*  The horizontal segments of each scanline only depend on the
+   *  scanline and its neighbors, so they are found for bands of
+   *  scanlines in parallel.
+   */
+  if (data.end <= data.start || find == GIMP_BOUNDARY_FIND_SERIAL)
     {
-      return 1;
+      generate_boundary_band (0, MAX (data.end - data.start, 0), &data);
     }
   else
     {
-      return 0;
-    }
-}
+      gdouble rows_per_thread = 1.0;
 
+      if (find == GIMP_BOUNDARY_FIND_AUTO)
+        rows_per_thread = PIXELS_PER_THREAD / MAX (region->width, 1);
 
-/*
- * Compares (x1, y1) pairs in specified segments, using their addresses if
- * (x1, y1) pairs are equal.
- */
-static gint
-cmp_segptr_xy1_addr (const GimpBoundSeg **seg_ptr_a,
-                     const GimpBoundSeg **seg_ptr_b)
-{
-  const GimpBoundSeg *seg_a = *seg_ptr_a;
-  const GimpBoundSeg *seg_b = *seg_ptr_b;
+      gegl_parallel_distribute_range (
+        data.end - data.start, rows_per_thread,
+        (GeglParallelDistributeRangeFunc) generate_boundary_band,
+        &data);
+    }
 
-  gint result = cmp_xy (seg_a->x1, seg_a->y1, seg_b->x1, seg_b->y1);
+  /*  Stitch the bands together, in order, adding the vertical
+   *  segments which close in the horizontal segments on the way.
+   *  This yields the same segments, in the same order, as processing
+   *  all the scanlines at once.
+   */
+  boundary = gimp_boundary_new (region);
+
+  data.bands = g_slist_sort (data.bands,
+                             (GCompareFunc) boundary_band_compare);
 
-  if (result == 0)
+  for (iter = data.bands; iter; iter = g_slist_next (iter))
     {
-      if (seg_a < seg_b)
-        result = -1;
-      else if (seg_a > seg_b)
-        result = 1;
+      BoundaryBand *band = iter->data;
+      gint          i;
+
+      for (i = 0; i < band->boundary->num_segs; i++)
+        {
+          const GimpBoundSeg *seg = &band->boundary->segs[i];
+
+          process_horiz_seg (boundary,
+                             seg->x1, seg->y1, seg->x2, seg->y2,
+                             seg->open);
+        }
+
+      gimp_boundary_free (band->boundary, TRUE);
+      g_slice_free (BoundaryBand, band);
     }
 
-  return result;
+  g_slist_free (data.bands);
+
+  return boundary;
 }
 
-/*
- * Compares (x2, y2) pairs in specified segments, using their addresses if
- * (x2, y2) pairs are equal.
- */
-static gint
-cmp_segptr_xy2_addr (const GimpBoundSeg **seg_ptr_a,
-                     const GimpBoundSeg **seg_ptr_b)
+/*  sorting utility functions  */
+
+static void
+seg_point_table_init (SegPointTable      *table,
+                      const GimpBoundSeg *segs,
+                      gint                num_segs)
 {
-  const GimpBoundSeg *seg_a = *seg_ptr_a;
-  const GimpBoundSeg *seg_b = *seg_ptr_b;
+  guint size = 1;
+  gint  i;
 
-  gint result = cmp_xy (seg_a->x2, seg_a->y2, seg_b->x2, seg_b->y2);
+  /*  keep the table at most half full  */
+  while (size < 4 * (guint) num_segs)
+    size <<= 1;
 
-  if (result == 0)
+  table->points = g_new (SegPoint, size);
+  table->mask   = size - 1;
+  table->next   = g_new (gint, 2 * num_segs);
+
+  for (i = 0; i < (gint) size; i++)
+    table->points[i].first = -1;
+
+  for (i = 0; i < 2 * num_segs; i++)
     {
-      if (seg_a < seg_b)
-        result = -1;
-      else if (seg_a > seg_b)
-        result = 1;
-    }
+      const GimpBoundSeg *seg = &segs[i / 2];
+      SegPoint           *point;
 
-  return result;
-}
+      if (i % 2 == 0)
+        point = seg_point_table_lookup (table, seg->x1, seg->y1, TRUE);
+      else
+        point = seg_point_table_lookup (table, seg->x2, seg->y2, TRUE);
 
+      if (point->first < 0)
+        point->first = i;
+      else
+        table->next[point->last] = i;
 
-/*
- * Compares (x1, y1) pairs in specified segments.
- */
-static gint
-cmp_segptr_xy1 (const GimpBoundSeg **seg_ptr_a,
-                const GimpBoundSeg **seg_ptr_b)
-{
-  const GimpBoundSeg *seg_a = *seg_ptr_a, *seg_b = *seg_ptr_b;
+      point->last    = i;
+      table->next[i] = -1;
+    }
+}
 
-  return cmp_xy (seg_a->x1, seg_a->y1, seg_b->x1, seg_b->y1);
+static void
+seg_point_table_clear (SegPointTable *table)
+{
+  g_free (table->points);
+  g_free (table->next);
 }
 
-/*
- * Compares (x2, y2) pairs in specified segments.
- */
-static gint
-cmp_segptr_xy2 (const GimpBoundSeg **seg_ptr_a,
-                const GimpBoundSeg **seg_ptr_b)
+static SegPoint *
+seg_point_table_lookup (SegPointTable *table,
+                        gint           x,
+                        gint           y,
+                        gboolean       insert)
 {
-  const GimpBoundSeg *seg_a = *seg_ptr_a;
-  const GimpBoundSeg *seg_b = *seg_ptr_b;
+  guint hash;
 
-  return cmp_xy (seg_a->x2, seg_a->y2, seg_b->x2, seg_b->y2);
-}
+  hash  = (guint) x * 0x9e3779b1u ^ (guint) y * 0x85ebca77u;
+  hash ^= hash >> 16;
 
+  while (TRUE)
+    {
+      SegPoint *point = &table->points[hash & table->mask];
 
-static const GimpBoundSeg *
-find_segment (const GimpBoundSeg **segs_by_xy1,
-              const GimpBoundSeg **segs_by_xy2,
-              gint                 num_segs,
-              gint                 x,
-              gint                 y)
-{
-  const GimpBoundSeg *segptr_xy1;
-  const GimpBoundSeg *segptr_xy2;
-  GimpBoundSeg        search_seg;
-
-  search_seg.x1 = search_seg.x2 = x;
-  search_seg.y1 = search_seg.y2 = y;
-
-  segptr_xy1 = find_segment_with_func (segs_by_xy1, num_segs, &search_seg,
-                                       (GCompareFunc) cmp_segptr_xy1);
-  segptr_xy2 = find_segment_with_func (segs_by_xy2, num_segs, &search_seg,
-                                       (GCompareFunc) cmp_segptr_xy2);
-
-  /* return segment with smaller address */
-  if (segptr_xy1 != NULL && segptr_xy2 != NULL)
-    return MIN(segptr_xy1, segptr_xy2);
-  else if (segptr_xy1 != NULL)
-    return segptr_xy1;
-  else if (segptr_xy2 != NULL)
-    return segptr_xy2;
+      if (point->first < 0)
+        {
+          if (! insert)
+            return NULL;
 
-  return NULL;
-}
+          point->x = x;
+          point->y = y;
 
+          return point;
+        }
+      else if (point->x == x && point->y == y)
+        {
+          return point;
+        }
+
+      hash++;
+    }
+}
 
+/*
+ * Returns the first non-visited segment, in memory order, which starts
+ * or ends at (x, y).
+ */
 static const GimpBoundSeg *
-find_segment_with_func (const GimpBoundSeg **segs,
-                        gint                 num_segs,
-                        const GimpBoundSeg  *search_seg,
-                        GCompareFunc         cmp_func)
+find_segment (SegPointTable      *table,
+              const GimpBoundSeg *segs,
+              gint                x,
+              gint                y)
 {
-  const GimpBoundSeg **seg;
-  const GimpBoundSeg *found_seg = NULL;
+  SegPoint *point;
+  gint      i;
+
+  point = seg_point_table_lookup (table, x, y, FALSE);
 
-  seg = bsearch (&search_seg, segs, num_segs, sizeof (GimpBoundSeg *), cmp_func);
+  if (! point)
+    return NULL;
 
-  if (seg != NULL)
+  /*  visited segments stay visited, so drop them from the list as we
+   *  go, but keep the point's slot occupied, for the probing to work
+   */
+  for (i = point->first; i >= 0; i = table->next[i])
     {
-      /* find first matching segment */
-      while (seg > segs && cmp_func (seg - 1, &search_seg) == 0)
-        seg--;
-
-      /* find first non-visited segment */
-      while (seg != segs + num_segs && cmp_func (seg, &search_seg) == 0)
-        if (!(*seg)->visited)
-          {
-            found_seg = *seg;
-            break;
-          }
-        else
-          seg++;
+      if (! segs[i / 2].visited)
+        {
+          point->first = i;
+
+          return &segs[i / 2];
+        }
     }
 
-    return found_seg;
+  point->first = point->last;
+
+  return NULL;
 }
 
 
@@ -64,5 +64,26 @@ void       gimp_boundary_offset        (GimpBoundSeg        *segs,
                                         gint                 off_x,
                                         gint                 off_y);
 
+/*  debug API for testing  */
+
+typedef enum
+{
+  GIMP_BOUNDARY_FIND_AUTO,
+  GIMP_BOUNDARY_FIND_SERIAL,
+  GIMP_BOUNDARY_FIND_PARALLEL
+} GimpBoundaryFind;
+
+GimpBoundSeg * gimp_boundary_find_with_method (GeglBuffer          *buffer,
+                                               const GeglRectangle *region,
+                                               const Babl          *format,
+                                               GimpBoundaryType     type,
+                                               gint                 x1,
+                                               gint                 y1,
+                                               gint                 x2,
+                                               gint                 y2,
+                                               gfloat               threshold,
+                                               GimpBoundaryFind     find,
+                                               gint                *num_segs);
+
 
 #endif  /*  __GIMP_BOUNDARY_H__  */
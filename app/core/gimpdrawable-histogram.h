@@ -17,8 +17,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#ifndef __GIMP_DRAWABLE_HISTOGRAM_H__
-#define __GIMP_DRAWABLE_HISTOGRAM_H__
+#ifndef __GIMP_DRAWABLE__HISTOGRAM_H__
+#define __GIMP_DRAWABLE__HISTOGRAM_H__
 
 
 void        gimp_drawable_calculate_histogram       (GimpDrawable  *drawable,
@@ -29,4 +29,4 @@ GimpAsync * gimp_drawable_calculate_histogram_async (GimpDrawable  *drawable,
                                                      gboolean       with_filters);
 
 
-#endif /* __GIMP_HISTOGRAM_H__ */
+#endif /* __GIMP_DRAWABLE__HISTOGRAM_H__ */
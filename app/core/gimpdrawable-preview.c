@@ -405,11 +405,48 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
                                      gint          src_height,
                                      gint          dest_width,
                                      gint          dest_height)
+{
+  return gimp_drawable_get_sub_preview_area_async (drawable,
+                                                   src_x, src_y,
+                                                   src_width, src_height,
+                                                   dest_width, dest_height,
+                                                   NULL);
+}
+
+/**
+ * gimp_drawable_get_sub_preview_area_async:
+ * @drawable:    a #GimpDrawable
+ * @src_x:       x coordinate of the previewed area of @drawable
+ * @src_y:       y coordinate of the previewed area of @drawable
+ * @src_width:   width of the previewed area of @drawable
+ * @src_height:  height of the previewed area of @drawable
+ * @dest_width:  width of the preview
+ * @dest_height: height of the preview
+ * @dest_area:   (nullable): the part of the preview to render
+ *
+ * Like gimp_drawable_get_sub_preview_async(), but only renders
+ * @dest_area of the preview, in preview coordinates, which must lie
+ * within the preview.  The result has the size of @dest_area, and is
+ * identical to the same area of the full preview, so it can be used
+ * to update a preview whose drawable changed in a small area.
+ *
+ * Returns: (nullable): a #GimpAsync, whose result is a #GimpTempBuf.
+ **/
+GimpAsync *
+gimp_drawable_get_sub_preview_area_async (GimpDrawable        *drawable,
+                                          gint                 src_x,
+                                          gint                 src_y,
+                                          gint                 src_width,
+                                          gint                 src_height,
+                                          gint                 dest_width,
+                                          gint                 dest_height,
+                                          const GeglRectangle *dest_area)
 {
   GimpItem       *item;
   GimpImage      *image;
   GeglBuffer     *buffer;
   SubPreviewData *data;
+  GeglRectangle   rect;
   gdouble         scale;
   gint            scaled_x;
   gint            scaled_y;
@@ -422,6 +459,10 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
   g_return_val_if_fail (src_height > 0, NULL);
   g_return_val_if_fail (dest_width  > 0, NULL);
   g_return_val_if_fail (dest_height > 0, NULL);
+  g_return_val_if_fail (dest_area == NULL ||
+                        gegl_rectangle_contains (
+                          GEGL_RECTANGLE (0, 0, dest_width, dest_height),
+                          dest_area), NULL);
 
   item = GIMP_ITEM (drawable);
 
@@ -441,33 +482,51 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
         (g_getenv ("GIMP_NO_ASYNC_DRAWABLE_PREVIEWS") != NULL);
     }
 
+  scale = MIN ((gdouble) dest_width  / (gdouble) src_width,
+               (gdouble) dest_height / (gdouble) src_height);
+
+  scaled_x = RINT ((gdouble) src_x * scale);
+  scaled_y = RINT ((gdouble) src_y * scale);
+
+  if (dest_area)
+    {
+      rect.x      = scaled_x + dest_area->x;
+      rect.y      = scaled_y + dest_area->y;
+      rect.width  = dest_area->width;
+      rect.height = dest_area->height;
+    }
+  else
+    {
+      rect.x      = scaled_x;
+      rect.y      = scaled_y;
+      rect.width  = dest_width;
+      rect.height = dest_height;
+    }
+
   if (no_async_drawable_previews)
     {
-      GimpAsync *async = gimp_async_new ();
+      GimpAsync   *async = gimp_async_new ();
+      GimpTempBuf *preview;
+
+      preview = gimp_temp_buf_new (rect.width, rect.height,
+                                   gimp_drawable_get_preview_format (drawable));
+
+      gegl_buffer_get (buffer, &rect, scale,
+                       gimp_temp_buf_get_format (preview),
+                       gimp_temp_buf_get_data (preview),
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
 
       gimp_async_finish_full (async,
-                              gimp_drawable_get_sub_preview (drawable,
-                                                             src_x,
-                                                             src_y,
-                                                             src_width,
-                                                             src_height,
-                                                             dest_width,
-                                                             dest_height),
+                              preview,
                               (GDestroyNotify) gimp_temp_buf_unref);
 
       return async;
     }
 
-  scale = MIN ((gdouble) dest_width  / (gdouble) src_width,
-               (gdouble) dest_height / (gdouble) src_height);
-
-  scaled_x = RINT ((gdouble) src_x * scale);
-  scaled_y = RINT ((gdouble) src_y * scale);
-
   data = sub_preview_data_new (
     gimp_drawable_get_preview_format (drawable),
     buffer,
-    GEGL_RECTANGLE (scaled_x, scaled_y, dest_width, dest_height),
+    &rect,
     scale);
 
   if (gimp_tile_handler_validate_get_assigned (buffer))
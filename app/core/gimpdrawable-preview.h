@@ -58,6 +58,15 @@ GimpAsync   * gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
                                                    gint          src_height,
                                                    gint          dest_width,
                                                    gint          dest_height);
+GimpAsync   * gimp_drawable_get_sub_preview_area_async
+                                                  (GimpDrawable        *drawable,
+                                                   gint                 src_x,
+                                                   gint                 src_y,
+                                                   gint                 src_width,
+                                                   gint                 src_height,
+                                                   gint                 dest_width,
+                                                   gint                 dest_height,
+                                                   const GeglRectangle *dest_area);
 
 
 #endif /* __GIMP_DRAWABLE__PREVIEW_H__ */
@@ -46,6 +46,7 @@
 #include "gimpfilterstack.h"
 #include "gimpimage.h"
 #include "gimpimage-colormap.h"
+#include "gimpimage-scale.h"
 #include "gimpimage-undo-push.h"
 #include "gimpmarshal.h"
 #include "gimppickable.h"
@@ -535,18 +536,35 @@ gimp_drawable_scale (GimpItem              *item,
   GimpDrawable *drawable = GIMP_DRAWABLE (item);
   GeglBuffer   *new_buffer;
 
-  new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                new_width, new_height),
-                                gimp_drawable_get_format (drawable));
+  /*  gimp_image_scale() may have scaled us already, in which case
+   *  this waits for the background scale, and reports its progress
+   */
+  new_buffer = gimp_image_scale_take_buffer (gimp_item_get_image (item),
+                                             drawable,
+                                             new_width, new_height,
+                                             progress);
 
-  gimp_gegl_apply_scale (gimp_drawable_get_buffer (drawable),
-                         progress, C_("undo-type", "Scale"),
-                         new_buffer,
-                         interpolation_type,
-                         ((gdouble) new_width /
-                          gimp_item_get_width  (item)),
-                         ((gdouble) new_height /
-                          gimp_item_get_height (item)));
+  if (new_buffer)
+    {
+      /*  the scaled buffer is complete only now  */
+      if (progress)
+        gimp_progress_set_value (progress, 1.0);
+    }
+  else
+    {
+      new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                                    new_width, new_height),
+                                    gimp_drawable_get_format (drawable));
+
+      gimp_gegl_apply_scale (gimp_drawable_get_buffer (drawable),
+                             progress, C_("undo-type", "Scale"),
+                             new_buffer,
+                             interpolation_type,
+                             ((gdouble) new_width /
+                              gimp_item_get_width  (item)),
+                             ((gdouble) new_height /
+                              gimp_item_get_height (item)));
+    }
 
   gimp_drawable_set_buffer_full (drawable, gimp_item_is_attached (item), NULL,
                                  new_buffer,
@@ -802,7 +820,8 @@ gimp_drawable_real_update (GimpDrawable *drawable,
                            gint          width,
                            gint          height)
 {
-  gimp_viewable_invalidate_preview (GIMP_VIEWABLE (drawable));
+  gimp_viewable_invalidate_preview_area (GIMP_VIEWABLE (drawable),
+                                         x, y, width, height);
 }
 
 static gint64
@@ -0,0 +1,746 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdrawablehistogram.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "core-types.h"
+
+#include "gegl/gimp-gegl-loops.h"
+
+#include "gimp-parallel.h"
+#include "gimpasync.h"
+#include "gimpchannel.h"
+#include "gimpdrawable.h"
+#include "gimpdrawable-filters.h"
+#include "gimpdrawable-histogram.h"
+#include "gimpdrawablehistogram.h"
+#include "gimphistogram.h"
+#include "gimpimage.h"
+
+
+/* GimpDrawableHistogram keeps the histogram of a drawable up to date
+ * incrementally.  The drawable is divided into tiles, whose partial
+ * histograms are cached, and whose sum is the drawable's histogram.
+ * When the drawable is updated, only the affected tiles are marked as
+ * dirty, and the next calculation only recalculates their partial
+ * histograms, subtracting their old contribution from the sum, and
+ * adding the new one.  Every MAX_INCREMENTAL_UPDATES calculations, the
+ * sum is rebuilt from the partial histograms instead, so that rounding
+ * errors of the fractional weights of selected pixels don't accumulate.
+ *
+ * Only the histogram editor uses it; the levels and curves tools only
+ * calculate the histogram once, when they start, and keep using
+ * gimp_drawable_calculate_histogram_async().
+ */
+
+
+/* the tile size is doubled until there are at most MAX_N_TILES tiles,
+ * to bound the memory used by the partial histograms
+ */
+#define MIN_TILE_SIZE 256
+#define MAX_N_TILES   256
+
+/* the number of incremental updates after which the sum is rebuilt */
+#define MAX_INCREMENTAL_UPDATES 32
+
+
+typedef struct
+{
+  gdouble  *values;
+  guint     stamp;
+  gboolean  dirty;
+} HistogramTile;
+
+struct _GimpDrawableHistogramPrivate
+{
+  GimpDrawable  *drawable;
+  GimpHistogram *histogram;
+  gboolean       with_filters;
+
+  gboolean       valid;
+  guint          generation;
+
+  GeglRectangle  rect;
+  gboolean       has_mask;
+  gint           offset_x;
+  gint           offset_y;
+
+  gint           tile_size;
+  gint           tile_x;
+  gint           tile_y;
+  gint           n_cols;
+  gint           n_rows;
+  HistogramTile *tiles;
+
+  gint           n_components;
+  gint           n_bins;
+  gint           n_values;
+  gdouble       *values;
+  gint           n_updates;
+
+  GimpAsync     *async;
+};
+
+typedef struct
+{
+  /*  input  */
+  GimpDrawableHistogram  *drawable_histogram;
+  GimpHistogram          *histogram;
+  guint                   generation;
+  GeglBuffer             *buffer;
+  GeglBuffer             *mask;
+  gint                    offset_x;
+  gint                    offset_y;
+  gint                    n_tiles;
+  gint                   *indices;
+  guint                  *stamps;
+  GeglRectangle          *rects;
+
+  /*  output  */
+  gdouble               **values;
+  gint                    n_components;
+  gint                    n_bins;
+  gint                    n_values;
+} CalculateData;
+
+
+/*  local function prototypes  */
+
+static void     gimp_drawable_histogram_finalize       (GObject               *object);
+
+static gint64   gimp_drawable_histogram_get_memsize    (GimpObject            *object,
+                                                        gint64                *gui_size);
+
+static void     gimp_drawable_histogram_setup          (GimpDrawableHistogram *drawable_histogram,
+                                                        const GeglRectangle   *rect,
+                                                        gboolean               has_mask,
+                                                        gint                   offset_x,
+                                                        gint                   offset_y);
+static void     gimp_drawable_histogram_get_tile_rect  (GimpDrawableHistogram *drawable_histogram,
+                                                        gint                   index,
+                                                        GeglRectangle         *rect);
+
+static void     gimp_drawable_histogram_drawable_update
+                                                       (GimpDrawable          *drawable,
+                                                        gint                   x,
+                                                        gint                   y,
+                                                        gint                   width,
+                                                        gint                   height,
+                                                        GimpDrawableHistogram *drawable_histogram);
+static void     gimp_drawable_histogram_mask_changed   (GimpDrawableHistogram *drawable_histogram);
+
+static void     gimp_drawable_histogram_calculate_func (GimpAsync             *async,
+                                                        CalculateData         *data);
+static void     gimp_drawable_histogram_calculate_async_callback
+                                                       (GimpAsync             *async,
+                                                        CalculateData         *data);
+static void     calculate_data_free                    (CalculateData         *data);
+
+
+G_DEFINE_TYPE_WITH_PRIVATE (GimpDrawableHistogram, gimp_drawable_histogram,
+                            GIMP_TYPE_OBJECT)
+
+#define parent_class gimp_drawable_histogram_parent_class
+
+
+static void
+gimp_drawable_histogram_class_init (GimpDrawableHistogramClass *klass)
+{
+  GObjectClass    *object_class      = G_OBJECT_CLASS (klass);
+  GimpObjectClass *gimp_object_class = GIMP_OBJECT_CLASS (klass);
+
+  object_class->finalize         = gimp_drawable_histogram_finalize;
+
+  gimp_object_class->get_memsize = gimp_drawable_histogram_get_memsize;
+}
+
+static void
+gimp_drawable_histogram_init (GimpDrawableHistogram *drawable_histogram)
+{
+  drawable_histogram->priv =
+    gimp_drawable_histogram_get_instance_private (drawable_histogram);
+}
+
+static void
+gimp_drawable_histogram_finalize (GObject *object)
+{
+  GimpDrawableHistogram        *drawable_histogram = GIMP_DRAWABLE_HISTOGRAM (object);
+  GimpDrawableHistogramPrivate *priv               = drawable_histogram->priv;
+
+  if (priv->async)
+    gimp_async_cancel_and_wait (priv->async);
+
+  gimp_drawable_histogram_invalidate (drawable_histogram);
+
+  g_clear_object (&priv->drawable);
+  g_clear_object (&priv->histogram);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gint64
+gimp_drawable_histogram_get_memsize (GimpObject *object,
+                                     gint64     *gui_size)
+{
+  GimpDrawableHistogramPrivate *priv    = GIMP_DRAWABLE_HISTOGRAM (object)->priv;
+  gint64                        memsize = 0;
+
+  if (priv->tiles)
+    {
+      gint n_tiles = priv->n_cols * priv->n_rows;
+      gint i;
+
+      memsize += n_tiles * sizeof (HistogramTile);
+
+      for (i = 0; i < n_tiles; i++)
+        {
+          if (priv->tiles[i].values)
+            memsize += priv->n_values * sizeof (gdouble);
+        }
+    }
+
+  if (priv->values)
+    memsize += priv->n_values * sizeof (gdouble);
+
+  return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
+                                                                  gui_size);
+}
+
+
+/*  public functions  */
+
+GimpDrawableHistogram *
+gimp_drawable_histogram_new (GimpDrawable  *drawable,
+                             GimpHistogram *histogram,
+                             gboolean       with_filters)
+{
+  GimpDrawableHistogram *drawable_histogram;
+  GimpImage             *image;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (GIMP_IS_HISTOGRAM (histogram), NULL);
+
+  drawable_histogram = g_object_new (GIMP_TYPE_DRAWABLE_HISTOGRAM, NULL);
+
+  drawable_histogram->priv->drawable     = g_object_ref (drawable);
+  drawable_histogram->priv->histogram    = g_object_ref (histogram);
+  drawable_histogram->priv->with_filters = with_filters;
+
+  g_signal_connect_object (drawable, "update",
+                           G_CALLBACK (gimp_drawable_histogram_drawable_update),
+                           drawable_histogram, 0);
+  g_signal_connect_object (drawable, "notify::buffer",
+                           G_CALLBACK (gimp_drawable_histogram_invalidate),
+                           drawable_histogram, G_CONNECT_SWAPPED);
+
+  image = gimp_item_get_image (GIMP_ITEM (drawable));
+
+  g_signal_connect_object (image, "mask-changed",
+                           G_CALLBACK (gimp_drawable_histogram_mask_changed),
+                           drawable_histogram, G_CONNECT_SWAPPED);
+
+  return drawable_histogram;
+}
+
+GimpDrawable *
+gimp_drawable_histogram_get_drawable (GimpDrawableHistogram *drawable_histogram)
+{
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_HISTOGRAM (drawable_histogram), NULL);
+
+  return drawable_histogram->priv->drawable;
+}
+
+GimpHistogram *
+gimp_drawable_histogram_get_histogram (GimpDrawableHistogram *drawable_histogram)
+{
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_HISTOGRAM (drawable_histogram), NULL);
+
+  return drawable_histogram->priv->histogram;
+}
+
+/**
+ * gimp_drawable_histogram_invalidate:
+ * @drawable_histogram: a #GimpDrawableHistogram
+ *
+ * Drops all cached partial histograms, so that the next calculation
+ * recalculates the entire histogram.
+ **/
+void
+gimp_drawable_histogram_invalidate (GimpDrawableHistogram *drawable_histogram)
+{
+  GimpDrawableHistogramPrivate *priv;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE_HISTOGRAM (drawable_histogram));
+
+  priv = drawable_histogram->priv;
+
+  if (priv->tiles)
+    {
+      gint n_tiles = priv->n_cols * priv->n_rows;
+      gint i;
+
+      for (i = 0; i < n_tiles; i++)
+        g_free (priv->tiles[i].values);
+
+      g_clear_pointer (&priv->tiles, g_free);
+    }
+
+  g_clear_pointer (&priv->values, g_free);
+
+  priv->valid     = FALSE;
+  priv->n_updates = 0;
+
+  /* make sure the results of a pending calculation are discarded */
+  priv->generation++;
+}
+
+/**
+ * gimp_drawable_histogram_calculate_async:
+ * @drawable_histogram: a #GimpDrawableHistogram
+ *
+ * Brings the histogram up to date with the drawable, recalculating
+ * only the parts of the drawable that changed since the last
+ * calculation.  Like gimp_drawable_calculate_histogram_async(), the
+ * histogram is calculated within the selection, and, if
+ * @drawable_histogram was created with @with_filters, the drawable's
+ * filters are taken into account; in this case, the entire histogram
+ * is recalculated.
+ *
+ * Returns: (transfer full): a #GimpAsync for the calculation.
+ **/
+GimpAsync *
+gimp_drawable_histogram_calculate_async (GimpDrawableHistogram *drawable_histogram)
+{
+  GimpDrawableHistogramPrivate *priv;
+  GimpItem                     *item;
+  GimpChannel                  *mask;
+  GimpAsync                    *async;
+  CalculateData                *data;
+  GeglBuffer                   *buffer;
+  GeglBuffer                   *mask_buffer = NULL;
+  GeglRectangle                 rect;
+  gboolean                      has_mask;
+  gint                          offset_x;
+  gint                          offset_y;
+  gint                          n_tiles;
+  gint                          n_dirty     = 0;
+  gint                          i;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE_HISTOGRAM (drawable_histogram), NULL);
+
+  priv = drawable_histogram->priv;
+  item = GIMP_ITEM (priv->drawable);
+
+  g_return_val_if_fail (gimp_item_is_attached (item), NULL);
+
+  if (priv->async)
+    gimp_async_cancel_and_wait (priv->async);
+
+  if (priv->with_filters && gimp_drawable_has_filters (priv->drawable))
+    {
+      /*  changes to the filters' output are not tracked per tile  */
+      gimp_drawable_histogram_invalidate (drawable_histogram);
+
+      return gimp_drawable_calculate_histogram_async (priv->drawable,
+                                                      priv->histogram,
+                                                      TRUE);
+    }
+
+  if (! gimp_item_mask_intersect (item,
+                                  &rect.x, &rect.y,
+                                  &rect.width, &rect.height))
+    {
+      gimp_drawable_histogram_invalidate (drawable_histogram);
+
+      async = gimp_async_new ();
+
+      gimp_async_finish (async, NULL);
+
+      return async;
+    }
+
+  mask     = gimp_image_get_mask (gimp_item_get_image (item));
+  has_mask = ! gimp_channel_is_empty (mask);
+
+  gimp_item_get_offset (item, &offset_x, &offset_y);
+
+  if (! priv->valid                             ||
+      ! gegl_rectangle_equal (&rect, &priv->rect) ||
+      has_mask != priv->has_mask                 ||
+      (has_mask && (offset_x != priv->offset_x ||
+                    offset_y != priv->offset_y)))
+    {
+      gimp_drawable_histogram_setup (drawable_histogram,
+                                     &rect, has_mask, offset_x, offset_y);
+    }
+
+  n_tiles = priv->n_cols * priv->n_rows;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (priv->tiles[i].dirty)
+        n_dirty++;
+    }
+
+  if (n_dirty == 0)
+    {
+      /*  the histogram might have been cleared in the meantime  */
+      if (priv->values &&
+          gimp_histogram_n_bins (priv->histogram) != priv->n_bins)
+        {
+          gimp_histogram_set_values (priv->histogram,
+                                     priv->n_components, priv->n_bins,
+                                     g_memdup2 (priv->values,
+                                                priv->n_values *
+                                                sizeof (gdouble)));
+        }
+
+      async = gimp_async_new ();
+
+      gimp_async_finish (async, NULL);
+
+      return async;
+    }
+
+  buffer = gimp_drawable_get_buffer (priv->drawable);
+
+  if (has_mask)
+    mask_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (mask));
+
+  data = g_slice_new0 (CalculateData);
+
+  data->drawable_histogram = drawable_histogram;
+  data->histogram          = g_object_ref (priv->histogram);
+  data->generation         = priv->generation;
+  data->offset_x           = offset_x;
+  data->offset_y           = offset_y;
+  data->n_tiles            = n_dirty;
+  data->indices            = g_new  (gint,          n_dirty);
+  data->stamps             = g_new  (guint,         n_dirty);
+  data->rects              = g_new  (GeglRectangle, n_dirty);
+  data->values             = g_new0 (gdouble *,     n_dirty);
+
+  /*  copy the dirty tiles, so that the drawable can keep changing while
+   *  we calculate.  the tiles are aligned to the buffer's tile grid, so
+   *  the copies are mostly cheap copy-on-write tile references.
+   */
+  data->buffer = gegl_buffer_new (gegl_buffer_get_extent (buffer),
+                                  gegl_buffer_get_format (buffer));
+
+  if (mask_buffer)
+    {
+      data->mask = gegl_buffer_new (gegl_buffer_get_extent (mask_buffer),
+                                    gegl_buffer_get_format (mask_buffer));
+    }
+
+  for (i = 0, n_dirty = 0; i < n_tiles; i++)
+    {
+      GeglRectangle *tile_rect = &data->rects[n_dirty];
+
+      if (! priv->tiles[i].dirty)
+        continue;
+
+      data->indices[n_dirty] = i;
+      data->stamps[n_dirty]  = priv->tiles[i].stamp;
+
+      gimp_drawable_histogram_get_tile_rect (drawable_histogram, i, tile_rect);
+
+      gimp_gegl_buffer_copy (buffer, tile_rect, GEGL_ABYSS_NONE,
+                             data->buffer, tile_rect);
+
+      if (mask_buffer)
+        {
+          GeglRectangle mask_rect = *tile_rect;
+
+          mask_rect.x += offset_x;
+          mask_rect.y += offset_y;
+
+          gimp_gegl_buffer_copy (mask_buffer, &mask_rect, GEGL_ABYSS_NONE,
+                                 data->mask, &mask_rect);
+        }
+
+      n_dirty++;
+    }
+
+  priv->async = gimp_parallel_run_async (
+    (GimpRunAsyncFunc) gimp_drawable_histogram_calculate_func,
+    data);
+
+  gimp_async_add_callback (
+    priv->async,
+    (GimpAsyncCallback) gimp_drawable_histogram_calculate_async_callback,
+    data);
+
+  return priv->async;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_drawable_histogram_setup (GimpDrawableHistogram *drawable_histogram,
+                               const GeglRectangle   *rect,
+                               gboolean               has_mask,
+                               gint                   offset_x,
+                               gint                   offset_y)
+{
+  GimpDrawableHistogramPrivate *priv = drawable_histogram->priv;
+  gint                          n_tiles;
+  gint                          i;
+
+  gimp_drawable_histogram_invalidate (drawable_histogram);
+
+  priv->rect     = *rect;
+  priv->has_mask = has_mask;
+  priv->offset_x = offset_x;
+  priv->offset_y = offset_y;
+
+  /*  the tile grid is anchored at the drawable's origin, and not at the
+   *  rect's, so that the tiles stay aligned to the buffer's tiles
+   */
+  for (priv->tile_size = MIN_TILE_SIZE; ; priv->tile_size *= 2)
+    {
+      priv->tile_x = rect->x / priv->tile_size;
+      priv->tile_y = rect->y / priv->tile_size;
+      priv->n_cols = (rect->x + rect->width  - 1) / priv->tile_size -
+                     priv->tile_x + 1;
+      priv->n_rows = (rect->y + rect->height - 1) / priv->tile_size -
+                     priv->tile_y + 1;
+
+      if (priv->n_cols * priv->n_rows <= MAX_N_TILES)
+        break;
+    }
+
+  n_tiles = priv->n_cols * priv->n_rows;
+
+  priv->tiles = g_new0 (HistogramTile, n_tiles);
+
+  for (i = 0; i < n_tiles; i++)
+    priv->tiles[i].dirty = TRUE;
+
+  priv->valid = TRUE;
+}
+
+static void
+gimp_drawable_histogram_get_tile_rect (GimpDrawableHistogram *drawable_histogram,
+                                       gint                   index,
+                                       GeglRectangle         *rect)
+{
+  GimpDrawableHistogramPrivate *priv = drawable_histogram->priv;
+
+  rect->x      = (priv->tile_x + index % priv->n_cols) * priv->tile_size;
+  rect->y      = (priv->tile_y + index / priv->n_cols) * priv->tile_size;
+  rect->width  = priv->tile_size;
+  rect->height = priv->tile_size;
+
+  gegl_rectangle_intersect (rect, rect, &priv->rect);
+}
+
+static void
+gimp_drawable_histogram_drawable_update (GimpDrawable          *drawable,
+                                         gint                   x,
+                                         gint                   y,
+                                         gint                   width,
+                                         gint                   height,
+                                         GimpDrawableHistogram *drawable_histogram)
+{
+  GimpDrawableHistogramPrivate *priv = drawable_histogram->priv;
+  GeglRectangle                 rect;
+  gint                          col1, col2;
+  gint                          row1, row2;
+  gint                          col, row;
+
+  if (! priv->valid ||
+      ! gegl_rectangle_intersect (&rect,
+                                  GEGL_RECTANGLE (x, y, width, height),
+                                  &priv->rect))
+    {
+      return;
+    }
+
+  col1 = rect.x / priv->tile_size - priv->tile_x;
+  row1 = rect.y / priv->tile_size - priv->tile_y;
+  col2 = (rect.x + rect.width  - 1) / priv->tile_size - priv->tile_x;
+  row2 = (rect.y + rect.height - 1) / priv->tile_size - priv->tile_y;
+
+  for (row = row1; row <= row2; row++)
+    {
+      for (col = col1; col <= col2; col++)
+        {
+          HistogramTile *tile = &priv->tiles[row * priv->n_cols + col];
+
+          tile->dirty = TRUE;
+          tile->stamp++;
+        }
+    }
+}
+
+static void
+gimp_drawable_histogram_mask_changed (GimpDrawableHistogram *drawable_histogram)
+{
+  /*  if the selection is emptied or created, the next calculation will
+   *  notice by itself
+   */
+  if (drawable_histogram->priv->has_mask)
+    gimp_drawable_histogram_invalidate (drawable_histogram);
+}
+
+static void
+gimp_drawable_histogram_calculate_func (GimpAsync     *async,
+                                        CalculateData *data)
+{
+  gint i;
+
+  for (i = 0; i < data->n_tiles; i++)
+    {
+      GeglRectangle mask_rect = data->rects[i];
+
+      if (gimp_async_is_canceled (async))
+        {
+          gimp_async_abort (async);
+
+          return;
+        }
+
+      mask_rect.x += data->offset_x;
+      mask_rect.y += data->offset_y;
+
+      data->values[i] = gimp_histogram_calculate_values (data->histogram,
+                                                         data->buffer,
+                                                         &data->rects[i],
+                                                         data->mask,
+                                                         &mask_rect,
+                                                         &data->n_components,
+                                                         &data->n_bins,
+                                                         &data->n_values);
+    }
+
+  gimp_async_finish (async, NULL);
+}
+
+static void
+gimp_drawable_histogram_calculate_async_callback (GimpAsync     *async,
+                                                  CalculateData *data)
+{
+  GimpDrawableHistogram        *drawable_histogram = data->drawable_histogram;
+  GimpDrawableHistogramPrivate *priv               = drawable_histogram->priv;
+
+  priv->async = NULL;
+
+  if (gimp_async_is_finished (async) &&
+      data->generation == priv->generation)
+    {
+      gint     n_tiles = priv->n_cols * priv->n_rows;
+      gboolean rebuild;
+      gint     i;
+      gint     j;
+
+      /*  when all tiles were recalculated, or after enough incremental
+       *  updates, rebuild the sum from the partial histograms, instead
+       *  of subtracting the old values, so that rounding errors don't
+       *  accumulate
+       */
+      rebuild = (! priv->values            ||
+                 data->n_tiles == n_tiles  ||
+                 ++priv->n_updates >= MAX_INCREMENTAL_UPDATES);
+
+      if (rebuild)
+        {
+          g_free (priv->values);
+
+          priv->n_components = data->n_components;
+          priv->n_bins       = data->n_bins;
+          priv->n_values     = data->n_values;
+          priv->values       = g_new0 (gdouble, priv->n_values);
+          priv->n_updates    = 0;
+        }
+
+      for (i = 0; i < data->n_tiles; i++)
+        {
+          HistogramTile *tile   = &priv->tiles[data->indices[i]];
+          gdouble       *values = data->values[i];
+
+          if (! rebuild)
+            {
+              if (tile->values)
+                {
+                  for (j = 0; j < priv->n_values; j++)
+                    priv->values[j] -= tile->values[j];
+                }
+
+              for (j = 0; j < priv->n_values; j++)
+                priv->values[j] += values[j];
+            }
+
+          g_free (tile->values);
+          tile->values    = values;
+          data->values[i] = NULL;
+
+          /*  the tile might have been updated again while we were busy  */
+          if (tile->stamp == data->stamps[i])
+            tile->dirty = FALSE;
+        }
+
+      if (rebuild)
+        {
+          for (i = 0; i < n_tiles; i++)
+            {
+              const gdouble *values = priv->tiles[i].values;
+
+              if (! values)
+                continue;
+
+              for (j = 0; j < priv->n_values; j++)
+                priv->values[j] += values[j];
+            }
+        }
+
+      gimp_histogram_set_values (priv->histogram,
+                                 priv->n_components, priv->n_bins,
+                                 g_memdup2 (priv->values,
+                                            priv->n_values * sizeof (gdouble)));
+    }
+
+  calculate_data_free (data);
+}
+
+static void
+calculate_data_free (CalculateData *data)
+{
+  gint i;
+
+  for (i = 0; i < data->n_tiles; i++)
+    g_free (data->values[i]);
+
+  g_free (data->values);
+  g_free (data->indices);
+  g_free (data->stamps);
+  g_free (data->rects);
+
+  g_object_unref (data->buffer);
+  g_clear_object (&data->mask);
+  g_object_unref (data->histogram);
+
+  g_slice_free (CalculateData, data);
+}
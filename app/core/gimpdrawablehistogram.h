@@ -0,0 +1,65 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdrawablehistogram.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DRAWABLE_HISTOGRAM_H__
+#define __GIMP_DRAWABLE_HISTOGRAM_H__
+
+
+#include "gimpobject.h"
+
+
+#define GIMP_TYPE_DRAWABLE_HISTOGRAM            (gimp_drawable_histogram_get_type ())
+#define GIMP_DRAWABLE_HISTOGRAM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_DRAWABLE_HISTOGRAM, GimpDrawableHistogram))
+#define GIMP_DRAWABLE_HISTOGRAM_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GIMP_TYPE_DRAWABLE_HISTOGRAM, GimpDrawableHistogramClass))
+#define GIMP_IS_DRAWABLE_HISTOGRAM(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_DRAWABLE_HISTOGRAM))
+#define GIMP_IS_DRAWABLE_HISTOGRAM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GIMP_TYPE_DRAWABLE_HISTOGRAM))
+#define GIMP_DRAWABLE_HISTOGRAM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GIMP_TYPE_DRAWABLE_HISTOGRAM, GimpDrawableHistogramClass))
+
+
+typedef struct _GimpDrawableHistogramPrivate GimpDrawableHistogramPrivate;
+typedef struct _GimpDrawableHistogramClass   GimpDrawableHistogramClass;
+
+struct _GimpDrawableHistogram
+{
+  GimpObject                    parent_instance;
+
+  GimpDrawableHistogramPrivate *priv;
+};
+
+struct _GimpDrawableHistogramClass
+{
+  GimpObjectClass  parent_class;
+};
+
+
+GType                   gimp_drawable_histogram_get_type        (void) G_GNUC_CONST;
+
+GimpDrawableHistogram * gimp_drawable_histogram_new             (GimpDrawable          *drawable,
+                                                                 GimpHistogram         *histogram,
+                                                                 gboolean               with_filters);
+
+GimpDrawable          * gimp_drawable_histogram_get_drawable    (GimpDrawableHistogram *drawable_histogram);
+GimpHistogram         * gimp_drawable_histogram_get_histogram   (GimpDrawableHistogram *drawable_histogram);
+
+void                    gimp_drawable_histogram_invalidate      (GimpDrawableHistogram *drawable_histogram);
+
+GimpAsync             * gimp_drawable_histogram_calculate_async (GimpDrawableHistogram *drawable_histogram);
+
+
+#endif /* __GIMP_DRAWABLE_HISTOGRAM_H__ */
@@ -17,6 +17,8 @@
 
 #include "config.h"
 
+#include <zlib.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -24,12 +26,23 @@
 
 #include "core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
+#include "gimp.h"
 #include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
 #include "gimpimage.h"
+#include "gimpimage-undo.h"
 #include "gimpdrawable.h"
 #include "gimpdrawableundo.h"
 
 
+/* number of rows deflated at once, and the smallest buffer worth it */
+#define COMPRESS_CHUNK_HEIGHT 64
+#define COMPRESS_MIN_SIZE     (64 * 1024)
+
+
 enum
 {
   PROP_0,
@@ -39,7 +52,16 @@ enum
 };
 
 
+typedef struct
+{
+  GeglBuffer    *buffer;
+  GeglRectangle  extent;
+  const Babl    *format;
+} CompressData;
+
+
 static void     gimp_drawable_undo_constructed  (GObject             *object);
+static void     gimp_drawable_undo_finalize     (GObject             *object);
 static void     gimp_drawable_undo_set_property (GObject             *object,
                                                  guint                property_id,
                                                  const GValue        *value,
@@ -58,6 +80,19 @@ static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
 static void     gimp_drawable_undo_free         (GimpUndo            *undo,
                                                  GimpUndoMode         undo_mode);
 
+static void     gimp_drawable_undo_compress     (GimpDrawableUndo    *drawable_undo);
+static void     gimp_drawable_undo_cancel_compress
+                                                (GimpDrawableUndo    *drawable_undo);
+static void     gimp_drawable_undo_decompress   (GimpDrawableUndo    *drawable_undo);
+static void     gimp_drawable_undo_compress_func
+                                                (GimpAsync           *async,
+                                                 CompressData        *data);
+static void     gimp_drawable_undo_compress_callback
+                                                (GimpAsync           *async,
+                                                 GimpDrawableUndo    *drawable_undo);
+
+static void     compress_data_free              (CompressData        *data);
+
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
 
@@ -72,6 +107,7 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
   GimpUndoClass   *undo_class        = GIMP_UNDO_CLASS (klass);
 
   object_class->constructed      = gimp_drawable_undo_constructed;
+  object_class->finalize         = gimp_drawable_undo_finalize;
   object_class->set_property     = gimp_drawable_undo_set_property;
   object_class->get_property     = gimp_drawable_undo_get_property;
 
@@ -113,6 +149,21 @@ gimp_drawable_undo_constructed (GObject *object)
 
   gimp_assert (GIMP_IS_DRAWABLE (GIMP_ITEM_UNDO (object)->item));
   gimp_assert (GEGL_IS_BUFFER (drawable_undo->buffer));
+
+  gimp_drawable_undo_compress (drawable_undo);
+}
+
+static void
+gimp_drawable_undo_finalize (GObject *object)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (object);
+
+  gimp_drawable_undo_cancel_compress (drawable_undo);
+
+  g_clear_pointer (&drawable_undo->chunks, g_ptr_array_unref);
+  g_clear_object (&drawable_undo->buffer);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
@@ -174,7 +225,20 @@ gimp_drawable_undo_get_memsize (GimpObject *object,
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (object);
   gint64            memsize       = 0;
 
-  memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+  if (drawable_undo->chunks)
+    {
+      gint i;
+
+      memsize += sizeof (GPtrArray) +
+                 drawable_undo->chunks->len * sizeof (gpointer);
+
+      for (i = 0; i < drawable_undo->chunks->len; i++)
+        memsize += g_bytes_get_size (drawable_undo->chunks->pdata[i]);
+    }
+  else
+    {
+      memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+    }
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -189,10 +253,15 @@ gimp_drawable_undo_pop (GimpUndo            *undo,
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
+  gimp_drawable_undo_decompress (drawable_undo);
+
   gimp_drawable_swap_pixels (GIMP_DRAWABLE (GIMP_ITEM_UNDO (undo)->item),
                              drawable_undo->buffer,
                              drawable_undo->x,
                              drawable_undo->y);
+
+  /*  the buffer now holds the pixels for the opposite direction  */
+  gimp_drawable_undo_compress (drawable_undo);
 }
 
 static void
@@ -201,7 +270,220 @@ gimp_drawable_undo_free (GimpUndo     *undo,
 {
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
 
+  gimp_drawable_undo_cancel_compress (drawable_undo);
+
+  g_clear_pointer (&drawable_undo->chunks, g_ptr_array_unref);
   g_clear_object (&drawable_undo->buffer);
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static void
+gimp_drawable_undo_compress (GimpDrawableUndo *drawable_undo)
+{
+  GimpImage    *image = GIMP_UNDO (drawable_undo)->image;
+  CompressData *data;
+
+  if (! image->gimp->config->undo_compression)
+    return;
+
+  drawable_undo->extent = *gegl_buffer_get_extent (drawable_undo->buffer);
+  drawable_undo->format = gegl_buffer_get_format (drawable_undo->buffer);
+
+  if ((gint64) drawable_undo->extent.width  *
+               drawable_undo->extent.height *
+      babl_format_get_bytes_per_pixel (drawable_undo->format) <
+      COMPRESS_MIN_SIZE)
+    {
+      return;
+    }
+
+  data = g_slice_new (CompressData);
+
+  data->buffer = g_object_ref (drawable_undo->buffer);
+  data->extent = drawable_undo->extent;
+  data->format = drawable_undo->format;
+
+  drawable_undo->compress_async = gimp_parallel_run_async_full (
+    +1,
+    (GimpRunAsyncFunc) gimp_drawable_undo_compress_func,
+    data,
+    (GDestroyNotify) compress_data_free);
+
+  gimp_async_add_callback (
+    drawable_undo->compress_async,
+    (GimpAsyncCallback) gimp_drawable_undo_compress_callback,
+    drawable_undo);
+}
+
+static void
+gimp_drawable_undo_cancel_compress (GimpDrawableUndo *drawable_undo)
+{
+  if (drawable_undo->compress_async)
+    {
+      GimpAsync *async = drawable_undo->compress_async;
+
+      gimp_async_remove_callback (
+        async,
+        (GimpAsyncCallback) gimp_drawable_undo_compress_callback,
+        drawable_undo);
+
+      gimp_async_cancel_and_wait (async);
+
+      g_clear_object (&drawable_undo->compress_async);
+    }
+}
+
+static void
+gimp_drawable_undo_decompress (GimpDrawableUndo *drawable_undo)
+{
+  const GeglRectangle *extent = &drawable_undo->extent;
+  gint                 bpp;
+  gint                 rowstride;
+  guchar              *pixels;
+  gint                 i;
+
+  /*  if the undo is popped before compression finished, just use the
+   *  uncompressed buffer
+   */
+  if (drawable_undo->compress_async)
+    gimp_async_cancel_and_wait (drawable_undo->compress_async);
+
+  if (! drawable_undo->chunks)
+    return;
+
+  bpp       = babl_format_get_bytes_per_pixel (drawable_undo->format);
+  rowstride = extent->width * bpp;
+  pixels    = g_malloc ((gsize) rowstride * COMPRESS_CHUNK_HEIGHT);
+
+  drawable_undo->buffer = gegl_buffer_new (extent, drawable_undo->format);
+
+  for (i = 0; i < drawable_undo->chunks->len; i++)
+    {
+      GBytes        *chunk  = drawable_undo->chunks->pdata[i];
+      GeglRectangle  rect;
+      uLongf         size;
+
+      rect.x      = extent->x;
+      rect.y      = extent->y + i * COMPRESS_CHUNK_HEIGHT;
+      rect.width  = extent->width;
+      rect.height = MIN (COMPRESS_CHUNK_HEIGHT,
+                         extent->y + extent->height - rect.y);
+
+      size = (uLongf) rowstride * rect.height;
+
+      if (uncompress (pixels, &size,
+                      g_bytes_get_data (chunk, NULL),
+                      g_bytes_get_size (chunk)) != Z_OK ||
+          size != (uLongf) rowstride * rect.height)
+        {
+          g_warning ("%s: failed to decompress undo data", G_STRFUNC);
+          break;
+        }
+
+      gegl_buffer_set (drawable_undo->buffer, &rect, 0,
+                       drawable_undo->format, pixels, rowstride);
+    }
+
+  g_free (pixels);
+
+  g_clear_pointer (&drawable_undo->chunks, g_ptr_array_unref);
+}
+
+static void
+gimp_drawable_undo_compress_func (GimpAsync    *async,
+                                  CompressData *data)
+{
+  const GeglRectangle *extent = &data->extent;
+  GPtrArray           *chunks;
+  gint                 bpp;
+  gint                 rowstride;
+  guchar              *pixels;
+  guchar              *compressed;
+  uLong                max_size;
+  gint64               total = 0;
+  gint                 y;
+
+  bpp        = babl_format_get_bytes_per_pixel (data->format);
+  rowstride  = extent->width * bpp;
+  max_size   = compressBound ((uLong) rowstride * COMPRESS_CHUNK_HEIGHT);
+  pixels     = g_malloc ((gsize) rowstride * COMPRESS_CHUNK_HEIGHT);
+  compressed = g_malloc (max_size);
+
+  chunks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+
+  for (y = 0; y < extent->height; y += COMPRESS_CHUNK_HEIGHT)
+    {
+      GeglRectangle rect;
+      uLongf        size = max_size;
+
+      if (gimp_async_is_canceled (async))
+        break;
+
+      rect.x      = extent->x;
+      rect.y      = extent->y + y;
+      rect.width  = extent->width;
+      rect.height = MIN (COMPRESS_CHUNK_HEIGHT, extent->height - y);
+
+      gegl_buffer_get (data->buffer, &rect, 1.0,
+                       data->format, pixels, rowstride,
+                       GEGL_ABYSS_NONE);
+
+      if (compress2 (compressed, &size,
+                     pixels, (uLong) rowstride * rect.height,
+                     Z_BEST_SPEED) != Z_OK)
+        {
+          break;
+        }
+
+      g_ptr_array_add (chunks, g_bytes_new (compressed, size));
+
+      total += size;
+    }
+
+  g_free (pixels);
+  g_free (compressed);
+  compress_data_free (data);
+
+  /*  keep the uncompressed buffer if compression didn't finish, or if
+   *  it doesn't save at least a quarter of the memory
+   */
+  if (y < extent->height ||
+      total > (gint64) rowstride * extent->height / 4 * 3)
+    {
+      g_ptr_array_unref (chunks);
+
+      gimp_async_abort (async);
+
+      return;
+    }
+
+  gimp_async_finish_full (async, chunks, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+gimp_drawable_undo_compress_callback (GimpAsync        *async,
+                                      GimpDrawableUndo *drawable_undo)
+{
+  GimpUndo *undo = GIMP_UNDO (drawable_undo);
+
+  if (gimp_async_is_finished (async))
+    {
+      drawable_undo->chunks = g_ptr_array_ref (gimp_async_get_result (async));
+
+      g_clear_object (&drawable_undo->buffer);
+    }
+
+  g_clear_object (&drawable_undo->compress_async);
+
+  if (drawable_undo->chunks)
+    gimp_image_undo_size_changed (undo->image, undo);
+}
+
+static void
+compress_data_free (CompressData *data)
+{
+  g_object_unref (data->buffer);
+
+  g_slice_free (CompressData, data);
+}
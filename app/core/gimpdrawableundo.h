@@ -35,11 +35,17 @@ typedef struct _GimpDrawableUndoClass GimpDrawableUndoClass;
 
 struct _GimpDrawableUndo
 {
-  GimpItemUndo  parent_instance;
+  GimpItemUndo   parent_instance;
 
-  GeglBuffer   *buffer;
-  gint          x;
-  gint          y;
+  GeglBuffer    *buffer;
+  gint           x;
+  gint           y;
+
+  /*  the buffer's pixels, deflated in chunks of rows, while cold  */
+  GimpAsync     *compress_async;
+  GPtrArray     *chunks;
+  GeglRectangle  extent;
+  const Babl    *format;
 };
 
 struct _GimpDrawableUndoClass
@@ -107,11 +107,6 @@ static gint64     gimp_histogram_get_memsize              (GimpObject
 static gboolean   gimp_histogram_map_channel              (GimpHistogram        *histogram,
                                                            GimpHistogramChannel *channel);
 
-static void       gimp_histogram_set_values               (GimpHistogram        *histogram,
-                                                           gint                  n_components,
-                                                           gint                  n_bins,
-                                                           gdouble              *values);
-
 static void       gimp_histogram_calculate_internal       (GimpAsync            *async,
                                                            CalculateContext     *context);
 static void       gimp_histogram_calculate_area           (const GeglRectangle  *area,
@@ -278,7 +273,9 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
                           GeglBuffer          *mask,
                           const GeglRectangle *mask_rect)
 {
-  CalculateContext context = {};
+  gdouble *values;
+  gint     n_components;
+  gint     n_bins;
 
   g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
   g_return_if_fail (GEGL_IS_BUFFER (buffer));
@@ -287,25 +284,12 @@ gimp_histogram_calculate (GimpHistogram       *histogram,
   if (histogram->priv->calculate_async)
     gimp_async_cancel_and_wait (histogram->priv->calculate_async);
 
-  context.histogram   = histogram;
-  context.buffer      = buffer;
-  context.buffer_rect = *buffer_rect;
-
-  if (mask)
-    {
-      context.mask = mask;
+  values = gimp_histogram_calculate_values (histogram,
+                                            buffer, buffer_rect,
+                                            mask, mask_rect,
+                                            &n_components, &n_bins, NULL);
 
-      if (mask_rect)
-        context.mask_rect = *mask_rect;
-      else
-        context.mask_rect = *gegl_buffer_get_extent (mask);
-    }
-
-  gimp_histogram_calculate_internal (NULL, &context);
-
-  gimp_histogram_set_values (histogram,
-                             context.n_components, context.n_bins,
-                             context.values);
+  gimp_histogram_set_values (histogram, n_components, n_bins, values);
 }
 
 GimpAsync *
@@ -366,6 +350,135 @@ gimp_histogram_calculate_async (GimpHistogram       *histogram,
   return histogram->priv->calculate_async;
 }
 
+/**
+ * gimp_histogram_calculate_values:
+ * @histogram:    a %GimpHistogram
+ * @buffer:       the buffer to calculate the values of
+ * @buffer_rect:  the area of @buffer
+ * @mask:         an optional mask buffer
+ * @mask_rect:    the area of @mask, or %NULL for its extent
+ * @n_components: returns the number of components of the values
+ * @n_bins:       returns the number of bins of the values
+ * @n_values:     returns the total number of values, or %NULL
+ *
+ * Calculates the histogram values of an area, the way
+ * gimp_histogram_calculate() does, but returns them instead of setting
+ * them on @histogram, which is only used for its TRC.  Values calculated
+ * for different areas of the same buffer can be added up, and later
+ * passed to gimp_histogram_set_values().
+ *
+ * This function may be called from any thread.
+ *
+ * Returns: the newly allocated values, to be freed with g_free().
+ **/
+gdouble *
+gimp_histogram_calculate_values (GimpHistogram       *histogram,
+                                 GeglBuffer          *buffer,
+                                 const GeglRectangle *buffer_rect,
+                                 GeglBuffer          *mask,
+                                 const GeglRectangle *mask_rect,
+                                 gint                *n_components,
+                                 gint                *n_bins,
+                                 gint                *n_values)
+{
+  CalculateContext context = {};
+
+  g_return_val_if_fail (GIMP_IS_HISTOGRAM (histogram), NULL);
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (buffer_rect != NULL, NULL);
+  g_return_val_if_fail (n_components != NULL, NULL);
+  g_return_val_if_fail (n_bins != NULL, NULL);
+
+  context.histogram   = histogram;
+  context.buffer      = buffer;
+  context.buffer_rect = *buffer_rect;
+
+  if (mask)
+    {
+      context.mask = mask;
+
+      if (mask_rect)
+        context.mask_rect = *mask_rect;
+      else
+        context.mask_rect = *gegl_buffer_get_extent (mask);
+    }
+
+  gimp_histogram_calculate_internal (NULL, &context);
+
+  *n_components = context.n_components;
+  *n_bins       = context.n_bins;
+
+  if (n_values)
+    {
+      *n_values = (context.n_components + N_DERIVED_CHANNELS) *
+                  context.n_bins;
+    }
+
+  return context.values;
+}
+
+/**
+ * gimp_histogram_set_values:
+ * @histogram:    a %GimpHistogram
+ * @n_components: the number of components of @values
+ * @n_bins:       the number of bins of @values
+ * @values:       (transfer full): values, as returned by
+ *                gimp_histogram_calculate_values(), or %NULL
+ *
+ * Sets the values of @histogram, canceling any pending calculation.
+ **/
+void
+gimp_histogram_set_values (GimpHistogram *histogram,
+                           gint           n_components,
+                           gint           n_bins,
+                           gdouble       *values)
+{
+  GimpHistogramPrivate *priv;
+  gint                  n_channels          = n_components;
+  gboolean              notify_n_components = FALSE;
+  gboolean              notify_n_bins       = FALSE;
+
+  g_return_if_fail (GIMP_IS_HISTOGRAM (histogram));
+
+  priv = histogram->priv;
+
+  if (priv->calculate_async)
+    gimp_async_cancel_and_wait (priv->calculate_async);
+
+  if (n_channels > 0)
+    n_channels += N_DERIVED_CHANNELS;
+
+  if (n_channels != priv->n_channels)
+    {
+      priv->n_channels = n_channels;
+
+      notify_n_components = TRUE;
+    }
+
+  if (n_bins != priv->n_bins)
+    {
+      priv->n_bins = n_bins;
+
+      notify_n_bins = TRUE;
+    }
+
+  if (values != priv->values)
+    {
+      if (priv->values)
+        g_free (priv->values);
+
+      priv->values = values;
+    }
+
+  if (notify_n_components)
+    g_object_notify (G_OBJECT (histogram), "n-components");
+
+  if (notify_n_bins)
+    g_object_notify (G_OBJECT (histogram), "n-bins");
+
+  g_object_notify (G_OBJECT (histogram), "values");
+}
+
 void
 gimp_histogram_clear_values (GimpHistogram *histogram,
                              gint           n_components)
@@ -832,51 +945,6 @@ gimp_histogram_map_channel (GimpHistogram        *histogram,
   return *channel < priv->n_channels;
 }
 
-static void
-gimp_histogram_set_values (GimpHistogram *histogram,
-                           gint           n_components,
-                           gint           n_bins,
-                           gdouble       *values)
-{
-  GimpHistogramPrivate *priv                = histogram->priv;
-  gint                  n_channels          = n_components;
-  gboolean              notify_n_components = FALSE;
-  gboolean              notify_n_bins       = FALSE;
-
-  if (n_channels > 0)
-    n_channels += N_DERIVED_CHANNELS;
-
-  if (n_channels != priv->n_channels)
-    {
-      priv->n_channels = n_channels;
-
-      notify_n_components = TRUE;
-    }
-
-  if (n_bins != priv->n_bins)
-    {
-      priv->n_bins = n_bins;
-
-      notify_n_bins = TRUE;
-    }
-
-  if (values != priv->values)
-    {
-      if (priv->values)
-        g_free (priv->values);
-
-      priv->values = values;
-    }
-
-  if (notify_n_components)
-    g_object_notify (G_OBJECT (histogram), "n-components");
-
-  if (notify_n_bins)
-    g_object_notify (G_OBJECT (histogram), "n-bins");
-
-  g_object_notify (G_OBJECT (histogram), "values");
-}
-
 static void
 gimp_histogram_calculate_internal (GimpAsync        *async,
                                    CalculateContext *context)
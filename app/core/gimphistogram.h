@@ -65,6 +65,20 @@ GimpAsync     * gimp_histogram_calculate_async (GimpHistogram        *histogram,
                                                 GeglBuffer           *mask,
                                                 const GeglRectangle  *mask_rect);
 
+gdouble       * gimp_histogram_calculate_values
+                                               (GimpHistogram        *histogram,
+                                                GeglBuffer           *buffer,
+                                                const GeglRectangle  *buffer_rect,
+                                                GeglBuffer           *mask,
+                                                const GeglRectangle  *mask_rect,
+                                                gint                 *n_components,
+                                                gint                 *n_bins,
+                                                gint                 *n_values);
+
+void            gimp_histogram_set_values      (GimpHistogram        *histogram,
+                                                gint                  n_components,
+                                                gint                  n_bins,
+                                                gdouble              *values);
 void            gimp_histogram_clear_values    (GimpHistogram        *histogram,
                                                 gint                  n_components);
 
@@ -192,6 +192,27 @@
 #define G_SCALE 24              /*  scale G (a*) distances by this much  */
 #define B_SCALE 26              /*  and B (b*) by this much              */
 
+/* the histogram is counted into per-thread copies, which are merged
+ * afterwards, so only split large layers
+ */
+#define HISTOGRAM_PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 256.0 * 256.0 /* pixels */)
+
+#define PASS2_PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+
+/* pass 2 runs over bands of rows, reporting progress in-between */
+#define PASS2_BAND_HEIGHT 256
+
+/* error diffusion runs over horizontal strips of the layer, dithered
+ * independently of each other.  each strip's error rows are primed by
+ * first dithering, and discarding, the rows right above it, so that
+ * the strip seams don't show.  the result only depends on these
+ * constants, not on the number of threads.
+ */
+#define FS_STRIP_HEIGHT  128
+#define FS_STRIP_PRIMING  16
+
 
 typedef struct _Color Color;
 typedef struct _QuantizeObj QuantizeObj;
@@ -203,6 +224,18 @@ typedef void (* Pass2Func)     (QuantizeObj *quantize_obj,
                                 GeglBuffer  *new_buffer);
 typedef void (* CleanupFunc)   (QuantizeObj *quantize_obj);
 
+typedef void (* Pass2AreaFunc)  (QuantizeObj         *quantize_obj,
+                                 GimpLayer           *layer,
+                                 GeglBuffer          *new_buffer,
+                                 const GeglRectangle *area,
+                                 guint64             *index_used_count);
+typedef void (* Pass2StripFunc) (QuantizeObj         *quantize_obj,
+                                 GimpLayer           *layer,
+                                 GeglBuffer          *new_buffer,
+                                 gint                 first_row,
+                                 gint                 last_row,
+                                 guint64             *index_used_count);
+
 typedef guint64 ColorFreq;
 typedef ColorFreq * CFHistogram;
 
@@ -483,6 +516,8 @@ struct _QuantizeObj
   Color         clin[256];                /* .. converted back to linear space */
   guint64       index_used_count[256];    /* how many times an index was used  */
   CFHistogram   histogram;                /* holds the histogram               */
+  gboolean      has_histogram;            /* histogram holds the image colors  */
+  gint         *inverse_cmap;             /* colormap index + 1 of each cell   */
 
   gboolean      want_dither_alpha;
   gint          error_freedom;            /* 0=much bleed, 1=controlled bleed */
@@ -515,6 +550,30 @@ typedef struct
 
 } box, *boxptr;
 
+typedef struct
+{
+  CFHistogram    histogram;
+  GeglBuffer    *buffer;
+  const Babl    *format;
+  GeglRectangle  rect;
+  gint           offsetx;
+  gint           offsety;
+  gboolean       dither_alpha;
+  GMutex         mutex;
+} HistogramData;
+
+typedef struct
+{
+  QuantizeObj    *quantobj;
+  GimpLayer      *layer;
+  GeglBuffer     *new_buffer;
+  Pass2AreaFunc   area_func;
+  Pass2StripFunc  strip_func;
+  gint            height;
+  gint            first_strip;
+  GMutex          mutex;
+} Pass2Data;
+
 
 static void          zero_histogram_gray     (CFHistogram   histogram);
 static void          zero_histogram_rgb      (CFHistogram   histogram);
@@ -885,6 +944,8 @@ gimp_image_convert_indexed (GimpImage               *image,
                                       sub_progress);
             }
         }
+
+      quantobj->has_histogram = (old_type != GIMP_GRAY);
     }
 
   if (progress)
@@ -1169,135 +1230,200 @@ generate_histogram_gray (CFHistogram  histogram,
 }
 
 static void
-check_white_or_black (const guchar *data)
+check_white_or_black (const guchar *data,
+                      gboolean     *white,
+                      gboolean     *black)
 {
   if (data[RED]   == 255 &&
       data[GREEN] == 255 &&
       data[BLUE]  == 255)
-    had_white = TRUE;
+    *white = TRUE;
   if (data[RED]  ==0 &&
       data[GREEN]==0 &&
       data[BLUE] ==0)
-    had_black = TRUE;
+    *black = TRUE;
 }
 
 static void
-generate_histogram_rgb (CFHistogram   histogram,
-                        GimpLayer    *layer,
-                        gint          col_limit,
-                        gboolean      dither_alpha,
-                        GimpProgress *progress)
+generate_histogram_rgb_area (const GeglRectangle *area,
+                             HistogramData       *data)
 {
   GeglBufferIterator *iter;
-  const Babl         *format;
   GeglRectangle      *roi;
+  CFHistogram         histogram;
   ColorFreq          *colfreq;
-  gint                nfc_iter;
-  gint                row, col, coledge;
-  gint                offsetx, offsety;
-  gint64              layer_size;
-  gint64              total_size = 0;
-  gint                count      = 0;
   gint                bpp;
   gboolean            has_alpha;
+  gboolean            white = FALSE;
+  gboolean            black = FALSE;
 
-  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
-
-  g_return_if_fail (format == babl_format_with_space ("R'G'B' u8", format) ||
-                    format == babl_format_with_space ("R'G'B'A u8", format));
-
-  bpp       = babl_format_get_bytes_per_pixel (format);
-  has_alpha = babl_format_has_alpha (format);
+  bpp       = babl_format_get_bytes_per_pixel (data->format);
+  has_alpha = babl_format_has_alpha (data->format);
 
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
-
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
-  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
+  /* only count into a private histogram if the layer is split */
+  if (gegl_rectangle_equal (area, &data->rect))
+    histogram = data->histogram;
+  else
+    histogram = g_new0 (ColorFreq, HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS);
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, format,
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0, data->format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
   roi = &iter->items[0].roi;
 
-  if (progress)
-    gimp_progress_set_value (progress, 0.0);
-
   while (gegl_buffer_iterator_next (iter))
     {
-      const guchar *data   = iter->items[0].data;
+      const guchar *src    = iter->items[0].data;
       gint          length = iter->length;
 
-      total_size += length;
+      if (data->dither_alpha)
+        {
+          /* if alpha-dithering,
+             we need to be deterministic w.r.t. offsets */
 
-      /* g_printerr (" [%d,%d - %d,%d]", srcPR.x, src_roi->y, offsetx, offsety); */
+          gint col     = roi->x + data->offsetx;
+          gint coledge = col + roi->width;
+          gint row     = roi->y + data->offsety;
 
-      if (needs_quantize)
-        {
-          if (dither_alpha)
+          while (length--)
             {
-              /* if alpha-dithering,
-                 we need to be deterministic w.r.t. offsets */
+              gboolean transparent = FALSE;
 
-              col = roi->x + offsetx;
-              coledge = col + roi->width;
-              row = roi->y + offsety;
+              if (has_alpha &&
+                  src[ALPHA] <
+                  DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
+                transparent = TRUE;
 
-              while (length--)
+              if (! transparent)
                 {
-                  gboolean transparent = FALSE;
-
-                  if (has_alpha &&
-                      data[ALPHA] <
-                      DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
-                    transparent = TRUE;
-
-                  if (! transparent)
-                    {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      check_white_or_black (data);
-                      (*colfreq)++;
-                    }
-
-                  col++;
-                  if (col == coledge)
-                    {
-                      col = roi->x + offsetx;
-                      row++;
-                    }
+                  colfreq = HIST_RGB (histogram,
+                                      src[RED],
+                                      src[GREEN],
+                                      src[BLUE]);
+                  check_white_or_black (src, &white, &black);
+                  (*colfreq)++;
+                }
 
-                  data += bpp;
+              col++;
+              if (col == coledge)
+                {
+                  col = roi->x + data->offsetx;
+                  row++;
                 }
+
+              src += bpp;
             }
-          else
+        }
+      else
+        {
+          while (length--)
             {
-              while (length--)
+              if ((has_alpha && ((src[ALPHA] > 127)))
+                  || (!has_alpha))
                 {
-                  if ((has_alpha && ((data[ALPHA] > 127)))
-                      || (!has_alpha))
-                    {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      check_white_or_black (data);
-                      (*colfreq)++;
-                    }
-
-                  data += bpp;
+                  colfreq = HIST_RGB (histogram,
+                                      src[RED],
+                                      src[GREEN],
+                                      src[BLUE]);
+                  check_white_or_black (src, &white, &black);
+                  (*colfreq)++;
                 }
+
+              src += bpp;
             }
         }
-      else
+    }
+
+  g_mutex_lock (&data->mutex);
+
+  if (histogram != data->histogram)
+    {
+      gint i;
+
+      for (i = 0; i < HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS; i++)
+        data->histogram[i] += histogram[i];
+
+      g_free (histogram);
+    }
+
+  had_white |= white;
+  had_black |= black;
+
+  g_mutex_unlock (&data->mutex);
+}
+
+static void
+generate_histogram_rgb (CFHistogram   histogram,
+                        GimpLayer    *layer,
+                        gint          col_limit,
+                        gboolean      dither_alpha,
+                        GimpProgress *progress)
+{
+  HistogramData   data;
+  cairo_region_t *region;
+  ColorFreq      *colfreq;
+  gint            nfc_iter;
+  gint            row, col, coledge;
+  gint64          layer_size;
+  gint64          total_size = 0;
+  gint            count      = 0;
+  gint            bpp;
+  gboolean        has_alpha;
+  gint            n_rects;
+  gint            i;
+
+  data.format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+
+  g_return_if_fail (data.format == babl_format_with_space ("R'G'B' u8", data.format) ||
+                    data.format == babl_format_with_space ("R'G'B'A u8", data.format));
+
+  data.histogram    = histogram;
+  data.buffer       = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  data.rect         = *gegl_buffer_get_extent (data.buffer);
+  data.dither_alpha = dither_alpha;
+
+  gimp_item_get_offset (GIMP_ITEM (layer), &data.offsetx, &data.offsety);
+
+  bpp       = babl_format_get_bytes_per_pixel (data.format);
+  has_alpha = babl_format_has_alpha (data.format);
+
+  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
+                gimp_item_get_height (GIMP_ITEM (layer)));
+
+  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
+
+  region = cairo_region_create_rectangle ((cairo_rectangle_int_t *) &data.rect);
+
+  if (progress)
+    gimp_progress_set_value (progress, 0.0);
+
+  /*  As long as the image might not need quantization, the colors are
+   *  recorded in the order they are found, which determines the
+   *  palette, so this has to be done sequentially.  Once there are
+   *  too many colors, the rest of the layer is counted in parallel.
+   */
+  if (! needs_quantize)
+    {
+      GeglBufferIterator *iter;
+      GeglRectangle      *roi;
+
+      iter = gegl_buffer_iterator_new (data.buffer,
+                                       NULL, 0, data.format,
+                                       GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+      roi = &iter->items[0].roi;
+
+      while (gegl_buffer_iterator_next (iter))
         {
+          const guchar *src    = iter->items[0].data;
+          gint          length = iter->length;
+
+          total_size += length;
+
+          /* g_printerr (" [%d,%d - %d,%d]", srcPR.x, src_roi->y, offsetx, offsety); */
+
           /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
-          col = roi->x + offsetx;
+          col = roi->x + data.offsetx;
           coledge = col + roi->width;
-          row = roi->y + offsety;
+          row = roi->y + data.offsety;
 
           while (length--)
             {
@@ -1307,13 +1433,13 @@ generate_histogram_rgb (CFHistogram   histogram,
                 {
                   if (dither_alpha)
                     {
-                      if (data[ALPHA] <
+                      if (src[ALPHA] <
                           DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
                         transparent = TRUE;
                     }
                   else
                     {
-                      if (data[ALPHA] <= 127)
+                      if (src[ALPHA] <= 127)
                         transparent = TRUE;
                     }
                 }
@@ -1321,9 +1447,9 @@ generate_histogram_rgb (CFHistogram   histogram,
               if (! transparent)
                 {
                   colfreq = HIST_RGB (histogram,
-                                      data[RED],
-                                      data[GREEN],
-                                      data[BLUE]);
+                                      src[RED],
+                                      src[GREEN],
+                                      src[BLUE]);
                   (*colfreq)++;
 
                   if (!needs_quantize)
@@ -1332,9 +1458,9 @@ generate_histogram_rgb (CFHistogram   histogram,
                            nfc_iter < num_found_cols;
                            nfc_iter++)
                         {
-                          if ((data[RED]   == found_cols[nfc_iter][0]) &&
-                              (data[GREEN] == found_cols[nfc_iter][1]) &&
-                              (data[BLUE]  == found_cols[nfc_iter][2]))
+                          if ((src[RED]   == found_cols[nfc_iter][0]) &&
+                              (src[GREEN] == found_cols[nfc_iter][1]) &&
+                              (src[BLUE]  == found_cols[nfc_iter][2]))
                             goto already_found;
                         }
 
@@ -1359,11 +1485,11 @@ generate_histogram_rgb (CFHistogram   histogram,
                         {
                           /* Remember the new color we just found.
                            */
-                          found_cols[num_found_cols-1][0] = data[RED];
-                          found_cols[num_found_cols-1][1] = data[GREEN];
-                          found_cols[num_found_cols-1][2] = data[BLUE];
+                          found_cols[num_found_cols-1][0] = src[RED];
+                          found_cols[num_found_cols-1][1] = src[GREEN];
+                          found_cols[num_found_cols-1][2] = src[BLUE];
 
-                          check_white_or_black (data);
+                          check_white_or_black (src, &had_white, &had_black);
                         }
                     }
                 }
@@ -1372,19 +1498,59 @@ generate_histogram_rgb (CFHistogram   histogram,
               col++;
               if (col == coledge)
                 {
-                  col = roi->x + offsetx;
+                  col = roi->x + data.offsetx;
                   row++;
                 }
 
-              data += bpp;
+              src += bpp;
             }
+
+          cairo_region_subtract_rectangle (region,
+                                           (cairo_rectangle_int_t *) roi);
+
+          if (needs_quantize)
+            {
+              gegl_buffer_iterator_stop (iter);
+
+              break;
+            }
+
+          if (progress && (count % 16 == 0))
+            gimp_progress_set_value (progress,
+                                     (gdouble) total_size /
+                                     (gdouble) layer_size);
         }
+    }
+
+  /*  Count the part of the layer we haven't seen yet  */
+  g_mutex_init (&data.mutex);
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      GeglRectangle rect;
 
-      if (progress && (count % 16 == 0))
-        gimp_progress_set_value (progress,
-                                 (gdouble) total_size / (gdouble) layer_size);
+      cairo_region_get_rectangle (region, i, (cairo_rectangle_int_t *) &rect);
+
+      /* an area covering all of data.rect counts straight into the
+       * histogram
+       */
+      data.rect = rect;
+
+      gegl_parallel_distribute_area (
+        &rect, HISTOGRAM_PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) generate_histogram_rgb_area,
+        &data);
     }
 
+  g_mutex_clear (&data.mutex);
+
+  cairo_region_destroy (region);
+
+  if (progress)
+    gimp_progress_set_value (progress, 1.0);
+
 /*  g_print ("O: col_limit = %d, nfc = %d\n", col_limit, num_found_cols);*/
 }
 
@@ -2678,13 +2844,13 @@ find_best_colors (QuantizeObj *quantobj,
 }
 
 
-/* Fill the inverse-colormap entries in the update box that contains
- * histogram cell R/G/B.  (Only that one cell MUST be filled, but we
- * can fill as many others as we wish.)
+/* Fill the inverse-colormap entry of histogram cell PIXEL.
+ *
+ * Pass 2 runs on several threads, which may fill the same entries at
+ * the same time, so entries are only accessed atomically.
  */
 static void
 fill_inverse_cmap_gray (QuantizeObj *quantobj,
-                        CFHistogram  histogram,
                         gint         pixel)
 {
   Color *cmap = quantobj->cmap;
@@ -2711,17 +2877,19 @@ fill_inverse_cmap_gray (QuantizeObj *quantobj,
         }
     }
 
-  histogram[pixel] = mindisti + 1;
+  g_atomic_int_set (&quantobj->inverse_cmap[pixel], mindisti + 1);
 }
 
 
 /* Fill the inverse-colormap entries in the update box that contains
  * histogram cell R/G/B.  (Only that one cell MUST be filled, but we
  * can fill as many others as we wish.)
+ *
+ * Pass 2 runs on several threads, which may fill the same entries at
+ * the same time, so entries are only accessed atomically.
  */
 static void
 fill_inverse_cmap_rgb (QuantizeObj *quantobj,
-                       CFHistogram  histogram,
                        gint         R,
                        gint         G,
                        gint         B)
@@ -2768,13 +2936,49 @@ fill_inverse_cmap_rgb (QuantizeObj *quantobj,
         {
           for (iB = 0; iB < BOX_B_ELEMS; iB++)
             {
-              *HIST_LIN (histogram, R + iR, G + iG, B + iB) = (*cptr++) + 1;
+              g_atomic_int_set (HIST_LIN (quantobj->inverse_cmap,
+                                          R + iR, G + iG, B + iB),
+                                (*cptr++) + 1);
             }
         }
     }
 }
 
 
+/* Return the colormap index of histogram cell PIXEL, filling in its
+ * inverse-colormap entry if it's not known yet.
+ */
+static inline gint
+lookup_inverse_cmap_gray (QuantizeObj *quantobj,
+                          gint         pixel)
+{
+  gint *cachep = &quantobj->inverse_cmap[pixel];
+
+  if (g_atomic_int_get (cachep) == 0)
+    fill_inverse_cmap_gray (quantobj, pixel);
+
+  return g_atomic_int_get (cachep) - 1;
+}
+
+
+/* Return the colormap index of histogram cell R/G/B, filling in its
+ * inverse-colormap entry if it's not known yet.
+ */
+static inline gint
+lookup_inverse_cmap_rgb (QuantizeObj *quantobj,
+                         gint         R,
+                         gint         G,
+                         gint         B)
+{
+  gint *cachep = HIST_LIN (quantobj->inverse_cmap, R, G, B);
+
+  if (g_atomic_int_get (cachep) == 0)
+    fill_inverse_cmap_rgb (quantobj, R, G, B);
+
+  return g_atomic_int_get (cachep) - 1;
+}
+
+
 /*  This is pass 1  */
 
 static void
@@ -2904,25 +3108,167 @@ custompal_pass1 (QuantizeObj *quantobj)
   quantobj -> actual_number_of_colors = i;
 }
 
+/*
+ * Pass 2 is run in parallel.  The per-pixel remappers convert separate
+ * areas of the layer, while the error-diffusion ditherers convert
+ * separate strips of rows.  Either way, the colormap-index counts of
+ * each thread are added up at the end.
+ */
+
+static void
+median_cut_pass2_area (const GeglRectangle *area,
+                       Pass2Data           *data)
+{
+  guint64 index_used_count[256] = { 0, };
+  gint    i;
+
+  data->area_func (data->quantobj, data->layer, data->new_buffer,
+                   area, index_used_count);
+
+  g_mutex_lock (&data->mutex);
+
+  for (i = 0; i < 256; i++)
+    data->quantobj->index_used_count[i] += index_used_count[i];
+
+  g_mutex_unlock (&data->mutex);
+}
+
+static void
+median_cut_pass2_strips (gsize      offset,
+                         gsize      size,
+                         Pass2Data *data)
+{
+  guint64 index_used_count[256] = { 0, };
+  gint    strip;
+  gint    i;
+
+  for (strip = data->first_strip + offset;
+       strip < data->first_strip + offset + size;
+       strip++)
+    {
+      gint first_row = strip * FS_STRIP_HEIGHT;
+      gint last_row  = MIN (first_row + FS_STRIP_HEIGHT, data->height);
+
+      data->strip_func (data->quantobj, data->layer, data->new_buffer,
+                        first_row, last_row, index_used_count);
+    }
+
+  g_mutex_lock (&data->mutex);
+
+  for (i = 0; i < 256; i++)
+    data->quantobj->index_used_count[i] += index_used_count[i];
+
+  g_mutex_unlock (&data->mutex);
+}
+
+static void
+median_cut_pass2_distribute_areas (QuantizeObj   *quantobj,
+                                   GimpLayer     *layer,
+                                   GeglBuffer    *new_buffer,
+                                   Pass2AreaFunc  func)
+{
+  Pass2Data data = { 0, };
+  gint      width;
+  gint      y;
+
+  data.quantobj   = quantobj;
+  data.layer      = layer;
+  data.new_buffer = new_buffer;
+  data.area_func  = func;
+  data.height     = gimp_item_get_height (GIMP_ITEM (layer));
+
+  width = gimp_item_get_width (GIMP_ITEM (layer));
+
+  g_mutex_init (&data.mutex);
+
+  for (y = 0; y < data.height; y += PASS2_BAND_HEIGHT)
+    {
+      GeglRectangle band;
+
+      band.x      = 0;
+      band.y      = y;
+      band.width  = width;
+      band.height = MIN (PASS2_BAND_HEIGHT, data.height - y);
+
+      gegl_parallel_distribute_area (
+        &band, PASS2_PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) median_cut_pass2_area,
+        &data);
+
+      if (quantobj->progress)
+        gimp_progress_set_value (quantobj->progress,
+                                 (gdouble) (band.y + band.height) /
+                                 (gdouble) data.height);
+    }
+
+  g_mutex_clear (&data.mutex);
+}
+
+static void
+median_cut_pass2_distribute_strips (QuantizeObj    *quantobj,
+                                    GimpLayer      *layer,
+                                    GeglBuffer     *new_buffer,
+                                    Pass2StripFunc  func)
+{
+  Pass2Data data = { 0, };
+  gint      n_strips;
+  gint      n_threads;
+
+  data.quantobj   = quantobj;
+  data.layer      = layer;
+  data.new_buffer = new_buffer;
+  data.strip_func = func;
+  data.height     = gimp_item_get_height (GIMP_ITEM (layer));
+
+  n_strips = (data.height + FS_STRIP_HEIGHT - 1) / FS_STRIP_HEIGHT;
+
+  g_object_get (gegl_config (),
+                "threads", &n_threads,
+                NULL);
+
+  g_mutex_init (&data.mutex);
+
+  /* process as many strips at a time as there are threads, reporting
+   * progress in-between
+   */
+  for (data.first_strip = 0;
+       data.first_strip < n_strips;
+       data.first_strip += n_threads)
+    {
+      gint n = MIN (n_threads, n_strips - data.first_strip);
+
+      gegl_parallel_distribute_range (
+        n, 1,
+        (GeglParallelDistributeRangeFunc) median_cut_pass2_strips,
+        &data);
+
+      if (quantobj->progress)
+        gimp_progress_set_value (quantobj->progress,
+                                 (gdouble) (data.first_strip + n) /
+                                 (gdouble) n_strips);
+    }
+
+  g_mutex_clear (&data.mutex);
+}
+
 /*
  * Map some rows of pixels to the output colormapped representation.
  */
 
 static void
-median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
-                                 GimpLayer   *layer,
-                                 GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_gray_area (QuantizeObj         *quantobj,
+                                      GimpLayer           *layer,
+                                      GeglBuffer          *new_buffer,
+                                      const GeglRectangle *area,
+                                      guint64             *index_used_count)
 {
   GeglBufferIterator *iter;
-  CFHistogram         histogram = quantobj->histogram;
-  ColorFreq          *cachep;
   const Babl         *src_format;
   const Babl         *dest_format;
   GeglRectangle      *src_roi;
   gint                src_bpp;
   gint                dest_bpp;
   gint                has_alpha;
-  guint64            *index_used_count = quantobj->index_used_count;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
   gint                offsetx, offsety;
 
@@ -2937,12 +3283,12 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
   has_alpha = babl_format_has_alpha (src_format);
 
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
   gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -2957,15 +3303,8 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
 
           for (col = 0; col < src_roi->width; col++)
             {
-              /* get pixel value and index into the cache */
-              gint pixel = src[GRAY];
-
-              cachep = &histogram[pixel];
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_gray (quantobj, histogram, pixel);
+              /* get pixel value and look up its colormap index */
+              gint index = lookup_inverse_cmap_gray (quantobj, src[GRAY]);
 
               if (has_alpha)
                 {
@@ -2992,13 +3331,13 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
                   else
                     {
                       dest[ALPHA_I] = 255;
-                      index_used_count[dest[INDEXED] = *cachep - 1]++;
+                      index_used_count[dest[INDEXED] = index]++;
                     }
                 }
               else
                 {
                   /* Now emit the colormap index for this cell */
-                  index_used_count[dest[INDEXED] = *cachep - 1]++;
+                  index_used_count[dest[INDEXED] = index]++;
                 }
 
               src  += src_bpp;
@@ -3009,13 +3348,13 @@ median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
 }
 
 static void
-median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
-                                    GimpLayer   *layer,
-                                    GeglBuffer  *new_buffer)
+median_cut_pass2_fixed_dither_gray_area (QuantizeObj         *quantobj,
+                                         GimpLayer           *layer,
+                                         GeglBuffer          *new_buffer,
+                                         const GeglRectangle *area,
+                                         guint64             *index_used_count)
 {
   GeglBufferIterator *iter;
-  CFHistogram         histogram = quantobj->histogram;
-  ColorFreq          *cachep;
   const Babl         *src_format;
   const Babl         *dest_format;
   GeglRectangle      *src_roi;
@@ -3028,7 +3367,6 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
   gint                err2;
   Color              *color1;
   Color              *color2;
-  guint64            *index_used_count = quantobj->index_used_count;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
   gint                offsetx, offsety;
 
@@ -3043,12 +3381,12 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
   has_alpha = babl_format_has_alpha (src_format);
 
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
   gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -3068,17 +3406,10 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
                 DM[(col + offsetx + src_roi->x) & DM_WIDTHMASK]
                 [(row + offsety + src_roi->y) & DM_HEIGHTMASK];
 
-              /* get pixel value and index into the cache */
+              /* get pixel value and look up its colormap index */
               pixel = src[GRAY];
 
-              cachep = &histogram[pixel];
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_gray (quantobj, histogram, pixel);
-
-              pixval1 = *cachep - 1;
+              pixval1 = lookup_inverse_cmap_gray (quantobj, pixel);
               color1 = &quantobj->cmap[pixval1];
 
               if (quantobj->actual_number_of_colors > 2)
@@ -3090,14 +3421,7 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
                     {
                       const gint R = CLAMP0255 (RV);
 
-                      cachep = &histogram[R];
-                      /* If we have not seen this color before, find
-                       * nearest colormap entry and update the cache
-                       */
-                      if (*cachep == 0)
-                        fill_inverse_cmap_gray (quantobj, histogram, R);
-
-                      pixval2 = *cachep - 1;
+                      pixval2 = lookup_inverse_cmap_gray (quantobj, R);
                       RV += re;
                     }
                   while ((pixval1 == pixval2) &&
@@ -3177,13 +3501,13 @@ median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
 }
 
 static void
-median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
-                                GimpLayer   *layer,
-                                GeglBuffer  *new_buffer)
+median_cut_pass2_no_dither_rgb_area (QuantizeObj         *quantobj,
+                                     GimpLayer           *layer,
+                                     GeglBuffer          *new_buffer,
+                                     const GeglRectangle *area,
+                                     guint64             *index_used_count)
 {
   GeglBufferIterator *iter;
-  CFHistogram         histogram = quantobj->histogram;
-  ColorFreq          *cachep;
   const Babl         *src_format;
   const Babl         *dest_format;
   GeglRectangle      *src_roi;
@@ -3197,10 +3521,6 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
   gint                alpha_pix        = ALPHA;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
   gint                offsetx, offsety;
-  guint64            *index_used_count = quantobj->index_used_count;
-  gint64              total_size       = 0;
-  gint64              layer_size;
-  gint                count            = 0;
 
   gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
 
@@ -3222,25 +3542,20 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
     }
 
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
   gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->items[0].data;
       guchar       *dest = iter->items[1].data;
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
@@ -3276,19 +3591,13 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
                     }
                 }
 
-              /* get pixel value and index into the cache */
+              /* get pixel value and look up its colormap index */
               rgb_to_lin (src[red_pix], src[green_pix], src[blue_pix],
                           &R, &G, &B);
 
-              cachep = HIST_LIN (histogram, R, G, B);
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
-
               /* Now emit the colormap index for this cell, barfbarf */
-              index_used_count[dest[INDEXED] = *cachep - 1]++;
+              index_used_count[dest[INDEXED] =
+                               lookup_inverse_cmap_rgb (quantobj, R, G, B)]++;
 
             next_pixel:
 
@@ -3296,21 +3605,17 @@ median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
               dest += dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-         gimp_progress_set_value (quantobj->progress,
-                                  (gdouble) total_size / (gdouble) layer_size);
     }
 }
 
 static void
-median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
-                                   GimpLayer   *layer,
-                                   GeglBuffer  *new_buffer)
+median_cut_pass2_fixed_dither_rgb_area (QuantizeObj         *quantobj,
+                                        GimpLayer           *layer,
+                                        GeglBuffer          *new_buffer,
+                                        const GeglRectangle *area,
+                                        guint64             *index_used_count)
 {
   GeglBufferIterator *iter;
-  CFHistogram         histogram = quantobj->histogram;
-  ColorFreq          *cachep;
   const Babl         *src_format;
   const Babl         *dest_format;
   GeglRectangle      *src_roi;
@@ -3330,10 +3635,6 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
   gint                alpha_pix        = ALPHA;
   gboolean            dither_alpha     = quantobj->want_dither_alpha;
   gint                offsetx, offsety;
-  guint64            *index_used_count = quantobj->index_used_count;
-  gint64              total_size       = 0;
-  gint64              layer_size;
-  gint                count            = 0;
 
   gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
 
@@ -3355,25 +3656,20 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
     }
 
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
   gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
-
   while (gegl_buffer_iterator_next (iter))
     {
       const guchar *src  = iter->items[0].data;
       guchar       *dest = iter->items[1].data;
       gint          row;
 
-      total_size += src_roi->height * src_roi->width;
-
       for (row = 0; row < src_roi->height; row++)
         {
           gint col;
@@ -3410,16 +3706,11 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                     }
                 }
 
-              /* get pixel value and index into the cache */
+              /* get pixel value and look up its colormap index */
               rgb_to_lin (src[red_pix], src[green_pix], src[blue_pix],
                           &R, &G, &B);
 
-              cachep = HIST_LIN (histogram, R, G, B);
-              /* If we have not seen this color before, find nearest
-               * colormap entry and update the cache
-               */
-              if (*cachep == 0)
-                fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
+              pixval1 = lookup_inverse_cmap_rgb (quantobj, R, G, B);
 
               /* We now try to find a color which, when mixed in some
                * fashion with the closest match, yields something
@@ -3430,7 +3721,6 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                * intended color to determine their relative
                * probabilities of being chosen.
                */
-              pixval1 = *cachep - 1;
               color1 = &quantobj->cmap[pixval1];
 
               if (quantobj->actual_number_of_colors > 2)
@@ -3449,14 +3739,7 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
                                   (CLAMP0255(BV)),
                                   &R, &G, &B);
 
-                      cachep = HIST_LIN (histogram, R, G, B);
-                      /* If we have not seen this color before, find
-                       * nearest colormap entry and update the cache
-                       */
-                      if (*cachep == 0)
-                        fill_inverse_cmap_rgb (quantobj, histogram, R, G, B);
-
-                      pixval2 = *cachep - 1;
+                      pixval2 = lookup_inverse_cmap_rgb (quantobj, R, G, B);
                       RV += re;  GV += ge;  BV += be;
                     }
                   while ((pixval1 == pixval2) &&
@@ -3528,17 +3811,15 @@ median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
               dest += dest_bpp;
             }
         }
-
-      if (quantobj->progress && (count % 16 == 0))
-        gimp_progress_set_value (quantobj->progress,
-                                 (gdouble) total_size / (gdouble) layer_size);
     }
 }
 
 static void
-median_cut_pass2_nodestruct_dither_rgb (QuantizeObj *quantobj,
-                                        GimpLayer   *layer,
-                                        GeglBuffer  *new_buffer)
+median_cut_pass2_nodestruct_dither_rgb_area (QuantizeObj         *quantobj,
+                                             GimpLayer           *layer,
+                                             GeglBuffer          *new_buffer,
+                                             const GeglRectangle *area,
+                                             guint64             *index_used_count)
 {
   GeglBufferIterator *iter;
   const Babl         *src_format;
@@ -3569,12 +3850,12 @@ median_cut_pass2_nodestruct_dither_rgb (QuantizeObj *quantobj,
   has_alpha = babl_format_has_alpha (src_format);
 
   iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, NULL,
+                                   area, 0, NULL,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 2);
   src_roi = &iter->items[0].roi;
 
   gegl_buffer_iterator_add (iter, new_buffer,
-                            NULL, 0, NULL,
+                            area, 0, NULL,
                             GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -3749,13 +4030,14 @@ init_error_limit (const int error_freedom)
  */
 
 static void
-median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
-                                 GimpLayer   *layer,
-                                 GeglBuffer  *new_buffer)
+median_cut_pass2_fs_dither_gray_strip (QuantizeObj *quantobj,
+                                       GimpLayer   *layer,
+                                       GeglBuffer  *new_buffer,
+                                       gint         first_row,
+                                       gint         last_row,
+                                       guint64     *index_used_count)
 {
   GeglBuffer   *src_buffer;
-  CFHistogram   histogram = quantobj->histogram;
-  ColorFreq    *cachep;
   Color        *color;
   gint         *error_limiter;
   const gshort *fs_err1, *fs_err2;
@@ -3778,8 +4060,8 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
   gboolean      has_alpha;
   gint          offsetx, offsety;
   gboolean      dither_alpha = quantobj->want_dither_alpha;
-  gint          width, height;
-  guint64      *index_used_count = quantobj->index_used_count;
+  gint          width;
+  gint          prime_row;
 
   src_buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
 
@@ -3793,8 +4075,12 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
 
   has_alpha = babl_format_has_alpha (src_format);
 
-  width  = gimp_item_get_width  (GIMP_ITEM (layer));
-  height = gimp_item_get_height (GIMP_ITEM (layer));
+  width = gimp_item_get_width (GIMP_ITEM (layer));
+
+  /* dither the rows above the strip too, only to prime the error rows,
+   * see FS_STRIP_PRIMING
+   */
+  prime_row = MAX (0, first_row - FS_STRIP_PRIMING);
 
   error_limiter = init_error_limit (quantobj->error_freedom);
   range_limiter = range_array + 256;
@@ -3810,9 +4096,10 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
   fs_err3 = floyd_steinberg_error3 + 511;
   fs_err4 = floyd_steinberg_error4 + 511;
 
-  odd_row = 0;
+  /* serpentine scanning, by absolute row */
+  odd_row = prime_row & 1;
 
-  for (row = 0; row < height; row++)
+  for (row = prime_row; row < last_row; row++)
     {
       const guchar *src;
       guchar       *dest;
@@ -3854,12 +4141,7 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
         {
           pixel = range_limiter[src[GRAY] + error_limiter[*pr]];
 
-          cachep = &histogram[pixel];
-          /* If we have not seen this color before, find nearest
-           * colormap entry and update the cache
-           */
-          if (*cachep == 0)
-            fill_inverse_cmap_gray (quantobj, histogram, pixel);
+          index = lookup_inverse_cmap_gray (quantobj, pixel);
 
           if (has_alpha)
             {
@@ -3925,8 +4207,10 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
                 }
             }
 
-          index = *cachep - 1;
-          index_used_count[dest[INDEXED] = index]++;
+          dest[INDEXED] = index;
+
+          if (row >= first_row)
+            index_used_count[index]++;
 
           color = &quantobj->cmap[index];
           pixele = pixel - color->red;
@@ -3958,9 +4242,10 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
 
       odd_row = !odd_row;
 
-      gegl_buffer_set (new_buffer, GEGL_RECTANGLE (0, row, width, 1),
-                       0, NULL, dest_buf,
-                       GEGL_AUTO_ROWSTRIDE);
+      if (row >= first_row)
+        gegl_buffer_set (new_buffer, GEGL_RECTANGLE (0, row, width, 1),
+                         0, NULL, dest_buf,
+                         GEGL_AUTO_ROWSTRIDE);
     }
 
   g_free (error_limiter - 255); /* good lord. */
@@ -3970,13 +4255,37 @@ median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
   g_free (dest_buf);
 }
 
+static void
+median_cut_pass2_rgb_init_range (gsize        offset,
+                                 gsize        size,
+                                 QuantizeObj *quantobj)
+{
+  CFHistogram histogram = quantobj->histogram;
+  gint        R, G, B;
+
+  for (R = offset << BOX_R_LOG;
+       R < (offset + size) << BOX_R_LOG;
+       R++)
+    {
+      for (G = 0; G < HIST_G_ELEMS; G++)
+        {
+          for (B = 0; B < HIST_B_ELEMS; B++)
+            {
+              if (*HIST_LIN (histogram, R, G, B) != 0 &&
+                  *HIST_LIN (quantobj->inverse_cmap, R, G, B) == 0)
+                {
+                  fill_inverse_cmap_rgb (quantobj, R, G, B);
+                }
+            }
+        }
+    }
+}
+
 static void
 median_cut_pass2_rgb_init (QuantizeObj *quantobj)
 {
   int i;
 
-  zero_histogram_rgb (quantobj->histogram);
-
   /* Mark all indices as currently unused */
   memset (quantobj->index_used_count, 0, 256 * sizeof (guint64));
 
@@ -3990,25 +4299,44 @@ median_cut_pass2_rgb_init (QuantizeObj *quantobj)
                             &quantobj->clin[i].green,
                             &quantobj->clin[i].blue);
     }
+
+  g_free (quantobj->inverse_cmap);
+  quantobj->inverse_cmap = g_new0 (gint,
+                                   HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS);
+
+  if (quantobj->has_histogram)
+    {
+      /* The histogram holds the colors of the image; we already know
+       * that all of them are going to be looked up, so fill in their
+       * inverse-colormap entries in parallel, before pass 2 starts.
+       * Each thread only fills the update boxes of its own range.
+       */
+      gegl_parallel_distribute_range (
+        HIST_R_ELEMS >> BOX_R_LOG, 1,
+        (GeglParallelDistributeRangeFunc) median_cut_pass2_rgb_init_range,
+        quantobj);
+    }
 }
 
 static void
 median_cut_pass2_gray_init (QuantizeObj *quantobj)
 {
-  zero_histogram_gray (quantobj->histogram);
+  g_free (quantobj->inverse_cmap);
+  quantobj->inverse_cmap = g_new0 (gint, 256);
 
   /* Mark all indices as currently unused */
   memset (quantobj->index_used_count, 0, 256 * sizeof (guint64));
 }
 
 static void
-median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
-                                GimpLayer   *layer,
-                                GeglBuffer  *new_buffer)
+median_cut_pass2_fs_dither_rgb_strip (QuantizeObj *quantobj,
+                                      GimpLayer   *layer,
+                                      GeglBuffer  *new_buffer,
+                                      gint         first_row,
+                                      gint         last_row,
+                                      guint64     *index_used_count)
 {
   GeglBuffer   *src_buffer;
-  CFHistogram   histogram = quantobj->histogram;
-  ColorFreq    *cachep;
   Color        *color;
   gint         *error_limiter;
   const gshort *fs_err1, *fs_err2;
@@ -4032,14 +4360,14 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
   gint          step_dest, step_src;
   gint          odd_row;
   gboolean      has_alpha;
-  gint          width, height;
+  gint          width;
+  gint          prime_row;
   gint          red_pix   = RED;
   gint          green_pix = GREEN;
   gint          blue_pix  = BLUE;
   gint          alpha_pix = ALPHA;
   gint          offsetx, offsety;
   gboolean      dither_alpha     = quantobj->want_dither_alpha;
-  guint64      *index_used_count = quantobj->index_used_count;
   gint          global_rmax = 0, global_rmin = G_MAXINT;
   gint          global_gmax = 0, global_gmin = G_MAXINT;
   gint          global_bmax = 0, global_bmin = G_MAXINT;
@@ -4062,8 +4390,12 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
 
   has_alpha = babl_format_has_alpha (src_format);
 
-  width  = gimp_item_get_width  (GIMP_ITEM (layer));
-  height = gimp_item_get_height (GIMP_ITEM (layer));
+  width = gimp_item_get_width (GIMP_ITEM (layer));
+
+  /* dither the rows above the strip too, only to prime the error rows,
+   * see FS_STRIP_PRIMING
+   */
+  prime_row = MAX (0, first_row - FS_STRIP_PRIMING);
 
   error_limiter = init_error_limit (quantobj->error_freedom);
   range_limiter = range_array + 256;
@@ -4097,9 +4429,10 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
   fs_err3 = floyd_steinberg_error3 + 511;
   fs_err4 = floyd_steinberg_error4 + 511;
 
-  odd_row = 0;
+  /* serpentine scanning, by absolute row */
+  odd_row = prime_row & 1;
 
-  for (row = 0; row < height; row++)
+  for (row = prime_row; row < last_row; row++)
     {
       const guchar *src;
       guchar       *dest;
@@ -4236,23 +4569,16 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
           ge = range_limiter[ge + error_limiter[*gpr]];
           be = range_limiter[be + error_limiter[*bpr]];
 
-          cachep = HIST_LIN (histogram,
-                             RSDF (re),
-                             GSDF (ge),
-                             BSDF (be));
-          /* If we have not seen this color before, find nearest
-           * colormap entry and update the cache
-           */
-          if (*cachep == 0)
-            fill_inverse_cmap_rgb (quantobj, histogram,
-                                   RSDF (re),
-                                   GSDF (ge),
-                                   BSDF (be));
-
-          index = *cachep - 1;
-          index_used_count[index]++;
+          index = lookup_inverse_cmap_rgb (quantobj,
+                                           RSDF (re),
+                                           GSDF (ge),
+                                           BSDF (be));
+
           dest[INDEXED] = index;
 
+          if (row >= first_row)
+            index_used_count[index]++;
+
           /*if (re > global_rmax)
             re = (re + 3*global_rmax) / 4;
           else if (re < global_rmin)
@@ -4354,13 +4680,10 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
 
       odd_row = !odd_row;
 
-      gegl_buffer_set (new_buffer, GEGL_RECTANGLE (0, row, width, 1),
-                       0, NULL, dest_buf,
-                       GEGL_AUTO_ROWSTRIDE);
-
-      if (quantobj->progress && (row % 16 == 0))
-        gimp_progress_set_value (quantobj->progress,
-                                 (gdouble) row / (gdouble) height);
+      if (row >= first_row)
+        gegl_buffer_set (new_buffer, GEGL_RECTANGLE (0, row, width, 1),
+                         0, NULL, dest_buf,
+                         GEGL_AUTO_ROWSTRIDE);
     }
 
   g_free (error_limiter - 255);
@@ -4375,9 +4698,74 @@ median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
 }
 
 
+static void
+median_cut_pass2_no_dither_gray (QuantizeObj *quantobj,
+                                 GimpLayer   *layer,
+                                 GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_areas (quantobj, layer, new_buffer,
+                                     median_cut_pass2_no_dither_gray_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_gray (QuantizeObj *quantobj,
+                                    GimpLayer   *layer,
+                                    GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_areas (quantobj, layer, new_buffer,
+                                     median_cut_pass2_fixed_dither_gray_area);
+}
+
+static void
+median_cut_pass2_fs_dither_gray (QuantizeObj *quantobj,
+                                 GimpLayer   *layer,
+                                 GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_strips (quantobj, layer, new_buffer,
+                                      median_cut_pass2_fs_dither_gray_strip);
+}
+
+static void
+median_cut_pass2_no_dither_rgb (QuantizeObj *quantobj,
+                                GimpLayer   *layer,
+                                GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_areas (quantobj, layer, new_buffer,
+                                     median_cut_pass2_no_dither_rgb_area);
+}
+
+static void
+median_cut_pass2_fixed_dither_rgb (QuantizeObj *quantobj,
+                                   GimpLayer   *layer,
+                                   GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_areas (quantobj, layer, new_buffer,
+                                     median_cut_pass2_fixed_dither_rgb_area);
+}
+
+static void
+median_cut_pass2_nodestruct_dither_rgb (QuantizeObj *quantobj,
+                                        GimpLayer   *layer,
+                                        GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_areas (quantobj, layer, new_buffer,
+                                     median_cut_pass2_nodestruct_dither_rgb_area);
+}
+
+static void
+median_cut_pass2_fs_dither_rgb (QuantizeObj *quantobj,
+                                GimpLayer   *layer,
+                                GeglBuffer  *new_buffer)
+{
+  median_cut_pass2_distribute_strips (quantobj, layer, new_buffer,
+                                      median_cut_pass2_fs_dither_rgb_strip);
+}
+
+
 static void
 delete_median_cut (QuantizeObj *quantobj)
 {
+  g_free (quantobj->inverse_cmap);
   g_free (quantobj->histogram);
   g_free (quantobj);
 }
@@ -4433,6 +4821,8 @@ initialize_median_cut (GimpImageBaseType       type,
     quantobj->histogram = g_new (ColorFreq,
                                  HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS);
 
+  quantobj->has_histogram            = FALSE;
+  quantobj->inverse_cmap             = NULL;
   quantobj->custom_palette           = custom_palette;
   quantobj->desired_number_of_colors = num_colors;
   quantobj->want_dither_alpha        = want_dither_alpha;
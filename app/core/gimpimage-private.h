@@ -20,6 +20,7 @@
 
 
 typedef struct _GimpImageFlushAccumulator GimpImageFlushAccumulator;
+typedef struct _GimpImageScaleJobs        GimpImageScaleJobs;
 
 struct _GimpImageFlushAccumulator
 {
@@ -87,6 +88,7 @@ struct _GimpImagePrivate
   GFile             *untitled_file;         /*  a file saying "Untitled"     */
 
   gboolean           xcf_compression;       /*  XCF compression enabled?     */
+  gboolean           xcf_mipmaps;           /*  XCF mipmap levels enabled?   */
 
   gint               dirty;                 /*  dirty flag -- # of ops       */
   gint64             dirty_time;            /*  time when image became dirty */
@@ -147,6 +149,9 @@ struct _GimpImagePrivate
   gint               group_count;           /*  nested undo groups           */
   GimpUndoType       pushing_undo_group;    /*  undo group status flag       */
 
+  /*  Drawables being scaled in parallel by gimp_image_scale()  */
+  GimpImageScaleJobs *scale_jobs;
+
   /*  Signal emission accumulator  */
   GimpImageFlushAccumulator  flush_accum;
 };
@@ -20,28 +20,106 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "core-types.h"
 
+#include "config/gimpgeglconfig.h"
+
 #include "gimp.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
+#include "gimpcancelable.h"
+#include "gimpchannel.h"
 #include "gimpcontainer.h"
 #include "gimpguide.h"
 #include "gimpgrouplayer.h"
 #include "gimpimage.h"
 #include "gimpimage-guides.h"
+#include "gimpimage-private.h"
 #include "gimpimage-sample-points.h"
 #include "gimpimage-scale.h"
 #include "gimpimage-undo.h"
 #include "gimpimage-undo-push.h"
+#include "gimpitemstack.h"
 #include "gimplayer.h"
 #include "gimpobjectqueue.h"
 #include "gimpprogress.h"
 #include "gimpprojection.h"
 #include "gimpsamplepoint.h"
+#include "gimpwaitable.h"
 
 #include "gimp-log.h"
 #include "gimp-intl.h"
 
 
+/*  the resolution of a job's progress, and how often
+ *  gimp_image_scale_take_buffer() reports it while waiting for the job
+ */
+#define SCALE_JOB_PROGRESS_MAX       1000
+#define SCALE_JOB_PROGRESS_INTERVAL  (G_TIME_SPAN_SECOND / 20)
+
+
+typedef struct
+{
+  GimpDrawable          *drawable;
+  GeglBuffer            *src_buffer;
+  const Babl            *format;
+  gint                   new_width;
+  gint                   new_height;
+  GimpInterpolationType  interpolation_type;
+  gint64                 memsize;
+  GimpAsync             *async;
+  gint                   progress;  /*  in 1/SCALE_JOB_PROGRESS_MAX, atomic  */
+} ScaleJob;
+
+/*  The drawables of the image are scaled ahead of time in the
+ *  background, in the order in which gimp_image_scale() is going to
+ *  scale them, and their buffers are picked up by gimp_drawable_scale()
+ *  through gimp_image_scale_take_buffer().  The number and total size
+ *  of the buffers which are scaled but not picked up yet is limited.
+ */
+struct _GimpImageScaleJobs
+{
+  GHashTable *jobs;        /*  drawable -> ScaleJob          */
+  GQueue      pending;     /*  jobs which are not started    */
+  gint        n_started;   /*  started and not picked up     */
+  gint64      memsize;     /*  size of the started jobs      */
+  gint        max_started;
+  gint64      max_memsize;
+};
+
+
+static GimpImageScaleJobs * gimp_image_scale_jobs_new     (GimpImage             *image,
+                                                           gdouble                img_scale_w,
+                                                           gdouble                img_scale_h,
+                                                           GimpInterpolationType  interpolation_type);
+static void                 gimp_image_scale_jobs_free    (GimpImageScaleJobs    *jobs);
+static void                 gimp_image_scale_jobs_add_item
+                                                          (GimpImageScaleJobs    *jobs,
+                                                           GimpItem              *item,
+                                                           gdouble                w_factor,
+                                                           gdouble                h_factor,
+                                                           gint                   origin_x,
+                                                           gint                   origin_y,
+                                                           gint                   new_origin_x,
+                                                           gint                   new_origin_y,
+                                                           GimpInterpolationType  interpolation_type);
+static void                 gimp_image_scale_jobs_add_drawable
+                                                          (GimpImageScaleJobs    *jobs,
+                                                           GimpDrawable          *drawable,
+                                                           gint                   new_width,
+                                                           gint                   new_height,
+                                                           GimpInterpolationType  interpolation_type);
+static void                 gimp_image_scale_jobs_start   (GimpImageScaleJobs    *jobs);
+
+static void                 scale_job_free                (ScaleJob              *job);
+static void                 scale_job_func                (GimpAsync             *async,
+                                                           ScaleJob              *job);
+
+
+/*  public functions  */
+
 void
 gimp_image_scale (GimpImage             *image,
                   gint                   new_width,
@@ -49,20 +127,23 @@ gimp_image_scale (GimpImage             *image,
                   GimpInterpolationType  interpolation_type,
                   GimpProgress          *progress)
 {
-  GimpObjectQueue *queue;
-  GimpItem        *item;
-  GList           *list;
-  gint             old_width;
-  gint             old_height;
-  gint             offset_x;
-  gint             offset_y;
-  gdouble          img_scale_w = 1.0;
-  gdouble          img_scale_h = 1.0;
+  GimpImagePrivate *private;
+  GimpObjectQueue  *queue;
+  GimpItem         *item;
+  GList            *list;
+  gint              old_width;
+  gint              old_height;
+  gint              offset_x;
+  gint              offset_y;
+  gdouble           img_scale_w = 1.0;
+  gdouble           img_scale_h = 1.0;
 
   g_return_if_fail (GIMP_IS_IMAGE (image));
   g_return_if_fail (new_width > 0 && new_height > 0);
   g_return_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress));
 
+  private = GIMP_IMAGE_GET_PRIVATE (image);
+
   gimp_set_busy (image->gimp);
 
   queue    = gimp_object_queue_new (progress);
@@ -86,6 +167,13 @@ gimp_image_scale (GimpImage             *image,
   offset_x = (old_width  - new_width)  / 2;
   offset_y = (old_height - new_height) / 2;
 
+  /*  Start scaling the drawables in the background, before anything
+   *  below changes them
+   */
+  private->scale_jobs = gimp_image_scale_jobs_new (image,
+                                                   img_scale_w, img_scale_h,
+                                                   interpolation_type);
+
   /*  Push the image size to the stack  */
   gimp_image_undo_push_image_size (image,
                                    NULL,
@@ -120,6 +208,8 @@ gimp_image_scale (GimpImage             *image,
         }
     }
 
+  g_clear_pointer (&private->scale_jobs, gimp_image_scale_jobs_free);
+
   /*  Scale all Guides  */
   for (list = gimp_image_get_guides (image);
        list;
@@ -258,3 +348,395 @@ gimp_image_scale_check (GimpImage *image,
 
   return GIMP_IMAGE_SCALE_OK;
 }
+
+/**
+ * gimp_image_scale_take_buffer:
+ * @image:      A #GimpImage.
+ * @drawable:   A #GimpDrawable of @image.
+ * @new_width:  The new width of @drawable.
+ * @new_height: The new height of @drawable.
+ * @progress:   A #GimpProgress, or %NULL.
+ *
+ * While gimp_image_scale() is in progress, returns the buffer of
+ * @drawable scaled to @new_width x @new_height in the background,
+ * waiting for it if necessary, and reporting how far the background
+ * scale got on @progress meanwhile.
+ *
+ * Returns: (transfer full) (nullable): the scaled buffer, or %NULL if
+ *          @drawable wasn't scaled in the background, or not to the
+ *          requested size, in which case it has to be scaled by the
+ *          caller.
+ **/
+GeglBuffer *
+gimp_image_scale_take_buffer (GimpImage    *image,
+                              GimpDrawable *drawable,
+                              gint          new_width,
+                              gint          new_height,
+                              GimpProgress *progress)
+{
+  GimpImageScaleJobs *jobs;
+  ScaleJob           *job;
+  GeglBuffer         *buffer = NULL;
+
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), NULL);
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (progress == NULL || GIMP_IS_PROGRESS (progress), NULL);
+
+  jobs = GIMP_IMAGE_GET_PRIVATE (image)->scale_jobs;
+
+  if (! jobs)
+    return NULL;
+
+  job = g_hash_table_lookup (jobs->jobs, drawable);
+
+  if (! job)
+    return NULL;
+
+  g_hash_table_steal (jobs->jobs, drawable);
+
+  if (job->async)
+    {
+      while (! gimp_waitable_wait_for (GIMP_WAITABLE (job->async),
+                                       SCALE_JOB_PROGRESS_INTERVAL))
+        {
+          if (progress)
+            gimp_progress_set_value (progress,
+                                     (gdouble) g_atomic_int_get (&job->progress) /
+                                     SCALE_JOB_PROGRESS_MAX);
+        }
+
+      if (gimp_async_is_finished (job->async) &&
+          job->new_width  == new_width        &&
+          job->new_height == new_height)
+        {
+          buffer = g_object_ref (gimp_async_get_result (job->async));
+        }
+
+      jobs->n_started--;
+      jobs->memsize -= job->memsize;
+    }
+  else
+    {
+      g_queue_remove (&jobs->pending, job);
+    }
+
+  scale_job_free (job);
+
+  gimp_image_scale_jobs_start (jobs);
+
+  return buffer;
+}
+
+
+/*  private functions  */
+
+static GimpImageScaleJobs *
+gimp_image_scale_jobs_new (GimpImage             *image,
+                           gdouble                img_scale_w,
+                           gdouble                img_scale_h,
+                           GimpInterpolationType  interpolation_type)
+{
+  GimpGeglConfig     *config = GIMP_GEGL_CONFIG (image->gimp->config);
+  GimpImageScaleJobs *jobs;
+  GList              *list;
+
+  if (config->num_processors < 2)
+    return NULL;
+
+  jobs = g_slice_new0 (GimpImageScaleJobs);
+
+  jobs->jobs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL,
+                                      (GDestroyNotify) scale_job_free);
+  g_queue_init (&jobs->pending);
+
+  jobs->max_started = config->num_processors;
+  jobs->max_memsize = config->tile_cache_size / 2;
+
+  /*  in the same order as gimp_image_scale() scales the items  */
+  for (list = gimp_image_get_layer_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      gimp_image_scale_jobs_add_item (jobs, list->data,
+                                      img_scale_w, img_scale_h,
+                                      0, 0, 0, 0,
+                                      interpolation_type);
+    }
+
+  gimp_image_scale_jobs_add_item (jobs, GIMP_ITEM (gimp_image_get_mask (image)),
+                                  img_scale_w, img_scale_h,
+                                  0, 0, 0, 0,
+                                  interpolation_type);
+
+  for (list = gimp_image_get_channel_iter (image);
+       list;
+       list = g_list_next (list))
+    {
+      gimp_image_scale_jobs_add_item (jobs, list->data,
+                                      img_scale_w, img_scale_h,
+                                      0, 0, 0, 0,
+                                      interpolation_type);
+    }
+
+  gimp_image_scale_jobs_start (jobs);
+
+  return jobs;
+}
+
+static void
+gimp_image_scale_jobs_free (GimpImageScaleJobs *jobs)
+{
+  GHashTableIter  iter;
+  ScaleJob       *job;
+
+  /*  jobs which were not picked up, e.g. because their items were
+   *  removed, are canceled
+   */
+  g_hash_table_iter_init (&iter, jobs->jobs);
+
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+    {
+      if (job->async)
+        gimp_cancelable_cancel (GIMP_CANCELABLE (job->async));
+    }
+
+  g_queue_clear (&jobs->pending);
+  g_hash_table_unref (jobs->jobs);
+
+  g_slice_free (GimpImageScaleJobs, jobs);
+}
+
+/*  mirrors gimp_item_scale_by_factors_with_origin(), and the way
+ *  GimpLayer and GimpGroupLayer scale their masks and children
+ */
+static void
+gimp_image_scale_jobs_add_item (GimpImageScaleJobs    *jobs,
+                                GimpItem              *item,
+                                gdouble                w_factor,
+                                gdouble                h_factor,
+                                gint                   origin_x,
+                                gint                   origin_y,
+                                gint                   new_origin_x,
+                                gint                   new_origin_y,
+                                GimpInterpolationType  interpolation_type)
+{
+  GimpContainer *children;
+  gint           offset_x;
+  gint           offset_y;
+  gint           new_offset_x;
+  gint           new_offset_y;
+  gint           new_width;
+  gint           new_height;
+
+  if (! GIMP_IS_DRAWABLE (item))
+    return;
+
+  children = gimp_viewable_get_children (GIMP_VIEWABLE (item));
+
+  if (children && gimp_container_is_empty (children))
+    return;
+
+  gimp_item_get_offset (item, &offset_x, &offset_y);
+
+  new_offset_x = SIGNED_ROUND (w_factor * (offset_x - origin_x));
+  new_offset_y = SIGNED_ROUND (h_factor * (offset_y - origin_y));
+  new_width    = SIGNED_ROUND (w_factor * (offset_x - origin_x +
+                                           gimp_item_get_width (item))) -
+                 new_offset_x;
+  new_height   = SIGNED_ROUND (h_factor * (offset_y - origin_y +
+                                           gimp_item_get_height (item))) -
+                 new_offset_y;
+
+  new_offset_x += new_origin_x;
+  new_offset_y += new_origin_y;
+
+  if (new_width <= 0 || new_height <= 0)
+    return;
+
+  if (children)
+    {
+      GList   *list;
+      gdouble  child_w_factor;
+      gdouble  child_h_factor;
+
+      child_w_factor = (gdouble) new_width  / gimp_item_get_width  (item);
+      child_h_factor = (gdouble) new_height / gimp_item_get_height (item);
+
+      for (list = gimp_item_stack_get_item_iter (GIMP_ITEM_STACK (children));
+           list;
+           list = g_list_next (list))
+        {
+          gimp_image_scale_jobs_add_item (jobs, list->data,
+                                          child_w_factor, child_h_factor,
+                                          offset_x, offset_y,
+                                          new_offset_x, new_offset_y,
+                                          interpolation_type);
+        }
+    }
+  else
+    {
+      gimp_image_scale_jobs_add_drawable (jobs, GIMP_DRAWABLE (item),
+                                          new_width, new_height,
+                                          interpolation_type);
+    }
+
+  if (GIMP_IS_LAYER (item) && gimp_layer_get_mask (GIMP_LAYER (item)))
+    {
+      gimp_image_scale_jobs_add_drawable (
+        jobs, GIMP_DRAWABLE (gimp_layer_get_mask (GIMP_LAYER (item))),
+        new_width, new_height,
+        interpolation_type);
+    }
+}
+
+static void
+gimp_image_scale_jobs_add_drawable (GimpImageScaleJobs    *jobs,
+                                    GimpDrawable          *drawable,
+                                    gint                   new_width,
+                                    gint                   new_height,
+                                    GimpInterpolationType  interpolation_type)
+{
+  ScaleJob *job;
+
+  /*  gimp_channel_scale() doesn't scale empty channels  */
+  if (GIMP_IS_CHANNEL (drawable) &&
+      gimp_channel_is_empty (GIMP_CHANNEL (drawable)))
+    {
+      return;
+    }
+
+  job = g_slice_new0 (ScaleJob);
+
+  job->drawable           = g_object_ref (drawable);
+  job->src_buffer         = g_object_ref (gimp_drawable_get_buffer (drawable));
+  job->format             = gimp_drawable_get_format (drawable);
+  job->new_width          = new_width;
+  job->new_height         = new_height;
+  job->interpolation_type = interpolation_type;
+  job->memsize            = (gint64) new_width * new_height *
+                            babl_format_get_bytes_per_pixel (job->format);
+
+  g_hash_table_insert (jobs->jobs, drawable, job);
+  g_queue_push_tail (&jobs->pending, job);
+}
+
+static void
+gimp_image_scale_jobs_start (GimpImageScaleJobs *jobs)
+{
+  ScaleJob *job;
+
+  while ((job = g_queue_peek_head (&jobs->pending)))
+    {
+      /*  always keep at least one job going, however big  */
+      if (jobs->n_started > 0 &&
+          (jobs->n_started >= jobs->max_started ||
+           jobs->memsize + job->memsize > jobs->max_memsize))
+        {
+          break;
+        }
+
+      g_queue_pop_head (&jobs->pending);
+
+      job->async = gimp_parallel_run_async_full (
+        0,
+        (GimpRunAsyncFunc) scale_job_func,
+        job, NULL);
+
+      jobs->n_started++;
+      jobs->memsize += job->memsize;
+    }
+}
+
+static void
+scale_job_free (ScaleJob *job)
+{
+  if (job->async)
+    {
+      gimp_async_cancel_and_wait (job->async);
+      g_object_unref (job->async);
+    }
+
+  g_object_unref (job->src_buffer);
+  g_object_unref (job->drawable);
+
+  g_slice_free (ScaleJob, job);
+}
+
+static void
+scale_job_func (GimpAsync *async,
+                ScaleJob  *job)
+{
+  GeglBuffer    *buffer;
+  GeglNode      *gegl;
+  GeglNode      *source;
+  GeglNode      *node;
+  GeglNode      *dest;
+  GeglProcessor *processor;
+  gdouble        value;
+
+  if (gimp_async_is_canceled (async))
+    {
+      gimp_async_abort (async);
+
+      return;
+    }
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                            job->new_width, job->new_height),
+                            job->format);
+
+  gegl = gegl_node_new ();
+
+  source = gegl_node_new_child (gegl,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    job->src_buffer,
+                                NULL);
+
+  /*  the same scale as gimp_drawable_scale(), using gimp_gegl_apply_scale(),
+   *  processed here so we can report its progress
+   */
+  node = gegl_node_new_child (gegl,
+                              "operation",    "gegl:scale-ratio",
+                              "origin-x",     0.0,
+                              "origin-y",     0.0,
+                              "sampler",      job->interpolation_type,
+                              "abyss-policy", GEGL_ABYSS_CLAMP,
+                              "x",            ((gdouble) job->new_width /
+                                               gegl_buffer_get_width  (job->src_buffer)),
+                              "y",            ((gdouble) job->new_height /
+                                               gegl_buffer_get_height (job->src_buffer)),
+                              NULL);
+
+  dest = gegl_node_new_child (gegl,
+                              "operation", "gegl:write-buffer",
+                              "buffer",    buffer,
+                              NULL);
+
+  gegl_node_link_many (source, node, dest, NULL);
+
+  processor = gegl_node_new_processor (dest,
+                                       gegl_buffer_get_extent (buffer));
+
+  while (gegl_processor_work (processor, &value))
+    {
+      if (gimp_async_is_canceled (async))
+        break;
+
+      g_atomic_int_set (&job->progress, value * SCALE_JOB_PROGRESS_MAX);
+    }
+
+  g_object_unref (processor);
+  g_object_unref (gegl);
+
+  if (gimp_async_is_canceled (async))
+    {
+      g_object_unref (buffer);
+
+      gimp_async_abort (async);
+
+      return;
+    }
+
+  gimp_async_finish_full (async, buffer, g_object_unref);
+}
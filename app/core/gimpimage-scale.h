@@ -19,18 +19,25 @@
 #define __GIMP_IMAGE_SCALE_H__
 
 
-void   gimp_image_scale         (GimpImage             *image,
-                                 gint                   new_width,
-                                 gint                   new_height,
-                                 GimpInterpolationType  interpolation_type,
-                                 GimpProgress          *progress);
+void   gimp_image_scale             (GimpImage             *image,
+                                     gint                   new_width,
+                                     gint                   new_height,
+                                     GimpInterpolationType  interpolation_type,
+                                     GimpProgress          *progress);
 
 GimpImageScaleCheckType
-       gimp_image_scale_check   (GimpImage             *image,
-                                 gint                   new_width,
-                                 gint                   new_height,
-                                 gint64                 max_memsize,
-                                 gint64                *new_memsize);
+       gimp_image_scale_check       (GimpImage             *image,
+                                     gint                   new_width,
+                                     gint                   new_height,
+                                     gint64                 max_memsize,
+                                     gint64                *new_memsize);
+
+GeglBuffer *
+       gimp_image_scale_take_buffer (GimpImage             *image,
+                                     GimpDrawable          *drawable,
+                                     gint                   new_width,
+                                     gint                   new_height,
+                                     GimpProgress          *progress);
 
 
 #endif /* __GIMP_IMAGE_SCALE_H__ */
@@ -339,6 +339,10 @@ gimp_image_undo_group_end (GimpImage *image)
     {
       private->pushing_undo_group = GIMP_UNDO_GROUP_NONE;
 
+      /*  the group grew since it was pushed, measure it once it's complete  */
+      gimp_undo_stack_update_undo (private->undo_stack,
+                                   gimp_undo_stack_peek (private->undo_stack));
+
       /* Do it here, since undo_push doesn't emit this event while in
        * the middle of a group
        */
@@ -460,6 +464,30 @@ gimp_image_undo_can_compress (GimpImage    *image,
   return NULL;
 }
 
+/**
+ * gimp_image_undo_size_changed:
+ * @image: a #GimpImage
+ * @undo:  a #GimpUndo on one of @image's undo stacks
+ *
+ * Lets the undo stacks re-measure @undo, for undo steps whose memory
+ * use changes after they were pushed, e.g. because their data got
+ * compressed in the background, or their preview was created.
+ **/
+void
+gimp_image_undo_size_changed (GimpImage *image,
+                              GimpUndo  *undo)
+{
+  GimpImagePrivate *private;
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  if (! gimp_undo_stack_update_undo (private->undo_stack, undo))
+    gimp_undo_stack_update_undo (private->redo_stack, undo);
+}
+
 
 /*  private functions  */
 
@@ -530,14 +558,14 @@ gimp_image_undo_free_space (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("undo_steps: %d    undo_bytes: %ld\n",
               gimp_container_get_n_children (container),
-              (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
+              (glong) gimp_undo_stack_get_size (private->undo_stack));
 #endif
 
   /*  keep at least min_undo_levels undo steps  */
   if (gimp_container_get_n_children (container) <= min_undo_levels)
     return;
 
-  while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+  while ((gimp_undo_stack_get_size (private->undo_stack) > undo_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
       GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
@@ -546,8 +574,7 @@ gimp_image_undo_free_space (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: undo_steps: %d    undo_bytes: %ld\n",
                   gimp_container_get_n_children (container),
-                  (glong) gimp_object_get_memsize (GIMP_OBJECT (container),
-                                                   NULL));
+                  (glong) gimp_undo_stack_get_size (private->undo_stack));
 #endif
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_UNDO_EXPIRED, freed);
@@ -568,7 +595,7 @@ gimp_image_undo_free_redo (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
   g_printerr ("redo_steps: %d    redo_bytes: %ld\n",
               gimp_container_get_n_children (container),
-              (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
+              (glong) gimp_undo_stack_get_size (private->redo_stack));
 #endif
 
   if (gimp_container_is_empty (container))
@@ -582,8 +609,7 @@ gimp_image_undo_free_redo (GimpImage *image)
 #ifdef DEBUG_IMAGE_UNDO
       g_printerr ("freed one step: redo_steps: %d    redo_bytes: %ld\n",
                   gimp_container_get_n_children (container),
-                  (glong )gimp_object_get_memsize (GIMP_OBJECT (container),
-                                                   NULL));
+                  (glong) gimp_undo_stack_get_size (private->redo_stack));
 #endif
 
       gimp_image_undo_event (image, GIMP_UNDO_EVENT_REDO_EXPIRED, freed);
@@ -53,5 +53,8 @@ GimpUndo      * gimp_image_undo_can_compress    (GimpImage     *image,
                                                  GType          object_type,
                                                  GimpUndoType   undo_type);
 
+void            gimp_image_undo_size_changed    (GimpImage     *image,
+                                                 GimpUndo      *undo);
+
 
 #endif /* __GIMP_IMAGE__UNDO_H__ */
@@ -2796,7 +2796,8 @@ gimp_image_get_export_proc (GimpImage *image)
 
 gint
 gimp_image_get_xcf_version (GimpImage    *image,
-                            gboolean      zlib_compression,
+                            gboolean      compression,
+                            gboolean      mipmaps,
                             gint         *gimp_version,
                             const gchar **version_string,
                             gchar       **version_reason)
@@ -3026,8 +3027,16 @@ gimp_image_get_xcf_version (GimpImage    *image,
       version = MAX (12, version);
     }
 
-  /* need version 8 for zlib compression */
-  if (zlib_compression)
+  /* need version 8 for zlib compression, and version 20 for zstd
+   * compression, which is used instead if so configured
+   */
+  if (compression && image->gimp->config->xcf_zstd_compression)
+    {
+      ADD_REASON (g_strdup_printf (_("Internal zstd compression was "
+                                     "added in %s"), "GIMP 3.0.0"));
+      version = MAX (20, version);
+    }
+  else if (compression)
     {
       ADD_REASON (g_strdup_printf (_("Internal zlib compression was "
                                      "added in %s"), "GIMP 2.10"));
@@ -3092,6 +3101,16 @@ gimp_image_get_xcf_version (GimpImage    *image,
       version = MAX (16, version);
     }
 
+  /* need version 19 for mipmap levels, which use real offsets for
+   * the levels above the first
+   */
+  if (mipmaps)
+    {
+      ADD_REASON (g_strdup_printf (_("Mipmap levels were added in %s"),
+                                   "GIMP 3.0.0"));
+      version = MAX (19, version);
+    }
+
 
 #undef ADD_REASON
 
@@ -3127,6 +3146,8 @@ gimp_image_get_xcf_version (GimpImage    *image,
     case 16:
     case 17:
     case 18:
+    case 19:
+    case 20:
       if (gimp_version)   *gimp_version   = 300;
       if (version_string) *version_string = "GIMP 3.0";
       break;
@@ -3170,6 +3191,23 @@ gimp_image_get_xcf_compression (GimpImage *image)
   return GIMP_IMAGE_GET_PRIVATE (image)->xcf_compression;
 }
 
+void
+gimp_image_set_xcf_mipmaps (GimpImage *image,
+                            gboolean   mipmaps)
+{
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+
+  GIMP_IMAGE_GET_PRIVATE (image)->xcf_mipmaps = mipmaps;
+}
+
+gboolean
+gimp_image_get_xcf_mipmaps (GimpImage *image)
+{
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), FALSE);
+
+  return GIMP_IMAGE_GET_PRIVATE (image)->xcf_mipmaps;
+}
+
 void
 gimp_image_set_resolution (GimpImage *image,
                            gdouble    xresolution,
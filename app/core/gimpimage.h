@@ -183,7 +183,8 @@ void            gimp_image_exported              (GimpImage          *image,
                                                   GFile              *file);
 
 gint            gimp_image_get_xcf_version       (GimpImage          *image,
-                                                  gboolean            zlib_compression,
+                                                  gboolean            compression,
+                                                  gboolean            mipmaps,
                                                   gint               *gimp_version,
                                                   const gchar       **version_string,
                                                   gchar             **version_reason);
@@ -192,6 +193,10 @@ void            gimp_image_set_xcf_compression   (GimpImage          *image,
                                                   gboolean            compression);
 gboolean        gimp_image_get_xcf_compression   (GimpImage          *image);
 
+void            gimp_image_set_xcf_mipmaps       (GimpImage          *image,
+                                                  gboolean            mipmaps);
+gboolean        gimp_image_get_xcf_mipmaps       (GimpImage          *image);
+
 void            gimp_image_set_resolution        (GimpImage          *image,
                                                   gdouble             xres,
                                                   gdouble             yres);
@@ -47,6 +47,16 @@ extern "C"
 #define PIXELS_PER_THREAD \
   (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
 
+/* the size of the tiles the parallel fill labels independently */
+#define FILL_TILE_SIZE 256
+
+/* the minimal extent area for which the parallel fill is considered, and
+ * the fraction of it the serial fill may select before we switch to the
+ * parallel fill
+ */
+#define PARALLEL_FILL_MIN_AREA (1024 * 1024)
+#define SERIAL_FILL_FRACTION   16
+
 
 typedef struct
 {
@@ -55,6 +65,23 @@ typedef struct
   gint   level;
 } BorderPixel;
 
+typedef struct
+{
+  GeglRectangle  rect;
+
+  gint           n_labels;
+  gint           n_border_labels;
+  gint           seed_label;
+  gint           seed_border_label;
+  gint           base;
+  gint           n_kept;
+
+  /* the border labels of the pixels along the top, bottom, left and right
+   * edges of the tile, in this order, or -1 for unselected pixels
+   */
+  gint          *edges;
+} FillTile;
+
 
 /*  local function prototypes  */
 
@@ -101,7 +128,42 @@ static gboolean find_contiguous_segment   (const gfloat        *col,
                                            gint                *start,
                                            gint                *end,
                                            gfloat              *row);
-static void     find_contiguous_region    (GeglBuffer          *src_buffer,
+static gboolean find_contiguous_region    (GeglBuffer          *src_buffer,
+                                           GeglBuffer          *mask_buffer,
+                                           const Babl          *format,
+                                           gint                 n_components,
+                                           gboolean             has_alpha,
+                                           gboolean             select_transparent,
+                                           GimpSelectCriterion  select_criterion,
+                                           gboolean             antialias,
+                                           gfloat               threshold,
+                                           gboolean             diagonal_neighbors,
+                                           gint                 x,
+                                           gint                 y,
+                                           const gfloat        *col,
+                                           gint64               max_pixels);
+
+static gint     fill_label_tile           (const gfloat        *mask,
+                                           gint                 width,
+                                           gint                 height,
+                                           gboolean             diagonal_neighbors,
+                                           gint                *labels,
+                                           gint                *parent);
+static gint     fill_label_tile_border    (const gint          *labels,
+                                           gint                 width,
+                                           gint                 height,
+                                           gint                 n_labels,
+                                           gint                *border,
+                                           gint                *edges);
+static void     fill_union_edges          (gint                *parent,
+                                           gint                 base1,
+                                           const gint          *edge1,
+                                           gint                 base2,
+                                           const gint          *edge2,
+                                           gint                 n,
+                                           gboolean             diagonal_neighbors);
+static void     find_contiguous_region_parallel
+                                          (GeglBuffer          *src_buffer,
                                            GeglBuffer          *mask_buffer,
                                            const Babl          *format,
                                            gint                 n_components,
@@ -174,13 +236,33 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
   if (x >= extent.x && x < (extent.x + extent.width) &&
       y >= extent.y && y < (extent.y + extent.height))
     {
+      gint64 area       = (gint64) extent.width * extent.height;
+      gint64 max_pixels = -1;
+
+      /* the serial fill only touches the selected region, while the
+       * parallel fill always processes the entire extent.  start with the
+       * serial fill, and switch to the parallel fill once the region turns
+       * out to cover a large part of a large extent.
+       */
+      if (area >= PARALLEL_FILL_MIN_AREA)
+        max_pixels = area / SERIAL_FILL_FRACTION;
+
       GIMP_TIMER_START();
 
-      find_contiguous_region (src_buffer, mask_buffer,
-                              format, n_components, has_alpha,
-                              select_transparent, select_criterion,
-                              antialias, threshold, diagonal_neighbors,
-                              x, y, start_col);
+      if (! find_contiguous_region (src_buffer, mask_buffer,
+                                    format, n_components, has_alpha,
+                                    select_transparent, select_criterion,
+                                    antialias, threshold, diagonal_neighbors,
+                                    x, y, start_col, max_pixels))
+        {
+          find_contiguous_region_parallel (src_buffer, mask_buffer,
+                                           format, n_components, has_alpha,
+                                           select_transparent,
+                                           select_criterion,
+                                           antialias, threshold,
+                                           diagonal_neighbors,
+                                           x, y, start_col);
+        }
 
       GIMP_TIMER_END("foo");
     }
@@ -417,7 +499,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x - 1, y - 1, &col);
+                                    x - 1, y - 1, &col, -1);
 
           if (x - 1 >= extent.x && x - 1 < extent.x + extent.width &&
               y >= extent.y && y < (extent.y + extent.height))
@@ -425,7 +507,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x - 1, y, &col);
+                                    x - 1, y, &col, -1);
 
           if (x - 1 >= extent.x && x - 1 < extent.x + extent.width &&
               y + 1 >= extent.y && y + 1 < (extent.y + extent.height))
@@ -433,7 +515,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x - 1, y + 1, &col);
+                                    x - 1, y + 1, &col, -1);
 
           if (x >= extent.x && x < extent.x + extent.width &&
               y - 1 >= extent.y && y - 1 < (extent.y + extent.height))
@@ -441,7 +523,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x, y - 1, &col);
+                                    x, y - 1, &col, -1);
 
           if (x >= extent.x && x < extent.x + extent.width &&
               y + 1 >= extent.y && y + 1 < (extent.y + extent.height))
@@ -449,7 +531,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x, y + 1, &col);
+                                    x, y + 1, &col, -1);
 
           if (x + 1 >= extent.x && x + 1 < extent.x + extent.width &&
               y - 1 >= extent.y && y - 1 < (extent.y + extent.height))
@@ -457,7 +539,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x + 1, y - 1, &col);
+                                    x + 1, y - 1, &col, -1);
 
           if (x + 1 >= extent.x && x + 1 < extent.x + extent.width &&
               y >= extent.y && y < (extent.y + extent.height))
@@ -465,7 +547,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x + 1, y, &col);
+                                    x + 1, y, &col, -1);
 
           if (x + 1 >= extent.x && x + 1 < extent.x + extent.width &&
               y + 1 >= extent.y && y + 1 < (extent.y + extent.height))
@@ -473,7 +555,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                                     format, 1, FALSE,
                                     FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                                     FALSE, 0.0, FALSE,
-                                    x + 1, y + 1, &col);
+                                    x + 1, y + 1, &col, -1);
 
           filled = TRUE;
         }
@@ -487,7 +569,7 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable  *pickable,
                               format, 1, FALSE,
                               FALSE, GIMP_SELECT_CRITERION_COMPOSITE,
                               FALSE, 0.0, FALSE,
-                              x, y, &col);
+                              x, y, &col, -1);
       filled = TRUE;
     }
 
@@ -1067,7 +1149,7 @@ find_contiguous_segment (const gfloat        *col,
   return TRUE;
 }
 
-static void
+static gboolean
 find_contiguous_region (GeglBuffer          *src_buffer,
                         GeglBuffer          *mask_buffer,
                         const Babl          *format,
@@ -1080,7 +1162,8 @@ find_contiguous_region (GeglBuffer          *src_buffer,
                         gboolean             diagonal_neighbors,
                         gint                 x,
                         gint                 y,
-                        const gfloat        *col)
+                        const gfloat        *col,
+                        gint64               max_pixels)
 {
   const Babl          *mask_format = babl_format ("Y float");
   GeglSampler         *src_sampler;
@@ -1089,7 +1172,9 @@ find_contiguous_region (GeglBuffer          *src_buffer,
   gint                 start, end;
   gint                 new_start, new_end;
   GQueue              *segment_queue;
-  gfloat              *row = NULL;
+  gfloat              *row      = NULL;
+  gint64               n_pixels = 0;
+  gboolean             complete = TRUE;
 
   src_extent = gegl_buffer_get_extent (src_buffer);
 
@@ -1149,6 +1234,17 @@ find_contiguous_region (GeglBuffer          *src_buffer,
            */
           x = new_end;
 
+          /* give up once we've selected more than `max_pixels` pixels, and
+           * let the caller fill the region by other means.
+           */
+          n_pixels += new_end - new_start - 1;
+
+          if (max_pixels >= 0 && n_pixels > max_pixels)
+            {
+              complete = FALSE;
+              break;
+            }
+
           if (diagonal_neighbors)
             {
               if (new_start >= src_extent->x)
@@ -1174,7 +1270,7 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 
         }
     }
-  while (! g_queue_is_empty (segment_queue));
+  while (complete && ! g_queue_is_empty (segment_queue));
 
   g_queue_free (segment_queue);
 
@@ -1183,6 +1279,526 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 #ifdef FETCH_ROW
   g_free (row);
 #endif
+
+  return complete;
+}
+
+static inline gint
+fill_label_find (gint *parent,
+                 gint  label)
+{
+  while (parent[label] != label)
+    {
+      parent[label] = parent[parent[label]];
+      label         = parent[label];
+    }
+
+  return label;
+}
+
+static inline void
+fill_label_union (gint *parent,
+                  gint  label1,
+                  gint  label2)
+{
+  label1 = fill_label_find (parent, label1);
+  label2 = fill_label_find (parent, label2);
+
+  /* always link the larger root to the smaller one, so that the result
+   * doesn't depend on the order of the unions, and so that a label's
+   * parent is never larger than the label itself.
+   */
+  if (label1 < label2)
+    parent[label2] = label1;
+  else if (label2 < label1)
+    parent[label1] = label2;
+}
+
+static inline void
+fill_label_merge (gint *parent,
+                  gint *label,
+                  gint  neighbor)
+{
+  if (neighbor < 0)
+    return;
+
+  if (*label < 0)
+    *label = neighbor;
+  else
+    fill_label_union (parent, *label, neighbor);
+}
+
+/* labels the connected components of the nonzero pixels of `mask`, writing
+ * the label of each pixel to `labels` (or -1 for zero pixels), and returns
+ * the number of components.  components are numbered in the order of their
+ * first pixel in raster order, so that the labels only depend on `mask`.
+ * `parent` is scratch space, with room for `width * height` labels.
+ */
+static gint
+fill_label_tile (const gfloat *mask,
+                 gint          width,
+                 gint          height,
+                 gboolean      diagonal_neighbors,
+                 gint         *labels,
+                 gint         *parent)
+{
+  gint n        = 0;
+  gint n_labels = 0;
+  gint x, y;
+  gint i;
+
+  for (y = 0, i = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++, i++)
+        {
+          gint label = -1;
+
+          if (mask[i] == 0.0f)
+            {
+              labels[i] = -1;
+
+              continue;
+            }
+
+          if (x > 0)
+            fill_label_merge (parent, &label, labels[i - 1]);
+
+          if (y > 0)
+            {
+              fill_label_merge (parent, &label, labels[i - width]);
+
+              if (diagonal_neighbors)
+                {
+                  if (x > 0)
+                    fill_label_merge (parent, &label, labels[i - width - 1]);
+
+                  if (x < width - 1)
+                    fill_label_merge (parent, &label, labels[i - width + 1]);
+                }
+            }
+
+          if (label < 0)
+            {
+              label     = n;
+              parent[n] = n;
+              n++;
+            }
+
+          labels[i] = label;
+        }
+    }
+
+  /* since a label's parent is never larger than the label, a single pass
+   * in increasing order is enough to map each provisional label to the
+   * final label of its component.
+   */
+  for (i = 0; i < n; i++)
+    {
+      if (parent[i] == i)
+        parent[i] = n_labels++;
+      else
+        parent[i] = parent[parent[i]];
+    }
+
+  for (i = 0; i < width * height; i++)
+    {
+      if (labels[i] >= 0)
+        labels[i] = parent[labels[i]];
+    }
+
+  return n_labels;
+}
+
+/* numbers the components touching the edges of a labeled tile, writing the
+ * border label of each component to `border` (or -1 for interior
+ * components), and, if `edges` is non-NULL, the border labels of the edge
+ * pixels to `edges`.  returns the number of border labels.
+ */
+static gint
+fill_label_tile_border (const gint *labels,
+                        gint        width,
+                        gint        height,
+                        gint        n_labels,
+                        gint       *border,
+                        gint       *edges)
+{
+  const struct
+  {
+    gint offset;
+    gint stride;
+    gint n;
+  } sides[] =
+  {
+    { 0,                    1,     width  }, /* top    */
+    { (height - 1) * width, 1,     width  }, /* bottom */
+    { 0,                    width, height }, /* left   */
+    { width - 1,            width, height }  /* right  */
+  };
+  gint n_border_labels = 0;
+  gint i;
+  gint j;
+
+  for (i = 0; i < n_labels; i++)
+    border[i] = -1;
+
+  for (i = 0; i < (gint) G_N_ELEMENTS (sides); i++)
+    {
+      for (j = 0; j < sides[i].n; j++)
+        {
+          gint label = labels[sides[i].offset + j * sides[i].stride];
+
+          if (label >= 0 && border[label] < 0)
+            border[label] = n_border_labels++;
+
+          if (edges)
+            *edges++ = label >= 0 ? border[label] : -1;
+        }
+    }
+
+  return n_border_labels;
+}
+
+static void
+fill_union_edges (gint       *parent,
+                  gint        base1,
+                  const gint *edge1,
+                  gint        base2,
+                  const gint *edge2,
+                  gint        n,
+                  gboolean    diagonal_neighbors)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (edge1[i] < 0)
+        continue;
+
+      if (edge2[i] >= 0)
+        fill_label_union (parent, base1 + edge1[i], base2 + edge2[i]);
+
+      if (diagonal_neighbors)
+        {
+          if (i > 0 && edge2[i - 1] >= 0)
+            fill_label_union (parent, base1 + edge1[i], base2 + edge2[i - 1]);
+
+          if (i < n - 1 && edge2[i + 1] >= 0)
+            fill_label_union (parent, base1 + edge1[i], base2 + edge2[i + 1]);
+        }
+    }
+}
+
+/* a tile-parallel version of find_contiguous_region(), producing the same
+ * mask.  the difference of all pixels is computed, and the selected pixels
+ * of each tile are labeled, in parallel; the components touching the tile
+ * edges are then merged across tiles, and, finally, the pixels that don't
+ * belong to the seed's component are cleared, again in parallel.
+ */
+static void
+find_contiguous_region_parallel (GeglBuffer          *src_buffer,
+                                 GeglBuffer          *mask_buffer,
+                                 const Babl          *format,
+                                 gint                 n_components,
+                                 gboolean             has_alpha,
+                                 gboolean             select_transparent,
+                                 GimpSelectCriterion  select_criterion,
+                                 gboolean             antialias,
+                                 gfloat               threshold,
+                                 gboolean             diagonal_neighbors,
+                                 gint                 x,
+                                 gint                 y,
+                                 const gfloat        *col)
+{
+  const Babl          *mask_format = babl_format ("Y float");
+  const GeglRectangle *src_extent;
+  FillTile            *tiles;
+  FillTile            *seed_tile;
+  gint                *parent;
+  gint                 n_cols;
+  gint                 n_rows;
+  gint                 n_tiles;
+  gint                 n_border_labels = 0;
+  gint                 seed_root       = -1;
+  gint                 tile_x;
+  gint                 tile_y;
+  gint                 i;
+
+  src_extent = gegl_buffer_get_extent (src_buffer);
+
+  n_cols  = (src_extent->width  + FILL_TILE_SIZE - 1) / FILL_TILE_SIZE;
+  n_rows  = (src_extent->height + FILL_TILE_SIZE - 1) / FILL_TILE_SIZE;
+  n_tiles = n_cols * n_rows;
+
+  tiles = g_new0 (FillTile, n_tiles);
+
+  for (tile_y = 0; tile_y < n_rows; tile_y++)
+    {
+      for (tile_x = 0; tile_x < n_cols; tile_x++)
+        {
+          FillTile *tile = &tiles[tile_y * n_cols + tile_x];
+
+          tile->rect.x      = src_extent->x + tile_x * FILL_TILE_SIZE;
+          tile->rect.y      = src_extent->y + tile_y * FILL_TILE_SIZE;
+          tile->rect.width  = MIN (FILL_TILE_SIZE,
+                                   src_extent->width  - tile_x * FILL_TILE_SIZE);
+          tile->rect.height = MIN (FILL_TILE_SIZE,
+                                   src_extent->height - tile_y * FILL_TILE_SIZE);
+
+          tile->seed_label        = -1;
+          tile->seed_border_label = -1;
+
+          tile->edges = g_new (gint, 2 * (tile->rect.width +
+                                          tile->rect.height));
+        }
+    }
+
+  seed_tile = &tiles[((y - src_extent->y) / FILL_TILE_SIZE) * n_cols +
+                     ((x - src_extent->x) / FILL_TILE_SIZE)];
+
+  /* compute the difference of all pixels, and label each tile */
+  gegl_parallel_distribute_range (
+    n_tiles, 1,
+    [=] (gint offset, gint size)
+    {
+      gfloat *src     = g_new (gfloat, FILL_TILE_SIZE * FILL_TILE_SIZE *
+                                       n_components);
+      gfloat *mask    = g_new (gfloat, FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint   *labels  = g_new (gint,   FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint   *scratch = g_new (gint,   FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint    i;
+
+      for (i = offset; i < offset + size; i++)
+        {
+          FillTile            *tile = &tiles[i];
+          const GeglRectangle *rect = &tile->rect;
+          gint                 n    = rect->width * rect->height;
+          gint                 j;
+
+          gegl_buffer_get (src_buffer, rect, 1.0, format, src,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (j = 0; j < n; j++)
+            {
+              mask[j] = pixel_difference (col, src + j * n_components,
+                                          antialias,
+                                          threshold,
+                                          n_components,
+                                          has_alpha,
+                                          select_transparent,
+                                          select_criterion);
+            }
+
+          gegl_buffer_set (mask_buffer, rect, 0, mask_format, mask,
+                           GEGL_AUTO_ROWSTRIDE);
+
+          tile->n_labels        = fill_label_tile (mask,
+                                                   rect->width, rect->height,
+                                                   diagonal_neighbors,
+                                                   labels, scratch);
+          tile->n_border_labels = fill_label_tile_border (labels,
+                                                          rect->width,
+                                                          rect->height,
+                                                          tile->n_labels,
+                                                          scratch,
+                                                          tile->edges);
+
+          if (tile == seed_tile)
+            {
+              tile->seed_label = labels[(y - rect->y) * rect->width +
+                                        (x - rect->x)];
+
+              if (tile->seed_label >= 0)
+                tile->seed_border_label = scratch[tile->seed_label];
+            }
+        }
+
+      g_free (src);
+      g_free (mask);
+      g_free (labels);
+      g_free (scratch);
+    });
+
+  if (seed_tile->seed_label < 0)
+    {
+      /* the seed pixel itself isn't selected */
+      gegl_buffer_clear (mask_buffer, NULL);
+
+      goto finish;
+    }
+
+  /* merge the components touching the tile edges across tiles */
+  for (i = 0; i < n_tiles; i++)
+    {
+      tiles[i].base    = n_border_labels;
+      n_border_labels += tiles[i].n_border_labels;
+    }
+
+  parent = g_new (gint, MAX (n_border_labels, 1));
+
+  for (i = 0; i < n_border_labels; i++)
+    parent[i] = i;
+
+  for (tile_y = 0; tile_y < n_rows; tile_y++)
+    {
+      for (tile_x = 0; tile_x < n_cols; tile_x++)
+        {
+          const FillTile *tile   = &tiles[tile_y * n_cols + tile_x];
+          gint            width  = tile->rect.width;
+          gint            height = tile->rect.height;
+          const gint     *bottom = tile->edges + width;
+          const gint     *right  = tile->edges + 2 * width + height;
+
+          if (tile_x + 1 < n_cols)
+            {
+              const FillTile *next = tile + 1;
+
+              fill_union_edges (parent,
+                                tile->base, right,
+                                next->base, next->edges + 2 * next->rect.width,
+                                height, diagonal_neighbors);
+            }
+
+          if (tile_y + 1 < n_rows)
+            {
+              const FillTile *next = tile + n_cols;
+
+              fill_union_edges (parent,
+                                tile->base, bottom,
+                                next->base, next->edges,
+                                width, diagonal_neighbors);
+
+              /* with diagonal neighbors, the corner pixels of diagonally
+               * adjacent tiles are connected too
+               */
+              if (diagonal_neighbors && tile_x + 1 < n_cols)
+                {
+                  next = tile + n_cols + 1;
+
+                  if (bottom[width - 1] >= 0 && next->edges[0] >= 0)
+                    {
+                      fill_label_union (parent,
+                                        tile->base + bottom[width - 1],
+                                        next->base + next->edges[0]);
+                    }
+                }
+
+              if (diagonal_neighbors && tile_x > 0)
+                {
+                  next = tile + n_cols - 1;
+
+                  if (bottom[0] >= 0 &&
+                      next->edges[next->rect.width - 1] >= 0)
+                    {
+                      fill_label_union (parent,
+                                        tile->base + bottom[0],
+                                        next->base +
+                                        next->edges[next->rect.width - 1]);
+                    }
+                }
+            }
+        }
+    }
+
+  /* resolve all roots, so that `parent` can be read concurrently below */
+  for (i = 0; i < n_border_labels; i++)
+    parent[i] = fill_label_find (parent, i);
+
+  if (seed_tile->seed_border_label >= 0)
+    seed_root = parent[seed_tile->base + seed_tile->seed_border_label];
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      FillTile *tile = &tiles[i];
+      gint      j;
+
+      if (seed_root >= 0)
+        {
+          for (j = 0; j < tile->n_border_labels; j++)
+            {
+              if (parent[tile->base + j] == seed_root)
+                tile->n_kept++;
+            }
+        }
+      else if (tile == seed_tile)
+        {
+          tile->n_kept = 1;
+        }
+    }
+
+  /* clear the pixels outside of the seed's component */
+  gegl_parallel_distribute_range (
+    n_tiles, 1,
+    [=] (gint offset, gint size)
+    {
+      gfloat *mask   = g_new (gfloat, FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint   *labels = g_new (gint,   FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint   *keep   = g_new (gint,   FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint   *border = g_new (gint,   FILL_TILE_SIZE * FILL_TILE_SIZE);
+      gint    i;
+
+      for (i = offset; i < offset + size; i++)
+        {
+          const FillTile      *tile = &tiles[i];
+          const GeglRectangle *rect = &tile->rect;
+          gint                 n    = rect->width * rect->height;
+          gint                 n_labels;
+          gint                 j;
+
+          if (tile->n_kept == tile->n_labels)
+            continue;
+
+          if (tile->n_kept == 0)
+            {
+              gegl_buffer_clear (mask_buffer, rect);
+
+              continue;
+            }
+
+          gegl_buffer_get (mask_buffer, rect, 1.0, mask_format, mask,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          /* labeling is deterministic, so we get the same labels as
+           * before
+           */
+          n_labels = fill_label_tile (mask,
+                                      rect->width, rect->height,
+                                      diagonal_neighbors,
+                                      labels, keep);
+          fill_label_tile_border (labels,
+                                  rect->width, rect->height,
+                                  n_labels, border, NULL);
+
+          for (j = 0; j < n_labels; j++)
+            {
+              if (border[j] >= 0)
+                keep[j] = parent[tile->base + border[j]] == seed_root;
+              else
+                keep[j] = j == tile->seed_label;
+            }
+
+          for (j = 0; j < n; j++)
+            {
+              if (labels[j] >= 0 && ! keep[labels[j]])
+                mask[j] = 0.0f;
+            }
+
+          gegl_buffer_set (mask_buffer, rect, 0, mask_format, mask,
+                           GEGL_AUTO_ROWSTRIDE);
+        }
+
+      g_free (mask);
+      g_free (labels);
+      g_free (keep);
+      g_free (border);
+    });
+
+  g_free (parent);
+
+finish:
+  for (i = 0; i < n_tiles; i++)
+    g_free (tiles[i].edges);
+
+  g_free (tiles);
 }
 
 static void
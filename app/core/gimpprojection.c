@@ -29,12 +29,16 @@
 
 #include "core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
 #include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
 #include "gimpchunkiterator.h"
 #include "gimpimage.h"
 #include "gimpmarshal.h"
@@ -51,6 +55,11 @@
 #define GIMP_PROJECTION_UPDATE_CHUNK_WIDTH  32
 #define GIMP_PROJECTION_UPDATE_CHUNK_HEIGHT 32
 
+/*  iteration interval of asynchronous rendering, which is also the
+ *  longest time the main thread has to wait when it stops rendering
+ */
+#define GIMP_PROJECTION_RENDER_ASYNC_INTERVAL (1.0 / 60.0) /* seconds */
+
 
 enum
 {
@@ -79,6 +88,13 @@ struct _GimpProjectionPrivate
   GimpChunkIterator         *iter;
   guint                      idle_id;
 
+  GimpAsync                 *render_async;
+  GeglRectangle              render_bounding_box;
+
+  GMutex                     notify_mutex;    /* protects the fields below */
+  cairo_region_t            *rendered_region; /* rendered asynchronously   */
+  guint                      notify_idle_id;
+
   gboolean                   invalidate_preview;
 };
 
@@ -147,6 +163,26 @@ static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gint             y,
                                                           gint             w,
                                                           gint             h);
+static gboolean    gimp_projection_validate_area         (GimpProjection  *proj,
+                                                          gboolean         now,
+                                                          gint             x,
+                                                          gint             y,
+                                                          gint             w,
+                                                          gint             h,
+                                                          GeglRectangle   *rect);
+
+static gboolean    gimp_projection_use_render_async      (GimpProjection  *proj);
+static void        gimp_projection_render_async_start    (GimpProjection  *proj);
+static void        gimp_projection_render_async_stop     (GimpProjection  *proj);
+static void        gimp_projection_render_async_func     (GimpAsync       *async,
+                                                          GimpProjection  *proj);
+static void        gimp_projection_render_async_callback (GimpAsync       *async,
+                                                          GimpProjection  *proj);
+static void        gimp_projection_render_async_queue_notify
+                                                         (GimpProjection  *proj);
+static gboolean    gimp_projection_render_async_notify_callback
+                                                         (GimpProjection  *proj);
+static void        gimp_projection_render_async_notify   (GimpProjection  *proj);
 
 static void        gimp_projection_projectable_invalidate(GimpProjectable *projectable,
                                                           gint             x,
@@ -209,6 +245,8 @@ static void
 gimp_projection_init (GimpProjection *proj)
 {
   proj->priv = gimp_projection_get_instance_private (proj);
+
+  g_mutex_init (&proj->priv->notify_mutex);
 }
 
 static void
@@ -233,6 +271,8 @@ gimp_projection_finalize (GObject *object)
 
   gimp_projection_free_buffer (proj);
 
+  g_mutex_clear (&proj->priv->notify_mutex);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -514,6 +554,12 @@ gimp_projection_set_priority_rect (GimpProjection *proj,
 {
   g_return_if_fail (GIMP_IS_PROJECTION (proj));
 
+  if (gegl_rectangle_equal (&proj->priv->priority_rect,
+                            GEGL_RECTANGLE (x, y, w, h)))
+    {
+      return;
+    }
+
   proj->priv->priority_rect = *GEGL_RECTANGLE (x, y, w, h);
 
   gimp_projection_update_priority_rect (proj);
@@ -551,6 +597,8 @@ gimp_projection_finish_draw (GimpProjection *proj)
 {
   g_return_if_fail (GIMP_IS_PROJECTION (proj));
 
+  gimp_projection_render_async_stop (proj);
+
   if (proj->priv->iter)
     {
       gimp_chunk_iterator_set_priority_rect (proj->priv->iter, NULL);
@@ -600,6 +648,18 @@ gimp_projection_free_buffer (GimpProjection  *proj)
 
   g_clear_pointer (&proj->priv->update_region, cairo_region_destroy);
 
+  g_mutex_lock (&proj->priv->notify_mutex);
+
+  if (proj->priv->notify_idle_id)
+    {
+      g_source_remove (proj->priv->notify_idle_id);
+      proj->priv->notify_idle_id = 0;
+    }
+
+  g_clear_pointer (&proj->priv->rendered_region, cairo_region_destroy);
+
+  g_mutex_unlock (&proj->priv->notify_mutex);
+
   if (proj->priv->buffer)
     {
       gimp_tile_handler_validate_unassign (proj->priv->validate_handler,
@@ -684,7 +744,10 @@ gimp_projection_flush_whenever (GimpProjection *proj,
           gimp_projection_chunk_render_start (proj);
         }
     }
-  else if (! now && ! proj->priv->iter && proj->priv->invalidate_preview)
+  else if (! now                       &&
+           ! proj->priv->render_async &&
+           ! proj->priv->iter         &&
+           proj->priv->invalidate_preview)
     {
       /* invalidate the preview here since it is constructed from
        * the projection
@@ -698,6 +761,11 @@ gimp_projection_flush_whenever (GimpProjection *proj,
 static void
 gimp_projection_update_priority_rect (GimpProjection *proj)
 {
+  gboolean rendering = (proj->priv->render_async != NULL);
+
+  /*  the iterator can't be changed while it is being rendered  */
+  gimp_projection_render_async_stop (proj);
+
   if (proj->priv->iter)
     {
       GeglRectangle rect;
@@ -719,15 +787,22 @@ gimp_projection_update_priority_rect (GimpProjection *proj)
       gegl_rectangle_intersect (&rect, &rect, &bounding_box);
 
       gimp_chunk_iterator_set_priority_rect (proj->priv->iter, &rect);
+
+      if (rendering)
+        gimp_projection_render_async_start (proj);
     }
 }
 
 static void
 gimp_projection_chunk_render_start (GimpProjection *proj)
 {
-  cairo_region_t *region             = proj->priv->update_region;
+  cairo_region_t *region;
   gboolean        invalidate_preview = FALSE;
 
+  gimp_projection_render_async_stop (proj);
+
+  region = proj->priv->update_region;
+
   if (proj->priv->iter)
     {
       region = gimp_chunk_iterator_stop (proj->priv->iter, FALSE);
@@ -753,7 +828,15 @@ gimp_projection_chunk_render_start (GimpProjection *proj)
 
       gimp_projection_update_priority_rect (proj);
 
-      if (! proj->priv->idle_id)
+      if (gimp_projection_use_render_async (proj))
+        {
+          gimp_chunk_iterator_set_interval (
+            proj->priv->iter,
+            GIMP_PROJECTION_RENDER_ASYNC_INTERVAL);
+
+          gimp_projection_render_async_start (proj);
+        }
+      else if (! proj->priv->idle_id)
         {
           proj->priv->idle_id = g_idle_add_full (
             GIMP_PRIORITY_PROJECTION_IDLE + proj->priv->priority,
@@ -794,6 +877,8 @@ gimp_projection_chunk_render_stop (GimpProjection *proj,
       proj->priv->idle_id = 0;
     }
 
+  gimp_projection_render_async_stop (proj);
+
   if (proj->priv->iter)
     {
       if (merge)
@@ -884,30 +969,13 @@ gimp_projection_paint_area (GimpProjection *proj,
                             gint            w,
                             gint            h)
 {
-  gint          off_x, off_y;
-  GeglRectangle bounding_box;
   GeglRectangle rect;
 
-  gimp_projectable_get_offset (proj->priv->projectable, &off_x, &off_y);
-  bounding_box = gimp_projectable_get_bounding_box (proj->priv->projectable);
-
-  if (gegl_rectangle_intersect (&rect,
-                                GEGL_RECTANGLE (x, y, w, h), &bounding_box))
+  if (gimp_projection_validate_area (proj, now, x, y, w, h, &rect))
     {
-      if (now)
-        {
-          gimp_tile_handler_validate_validate (
-            proj->priv->validate_handler,
-            proj->priv->buffer,
-            &rect,
-            FALSE, FALSE);
-        }
-      else
-        {
-          gimp_tile_handler_validate_invalidate (
-            proj->priv->validate_handler,
-            &rect);
-        }
+      gint off_x, off_y;
+
+      gimp_projectable_get_offset (proj->priv->projectable, &off_x, &off_y);
 
       /*  add the projectable's offsets because the list of update areas
        *  is in tile-pyramid coordinates, but our external API is always
@@ -922,6 +990,267 @@ gimp_projection_paint_area (GimpProjection *proj,
     }
 }
 
+static gboolean
+gimp_projection_validate_area (GimpProjection *proj,
+                               gboolean        now,
+                               gint            x,
+                               gint            y,
+                               gint            w,
+                               gint            h,
+                               GeglRectangle  *rect)
+{
+  GeglRectangle bounding_box;
+
+  bounding_box = gimp_projectable_get_bounding_box (proj->priv->projectable);
+
+  if (! gegl_rectangle_intersect (rect,
+                                  GEGL_RECTANGLE (x, y, w, h), &bounding_box))
+    {
+      return FALSE;
+    }
+
+  if (now)
+    {
+      gimp_tile_handler_validate_validate (
+        proj->priv->validate_handler,
+        proj->priv->buffer,
+        rect,
+        FALSE, FALSE);
+    }
+  else
+    {
+      gimp_tile_handler_validate_invalidate (
+        proj->priv->validate_handler,
+        rect);
+    }
+
+  return TRUE;
+}
+
+
+/*  asynchronous rendering functions  */
+
+static gboolean
+gimp_projection_use_render_async (GimpProjection *proj)
+{
+  GimpImage *image = gimp_projectable_get_image (proj->priv->projectable);
+
+  return image && image->gimp->config->projection_render_async;
+}
+
+static void
+gimp_projection_render_async_start (GimpProjection *proj)
+{
+  proj->priv->render_bounding_box =
+    gimp_projectable_get_bounding_box (proj->priv->projectable);
+
+  proj->priv->render_async = gimp_parallel_run_async_full (
+    proj->priv->priority,
+    (GimpRunAsyncFunc) gimp_projection_render_async_func,
+    proj, NULL);
+
+  gimp_async_add_callback (
+    proj->priv->render_async,
+    (GimpAsyncCallback) gimp_projection_render_async_callback,
+    proj);
+}
+
+/*  must be called before the iterator, the buffer, or the tile handler
+ *  are accessed on the main thread
+ */
+static void
+gimp_projection_render_async_stop (GimpProjection *proj)
+{
+  if (proj->priv->render_async)
+    {
+      GimpAsync *async = proj->priv->render_async;
+
+      gimp_async_remove_callback (
+        async,
+        (GimpAsyncCallback) gimp_projection_render_async_callback,
+        proj);
+
+      gimp_async_cancel_and_wait (async);
+
+      g_clear_object (&proj->priv->render_async);
+
+      /*  if the iterator was drained meanwhile, let the notify callback
+       *  finish up, instead of the removed async callback
+       */
+      if (! proj->priv->iter)
+        gimp_projection_render_async_queue_notify (proj);
+    }
+}
+
+/*  runs on a worker thread.  the main thread doesn't access the
+ *  iterator, the buffer, or the tile handler until it has waited for
+ *  the async, and the tile handler serializes rendering with the
+ *  tiles the main thread validates on demand.
+ */
+static void
+gimp_projection_render_async_func (GimpAsync      *async,
+                                   GimpProjection *proj)
+{
+  GimpProjectionPrivate *priv = proj->priv;
+
+  while (! gimp_async_is_canceled (async))
+    {
+      GeglRectangle rect;
+
+      if (! gimp_chunk_iterator_next (priv->iter))
+        {
+          /*  the iterator frees itself once it's drained  */
+          priv->iter = NULL;
+
+          gimp_async_finish (async, NULL);
+
+          return;
+        }
+
+      gimp_tile_handler_validate_begin_validate (priv->validate_handler);
+
+      while (! gimp_async_is_canceled (async) &&
+             gimp_chunk_iterator_get_rect (priv->iter, &rect))
+        {
+          if (! gegl_rectangle_intersect (&rect,
+                                          &rect, &priv->render_bounding_box))
+            {
+              continue;
+            }
+
+          gimp_tile_handler_validate_validate (priv->validate_handler,
+                                               priv->buffer,
+                                               &rect,
+                                               FALSE, FALSE);
+
+          g_mutex_lock (&priv->notify_mutex);
+
+          if (priv->rendered_region)
+            {
+              cairo_region_union_rectangle (
+                priv->rendered_region,
+                (const cairo_rectangle_int_t *) &rect);
+            }
+          else
+            {
+              priv->rendered_region = cairo_region_create_rectangle (
+                (const cairo_rectangle_int_t *) &rect);
+            }
+
+          g_mutex_unlock (&priv->notify_mutex);
+
+          gimp_projection_render_async_queue_notify (proj);
+        }
+
+      gimp_tile_handler_validate_end_validate (priv->validate_handler);
+    }
+
+  gimp_async_abort (async);
+}
+
+static void
+gimp_projection_render_async_callback (GimpAsync      *async,
+                                       GimpProjection *proj)
+{
+  g_clear_object (&proj->priv->render_async);
+
+  gimp_projection_render_async_notify (proj);
+}
+
+/*  called on either thread  */
+static void
+gimp_projection_render_async_queue_notify (GimpProjection *proj)
+{
+  g_mutex_lock (&proj->priv->notify_mutex);
+
+  if (! proj->priv->notify_idle_id)
+    {
+      proj->priv->notify_idle_id = g_idle_add_full (
+        GIMP_PRIORITY_PROJECTION_IDLE + proj->priv->priority,
+        (GSourceFunc) gimp_projection_render_async_notify_callback,
+        proj, NULL);
+    }
+
+  g_mutex_unlock (&proj->priv->notify_mutex);
+}
+
+static gboolean
+gimp_projection_render_async_notify_callback (GimpProjection *proj)
+{
+  g_mutex_lock (&proj->priv->notify_mutex);
+
+  proj->priv->notify_idle_id = 0;
+
+  g_mutex_unlock (&proj->priv->notify_mutex);
+
+  gimp_projection_render_async_notify (proj);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_projection_render_async_notify (GimpProjection *proj)
+{
+  cairo_region_t *region;
+
+  g_mutex_lock (&proj->priv->notify_mutex);
+
+  region = proj->priv->rendered_region;
+
+  proj->priv->rendered_region = NULL;
+
+  if (proj->priv->notify_idle_id)
+    {
+      g_source_remove (proj->priv->notify_idle_id);
+      proj->priv->notify_idle_id = 0;
+    }
+
+  g_mutex_unlock (&proj->priv->notify_mutex);
+
+  if (region)
+    {
+      gint off_x, off_y;
+      gint n_rects;
+      gint i;
+
+      gimp_projectable_get_offset (proj->priv->projectable, &off_x, &off_y);
+
+      n_rects = cairo_region_num_rectangles (region);
+
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (region, i, &rect);
+
+          /*  add the projectable's offsets because the list of update
+           *  areas is in tile-pyramid coordinates, but our external API
+           *  is always in terms of image coordinates.
+           */
+          g_signal_emit (proj, projection_signals[UPDATE], 0,
+                         TRUE,
+                         rect.x + off_x,
+                         rect.y + off_y,
+                         rect.width,
+                         rect.height);
+        }
+
+      cairo_region_destroy (region);
+    }
+
+  if (! proj->priv->render_async &&
+      ! proj->priv->iter         &&
+      proj->priv->invalidate_preview)
+    {
+      /* invalidate the preview here since it is constructed from
+       * the projection
+       */
+      proj->priv->invalidate_preview = FALSE;
+
+      gimp_projectable_invalidate_preview (proj->priv->projectable);
+    }
+}
+
 
 /*  image callbacks  */
 
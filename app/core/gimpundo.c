@@ -493,6 +493,8 @@ gimp_undo_create_preview_private (GimpUndo    *undo,
   undo->preview = gimp_viewable_get_new_preview (preview_viewable, context,
                                                  width, height);
 
+  gimp_image_undo_size_changed (image, undo);
+
   gimp_viewable_invalidate_preview (GIMP_VIEWABLE (undo));
 }
 
@@ -509,6 +511,8 @@ gimp_undo_refresh_preview (GimpUndo    *undo,
   if (undo->preview)
     {
       g_clear_pointer (&undo->preview, gimp_temp_buf_unref);
+      gimp_image_undo_size_changed (undo->image, undo);
+
       gimp_undo_create_preview (undo, context, FALSE);
     }
 }
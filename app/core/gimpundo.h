@@ -61,6 +61,8 @@ struct _GimpUndo
 
   GimpTempBuf      *preview;
   guint             preview_idle_id;
+
+  gint64            memsize;        /* size accounted by the parent stack */
 };
 
 struct _GimpUndoClass
@@ -39,6 +39,14 @@ static void    gimp_undo_stack_pop         (GimpUndo            *undo,
 static void    gimp_undo_stack_free        (GimpUndo            *undo,
                                             GimpUndoMode         undo_mode);
 
+static void    gimp_undo_stack_account     (GimpUndoStack       *stack,
+                                            GimpUndo            *undo);
+static void    gimp_undo_stack_unaccount   (GimpUndoStack       *stack,
+                                            GimpUndo            *undo);
+static gboolean gimp_undo_stack_update     (GimpUndoStack       *stack,
+                                            GimpUndo            *undo,
+                                            gint64              *delta);
+
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
 
@@ -120,11 +128,15 @@ gimp_undo_stack_free (GimpUndo     *undo,
     {
       GimpUndo *child = list->data;
 
+      child->memsize = 0;
+
       gimp_undo_free (child, undo_mode);
       g_object_unref (child);
     }
 
   gimp_container_clear (stack->undos);
+
+  stack->memsize = 0;
 }
 
 GimpUndoStack *
@@ -145,6 +157,8 @@ gimp_undo_stack_push_undo (GimpUndoStack *stack,
   g_return_if_fail (GIMP_IS_UNDO (undo));
 
   gimp_container_add (stack->undos, GIMP_OBJECT (undo));
+
+  gimp_undo_stack_account (stack, undo);
 }
 
 GimpUndo *
@@ -162,6 +176,8 @@ gimp_undo_stack_pop_undo (GimpUndoStack       *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+      gimp_undo_stack_unaccount (stack, undo);
+
       gimp_undo_pop (undo, undo_mode, accum);
 
       return undo;
@@ -183,6 +199,8 @@ gimp_undo_stack_free_bottom (GimpUndoStack *stack,
   if (undo)
     {
       gimp_container_remove (stack->undos, GIMP_OBJECT (undo));
+      gimp_undo_stack_unaccount (stack, undo);
+
       gimp_undo_free (undo, undo_mode);
 
       return undo;
@@ -191,6 +209,30 @@ gimp_undo_stack_free_bottom (GimpUndoStack *stack,
   return NULL;
 }
 
+/**
+ * gimp_undo_stack_update_undo:
+ * @stack: a #GimpUndoStack
+ * @undo:  a #GimpUndo
+ *
+ * Re-measures @undo, which is on @stack or on one of the undo groups
+ * on @stack, after its memory use changed, e.g. because more undos
+ * were pushed to it when it is an undo group, or because its data got
+ * compressed or its preview created.
+ *
+ * Returns: %TRUE if @undo was found on @stack.
+ **/
+gboolean
+gimp_undo_stack_update_undo (GimpUndoStack *stack,
+                             GimpUndo      *undo)
+{
+  gint64 delta;
+
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), FALSE);
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+
+  return gimp_undo_stack_update (stack, undo, &delta);
+}
+
 GimpUndo *
 gimp_undo_stack_peek (GimpUndoStack *stack)
 {
@@ -206,3 +248,107 @@ gimp_undo_stack_get_depth (GimpUndoStack *stack)
 
   return gimp_container_get_n_children (stack->undos);
 }
+
+/**
+ * gimp_undo_stack_get_size:
+ * @stack: a #GimpUndoStack
+ *
+ * Returns the memory used by the undos on @stack, including their
+ * previews, as measured when they were pushed or last updated. Unlike
+ * gimp_object_get_memsize(), this doesn't walk the stack, so it can be
+ * used in a loop while freeing undos.
+ *
+ * Returns: the size of @stack's undos in bytes.
+ **/
+gint64
+gimp_undo_stack_get_size (GimpUndoStack *stack)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO_STACK (stack), 0);
+
+  return stack->memsize;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_undo_stack_account (GimpUndoStack *stack,
+                         GimpUndo      *undo)
+{
+  gint64 gui_size;
+
+  /*  an undo group's undos may have changed since they were accounted,
+   *  e.g. while the group was popped, so account them all over again
+   */
+  if (GIMP_IS_UNDO_STACK (undo))
+    {
+      GimpUndoStack *group = GIMP_UNDO_STACK (undo);
+      GList         *list;
+
+      group->memsize = 0;
+
+      for (list = GIMP_LIST (group->undos)->queue->head;
+           list;
+           list = g_list_next (list))
+        {
+          gimp_undo_stack_account (group, list->data);
+        }
+    }
+
+  undo->memsize = gimp_object_get_memsize (GIMP_OBJECT (undo), &gui_size);
+  undo->memsize += gui_size;
+
+  stack->memsize += undo->memsize;
+}
+
+static void
+gimp_undo_stack_unaccount (GimpUndoStack *stack,
+                           GimpUndo      *undo)
+{
+  g_warn_if_fail (stack->memsize >= undo->memsize);
+
+  stack->memsize -= undo->memsize;
+  undo->memsize   = 0;
+}
+
+/*  re-measures @undo if it is on @stack, or the undo group on @stack
+ *  which contains it, by the amount @undo changed, which is returned
+ *  in @delta, so that the group's other undos don't have to be
+ *  measured again
+ */
+static gboolean
+gimp_undo_stack_update (GimpUndoStack *stack,
+                        GimpUndo      *undo,
+                        gint64        *delta)
+{
+  GList *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *child = list->data;
+
+      if (child == undo)
+        {
+          gint64 old_memsize = child->memsize;
+
+          gimp_undo_stack_unaccount (stack, child);
+          gimp_undo_stack_account (stack, child);
+
+          *delta = child->memsize - old_memsize;
+
+          return TRUE;
+        }
+      else if (GIMP_IS_UNDO_STACK (child) &&
+               gimp_undo_stack_update (GIMP_UNDO_STACK (child), undo, delta))
+        {
+          child->memsize += *delta;
+          stack->memsize += *delta;
+
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
@@ -37,6 +37,7 @@ struct _GimpUndoStack
   GimpUndo       parent_instance;
 
   GimpContainer *undos;
+  gint64         memsize;  /* sum of the undos' accounted sizes */
 };
 
 struct _GimpUndoStackClass
@@ -57,8 +58,12 @@ GimpUndo      * gimp_undo_stack_pop_undo    (GimpUndoStack       *stack,
 
 GimpUndo      * gimp_undo_stack_free_bottom (GimpUndoStack       *stack,
                                              GimpUndoMode         undo_mode);
+gboolean        gimp_undo_stack_update_undo (GimpUndoStack       *stack,
+                                             GimpUndo            *undo);
+
 GimpUndo      * gimp_undo_stack_peek        (GimpUndoStack       *stack);
 gint            gimp_undo_stack_get_depth   (GimpUndoStack       *stack);
+gint64          gimp_undo_stack_get_size    (GimpUndoStack       *stack);
 
 
 #endif /* __GIMP_UNDO_STACK_H__ */
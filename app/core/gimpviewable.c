@@ -36,6 +36,7 @@
 #include "gimp-memsize.h"
 #include "gimpcontainer.h"
 #include "gimpcontext.h"
+#include "gimpmarshal.h"
 #include "gimptempbuf.h"
 #include "gimpviewable.h"
 
@@ -53,6 +54,7 @@ static GParamSpec *obj_props[N_PROPS] = { NULL, };
 enum
 {
   INVALIDATE_PREVIEW,
+  INVALIDATE_PREVIEW_AREA,
   SIZE_CHANGED,
   EXPANDED_CHANGED,
   ANCESTRY_CHANGED,
@@ -68,6 +70,7 @@ struct _GimpViewablePrivate
   GdkPixbuf    *icon_pixbuf;
   gint          freeze_count;
   gboolean      invalidate_pending;
+  GeglRectangle invalidate_area_pending;
   gboolean      size_changed_prending;
   GimpViewable *parent;
   gint          depth;
@@ -155,6 +158,19 @@ gimp_viewable_class_init (GimpViewableClass *klass)
                   NULL, NULL, NULL,
                   G_TYPE_NONE, 0);
 
+  viewable_signals[INVALIDATE_PREVIEW_AREA] =
+    g_signal_new ("invalidate-preview-area",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (GimpViewableClass, invalidate_preview_area),
+                  NULL, NULL,
+                  gimp_marshal_VOID__INT_INT_INT_INT,
+                  G_TYPE_NONE, 4,
+                  G_TYPE_INT,
+                  G_TYPE_INT,
+                  G_TYPE_INT,
+                  G_TYPE_INT);
+
   viewable_signals[SIZE_CHANGED] =
     g_signal_new ("size-changed",
                   G_TYPE_FROM_CLASS (klass),
@@ -190,6 +206,7 @@ gimp_viewable_class_init (GimpViewableClass *klass)
   klass->name_editable           = FALSE;
 
   klass->invalidate_preview      = gimp_viewable_real_invalidate_preview;
+  klass->invalidate_preview_area = NULL;
   klass->size_changed            = NULL;
   klass->expanded_changed        = NULL;
   klass->ancestry_changed        = gimp_viewable_real_ancestry_changed;
@@ -574,6 +591,55 @@ gimp_viewable_invalidate_preview (GimpViewable *viewable)
     private->invalidate_pending = TRUE;
 }
 
+/**
+ * gimp_viewable_invalidate_preview_area:
+ * @viewable: a viewable object
+ * @x:        x coordinate of the changed area
+ * @y:        y coordinate of the changed area
+ * @width:    width of the changed area
+ * @height:   height of the changed area
+ *
+ * Like gimp_viewable_invalidate_preview(), but for a change that only
+ * affected the given area of the viewable.
+ *
+ * "invalidate-preview-area" is emitted right before
+ * "invalidate-preview", so that views which can update part of their
+ * preview can ignore the following "invalidate-preview".  While the
+ * preview is frozen, the changed areas are accumulated.  An empty area
+ * invalidates the whole preview.
+ **/
+void
+gimp_viewable_invalidate_preview_area (GimpViewable *viewable,
+                                       gint          x,
+                                       gint          y,
+                                       gint          width,
+                                       gint          height)
+{
+  GimpViewablePrivate *private = GET_PRIVATE (viewable);
+
+  g_return_if_fail (GIMP_IS_VIEWABLE (viewable));
+
+  if (width <= 0 || height <= 0)
+    {
+      gimp_viewable_invalidate_preview (viewable);
+
+      return;
+    }
+
+  if (private->freeze_count == 0)
+    {
+      g_signal_emit (viewable, viewable_signals[INVALIDATE_PREVIEW_AREA], 0,
+                     x, y, width, height);
+      g_signal_emit (viewable, viewable_signals[INVALIDATE_PREVIEW], 0);
+    }
+  else if (! private->invalidate_pending)
+    {
+      gegl_rectangle_bounding_box (&private->invalidate_area_pending,
+                                   &private->invalidate_area_pending,
+                                   GEGL_RECTANGLE (x, y, width, height));
+    }
+}
+
 /**
  * gimp_viewable_size_changed:
  * @viewable: a viewable object
@@ -1296,6 +1362,16 @@ gimp_viewable_preview_thaw (GimpViewable *viewable)
 
           gimp_viewable_invalidate_preview (viewable);
         }
+      else if (! gegl_rectangle_is_empty (&private->invalidate_area_pending))
+        {
+          GeglRectangle area = private->invalidate_area_pending;
+
+          gimp_viewable_invalidate_preview_area (viewable,
+                                                 area.x,     area.y,
+                                                 area.width, area.height);
+        }
+
+      private->invalidate_area_pending = *GEGL_RECTANGLE (0, 0, 0, 0);
 
       g_object_notify_by_pspec (G_OBJECT (viewable), obj_props[PROP_FROZEN]);
 
@@ -56,6 +56,12 @@ struct _GimpViewableClass
 
   /*  signals  */
   void            (* invalidate_preview) (GimpViewable  *viewable);
+  void            (* invalidate_preview_area)
+                                         (GimpViewable  *viewable,
+                                          gint           x,
+                                          gint           y,
+                                          gint           width,
+                                          gint           height);
   void            (* size_changed)       (GimpViewable  *viewable);
   void            (* expanded_changed)   (GimpViewable  *viewable);
   void            (* ancestry_changed)   (GimpViewable  *viewable);
@@ -111,6 +117,12 @@ struct _GimpViewableClass
 GType           gimp_viewable_get_type           (void) G_GNUC_CONST;
 
 void            gimp_viewable_invalidate_preview (GimpViewable  *viewable);
+void            gimp_viewable_invalidate_preview_area
+                                                 (GimpViewable  *viewable,
+                                                  gint           x,
+                                                  gint           y,
+                                                  gint           width,
+                                                  gint           height);
 void            gimp_viewable_size_changed       (GimpViewable  *viewable);
 void            gimp_viewable_expanded_changed   (GimpViewable  *viewable);
 
@@ -183,6 +183,7 @@ file_save_dialog_response (GtkWidget *dialog,
         GimpProgress *progress           = GIMP_PROGRESS (dialog);
         GimpDisplay  *display_to_close   = NULL;
         gboolean      xcf_compression    = FALSE;
+        gboolean      xcf_mipmaps        = FALSE;
         gboolean      is_save_dialog     = GIMP_IS_SAVE_DIALOG (dialog);
         gboolean      close_after_saving = FALSE;
         gboolean      save_a_copy        = FALSE;
@@ -199,6 +200,7 @@ file_save_dialog_response (GtkWidget *dialog,
         if (GIMP_IS_SAVE_DIALOG (dialog))
           {
             xcf_compression = GIMP_SAVE_DIALOG (dialog)->compression;
+            xcf_mipmaps     = GIMP_SAVE_DIALOG (dialog)->mipmaps;
           }
 
         /* Hide the file dialog while exporting, avoid dialogs piling
@@ -225,6 +227,7 @@ file_save_dialog_response (GtkWidget *dialog,
                                          FALSE,
                                          GIMP_IS_EXPORT_DIALOG (dialog),
                                          xcf_compression,
+                                         xcf_mipmaps,
                                          FALSE))
           {
             /* Save was successful, now store the URI in a couple of
@@ -804,6 +807,7 @@ file_save_dialog_save_image (GimpProgress        *progress,
                              gboolean             export_backward,
                              gboolean             export_forward,
                              gboolean             xcf_compression,
+                             gboolean             xcf_mipmaps,
                              gboolean             verbose_cancel)
 {
   GimpPDBStatusType  status;
@@ -819,6 +823,7 @@ file_save_dialog_save_image (GimpProgress        *progress,
     }
 
   gimp_image_set_xcf_compression (image, xcf_compression);
+  gimp_image_set_xcf_mipmaps (image, xcf_mipmaps);
 
   status = file_save (gimp, image, progress, file,
                       save_proc, run_mode,
@@ -1289,6 +1289,10 @@ prefs_dialog_new (Gimp       *gimp,
                          GTK_GRID (grid), 5, size_group);
 #endif /* ENABLE_MP */
 
+  prefs_check_button_add (object, "undo-compression",
+                          _("Com_press undo steps in the background"),
+                          GTK_BOX (vbox2));
+
   /*  Internet access  */
 #ifdef CHECK_UPDATE
   if (gimp_version_check_update ())
@@ -1648,6 +1652,38 @@ prefs_dialog_new (Gimp       *gimp,
                             _("Default export file t_ype:"),
                             GTK_GRID (grid), 0, size_group);
 
+  /*  XCF Compression  */
+  vbox2 = prefs_frame_new (_("XCF Compression"), GTK_CONTAINER (vbox), FALSE);
+
+  button = prefs_check_button_add (object, "xcf-zstd-compression",
+                                   _("Use _zstd when saving with compression"),
+                                   GTK_BOX (vbox2));
+
+  grid = prefs_grid_new (GTK_CONTAINER (vbox2));
+  g_object_bind_property (button, "active",
+                          grid,   "sensitive",
+                          G_BINDING_SYNC_CREATE);
+
+  prefs_spin_button_add (object, "xcf-zstd-level", 1.0, 5.0, 0,
+                         _("zstd compression _level:"),
+                         GTK_GRID (grid), 0, size_group);
+
+  /*  XCF Loading  */
+  vbox2 = prefs_frame_new (_("XCF Loading"), GTK_CONTAINER (vbox), FALSE);
+
+  button = prefs_check_button_add (object, "xcf-progressive-load",
+                                   _("Load _full resolution in the background"),
+                                   GTK_BOX (vbox2));
+  button2 = prefs_check_button_add (object, "xcf-lazy-load",
+                                    _("Load layer pixels _only when needed"),
+                                    GTK_BOX (vbox2));
+
+  /*  lazily loaded files are never loaded in the background  */
+  g_object_bind_property (button2, "active",
+                          button,  "sensitive",
+                          G_BINDING_SYNC_CREATE |
+                          G_BINDING_INVERT_BOOLEAN);
+
   /*  Raw Image Importer  */
   vbox2 = prefs_frame_new (_("Raw Image Importer"),
                            GTK_CONTAINER (vbox), TRUE);
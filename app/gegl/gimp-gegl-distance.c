@@ -0,0 +1,450 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-distance.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "gimp-gegl-types.h"
+
+#include "gimp-gegl-distance.h"
+
+
+/*  The grow, shrink and border operations all use the same elliptical
+ *  neighborhood: a pixel at offset (dx, dy) is within radii (rx, ry) iff
+ *
+ *    tx * tx / (rx * rx) + ty * ty / (ry * ry) < 1
+ *
+ *  where tx = |dx| - 0.5, or 0 if dx == 0 (and likewise for ty).
+ *  Multiplying by 4 * rx^2 * ry^2, this is
+ *
+ *    ry^2 * h (dx) + rx^2 * h (dy) < 4 * rx^2 * ry^2
+ *
+ *  with h (d) = (2 |d| - 1)^2, and h (0) = 0, whose terms are integers,
+ *  and which is never an equality.
+ *
+ *  gimp_gegl_distance_ellipse() finds, for each pixel, the site with the
+ *  smallest left-hand side, in two separable passes taking O(1) time per
+ *  pixel, regardless of the radii:
+ *
+ *  - the vertical pass finds the distance |dy| to the nearest site in
+ *    each column.  since h() increases with |d|, the nearest site of a
+ *    column is also the best one.
+ *
+ *  - the horizontal pass minimizes ry^2 * h (dx) + F (x + dx) over each
+ *    row, where F is rx^2 * h (|dy|) of each column.  for dx > 0,
+ *    h (dx) = (2 (x + dx) - (2 x + 1))^2, and for dx < 0,
+ *    h (dx) = (2 (x + dx) - (2 x - 1))^2, so, in doubled coordinates,
+ *    the minimum is the lower envelope of the parabolas
+ *    ry^2 * (t - 2 q)^2 + F (q), sampled at t = 2 x - 1 and
+ *    t = 2 x + 1, or the pixel's own column (whose h (0) is 0).
+ *    using each sample only for the sites on its side is unnecessary,
+ *    since it overestimates the sites on the other side.  the envelope
+ *    is found exactly, using integers, as in Meijster et al. [1].
+ *
+ *  Rows are independent in the horizontal pass, and columns are
+ *  independent in the vertical pass, so both passes are distributed
+ *  between threads.
+ *
+ *  [1] A. Meijster, J. B. T. M. Roerdink, W. H. Hesselink, "A General
+ *      Algorithm for Computing Distance Transforms in Linear Time",
+ *      Mathematical Morphology and its Applications to Image and Signal
+ *      Processing, 2000.
+ */
+
+
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+
+
+typedef struct
+{
+  GeglBuffer           *buffer;
+  const GeglRectangle  *rect;
+  const Babl           *format;
+  gboolean              invert;
+  guint8               *sites;
+  gint                  is_binary;
+} SitesData;
+
+typedef struct
+{
+  const guint8         *sites;
+  gint                  width;
+  gint                  height;
+  gint                  sites_height;
+  gboolean              outside_is_site;
+  gint                  radius_x;
+  gint                  radius_y;
+  guint16              *dy;
+  GimpGeglDistanceFunc  func;
+  gpointer              user_data;
+} DistanceData;
+
+
+/*  private functions  */
+
+static inline gint64
+gimp_gegl_distance_h (gint d)
+{
+  return d ? (gint64) (2 * d - 1) * (2 * d - 1) : 0;
+}
+
+static inline gint64
+gimp_gegl_distance_floor_div (gint64 a,
+                              gint64 b)
+{
+  /* b is always positive */
+  return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
+
+static void
+gimp_gegl_distance_get_sites_range (gsize      offset,
+                                    gsize      size,
+                                    SitesData *data)
+{
+  const GeglRectangle *rect  = data->rect;
+  gfloat              *row   = g_new (gfloat, rect->width);
+  guint8               value = data->invert ? 0 : 1;
+  gint                 y;
+
+  for (y = offset; y < (gint) (offset + size); y++)
+    {
+      guint8 *sites = data->sites + (gsize) y * rect->width;
+      gint    x;
+
+      if (! g_atomic_int_get (&data->is_binary))
+        break;
+
+      gegl_buffer_get (data->buffer,
+                       GEGL_RECTANGLE (rect->x, rect->y + y, rect->width, 1),
+                       1.0, data->format, row,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (x = 0; x < rect->width; x++)
+        {
+          if (row[x] == 1.0)
+            {
+              sites[x] = value;
+            }
+          else if (row[x] == 0.0)
+            {
+              sites[x] = ! value;
+            }
+          else
+            {
+              g_atomic_int_set (&data->is_binary, FALSE);
+              break;
+            }
+        }
+    }
+
+  g_free (row);
+}
+
+static void
+gimp_gegl_distance_vertical (gsize         offset,
+                             gsize         size,
+                             DistanceData *data)
+{
+  gint  width  = data->width;
+  gint  max_dy = data->radius_y + 1;
+  gint  x1     = offset;
+  gint  x2     = offset + size;
+  gint *site   = g_new (gint, size);
+  gint  x, y;
+
+  /*  the distance to the nearest site above, or on, each pixel  */
+  for (x = x1; x < x2; x++)
+    site[x - x1] = data->outside_is_site ? -1 : -(max_dy + 1);
+
+  for (y = 0; y < data->height; y++)
+    {
+      const guint8 *sites = data->sites + (gsize) y * width;
+      guint16      *dy    = data->dy    + (gsize) y * width;
+
+      for (x = x1; x < x2; x++)
+        {
+          if (sites[x])
+            site[x - x1] = y;
+
+          dy[x] = MIN (y - site[x - x1], max_dy);
+        }
+    }
+
+  /*  the distance to the nearest site below, including the extra rows  */
+  for (x = x1; x < x2; x++)
+    {
+      site[x - x1] = data->outside_is_site ? data->sites_height :
+                                             data->sites_height + max_dy;
+    }
+
+  for (y = MIN (data->sites_height, data->height + max_dy) - 1;
+       y >= 0;
+       y--)
+    {
+      const guint8 *sites = data->sites + (gsize) y * width;
+
+      for (x = x1; x < x2; x++)
+        {
+          if (sites[x])
+            site[x - x1] = y;
+        }
+
+      if (y < data->height)
+        {
+          guint16 *dy = data->dy + (gsize) y * width;
+
+          for (x = x1; x < x2; x++)
+            dy[x] = MIN (dy[x], site[x - x1] - y);
+        }
+    }
+
+  g_free (site);
+}
+
+static void
+gimp_gegl_distance_horizontal (gsize         offset,
+                               gsize         size,
+                               DistanceData *data)
+{
+  gint     width     = data->width;
+  gint64   rx2       = (gint64) data->radius_x * data->radius_x;
+  gint64   ry2       = (gint64) data->radius_y * data->radius_y;
+  gint64   threshold = 4 * rx2 * ry2;
+  gint64   t_max     = 2 * width - 1;
+  gint64  *pos;      /* the envelope's sites, in doubled coordinates */
+  gint64  *f;        /* the value of F at each site of the envelope   */
+  gint64  *start;    /* where each site of the envelope becomes lowest */
+  gint    *site_dy;  /* |dy| of each site of the envelope              */
+  gdouble *dist;
+  gint     y;
+
+  pos     = g_new (gint64,  width + 2);
+  f       = g_new (gint64,  width + 2);
+  start   = g_new (gint64,  width + 2);
+  site_dy = g_new (gint,    width + 2);
+  dist    = g_new (gdouble, width);
+
+  for (y = offset; y < (gint) (offset + size); y++)
+    {
+      const guint16 *dy = data->dy + (gsize) y * width;
+      gint           n  = -1;
+      gint           first;
+      gint           last;
+      gint           q;
+      gint           i;
+      gint           x;
+
+      if (data->outside_is_site)
+        {
+          first = -1;
+          last  = width;
+        }
+      else
+        {
+          first = 0;
+          last  = width - 1;
+        }
+
+      /*  find the lower envelope  */
+      for (q = first; q <= last; q++)
+        {
+          gint   q_dy = (q < 0 || q >= width) ? 0 : dy[q];
+          gint64 u;
+          gint64 u_f;
+
+          if (q_dy > data->radius_y)
+            continue;
+
+          u   = 2 * q;
+          u_f = rx2 * gimp_gegl_distance_h (q_dy);
+
+          while (n >= 0 &&
+                 ry2 * (start[n] - pos[n]) * (start[n] - pos[n]) + f[n] >
+                 ry2 * (start[n] - u)      * (start[n] - u)      + u_f)
+            {
+              n--;
+            }
+
+          if (n < 0)
+            {
+              n        = 0;
+              start[n] = -1;
+            }
+          else
+            {
+              gint64 w;
+
+              w = 1 + gimp_gegl_distance_floor_div (
+                        ry2 * (u * u - pos[n] * pos[n]) + u_f - f[n],
+                        2 * ry2 * (u - pos[n]));
+
+              if (w > t_max)
+                continue;
+
+              n++;
+              start[n] = w;
+            }
+
+          pos[n]     = u;
+          f[n]       = u_f;
+          site_dy[n] = q_dy;
+        }
+
+      /*  sample it on both sides of each pixel  */
+      for (x = 0, i = 0; x < width; x++)
+        {
+          gint64 best_cost = G_MAXINT64;
+          gint   best_dx   = 0;
+          gint   best_dy   = 0;
+          gint64 t;
+
+          if (dy[x] <= data->radius_y)
+            {
+              best_cost = rx2 * gimp_gegl_distance_h (dy[x]);
+              best_dy   = dy[x];
+            }
+
+          for (t = 2 * x - 1; n >= 0 && t <= 2 * x + 1; t += 2)
+            {
+              gint64 cost;
+
+              while (i < n && start[i + 1] <= t)
+                i++;
+
+              cost = ry2 * (t - pos[i]) * (t - pos[i]) + f[i];
+
+              if (cost < best_cost)
+                {
+                  best_cost = cost;
+                  best_dx   = pos[i] / 2 - x;
+                  best_dy   = site_dy[i];
+                }
+            }
+
+          if (best_cost < threshold)
+            {
+              gdouble tx = best_dx ? ABS (best_dx) - 0.5 : 0.0;
+              gdouble ty = best_dy ? best_dy       - 0.5 : 0.0;
+
+              dist[x] = ((ty * ty) / (data->radius_y * data->radius_y) +
+                         (tx * tx) / (data->radius_x * data->radius_x));
+            }
+          else
+            {
+              dist[x] = 1.0;
+            }
+        }
+
+      data->func (y, dist, data->user_data);
+    }
+
+  g_free (pos);
+  g_free (f);
+  g_free (start);
+  g_free (site_dy);
+  g_free (dist);
+}
+
+
+/*  public functions  */
+
+/*  returns a map of @rect, which is TRUE for the pixels of @buffer which
+ *  are 1.0, or 0.0 if @invert is TRUE, or NULL if @buffer has values
+ *  other than 0.0 and 1.0.
+ */
+guint8 *
+gimp_gegl_distance_get_sites (GeglBuffer          *buffer,
+                              const GeglRectangle *rect,
+                              const Babl          *format,
+                              gboolean             invert)
+{
+  SitesData data;
+
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+
+  data.buffer    = buffer;
+  data.rect      = rect;
+  data.format    = format;
+  data.invert    = invert;
+  data.sites     = g_new (guint8, (gsize) rect->width * rect->height);
+  data.is_binary = TRUE;
+
+  gegl_parallel_distribute_range (
+    rect->height, PIXELS_PER_THREAD / MAX (rect->width, 1),
+    (GeglParallelDistributeRangeFunc) gimp_gegl_distance_get_sites_range,
+    &data);
+
+  if (! data.is_binary)
+    g_clear_pointer (&data.sites, g_free);
+
+  return data.sites;
+}
+
+/*  calls @func for each row of a @width x @height area, with the
+ *  normalized distance, as defined above, from each pixel to the nearest
+ *  site within the ellipse of radii @radius_x and @radius_y, or 1.0 if
+ *  there is none.  @sites has @height + @n_extra_rows rows, and, if
+ *  @outside_is_site is TRUE, everything around it is a site too.  @func
+ *  is called from several threads at once.
+ */
+void
+gimp_gegl_distance_ellipse (const guint8         *sites,
+                            gint                  width,
+                            gint                  height,
+                            gint                  n_extra_rows,
+                            gboolean              outside_is_site,
+                            gint                  radius_x,
+                            gint                  radius_y,
+                            GimpGeglDistanceFunc  func,
+                            gpointer              user_data)
+{
+  DistanceData data;
+
+  g_return_if_fail (sites != NULL);
+  g_return_if_fail (width > 0 && height > 0);
+  g_return_if_fail (n_extra_rows >= 0);
+  g_return_if_fail (radius_x > 0 && radius_y > 0);
+  g_return_if_fail (func != NULL);
+
+  data.sites           = sites;
+  data.width           = width;
+  data.height          = height;
+  data.sites_height    = height + n_extra_rows;
+  data.outside_is_site = outside_is_site;
+  data.radius_x        = radius_x;
+  data.radius_y        = radius_y;
+  data.dy              = g_new (guint16, (gsize) width * height);
+  data.func            = func;
+  data.user_data       = user_data;
+
+  gegl_parallel_distribute_range (
+    width, PIXELS_PER_THREAD / height,
+    (GeglParallelDistributeRangeFunc) gimp_gegl_distance_vertical,
+    &data);
+
+  gegl_parallel_distribute_range (
+    height, PIXELS_PER_THREAD / width,
+    (GeglParallelDistributeRangeFunc) gimp_gegl_distance_horizontal,
+    &data);
+
+  g_free (data.dy);
+}
@@ -0,0 +1,45 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-gegl-distance.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_GEGL_DISTANCE_H__
+#define __GIMP_GEGL_DISTANCE_H__
+
+
+typedef void (* GimpGeglDistanceFunc) (gint           y,
+                                       const gdouble *dist,
+                                       gpointer       user_data);
+
+
+guint8 * gimp_gegl_distance_get_sites (GeglBuffer           *buffer,
+                                       const GeglRectangle  *rect,
+                                       const Babl           *format,
+                                       gboolean              invert);
+
+void     gimp_gegl_distance_ellipse   (const guint8         *sites,
+                                       gint                  width,
+                                       gint                  height,
+                                       gint                  n_extra_rows,
+                                       gboolean              outside_is_site,
+                                       gint                  radius_x,
+                                       gint                  radius_y,
+                                       GimpGeglDistanceFunc  func,
+                                       gpointer              user_data);
+
+
+#endif /* __GIMP_GEGL_DISTANCE_H__ */
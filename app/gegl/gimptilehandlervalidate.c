@@ -140,6 +140,9 @@ gimp_tile_handler_validate_init (GimpTileHandlerValidate *validate)
   source->command = gimp_tile_handler_validate_command;
 
   validate->dirty_region = cairo_region_create ();
+
+  g_mutex_init (&validate->mutex);
+  g_rec_mutex_init (&validate->render_mutex);
 }
 
 static void
@@ -150,6 +153,9 @@ gimp_tile_handler_validate_finalize (GObject *object)
   g_clear_object (&validate->graph);
   g_clear_pointer (&validate->dirty_region, cairo_region_destroy);
 
+  g_mutex_clear (&validate->mutex);
+  g_rec_mutex_clear (&validate->render_mutex);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -214,13 +220,13 @@ gimp_tile_handler_validate_get_property (GObject    *object,
 static void
 gimp_tile_handler_validate_real_begin_validate (GimpTileHandlerValidate *validate)
 {
-  validate->suspend_validate++;
+  g_atomic_int_inc (&validate->suspend_validate);
 }
 
 static void
 gimp_tile_handler_validate_real_end_validate (GimpTileHandlerValidate *validate)
 {
-  validate->suspend_validate--;
+  g_atomic_int_add (&validate->suspend_validate, -1);
 }
 
 static void
@@ -281,8 +287,10 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
   cairo_rectangle_int_t    tile_rect;
   cairo_region_overlap_t   overlap;
 
-  if (validate->suspend_validate ||
-      cairo_region_is_empty (validate->dirty_region))
+  /*  tiles requested while the graph is being rendered, possibly by
+   *  GEGL's worker threads, are never validated
+   */
+  if (g_atomic_int_get (&validate->suspend_validate))
     {
       return gegl_tile_handler_source_command (source,
                                                GEGL_TILE_GET, x, y, 0, NULL);
@@ -293,11 +301,15 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
   tile_rect.width  = validate->tile_width;
   tile_rect.height = validate->tile_height;
 
+  g_mutex_lock (&validate->mutex);
+
   overlap = cairo_region_contains_rectangle (validate->dirty_region,
                                              &tile_rect);
 
   if (overlap == CAIRO_REGION_OVERLAP_OUT)
     {
+      g_mutex_unlock (&validate->mutex);
+
       return gegl_tile_handler_source_command (source,
                                                GEGL_TILE_GET, x, y, 0, NULL);
     }
@@ -309,6 +321,8 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
 
       cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
 
+      g_mutex_unlock (&validate->mutex);
+
       tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
       tile_stride = tile_bpp * validate->tile_width;
 
@@ -346,6 +360,8 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
 
       cairo_region_subtract_rectangle (validate->dirty_region, &tile_rect);
 
+      g_mutex_unlock (&validate->mutex);
+
       tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
       tile_stride = tile_bpp * validate->tile_width;
 
@@ -489,9 +505,13 @@ gimp_tile_handler_validate_invalidate (GimpTileHandlerValidate *validate,
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
   g_return_if_fail (rect != NULL);
 
+  g_mutex_lock (&validate->mutex);
+
   cairo_region_union_rectangle (validate->dirty_region,
                                 (cairo_rectangle_int_t *) rect);
 
+  g_mutex_unlock (&validate->mutex);
+
   gegl_tile_handler_damage_rect (GEGL_TILE_HANDLER (validate), rect);
 
   g_signal_emit (validate, gimp_tile_handler_validate_signals[INVALIDATED],
@@ -505,8 +525,12 @@ gimp_tile_handler_validate_undo_invalidate (GimpTileHandlerValidate *validate,
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
   g_return_if_fail (rect != NULL);
 
+  g_mutex_lock (&validate->mutex);
+
   cairo_region_subtract_rectangle (validate->dirty_region,
                                    (cairo_rectangle_int_t *) rect);
+
+  g_mutex_unlock (&validate->mutex);
 }
 
 void
@@ -514,6 +538,11 @@ gimp_tile_handler_validate_begin_validate (GimpTileHandlerValidate *validate)
 {
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
 
+  /*  only one thread renders the graph at a time; the lock is kept
+   *  until the matching end_validate()
+   */
+  g_rec_mutex_lock (&validate->render_mutex);
+
   if (validate->validating++ == 0)
     GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate)->begin_validate (validate);
 }
@@ -526,6 +555,8 @@ gimp_tile_handler_validate_end_validate (GimpTileHandlerValidate *validate)
 
   if (--validate->validating == 0)
     GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate)->end_validate (validate);
+
+  g_rec_mutex_unlock (&validate->render_mutex);
 }
 
 void
@@ -547,6 +578,11 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
   if (! rect)
     rect = gegl_buffer_get_extent (buffer);
 
+  /*  the rect is marked as valid before it is rendered, so that it
+   *  stays dirty if it gets invalidated, by another thread, meanwhile
+   */
+  g_mutex_lock (&validate->mutex);
+
   if (intersect)
     {
       region = cairo_region_copy (validate->dirty_region);
@@ -560,6 +596,11 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
         (const cairo_rectangle_int_t *) rect);
     }
 
+  cairo_region_subtract_rectangle (validate->dirty_region,
+                                   (const cairo_rectangle_int_t *) rect);
+
+  g_mutex_unlock (&validate->mutex);
+
   if (region)
     {
       if (! cairo_region_is_empty (region))
@@ -601,10 +642,6 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
               }
 
           gimp_tile_handler_validate_end_validate (validate);
-
-          cairo_region_subtract_rectangle (
-            validate->dirty_region,
-            (const cairo_rectangle_int_t *) rect);
         }
 
       g_clear_pointer (&region, cairo_region_destroy);
@@ -616,10 +653,6 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
       klass->validate_buffer (validate, rect, buffer);
 
       gimp_tile_handler_validate_end_validate (validate);
-
-      cairo_region_subtract_rectangle (
-            validate->dirty_region,
-            (const cairo_rectangle_int_t *) rect);
     }
 }
 
@@ -636,19 +669,23 @@ gimp_tile_handler_validate_buffer_set_extent (GeglBuffer          *buffer,
 
   g_return_val_if_fail (validate != NULL, FALSE);
 
-  validate->suspend_validate++;
+  g_atomic_int_inc (&validate->suspend_validate);
 
   if (gimp_gegl_buffer_set_extent (buffer, extent))
     {
-      validate->suspend_validate--;
+      g_atomic_int_add (&validate->suspend_validate, -1);
+
+      g_mutex_lock (&validate->mutex);
 
       cairo_region_intersect_rectangle (validate->dirty_region,
                                         (const cairo_rectangle_int_t *) extent);
 
+      g_mutex_unlock (&validate->mutex);
+
       return TRUE;
     }
 
-  validate->suspend_validate--;
+  g_atomic_int_add (&validate->suspend_validate, -1);
 
   return FALSE;
 }
@@ -663,6 +700,7 @@ gimp_tile_handler_validate_buffer_copy (GeglBuffer          *src_buffer,
   GimpTileHandlerValidate *dst_validate;
   GeglRectangle            real_src_rect;
   GeglRectangle            real_dst_rect;
+  cairo_region_t          *region = NULL;
 
   g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
   g_return_if_fail (GEGL_IS_BUFFER (dst_buffer));
@@ -704,12 +742,12 @@ gimp_tile_handler_validate_buffer_copy (GeglBuffer          *src_buffer,
       gimp_tile_handler_validate_unassign (src_validate, src_buffer);
     }
 
-  dst_validate->suspend_validate++;
+  g_atomic_int_inc (&dst_validate->suspend_validate);
 
   gimp_gegl_buffer_copy (src_buffer, &real_src_rect, GEGL_ABYSS_NONE,
                          dst_buffer, &real_dst_rect);
 
-  dst_validate->suspend_validate--;
+  g_atomic_int_add (&dst_validate->suspend_validate, -1);
 
   if (src_validate)
     {
@@ -718,26 +756,18 @@ gimp_tile_handler_validate_buffer_copy (GeglBuffer          *src_buffer,
       g_object_unref (src_validate);
     }
 
-  cairo_region_subtract_rectangle (dst_validate->dirty_region,
-                                   (cairo_rectangle_int_t *) &real_dst_rect);
-
+  /*  copy the source's dirty region first, so that only one of the
+   *  handlers is locked at a time
+   */
   if (src_validate)
     {
-      if (real_src_rect.x == real_dst_rect.x &&
-          real_src_rect.y == real_dst_rect.y &&
-          gegl_rectangle_equal (&real_src_rect,
-                                gegl_buffer_get_extent (src_buffer)))
-        {
-          cairo_region_union (dst_validate->dirty_region,
-                              src_validate->dirty_region);
-        }
-      else if (cairo_region_contains_rectangle (
-                 src_validate->dirty_region,
-                 (cairo_rectangle_int_t *) &real_src_rect) !=
-               CAIRO_REGION_OVERLAP_OUT)
-        {
-          cairo_region_t *region;
+      g_mutex_lock (&src_validate->mutex);
 
+      if (cairo_region_contains_rectangle (
+            src_validate->dirty_region,
+            (cairo_rectangle_int_t *) &real_src_rect) !=
+          CAIRO_REGION_OVERLAP_OUT)
+        {
           region = cairo_region_copy (src_validate->dirty_region);
 
           if (! gegl_rectangle_equal (&real_src_rect,
@@ -750,19 +780,31 @@ gimp_tile_handler_validate_buffer_copy (GeglBuffer          *src_buffer,
           cairo_region_translate (region,
                                   real_dst_rect.x - real_src_rect.x,
                                   real_dst_rect.y - real_src_rect.y);
+        }
 
-          if (cairo_region_is_empty (dst_validate->dirty_region))
-            {
-              cairo_region_destroy (dst_validate->dirty_region);
+      g_mutex_unlock (&src_validate->mutex);
+    }
 
-              dst_validate->dirty_region = region;
-            }
-          else
-            {
-              cairo_region_union (dst_validate->dirty_region, region);
+  g_mutex_lock (&dst_validate->mutex);
 
-              cairo_region_destroy (region);
-            }
+  cairo_region_subtract_rectangle (dst_validate->dirty_region,
+                                   (cairo_rectangle_int_t *) &real_dst_rect);
+
+  if (region)
+    {
+      if (cairo_region_is_empty (dst_validate->dirty_region))
+        {
+          cairo_region_destroy (dst_validate->dirty_region);
+
+          dst_validate->dirty_region = region;
+        }
+      else
+        {
+          cairo_region_union (dst_validate->dirty_region, region);
+
+          cairo_region_destroy (region);
         }
     }
+
+  g_mutex_unlock (&dst_validate->mutex);
 }
@@ -50,6 +50,9 @@ struct _GimpTileHandlerValidate
   gboolean         whole_tile;
   gint             validating;
   gint             suspend_validate;
+
+  GMutex           mutex;        /* protects dirty_region       */
+  GRecMutex        render_mutex; /* held between begin and end  */
 };
 
 struct _GimpTileHandlerValidateClass
@@ -29,6 +29,8 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-distance.h"
+
 #include "gimpoperationborder.h"
 
 
@@ -42,6 +44,15 @@ enum
 };
 
 
+typedef struct
+{
+  GeglBuffer          *output;
+  const GeglRectangle *roi;
+  const Babl          *format;
+  gboolean             feather;
+} OutputData;
+
+
 static void     gimp_operation_border_get_property (GObject      *object,
                                                     guint         property_id,
                                                     GValue       *value,
@@ -328,6 +339,150 @@ compute_transition (gfloat    *transition,
     }
 }
 
+/* Computes the transitional pixels of all the rows, and of the `radius_y' rows
+   below them, which repeat the last computed row with `edge_lock', the way
+   the original row-by-row filter saw them. */
+static guint8 *
+gimp_operation_border_get_transitions (GimpOperationBorder *self,
+                                       GeglBuffer          *input,
+                                       const GeglRectangle *roi,
+                                       const Babl          *input_format)
+{
+  gint     width  = roi->width;
+  gint     height = roi->height;
+  guint8  *transitions;
+  gfloat  *transition;
+  gfloat  *buf[3];
+  gint     i, x, y;
+
+  transitions = g_new0 (guint8, (gsize) width * (height + self->radius_y));
+  transition  = g_new (gfloat, width);
+
+  for (i = 0; i < 3; i++)
+    buf[i] = g_new (gfloat, width);
+
+#define STORE_TRANSITION(row)                                          \
+  G_STMT_START                                                         \
+    {                                                                  \
+      guint8 *dest = transitions + (gsize) (row) * width;              \
+                                                                       \
+      for (x = 0; x < width; x++)                                      \
+        dest[x] = transition[x] != 0.0;                                \
+    }                                                                  \
+  G_STMT_END
+
+  if (self->edge_lock)
+    {
+      for (i = 0; i < width; i++)
+        buf[0][i] = 1.0;
+    }
+  else
+    {
+      memset (buf[0], 0, width * sizeof (gfloat));
+    }
+
+  gegl_buffer_get (input,
+                   GEGL_RECTANGLE (roi->x, roi->y + 0,
+                                   width, 1),
+                   1.0, input_format, buf[1],
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (height > 1)
+    gegl_buffer_get (input,
+                     GEGL_RECTANGLE (roi->x, roi->y + 1,
+                                     width, 1),
+                     1.0, input_format, buf[2],
+                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  else
+    memcpy (buf[2], buf[1], width * sizeof (gfloat));
+
+  compute_transition (transition, buf, width, self->edge_lock);
+  STORE_TRANSITION (0);
+
+  for (y = 1; y < self->radius_y && y + 1 < height; y++)
+    {
+      rotate_pointers (buf, 3);
+      gegl_buffer_get (input,
+                       GEGL_RECTANGLE (roi->x, roi->y + y + 1,
+                                       width, 1),
+                       1.0, input_format, buf[2],
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      compute_transition (transition, buf, width, self->edge_lock);
+      STORE_TRANSITION (y);
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      gint row = y + self->radius_y;
+
+      rotate_pointers (buf, 3);
+
+      if (y < height - (self->radius_y + 1))
+        {
+          gegl_buffer_get (input,
+                           GEGL_RECTANGLE (roi->x, roi->y + row + 1,
+                                           width, 1),
+                           1.0, input_format, buf[2],
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          compute_transition (transition, buf, width, self->edge_lock);
+          STORE_TRANSITION (row);
+        }
+      else if (self->edge_lock)
+        {
+          memcpy (transitions + (gsize) row       * width,
+                  transitions + (gsize) (row - 1) * width,
+                  width);
+        }
+      else
+        {
+          memset (buf[2], 0, width * sizeof (gfloat));
+          compute_transition (transition, buf, width, self->edge_lock);
+          STORE_TRANSITION (row);
+        }
+    }
+
+#undef STORE_TRANSITION
+
+  for (i = 0; i < 3; i++)
+    g_free (buf[i]);
+
+  g_free (transition);
+
+  return transitions;
+}
+
+static void
+gimp_operation_border_set_row (gint           y,
+                               const gdouble *dist,
+                               OutputData    *data)
+{
+  gfloat *out = g_new (gfloat, data->roi->width);
+  gint    x;
+
+  for (x = 0; x < data->roi->width; x++)
+    {
+      if (dist[x] < 1.0)
+        {
+          if (data->feather)
+            out[x] = 1.0 - sqrt (dist[x]);
+          else
+            out[x] = 1.0;
+        }
+      else
+        {
+          out[x] = 0.0;
+        }
+    }
+
+  gegl_buffer_set (data->output,
+                   GEGL_RECTANGLE (data->roi->x, data->roi->y + y,
+                                   data->roi->width, 1),
+                   0, data->format, out,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (out);
+}
+
 static gboolean
 gimp_operation_border_process (GeglOperation       *operation,
                                GeglBuffer          *input,
@@ -341,29 +496,9 @@ gimp_operation_border_process (GeglOperation       *operation,
   GimpOperationBorder *self          = GIMP_OPERATION_BORDER (operation);
   const Babl          *input_format  = gegl_operation_get_format (operation, "input");
   const Babl          *output_format = gegl_operation_get_format (operation, "output");
-
-  gint32 i, j, x, y;
-
-  /* A cache used in the algorithm as it works its way down. `buf[1]' is the
-     current row. Thus, at algorithm initialization, `buf[0]' represents the
-     row 'above' the first row of the region. */
-  gfloat  *buf[3];
-
-  /* The resulting selection is calculated row by row, and this buffer holds the
-     output for each individual row, on each iteration. */
-  gfloat  *out;
-
-  /* Keeps track of transitional pixels (pixels that are selected and have
-     unselected neighbouring pixels). */
-  gfloat **transition;
-
-  /* TODO: Figure out role clearly in algorithm. */
-  gint16  *max;
-
-  /* TODO: Figure out role clearly in algorithm. */
-  gfloat **density;
-
-  gint16   last_index;
+  OutputData           data;
+  guint8              *transitions;
+  gint32               i, y;
 
   /* optimize this case specifically */
   if (self->radius_x == 1 && self->radius_y == 1)
@@ -456,293 +591,23 @@ gimp_operation_border_process (GeglOperation       *operation,
       return TRUE;
     }
 
-  max = g_new (gint16, roi->width + 2 * self->radius_x);
-
-  for (i = 0; i < (roi->width + 2 * self->radius_x); i++)
-    max[i] = self->radius_y + 2;
-
-  max += self->radius_x;
-
-  for (i = 0; i < 3; i++)
-    buf[i] = g_new (gfloat, roi->width);
-
-  transition = g_new (gfloat *, self->radius_y + 1);
-
-  for (i = 0; i < self->radius_y + 1; i++)
-    {
-      transition[i] = g_new (gfloat, roi->width + 2 * self->radius_x);
-      memset (transition[i], 0,
-              (roi->width + 2 * self->radius_x) * sizeof (gfloat));
-      transition[i] += self->radius_x;
-    }
-
-  out = g_new (gfloat, roi->width);
-
-  density = g_new (gfloat *, 2 * self->radius_x + 1);
-  density += self->radius_x;
-
-  /* allocate density[][] */
-  for (x = 0; x < (self->radius_x + 1); x++)
-    {
-      density[ x]  = g_new (gfloat, 2 * self->radius_y + 1);
-      density[ x] += self->radius_y;
-      density[-x]  = density[x];
-    }
-
-  /* compute density[][] */
-  for (x = 0; x < (self->radius_x + 1); x++)
-    {
-      gdouble tmpx, tmpy, dist;
-      gfloat  a;
-
-      if (x > 0)
-        tmpx = x - 0.5;
-      else if (x < 0)
-        tmpx = x + 0.5;
-      else
-        tmpx = 0.0;
-
-      for (y = 0; y < (self->radius_y + 1); y++)
-        {
-          if (y > 0)
-            tmpy = y - 0.5;
-          else if (y < 0)
-            tmpy = y + 0.5;
-          else
-            tmpy = 0.0;
-
-          dist = ((tmpy * tmpy) / (self->radius_y * self->radius_y) +
-                  (tmpx * tmpx) / (self->radius_x * self->radius_x));
+  /* The transitional pixels within the ellipse around each pixel are found by
+     a distance transform, in O(1) time per pixel regardless of the radius. */
+  transitions = gimp_operation_border_get_transitions (self, input, roi,
+                                                       input_format);
 
-          if (dist < 1.0)
-            {
-              if (self->feather)
-                a = 1.0 - sqrt (dist);
-              else
-                a = 1.0;
-            }
-          else
-            {
-              a = 0.0;
-            }
+  data.output  = output;
+  data.roi     = roi;
+  data.format  = output_format;
+  data.feather = self->feather;
 
-          density[ x][ y] = a;
-          density[ x][-y] = a;
-          density[-x][ y] = a;
-          density[-x][-y] = a;
-        }
-    }
-
-  /* Since the algorithm considerers `buf[0]' to be 'over' the row
-   * currently calculated, we must start with `buf[0]' as non-selected
-   * if there is no `self->edge_lock. If there is an
-   * 'self->edge_lock', initialize the first row to 'selected'. Refer
-   * to bug #350009.
-   */
-  if (self->edge_lock)
-    {
-      for (i = 0; i < roi->width; i++)
-        buf[0][i] = 1.0;
-    }
-  else
-    {
-      memset (buf[0], 0, roi->width * sizeof (gfloat));
-    }
-
-  gegl_buffer_get (input,
-                   GEGL_RECTANGLE (roi->x, roi->y + 0,
-                                   roi->width, 1),
-                   1.0, input_format, buf[1],
-                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-  if (roi->height > 1)
-    gegl_buffer_get (input,
-                     GEGL_RECTANGLE (roi->x, roi->y + 1,
-                                     roi->width, 1),
-                     1.0, input_format, buf[2],
-                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-  else
-    memcpy (buf[2], buf[1], roi->width * sizeof (gfloat));
-
-  compute_transition (transition[1], buf, roi->width, self->edge_lock);
-
-   /* set up top of image */
-  for (y = 1; y < self->radius_y && y + 1 < roi->height; y++)
-    {
-      rotate_pointers (buf, 3);
-      gegl_buffer_get (input,
-                       GEGL_RECTANGLE (roi->x, roi->y + y + 1,
-                                       roi->width, 1),
-                       1.0, input_format, buf[2],
-                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-      compute_transition (transition[y + 1], buf, roi->width, self->edge_lock);
-    }
-
-  /* set up max[] for top of image */
-  for (x = 0; x < roi->width; x++)
-    {
-      max[x] = -(self->radius_y + 7);
-
-      for (j = 1; j < self->radius_y + 1; j++)
-        if (transition[j][x])
-          {
-            max[x] = j;
-            break;
-          }
-    }
-
-  /* main calculation loop */
-  for (y = 0; y < roi->height; y++)
-    {
-      rotate_pointers (buf, 3);
-      rotate_pointers (transition, self->radius_y + 1);
-
-      if (y < roi->height - (self->radius_y + 1))
-        {
-          gegl_buffer_get (input,
-                           GEGL_RECTANGLE (roi->x,
-                                           roi->y + y + self->radius_y + 1,
-                                           roi->width, 1),
-                           1.0, input_format, buf[2],
-                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-          compute_transition (transition[self->radius_y], buf, roi->width, self->edge_lock);
-        }
-      else
-        {
-          if (self->edge_lock)
-            {
-              memcpy (transition[self->radius_y], transition[self->radius_y - 1], roi->width * sizeof (gfloat));
-            }
-          else
-            {
-              /* No edge lock, set everything 'below canvas' as seen
-               * from the algorithm as unselected.
-               */
-              memset (buf[2], 0, roi->width * sizeof (gfloat));
-              compute_transition (transition[self->radius_y], buf, roi->width, self->edge_lock);
-            }
-        }
-
-      /* update max array */
-      for (x = 0; x < roi->width; x++)
-        {
-          if (max[x] < 1)
-            {
-              if (max[x] <= -self->radius_y)
-                {
-                  if (transition[self->radius_y][x])
-                    max[x] = self->radius_y;
-                  else
-                    max[x]--;
-                }
-              else
-                {
-                  if (transition[-max[x]][x])
-                    max[x] = -max[x];
-                  else if (transition[-max[x] + 1][x])
-                    max[x] = -max[x] + 1;
-                  else
-                    max[x]--;
-                }
-            }
-          else
-            {
-              max[x]--;
-            }
-
-          if (max[x] < -self->radius_y - 1)
-            max[x] = -self->radius_y - 1;
-        }
-
-      last_index = 1;
-
-       /* render scan line */
-      for (x = 0 ; x < roi->width; x++)
-        {
-          gfloat last_max;
-
-          last_index--;
-
-          if (last_index >= 0)
-            {
-              last_max = 0.0;
-
-              for (i = self->radius_x; i >= 0; i--)
-                if (max[x + i] <= self->radius_y && max[x + i] >= -self->radius_y &&
-                    density[i][max[x+i]] > last_max)
-                  {
-                    last_max = density[i][max[x + i]];
-                    last_index = i;
-                  }
-
-              out[x] = last_max;
-            }
-          else
-            {
-              last_max = 0.0;
-
-              for (i = self->radius_x; i >= -self->radius_x; i--)
-                if (max[x + i] <= self->radius_y && max[x + i] >= -self->radius_y &&
-                    density[i][max[x + i]] > last_max)
-                  {
-                    last_max = density[i][max[x + i]];
-                    last_index = i;
-                  }
-
-              out[x] = last_max;
-            }
-
-          if (last_max <= 0.0)
-            {
-              for (i = x + 1; i < roi->width; i++)
-                {
-                  if (max[i] >= -self->radius_y)
-                    break;
-                }
-
-              if (i - x > self->radius_x)
-                {
-                  for (; x < i - self->radius_x; x++)
-                    out[x] = 0;
-
-                  x--;
-                }
-
-              last_index = self->radius_x;
-            }
-        }
-
-      gegl_buffer_set (output,
-                       GEGL_RECTANGLE (roi->x, roi->y + y,
-                                       roi->width, 1),
-                       0, output_format, out,
-                       GEGL_AUTO_ROWSTRIDE);
-    }
-
-  g_free (out);
-
-  for (i = 0; i < 3; i++)
-    g_free (buf[i]);
-
-  max -= self->radius_x;
-  g_free (max);
-
-  for (i = 0; i < self->radius_y + 1; i++)
-    {
-      transition[i] -= self->radius_x;
-      g_free (transition[i]);
-    }
-
-  g_free (transition);
-
-  for (i = 0; i < self->radius_x + 1 ; i++)
-    {
-      density[i] -= self->radius_y;
-      g_free (density[i]);
-    }
+  gimp_gegl_distance_ellipse (transitions, roi->width, roi->height,
+                              self->radius_y, FALSE,
+                              self->radius_x, self->radius_y,
+                              (GimpGeglDistanceFunc) gimp_operation_border_set_row,
+                              &data);
 
-  density -= self->radius_x;
-  g_free (density);
+  g_free (transitions);
 
   return TRUE;
 }
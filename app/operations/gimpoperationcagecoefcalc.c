@@ -32,6 +32,30 @@
 #include "gimp-intl.h"
 
 
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixel-edge pairs */)
+
+
+typedef struct
+{
+  GimpVector2  v1;          /* the edge's first vertex                */
+  GimpVector2  a;           /* the edge, from the first to the second */
+  GimpVector2  dir;         /* the edge's direction                   */
+  gdouble      Q;           /* the edge's squared length              */
+  gdouble      edge_factor; /* scales the edge coefficient            */
+  gint         next;        /* index of the edge's second vertex      */
+} CageEdge;
+
+typedef struct
+{
+  GimpCageConfig *config;
+  GeglBuffer     *output;
+  const Babl     *format;
+  const CageEdge *edges;
+  guint           n_cage_vertices;
+} CoefCalcData;
+
+
 static void           gimp_operation_cage_coef_calc_finalize         (GObject              *object);
 static void           gimp_operation_cage_coef_calc_get_property     (GObject              *object,
                                                                       guint                 property_id,
@@ -148,22 +172,18 @@ gimp_operation_cage_coef_calc_set_property (GObject      *object,
 }
 
 static gboolean
-gimp_operation_cage_coef_calc_is_on_straight (GimpVector2 *d1,
-                                              GimpVector2 *d2,
-                                              GimpVector2 *p)
+gimp_operation_cage_coef_calc_is_on_straight (const CageEdge *edge,
+                                              GimpVector2     b)
 {
-  GimpVector2 v1, v2;
+  GimpVector2 v1;
   gfloat      deter;
 
-  v1.x = p->x - d1->x;
-  v1.y = p->y - d1->y;
-  v2.x = d2->x - d1->x;
-  v2.y = d2->y - d1->y;
+  v1.x = -b.x;
+  v1.y = -b.y;
 
   gimp_vector2_normalize (&v1);
-  gimp_vector2_normalize (&v2);
 
-  deter = v1.x * v2.y - v2.x * v1.y;
+  deter = v1.x * edge->dir.y - edge->dir.x * v1.y;
 
   return (deter < 0.000000001) && (deter > -0.000000001);
 }
@@ -189,29 +209,16 @@ gimp_operation_cage_coef_calc_get_bounding_box (GeglOperation *operation)
   return gimp_cage_config_get_bounding_box (config);
 }
 
-static gboolean
-gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
-                                       GeglBuffer          *output,
-                                       const GeglRectangle *roi,
-                                       gint                 level)
+static void
+gimp_operation_cage_coef_calc_area (const GeglRectangle *area,
+                                    CoefCalcData        *data)
 {
-  GimpOperationCageCoefCalc *occc   = GIMP_OPERATION_CAGE_COEF_CALC (operation);
-  GimpCageConfig            *config = GIMP_CAGE_CONFIG (occc->config);
-
-  const Babl *format;
-
+  GimpCageConfig     *config          = data->config;
+  const CageEdge     *edges           = data->edges;
+  guint               n_cage_vertices = data->n_cage_vertices;
   GeglBufferIterator *it;
-  guint               n_cage_vertices;
-  GimpCagePoint      *current, *last;
-
-  if (! config)
-    return FALSE;
-
-  format = babl_format_n (babl_type ("float"), 2 * gimp_cage_config_get_n_points (config));
 
-  n_cage_vertices   = gimp_cage_config_get_n_points (config);
-
-  it = gegl_buffer_iterator_new (output, roi, 0, format,
+  it = gegl_buffer_iterator_new (data->output, area, 0, data->format,
                                  GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
 
   while (gegl_buffer_iterator_next (it))
@@ -228,28 +235,21 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
         {
           if (gimp_cage_config_point_inside(config, x, y))
             {
-              last = &(g_array_index (config->cage_points, GimpCagePoint, 0));
+              gfloat *vertex_coef = coef;
+              gfloat *edge_coef   = coef + n_cage_vertices;
 
               for( j = 0; j < n_cage_vertices; j++)
                 {
-                  GimpVector2 v1,v2,a,b,p;
-                  gdouble BA,SRT,L0,L1,A0,A1,A10,L10, Q,S,R, absa;
-
-                  current = &(g_array_index (config->cage_points, GimpCagePoint, (j+1) % n_cage_vertices));
-                  v1 = last->src_point;
-                  v2 = current->src_point;
-                  p.x = x;
-                  p.y = y;
-                  a.x = v2.x - v1.x;
-                  a.y = v2.y - v1.y;
-                  absa = gimp_vector2_length (&a);
-
-                  b.x = v1.x - x;
-                  b.y = v1.y - y;
-                  Q = a.x * a.x + a.y * a.y;
+                  const CageEdge *edge = &edges[j];
+                  GimpVector2     b;
+                  gdouble         BA,SRT,L0,L1,A0,A1,A10,L10, Q,S,R;
+
+                  b.x = edge->v1.x - x;
+                  b.y = edge->v1.y - y;
+                  Q = edge->Q;
                   S = b.x * b.x + b.y * b.y;
-                  R = 2.0 * (a.x * b.x + a.y * b.y);
-                  BA = b.x * a.y - b.y * a.x;
+                  R = 2.0 * (edge->a.x * b.x + edge->a.y * b.y);
+                  BA = b.x * edge->a.y - b.y * edge->a.x;
                   SRT = sqrt(4.0 * S * Q - R * R);
 
                   L0 = log(S);
@@ -260,21 +260,19 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
                   L10 = L1 - L0;
 
                   /* edge coef */
-                  coef[j + n_cage_vertices] = (-absa / (4.0 * G_PI)) * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
+                  edge_coef[j] = edge->edge_factor * ((4.0*S-(R*R)/Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
 
-                  if (isnan(coef[j + n_cage_vertices]))
+                  if (isnan(edge_coef[j]))
                     {
-                      coef[j + n_cage_vertices] = 0.0;
+                      edge_coef[j] = 0.0;
                     }
 
                   /* vertice coef */
-                  if (!gimp_operation_cage_coef_calc_is_on_straight (&v1, &v2, &p))
+                  if (!gimp_operation_cage_coef_calc_is_on_straight (edge, b))
                     {
-                      coef[j] += (BA / (2.0 * G_PI)) * (L10 /(2.0*Q) - A10 * (2.0 + R / Q));
-                      coef[(j+1)%n_cage_vertices] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
+                      vertex_coef[j] += (BA / (2.0 * G_PI)) * (L10 /(2.0*Q) - A10 * (2.0 + R / Q));
+                      vertex_coef[edge->next] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
                     }
-
-                  last = current;
                 }
             }
 
@@ -289,6 +287,72 @@ gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
             }
         }
     }
+}
+
+static gboolean
+gimp_operation_cage_coef_calc_process (GeglOperation       *operation,
+                                       GeglBuffer          *output,
+                                       const GeglRectangle *roi,
+                                       gint                 level)
+{
+  GimpOperationCageCoefCalc *occc   = GIMP_OPERATION_CAGE_COEF_CALC (operation);
+  GimpCageConfig            *config = GIMP_CAGE_CONFIG (occc->config);
+  CoefCalcData               data;
+  CageEdge                  *edges;
+  GimpCagePoint             *current, *last;
+  gint                       j;
+
+  if (! config)
+    return FALSE;
+
+  data.config          = config;
+  data.output          = output;
+  data.n_cage_vertices = gimp_cage_config_get_n_points (config);
+  data.format          = babl_format_n (babl_type ("float"),
+                                        2 * data.n_cage_vertices);
+  data.edges           = edges = g_new (CageEdge, data.n_cage_vertices);
+
+  /*  Everything which only depends on the cage, and not on the pixel,
+   *  is computed once for each edge, instead of once per pixel.
+   */
+  last = &(g_array_index (config->cage_points, GimpCagePoint, 0));
+
+  for (j = 0; j < data.n_cage_vertices; j++)
+    {
+      CageEdge *edge = &edges[j];
+      gdouble   absa;
+
+      edge->next = (j + 1) % data.n_cage_vertices;
+
+      current = &(g_array_index (config->cage_points, GimpCagePoint, edge->next));
+
+      edge->v1  = last->src_point;
+      edge->a.x = current->src_point.x - last->src_point.x;
+      edge->a.y = current->src_point.y - last->src_point.y;
+      edge->dir = edge->a;
+      edge->Q   = edge->a.x * edge->a.x + edge->a.y * edge->a.y;
+
+      absa = gimp_vector2_length (&edge->a);
+
+      edge->edge_factor = -absa / (4.0 * G_PI);
+
+      gimp_vector2_normalize (&edge->dir);
+
+      last = current;
+    }
+
+  /*  Each pixel's coefficients only depend on the cage, so the roi is
+   *  split between threads.  The cost of a pixel grows with the number
+   *  of cage vertices.
+   */
+  gegl_parallel_distribute_area (
+    roi, PIXELS_PER_THREAD / MAX (data.n_cage_vertices, 1),
+    GEGL_SPLIT_STRATEGY_AUTO,
+    (GeglParallelDistributeAreaFunc) gimp_operation_cage_coef_calc_area,
+    &data);
+
+  g_free (edges);
 
   return TRUE;
 }
+
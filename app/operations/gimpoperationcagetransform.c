@@ -33,6 +33,20 @@
 
 #include "gimp-intl.h"
 
+#define PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+
+/* the cage bounding box is transformed in bands of CAGE_BAND_HEIGHT
+ * rows of cells, one after the other.
+ */
+#define CAGE_BAND_HEIGHT 128
+
+/* the output is rendered in bands of BAND_HEIGHT scanlines, each of
+ * which is rendered, start to end, by a single thread.
+ */
+#define BAND_HEIGHT 32
+
+
 enum
 {
   PROP_0,
@@ -41,6 +55,36 @@ enum
 };
 
 
+typedef struct
+{
+  GimpOperationCageTransform *oct;
+  GimpCageConfig             *config;
+  GeglBuffer                 *aux_buf;
+  GeglBuffer                 *out_buf;
+  const GeglRectangle        *roi;
+  GeglRectangle               cage_bb;
+  GimpVector2                 plain_color;
+  const Babl                 *format_coef;
+  gint                        n_cage_vertices;
+
+  /*  the current band of the cage bounding box  */
+  gint                        band_y;      /* its first row of cells       */
+  gint                        band_height; /* its number of rows of cells  */
+  GimpVector2                *dest;        /* the destination of each of
+                                            * its points
+                                            */
+  gdouble                    *dest_min_y;  /* the destination's y range    */
+  gdouble                    *dest_max_y;  /* for each of its rows         */
+  guint8                     *inside;      /* whether each of its cells is
+                                            * inside the cage
+                                            */
+
+  gint                        first_band;  /* the first output band to
+                                            * render
+                                            */
+} CageTransformData;
+
+
 static void         gimp_operation_cage_transform_finalize                (GObject             *object);
 static void         gimp_operation_cage_transform_get_property            (GObject             *object,
                                                                            guint                property_id,
@@ -57,22 +101,33 @@ static gboolean     gimp_operation_cage_transform_process                 (GeglO
                                                                            GeglBuffer          *out_buf,
                                                                            const GeglRectangle *roi,
                                                                            gint                 level);
+static void         gimp_operation_cage_transform_get_band                (const GeglRectangle *roi,
+                                                                           gint                 index,
+                                                                           GeglRectangle       *band);
+static void         gimp_operation_cage_transform_fill_band               (CageTransformData   *data,
+                                                                           const GeglRectangle *band,
+                                                                           gfloat              *output);
+static void         gimp_operation_cage_transform_fill_bands              (gsize                offset,
+                                                                           gsize                size,
+                                                                           CageTransformData   *data);
+static void         gimp_operation_cage_transform_compute_rows            (gsize                offset,
+                                                                           gsize                size,
+                                                                           CageTransformData   *data);
+static void         gimp_operation_cage_transform_render_bands            (gsize                offset,
+                                                                           gsize                size,
+                                                                           CageTransformData   *data);
 static void         gimp_operation_cage_transform_interpolate_source_coords_recurs
-                                                                          (GimpOperationCageTransform  *oct,
-                                                                           GeglBuffer          *out_buf,
-                                                                           const GeglRectangle *roi,
+                                                                          (const GeglRectangle *roi,
+                                                                           gfloat              *output,
                                                                            GimpVector2          p1_s,
                                                                            GimpVector2          p1_d,
                                                                            GimpVector2          p2_s,
                                                                            GimpVector2          p2_d,
                                                                            GimpVector2          p3_s,
                                                                            GimpVector2          p3_d,
-                                                                           gint                 recursion_depth,
-                                                                           gfloat              *coords);
+                                                                           gint                 recursion_depth);
 static GimpVector2  gimp_cage_transform_compute_destination               (GimpCageConfig      *config,
-                                                                           gfloat              *coef,
-                                                                           GeglSampler         *coef_sampler,
-                                                                           GimpVector2          coords);
+                                                                           const gfloat        *coef);
 GeglRectangle       gimp_operation_cage_transform_get_cached_region       (GeglOperation       *operation,
                                                                            const GeglRectangle *roi);
 GeglRectangle       gimp_operation_cage_transform_get_required_for_output (GeglOperation       *operation,
@@ -109,8 +164,10 @@ gimp_operation_cage_transform_class_init (GimpOperationCageTransformClass *klass
   operation_class->get_required_for_output = gimp_operation_cage_transform_get_required_for_output;
   operation_class->get_cached_region       = gimp_operation_cage_transform_get_cached_region;
   operation_class->get_bounding_box        = gimp_operation_cage_transform_get_bounding_box;
-  /* XXX Temporarily disable multi-threading on this operation because
-   * it is much faster when single-threaded. See bug 787663.
+  /* The whole cage is rasterized for every processed rectangle, so
+   * GEGL's own multi-threading, which splits the output into many small
+   * rectangles, makes things slower (see bug 787663).  Instead, process()
+   * distributes the work between threads itself.
    */
   operation_class->threaded                = FALSE;
 
@@ -219,52 +276,165 @@ gimp_operation_cage_transform_process (GeglOperation       *operation,
 {
   GimpOperationCageTransform *oct    = GIMP_OPERATION_CAGE_TRANSFORM (operation);
   GimpCageConfig             *config = GIMP_CAGE_CONFIG (oct->config);
-  GeglRectangle               cage_bb;
-  gfloat                     *coords;
-  gfloat                     *coef;
-  const Babl                 *format_coef;
-  GeglSampler                *coef_sampler;
-  GimpVector2                 plain_color;
-  GeglBufferIterator         *it;
-  gint                        x, y;
-  gboolean                    output_set;
+  CageTransformData           data   = { 0, };
   GimpCagePoint              *point;
-  guint                       n_cage_vertices;
+  gint                        n_bands;
+  gint                        n_rows;
+
+  data.oct             = oct;
+  data.config          = config;
+  data.aux_buf         = aux_buf;
+  data.out_buf         = out_buf;
+  data.roi             = roi;
+  data.cage_bb         = gimp_cage_config_get_bounding_box (config);
+  data.n_cage_vertices = gimp_cage_config_get_n_points (config);
+  data.format_coef     = babl_format_n (babl_type ("float"),
+                                        2 * data.n_cage_vertices);
+
+  point = &(g_array_index (config->cage_points, GimpCagePoint, 0));
+  data.plain_color.x = (gint) point->src_point.x;
+  data.plain_color.y = (gint) point->src_point.y;
+
+  n_bands = (roi->height + BAND_HEIGHT - 1) / BAND_HEIGHT;
 
   /* pre-fill the out buffer with no-displacement coordinate */
-  it      = gegl_buffer_iterator_new (out_buf, roi, 0, NULL,
-                                      GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
-  cage_bb = gimp_cage_config_get_bounding_box (config);
+  gegl_parallel_distribute_range (
+    n_bands, 1,
+    (GeglParallelDistributeRangeFunc)
+      gimp_operation_cage_transform_fill_bands,
+    &data);
 
-  point = &(g_array_index (config->cage_points, GimpCagePoint, 0));
-  plain_color.x = (gint) point->src_point.x;
-  plain_color.y = (gint) point->src_point.y;
+  if (! aux_buf)
+    return TRUE;
+
+  gegl_operation_progress (operation, 0.0, "");
 
-  n_cage_vertices = gimp_cage_config_get_n_points (config);
+  n_rows = data.cage_bb.height - 1;
 
-  while (gegl_buffer_iterator_next (it))
+  if (data.cage_bb.width > 1 && n_rows > 0)
     {
-      /* iterate inside the roi */
-      gint    n_pixels = it->length;
-      gfloat *output   = it->items[0].data;
+      data.dest       = g_new (GimpVector2,
+                               (gsize) (CAGE_BAND_HEIGHT + 1) *
+                               data.cage_bb.width);
+      data.dest_min_y = g_new (gdouble, CAGE_BAND_HEIGHT + 1);
+      data.dest_max_y = g_new (gdouble, CAGE_BAND_HEIGHT + 1);
+      data.inside     = g_new (guint8,
+                               (gsize) CAGE_BAND_HEIGHT *
+                               (data.cage_bb.width - 1));
+    }
 
-      x = it->items[0].roi.x; /* initial x         */
-      y = it->items[0].roi.y; /* and y coordinates */
+  /*  compute, reverse and interpolate the transformation, one band of
+   *  the cage bounding box at a time, in order.  the destination of
+   *  each point of the band is computed once, in parallel, reading the
+   *  coefficients a row at a time.  then, the output bands which the
+   *  band's cells can reach are rendered in parallel.  each of them
+   *  goes over the cells in the same order, and only keeps the pixels
+   *  falling inside it, so the result doesn't depend on how the bands
+   *  are split between threads.
+   */
+  for (data.band_y = 0;
+       data.dest && data.band_y < n_rows;
+       data.band_y += CAGE_BAND_HEIGHT)
+    {
+      gdouble min_y      = G_MAXDOUBLE;
+      gdouble max_y      = -G_MAXDOUBLE;
+      gint    first_band = 0;
+      gint    last_band  = n_bands - 1;
+      gint    y;
+
+      data.band_height = MIN (CAGE_BAND_HEIGHT, n_rows - data.band_y);
+
+      /*  the band's last row of points is the next band's first  */
+      gegl_parallel_distribute_range (
+        data.band_height + 1,
+        PIXELS_PER_THREAD / data.cage_bb.width,
+        (GeglParallelDistributeRangeFunc)
+          gimp_operation_cage_transform_compute_rows,
+        &data);
+
+      for (y = 0; y <= data.band_height; y++)
+        {
+          min_y = MIN (min_y, data.dest_min_y[y]);
+          max_y = MAX (max_y, data.dest_max_y[y]);
+        }
+
+      if (min_y >= roi->y + roi->height)
+        first_band = n_bands;
+      else if (min_y >= roi->y)
+        first_band = ((gint) floor (min_y) - roi->y) / BAND_HEIGHT;
 
-      while (n_pixels--)
+      if (max_y < roi->y)
+        last_band = -1;
+      else if (max_y < roi->y + roi->height)
+        last_band = ((gint) floor (max_y) - roi->y) / BAND_HEIGHT;
+
+      if (first_band <= last_band)
         {
-          output_set = FALSE;
-          if (oct->fill_plain_color)
+          data.first_band = first_band;
+
+          gegl_parallel_distribute_range (
+            last_band - first_band + 1, 1,
+            (GeglParallelDistributeRangeFunc)
+              gimp_operation_cage_transform_render_bands,
+            &data);
+        }
+
+      if (data.band_y + data.band_height < n_rows)
+        {
+          gegl_operation_progress (operation,
+                                   (gdouble) (data.band_y +
+                                              data.band_height) /
+                                   (gdouble) n_rows,
+                                   "");
+        }
+    }
+
+  g_free (data.dest);
+  g_free (data.dest_min_y);
+  g_free (data.dest_max_y);
+  g_free (data.inside);
+
+  gegl_operation_progress (operation, 1.0, "");
+
+  return TRUE;
+}
+
+static void
+gimp_operation_cage_transform_get_band (const GeglRectangle *roi,
+                                        gint                 index,
+                                        GeglRectangle       *band)
+{
+  band->x      = roi->x;
+  band->y      = roi->y + index * BAND_HEIGHT;
+  band->width  = roi->width;
+  band->height = MIN (BAND_HEIGHT, roi->y + roi->height - band->y);
+}
+
+static void
+gimp_operation_cage_transform_fill_band (CageTransformData   *data,
+                                         const GeglRectangle *band,
+                                         gfloat              *output)
+{
+  const GeglRectangle *cage_bb = &data->cage_bb;
+  gint                 x, y;
+
+  for (y = band->y; y < band->y + band->height; y++)
+    {
+      for (x = band->x; x < band->x + band->width; x++)
+        {
+          gboolean output_set = FALSE;
+
+          if (data->oct->fill_plain_color)
             {
-              if (x > cage_bb.x &&
-                  y > cage_bb.y &&
-                  x < cage_bb.x + cage_bb.width &&
-                  y < cage_bb.y + cage_bb.height)
+              if (x > cage_bb->x &&
+                  y > cage_bb->y &&
+                  x < cage_bb->x + cage_bb->width &&
+                  y < cage_bb->y + cage_bb->height)
                 {
-                  if (gimp_cage_config_point_inside (config, x, y))
+                  if (gimp_cage_config_point_inside (data->config, x, y))
                     {
-                      output[0] = plain_color.x;
-                      output[1] = plain_color.y;
+                      output[0] = data->plain_color.x;
+                      output[1] = data->plain_color.y;
                       output_set = TRUE;
                     }
                 }
@@ -276,114 +446,178 @@ gimp_operation_cage_transform_process (GeglOperation       *operation,
             }
 
           output += 2;
-
-          /* update x and y coordinates */
-          x++;
-          if (x >= (it->items[0].roi.x + it->items[0].roi.width))
-            {
-              x = it->items[0].roi.x;
-              y++;
-            }
         }
     }
+}
 
-  if (! aux_buf)
-    return TRUE;
-
-  gegl_operation_progress (operation, 0.0, "");
+static void
+gimp_operation_cage_transform_fill_bands (gsize              offset,
+                                          gsize              size,
+                                          CageTransformData *data)
+{
+  gfloat *output;
+  gint    i;
 
-  /* pre-allocate memory outside of the loop */
-  coords       = g_slice_alloc (2 * sizeof (gfloat));
-  coef         = g_malloc (n_cage_vertices * 2 * sizeof (gfloat));
-  format_coef  = babl_format_n (babl_type ("float"), 2 * n_cage_vertices);
-  coef_sampler = gegl_buffer_sampler_new (aux_buf,
-                                          format_coef, GEGL_SAMPLER_NEAREST);
+  output = g_new (gfloat, (gsize) data->roi->width * BAND_HEIGHT * 2);
 
-  /* compute, reverse and interpolate the transformation */
-  for (y = cage_bb.y; y < cage_bb.y + cage_bb.height - 1; y++)
+  for (i = offset; i < (gint) (offset + size); i++)
     {
-      GimpVector2 p1_d, p2_d, p3_d, p4_d;
-      GimpVector2 p1_s, p2_s, p3_s, p4_s;
+      GeglRectangle band;
 
-      p1_s.y = y;
-      p2_s.y = y+1;
-      p3_s.y = y+1;
-      p3_s.x = cage_bb.x;
-      p4_s.y = y;
-      p4_s.x = cage_bb.x;
+      gimp_operation_cage_transform_get_band (data->roi, i, &band);
 
-      p3_d = gimp_cage_transform_compute_destination (config, coef, coef_sampler, p3_s);
-      p4_d = gimp_cage_transform_compute_destination (config, coef, coef_sampler, p4_s);
+      gimp_operation_cage_transform_fill_band (data, &band, output);
 
-      for (x = cage_bb.x; x < cage_bb.x + cage_bb.width - 1; x++)
-        {
-          p1_s = p4_s;
-          p2_s = p3_s;
-          p3_s.x = x+1;
-          p4_s.x = x+1;
+      gegl_buffer_set (data->out_buf, &band, 0,
+                       data->oct->format_coords, output,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
 
-          p1_d = p4_d;
-          p2_d = p3_d;
-          p3_d = gimp_cage_transform_compute_destination (config, coef, coef_sampler, p3_s);
-          p4_d = gimp_cage_transform_compute_destination (config, coef, coef_sampler, p4_s);
+  g_free (output);
+}
 
-          if (gimp_cage_config_point_inside (config, x, y))
-            {
-              gimp_operation_cage_transform_interpolate_source_coords_recurs (oct,
-                                                                              out_buf,
-                                                                              roi,
-                                                                              p1_s, p1_d,
-                                                                              p2_s, p2_d,
-                                                                              p3_s, p3_d,
-                                                                              0,
-                                                                              coords);
-
-              gimp_operation_cage_transform_interpolate_source_coords_recurs (oct,
-                                                                              out_buf,
-                                                                              roi,
-                                                                              p1_s, p1_d,
-                                                                              p3_s, p3_d,
-                                                                              p4_s, p4_d,
-                                                                              0,
-                                                                              coords);
-            }
+static void
+gimp_operation_cage_transform_compute_rows (gsize              offset,
+                                            gsize              size,
+                                            CageTransformData *data)
+{
+  const GeglRectangle *cage_bb = &data->cage_bb;
+  gfloat              *coef;
+  gint                 y;
+
+  coef = g_new (gfloat, (gsize) cage_bb->width * 2 * data->n_cage_vertices);
+
+  for (y = offset; y < (gint) (offset + size); y++)
+    {
+      GeglRectangle  row   = { cage_bb->x, cage_bb->y + data->band_y + y,
+                               cage_bb->width, 1 };
+      GimpVector2   *dest  = data->dest + (gsize) y * cage_bb->width;
+      gdouble        min_y = G_MAXDOUBLE;
+      gdouble        max_y = -G_MAXDOUBLE;
+      gint           x;
+
+      gegl_buffer_get (data->aux_buf, &row, 1.0, data->format_coef, coef,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (x = 0; x < cage_bb->width; x++)
+        {
+          dest[x] = gimp_cage_transform_compute_destination (
+            data->config, coef + x * 2 * data->n_cage_vertices);
+
+          min_y = MIN (min_y, dest[x].y);
+          max_y = MAX (max_y, dest[x].y);
         }
 
-      if ((y - cage_bb.y) % 20 == 0)
+      data->dest_min_y[y] = min_y;
+      data->dest_max_y[y] = max_y;
+
+      if (y < data->band_height)
         {
-          gdouble fraction = ((gdouble) (y - cage_bb.y) /
-                              (gdouble) (cage_bb.height));
+          guint8 *inside = data->inside + (gsize) y * (cage_bb->width - 1);
 
-          /*  0.0 and 1.0 indicate progress start/end, so avoid them  */
-          if (fraction > 0.0 && fraction < 1.0)
+          for (x = 0; x < cage_bb->width - 1; x++)
             {
-              gegl_operation_progress (operation, fraction, "");
+              inside[x] = gimp_cage_config_point_inside (data->config,
+                                                         row.x + x,
+                                                         row.y);
             }
         }
     }
 
-  g_object_unref (coef_sampler);
   g_free (coef);
-  g_slice_free1 (2 * sizeof (gfloat), coords);
+}
 
-  gegl_operation_progress (operation, 1.0, "");
+static void
+gimp_operation_cage_transform_render_bands (gsize              offset,
+                                            gsize              size,
+                                            CageTransformData *data)
+{
+  const GeglRectangle *cage_bb = &data->cage_bb;
+  gfloat              *output;
+  gint                 i;
 
-  return TRUE;
-}
+  output = g_new (gfloat, (gsize) data->roi->width * BAND_HEIGHT * 2);
+
+  for (i = offset; i < (gint) (offset + size); i++)
+    {
+      GeglRectangle band;
+      gint          x, y;
+
+      gimp_operation_cage_transform_get_band (data->roi,
+                                              data->first_band + i, &band);
+
+      gegl_buffer_get (data->out_buf, &band, 1.0,
+                       data->oct->format_coords, output,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      for (y = 0; y < data->band_height; y++)
+        {
+          const GimpVector2 *dest1  = data->dest + (gsize) y * cage_bb->width;
+          const GimpVector2 *dest2  = dest1 + cage_bb->width;
+          const guint8      *inside = data->inside +
+                                      (gsize) y * (cage_bb->width - 1);
+
+          /* skip the rows of cells which are entirely above or below
+           * the band
+           */
+          if (MIN (data->dest_min_y[y], data->dest_min_y[y + 1]) >=
+              band.y + band.height ||
+              MAX (data->dest_max_y[y], data->dest_max_y[y + 1]) <
+              band.y)
+            {
+              continue;
+            }
 
+          for (x = 0; x < cage_bb->width - 1; x++)
+            {
+              GimpVector2 p1_s, p2_s, p3_s, p4_s;
+
+              if (! inside[x])
+                continue;
+
+              p1_s.x = cage_bb->x + x;
+              p1_s.y = cage_bb->y + data->band_y + y;
+              p2_s.x = p1_s.x;
+              p2_s.y = p1_s.y + 1;
+              p3_s.x = p1_s.x + 1;
+              p3_s.y = p1_s.y + 1;
+              p4_s.x = p1_s.x + 1;
+              p4_s.y = p1_s.y;
+
+              gimp_operation_cage_transform_interpolate_source_coords_recurs (&band,
+                                                                              output,
+                                                                              p1_s, dest1[x],
+                                                                              p2_s, dest2[x],
+                                                                              p3_s, dest2[x + 1],
+                                                                              0);
+
+              gimp_operation_cage_transform_interpolate_source_coords_recurs (&band,
+                                                                              output,
+                                                                              p1_s, dest1[x],
+                                                                              p3_s, dest2[x + 1],
+                                                                              p4_s, dest1[x + 1],
+                                                                              0);
+            }
+        }
+
+      gegl_buffer_set (data->out_buf, &band, 0,
+                       data->oct->format_coords, output,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (output);
+}
 
 static void
-gimp_operation_cage_transform_interpolate_source_coords_recurs (GimpOperationCageTransform *oct,
-                                                                GeglBuffer                 *out_buf,
-                                                                const GeglRectangle        *roi,
-                                                                GimpVector2                 p1_s,
-                                                                GimpVector2                 p1_d,
-                                                                GimpVector2                 p2_s,
-                                                                GimpVector2                 p2_d,
-                                                                GimpVector2                 p3_s,
-                                                                GimpVector2                 p3_d,
-                                                                gint                        recursion_depth,
-                                                                gfloat                     *coords)
+gimp_operation_cage_transform_interpolate_source_coords_recurs (const GeglRectangle *roi,
+                                                                gfloat              *output,
+                                                                GimpVector2          p1_s,
+                                                                GimpVector2          p1_d,
+                                                                GimpVector2          p2_s,
+                                                                GimpVector2          p2_d,
+                                                                GimpVector2          p3_s,
+                                                                GimpVector2          p3_d,
+                                                                gint                 recursion_depth)
 {
   gint xmin, xmax, ymin, ymax, x, y;
 
@@ -450,25 +684,17 @@ gimp_operation_cage_transform_interpolate_source_coords_recurs (GimpOperationCag
       c = 1.0 - a - b;
 
       /* if a pixel is inside, we compute its source coordinate and
-       * set it in the output buffer
+       * set it in the output, unless it belongs to another band
        */
-      if ((a > 0 && b > 0 && c > 0) || (a < 0 && b < 0 && c < 0))
+      if (((a > 0 && b > 0 && c > 0) || (a < 0 && b < 0 && c < 0)) &&
+          xmin >= roi->x && xmin < roi->x + roi->width &&
+          ymin >= roi->y && ymin < roi->y + roi->height)
         {
-          GeglRectangle rect = { 0, 0, 1, 1 };
-          gfloat        coords[2];
-
-          rect.x = xmin;
-          rect.y = ymin;
+          gfloat *coords = output + 2 * ((ymin - roi->y) * roi->width +
+                                         (xmin - roi->x));
 
           coords[0] = (a * p1_s.x + b * p2_s.x + c * p3_s.x);
           coords[1] = (a * p1_s.y + b * p2_s.y + c * p3_s.y);
-
-          gegl_buffer_set (out_buf,
-                           &rect,
-                           0,
-                           oct->format_coords,
-                           coords,
-                           GEGL_AUTO_ROWSTRIDE);
         }
 
       return;
@@ -506,58 +732,45 @@ gimp_operation_cage_transform_interpolate_source_coords_recurs (GimpOperationCag
       pm3_s.x = (p3_s.x + p1_s.x) / 2.0;
       pm3_s.y = (p3_s.y + p1_s.y) / 2.0;
 
-      gimp_operation_cage_transform_interpolate_source_coords_recurs (oct,
-                                                                      out_buf,
-                                                                      roi,
+      gimp_operation_cage_transform_interpolate_source_coords_recurs (roi,
+                                                                      output,
                                                                       p1_s, p1_d,
                                                                       pm1_s, pm1_d,
                                                                       pm3_s, pm3_d,
-                                                                      next_depth,
-                                                                      coords);
+                                                                      next_depth);
 
-      gimp_operation_cage_transform_interpolate_source_coords_recurs (oct,
-                                                                      out_buf,
-                                                                      roi,
+      gimp_operation_cage_transform_interpolate_source_coords_recurs (roi,
+                                                                      output,
                                                                       pm1_s, pm1_d,
                                                                       p2_s, p2_d,
                                                                       pm2_s, pm2_d,
-                                                                      next_depth,
-                                                                      coords);
+                                                                      next_depth);
 
-      gimp_operation_cage_transform_interpolate_source_coords_recurs (oct,
-                                                                      out_buf,
-                                                                      roi,
+      gimp_operation_cage_transform_interpolate_source_coords_recurs (roi,
+                                                                      output,
                                                                       pm1_s, pm1_d,
                                                                       pm2_s, pm2_d,
                                                                       pm3_s, pm3_d,
-                                                                      next_depth,
-                                                                      coords);
+                                                                      next_depth);
 
-      gimp_operation_cage_transform_interpolate_source_coords_recurs (oct,
-                                                                      out_buf,
-                                                                      roi,
+      gimp_operation_cage_transform_interpolate_source_coords_recurs (roi,
+                                                                      output,
                                                                       pm3_s, pm3_d,
                                                                       pm2_s, pm2_d,
                                                                       p3_s, p3_d,
-                                                                      next_depth,
-                                                                      coords);
+                                                                      next_depth);
     }
 }
 
 static GimpVector2
 gimp_cage_transform_compute_destination (GimpCageConfig *config,
-                                         gfloat         *coef,
-                                         GeglSampler    *coef_sampler,
-                                         GimpVector2     coords)
+                                         const gfloat   *coef)
 {
   GimpVector2    result = {0, 0};
   gint           n_cage_vertices = gimp_cage_config_get_n_points (config);
   gint           i;
   GimpCagePoint *point;
 
-  gegl_sampler_get (coef_sampler,
-                    coords.x, coords.y, NULL, coef, GEGL_ABYSS_NONE);
-
   for (i = 0; i < n_cage_vertices; i++)
     {
       point = &g_array_index (config->cage_points, GimpCagePoint, i);
@@ -601,3 +814,4 @@ gimp_operation_cage_transform_get_bounding_box (GeglOperation *operation)
 
   return result;
 }
+
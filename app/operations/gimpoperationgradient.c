@@ -39,6 +39,9 @@
 #define GRADIENT_CACHE_N_SUPERSAMPLES 4
 #define GRADIENT_CACHE_MAX_SIZE       ((1 << 20) / sizeof (GimpRGB))
 
+#define SUPERSAMPLE_PIXELS_PER_THREAD \
+  (/* each thread costs as much as */ 32.0 * 32.0 /* supersampled pixels */)
+
 
 enum
 {
@@ -86,6 +89,16 @@ typedef struct
 } PutPixelData;
 
 
+typedef struct
+{
+  GimpOperationGradient *self;
+  GeglBuffer            *input;
+  GeglBuffer            *output;
+  gint                   level;
+  const RenderBlendData *rbd;
+} SupersampleData;
+
+
 /*  local function prototypes  */
 
 static void            gimp_operation_gradient_dispose           (GObject               *gobject);
@@ -165,6 +178,9 @@ static void            gradient_dither_pixel                     (GimpRGB
                                                                   GRand                 *dither_rand,
                                                                   gfloat                *dest);
 
+static void            gimp_operation_gradient_supersample_area  (const GeglRectangle   *area,
+                                                                  SupersampleData       *data);
+
 static gboolean        gimp_operation_gradient_process           (GeglOperation         *operation,
                                                                   GeglBuffer            *input,
                                                                   GeglBuffer            *output,
@@ -1065,6 +1081,55 @@ gradient_dither_pixel (GimpRGB *color,
   *dest++ = CLAMP (a, 0.0, 1.0);
 }
 
+static void
+gimp_operation_gradient_supersample_area (const GeglRectangle *area,
+                                          SupersampleData     *data)
+{
+  GimpOperationGradient *self = data->self;
+  RenderBlendData        rbd  = *data->rbd;
+  PutPixelData           ppd;
+  GeglBufferIterator    *iter;
+  GeglRectangle         *roi;
+
+  /*  the distance sampler, and the last gradient segment, are not shared
+   *  between threads
+   */
+  if (rbd.dist_sampler)
+    {
+      rbd.dist_sampler = gegl_buffer_sampler_new_at_level (
+        data->input, babl_format ("Y float"), GEGL_SAMPLER_NEAREST,
+        data->level);
+    }
+
+  ppd.dither_rand = self->dither ? g_rand_new () : NULL;
+
+  iter = gegl_buffer_iterator_new (data->output, area, 0,
+                                   babl_format ("R'G'B'A float"),
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+  roi = &iter->items[0].roi;
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      ppd.data = iter->items[0].data;
+      ppd.roi  = *roi;
+
+      gimp_adaptive_supersample_area (roi->x, roi->y,
+                                      roi->x + roi->width  - 1,
+                                      roi->y + roi->height - 1,
+                                      self->supersample_depth,
+                                      self->supersample_threshold,
+                                      gradient_render_pixel, &rbd,
+                                      gradient_put_pixel, &ppd,
+                                      NULL,
+                                      NULL);
+    }
+
+  if (ppd.dither_rand)
+    g_rand_free (ppd.dither_rand);
+
+  g_clear_object (&rbd.dist_sampler);
+}
+
 static gboolean
 gimp_operation_gradient_process (GeglOperation       *operation,
                                  GeglBuffer          *input,
@@ -1147,38 +1212,36 @@ gimp_operation_gradient_process (GeglOperation       *operation,
 
   /* Render the gradient! */
 
-  iter = gegl_buffer_iterator_new (output, result, 0,
-                                   babl_format ("R'G'B'A float"),
-                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
-  roi = &iter->items[0].roi;
-
-  if (self->dither)
-    dither_rand = g_rand_new ();
-
   if (self->supersample)
     {
-      PutPixelData ppd;
-
-      ppd.dither_rand = dither_rand;
-
-      while (gegl_buffer_iterator_next (iter))
-        {
-          ppd.data = iter->items[0].data;
-          ppd.roi  = *roi;
-
-          gimp_adaptive_supersample_area (roi->x, roi->y,
-                                          roi->x + roi->width  - 1,
-                                          roi->y + roi->height - 1,
-                                          self->supersample_depth,
-                                          self->supersample_threshold,
-                                          gradient_render_pixel, &rbd,
-                                          gradient_put_pixel, &ppd,
-                                          NULL,
-                                          NULL);
-        }
+      SupersampleData data;
+
+      data.self   = self;
+      data.input  = input;
+      data.output = output;
+      data.level  = level;
+      data.rbd    = &rbd;
+
+      /*  each area is supersampled independently, without sharing the
+       *  samples on its edges with its neighbors, which only costs
+       *  these samples being rendered twice, since rendering is a pure
+       *  function of the sample position.
+       */
+      gegl_parallel_distribute_area (
+        result, SUPERSAMPLE_PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) gimp_operation_gradient_supersample_area,
+        &data);
     }
   else
     {
+      iter = gegl_buffer_iterator_new (output, result, 0,
+                                       babl_format ("R'G'B'A float"),
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+      roi = &iter->items[0].roi;
+
+      if (self->dither)
+        dither_rand = g_rand_new ();
+
       while (gegl_buffer_iterator_next (iter))
         {
           gfloat *dest = iter->items[0].data;
@@ -1215,10 +1278,10 @@ gimp_operation_gradient_process (GeglOperation       *operation,
                   }
             }
         }
-    }
 
-  if (self->dither)
-    g_rand_free (dither_rand);
+      if (dither_rand)
+        g_rand_free (dither_rand);
+    }
 
   g_clear_object (&rbd.dist_sampler);
 
@@ -1281,3 +1344,4 @@ gimp_operation_gradient_validate_cache (GimpOperationGradient *self)
 
   g_mutex_unlock (&self->gradient_cache_mutex);
 }
+
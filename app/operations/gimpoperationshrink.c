@@ -29,6 +29,8 @@
 
 #include "operations-types.h"
 
+#include "gegl/gimp-gegl-distance.h"
+
 #include "gimpoperationshrink.h"
 
 
@@ -41,6 +43,14 @@ enum
 };
 
 
+typedef struct
+{
+  GeglBuffer          *output;
+  const GeglRectangle *roi;
+  const Babl          *format;
+} OutputData;
+
+
 static void     gimp_operation_shrink_get_property (GObject             *object,
                                                     guint                property_id,
                                                     GValue              *value,
@@ -242,6 +252,63 @@ rotate_pointers (gfloat  **p,
   p[i] = tmp;
 }
 
+static void
+gimp_operation_shrink_set_row (gint           y,
+                               const gdouble *dist,
+                               OutputData    *data)
+{
+  gfloat *out = g_new (gfloat, data->roi->width);
+  gint    x;
+
+  for (x = 0; x < data->roi->width; x++)
+    out[x] = dist[x] < 1.0 ? 0.0 : 1.0;
+
+  gegl_buffer_set (data->output,
+                   GEGL_RECTANGLE (data->roi->x, data->roi->y + y,
+                                   data->roi->width, 1),
+                   0, data->format, out,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  g_free (out);
+}
+
+/*  a binary mask keeps the pixels which have no unselected pixel within
+ *  the ellipse around them, which is found by a distance transform to
+ *  the unselected pixels.  without edge lock, the outside of the region
+ *  counts as unselected; with edge lock, it replicates the edge pixels,
+ *  which never brings an unselected pixel any closer, and is ignored.
+ */
+static gboolean
+gimp_operation_shrink_process_binary (GimpOperationShrink *self,
+                                      GeglBuffer          *input,
+                                      GeglBuffer          *output,
+                                      const GeglRectangle *roi,
+                                      const Babl          *input_format,
+                                      const Babl          *output_format)
+{
+  OutputData  data;
+  guint8     *sites;
+
+  sites = gimp_gegl_distance_get_sites (input, roi, input_format, TRUE);
+
+  if (! sites)
+    return FALSE;
+
+  data.output = output;
+  data.roi    = roi;
+  data.format = output_format;
+
+  gimp_gegl_distance_ellipse (sites, roi->width, roi->height, 0,
+                              ! self->edge_lock,
+                              self->radius_x, self->radius_y,
+                              (GimpGeglDistanceFunc) gimp_operation_shrink_set_row,
+                              &data);
+
+  g_free (sites);
+
+  return TRUE;
+}
+
 static gboolean
 gimp_operation_shrink_process (GeglOperation       *operation,
                                GeglBuffer          *input,
@@ -269,6 +336,10 @@ gimp_operation_shrink_process (GeglOperation       *operation,
   gfloat              *buffer;
   gint                 buffer_size;
 
+  if (gimp_operation_shrink_process_binary (self, input, output, roi,
+                                            input_format, output_format))
+    return TRUE;
+
   max = g_new (gfloat *, roi->width + 2 * self->radius_x);
   buf = g_new (gfloat *, self->radius_y + 1);
 
@@ -1347,10 +1347,10 @@ gimp_layer_mode_get_blend_function (GimpLayerMode mode)
 {
   const GimpLayerModeInfo *info = gimp_layer_mode_info (mode);
 
-  if (! info)
+  if (! info || ! info->blend_function)
     return NULL;
 
-  return info->blend_function;
+  return gimp_operation_layer_mode_blend_get_accelerated (info->blend_function);
 }
 
 GimpLayerModeContext
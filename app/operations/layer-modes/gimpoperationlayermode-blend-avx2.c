@@ -0,0 +1,428 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationlayermode-blend-avx2.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl-plugin.h>
+#include <cairo.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "../operations-types.h"
+
+#include "gimpoperationlayermode-blend.h"
+
+
+#if COMPILE_AVX2_INTRINISICS
+
+/* AVX2 */
+#include <immintrin.h>
+
+
+#define EPSILON      1e-6f
+
+#define SAFE_DIV_MIN EPSILON
+#define SAFE_DIV_MAX (1.0f / SAFE_DIV_MIN)
+
+
+/*  the blend functions below process two RGBA pixels per vector, with
+ *  the same operations in the same order as the plain C versions in
+ *  gimpoperationlayermode-blend.c, so they give identical results.
+ *  this file is built without -mfma, so no operations get fused.
+ */
+
+typedef __m256 vfloat;
+
+#define v_set1(f)    _mm256_set1_ps (f)
+#define v_add(a, b)  _mm256_add_ps (a, b)
+#define v_sub(a, b)  _mm256_sub_ps (a, b)
+#define v_mul(a, b)  _mm256_mul_ps (a, b)
+#define v_div(a, b)  _mm256_div_ps (a, b)
+#define v_min(a, b)  _mm256_min_ps (a, b)
+#define v_max(a, b)  _mm256_max_ps (a, b)
+#define v_lt(a, b)   _mm256_cmp_ps (a, b, _CMP_LT_OQ)
+#define v_gt(a, b)   _mm256_cmp_ps (a, b, _CMP_GT_OQ)
+#define v_le(a, b)   _mm256_cmp_ps (a, b, _CMP_LE_OQ)
+
+
+static inline vfloat
+v_select (vfloat mask,
+          vfloat a,
+          vfloat b)
+{
+  return _mm256_blendv_ps (b, a, mask);
+}
+
+static inline vfloat
+v_abs (vfloat a)
+{
+  return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), a);
+}
+
+/* see safe_div() in gimpoperationlayermode-blend.c */
+static inline vfloat
+v_safe_div (vfloat a,
+            vfloat b)
+{
+  vfloat result;
+
+  result = v_div (a, b);
+  result = v_max (v_min (result, v_set1 (SAFE_DIV_MAX)),
+                  v_set1 (-SAFE_DIV_MAX));
+
+  return _mm256_and_ps (v_gt (v_abs (a), v_set1 (SAFE_DIV_MIN)), result);
+}
+
+
+/*  blend kernels  */
+
+static inline vfloat
+blend_addition (vfloat in,
+                vfloat layer)
+{
+  return v_add (in, layer);
+}
+
+static inline vfloat
+blend_burn (vfloat in,
+            vfloat layer)
+{
+  return v_sub (v_set1 (1.0f), v_safe_div (v_sub (v_set1 (1.0f), in), layer));
+}
+
+static inline vfloat
+blend_darken_only (vfloat in,
+                   vfloat layer)
+{
+  return v_min (in, layer);
+}
+
+static inline vfloat
+blend_difference (vfloat in,
+                  vfloat layer)
+{
+  return v_abs (v_sub (in, layer));
+}
+
+static inline vfloat
+blend_divide (vfloat in,
+              vfloat layer)
+{
+  return v_safe_div (in, layer);
+}
+
+static inline vfloat
+blend_dodge (vfloat in,
+             vfloat layer)
+{
+  return v_safe_div (in, v_sub (v_set1 (1.0f), layer));
+}
+
+static inline vfloat
+blend_exclusion (vfloat in,
+                 vfloat layer)
+{
+  const vfloat half = v_set1 (0.5f);
+
+  return v_sub (half, v_mul (v_mul (v_set1 (2.0f), v_sub (in, half)),
+                             v_sub (layer, half)));
+}
+
+static inline vfloat
+blend_grain_extract (vfloat in,
+                     vfloat layer)
+{
+  return v_add (v_sub (in, layer), v_set1 (0.5f));
+}
+
+static inline vfloat
+blend_grain_merge (vfloat in,
+                   vfloat layer)
+{
+  return v_sub (v_add (in, layer), v_set1 (0.5f));
+}
+
+static inline vfloat
+blend_hard_mix (vfloat in,
+                vfloat layer)
+{
+  return v_select (v_lt (v_add (in, layer), v_set1 (1.0f)),
+                   v_set1 (0.0f), v_set1 (1.0f));
+}
+
+static inline vfloat
+blend_hardlight (vfloat in,
+                 vfloat layer)
+{
+  const vfloat one = v_set1 (1.0f);
+  const vfloat two = v_set1 (2.0f);
+  vfloat       high;
+  vfloat       low;
+
+  high = v_mul (v_sub (one, in),
+                v_sub (one, v_mul (v_sub (layer, v_set1 (0.5f)), two)));
+  high = v_min (v_sub (one, high), one);
+
+  low  = v_min (v_mul (in, v_mul (layer, two)), one);
+
+  return v_select (v_gt (layer, v_set1 (0.5f)), high, low);
+}
+
+static inline vfloat
+blend_lighten_only (vfloat in,
+                    vfloat layer)
+{
+  return v_max (in, layer);
+}
+
+static inline vfloat
+blend_linear_burn (vfloat in,
+                   vfloat layer)
+{
+  return v_sub (v_add (in, layer), v_set1 (1.0f));
+}
+
+static inline vfloat
+blend_linear_light (vfloat in,
+                    vfloat layer)
+{
+  const vfloat two = v_set1 (2.0f);
+  vfloat       low;
+  vfloat       high;
+
+  low  = v_sub (v_add (in, v_mul (two, layer)), v_set1 (1.0f));
+  high = v_add (in, v_mul (two, v_sub (layer, v_set1 (0.5f))));
+
+  return v_select (v_le (layer, v_set1 (0.5f)), low, high);
+}
+
+static inline vfloat
+blend_multiply (vfloat in,
+                vfloat layer)
+{
+  return v_mul (in, layer);
+}
+
+static inline vfloat
+blend_overlay (vfloat in,
+               vfloat layer)
+{
+  const vfloat one = v_set1 (1.0f);
+  const vfloat two = v_set1 (2.0f);
+  vfloat       low;
+  vfloat       high;
+
+  low  = v_mul (v_mul (two, in), layer);
+  high = v_sub (one, v_mul (v_mul (two, v_sub (one, layer)),
+                            v_sub (one, in)));
+
+  return v_select (v_lt (in, v_set1 (0.5f)), low, high);
+}
+
+static inline vfloat
+blend_pin_light (vfloat in,
+                 vfloat layer)
+{
+  const vfloat two = v_set1 (2.0f);
+  vfloat       high;
+  vfloat       low;
+
+  high = v_max (in, v_mul (two, v_sub (layer, v_set1 (0.5f))));
+  low  = v_min (in, v_mul (two, layer));
+
+  return v_select (v_gt (layer, v_set1 (0.5f)), high, low);
+}
+
+static inline vfloat
+blend_screen (vfloat in,
+              vfloat layer)
+{
+  const vfloat one = v_set1 (1.0f);
+
+  return v_sub (one, v_mul (v_sub (one, in), v_sub (one, layer)));
+}
+
+static inline vfloat
+blend_softlight (vfloat in,
+                 vfloat layer)
+{
+  const vfloat one = v_set1 (1.0f);
+  vfloat       multiply;
+  vfloat       screen;
+
+  multiply = v_mul (in, layer);
+  screen   = v_sub (one, v_mul (v_sub (one, in), v_sub (one, layer)));
+
+  return v_add (v_mul (v_sub (one, in), multiply), v_mul (in, screen));
+}
+
+static inline vfloat
+blend_subtract (vfloat in,
+                vfloat layer)
+{
+  return v_sub (in, layer);
+}
+
+static inline vfloat
+blend_vivid_light (vfloat in,
+                   vfloat layer)
+{
+  const vfloat one = v_set1 (1.0f);
+  const vfloat two = v_set1 (2.0f);
+  vfloat       low;
+  vfloat       high;
+
+  low  = v_sub (one, v_safe_div (v_sub (one, in), v_mul (two, layer)));
+  low  = v_max (low, v_set1 (0.0f));
+
+  high = v_safe_div (in, v_mul (two, v_sub (one, layer)));
+  high = v_min (high, one);
+
+  return v_select (v_le (layer, v_set1 (0.5f)), low, high);
+}
+
+#define DEFINE_BLEND_FUNCTION(name)                                        \
+void                                                                       \
+gimp_operation_layer_mode_blend_##name##_avx2 (GeglOperation *operation,   \
+                                               const gfloat  *in,          \
+                                               const gfloat  *layer,       \
+                                               gfloat        *comp,        \
+                                               gint           samples)     \
+{                                                                          \
+  const vfloat alpha_mask = _mm256_castsi256_ps (                          \
+    _mm256_set_epi32 (-1, 0, 0, 0, -1, 0, 0, 0));                          \
+                                                                           \
+  for (; samples >= 2; samples -= 2)                                       \
+    {                                                                      \
+      vfloat v_in    = _mm256_loadu_ps (in);                               \
+      vfloat v_layer = _mm256_loadu_ps (layer);                            \
+                                                                           \
+      _mm256_storeu_ps (comp, v_select (alpha_mask,                        \
+                                        v_layer,                           \
+                                        blend_##name (v_in, v_layer)));    \
+                                                                           \
+      comp  += 8;                                                          \
+      layer += 8;                                                          \
+      in    += 8;                                                          \
+    }                                                                      \
+                                                                           \
+  if (samples)                                                             \
+    {                                                                      \
+      const __m256i tail_mask = _mm256_set_epi32 (0, 0, 0, 0,              \
+                                                  -1, -1, -1, -1);         \
+      vfloat        v_in      = _mm256_maskload_ps (in,    tail_mask);     \
+      vfloat        v_layer   = _mm256_maskload_ps (layer, tail_mask);     \
+                                                                           \
+      _mm256_maskstore_ps (comp, tail_mask,                                \
+                           v_select (alpha_mask,                           \
+                                     v_layer,                              \
+                                     blend_##name (v_in, v_layer)));       \
+    }                                                                      \
+}
+
+
+/*  public functions  */
+
+DEFINE_BLEND_FUNCTION (addition)
+DEFINE_BLEND_FUNCTION (burn)
+DEFINE_BLEND_FUNCTION (darken_only)
+DEFINE_BLEND_FUNCTION (difference)
+DEFINE_BLEND_FUNCTION (divide)
+DEFINE_BLEND_FUNCTION (dodge)
+DEFINE_BLEND_FUNCTION (exclusion)
+DEFINE_BLEND_FUNCTION (grain_extract)
+DEFINE_BLEND_FUNCTION (grain_merge)
+DEFINE_BLEND_FUNCTION (hard_mix)
+DEFINE_BLEND_FUNCTION (hardlight)
+DEFINE_BLEND_FUNCTION (lighten_only)
+DEFINE_BLEND_FUNCTION (linear_burn)
+DEFINE_BLEND_FUNCTION (linear_light)
+DEFINE_BLEND_FUNCTION (multiply)
+DEFINE_BLEND_FUNCTION (overlay)
+DEFINE_BLEND_FUNCTION (pin_light)
+DEFINE_BLEND_FUNCTION (screen)
+DEFINE_BLEND_FUNCTION (softlight)
+DEFINE_BLEND_FUNCTION (subtract)
+DEFINE_BLEND_FUNCTION (vivid_light)
+
+/*  returns the AVX2 version of blend_function, or NULL if there is none  */
+GimpLayerModeBlendFunc
+gimp_operation_layer_mode_blend_get_avx2 (GimpLayerModeBlendFunc blend_function)
+{
+  static const struct
+  {
+    GimpLayerModeBlendFunc blend_function;
+    GimpLayerModeBlendFunc avx2_function;
+  }
+  functions[] =
+  {
+    { gimp_operation_layer_mode_blend_addition,
+      gimp_operation_layer_mode_blend_addition_avx2 },
+    { gimp_operation_layer_mode_blend_burn,
+      gimp_operation_layer_mode_blend_burn_avx2 },
+    { gimp_operation_layer_mode_blend_darken_only,
+      gimp_operation_layer_mode_blend_darken_only_avx2 },
+    { gimp_operation_layer_mode_blend_difference,
+      gimp_operation_layer_mode_blend_difference_avx2 },
+    { gimp_operation_layer_mode_blend_divide,
+      gimp_operation_layer_mode_blend_divide_avx2 },
+    { gimp_operation_layer_mode_blend_dodge,
+      gimp_operation_layer_mode_blend_dodge_avx2 },
+    { gimp_operation_layer_mode_blend_exclusion,
+      gimp_operation_layer_mode_blend_exclusion_avx2 },
+    { gimp_operation_layer_mode_blend_grain_extract,
+      gimp_operation_layer_mode_blend_grain_extract_avx2 },
+    { gimp_operation_layer_mode_blend_grain_merge,
+      gimp_operation_layer_mode_blend_grain_merge_avx2 },
+    { gimp_operation_layer_mode_blend_hard_mix,
+      gimp_operation_layer_mode_blend_hard_mix_avx2 },
+    { gimp_operation_layer_mode_blend_hardlight,
+      gimp_operation_layer_mode_blend_hardlight_avx2 },
+    { gimp_operation_layer_mode_blend_lighten_only,
+      gimp_operation_layer_mode_blend_lighten_only_avx2 },
+    { gimp_operation_layer_mode_blend_linear_burn,
+      gimp_operation_layer_mode_blend_linear_burn_avx2 },
+    { gimp_operation_layer_mode_blend_linear_light,
+      gimp_operation_layer_mode_blend_linear_light_avx2 },
+    { gimp_operation_layer_mode_blend_multiply,
+      gimp_operation_layer_mode_blend_multiply_avx2 },
+    { gimp_operation_layer_mode_blend_overlay,
+      gimp_operation_layer_mode_blend_overlay_avx2 },
+    { gimp_operation_layer_mode_blend_pin_light,
+      gimp_operation_layer_mode_blend_pin_light_avx2 },
+    { gimp_operation_layer_mode_blend_screen,
+      gimp_operation_layer_mode_blend_screen_avx2 },
+    { gimp_operation_layer_mode_blend_softlight,
+      gimp_operation_layer_mode_blend_softlight_avx2 },
+    { gimp_operation_layer_mode_blend_subtract,
+      gimp_operation_layer_mode_blend_subtract_avx2 },
+    { gimp_operation_layer_mode_blend_vivid_light,
+      gimp_operation_layer_mode_blend_vivid_light_avx2 }
+  };
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (functions); i++)
+    {
+      if (functions[i].blend_function == blend_function)
+        return functions[i].avx2_function;
+    }
+
+  return NULL;
+}
+
+#endif /* COMPILE_AVX2_INTRINISICS */
@@ -72,6 +72,34 @@ safe_div (gfloat a,
 /*  public functions  */
 
 
+/*  returns the fastest version of blend_function the CPU supports,
+ *  which is blend_function itself if there is no SIMD version of it.
+ */
+GimpLayerModeBlendFunc
+gimp_operation_layer_mode_blend_get_accelerated (GimpLayerModeBlendFunc blend_function)
+{
+  GimpLayerModeBlendFunc accelerated = NULL;
+
+#if COMPILE_AVX2_INTRINISICS
+  if (! accelerated &&
+      (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_AVX2))
+    {
+      accelerated = gimp_operation_layer_mode_blend_get_avx2 (blend_function);
+    }
+#endif
+
+#if COMPILE_SSE2_INTRINISICS
+  if (! accelerated &&
+      (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_SSE2))
+    {
+      accelerated = gimp_operation_layer_mode_blend_get_sse2 (blend_function);
+    }
+#endif
+
+  return accelerated ? accelerated : blend_function;
+}
+
+
 /*  non-subtractive blending functions.  these functions must set comp[ALPHA]
  *  to the same value as layer[ALPHA].  when in[ALPHA] or layer[ALPHA] are
  *  zero, the value of comp[RED..BLUE] is unconstrained (in particular, it may
@@ -222,4 +222,236 @@ void gimp_operation_layer_mode_blend_color_erase       (GeglOperation *operation
                                                         gint           samples);
 
 
+/*  SIMD versions, see gimp_operation_layer_mode_blend_get_accelerated()  */
+
+GimpLayerModeBlendFunc
+     gimp_operation_layer_mode_blend_get_accelerated (GimpLayerModeBlendFunc blend_function);
+
+#if COMPILE_SSE2_INTRINISICS
+
+void gimp_operation_layer_mode_blend_addition_sse2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_burn_sse2          (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_darken_only_sse2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_difference_sse2    (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_divide_sse2        (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_dodge_sse2         (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_exclusion_sse2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_grain_extract_sse2 (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_grain_merge_sse2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_hard_mix_sse2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_hardlight_sse2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_lighten_only_sse2  (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_linear_burn_sse2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_linear_light_sse2  (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_multiply_sse2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_overlay_sse2       (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_pin_light_sse2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_screen_sse2        (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_softlight_sse2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_subtract_sse2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_vivid_light_sse2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+
+GimpLayerModeBlendFunc
+     gimp_operation_layer_mode_blend_get_sse2 (GimpLayerModeBlendFunc blend_function);
+
+#endif /* COMPILE_SSE2_INTRINISICS */
+
+#if COMPILE_AVX2_INTRINISICS
+
+void gimp_operation_layer_mode_blend_addition_avx2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_burn_avx2          (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_darken_only_avx2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_difference_avx2    (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_divide_avx2        (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_dodge_avx2         (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_exclusion_avx2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_grain_extract_avx2 (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_grain_merge_avx2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_hard_mix_avx2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_hardlight_avx2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_lighten_only_avx2  (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_linear_burn_avx2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_linear_light_avx2  (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_multiply_avx2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_overlay_avx2       (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_pin_light_avx2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_screen_avx2        (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_softlight_avx2     (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_subtract_avx2      (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+void gimp_operation_layer_mode_blend_vivid_light_avx2   (GeglOperation *operation,
+                                                         const gfloat  *in,
+                                                         const gfloat  *layer,
+                                                         gfloat        *comp,
+                                                         gint           samples);
+
+GimpLayerModeBlendFunc
+     gimp_operation_layer_mode_blend_get_avx2 (GimpLayerModeBlendFunc blend_function);
+
+#endif /* COMPILE_AVX2_INTRINISICS */
+
+
 #endif /* __GIMP_OPERATION_LAYER_MODE_BLEND_H__ */
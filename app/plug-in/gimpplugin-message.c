@@ -32,6 +32,8 @@
 
 #include "plug-in-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-tile-compat.h"
 
@@ -63,8 +65,36 @@ static void gimp_plug_in_handle_tile_put         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
 static void gimp_plug_in_handle_tile_get         (GimpPlugIn      *plug_in,
                                                   GPTileReq       *request);
+static void gimp_plug_in_handle_tile_range_request
+                                                 (GimpPlugIn      *plug_in,
+                                                  GPTileRangeReq  *request);
+static void gimp_plug_in_handle_tile_range_put   (GimpPlugIn      *plug_in,
+                                                  GPTileRangeReq  *request);
+static void gimp_plug_in_handle_tile_range_get   (GimpPlugIn      *plug_in,
+                                                  GPTileRangeReq  *request);
+static void gimp_plug_in_handle_buffer_map       (GimpPlugIn      *plug_in,
+                                                  GPBufferMapReq  *request);
+static void gimp_plug_in_handle_buffer_unmap     (GimpPlugIn      *plug_in,
+                                                  GPBufferUnmap   *unmap);
+static GeglBuffer *
+            gimp_plug_in_get_tile_buffer         (GimpPlugIn      *plug_in,
+                                                  gint32           drawable_id,
+                                                  gboolean         shadow,
+                                                  gboolean         write);
+static gboolean
+            gimp_plug_in_get_tile_range_rects    (GeglBuffer      *buffer,
+                                                  guint            tile_num,
+                                                  guint            n_tiles,
+                                                  gsize            max_length,
+                                                  GeglRectangle   *rects,
+                                                  gsize           *length);
+static GimpValueArray *
+            gimp_plug_in_run_proc                (GimpPlugIn      *plug_in,
+                                                  GPProcRun       *proc_run);
 static void gimp_plug_in_handle_proc_run         (GimpPlugIn      *plug_in,
                                                   GPProcRun       *proc_run);
+static void gimp_plug_in_handle_proc_run_batch   (GimpPlugIn      *plug_in,
+                                                  GPProcRunBatch  *proc_run_batch);
 static void gimp_plug_in_handle_proc_return      (GimpPlugIn      *plug_in,
                                                   GPProcReturn    *proc_return);
 static void gimp_plug_in_handle_temp_proc_return (GimpPlugIn      *plug_in,
@@ -160,6 +190,49 @@ gimp_plug_in_handle_message (GimpPlugIn      *plug_in,
     case GP_HAS_INIT:
       gimp_plug_in_handle_has_init (plug_in);
       break;
+
+    case GP_TILE_RANGE_REQ:
+      gimp_plug_in_handle_tile_range_request (plug_in, msg->data);
+      break;
+
+    case GP_TILE_RANGE_DATA:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a TILE_RANGE_DATA message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
+
+    case GP_BUFFER_MAP_REQ:
+      gimp_plug_in_handle_buffer_map (plug_in, msg->data);
+      break;
+
+    case GP_BUFFER_MAP_DATA:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a BUFFER_MAP_DATA message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
+
+    case GP_BUFFER_UNMAP:
+      gimp_plug_in_handle_buffer_unmap (plug_in, msg->data);
+      break;
+
+    case GP_PROC_RUN_BATCH:
+      gimp_plug_in_handle_proc_run_batch (plug_in, msg->data);
+      break;
+
+    case GP_PROC_RETURN_BATCH:
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a PROC_RETURN_BATCH message.  This should not happen.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      break;
     }
 }
 
@@ -191,7 +264,6 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
   GPTileData       tile_data;
   GPTileData      *tile_info;
   GimpWireMessage  msg;
-  GimpDrawable    *drawable;
   GeglBuffer      *buffer;
   const Babl      *format;
   GeglRectangle    tile_rect;
@@ -231,73 +303,16 @@ gimp_plug_in_handle_tile_put (GimpPlugIn *plug_in,
 
   tile_info = msg.data;
 
-  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
-                                                   tile_info->drawable_id);
-
-  if (! GIMP_IS_DRAWABLE (drawable))
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         tile_info->drawable_id,
+                                         tile_info->shadow,
+                                         TRUE);
+  if (! buffer)
     {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried writing to invalid drawable %d (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    tile_info->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried writing to drawable %d which was removed "
-                    "from the image (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    tile_info->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
+      gimp_wire_destroy (&msg);
       return;
     }
 
-  if (tile_info->shadow)
-    {
-
-      /*  don't check whether the drawable is a group or locked here,
-       *  the plugin will get a proper error message when it tries to
-       *  merge the shadow tiles, which is much better than just
-       *  killing it.
-       */
-      buffer = gimp_drawable_get_shadow_buffer (drawable);
-
-      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
-    }
-  else
-    {
-      if (gimp_item_is_content_locked (GIMP_ITEM (drawable), NULL))
-        {
-          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        "Plug-in \"%s\"\n(%s)\n\n"
-                        "tried writing to a locked drawable %d (killing)",
-                        gimp_object_get_name (plug_in),
-                        gimp_file_get_utf8_name (plug_in->file),
-                        tile_info->drawable_id);
-          gimp_plug_in_close (plug_in, TRUE);
-          return;
-        }
-      else if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
-        {
-          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                        "Plug-in \"%s\"\n(%s)\n\n"
-                        "tried writing to a group layer %d (killing)",
-                        gimp_object_get_name (plug_in),
-                        gimp_file_get_utf8_name (plug_in->file),
-                        tile_info->drawable_id);
-          gimp_plug_in_close (plug_in, TRUE);
-          return;
-        }
-
-      buffer = gimp_drawable_get_buffer (drawable);
-    }
-
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
                                         GIMP_PLUG_IN_TILE_HEIGHT,
@@ -346,49 +361,17 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
 {
   GPTileData       tile_data;
   GimpWireMessage  msg;
-  GimpDrawable    *drawable;
   GeglBuffer      *buffer;
   const Babl      *format;
   GeglRectangle    tile_rect;
   gint             tile_size;
 
-  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
-                                                   request->drawable_id);
-
-  if (! GIMP_IS_DRAWABLE (drawable))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried reading from invalid drawable %d (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
-    {
-      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
-                    "Plug-in \"%s\"\n(%s)\n\n"
-                    "tried reading from drawable %d which was removed "
-                    "from the image (killing)",
-                    gimp_object_get_name (plug_in),
-                    gimp_file_get_utf8_name (plug_in->file),
-                    request->drawable_id);
-      gimp_plug_in_close (plug_in, TRUE);
-      return;
-    }
-
-  if (request->shadow)
-    {
-      buffer = gimp_drawable_get_shadow_buffer (drawable);
-
-      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
-    }
-  else
-    {
-      buffer = gimp_drawable_get_buffer (drawable);
-    }
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         request->drawable_id,
+                                         request->shadow,
+                                         FALSE);
+  if (! buffer)
+    return;
 
   if (! gimp_gegl_buffer_get_tile_rect (buffer,
                                         GIMP_PLUG_IN_TILE_WIDTH,
@@ -461,6 +444,500 @@ gimp_plug_in_handle_tile_get (GimpPlugIn *plug_in,
   gimp_wire_destroy (&msg);
 }
 
+static void
+gimp_plug_in_handle_tile_range_request (GimpPlugIn     *plug_in,
+                                        GPTileRangeReq *request)
+{
+  g_return_if_fail (request != NULL);
+
+  if (request->drawable_id == -1)
+    gimp_plug_in_handle_tile_range_put (plug_in, request);
+  else
+    gimp_plug_in_handle_tile_range_get (plug_in, request);
+}
+
+static void
+gimp_plug_in_handle_tile_range_put (GimpPlugIn     *plug_in,
+                                    GPTileRangeReq *request)
+{
+  GPTileRangeData  tile_range_data = { 0, };
+  GPTileRangeData *tile_info;
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  GeglRectangle    tile_rects[GP_TILE_RANGE_MAX_TILES];
+  const guchar    *data;
+  gsize            max_length;
+  gsize            length;
+  gint             bpp;
+  guint            i;
+
+  tile_range_data.drawable_id = -1;
+  tile_range_data.use_shm     = (plug_in->manager->shm != NULL);
+
+  if (! gp_tile_range_data_write (plug_in->my_write, &tile_range_data,
+                                  plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (msg.type != GP_TILE_RANGE_DATA)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile range data and received: %d", msg.type);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  tile_info = msg.data;
+
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         tile_info->drawable_id,
+                                         tile_info->shadow,
+                                         TRUE);
+  if (! buffer)
+    {
+      gimp_wire_destroy (&msg);
+      return;
+    }
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  if (tile_range_data.use_shm)
+    max_length = gimp_plug_in_shm_get_size (plug_in->manager->shm);
+  else
+    max_length = G_MAXUINT32;
+
+  if (tile_info->bpp != bpp                                       ||
+      ! gimp_plug_in_get_tile_range_rects (buffer,
+                                           tile_info->tile_num,
+                                           tile_info->n_tiles,
+                                           max_length,
+                                           tile_rects, &length) ||
+      tile_info->length != length)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "requested invalid tile range #%d (%d tiles) "
+                    "for writing (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    tile_info->tile_num, tile_info->n_tiles);
+      gimp_wire_destroy (&msg);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (tile_range_data.use_shm)
+    data = gimp_plug_in_shm_get_addr (plug_in->manager->shm);
+  else
+    data = tile_info->data;
+
+  for (i = 0; i < tile_info->n_tiles; i++)
+    {
+      gegl_buffer_set (buffer, &tile_rects[i], 0, format,
+                       data, GEGL_AUTO_ROWSTRIDE);
+
+      data += tile_rects[i].width * tile_rects[i].height * bpp;
+    }
+
+  gimp_wire_destroy (&msg);
+
+  if (! gp_tile_ack_write (plug_in->my_write, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+}
+
+static void
+gimp_plug_in_handle_tile_range_get (GimpPlugIn     *plug_in,
+                                    GPTileRangeReq *request)
+{
+  GPTileRangeData  tile_range_data = { 0, };
+  GimpWireMessage  msg;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  GeglRectangle    tile_rects[GP_TILE_RANGE_MAX_TILES];
+  guchar          *data;
+  gsize            max_length;
+  gsize            length;
+  gint             bpp;
+  guint            i;
+
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         request->drawable_id,
+                                         request->shadow,
+                                         FALSE);
+  if (! buffer)
+    return;
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  tile_range_data.use_shm = (plug_in->manager->shm != NULL);
+
+  if (tile_range_data.use_shm)
+    max_length = gimp_plug_in_shm_get_size (plug_in->manager->shm);
+  else
+    max_length = G_MAXUINT32;
+
+  if (! gimp_plug_in_get_tile_range_rects (buffer,
+                                           request->tile_num,
+                                           request->n_tiles,
+                                           max_length,
+                                           tile_rects, &length))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "requested invalid tile range #%d (%d tiles) "
+                    "for reading (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    request->tile_num, request->n_tiles);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  tile_range_data.drawable_id = request->drawable_id;
+  tile_range_data.tile_num    = request->tile_num;
+  tile_range_data.n_tiles     = request->n_tiles;
+  tile_range_data.shadow      = request->shadow;
+  tile_range_data.bpp         = bpp;
+  tile_range_data.length      = length;
+
+  if (tile_range_data.use_shm)
+    {
+      data = gimp_plug_in_shm_get_addr (plug_in->manager->shm);
+    }
+  else
+    {
+      tile_range_data.data = g_malloc (length);
+
+      data = tile_range_data.data;
+    }
+
+  for (i = 0; i < request->n_tiles; i++)
+    {
+      gegl_buffer_get (buffer, &tile_rects[i], 1.0, format,
+                       data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      data += tile_rects[i].width * tile_rects[i].height * bpp;
+    }
+
+  if (! gp_tile_range_data_write (plug_in->my_write, &tile_range_data,
+                                  plug_in))
+    {
+      g_free (tile_range_data.data);
+
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  g_free (tile_range_data.data);
+
+  if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  if (msg.type != GP_TILE_ACK)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "expected tile ack and received: %d", msg.type);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  gimp_wire_destroy (&msg);
+}
+
+static void
+gimp_plug_in_handle_buffer_map (GimpPlugIn     *plug_in,
+                                GPBufferMapReq *request)
+{
+  GPBufferMapData  buffer_map_data = { 0, };
+  GimpPlugInShm   *shm             = NULL;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  GeglRectangle    extent;
+  gint             bpp;
+  guint64          size;
+
+  g_return_if_fail (request != NULL);
+
+  buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                         request->drawable_id,
+                                         request->shadow,
+                                         FALSE);
+  if (! buffer)
+    return;
+
+  format = gegl_buffer_get_format (buffer);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+  extent = *gegl_buffer_get_extent (buffer);
+
+  buffer_map_data.drawable_id = request->drawable_id;
+  buffer_map_data.shadow      = request->shadow;
+  buffer_map_data.map_id      = -1;
+  buffer_map_data.width       = extent.width;
+  buffer_map_data.height      = extent.height;
+  buffer_map_data.bpp         = bpp;
+
+  size = (guint64) extent.width * extent.height * bpp;
+
+  /*  it is not an error if the buffer can't be mapped, the plug-in
+   *  then simply falls back to tiles.  All of a plug-in's mappings
+   *  together may not take more memory than the tile cache, so a
+   *  plug-in can't make us allocate arbitrary amounts of it
+   */
+  if (plug_in->manager->gimp->use_shm &&
+      size > 0                         &&
+      size <= G_MAXSIZE                &&
+      plug_in->buffer_maps_size + size <=
+      GIMP_GEGL_CONFIG (plug_in->manager->gimp->config)->tile_cache_size)
+    {
+      shm = gimp_plug_in_shm_new_for_buffer (size);
+    }
+
+  if (shm)
+    {
+      gegl_buffer_get (buffer, &extent, 1.0, format,
+                       gimp_plug_in_shm_get_addr (shm),
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      gimp_plug_in_add_buffer_map (plug_in, shm,
+                                   request->drawable_id, request->shadow,
+                                   &extent, bpp);
+
+      buffer_map_data.map_id   = gimp_plug_in_shm_get_id (shm);
+      buffer_map_data.map_name = (gchar *) gimp_plug_in_shm_get_name (shm);
+    }
+
+  if (! gp_buffer_map_data_write (plug_in->my_write, &buffer_map_data,
+                                  plug_in))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "%s: ERROR", G_STRFUNC);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+}
+
+static void
+gimp_plug_in_handle_buffer_unmap (GimpPlugIn    *plug_in,
+                                  GPBufferUnmap *unmap)
+{
+  GimpPlugInBufferMap *map;
+  GeglBuffer          *buffer;
+  GeglRectangle        rect;
+
+  g_return_if_fail (unmap != NULL);
+
+  map = gimp_plug_in_find_buffer_map (plug_in, unmap->map_id);
+
+  if (! map)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried to unmap invalid buffer mapping %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    unmap->map_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  /*  the plug-in's linear buffer starts at 0, 0  */
+  rect.x      = map->extent.x + unmap->x;
+  rect.y      = map->extent.y + unmap->y;
+  rect.width  = unmap->width;
+  rect.height = unmap->height;
+
+  if (! gegl_rectangle_is_empty (&rect))
+    {
+      const GeglRectangle *extent;
+      const Babl          *format;
+      gint                 rowstride;
+      guchar              *data;
+
+      buffer = gimp_plug_in_get_tile_buffer (plug_in,
+                                             map->drawable_id,
+                                             map->shadow,
+                                             TRUE);
+      if (! buffer)
+        return;
+
+      extent = gegl_buffer_get_extent (buffer);
+      format = gegl_buffer_get_format (buffer);
+
+      /*  the drawable must not have changed while it was mapped, the
+       *  plug-in's view of it would be garbage otherwise
+       */
+      if (! gegl_rectangle_equal (extent, &map->extent)        ||
+          babl_format_get_bytes_per_pixel (format) != map->bpp ||
+          ! gegl_rectangle_contains (&map->extent, &rect))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing back an invalid area of buffer "
+                        "mapping %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        unmap->map_id);
+          gimp_plug_in_close (plug_in, TRUE);
+          return;
+        }
+
+      rowstride = map->extent.width * map->bpp;
+      data      = (gimp_plug_in_shm_get_addr (map->shm) +
+                   (gsize) unmap->y * rowstride +
+                   (gsize) unmap->x * map->bpp);
+
+      gegl_buffer_set (buffer, &rect, 0, format, data, rowstride);
+    }
+
+  gimp_plug_in_remove_buffer_map (plug_in, map);
+}
+
+/*  Looks up the buffer a plug-in wants to transfer tiles from or to,
+ *  closes the plug-in and returns NULL if it is not allowed to.
+ */
+static GeglBuffer *
+gimp_plug_in_get_tile_buffer (GimpPlugIn *plug_in,
+                              gint32      drawable_id,
+                              gboolean    shadow,
+                              gboolean    write)
+{
+  GimpDrawable *drawable;
+
+  drawable = (GimpDrawable *) gimp_item_get_by_id (plug_in->manager->gimp,
+                                                   drawable_id);
+
+  if (! GIMP_IS_DRAWABLE (drawable))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried %s invalid drawable %d (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    write ? "writing to" : "reading from",
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+  else if (gimp_item_is_removed (GIMP_ITEM (drawable)))
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "tried %s drawable %d which was removed "
+                    "from the image (killing)",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file),
+                    write ? "writing to" : "reading from",
+                    drawable_id);
+      gimp_plug_in_close (plug_in, TRUE);
+      return NULL;
+    }
+
+  if (shadow)
+    {
+      /*  don't check whether the drawable is a group or locked here,
+       *  the plugin will get a proper error message when it tries to
+       *  merge the shadow tiles, which is much better than just
+       *  killing it.
+       */
+      gimp_plug_in_cleanup_add_shadow (plug_in, drawable);
+
+      return gimp_drawable_get_shadow_buffer (drawable);
+    }
+
+  if (write)
+    {
+      if (gimp_item_is_content_locked (GIMP_ITEM (drawable), NULL))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing to a locked drawable %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        drawable_id);
+          gimp_plug_in_close (plug_in, TRUE);
+          return NULL;
+        }
+      else if (gimp_viewable_get_children (GIMP_VIEWABLE (drawable)))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "tried writing to a group layer %d (killing)",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file),
+                        drawable_id);
+          gimp_plug_in_close (plug_in, TRUE);
+          return NULL;
+        }
+    }
+
+  return gimp_drawable_get_buffer (drawable);
+}
+
+/*  Computes the rectangles of a range of tiles and the length of
+ *  their pixel data, returns FALSE if the range is invalid or doesn't
+ *  fit into max_length bytes.
+ */
+static gboolean
+gimp_plug_in_get_tile_range_rects (GeglBuffer    *buffer,
+                                   guint          tile_num,
+                                   guint          n_tiles,
+                                   gsize          max_length,
+                                   GeglRectangle *rects,
+                                   gsize         *length)
+{
+  gint  bpp = babl_format_get_bytes_per_pixel (gegl_buffer_get_format (buffer));
+  guint i;
+
+  *length = 0;
+
+  if (n_tiles < 1 || n_tiles > GP_TILE_RANGE_MAX_TILES)
+    return FALSE;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      if (! gimp_gegl_buffer_get_tile_rect (buffer,
+                                            GIMP_PLUG_IN_TILE_WIDTH,
+                                            GIMP_PLUG_IN_TILE_HEIGHT,
+                                            tile_num + i,
+                                            &rects[i]))
+        {
+          return FALSE;
+        }
+
+      *length += (gsize) rects[i].width * rects[i].height * bpp;
+    }
+
+  return *length <= max_length;
+}
+
 static void
 gimp_plug_in_handle_proc_error (GimpPlugIn          *plug_in,
                                 GimpPlugInProcFrame *proc_frame,
@@ -496,9 +973,14 @@ gimp_plug_in_handle_proc_error (GimpPlugIn          *plug_in,
     }
 }
 
-static void
-gimp_plug_in_handle_proc_run (GimpPlugIn *plug_in,
-                              GPProcRun  *proc_run)
+/*  Runs the procedure called by @proc_run, and returns its return
+ *  values.  Check that the plug-in is still open before sending them,
+ *  since executing the procedure may have closed it (e.g. if the
+ *  procedure is gimp-quit).
+ */
+static GimpValueArray *
+gimp_plug_in_run_proc (GimpPlugIn *plug_in,
+                       GPProcRun  *proc_run)
 {
   GimpPlugInProcFrame *proc_frame;
   gchar               *canonical;
@@ -508,9 +990,6 @@ gimp_plug_in_handle_proc_run (GimpPlugIn *plug_in,
   GimpValueArray      *return_vals = NULL;
   GError              *error       = NULL;
 
-  g_return_if_fail (proc_run != NULL);
-  g_return_if_fail (proc_run->name != NULL);
-
   canonical = gimp_canonicalize_identifier (proc_run->name);
 
   proc_frame = gimp_plug_in_get_proc_frame (plug_in);
@@ -602,6 +1081,20 @@ gimp_plug_in_handle_proc_run (GimpPlugIn *plug_in,
 
   g_free (canonical);
 
+  return return_vals;
+}
+
+static void
+gimp_plug_in_handle_proc_run (GimpPlugIn *plug_in,
+                              GPProcRun  *proc_run)
+{
+  GimpValueArray *return_vals;
+
+  g_return_if_fail (proc_run != NULL);
+  g_return_if_fail (proc_run->name != NULL);
+
+  return_vals = gimp_plug_in_run_proc (plug_in, proc_run);
+
   /*  Don't bother to send the return value if executing the procedure
    *  closed the plug-in (e.g. if the procedure is gimp-quit)
    */
@@ -630,6 +1123,84 @@ gimp_plug_in_handle_proc_run (GimpPlugIn *plug_in,
   gimp_value_array_unref (return_vals);
 }
 
+static void
+gimp_plug_in_handle_proc_run_batch (GimpPlugIn     *plug_in,
+                                    GPProcRunBatch *proc_run_batch)
+{
+  GPProcReturnBatch proc_return_batch;
+  gint              i;
+
+  /*  A NULL batch means it could not be read, e.g. because it had
+   *  more than GP_PROC_BATCH_MAX_CALLS calls
+   */
+  if (! proc_run_batch)
+    {
+      gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                    "Plug-in \"%s\"\n(%s)\n\n"
+                    "sent a malformed PROC_RUN_BATCH message.",
+                    gimp_object_get_name (plug_in),
+                    gimp_file_get_utf8_name (plug_in->file));
+      gimp_plug_in_close (plug_in, TRUE);
+      return;
+    }
+
+  proc_return_batch.n_procs = 0;
+  proc_return_batch.procs   = g_new0 (GPProcReturn, proc_run_batch->n_procs);
+
+  /*  Run the calls in order, exactly as if they had been sent one by
+   *  one, and send all their return values at once
+   */
+  for (i = 0; i < proc_run_batch->n_procs && plug_in->open; i++)
+    {
+      GPProcRun      *proc_run    = &proc_run_batch->procs[i];
+      GPProcReturn   *proc_return = &proc_return_batch.procs[i];
+      GimpValueArray *return_vals;
+
+      if (! proc_run->name)
+        break;
+
+      return_vals = gimp_plug_in_run_proc (plug_in, proc_run);
+
+      proc_return->name     = proc_run->name;
+      proc_return->n_params = gimp_value_array_length (return_vals);
+      proc_return->params   = _gimp_value_array_to_gp_params (return_vals,
+                                                              FALSE);
+
+      proc_return_batch.n_procs++;
+
+      gimp_value_array_unref (return_vals);
+    }
+
+  if (plug_in->open)
+    {
+      if (proc_return_batch.n_procs != proc_run_batch->n_procs)
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "Plug-in \"%s\"\n(%s)\n\n"
+                        "sent a malformed PROC_RUN_BATCH message.",
+                        gimp_object_get_name (plug_in),
+                        gimp_file_get_utf8_name (plug_in->file));
+          gimp_plug_in_close (plug_in, TRUE);
+        }
+      else if (! gp_proc_return_batch_write (plug_in->my_write,
+                                             &proc_return_batch, plug_in))
+        {
+          gimp_message (plug_in->manager->gimp, NULL, GIMP_MESSAGE_ERROR,
+                        "%s: ERROR", G_STRFUNC);
+          gimp_plug_in_close (plug_in, TRUE);
+        }
+    }
+
+  for (i = 0; i < proc_return_batch.n_procs; i++)
+    {
+      _gimp_gp_params_free (proc_return_batch.procs[i].params,
+                            proc_return_batch.procs[i].n_params,
+                            FALSE);
+    }
+
+  g_free (proc_return_batch.procs);
+}
+
 static void
 gimp_plug_in_handle_proc_return (GimpPlugIn   *plug_in,
                                  GPProcReturn *proc_return)
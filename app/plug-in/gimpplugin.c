@@ -89,6 +89,7 @@
 #include "gimpplugindef.h"
 #include "gimppluginmanager.h"
 #include "gimppluginmanager-help-domain.h"
+#include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 
 #include "gimp-intl.h"
@@ -158,6 +159,9 @@ gimp_plug_in_init (GimpPlugIn *plug_in)
 
   plug_in->temp_procedures    = NULL;
 
+  plug_in->buffer_maps        = NULL;
+  plug_in->buffer_maps_size   = 0;
+
   plug_in->ext_main_loop      = NULL;
 
   plug_in->temp_proc_frames   = NULL;
@@ -811,6 +815,12 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
   while (plug_in->temp_procedures)
     gimp_plug_in_remove_temp_proc (plug_in, plug_in->temp_procedures->data);
 
+  /* Drop any buffer mappings the plug-in didn't release, their
+   * contents are discarded like unflushed shadow tiles.
+   */
+  while (plug_in->buffer_maps)
+    gimp_plug_in_remove_buffer_map (plug_in, plug_in->buffer_maps->data);
+
   gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
 }
 
@@ -955,6 +965,67 @@ gimp_plug_in_remove_temp_proc (GimpPlugIn             *plug_in,
   g_object_unref (proc);
 }
 
+GimpPlugInBufferMap *
+gimp_plug_in_add_buffer_map (GimpPlugIn          *plug_in,
+                             GimpPlugInShm       *shm,
+                             gint32               drawable_id,
+                             gboolean             shadow,
+                             const GeglRectangle *extent,
+                             gint                 bpp)
+{
+  GimpPlugInBufferMap *map;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN (plug_in), NULL);
+  g_return_val_if_fail (shm != NULL, NULL);
+  g_return_val_if_fail (extent != NULL, NULL);
+
+  map = g_slice_new (GimpPlugInBufferMap);
+
+  map->shm         = shm;
+  map->drawable_id = drawable_id;
+  map->shadow      = shadow;
+  map->extent      = *extent;
+  map->bpp         = bpp;
+
+  plug_in->buffer_maps = g_list_prepend (plug_in->buffer_maps, map);
+  plug_in->buffer_maps_size += gimp_plug_in_shm_get_size (shm);
+
+  return map;
+}
+
+GimpPlugInBufferMap *
+gimp_plug_in_find_buffer_map (GimpPlugIn *plug_in,
+                              gint        map_id)
+{
+  GList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN (plug_in), NULL);
+
+  for (list = plug_in->buffer_maps; list; list = g_list_next (list))
+    {
+      GimpPlugInBufferMap *map = list->data;
+
+      if (gimp_plug_in_shm_get_id (map->shm) == map_id)
+        return map;
+    }
+
+  return NULL;
+}
+
+void
+gimp_plug_in_remove_buffer_map (GimpPlugIn          *plug_in,
+                                GimpPlugInBufferMap *map)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+  g_return_if_fail (map != NULL);
+
+  plug_in->buffer_maps = g_list_remove (plug_in->buffer_maps, map);
+  plug_in->buffer_maps_size -= gimp_plug_in_shm_get_size (map->shm);
+
+  gimp_plug_in_shm_free (map->shm);
+  g_slice_free (GimpPlugInBufferMap, map);
+}
+
 void
 gimp_plug_in_set_error_handler (GimpPlugIn          *plug_in,
                                 GimpPDBErrorHandler  handler)
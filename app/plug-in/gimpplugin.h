@@ -37,6 +37,15 @@
 
 typedef struct _GimpPlugInClass GimpPlugInClass;
 
+struct _GimpPlugInBufferMap
+{
+  GimpPlugInShm *shm;                   /*  Segment holding the pixels        */
+  gint32         drawable_id;
+  gboolean       shadow;
+  GeglRectangle  extent;                /*  Buffer extent at map time         */
+  gint           bpp;
+};
+
 struct _GimpPlugIn
 {
   GimpObject           parent_instance;
@@ -61,6 +70,9 @@ struct _GimpPlugIn
 
   GSList              *temp_procedures; /*  Temporary procedures              */
 
+  GList               *buffer_maps;     /*  Buffers mapped into the plug-in   */
+  guint64              buffer_maps_size; /* Their total size in bytes        */
+
   GMainLoop           *ext_main_loop;   /*  for waiting for extension_ack     */
 
   GimpPlugInProcFrame  main_proc_frame;
@@ -110,6 +122,19 @@ void          gimp_plug_in_add_temp_proc     (GimpPlugIn             *plug_in,
 void          gimp_plug_in_remove_temp_proc  (GimpPlugIn             *plug_in,
                                               GimpTemporaryProcedure *procedure);
 
+GimpPlugInBufferMap *
+              gimp_plug_in_add_buffer_map    (GimpPlugIn             *plug_in,
+                                              GimpPlugInShm          *shm,
+                                              gint32                  drawable_id,
+                                              gboolean                shadow,
+                                              const GeglRectangle    *extent,
+                                              gint                    bpp);
+GimpPlugInBufferMap *
+              gimp_plug_in_find_buffer_map   (GimpPlugIn             *plug_in,
+                                              gint                    map_id);
+void          gimp_plug_in_remove_buffer_map (GimpPlugIn             *plug_in,
+                                              GimpPlugInBufferMap    *map);
+
 void          gimp_plug_in_set_error_handler (GimpPlugIn             *plug_in,
                                               GimpPDBErrorHandler     handler);
 GimpPDBErrorHandler
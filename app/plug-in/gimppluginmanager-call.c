@@ -55,6 +55,13 @@
 #include "gimp-intl.h"
 
 
+typedef struct
+{
+  GimpPlugIn *plug_in;
+  gint64      start_time;
+} RunningPlugIn;
+
+
 static void
 gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 {
@@ -67,66 +74,116 @@ gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 /*  public functions  */
 
 void
-gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
-                                 GimpContext       *context,
-                                 GimpPlugInDef     *plug_in_def)
+gimp_plug_in_manager_call_query_init (GimpPlugInManager  *manager,
+                                      GimpContext        *context,
+                                      GimpPlugInCallMode  call_mode,
+                                      GSList             *plug_in_defs,
+                                      gint                max_running,
+                                      GimpInitStatusFunc  status_callback)
 {
-  GimpPlugIn *plug_in;
+  GArray  *running;
+  GPollFD *fds;
+  GSList  *list;
+  gint     n_plug_ins;
+  gint     nth        = 0;
+  gint64   start_time = g_get_monotonic_time ();
 
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
   g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+  g_return_if_fail (call_mode == GIMP_PLUG_IN_CALL_QUERY ||
+                    call_mode == GIMP_PLUG_IN_CALL_INIT);
+  g_return_if_fail (status_callback != NULL);
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
+  n_plug_ins = g_slist_length (plug_in_defs);
 
-  if (plug_in)
+  if (n_plug_ins == 0)
+    return;
+
+  max_running = CLAMP (max_running, 1, n_plug_ins);
+
+  running = g_array_sized_new (FALSE, FALSE, sizeof (RunningPlugIn),
+                               max_running);
+  fds     = g_new0 (GPollFD, max_running);
+
+  list = plug_in_defs;
+
+  while (list || running->len > 0)
     {
-      plug_in->plug_in_def = plug_in_def;
+      gint i;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
+      /*  start plug-ins until the pool is full  */
+      while (list && running->len < max_running)
         {
-          while (plug_in->open)
+          GimpPlugInDef *plug_in_def = list->data;
+          GimpPlugIn    *plug_in;
+          gchar         *basename;
+
+          list = g_slist_next (list);
+
+          basename =
+            g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
+          status_callback (NULL, basename,
+                           (gdouble) nth++ / (gdouble) n_plug_ins);
+          g_free (basename);
+
+          if (manager->gimp->be_verbose)
+            g_print ("%s plug-in: '%s'\n",
+                     call_mode == GIMP_PLUG_IN_CALL_QUERY ?
+                     "Querying" : "Initializing",
+                     gimp_file_get_utf8_name (plug_in_def->file));
+
+          plug_in = gimp_plug_in_new (manager, context, NULL,
+                                      NULL, plug_in_def->file);
+
+          if (! plug_in)
+            continue;
+
+          plug_in->plug_in_def = plug_in_def;
+
+          if (gimp_plug_in_open (plug_in, call_mode, TRUE))
             {
-              GimpWireMessage msg;
+              RunningPlugIn run = { plug_in, g_get_monotonic_time () };
 
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
-                {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
-                }
+              g_array_append_val (running, run);
+            }
+          else
+            {
+              g_object_unref (plug_in);
             }
         }
 
-      g_object_unref (plug_in);
-    }
-}
-
-void
-gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
-                                GimpContext       *context,
-                                GimpPlugInDef     *plug_in_def)
-{
-  GimpPlugIn *plug_in;
+      if (running->len == 0)
+        continue;
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+      for (i = 0; i < running->len; i++)
+        {
+          GimpPlugIn *plug_in = g_array_index (running, RunningPlugIn, i).plug_in;
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
+#ifdef G_OS_WIN32
+          g_io_channel_win32_make_pollfd (plug_in->my_read,
+                                          G_IO_IN  | G_IO_PRI |
+                                          G_IO_ERR | G_IO_HUP,
+                                          &fds[i]);
+#else
+          fds[i].fd     = g_io_channel_unix_get_fd (plug_in->my_read);
+          fds[i].events = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+#endif
+          fds[i].revents = 0;
+        }
 
-  if (plug_in)
-    {
-      plug_in->plug_in_def = plug_in_def;
+      if (g_poll (fds, running->len, -1) < 0)
+        continue;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_INIT, TRUE))
+      /*  walk backwards, so finished plug-ins can be removed in place  */
+      for (i = running->len - 1; i >= 0; i--)
         {
-          while (plug_in->open)
+          RunningPlugIn *run     = &g_array_index (running, RunningPlugIn, i);
+          GimpPlugIn    *plug_in = run->plug_in;
+
+          if (! fds[i].revents)
+            continue;
+
+          if (fds[i].revents & (G_IO_IN | G_IO_PRI))
             {
               GimpWireMessage msg;
 
@@ -140,10 +197,37 @@ gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
                   gimp_wire_destroy (&msg);
                 }
             }
-        }
+          else if (plug_in->open)
+            {
+              gimp_plug_in_close (plug_in, TRUE);
+            }
 
-      g_object_unref (plug_in);
+          if (! plug_in->open)
+            {
+              if (manager->gimp->be_verbose)
+                g_print ("  '%s' finished after %.3f seconds\n",
+                         gimp_file_get_utf8_name (plug_in->file),
+                         (g_get_monotonic_time () - run->start_time) /
+                         (gdouble) G_USEC_PER_SEC);
+
+              g_object_unref (plug_in);
+
+              g_array_remove_index_fast (running, i);
+            }
+        }
     }
+
+  if (manager->gimp->be_verbose)
+    g_print ("%s %d plug-ins took %.3f seconds (%d at a time)\n",
+             call_mode == GIMP_PLUG_IN_CALL_QUERY ?
+             "Querying" : "Initializing",
+             n_plug_ins,
+             (g_get_monotonic_time () - start_time) /
+             (gdouble) G_USEC_PER_SEC,
+             max_running);
+
+  g_array_free (running, TRUE);
+  g_free (fds);
 }
 
 GimpValueArray *
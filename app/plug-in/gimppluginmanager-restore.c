@@ -47,6 +47,7 @@
 #include "gimppluginmanager-restore.h"
 #include "gimppluginprocedure.h"
 #include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
 
 #include "gimp-intl.h"
 
@@ -56,15 +57,22 @@ static void    gimp_plug_in_manager_search            (GimpPlugInManager    *man
 static void    gimp_plug_in_manager_search_directory  (GimpPlugInManager    *manager,
                                                        GFile                *directory);
 static GFile * gimp_plug_in_manager_get_pluginrc      (GimpPlugInManager    *manager);
-static void    gimp_plug_in_manager_read_pluginrc     (GimpPlugInManager    *manager,
+static GFile * gimp_plug_in_manager_get_pluginrc_cache (GFile               *pluginrc);
+static gboolean gimp_plug_in_manager_read_pluginrc    (GimpPlugInManager    *manager,
                                                        GFile                *file,
+                                                       GFile                *cache,
                                                        GimpInitStatusFunc    status_callback);
+static void    gimp_plug_in_manager_write_pluginrc_cache
+                                                      (GimpPlugInManager    *manager,
+                                                       GFile                *pluginrc,
+                                                       GFile                *cache);
 static void    gimp_plug_in_manager_query_new         (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_init_plug_ins     (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
+static gint    gimp_plug_in_manager_get_n_jobs        (GimpPlugInManager    *manager);
 static void    gimp_plug_in_manager_run_extensions    (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
@@ -88,10 +96,12 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
                               GimpContext        *context,
                               GimpInitStatusFunc  status_callback)
 {
-  Gimp   *gimp;
-  GFile  *pluginrc;
-  GSList *list;
-  GError *error = NULL;
+  Gimp     *gimp;
+  GFile    *pluginrc;
+  GFile    *cache;
+  gboolean  cache_valid;
+  GSList   *list;
+  GError   *error = NULL;
 
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
   g_return_if_fail (GIMP_IS_CONTEXT (context));
@@ -107,8 +117,10 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
 
   /* read the pluginrc file for cached data */
   pluginrc = gimp_plug_in_manager_get_pluginrc (manager);
+  cache    = gimp_plug_in_manager_get_pluginrc_cache (pluginrc);
 
-  gimp_plug_in_manager_read_pluginrc (manager, pluginrc, status_callback);
+  cache_valid = gimp_plug_in_manager_read_pluginrc (manager, pluginrc, cache,
+                                                    status_callback);
 
   /* query any plug-ins that changed since we last wrote out pluginrc */
   gimp_plug_in_manager_query_new (manager, context, status_callback);
@@ -140,10 +152,19 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
                                 NULL, GIMP_MESSAGE_ERROR, error->message);
           g_clear_error (&error);
         }
+      else
+        {
+          cache_valid = FALSE;
+        }
 
       manager->write_pluginrc = FALSE;
     }
 
+  /* write the pluginrc cache if it doesn't match pluginrc */
+  if (! cache_valid)
+    gimp_plug_in_manager_write_pluginrc_cache (manager, pluginrc, cache);
+
+  g_object_unref (cache);
   g_object_unref (pluginrc);
 
   /* create help domain lists */
@@ -400,22 +421,43 @@ gimp_plug_in_manager_get_pluginrc (GimpPlugInManager *manager)
   return pluginrc;
 }
 
-/* read the pluginrc file for cached data */
-static void
+/* the binary cache of pluginrc lives next to it */
+static GFile *
+gimp_plug_in_manager_get_pluginrc_cache (GFile *pluginrc)
+{
+  GFile *parent = g_file_get_parent (pluginrc);
+  gchar *name   = g_file_get_basename (pluginrc);
+  gchar *basename;
+  GFile *cache;
+
+  basename = g_strconcat (name, ".cache", NULL);
+  cache    = g_file_get_child (parent, basename);
+
+  g_free (basename);
+  g_free (name);
+  g_object_unref (parent);
+
+  return cache;
+}
+
+/* read the pluginrc file for cached data, using its binary cache when
+ * it is up to date.  returns whether the cache was used.
+ */
+static gboolean
 gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
                                     GFile              *pluginrc,
+                                    GFile              *cache,
                                     GimpInitStatusFunc  status_callback)
 {
-  GSList *rc_defs;
-  GError *error = NULL;
+  GSList   *rc_defs;
+  gboolean  cache_valid;
+  GError   *error = NULL;
 
   status_callback (_("Resource configuration"),
                    gimp_file_get_utf8_name (pluginrc), 0.0);
 
-  if (manager->gimp->be_verbose)
-    g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
-
-  rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
+  rc_defs = plug_in_rc_cache_parse (manager->gimp, pluginrc, cache,
+                                    &cache_valid, &error);
 
   if (rc_defs)
     {
@@ -434,6 +476,31 @@ gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
 
       g_clear_error (&error);
     }
+
+  return cache_valid;
+}
+
+/* the cache is only an optimization, failing to write it is not an
+ * error worth bothering the user with
+ */
+static void
+gimp_plug_in_manager_write_pluginrc_cache (GimpPlugInManager *manager,
+                                           GFile             *pluginrc,
+                                           GFile             *cache)
+{
+  GError *error = NULL;
+
+  if (manager->gimp->be_verbose)
+    g_print ("Writing '%s'\n", gimp_file_get_utf8_name (cache));
+
+  if (! plug_in_rc_cache_write (manager->plug_in_defs, cache, pluginrc,
+                                &error))
+    {
+      if (manager->gimp->be_verbose)
+        g_print ("%s\n", error->message);
+
+      g_clear_error (&error);
+    }
 }
 
 /* query any plug-ins that changed since we last wrote out pluginrc */
@@ -443,11 +510,11 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
                                 GimpInitStatusFunc  status_callback)
 {
   GSList *list;
-  gint    n_plugins;
+  GSList *plug_in_defs = NULL;
 
   status_callback (_("Querying new Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
@@ -455,36 +522,26 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
         gimp_plug_in_def_set_needs_query (plug_in_def, TRUE);
 
       if (plug_in_def->needs_query)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
-
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->needs_query)
-            {
-              gchar *basename;
-
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      /*  the plug-ins run concurrently, but their procedures are kept
+       *  with their plug_in_def and added in plug_in_defs order later,
+       *  so the result doesn't depend on which plug-in finishes first
+       */
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Querying plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+      gimp_plug_in_manager_call_query_init (manager, context,
+                                            GIMP_PLUG_IN_CALL_QUERY,
+                                            plug_in_defs,
+                                            gimp_plug_in_manager_get_n_jobs (manager),
+                                            status_callback);
 
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (plug_in_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -497,48 +554,43 @@ gimp_plug_in_manager_init_plug_ins (GimpPlugInManager  *manager,
                                     GimpInitStatusFunc  status_callback)
 {
   GSList *list;
-  gint    n_plugins;
+  GSList *plug_in_defs = NULL;
 
   status_callback (_("Initializing Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->has_init)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
-
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->has_init)
-            {
-              gchar *basename;
-
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Initializing plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+      gimp_plug_in_manager_call_query_init (manager, context,
+                                            GIMP_PLUG_IN_CALL_INIT,
+                                            plug_in_defs,
+                                            gimp_plug_in_manager_get_n_jobs (manager),
+                                            status_callback);
 
-              gimp_plug_in_manager_call_init (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (plug_in_defs);
     }
 
   status_callback (NULL, "", 1.0);
 }
 
+/* the number of plug-ins to query or initialize at the same time */
+static gint
+gimp_plug_in_manager_get_n_jobs (GimpPlugInManager *manager)
+{
+  GimpGeglConfig *config = GIMP_GEGL_CONFIG (manager->gimp->config);
+
+  return MAX (config->num_processors, 1);
+}
+
 /* run automatically started extensions */
 static void
 gimp_plug_in_manager_run_extensions (GimpPlugInManager  *manager,
@@ -62,6 +62,9 @@
 
 #endif /* G_OS_WIN32 || G_WITH_CYGWIN */
 
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+
 #include "plug-in-types.h"
 
 #include "core/gimp-utils.h"
@@ -71,7 +74,8 @@
 #include "gimp-log.h"
 
 
-#define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32)
+#define TILE_MAP_SIZE (GIMP_PLUG_IN_TILE_WIDTH * GIMP_PLUG_IN_TILE_HEIGHT * 32 * \
+                       GP_SHM_N_TILES)
 
 #define ERRMSG_SHM_DISABLE "Disabling shared memory tile transport"
 
@@ -80,6 +84,8 @@ struct _GimpPlugInShm
 {
   gint    shm_id;
   guchar *shm_addr;
+  gsize   shm_size;
+  gchar  *shm_name;
 
 #if defined(USE_WIN32_SHM)
   HANDLE  shm_handle;
@@ -97,7 +103,8 @@ gimp_plug_in_shm_new (void)
 
   GimpPlugInShm *shm = g_slice_new0 (GimpPlugInShm);
 
-  shm->shm_id = -1;
+  shm->shm_id   = -1;
+  shm->shm_size = TILE_MAP_SIZE;
 
 #if defined(USE_SYSV_SHM)
 
@@ -208,7 +215,8 @@ gimp_plug_in_shm_new (void)
             /* Verify that we mapped our view */
             if (shm->shm_addr != MAP_FAILED)
               {
-                shm->shm_id = pid;
+                shm->shm_id   = pid;
+                shm->shm_name = g_strdup (shm_handle);
               }
             else
               {
@@ -250,6 +258,98 @@ gimp_plug_in_shm_new (void)
   return shm;
 }
 
+/*  Allocates a shared memory segment of its own for mapping a whole
+ *  buffer into a plug-in, see GP_BUFFER_MAP_REQ.  Returns NULL if
+ *  this is not possible, the plug-in has to use tiles then.
+ */
+GimpPlugInShm *
+gimp_plug_in_shm_new_for_buffer (gsize size)
+{
+  GimpPlugInShm *shm = g_slice_new0 (GimpPlugInShm);
+
+  shm->shm_id   = -1;
+  shm->shm_size = size;
+
+#if defined(USE_SYSV_SHM)
+
+  shm->shm_id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0600);
+
+  if (shm->shm_id != -1)
+    {
+      shm->shm_addr = (guchar *) shmat (shm->shm_id, NULL, 0);
+
+      if (shm->shm_addr == (guchar *) -1)
+        {
+          g_printerr ("shmat() failed: %s\n", g_strerror (errno));
+          shmctl (shm->shm_id, IPC_RMID, NULL);
+          shm->shm_id = -1;
+        }
+
+#ifdef IPC_RMID_DEFERRED_RELEASE
+      if (shm->shm_addr != (guchar *) -1)
+        shmctl (shm->shm_id, IPC_RMID, NULL);
+#endif
+    }
+
+#elif defined(USE_POSIX_SHM)
+
+  {
+    static gint serial = 0;
+    gchar       shm_handle[64];
+    gint        shm_fd;
+
+    g_snprintf (shm_handle, sizeof (shm_handle), "/gimp-shm-%d-%d",
+                gimp_get_pid (), ++serial);
+
+    shm_fd = shm_open (shm_handle, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (shm_fd != -1)
+      {
+        if (ftruncate (shm_fd, size) != -1)
+          {
+            shm->shm_addr = (guchar *) mmap (NULL, size,
+                                             PROT_READ | PROT_WRITE, MAP_SHARED,
+                                             shm_fd, 0);
+
+            if (shm->shm_addr != MAP_FAILED)
+              {
+                shm->shm_id   = serial;
+                shm->shm_name = g_strdup (shm_handle);
+              }
+            else
+              {
+                shm_unlink (shm_handle);
+              }
+          }
+        else
+          {
+            shm_unlink (shm_handle);
+          }
+
+        close (shm_fd);
+      }
+  }
+
+#endif
+
+  /*  Win32 file mappings are not supported for buffers, plug-ins
+   *  simply fall back to transferring tiles there.
+   */
+
+  if (shm->shm_id == -1)
+    {
+      g_slice_free (GimpPlugInShm, shm);
+      shm = NULL;
+    }
+  else
+    {
+      GIMP_LOG (SHM, "attached buffer shared memory segment ID = %d, "
+                "size = %" G_GSIZE_FORMAT, shm->shm_id, size);
+    }
+
+  return shm;
+}
+
 void
 gimp_plug_in_shm_free (GimpPlugInShm *shm)
 {
@@ -273,20 +373,17 @@ gimp_plug_in_shm_free (GimpPlugInShm *shm)
 
 #elif defined(USE_POSIX_SHM)
 
-      gchar shm_handle[32];
-
-      munmap (shm->shm_addr, TILE_MAP_SIZE);
+      munmap (shm->shm_addr, shm->shm_size);
 
-      g_snprintf (shm_handle, sizeof (shm_handle), "/gimp-shm-%d",
-                  shm->shm_id);
-
-      shm_unlink (shm_handle);
+      shm_unlink (shm->shm_name);
 
 #endif
 
       GIMP_LOG (SHM, "detached shared memory segment ID = %d", shm->shm_id);
     }
 
+  g_free (shm->shm_name);
+
   g_slice_free (GimpPlugInShm, shm);
 }
 
@@ -305,3 +402,19 @@ gimp_plug_in_shm_get_addr (GimpPlugInShm *shm)
 
   return shm->shm_addr;
 }
+
+gsize
+gimp_plug_in_shm_get_size (GimpPlugInShm *shm)
+{
+  g_return_val_if_fail (shm != NULL, 0);
+
+  return shm->shm_size;
+}
+
+const gchar *
+gimp_plug_in_shm_get_name (GimpPlugInShm *shm)
+{
+  g_return_val_if_fail (shm != NULL, NULL);
+
+  return shm->shm_name;
+}
@@ -21,11 +21,14 @@
 #define __GIMP_PLUG_IN_SHM_H__
 
 
-GimpPlugInShm * gimp_plug_in_shm_new      (void);
-void            gimp_plug_in_shm_free     (GimpPlugInShm *shm);
+GimpPlugInShm * gimp_plug_in_shm_new            (void);
+GimpPlugInShm * gimp_plug_in_shm_new_for_buffer (gsize          size);
+void            gimp_plug_in_shm_free           (GimpPlugInShm *shm);
 
-gint            gimp_plug_in_shm_get_id   (GimpPlugInShm *shm);
-guchar        * gimp_plug_in_shm_get_addr (GimpPlugInShm *shm);
+gint            gimp_plug_in_shm_get_id         (GimpPlugInShm *shm);
+guchar        * gimp_plug_in_shm_get_addr       (GimpPlugInShm *shm);
+gsize           gimp_plug_in_shm_get_size       (GimpPlugInShm *shm);
+const gchar   * gimp_plug_in_shm_get_name       (GimpPlugInShm *shm);
 
 
 #endif /* __GIMP_PLUG_IN_SHM_H__ */
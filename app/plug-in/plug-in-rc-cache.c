@@ -0,0 +1,1012 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "libgimp/gimpgpparams.h"
+
+#include "plug-in-types.h"
+
+#include "core/gimp.h"
+
+#include "gimpplugindef.h"
+#include "gimppluginprocedure.h"
+#include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
+
+#include "gimp-intl.h"
+
+
+/*  The plug-in-rc cache is a binary copy of pluginrc, which can be
+ *  mapped into memory and turned into GimpPlugInDefs without any
+ *  tokenizing.  It is only used when it matches the pluginrc file it
+ *  was written with, is in the byte order of the host, and its
+ *  checksum is right, otherwise pluginrc is parsed as usual.
+ *
+ *  All integers are stored in host byte order.  Strings are stored
+ *  as their length including the terminating NUL, followed by the
+ *  string, or as length 0 for NULL.
+ */
+
+#define PLUG_IN_RC_CACHE_MAGIC      "GIMPPRC"
+#define PLUG_IN_RC_CACHE_VERSION    1
+#define PLUG_IN_RC_CACHE_BYTE_ORDER 0x01020304
+
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 byte_order;
+  guint32 version;
+  guint32 protocol_version;
+  guint32 n_plug_in_defs;
+  gint64  pluginrc_mtime;
+  guint64 pluginrc_size;
+  guint8  checksum[16];
+} CacheHeader;
+
+typedef struct
+{
+  const guchar *data;
+  gsize         size;
+  gsize         offset;
+  gboolean      error;
+} CacheReader;
+
+enum
+{
+  PROC_KIND_NONE,
+  PROC_KIND_FILE,
+  PROC_KIND_BATCH
+};
+
+
+static gboolean              cache_get_pluginrc_info (GFile         *pluginrc,
+                                                      gint64        *mtime,
+                                                      guint64       *size);
+static gboolean              cache_checksum          (const guchar  *data,
+                                                      gsize          size,
+                                                      guint8         checksum[16]);
+
+static GimpPlugInDef       * cache_read_plug_in_def  (CacheReader   *reader,
+                                                      Gimp          *gimp);
+static GimpPlugInProcedure * cache_read_procedure    (CacheReader   *reader,
+                                                      Gimp          *gimp,
+                                                      GFile         *file);
+static GParamSpec          * cache_read_param_spec   (CacheReader   *reader);
+
+static void                  cache_read              (CacheReader   *reader,
+                                                      gpointer       dest,
+                                                      gsize          size);
+static gint32                cache_read_int32        (CacheReader   *reader);
+static gint64                cache_read_int64        (CacheReader   *reader);
+static gdouble               cache_read_double       (CacheReader   *reader);
+static const gchar         * cache_read_string       (CacheReader   *reader);
+static const guint8        * cache_read_data         (CacheReader   *reader,
+                                                      gint32        *length);
+
+static void                  cache_write_plug_in_def (GByteArray    *array,
+                                                      GimpPlugInDef *plug_in_def,
+                                                      const gchar   *path);
+static void                  cache_write_procedure   (GByteArray    *array,
+                                                      GimpPlugInProcedure *proc);
+static void                  cache_write_param_spec  (GByteArray    *array,
+                                                      GParamSpec    *pspec);
+
+static void                  cache_write_int32       (GByteArray    *array,
+                                                      gint32         value);
+static void                  cache_write_int64       (GByteArray    *array,
+                                                      gint64         value);
+static void                  cache_write_double      (GByteArray    *array,
+                                                      gdouble        value);
+static void                  cache_write_string      (GByteArray    *array,
+                                                      const gchar   *str);
+static void                  cache_write_data        (GByteArray    *array,
+                                                      const guint8  *data,
+                                                      gint32         length);
+
+
+/*  public functions  */
+
+/*  Returns the plug-in-defs of @pluginrc, read from its cache @file if
+ *  that is valid, and parsed from @pluginrc otherwise.  Sets
+ *  @cache_valid to whether the cache was used.
+ */
+GSList *
+plug_in_rc_cache_parse (Gimp      *gimp,
+                        GFile     *pluginrc,
+                        GFile     *file,
+                        gboolean  *cache_valid,
+                        GError   **error)
+{
+  GSList *plug_in_defs;
+  GError *cache_error = NULL;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (pluginrc), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (cache_valid != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (gimp->be_verbose)
+    g_print ("Loading '%s'\n", gimp_file_get_utf8_name (file));
+
+  plug_in_defs = plug_in_rc_cache_load (gimp, file, pluginrc, &cache_error);
+
+  *cache_valid = (cache_error == NULL);
+
+  if (! *cache_valid)
+    {
+      if (gimp->be_verbose)
+        g_print ("%s\n", cache_error->message);
+
+      g_clear_error (&cache_error);
+
+      if (gimp->be_verbose)
+        g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+
+      plug_in_defs = plug_in_rc_parse (gimp, pluginrc, error);
+    }
+
+  return plug_in_defs;
+}
+
+GSList *
+plug_in_rc_cache_load (Gimp    *gimp,
+                       GFile   *file,
+                       GFile   *pluginrc,
+                       GError **error)
+{
+  GMappedFile *mapped;
+  CacheHeader  header;
+  CacheReader  reader;
+  GSList      *plug_in_defs = NULL;
+  gchar       *path;
+  gint64       pluginrc_mtime;
+  guint64      pluginrc_size;
+  guint8       checksum[16];
+  guint        i;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (G_IS_FILE (pluginrc), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  path = g_file_get_path (file);
+
+  if (! path)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN,
+                   _("Skipping '%s': not a local file."),
+                   gimp_file_get_utf8_name (file));
+      return NULL;
+    }
+
+  mapped = g_mapped_file_new (path, FALSE, error);
+  g_free (path);
+
+  if (! mapped)
+    return NULL;
+
+  reader.data   = (const guchar *) g_mapped_file_get_contents (mapped);
+  reader.size   = g_mapped_file_get_length (mapped);
+  reader.offset = 0;
+  reader.error  = FALSE;
+
+  cache_read (&reader, &header, sizeof (header));
+
+  if (reader.error                                              ||
+      memcmp (header.magic, PLUG_IN_RC_CACHE_MAGIC,
+              sizeof (PLUG_IN_RC_CACHE_MAGIC))                  ||
+      header.byte_order       != PLUG_IN_RC_CACHE_BYTE_ORDER    ||
+      header.version          != PLUG_IN_RC_CACHE_VERSION       ||
+      header.protocol_version != GIMP_PROTOCOL_VERSION)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                   _("Skipping '%s': wrong cache file format version."),
+                   gimp_file_get_utf8_name (file));
+      goto out;
+    }
+
+  if (! cache_get_pluginrc_info (pluginrc, &pluginrc_mtime, &pluginrc_size) ||
+      header.pluginrc_mtime != pluginrc_mtime                               ||
+      header.pluginrc_size  != pluginrc_size)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+                   _("Skipping '%s': it doesn't match '%s'."),
+                   gimp_file_get_utf8_name (file),
+                   gimp_file_get_utf8_name (pluginrc));
+      goto out;
+    }
+
+  if (! cache_checksum (reader.data   + reader.offset,
+                        reader.size   - reader.offset,
+                        checksum) ||
+      memcmp (checksum, header.checksum, sizeof (checksum)))
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+                   _("Skipping '%s': checksum mismatch."),
+                   gimp_file_get_utf8_name (file));
+      goto out;
+    }
+
+  for (i = 0; i < header.n_plug_in_defs; i++)
+    {
+      GimpPlugInDef *plug_in_def = cache_read_plug_in_def (&reader, gimp);
+
+      if (! plug_in_def)
+        break;
+
+      plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
+    }
+
+  if (reader.error || reader.offset != reader.size)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+                   _("Skipping '%s': file is corrupt."),
+                   gimp_file_get_utf8_name (file));
+
+      g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+      plug_in_defs = NULL;
+    }
+
+ out:
+  g_mapped_file_unref (mapped);
+
+  return g_slist_reverse (plug_in_defs);
+}
+
+gboolean
+plug_in_rc_cache_write (GSList  *plug_in_defs,
+                        GFile   *file,
+                        GFile   *pluginrc,
+                        GError **error)
+{
+  GByteArray  *array;
+  CacheHeader  header = { { 0, }, };
+  GSList      *list;
+  gboolean     success;
+
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (G_IS_FILE (pluginrc), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  memcpy (header.magic, PLUG_IN_RC_CACHE_MAGIC,
+          sizeof (PLUG_IN_RC_CACHE_MAGIC));
+  header.byte_order       = PLUG_IN_RC_CACHE_BYTE_ORDER;
+  header.version          = PLUG_IN_RC_CACHE_VERSION;
+  header.protocol_version = GIMP_PROTOCOL_VERSION;
+
+  if (! cache_get_pluginrc_info (pluginrc,
+                                 &header.pluginrc_mtime,
+                                 &header.pluginrc_size))
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN,
+                   _("Could not read '%s'."),
+                   gimp_file_get_utf8_name (pluginrc));
+      return FALSE;
+    }
+
+  array = g_byte_array_new ();
+
+  g_byte_array_append (array, (const guint8 *) &header, sizeof (header));
+
+  /*  same selection of plug-in-defs as plug_in_rc_write()  */
+  for (list = plug_in_defs; list; list = g_slist_next (list))
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+      gchar         *path;
+
+      if (! plug_in_def->procedures)
+        continue;
+
+      path = gimp_file_get_config_path (plug_in_def->file, NULL);
+      if (! path)
+        continue;
+
+      cache_write_plug_in_def (array, plug_in_def, path);
+      header.n_plug_in_defs++;
+
+      g_free (path);
+    }
+
+  cache_checksum (array->data + sizeof (header),
+                  array->len  - sizeof (header),
+                  header.checksum);
+
+  memcpy (array->data, &header, sizeof (header));
+
+  success = g_file_replace_contents (file,
+                                     (const gchar *) array->data, array->len,
+                                     NULL, FALSE, G_FILE_CREATE_NONE,
+                                     NULL, NULL, error);
+
+  g_byte_array_free (array, TRUE);
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static gboolean
+cache_get_pluginrc_info (GFile   *pluginrc,
+                         gint64  *mtime,
+                         guint64 *size)
+{
+  GFileInfo *info;
+
+  info = g_file_query_info (pluginrc,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+  if (! info)
+    return FALSE;
+
+  *mtime = g_file_info_get_attribute_uint64 (info,
+                                             G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  *size  = g_file_info_get_size (info);
+
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+static gboolean
+cache_checksum (const guchar *data,
+                gsize         size,
+                guint8        checksum[16])
+{
+  GChecksum *md5    = g_checksum_new (G_CHECKSUM_MD5);
+  gsize      length = 16;
+
+  g_checksum_update (md5, data, size);
+  g_checksum_get_digest (md5, checksum, &length);
+  g_checksum_free (md5);
+
+  return length == 16;
+}
+
+static GimpPlugInDef *
+cache_read_plug_in_def (CacheReader *reader,
+                        Gimp        *gimp)
+{
+  GimpPlugInDef *plug_in_def;
+  const gchar   *path;
+  const gchar   *help_domain_name;
+  const gchar   *help_domain_uri;
+  GFile         *file;
+  gint64         mtime;
+  gboolean       has_init;
+  gint           n_procedures;
+  gint           i;
+
+  path             = cache_read_string (reader);
+  mtime            = cache_read_int64  (reader);
+  help_domain_name = cache_read_string (reader);
+  help_domain_uri  = cache_read_string (reader);
+  has_init         = cache_read_int32  (reader);
+  n_procedures     = cache_read_int32  (reader);
+
+  if (reader->error || ! (path && *path) || n_procedures < 0)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  file = gimp_file_new_for_config_path (path, NULL);
+
+  if (! file)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+
+  plug_in_def->mtime = mtime;
+
+  for (i = 0; i < n_procedures; i++)
+    {
+      GimpPlugInProcedure *proc;
+
+      proc = cache_read_procedure (reader, gimp, plug_in_def->file);
+
+      if (! proc)
+        {
+          g_object_unref (plug_in_def);
+          return NULL;
+        }
+
+      gimp_plug_in_def_add_procedure (plug_in_def, proc);
+      g_object_unref (proc);
+    }
+
+  if (help_domain_name)
+    gimp_plug_in_def_set_help_domain (plug_in_def,
+                                      help_domain_name, help_domain_uri);
+
+  if (has_init)
+    gimp_plug_in_def_set_has_init (plug_in_def, TRUE);
+
+  return plug_in_def;
+}
+
+static GimpPlugInProcedure *
+cache_read_procedure (CacheReader *reader,
+                      Gimp        *gimp,
+                      GFile       *file)
+{
+  GimpProcedure       *procedure;
+  GimpPlugInProcedure *proc;
+  const gchar         *name;
+  const gchar         *str;
+  const guint8        *icon_data;
+  gint32               proc_type;
+  gint32               icon_type;
+  gint32               icon_data_length;
+  gint32               kind;
+  gint                 n_menu_paths;
+  gint                 n_args;
+  gint                 n_values;
+  gint                 i;
+
+  name      = cache_read_string (reader);
+  proc_type = cache_read_int32  (reader);
+
+  if (reader->error || ! (name && *name) ||
+      (proc_type != GIMP_PDB_PROC_TYPE_PLUGIN &&
+       proc_type != GIMP_PDB_PROC_TYPE_EXTENSION))
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  procedure = gimp_plug_in_procedure_new (proc_type, file);
+  proc      = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+  gimp_object_set_name (GIMP_OBJECT (procedure), name);
+
+  procedure->blurb     = g_strdup (cache_read_string (reader));
+  procedure->help      = g_strdup (cache_read_string (reader));
+  procedure->authors   = g_strdup (cache_read_string (reader));
+  procedure->copyright = g_strdup (cache_read_string (reader));
+  procedure->date      = g_strdup (cache_read_string (reader));
+  proc->menu_label     = g_strdup (cache_read_string (reader));
+
+  n_menu_paths = cache_read_int32 (reader);
+
+  for (i = 0; i < n_menu_paths && ! reader->error; i++)
+    {
+      str = cache_read_string (reader);
+
+      if (str)
+        proc->menu_paths = g_list_append (proc->menu_paths, g_strdup (str));
+    }
+
+  icon_type = cache_read_int32 (reader);
+  icon_data = cache_read_data (reader, &icon_data_length);
+
+  if (reader->error)
+    goto error;
+
+  switch (icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      if (icon_data && icon_data[icon_data_length - 1] != '\0')
+        goto error;
+
+      gimp_plug_in_procedure_take_icon (proc, icon_type,
+                                        (guint8 *) g_strdup ((const gchar *) icon_data),
+                                        -1, NULL);
+      break;
+
+    case GIMP_ICON_TYPE_PIXBUF:
+      if (! icon_data)
+        goto error;
+
+      gimp_plug_in_procedure_take_icon (proc, icon_type,
+                                        g_memdup2 (icon_data, icon_data_length),
+                                        icon_data_length, NULL);
+      break;
+
+    default:
+      goto error;
+    }
+
+  kind = cache_read_int32 (reader);
+
+  switch (kind)
+    {
+    case PROC_KIND_NONE:
+      break;
+
+    case PROC_KIND_FILE:
+      proc->file_proc  = TRUE;
+      proc->extensions = g_strdup (cache_read_string (reader));
+      proc->prefixes   = g_strdup (cache_read_string (reader));
+      proc->magics     = g_strdup (cache_read_string (reader));
+
+      gimp_plug_in_procedure_set_priority (proc, cache_read_int32 (reader));
+
+      str = cache_read_string (reader);
+      if (str)
+        gimp_plug_in_procedure_set_mime_types (proc, str);
+
+      if (cache_read_int32 (reader))
+        gimp_plug_in_procedure_set_handles_remote (proc);
+
+      if (cache_read_int32 (reader))
+        gimp_plug_in_procedure_set_handles_raw (proc);
+
+      str = cache_read_string (reader);
+      if (str)
+        gimp_plug_in_procedure_set_thumb_loader (proc, str);
+      break;
+
+    case PROC_KIND_BATCH:
+      str = cache_read_string (reader);
+      if (! str)
+        goto error;
+
+      gimp_plug_in_procedure_set_batch_interpreter (proc, str);
+      break;
+
+    default:
+      goto error;
+    }
+
+  gimp_plug_in_procedure_set_image_types (proc, cache_read_string (reader));
+  gimp_plug_in_procedure_set_sensitivity_mask (proc,
+                                               cache_read_int32 (reader));
+
+  n_args   = cache_read_int32 (reader);
+  n_values = cache_read_int32 (reader);
+
+  for (i = 0; i < n_args && ! reader->error; i++)
+    {
+      GParamSpec *pspec = cache_read_param_spec (reader);
+
+      if (pspec)
+        gimp_procedure_add_argument (procedure, pspec);
+    }
+
+  for (i = 0; i < n_values && ! reader->error; i++)
+    {
+      GParamSpec *pspec = cache_read_param_spec (reader);
+
+      if (pspec)
+        gimp_procedure_add_return_value (procedure, pspec);
+    }
+
+  if (reader->error)
+    goto error;
+
+  return proc;
+
+ error:
+  reader->error = TRUE;
+
+  g_object_unref (procedure);
+
+  return NULL;
+}
+
+static GParamSpec *
+cache_read_param_spec (CacheReader *reader)
+{
+  GPParamDef param_def = { 0, };
+
+  /*  the strings point into the mapped file, and are copied by
+   *  _gimp_gp_param_def_to_param_spec()
+   */
+  param_def.param_def_type  = cache_read_int32  (reader);
+  param_def.type_name       = (gchar *) cache_read_string (reader);
+  param_def.value_type_name = (gchar *) cache_read_string (reader);
+  param_def.name            = (gchar *) cache_read_string (reader);
+  param_def.nick            = (gchar *) cache_read_string (reader);
+  param_def.blurb           = (gchar *) cache_read_string (reader);
+  param_def.flags           = cache_read_int32  (reader);
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      param_def.meta.m_int.min_val     = cache_read_int64 (reader);
+      param_def.meta.m_int.max_val     = cache_read_int64 (reader);
+      param_def.meta.m_int.default_val = cache_read_int64 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      param_def.meta.m_unit.allow_pixels  = cache_read_int32 (reader);
+      param_def.meta.m_unit.allow_percent = cache_read_int32 (reader);
+      param_def.meta.m_unit.default_val   = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      param_def.meta.m_enum.default_val = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      param_def.meta.m_boolean.default_val = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FLOAT:
+      param_def.meta.m_float.min_val     = cache_read_double (reader);
+      param_def.meta.m_float.max_val     = cache_read_double (reader);
+      param_def.meta.m_float.default_val = cache_read_double (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      param_def.meta.m_string.default_val =
+        (gchar *) cache_read_string (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_COLOR:
+      param_def.meta.m_color.has_alpha     = cache_read_int32  (reader);
+      param_def.meta.m_color.default_val.r = cache_read_double (reader);
+      param_def.meta.m_color.default_val.g = cache_read_double (reader);
+      param_def.meta.m_color.default_val.b = cache_read_double (reader);
+      param_def.meta.m_color.default_val.a = cache_read_double (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      param_def.meta.m_id.none_ok = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      param_def.meta.m_id_array.type_name =
+        (gchar *) cache_read_string (reader);
+      break;
+
+    default:
+      reader->error = TRUE;
+      break;
+    }
+
+  if (reader->error              ||
+      ! param_def.type_name      ||
+      ! param_def.value_type_name ||
+      ! param_def.name)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  return _gimp_gp_param_def_to_param_spec (&param_def);
+}
+
+static void
+cache_read (CacheReader *reader,
+            gpointer     dest,
+            gsize        size)
+{
+  if (reader->error || reader->size - reader->offset < size)
+    {
+      reader->error = TRUE;
+      memset (dest, 0, size);
+      return;
+    }
+
+  memcpy (dest, reader->data + reader->offset, size);
+  reader->offset += size;
+}
+
+static gint32
+cache_read_int32 (CacheReader *reader)
+{
+  gint32 value;
+
+  cache_read (reader, &value, sizeof (value));
+
+  return value;
+}
+
+static gint64
+cache_read_int64 (CacheReader *reader)
+{
+  gint64 value;
+
+  cache_read (reader, &value, sizeof (value));
+
+  return value;
+}
+
+static gdouble
+cache_read_double (CacheReader *reader)
+{
+  gdouble value;
+
+  cache_read (reader, &value, sizeof (value));
+
+  return value;
+}
+
+static const gchar *
+cache_read_string (CacheReader *reader)
+{
+  const guint8 *data;
+  gint32        length;
+
+  data = cache_read_data (reader, &length);
+
+  if (data && data[length - 1] != '\0')
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  return (const gchar *) data;
+}
+
+static const guint8 *
+cache_read_data (CacheReader *reader,
+                 gint32      *length)
+{
+  const guint8 *data;
+
+  *length = cache_read_int32 (reader);
+
+  if (reader->error || *length <= 0)
+    {
+      if (*length < 0)
+        reader->error = TRUE;
+
+      return NULL;
+    }
+
+  if (reader->size - reader->offset < (gsize) *length)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  data = reader->data + reader->offset;
+  reader->offset += *length;
+
+  return data;
+}
+
+static void
+cache_write_plug_in_def (GByteArray    *array,
+                         GimpPlugInDef *plug_in_def,
+                         const gchar   *path)
+{
+  GSList *list;
+  gint    n_procedures = 0;
+
+  for (list = plug_in_def->procedures; list; list = g_slist_next (list))
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (! proc->installed_during_init)
+        n_procedures++;
+    }
+
+  cache_write_string (array, path);
+  cache_write_int64  (array, plug_in_def->mtime);
+  cache_write_string (array, plug_in_def->help_domain_name);
+  cache_write_string (array, plug_in_def->help_domain_uri);
+  cache_write_int32  (array, plug_in_def->has_init);
+  cache_write_int32  (array, n_procedures);
+
+  for (list = plug_in_def->procedures; list; list = g_slist_next (list))
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (! proc->installed_during_init)
+        cache_write_procedure (array, proc);
+    }
+}
+
+static void
+cache_write_procedure (GByteArray          *array,
+                       GimpPlugInProcedure *proc)
+{
+  GimpProcedure *procedure = GIMP_PROCEDURE (proc);
+  GList         *list;
+  gint           i;
+
+  cache_write_string (array, gimp_object_get_name (procedure));
+  cache_write_int32  (array, procedure->proc_type);
+  cache_write_string (array, procedure->blurb);
+  cache_write_string (array, procedure->help);
+  cache_write_string (array, procedure->authors);
+  cache_write_string (array, procedure->copyright);
+  cache_write_string (array, procedure->date);
+  cache_write_string (array, proc->menu_label);
+
+  cache_write_int32 (array, g_list_length (proc->menu_paths));
+
+  for (list = proc->menu_paths; list; list = g_list_next (list))
+    cache_write_string (array, list->data);
+
+  cache_write_int32 (array, proc->icon_type);
+
+  switch (proc->icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      cache_write_string (array, (const gchar *) proc->icon_data);
+      break;
+
+    case GIMP_ICON_TYPE_PIXBUF:
+      cache_write_data (array, proc->icon_data, proc->icon_data_length);
+      break;
+    }
+
+  if (proc->file_proc)
+    {
+      cache_write_int32  (array, PROC_KIND_FILE);
+      cache_write_string (array, proc->extensions);
+      cache_write_string (array, proc->prefixes);
+      cache_write_string (array, proc->magics);
+      cache_write_int32  (array, proc->priority);
+      cache_write_string (array, proc->mime_types);
+      cache_write_int32  (array, proc->handles_remote);
+      cache_write_int32  (array, proc->handles_raw && ! proc->image_types);
+      cache_write_string (array, proc->thumb_loader);
+    }
+  else if (proc->batch_interpreter)
+    {
+      cache_write_int32  (array, PROC_KIND_BATCH);
+      cache_write_string (array, proc->batch_interpreter_name);
+    }
+  else
+    {
+      cache_write_int32  (array, PROC_KIND_NONE);
+    }
+
+  cache_write_string (array, proc->image_types);
+  cache_write_int32  (array, proc->sensitivity_mask);
+
+  cache_write_int32 (array, procedure->num_args);
+  cache_write_int32 (array, procedure->num_values);
+
+  for (i = 0; i < procedure->num_args; i++)
+    cache_write_param_spec (array, procedure->args[i]);
+
+  for (i = 0; i < procedure->num_values; i++)
+    cache_write_param_spec (array, procedure->values[i]);
+}
+
+static void
+cache_write_param_spec (GByteArray *array,
+                        GParamSpec *pspec)
+{
+  GPParamDef param_def = { 0, };
+
+  _gimp_param_spec_to_gp_param_def (pspec, &param_def);
+
+  cache_write_int32  (array, param_def.param_def_type);
+  cache_write_string (array, param_def.type_name);
+  cache_write_string (array, param_def.value_type_name);
+  cache_write_string (array, g_param_spec_get_name (pspec));
+  cache_write_string (array, g_param_spec_get_nick (pspec));
+  cache_write_string (array, g_param_spec_get_blurb (pspec));
+  cache_write_int32  (array, pspec->flags);
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      cache_write_int64 (array, param_def.meta.m_int.min_val);
+      cache_write_int64 (array, param_def.meta.m_int.max_val);
+      cache_write_int64 (array, param_def.meta.m_int.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      cache_write_int32 (array, param_def.meta.m_unit.allow_pixels);
+      cache_write_int32 (array, param_def.meta.m_unit.allow_percent);
+      cache_write_int32 (array, param_def.meta.m_unit.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      cache_write_int32 (array, param_def.meta.m_enum.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      cache_write_int32 (array, param_def.meta.m_boolean.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FLOAT:
+      cache_write_double (array, param_def.meta.m_float.min_val);
+      cache_write_double (array, param_def.meta.m_float.max_val);
+      cache_write_double (array, param_def.meta.m_float.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      cache_write_string (array, param_def.meta.m_string.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_COLOR:
+      cache_write_int32  (array, param_def.meta.m_color.has_alpha);
+      cache_write_double (array, param_def.meta.m_color.default_val.r);
+      cache_write_double (array, param_def.meta.m_color.default_val.g);
+      cache_write_double (array, param_def.meta.m_color.default_val.b);
+      cache_write_double (array, param_def.meta.m_color.default_val.a);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      cache_write_int32 (array, param_def.meta.m_id.none_ok);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      cache_write_string (array, param_def.meta.m_id_array.type_name);
+      break;
+    }
+}
+
+static void
+cache_write_int32 (GByteArray *array,
+                   gint32      value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_int64 (GByteArray *array,
+                   gint64      value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_double (GByteArray *array,
+                    gdouble     value)
+{
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_string (GByteArray  *array,
+                    const gchar *str)
+{
+  cache_write_data (array, (const guint8 *) str, str ? strlen (str) + 1 : 0);
+}
+
+static void
+cache_write_data (GByteArray   *array,
+                  const guint8 *data,
+                  gint32        length)
+{
+  if (! data || length < 0)
+    length = 0;
+
+  cache_write_int32 (array, length);
+
+  if (length > 0)
+    g_byte_array_append (array, data, length);
+}
@@ -0,0 +1,39 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PLUG_IN_RC_CACHE_H__
+#define __PLUG_IN_RC_CACHE_H__
+
+
+GSList   * plug_in_rc_cache_parse (Gimp     *gimp,
+                                   GFile    *pluginrc,
+                                   GFile    *file,
+                                   gboolean *cache_valid,
+                                   GError  **error);
+GSList   * plug_in_rc_cache_load  (Gimp     *gimp,
+                                   GFile    *file,
+                                   GFile    *pluginrc,
+                                   GError  **error);
+gboolean   plug_in_rc_cache_write (GSList   *plug_in_defs,
+                                   GFile    *file,
+                                   GFile    *pluginrc,
+                                   GError  **error);
+
+
+#endif /* __PLUG_IN_RC_CACHE_H__ */
@@ -29,6 +29,7 @@
 
 
 typedef struct _GimpPlugIn           GimpPlugIn;
+typedef struct _GimpPlugInBufferMap  GimpPlugInBufferMap;
 typedef struct _GimpPlugInDebug      GimpPlugInDebug;
 typedef struct _GimpPlugInDef        GimpPlugInDef;
 typedef struct _GimpPlugInManager    GimpPlugInManager;
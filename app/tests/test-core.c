@@ -15,19 +15,55 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <math.h>
+#include <string.h>
+
 #include <gegl.h>
 #include <gtk/gtk.h>
 
+#include "libgimpconfig/gimpconfig.h"
+#include "libgimpmath/gimpmath.h"
+
 #include "widgets/widgets-types.h"
 
 #include "widgets/gimpuimanager.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
+#include "core/gimpboundary.h"
+#include "core/gimpchannel-select.h"
+#include "core/gimpcontainer.h"
 #include "core/gimpcontext.h"
+#include "core/gimpdatafactory.h"
+#include "core/gimpdrawable-histogram.h"
+#include "core/gimpdrawable-preview.h"
+#include "core/gimpdrawableundo.h"
+#include "core/gimpdrawablehistogram.h"
+#include "core/gimphistogram.h"
+#include "core/gimpgrouplayer.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-colormap.h"
+#include "core/gimpimage-convert-indexed.h"
+#include "core/gimpimage-duplicate.h"
+#include "core/gimpimage-scale.h"
+#include "core/gimpimage-undo.h"
+#include "core/gimpimage-undo-push.h"
 #include "core/gimplayer.h"
 #include "core/gimplayer-new.h"
+#include "core/gimplayermask.h"
+#include "core/gimplist.h"
+#include "core/gimppickable.h"
+#include "core/gimppickable-contiguous-region.h"
+#include "core/gimpprojection.h"
+#include "core/gimptempbuf.h"
+#include "core/gimpundostack.h"
+#include "core/gimpwaitable.h"
+
+#include "text/gimptext.h"
+#include "text/gimptextlayer.h"
 
+#include "operations/gimpcageconfig.h"
 #include "operations/gimplevelsconfig.h"
 
 #include "tests.h"
@@ -37,6 +73,30 @@
 
 #define GIMP_TEST_IMAGE_SIZE 100
 
+#define GIMP_TEST_SCALE_N_LAYERS       24
+#define GIMP_TEST_SCALE_PERF_SIZE      1024
+#define GIMP_TEST_SCALE_PERF_N_LAYERS  200
+
+#define GIMP_TEST_FILL_WIDTH          700
+#define GIMP_TEST_FILL_HEIGHT         530
+#define GIMP_TEST_FILL_PARALLEL_SIZE  1024
+#define GIMP_TEST_FILL_PERF_SIZE      4096
+#define GIMP_TEST_FILL_THRESHOLD      (10.0 / 255.0)
+
+#define GIMP_TEST_BOUNDARY_X1  30
+#define GIMP_TEST_BOUNDARY_Y1  20
+#define GIMP_TEST_BOUNDARY_X2  530
+#define GIMP_TEST_BOUNDARY_Y2  420
+
+#define GIMP_TEST_CAGE_SIZE       300
+#define GIMP_TEST_CAGE_PERF_SIZE  1024
+
+#define GIMP_TEST_DISTANCE_SIZE       400
+#define GIMP_TEST_DISTANCE_PERF_SIZE  2048
+
+#define GIMP_TEST_GRADIENT_SIZE       300
+#define GIMP_TEST_GRADIENT_PERF_SIZE  2048
+
 #define ADD_IMAGE_TEST(function) \
   g_test_add ("/gimp-core/" #function, \
               GimpTestFixture, \
@@ -258,6 +318,3652 @@ white_graypoint_in_red_levels (GimpTestFixture *fixture,
                 NULL);
 }
 
+static GimpImage *
+gimp_test_scale_image_new (Gimp *gimp,
+                           gint  size,
+                           gint  n_layers)
+{
+  GimpImage *image;
+  GimpLayer *group;
+  GRand     *rand = g_rand_new_with_seed (n_layers);
+  gint       i;
+
+  image = gimp_image_new (gimp, size, size,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+
+  group = gimp_group_layer_new (image);
+  gimp_image_add_layer (image, group, NULL, 0, FALSE);
+
+  for (i = 0; i < n_layers; i++)
+    {
+      GimpLayer  *layer;
+      GeglBuffer *buffer;
+      guchar     *data;
+      gint        width  = size - i;
+      gint        height = size / 2 + i;
+      gint        j;
+
+      layer = gimp_layer_new (image, width, height,
+                              babl_format ("R'G'B'A u8"),
+                              "Test Layer",
+                              GIMP_OPACITY_OPAQUE,
+                              GIMP_LAYER_MODE_NORMAL);
+
+      buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+      data   = g_malloc ((gsize) width * height * 4);
+
+      for (j = 0; j < width * height * 4; j++)
+        data[j] = g_rand_int (rand);
+
+      gegl_buffer_set (buffer, NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+      g_free (data);
+
+      gimp_item_set_offset (GIMP_ITEM (layer), i, 2 * i);
+
+      /* put every other layer into the group, and give some a mask */
+      gimp_image_add_layer (image, layer,
+                            i % 2 ? group : NULL, 0,
+                            FALSE);
+
+      if (i % 3 == 0)
+        {
+          GimpLayerMask *mask;
+
+          mask = gimp_layer_create_mask (layer, GIMP_ADD_MASK_ALPHA, NULL);
+          gimp_layer_add_mask (layer, mask, FALSE, NULL);
+        }
+    }
+
+  g_rand_free (rand);
+
+  return image;
+}
+
+static void
+gimp_test_assert_buffers_equal (GeglBuffer *buffer1,
+                                GeglBuffer *buffer2)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer1);
+  const Babl          *format = gegl_buffer_get_format (buffer1);
+  gsize                size;
+  guchar              *data1;
+  guchar              *data2;
+
+  g_assert_true (gegl_rectangle_equal (extent,
+                                       gegl_buffer_get_extent (buffer2)));
+  g_assert_true (format == gegl_buffer_get_format (buffer2));
+
+  size  = (gsize) extent->width * extent->height *
+          babl_format_get_bytes_per_pixel (format);
+  data1 = g_malloc (size);
+  data2 = g_malloc (size);
+
+  gegl_buffer_get (buffer1, extent, 1.0, format, data1,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (buffer2, extent, 1.0, format, data2,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_assert_true (memcmp (data1, data2, size) == 0);
+
+  g_free (data1);
+  g_free (data2);
+}
+
+/* reports how long two implementations of the same thing took, as
+ * measured by the perf tests
+ */
+static void
+gimp_test_report_times (const gchar *name1,
+                        gint64       time1,
+                        const gchar *name2,
+                        gint64       time2,
+                        const gchar *format,
+                        ...)
+{
+  va_list  args;
+  gchar   *what;
+
+  va_start (args, format);
+  what = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  g_test_message ("%s: %s %.3f s  %s %.3f s  (%.2fx)",
+                  what,
+                  name1, time1 / 1000000.0,
+                  name2, time2 / 1000000.0,
+                  (gdouble) time1 / MAX (time2, 1));
+
+  g_free (what);
+}
+
+typedef GeglBuffer * (* GimpTestRenderFunc) (gpointer data,
+                                             gboolean original);
+
+/* renders @data with the original implementation and with the one which
+ * replaced it, makes sure both give exactly the same buffer, and, in
+ * perf mode, reports how long each took
+ */
+static void
+gimp_test_compare_implementations (GimpTestRenderFunc  render,
+                                   gpointer            data,
+                                   const gchar        *original_name,
+                                   const gchar        *name,
+                                   const gchar        *format,
+                                   ...)
+{
+  GeglBuffer *original_buffer;
+  GeglBuffer *buffer;
+  gint64      original_time;
+  gint64      time;
+
+  original_time   = g_get_monotonic_time ();
+  original_buffer = render (data, TRUE);
+  original_time   = g_get_monotonic_time () - original_time;
+
+  time   = g_get_monotonic_time ();
+  buffer = render (data, FALSE);
+  time   = g_get_monotonic_time () - time;
+
+  gimp_test_assert_buffers_equal (original_buffer, buffer);
+
+  if (g_test_perf ())
+    {
+      va_list  args;
+      gchar   *what;
+
+      va_start (args, format);
+      what = g_strdup_vprintf (format, args);
+      va_end (args);
+
+      gimp_test_report_times (original_name, original_time,
+                              name,          time,
+                              "%s", what);
+
+      g_free (what);
+    }
+
+  g_object_unref (original_buffer);
+  g_object_unref (buffer);
+}
+
+static gint64
+gimp_test_scale_image (GimpImage *image,
+                       gint       new_size,
+                       gboolean   parallel)
+{
+  Gimp   *gimp = image->gimp;
+  gint    num_processors;
+  gint64  start;
+  gint64  time;
+
+  g_object_get (gimp->config,
+                "num-processors", &num_processors,
+                NULL);
+
+  /*  layers are only scaled in parallel with more than one thread  */
+  g_object_set (gimp->config,
+                "num-processors",
+                parallel ? MAX (g_get_num_processors (), 2) : 1,
+                NULL);
+
+  start = g_get_monotonic_time ();
+
+  gimp_image_scale (image, new_size, new_size,
+                    GIMP_INTERPOLATION_LINEAR, NULL);
+
+  time = g_get_monotonic_time () - start;
+
+  g_object_set (gimp->config,
+                "num-processors", num_processors,
+                NULL);
+
+  return time;
+}
+
+/**
+ * scale_image_parallel:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure scaling the layers and masks of an image in parallel
+ * gives exactly the same result as scaling them one by one, and that
+ * the whole scale is still a single undo step.
+ **/
+static void
+scale_image_parallel (GimpTestFixture *fixture,
+                      gconstpointer    data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image1;
+  GimpImage *image2;
+  GList     *layers1;
+  GList     *layers2;
+  GList     *list1;
+  GList     *list2;
+
+  image1 = gimp_test_scale_image_new (gimp, GIMP_TEST_IMAGE_SIZE,
+                                      GIMP_TEST_SCALE_N_LAYERS);
+  image2 = gimp_image_duplicate (image1);
+
+  gimp_test_scale_image (image1, GIMP_TEST_IMAGE_SIZE * 3 / 2, FALSE);
+  gimp_test_scale_image (image2, GIMP_TEST_IMAGE_SIZE * 3 / 2, TRUE);
+
+  layers1 = gimp_image_get_layer_list (image1);
+  layers2 = gimp_image_get_layer_list (image2);
+
+  g_assert_cmpint (g_list_length (layers1), ==, g_list_length (layers2));
+
+  for (list1 = layers1, list2 = layers2;
+       list1 && list2;
+       list1 = g_list_next (list1), list2 = g_list_next (list2))
+    {
+      GimpItem  *item1 = list1->data;
+      GimpItem  *item2 = list2->data;
+      GimpLayer *layer1 = list1->data;
+      GimpLayer *layer2 = list2->data;
+
+      g_assert_cmpint (gimp_item_get_offset_x (item1), ==,
+                       gimp_item_get_offset_x (item2));
+      g_assert_cmpint (gimp_item_get_offset_y (item1), ==,
+                       gimp_item_get_offset_y (item2));
+
+      if (gimp_viewable_get_children (GIMP_VIEWABLE (item1)))
+        continue;
+
+      gimp_test_assert_buffers_equal (
+        gimp_drawable_get_buffer (GIMP_DRAWABLE (item1)),
+        gimp_drawable_get_buffer (GIMP_DRAWABLE (item2)));
+
+      g_assert_true (! gimp_layer_get_mask (layer1) ==
+                     ! gimp_layer_get_mask (layer2));
+
+      if (gimp_layer_get_mask (layer1))
+        {
+          gimp_test_assert_buffers_equal (
+            gimp_drawable_get_buffer (GIMP_DRAWABLE (gimp_layer_get_mask (layer1))),
+            gimp_drawable_get_buffer (GIMP_DRAWABLE (gimp_layer_get_mask (layer2))));
+        }
+    }
+
+  g_list_free (layers1);
+  g_list_free (layers2);
+
+  g_assert_true (gimp_image_undo (image2));
+  g_assert_cmpint (gimp_image_get_width (image2), ==, GIMP_TEST_IMAGE_SIZE);
+
+  g_object_unref (image1);
+  g_object_unref (image2);
+}
+
+/**
+ * scale_image_parallel_perf:
+ * @fixture:
+ * @data:
+ *
+ * Compares the time it takes to scale an image with many layers one
+ * layer at a time, and with the layers scaled in parallel.
+ **/
+static void
+scale_image_parallel_perf (GimpTestFixture *fixture,
+                           gconstpointer    data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image1;
+  GimpImage *image2;
+  gint64     serial_time;
+  gint64     parallel_time;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  image1 = gimp_test_scale_image_new (gimp, GIMP_TEST_SCALE_PERF_SIZE,
+                                      GIMP_TEST_SCALE_PERF_N_LAYERS);
+  image2 = gimp_image_duplicate (image1);
+
+  serial_time   = gimp_test_scale_image (image1,
+                                         GIMP_TEST_SCALE_PERF_SIZE / 2,
+                                         FALSE);
+  parallel_time = gimp_test_scale_image (image2,
+                                         GIMP_TEST_SCALE_PERF_SIZE / 2,
+                                         TRUE);
+
+  g_test_message ("scaling %d layers: serial %.3f s  parallel %.3f s  "
+                  "(%.2fx)",
+                  GIMP_TEST_SCALE_PERF_N_LAYERS,
+                  serial_time   / 1000000.0,
+                  parallel_time / 1000000.0,
+                  (gdouble) serial_time / MAX (parallel_time, 1));
+
+  g_object_unref (image1);
+  g_object_unref (image2);
+}
+
+/* creates a buffer of randomly colored 8x8 blocks, which compresses
+ * well enough for drawable undos to keep it compressed
+ */
+static GeglBuffer *
+gimp_test_undo_buffer_new (gint    size,
+                           guint32 seed)
+{
+  GeglBuffer *buffer;
+  guchar     *data;
+  GRand      *rand = g_rand_new_with_seed (seed);
+  gint        x;
+  gint        y;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, size, size),
+                            babl_format ("R'G'B'A u8"));
+  data   = g_malloc ((gsize) size * size * 4);
+
+  for (y = 0; y < size; y += 8)
+    for (x = 0; x < size; x += 8)
+      {
+        guint32 color = g_rand_int (rand);
+        gint    i;
+        gint    j;
+
+        for (j = y; j < MIN (y + 8, size); j++)
+          for (i = x; i < MIN (x + 8, size); i++)
+            memcpy (data + 4 * ((gsize) j * size + i), &color, 4);
+      }
+
+  gegl_buffer_set (buffer, NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static void
+gimp_test_undo_wait_compressed (GimpDrawableUndo *undo)
+{
+  if (undo->compress_async)
+    gimp_waitable_wait (GIMP_WAITABLE (undo->compress_async));
+
+  while (undo->compress_async)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+/**
+ * drawable_undo_compression:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure undoing and redoing a drawable change restores exactly
+ * the same pixels, both when the undo buffer was compressed in the
+ * background, and when the undo is popped before compression
+ * finished.
+ **/
+static void
+drawable_undo_compression (GimpTestFixture *fixture,
+                           gconstpointer    data)
+{
+  Gimp       *gimp = GIMP (data);
+  GimpImage  *image;
+  GimpLayer  *layer;
+  GeglBuffer *before;
+  GeglBuffer *after;
+  gint        i;
+
+  g_assert_true (gimp->config->undo_compression);
+
+  before = gimp_test_undo_buffer_new (512, 1);
+  after  = gimp_test_undo_buffer_new (512, 2);
+
+  for (i = 0; i < 2; i++)
+    {
+      gboolean          wait = (i == 0);
+      GimpDrawable     *drawable;
+      GimpDrawableUndo *undo;
+      GeglBuffer       *undo_buffer;
+
+      image = gimp_image_new (gimp, 512, 512, GIMP_RGB,
+                              GIMP_PRECISION_U8_NON_LINEAR);
+      layer = gimp_layer_new (image, 512, 512,
+                              babl_format ("R'G'B'A u8"),
+                              "Undo Layer",
+                              GIMP_OPACITY_OPAQUE,
+                              GIMP_LAYER_MODE_NORMAL);
+      gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+
+      drawable = GIMP_DRAWABLE (layer);
+
+      gegl_buffer_copy (before, NULL, GEGL_ABYSS_NONE,
+                        gimp_drawable_get_buffer (drawable), NULL);
+
+      undo_buffer = gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+      undo = GIMP_DRAWABLE_UNDO (
+        gimp_image_undo_push_drawable (image, "Undo Compression",
+                                       drawable, undo_buffer, 0, 0));
+      g_object_unref (undo_buffer);
+
+      gegl_buffer_copy (after, NULL, GEGL_ABYSS_NONE,
+                        gimp_drawable_get_buffer (drawable), NULL);
+
+      if (wait)
+        {
+          gimp_test_undo_wait_compressed (undo);
+
+          g_assert_nonnull (undo->chunks);
+          g_assert_null (undo->buffer);
+        }
+
+      g_assert_true (gimp_image_undo (image));
+      gimp_test_assert_buffers_equal (before,
+                                      gimp_drawable_get_buffer (drawable));
+
+      if (wait)
+        {
+          gimp_test_undo_wait_compressed (undo);
+
+          g_assert_nonnull (undo->chunks);
+          g_assert_null (undo->buffer);
+        }
+
+      g_assert_true (gimp_image_redo (image));
+      gimp_test_assert_buffers_equal (after,
+                                      gimp_drawable_get_buffer (drawable));
+
+      g_assert_true (gimp_image_undo (image));
+      gimp_test_assert_buffers_equal (before,
+                                      gimp_drawable_get_buffer (drawable));
+
+      g_object_unref (image);
+    }
+
+  g_object_unref (before);
+  g_object_unref (after);
+}
+
+/* makes sure the size @stack accounted for its undos, and each undo
+ * group on it for its own undos, is the sum of their memory sizes,
+ * including their previews
+ */
+static void
+gimp_test_assert_undo_stack_size (GimpUndoStack *stack)
+{
+  gint64  memsize = 0;
+  GList  *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      GimpUndo *undo = list->data;
+      gint64    gui_size;
+
+      memsize += gimp_object_get_memsize (GIMP_OBJECT (undo), &gui_size);
+      memsize += gui_size;
+
+      if (GIMP_IS_UNDO_STACK (undo))
+        gimp_test_assert_undo_stack_size (GIMP_UNDO_STACK (undo));
+    }
+
+  g_assert_cmpint (gimp_undo_stack_get_size (stack), ==, memsize);
+}
+
+static void
+gimp_test_assert_undo_size (GimpImage *image)
+{
+  gimp_test_assert_undo_stack_size (gimp_image_get_undo_stack (image));
+  gimp_test_assert_undo_stack_size (gimp_image_get_redo_stack (image));
+}
+
+static GimpDrawableUndo *
+gimp_test_undo_push_drawable (GimpImage    *image,
+                              GimpDrawable *drawable,
+                              GeglBuffer   *buffer)
+{
+  GimpUndo   *undo;
+  GeglBuffer *undo_buffer;
+
+  undo_buffer = gegl_buffer_dup (gimp_drawable_get_buffer (drawable));
+  undo = gimp_image_undo_push_drawable (image, "Undo Size",
+                                        drawable, undo_buffer, 0, 0);
+  g_object_unref (undo_buffer);
+
+  gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE,
+                    gimp_drawable_get_buffer (drawable), NULL);
+
+  return GIMP_DRAWABLE_UNDO (undo);
+}
+
+/**
+ * undo_stack_size:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the size the undo and redo stacks keep track of matches
+ * the memory size of their undos, while pushing undo groups and single
+ * undos, once their buffers got compressed and their previews created,
+ * and while undoing, redoing and freeing them.
+ **/
+static void
+undo_stack_size (GimpTestFixture *fixture,
+                 gconstpointer    data)
+{
+  Gimp             *gimp = GIMP (data);
+  GimpImage        *image;
+  GimpLayer        *layer;
+  GimpDrawable     *drawable;
+  GimpUndoStack    *undo_stack;
+  GimpDrawableUndo *undos[16];
+  GeglBuffer       *buffers[2];
+  gint              n_undos = 0;
+  gint              undo_levels;
+  guint64           undo_size;
+  gint              i;
+
+  g_object_get (gimp->config,
+                "undo-levels", &undo_levels,
+                "undo-size",   &undo_size,
+                NULL);
+
+  buffers[0] = gimp_test_undo_buffer_new (256, 1);
+  buffers[1] = gimp_test_undo_buffer_new (256, 2);
+
+  image = gimp_image_new (gimp, 256, 256, GIMP_RGB,
+                          GIMP_PRECISION_U8_NON_LINEAR);
+  layer = gimp_layer_new (image, 256, 256,
+                          babl_format ("R'G'B'A u8"),
+                          "Undo Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+  gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+
+  drawable = GIMP_DRAWABLE (layer);
+
+  /*  push groups of several undos, and single undos between them  */
+  for (i = 0; i < 4; i++)
+    {
+      gint j;
+
+      gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_PAINT, NULL);
+
+      for (j = 0; j < 3; j++)
+        undos[n_undos++] = gimp_test_undo_push_drawable (image, drawable,
+                                                         buffers[j % 2]);
+
+      gimp_image_undo_group_end (image);
+      gimp_test_assert_undo_size (image);
+
+      undos[n_undos++] = gimp_test_undo_push_drawable (image, drawable,
+                                                       buffers[i % 2]);
+      gimp_test_assert_undo_size (image);
+    }
+
+  /*  compressing the undos, also within groups, changes their size  */
+  for (i = 0; i < n_undos; i++)
+    gimp_test_undo_wait_compressed (undos[i]);
+
+  gimp_test_assert_undo_size (image);
+
+  undo_stack = gimp_image_get_undo_stack (image);
+
+  gimp_undo_create_preview (gimp_undo_stack_peek (undo_stack),
+                            gimp_get_user_context (gimp), TRUE);
+  gimp_test_assert_undo_size (image);
+
+  /*  undoing and redoing moves single undos and groups between the
+   *  stacks, and swaps their buffers
+   */
+  for (i = 0; i < 3; i++)
+    {
+      g_assert_true (gimp_image_undo (image));
+      gimp_test_assert_undo_size (image);
+    }
+
+  g_assert_true (gimp_image_redo (image));
+  gimp_test_assert_undo_size (image);
+
+  for (i = 0; i < n_undos; i++)
+    gimp_test_undo_wait_compressed (undos[i]);
+
+  gimp_test_assert_undo_size (image);
+
+  /*  pushing frees the redo stack  */
+  gimp_test_undo_push_drawable (image, drawable, buffers[0]);
+  gimp_test_assert_undo_size (image);
+
+  /*  and, without undo space, the bottom of the undo stack  */
+  g_object_set (gimp->config,
+                "undo-levels", 1,
+                "undo-size",   (guint64) 0,
+                NULL);
+
+  gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_PAINT, NULL);
+  gimp_test_undo_push_drawable (image, drawable, buffers[1]);
+  gimp_test_undo_push_drawable (image, drawable, buffers[0]);
+  gimp_image_undo_group_end (image);
+
+  g_assert_cmpint (gimp_undo_stack_get_depth (undo_stack), ==, 1);
+  gimp_test_assert_undo_size (image);
+
+  g_object_set (gimp->config,
+                "undo-levels", undo_levels,
+                "undo-size",   undo_size,
+                NULL);
+
+  g_object_unref (image);
+  g_object_unref (buffers[0]);
+  g_object_unref (buffers[1]);
+}
+
+static void
+gimp_test_projection_update (GimpProjection *proj,
+                             gboolean        now,
+                             gint            x,
+                             gint            y,
+                             gint            width,
+                             gint            height,
+                             cairo_region_t *region)
+{
+  cairo_region_union_rectangle (region,
+                                &(cairo_rectangle_int_t) { x, y,
+                                                           width, height });
+}
+
+/**
+ * projection_render_async:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure projections rendered asynchronously, while the main
+ * loop runs, cover the whole image, and give exactly the same result
+ * as rendering them synchronously.
+ **/
+static void
+projection_render_async (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  Gimp           *gimp = GIMP (data);
+  GimpImage      *image1;
+  GimpImage      *image2;
+  GimpProjection *proj1;
+  GimpProjection *proj2;
+  cairo_region_t *region;
+  gint64          end_time;
+  gint            size = GIMP_TEST_SCALE_PERF_SIZE;
+
+  image1 = gimp_test_scale_image_new (gimp, size, GIMP_TEST_SCALE_N_LAYERS);
+  image2 = gimp_image_duplicate (image1);
+
+  g_object_set (gimp->config,
+                "projection-render-async", TRUE,
+                NULL);
+
+  proj1 = gimp_image_get_projection (image1);
+  proj2 = gimp_image_get_projection (image2);
+
+  /*  render the first one synchronously  */
+  gimp_pickable_flush (GIMP_PICKABLE (proj1));
+
+  /*  and the second one in the background, while running the main loop  */
+  region = cairo_region_create ();
+
+  g_signal_connect (proj2, "update",
+                    G_CALLBACK (gimp_test_projection_update),
+                    region);
+
+  gimp_pickable_get_buffer (GIMP_PICKABLE (proj2));
+
+  end_time = g_get_monotonic_time () + 60 * G_TIME_SPAN_SECOND;
+
+  while (cairo_region_contains_rectangle (
+           region,
+           &(cairo_rectangle_int_t) { 0, 0, size, size }) !=
+         CAIRO_REGION_OVERLAP_IN)
+    {
+      g_assert_cmpint (g_get_monotonic_time (), <, end_time);
+
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  g_signal_handlers_disconnect_by_func (proj2,
+                                        gimp_test_projection_update,
+                                        region);
+  cairo_region_destroy (region);
+
+  g_object_set (gimp->config,
+                "projection-render-async", FALSE,
+                NULL);
+
+  gimp_test_assert_buffers_equal (
+    gimp_pickable_get_buffer (GIMP_PICKABLE (proj1)),
+    gimp_pickable_get_buffer (GIMP_PICKABLE (proj2)));
+
+  g_object_unref (image1);
+  g_object_unref (image2);
+}
+
+/* creates a layer with a random pattern of light pixels, slightly above
+ * the percolation threshold, so that the light pixels form a large,
+ * maze-like region, with many small islands and holes
+ */
+static GimpLayer *
+gimp_test_fill_layer_new (GimpImage *image,
+                          gint       width,
+                          gint       height)
+{
+  GimpLayer  *layer;
+  GeglBuffer *buffer;
+  guchar     *data;
+  GRand      *rand = g_rand_new_with_seed (width + height);
+  gint        i;
+
+  layer = gimp_layer_new (image, width, height,
+                          babl_format ("R'G'B'A u8"),
+                          "Fill Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+  gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+
+  buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  data   = g_malloc ((gsize) width * height * 4);
+
+  for (i = 0; i < width * height; i++)
+    {
+      guchar *p = data + 4 * i;
+
+      /* make sure the top-left pixel is light */
+      if (i == 0 || g_rand_double (rand) < 0.65)
+        {
+          /* light pixels, close enough to each other to be antialiased */
+          p[0] = p[1] = p[2] = g_rand_int_range (rand, 200, 216);
+          p[3] = (i == 0 || g_rand_int_range (rand, 0, 32)) ? 255 : 0;
+        }
+      else
+        {
+          p[0] = g_rand_int_range (rand, 0, 100);
+          p[1] = g_rand_int_range (rand, 0, 100);
+          p[2] = g_rand_int_range (rand, 0, 100);
+          p[3] = 255;
+        }
+    }
+
+  gegl_buffer_set (buffer, NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return layer;
+}
+
+typedef struct
+{
+  GimpLayer *layer;
+  gboolean   diagonal_neighbors;
+  gint       x;
+  gint       y;
+} GimpTestFill;
+
+/* the antialiased difference of the composite criterion, for pixels which
+ * are never selected when they are transparent
+ */
+static gfloat
+gimp_test_fill_difference (const gfloat *col1,
+                           const gfloat *col2,
+                           gfloat        threshold)
+{
+  gfloat max = 0.0;
+  gfloat aa;
+  gint   b;
+
+  if (col2[3] == 0.0)
+    return 0.0;
+
+  for (b = 0; b < 3; b++)
+    {
+      gfloat diff = fabs (col1[b] - col2[b]);
+
+      if (diff > max)
+        max = diff;
+    }
+
+  aa = 1.5 - (max / threshold);
+
+  if (aa <= 0.0)
+    return 0.0;
+  else if (aa < 0.5)
+    return aa * 2.0;
+  else
+    return 1.0;
+}
+
+/* a reference flood fill, which selects the pixels connected to the seed
+ * one pixel at a time, on the calling thread
+ */
+static GeglBuffer *
+gimp_test_fill_reference (GimpTestFill *fill)
+{
+  GeglBuffer          *buffer;
+  const GeglRectangle *extent;
+  GeglBuffer          *mask_buffer;
+  gfloat               threshold = GIMP_TEST_FILL_THRESHOLD;
+  gfloat              *src;
+  gfloat              *mask;
+  gint                *stack;
+  gint                 n_stack   = 0;
+  const gfloat        *col;
+  gint                 width;
+  gint                 height;
+  gint                 i;
+
+  buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (fill->layer));
+  extent = gegl_buffer_get_extent (buffer);
+  width  = extent->width;
+  height = extent->height;
+
+  src   = g_new  (gfloat, (gsize) width * height * 4);
+  mask  = g_new0 (gfloat, (gsize) width * height);
+  stack = g_new  (gint,   (gsize) width * height);
+
+  gegl_buffer_get (buffer, extent, 1.0, babl_format ("R'G'B'A float"),
+                   src, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  i   = (fill->y - extent->y) * width + (fill->x - extent->x);
+  col = src + 4 * i;
+
+  mask[i] = gimp_test_fill_difference (col, col, threshold);
+
+  if (mask[i] > 0.0)
+    stack[n_stack++] = i;
+
+  while (n_stack > 0)
+    {
+      gint x, y;
+      gint dx, dy;
+
+      i = stack[--n_stack];
+      x = i % width;
+      y = i / width;
+
+      for (dy = -1; dy <= 1; dy++)
+        for (dx = -1; dx <= 1; dx++)
+          {
+            gint j;
+
+            if ((! dx && ! dy) ||
+                (dx && dy && ! fill->diagonal_neighbors))
+              continue;
+
+            if (x + dx < 0 || x + dx >= width ||
+                y + dy < 0 || y + dy >= height)
+              continue;
+
+            j = (y + dy) * width + (x + dx);
+
+            if (mask[j] > 0.0)
+              continue;
+
+            mask[j] = gimp_test_fill_difference (col, src + 4 * j, threshold);
+
+            if (mask[j] > 0.0)
+              stack[n_stack++] = j;
+          }
+    }
+
+  mask_buffer = gegl_buffer_new (extent, babl_format ("Y float"));
+
+  gegl_buffer_set (mask_buffer, NULL, 0, NULL, mask, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (src);
+  g_free (mask);
+  g_free (stack);
+
+  return mask_buffer;
+}
+
+static GeglBuffer *
+gimp_test_fill (GimpTestFill *fill,
+                gboolean      original)
+{
+  if (original)
+    return gimp_test_fill_reference (fill);
+
+  return gimp_pickable_contiguous_region_by_seed (GIMP_PICKABLE (fill->layer),
+                                                  TRUE,
+                                                  GIMP_TEST_FILL_THRESHOLD,
+                                                  FALSE,
+                                                  GIMP_SELECT_CRITERION_COMPOSITE,
+                                                  fill->diagonal_neighbors,
+                                                  fill->x, fill->y);
+}
+
+static void
+gimp_test_fill_compare (GimpLayer *layer,
+                        gboolean   diagonal_neighbors,
+                        gint       x,
+                        gint       y)
+{
+  GimpTestFill fill;
+
+  fill.layer              = layer;
+  fill.diagonal_neighbors = diagonal_neighbors;
+  fill.x                  = x;
+  fill.y                  = y;
+
+  gimp_test_compare_implementations (
+    (GimpTestRenderFunc) gimp_test_fill, &fill,
+    "reference", "flood fill",
+    "filling %dx%d from (%d, %d) (%s)",
+    gimp_item_get_width  (GIMP_ITEM (layer)),
+    gimp_item_get_height (GIMP_ITEM (layer)),
+    x, y,
+    diagonal_neighbors ? "8-connected" : "4-connected");
+}
+
+/**
+ * contiguous_region_parallel:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the flood fill, which switches to the parallel fill for
+ * large regions of large images, selects exactly the same region, with
+ * exactly the same antialiasing, as a reference fill, with and without
+ * diagonal neighbors, for seeds in the large region, in small islands,
+ * and on unselectable pixels.
+ **/
+static void
+contiguous_region_parallel (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpLayer *layer;
+  GRand     *rand = g_rand_new_with_seed (1);
+  gint       i;
+
+  image = gimp_image_new (gimp,
+                          GIMP_TEST_FILL_PARALLEL_SIZE,
+                          GIMP_TEST_FILL_PARALLEL_SIZE,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+  layer = gimp_test_fill_layer_new (image,
+                                    GIMP_TEST_FILL_PARALLEL_SIZE,
+                                    GIMP_TEST_FILL_PARALLEL_SIZE);
+
+  /*  the top-left pixel is always in the large region  */
+  gimp_test_fill_compare (layer, FALSE, 0, 0);
+  gimp_test_fill_compare (layer, TRUE,  0, 0);
+
+  for (i = 0; i < 16; i++)
+    {
+      gint x = g_rand_int_range (rand, 0, GIMP_TEST_FILL_PARALLEL_SIZE);
+      gint y = g_rand_int_range (rand, 0, GIMP_TEST_FILL_PARALLEL_SIZE);
+
+      gimp_test_fill_compare (layer, i % 2, x, y);
+    }
+
+  g_rand_free (rand);
+  g_object_unref (image);
+}
+
+/**
+ * contiguous_region_parallel_perf:
+ * @fixture:
+ * @data:
+ *
+ * Compares the time it takes a reference fill and the flood fill, which
+ * switches to the parallel fill, to select a large region of a large
+ * image.
+ **/
+static void
+contiguous_region_parallel_perf (GimpTestFixture *fixture,
+                                 gconstpointer    data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpLayer *layer;
+  gint       diagonal_neighbors;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  image = gimp_image_new (gimp,
+                          GIMP_TEST_FILL_PERF_SIZE, GIMP_TEST_FILL_PERF_SIZE,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+  layer = gimp_test_fill_layer_new (image,
+                                    GIMP_TEST_FILL_PERF_SIZE,
+                                    GIMP_TEST_FILL_PERF_SIZE);
+
+  for (diagonal_neighbors = 0; diagonal_neighbors < 2; diagonal_neighbors++)
+    gimp_test_fill_compare (layer, diagonal_neighbors, 0, 0);
+
+  g_object_unref (image);
+}
+
+static void
+gimp_test_assert_histograms_equal (GimpHistogram *histogram1,
+                                   GimpHistogram *histogram2)
+{
+  GimpHistogramChannel channel;
+
+  g_assert_cmpint (gimp_histogram_n_components (histogram1), ==,
+                   gimp_histogram_n_components (histogram2));
+  g_assert_cmpint (gimp_histogram_n_bins (histogram1), ==,
+                   gimp_histogram_n_bins (histogram2));
+
+  for (channel = GIMP_HISTOGRAM_VALUE;
+       channel <= GIMP_HISTOGRAM_LUMINANCE;
+       channel++)
+    {
+      gint bin;
+
+      for (bin = 0; bin < gimp_histogram_n_bins (histogram1); bin++)
+        {
+          gdouble value1 = gimp_histogram_get_value (histogram1, channel, bin);
+          gdouble value2 = gimp_histogram_get_value (histogram2, channel, bin);
+
+          g_assert_cmpfloat (fabs (value1 - value2), <=,
+                             1e-6 * MAX (1.0, fabs (value1)));
+        }
+    }
+}
+
+static void
+gimp_test_drawable_histogram_check (GimpDrawableHistogram *drawable_histogram)
+{
+  GimpDrawable  *drawable;
+  GimpHistogram *histogram;
+  GimpAsync     *async;
+
+  async = gimp_drawable_histogram_calculate_async (drawable_histogram);
+  gimp_waitable_wait (GIMP_WAITABLE (async));
+  g_assert_true (gimp_async_is_finished (async));
+  g_object_unref (async);
+
+  drawable  = gimp_drawable_histogram_get_drawable (drawable_histogram);
+  histogram = gimp_histogram_new (GIMP_TRC_NON_LINEAR);
+
+  gimp_drawable_calculate_histogram (drawable, histogram, FALSE);
+
+  gimp_test_assert_histograms_equal (
+    gimp_drawable_histogram_get_histogram (drawable_histogram),
+    histogram);
+
+  g_object_unref (histogram);
+}
+
+static void
+gimp_test_drawable_histogram_paint (GimpDrawable *drawable,
+                                    gint          x,
+                                    gint          y,
+                                    gint          width,
+                                    gint          height,
+                                    gdouble       value)
+{
+  GeglColor *color = gegl_color_new (NULL);
+
+  gegl_color_set_rgba (color, value, 1.0 - value, value / 2.0, value);
+
+  gegl_buffer_set_color (gimp_drawable_get_buffer (drawable),
+                         GEGL_RECTANGLE (x, y, width, height), color);
+
+  gimp_drawable_update (drawable, x, y, width, height);
+
+  g_object_unref (color);
+}
+
+/**
+ * drawable_histogram_incremental:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the incrementally maintained histogram of a drawable
+ * matches a freshly calculated one after small changes to the
+ * drawable, with and without a selection, and after many changes
+ * within a feathered selection.
+ **/
+static void
+drawable_histogram_incremental (GimpTestFixture *fixture,
+                                gconstpointer    data)
+{
+  Gimp                  *gimp = GIMP (data);
+  GimpImage             *image;
+  GimpLayer             *layer;
+  GimpDrawable          *drawable;
+  GimpHistogram         *histogram;
+  GimpDrawableHistogram *drawable_histogram;
+  gint                   i;
+
+  image = gimp_image_new (gimp,
+                          GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+  layer = gimp_test_fill_layer_new (image,
+                                    GIMP_TEST_FILL_WIDTH,
+                                    GIMP_TEST_FILL_HEIGHT);
+  drawable = GIMP_DRAWABLE (layer);
+
+  histogram          = gimp_histogram_new (GIMP_TRC_NON_LINEAR);
+  drawable_histogram = gimp_drawable_histogram_new (drawable, histogram,
+                                                    FALSE);
+
+  gimp_test_drawable_histogram_check (drawable_histogram);
+
+  /* small changes within a tile, and across tiles */
+  gimp_test_drawable_histogram_paint (drawable, 10, 10, 20, 20, 0.25);
+  gimp_test_drawable_histogram_check (drawable_histogram);
+
+  gimp_test_drawable_histogram_paint (drawable, 250, 240, 30, 40, 0.75);
+  gimp_test_drawable_histogram_paint (drawable, 600, 500, 5, 5, 1.0);
+  gimp_test_drawable_histogram_check (drawable_histogram);
+
+  /* the same with a selection */
+  gimp_channel_select_rectangle (gimp_image_get_mask (image),
+                                 100, 50, 400, 300,
+                                 GIMP_CHANNEL_OP_REPLACE,
+                                 TRUE, 10.0, 10.0,
+                                 FALSE);
+  gimp_image_flush (image);
+  gimp_test_drawable_histogram_check (drawable_histogram);
+
+  gimp_test_drawable_histogram_paint (drawable, 90, 40, 50, 50, 0.5);
+  gimp_test_drawable_histogram_check (drawable_histogram);
+
+  /* many small changes across the feathered edge of the selection, more
+   * than the number of incremental updates after which the sum is
+   * rebuilt
+   */
+  for (i = 0; i < 100; i++)
+    {
+      gimp_test_drawable_histogram_paint (drawable,
+                                          95 + i % 10, 45 + i % 7, 20, 20,
+                                          (i % 16) / 15.0);
+      gimp_test_drawable_histogram_check (drawable_histogram);
+    }
+
+  gimp_channel_clear (gimp_image_get_mask (image), NULL, FALSE);
+  gimp_image_flush (image);
+  gimp_test_drawable_histogram_check (drawable_histogram);
+
+  g_object_unref (drawable_histogram);
+  g_object_unref (histogram);
+  g_object_unref (image);
+}
+
+static void
+gimp_test_text_layer_update (GimpDrawable  *drawable,
+                             gint           x,
+                             gint           y,
+                             gint           width,
+                             gint           height,
+                             GeglRectangle *area)
+{
+  gegl_rectangle_bounding_box (area, area,
+                               GEGL_RECTANGLE (x, y, width, height));
+}
+
+/* changes the text of @layer, and makes sure the result is identical
+ * to a text layer rendered from scratch with the same text.  returns
+ * the area of @layer which was rendered again.
+ */
+static GeglRectangle
+gimp_test_text_layer_change (GimpTextLayer *layer,
+                             const gchar   *first_property_name,
+                             ...)
+{
+  GimpImage     *image = gimp_item_get_image (GIMP_ITEM (layer));
+  GimpLayer     *reference;
+  GimpText      *text;
+  GeglRectangle  area  = { 0, };
+  va_list        args;
+
+  g_signal_connect (layer, "update",
+                    G_CALLBACK (gimp_test_text_layer_update),
+                    &area);
+
+  va_start (args, first_property_name);
+  g_object_set_valist (G_OBJECT (layer->text), first_property_name, args);
+  va_end (args);
+
+  g_signal_handlers_disconnect_by_func (layer,
+                                        gimp_test_text_layer_update,
+                                        &area);
+
+  text      = gimp_config_duplicate (GIMP_CONFIG (layer->text));
+  reference = gimp_text_layer_new (image, text);
+  g_object_unref (text);
+
+  gimp_test_assert_buffers_equal (
+    gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+    gimp_drawable_get_buffer (GIMP_DRAWABLE (reference)));
+
+  g_object_unref (g_object_ref_sink (reference));
+
+  return area;
+}
+
+/**
+ * text_layer_partial_render:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure re-rendering only the changed lines of a text layer gives
+ * exactly the same result as rendering the whole layer, after editing
+ * one line, toggling markup, and changing the line spacing, and that
+ * editing one line only re-renders part of the layer.
+ **/
+static void
+text_layer_partial_render (GimpTestFixture *fixture,
+                           gconstpointer    data)
+{
+  Gimp          *gimp = GIMP (data);
+  GimpContainer *fonts;
+  GimpImage     *image;
+  GimpText      *text;
+  GimpLayer     *layer;
+  GeglRectangle  area;
+  gint           width;
+  gint           height;
+
+  gimp_data_factory_data_wait (gimp->font_factory);
+  fonts = gimp_data_factory_get_container (gimp->font_factory);
+
+  if (gimp_container_is_empty (fonts))
+    {
+      g_test_skip ("no fonts available");
+      return;
+    }
+
+  image = gimp_image_new (gimp, 400, 300,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+
+  text = g_object_new (GIMP_TYPE_TEXT,
+                       "text",       "First line\nSecond line\nThird line",
+                       "font",       "Sans-serif",
+                       "font-size",  24.0,
+                       "box-mode",   GIMP_TEXT_BOX_FIXED,
+                       "box-width",  400.0,
+                       "box-height", 300.0,
+                       NULL);
+
+  layer = gimp_text_layer_new (image, text);
+  g_object_unref (text);
+
+  gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+
+  width  = gimp_item_get_width  (GIMP_ITEM (layer));
+  height = gimp_item_get_height (GIMP_ITEM (layer));
+
+  /* edit one line */
+  area = gimp_test_text_layer_change (GIMP_TEXT_LAYER (layer),
+                                      "text",
+                                      "First line\nSecond lime\nThird line",
+                                      NULL);
+  g_assert_cmpint (area.height, >, 0);
+  g_assert_cmpint (area.height, <, height);
+
+  /* toggle markup on, and off again */
+  gimp_test_text_layer_change (GIMP_TEXT_LAYER (layer),
+                               "markup",
+                               "<markup>First line\n"
+                               "<b>Second</b> lime\n"
+                               "Third line</markup>",
+                               NULL);
+  gimp_test_text_layer_change (GIMP_TEXT_LAYER (layer),
+                               "text",
+                               "First line\nSecond lime\nThird line",
+                               NULL);
+
+  /* change the line spacing, and edit a line with the new spacing */
+  area = gimp_test_text_layer_change (GIMP_TEXT_LAYER (layer),
+                                      "line-spacing", 10.0,
+                                      NULL);
+  g_assert_cmpint (area.width,  ==, width);
+  g_assert_cmpint (area.height, ==, height);
+
+  area = gimp_test_text_layer_change (GIMP_TEXT_LAYER (layer),
+                                      "text",
+                                      "First line\nSecond lime\nThird lines",
+                                      NULL);
+  g_assert_cmpint (area.height, >, 0);
+  g_assert_cmpint (area.height, <, height);
+
+  g_object_unref (image);
+}
+
+typedef struct
+{
+  gint          n_invalidate;
+  gint          n_invalidate_area;
+  GeglRectangle area;
+} GimpTestInvalidateData;
+
+static void
+gimp_test_invalidate_preview (GimpViewable           *viewable,
+                              GimpTestInvalidateData *data)
+{
+  /* "invalidate-preview-area" comes first */
+  g_assert_cmpint (data->n_invalidate, ==, data->n_invalidate_area - 1);
+
+  data->n_invalidate++;
+}
+
+static void
+gimp_test_invalidate_preview_area (GimpViewable           *viewable,
+                                   gint                    x,
+                                   gint                    y,
+                                   gint                    width,
+                                   gint                    height,
+                                   GimpTestInvalidateData *data)
+{
+  data->n_invalidate_area++;
+  data->area = *GEGL_RECTANGLE (x, y, width, height);
+}
+
+/**
+ * invalidate_preview_area:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure drawable updates invalidate the preview of the changed
+ * area, also while the preview is frozen, and that rendering an area
+ * of a drawable preview gives the same pixels as rendering the whole
+ * preview.
+ **/
+static void
+invalidate_preview_area (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  Gimp                   *gimp = GIMP (data);
+  GimpImage              *image;
+  GimpLayer              *layer;
+  GimpDrawable           *drawable;
+  GimpTestInvalidateData  invalidate = { 0, };
+  GimpAsync              *async;
+  GimpTempBuf            *preview;
+  GimpTempBuf            *area_preview;
+  const GeglRectangle     area = { 17, 9, 31, 22 };
+  gint                    bpp;
+  gint                    y;
+
+  image = gimp_image_new (gimp,
+                          GIMP_TEST_FILL_WIDTH, GIMP_TEST_FILL_HEIGHT,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+  layer = gimp_test_fill_layer_new (image,
+                                    GIMP_TEST_FILL_WIDTH,
+                                    GIMP_TEST_FILL_HEIGHT);
+  drawable = GIMP_DRAWABLE (layer);
+
+  g_signal_connect (drawable, "invalidate-preview",
+                    G_CALLBACK (gimp_test_invalidate_preview),
+                    &invalidate);
+  g_signal_connect (drawable, "invalidate-preview-area",
+                    G_CALLBACK (gimp_test_invalidate_preview_area),
+                    &invalidate);
+
+  gimp_drawable_update (drawable, 10, 20, 30, 40);
+
+  g_assert_cmpint (invalidate.n_invalidate,      ==, 1);
+  g_assert_cmpint (invalidate.n_invalidate_area, ==, 1);
+  g_assert_true (gegl_rectangle_equal (&invalidate.area,
+                                       GEGL_RECTANGLE (10, 20, 30, 40)));
+
+  /* updates of a frozen preview are accumulated */
+  gimp_viewable_preview_freeze (GIMP_VIEWABLE (drawable));
+
+  gimp_drawable_update (drawable, 10, 20, 30, 40);
+  gimp_drawable_update (drawable, 100, 5, 10, 10);
+
+  g_assert_cmpint (invalidate.n_invalidate_area, ==, 1);
+
+  gimp_viewable_preview_thaw (GIMP_VIEWABLE (drawable));
+
+  g_assert_cmpint (invalidate.n_invalidate,      ==, 2);
+  g_assert_cmpint (invalidate.n_invalidate_area, ==, 2);
+  g_assert_true (gegl_rectangle_equal (&invalidate.area,
+                                       GEGL_RECTANGLE (10, 5, 100, 55)));
+
+  /* ... unless the whole preview is invalidated */
+  gimp_viewable_preview_freeze (GIMP_VIEWABLE (drawable));
+
+  gimp_drawable_update (drawable, 10, 20, 30, 40);
+  gimp_viewable_invalidate_preview (GIMP_VIEWABLE (drawable));
+
+  gimp_viewable_preview_thaw (GIMP_VIEWABLE (drawable));
+
+  g_assert_cmpint (invalidate.n_invalidate,      ==, 3);
+  g_assert_cmpint (invalidate.n_invalidate_area, ==, 2);
+
+  g_signal_handlers_disconnect_by_data (drawable, &invalidate);
+
+  /* an area of the preview is the same as the area of the full preview */
+  async = gimp_drawable_get_sub_preview_async (drawable,
+                                               50, 30, 400, 300,
+                                               80, 60);
+  gimp_waitable_wait (GIMP_WAITABLE (async));
+  g_assert_true (gimp_async_is_finished (async));
+  preview = gimp_temp_buf_ref (gimp_async_get_result (async));
+  g_object_unref (async);
+
+  async = gimp_drawable_get_sub_preview_area_async (drawable,
+                                                    50, 30, 400, 300,
+                                                    80, 60,
+                                                    &area);
+  gimp_waitable_wait (GIMP_WAITABLE (async));
+  g_assert_true (gimp_async_is_finished (async));
+  area_preview = gimp_temp_buf_ref (gimp_async_get_result (async));
+  g_object_unref (async);
+
+  g_assert_cmpint (gimp_temp_buf_get_width  (area_preview), ==, area.width);
+  g_assert_cmpint (gimp_temp_buf_get_height (area_preview), ==, area.height);
+
+  bpp = babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (preview));
+
+  for (y = 0; y < area.height; y++)
+    {
+      const guchar *row1 = gimp_temp_buf_get_data (preview) +
+                           ((area.y + y) * 80 + area.x) * bpp;
+      const guchar *row2 = gimp_temp_buf_get_data (area_preview) +
+                           y * area.width * bpp;
+
+      g_assert_cmpint (memcmp (row1, row2, area.width * bpp), ==, 0);
+    }
+
+  gimp_temp_buf_unref (area_preview);
+  gimp_temp_buf_unref (preview);
+
+  g_object_unref (image);
+}
+
+/* creates an image with a tall and a short layer of noisy gradients,
+ * which have far more colors than fit into a colormap.  the short layer
+ * is a copy of the top of the tall one, and fits into a single strip of
+ * error diffusion.
+ */
+static GimpImage *
+gimp_test_convert_indexed_image_new (Gimp *gimp)
+{
+  GimpImage *image;
+  GRand     *rand   = g_rand_new_with_seed (19);
+  gint       width  = 300;
+  gint       height = 400;
+  guchar    *data;
+  guchar    *p;
+  gint       x, y;
+  gint       i;
+
+  image = gimp_image_new (gimp, width, height,
+                          GIMP_RGB, GIMP_PRECISION_U8_NON_LINEAR);
+
+  data = g_malloc ((gsize) width * height * 4);
+  p    = data;
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          *p++ = CLAMP (x * 255 / width  + g_rand_int_range (rand, -8, 8),
+                        0, 255);
+          *p++ = CLAMP (y * 255 / height + g_rand_int_range (rand, -8, 8),
+                        0, 255);
+          *p++ = g_rand_int_range (rand, 0, 256);
+          *p++ = 255;
+        }
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      GimpLayer *layer;
+
+      layer = gimp_layer_new (image, width, i == 0 ? height : 100,
+                              babl_format ("R'G'B'A u8"),
+                              "Test Layer",
+                              GIMP_OPACITY_OPAQUE,
+                              GIMP_LAYER_MODE_NORMAL);
+
+      gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                       NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+
+      gimp_image_add_layer (image, layer, NULL, 0, FALSE);
+    }
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return image;
+}
+
+/* converts a copy of @image to indexed mode, using @n_threads threads
+ */
+static GimpImage *
+gimp_test_convert_indexed (GimpImage              *image,
+                           GimpConvertPaletteType  palette_type,
+                           GimpConvertDitherType   dither_type,
+                           gint                    n_threads)
+{
+  Gimp      *gimp = image->gimp;
+  GimpImage *copy;
+  gint       num_processors;
+
+  copy = gimp_image_duplicate (image);
+
+  g_object_get (gimp->config,
+                "num-processors", &num_processors,
+                NULL);
+  g_object_set (gimp->config,
+                "num-processors", n_threads,
+                NULL);
+
+  g_assert_true (gimp_image_convert_indexed (copy, palette_type, 64,
+                                             FALSE, dither_type,
+                                             FALSE, FALSE, NULL, NULL,
+                                             NULL));
+
+  g_object_set (gimp->config,
+                "num-processors", num_processors,
+                NULL);
+
+  return copy;
+}
+
+/* asserts that the colormaps of @image1 and @image2 are the same, and
+ * all of their layers
+ */
+static void
+gimp_test_assert_indexed_equal (GimpImage *image1,
+                                GimpImage *image2)
+{
+  GList *layers1;
+  GList *layers2;
+  GList *list1;
+  GList *list2;
+  gint   n_colors;
+
+  n_colors = gimp_image_get_colormap_size (image1);
+
+  g_assert_cmpint (n_colors, ==, gimp_image_get_colormap_size (image2));
+  g_assert_cmpint (memcmp (gimp_image_get_colormap (image1),
+                           gimp_image_get_colormap (image2),
+                           n_colors * 3), ==, 0);
+
+  layers1 = gimp_image_get_layer_list (image1);
+  layers2 = gimp_image_get_layer_list (image2);
+
+  for (list1 = layers1, list2 = layers2;
+       list1 && list2;
+       list1 = g_list_next (list1), list2 = g_list_next (list2))
+    {
+      gimp_test_assert_buffers_equal (
+        gimp_drawable_get_buffer (GIMP_DRAWABLE (list1->data)),
+        gimp_drawable_get_buffer (GIMP_DRAWABLE (list2->data)));
+    }
+
+  g_list_free (layers1);
+  g_list_free (layers2);
+}
+
+/* asserts that the short layer of @image, converted in one piece, is
+ * the same as the top of the tall one, converted in several strips or
+ * areas, see gimp_test_convert_indexed_image_new()
+ */
+static void
+gimp_test_assert_indexed_top_equal (GimpImage *image)
+{
+  GList      *layers = gimp_image_get_layer_list (image);
+  GeglBuffer *tall;
+  GeglBuffer *shorter;
+  GeglBuffer *top;
+
+  g_assert_cmpuint (g_list_length (layers), ==, 2);
+
+  shorter = gimp_drawable_get_buffer (GIMP_DRAWABLE (layers->data));
+  tall    = gimp_drawable_get_buffer (GIMP_DRAWABLE (layers->next->data));
+
+  g_assert_cmpint (gegl_buffer_get_height (shorter), <,
+                   gegl_buffer_get_height (tall));
+
+  top = gegl_buffer_create_sub_buffer (tall,
+                                       gegl_buffer_get_extent (shorter));
+
+  gimp_test_assert_buffers_equal (shorter, top);
+
+  g_object_unref (top);
+  g_list_free (layers);
+}
+
+/**
+ * convert_indexed_parallel:
+ * @fixture:
+ * @data:
+ *
+ * Converts an image to indexed mode with different palettes and
+ * dithering types, and makes sure the result doesn't depend on the
+ * number of threads, and that a layer's pixels are mapped the same,
+ * whether or not it is split into strips and areas: error diffusion
+ * only carries errors right and down, so the top of a layer can't
+ * depend on what is below it.
+ **/
+static void
+convert_indexed_parallel (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  const GimpConvertPaletteType palette_types[] =
+  {
+    GIMP_CONVERT_PALETTE_GENERATE,
+    GIMP_CONVERT_PALETTE_WEB
+  };
+  const GimpConvertDitherType dither_types[] =
+  {
+    GIMP_CONVERT_DITHER_NONE,
+    GIMP_CONVERT_DITHER_FIXED,
+    GIMP_CONVERT_DITHER_FS,
+    GIMP_CONVERT_DITHER_FS_LOWBLEED
+  };
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  gint       n_threads;
+  gint       i;
+  gint       j;
+
+  image = gimp_test_convert_indexed_image_new (gimp);
+
+  n_threads = MAX (g_get_num_processors (), 4);
+
+  for (i = 0; i < G_N_ELEMENTS (palette_types); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (dither_types); j++)
+        {
+          GimpImage *single;
+          GimpImage *multi;
+
+          single = gimp_test_convert_indexed (image, palette_types[i],
+                                              dither_types[j], 1);
+          multi  = gimp_test_convert_indexed (image, palette_types[i],
+                                              dither_types[j], n_threads);
+
+          gimp_test_assert_indexed_equal (single, multi);
+          gimp_test_assert_indexed_top_equal (single);
+          gimp_test_assert_indexed_top_equal (multi);
+
+          g_object_unref (single);
+          g_object_unref (multi);
+        }
+    }
+
+  g_object_unref (image);
+}
+
+/* creates a mask of random noise, which is about as bad as it gets for
+ * gimp_boundary_find(): almost every pixel edge is part of the boundary.
+ * the bottom part is a 1-pixel checkerboard, whose segments all meet
+ * diagonally.  the noise comes from a fixed generator, so that the
+ * test is reproducible.
+ */
+static GeglBuffer *
+gimp_test_boundary_mask_new (gint width,
+                             gint height)
+{
+  GeglBuffer *mask;
+  gfloat     *data;
+  guint32     seed = width + height;
+  gint        x, y;
+
+  mask = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                          babl_format ("Y float"));
+  data = g_new (gfloat, (gsize) width * height);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          gfloat value;
+
+          seed = seed * 1103515245 + 12345;
+
+          if (y < height * 3 / 4)
+            value = (seed >> 16) & 1 ? 1.0 : 0.0;
+          else
+            value = (x + y) % 2 ? 1.0 : 0.0;
+
+          data[y * width + x] = value;
+        }
+    }
+
+  gegl_buffer_set (mask, NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+
+  return mask;
+}
+
+/* whether the pixel at @x, @y is inside the boundary of @data, the
+ * contents of a @width x @height mask, for @type
+ */
+static gboolean
+gimp_test_boundary_inside (const gfloat     *data,
+                           gint              width,
+                           gint              height,
+                           GimpBoundaryType  type,
+                           gint              x,
+                           gint              y)
+{
+  gboolean in_bounds;
+
+  if (x < 0 || x >= width || y < 0 || y >= height)
+    return FALSE;
+
+  if (data[y * width + x] <= GIMP_BOUNDARY_HALF_WAY)
+    return FALSE;
+
+  in_bounds = (x >= GIMP_TEST_BOUNDARY_X1 && x < GIMP_TEST_BOUNDARY_X2 &&
+               y >= GIMP_TEST_BOUNDARY_Y1 && y < GIMP_TEST_BOUNDARY_Y2);
+
+  /* GIMP_BOUNDARY_IGNORE_BOUNDS outlines what is outside the bounds */
+  if (type == GIMP_BOUNDARY_WITHIN_BOUNDS)
+    return in_bounds;
+  else
+    return ! in_bounds;
+}
+
+/* makes sure @segs lie on pixel edges, each with the inside of the
+ * mask on the same side, and that together they cover every edge
+ * between a pixel inside and one outside exactly once
+ */
+static void
+gimp_test_assert_boundary_segs (GeglBuffer         *mask,
+                                GimpBoundaryType    type,
+                                const GimpBoundSeg *segs,
+                                gint                n_segs)
+{
+  gint     width  = gegl_buffer_get_width  (mask);
+  gint     height = gegl_buffer_get_height (mask);
+  gfloat  *data;
+  guint8  *horiz_edges;
+  guint8  *vert_edges;
+  gint     horiz_open = -1;
+  gint     vert_open  = -1;
+  gint     n_edges    = 0;
+  gint     n_expected = 0;
+  gint     x, y;
+  gint     i;
+
+  data = g_new (gfloat, (gsize) width * height);
+  gegl_buffer_get (mask, NULL, 1.0, babl_format ("Y float"),
+                   data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  /* horizontal edges are above pixel rows 0..height, vertical edges
+   * left of pixel columns 0..width
+   */
+  horiz_edges = g_new0 (guint8, (gsize) width * (height + 1));
+  vert_edges  = g_new0 (guint8, (gsize) (width + 1) * height);
+
+  for (i = 0; i < n_segs; i++)
+    {
+      const GimpBoundSeg *seg = &segs[i];
+
+      g_assert_true (seg->x1 == seg->x2 || seg->y1 == seg->y2);
+
+      if (seg->y1 == seg->y2)
+        {
+          gint     x1 = MIN (seg->x1, seg->x2);
+          gint     x2 = MAX (seg->x1, seg->x2);
+          gboolean below;
+
+          g_assert_cmpint (x1, <, x2);
+          g_assert_cmpint (x1, >=, 0);
+          g_assert_cmpint (x2, <=, width);
+          g_assert_cmpint (seg->y1, >=, 0);
+          g_assert_cmpint (seg->y1, <=, height);
+
+          below = gimp_test_boundary_inside (data, width, height, type,
+                                             x1, seg->y1);
+
+          if (horiz_open < 0)
+            horiz_open = (seg->open == below);
+
+          g_assert_cmpint (seg->open == below, ==, horiz_open);
+
+          for (x = x1; x < x2; x++)
+            {
+              g_assert_true (gimp_test_boundary_inside (data, width, height,
+                                                        type,
+                                                        x, seg->y1) == below);
+              g_assert_true (gimp_test_boundary_inside (data, width, height,
+                                                        type,
+                                                        x, seg->y1 - 1) != below);
+
+              g_assert_false (horiz_edges[seg->y1 * width + x]);
+              horiz_edges[seg->y1 * width + x] = TRUE;
+              n_edges++;
+            }
+        }
+      else
+        {
+          gint     y1 = MIN (seg->y1, seg->y2);
+          gint     y2 = MAX (seg->y1, seg->y2);
+          gboolean right;
+
+          g_assert_cmpint (y1, <, y2);
+          g_assert_cmpint (y1, >=, 0);
+          g_assert_cmpint (y2, <=, height);
+          g_assert_cmpint (seg->x1, >=, 0);
+          g_assert_cmpint (seg->x1, <=, width);
+
+          right = gimp_test_boundary_inside (data, width, height, type,
+                                             seg->x1, y1);
+
+          if (vert_open < 0)
+            vert_open = (seg->open == right);
+
+          g_assert_cmpint (seg->open == right, ==, vert_open);
+
+          for (y = y1; y < y2; y++)
+            {
+              g_assert_true (gimp_test_boundary_inside (data, width, height,
+                                                        type,
+                                                        seg->x1, y) == right);
+              g_assert_true (gimp_test_boundary_inside (data, width, height,
+                                                        type,
+                                                        seg->x1 - 1, y) != right);
+
+              g_assert_false (vert_edges[y * (width + 1) + seg->x1]);
+              vert_edges[y * (width + 1) + seg->x1] = TRUE;
+              n_edges++;
+            }
+        }
+    }
+
+  for (y = 0; y <= height; y++)
+    {
+      for (x = 0; x <= width; x++)
+        {
+          gboolean inside = gimp_test_boundary_inside (data, width, height,
+                                                       type, x, y);
+
+          if (x < width &&
+              inside != gimp_test_boundary_inside (data, width, height,
+                                                   type, x, y - 1))
+            {
+              n_expected++;
+            }
+
+          if (y < height &&
+              inside != gimp_test_boundary_inside (data, width, height,
+                                                   type, x - 1, y))
+            {
+              n_expected++;
+            }
+        }
+    }
+
+  g_assert_cmpint (n_edges, ==, n_expected);
+
+  g_free (vert_edges);
+  g_free (horiz_edges);
+  g_free (data);
+}
+
+/* makes sure each of the @n_groups groups of @sorted is a closed loop
+ * of connected segments, and that they hold @n_segs segments
+ */
+static void
+gimp_test_assert_boundary_loops (const GimpBoundSeg *sorted,
+                                 gint                n_segs,
+                                 gint                n_groups)
+{
+  gint start = 0;
+  gint group = 0;
+  gint i;
+
+  for (i = 0; i < n_segs + n_groups; i++)
+    {
+      if (sorted[i].x1 == -1)
+        {
+          g_assert_cmpint (sorted[i].y1, ==, -1);
+          g_assert_cmpint (sorted[i].x2, ==, -1);
+          g_assert_cmpint (sorted[i].y2, ==, -1);
+
+          g_assert_cmpint (i, >, start);
+          g_assert_cmpint (sorted[i - 1].x2, ==, sorted[start].x1);
+          g_assert_cmpint (sorted[i - 1].y2, ==, sorted[start].y1);
+
+          start = i + 1;
+          group++;
+        }
+      else if (i > start)
+        {
+          g_assert_cmpint (sorted[i - 1].x2, ==, sorted[i].x1);
+          g_assert_cmpint (sorted[i - 1].y2, ==, sorted[i].y1);
+        }
+    }
+
+  g_assert_cmpint (start, ==, n_segs + n_groups);
+  g_assert_cmpint (group, ==, n_groups);
+}
+
+/* the bsearch()-based gimp_boundary_sort() which the hash-based one
+ * replaced, as a reference for it
+ */
+
+static gint
+gimp_test_boundary_cmp_xy (gint ax,
+                           gint ay,
+                           gint bx,
+                           gint by)
+{
+  if (ay != by)
+    return ay < by ? -1 : 1;
+  else if (ax != bx)
+    return ax < bx ? -1 : 1;
+
+  return 0;
+}
+
+static gint
+gimp_test_boundary_cmp_xy1_addr (const GimpBoundSeg **seg_ptr_a,
+                                 const GimpBoundSeg **seg_ptr_b)
+{
+  const GimpBoundSeg *seg_a  = *seg_ptr_a;
+  const GimpBoundSeg *seg_b  = *seg_ptr_b;
+  gint                result = gimp_test_boundary_cmp_xy (seg_a->x1, seg_a->y1,
+                                                          seg_b->x1, seg_b->y1);
+
+  if (result == 0 && seg_a != seg_b)
+    result = seg_a < seg_b ? -1 : 1;
+
+  return result;
+}
+
+static gint
+gimp_test_boundary_cmp_xy2_addr (const GimpBoundSeg **seg_ptr_a,
+                                 const GimpBoundSeg **seg_ptr_b)
+{
+  const GimpBoundSeg *seg_a  = *seg_ptr_a;
+  const GimpBoundSeg *seg_b  = *seg_ptr_b;
+  gint                result = gimp_test_boundary_cmp_xy (seg_a->x2, seg_a->y2,
+                                                          seg_b->x2, seg_b->y2);
+
+  if (result == 0 && seg_a != seg_b)
+    result = seg_a < seg_b ? -1 : 1;
+
+  return result;
+}
+
+static gint
+gimp_test_boundary_cmp_xy1 (const GimpBoundSeg **seg_ptr_a,
+                            const GimpBoundSeg **seg_ptr_b)
+{
+  return gimp_test_boundary_cmp_xy ((*seg_ptr_a)->x1, (*seg_ptr_a)->y1,
+                                    (*seg_ptr_b)->x1, (*seg_ptr_b)->y1);
+}
+
+static gint
+gimp_test_boundary_cmp_xy2 (const GimpBoundSeg **seg_ptr_a,
+                            const GimpBoundSeg **seg_ptr_b)
+{
+  return gimp_test_boundary_cmp_xy ((*seg_ptr_a)->x2, (*seg_ptr_a)->y2,
+                                    (*seg_ptr_b)->x2, (*seg_ptr_b)->y2);
+}
+
+static GimpBoundSeg *
+gimp_test_boundary_find_with_func (GimpBoundSeg **segs,
+                                   gint           n_segs,
+                                   GimpBoundSeg  *search_seg,
+                                   GCompareFunc   cmp_func)
+{
+  GimpBoundSeg **seg;
+
+  seg = bsearch (&search_seg, segs, n_segs, sizeof (GimpBoundSeg *),
+                 cmp_func);
+
+  if (! seg)
+    return NULL;
+
+  /* find the first matching segment */
+  while (seg > segs && cmp_func (seg - 1, &search_seg) == 0)
+    seg--;
+
+  /* find the first non-visited segment */
+  for (; seg != segs + n_segs && cmp_func (seg, &search_seg) == 0; seg++)
+    {
+      if (! (*seg)->visited)
+        return *seg;
+    }
+
+  return NULL;
+}
+
+static GimpBoundSeg *
+gimp_test_boundary_sort_reference (const GimpBoundSeg *segs,
+                                   gint                n_segs,
+                                   gint               *n_groups)
+{
+  GimpBoundSeg  *copy;
+  GimpBoundSeg **by_xy1;
+  GimpBoundSeg **by_xy2;
+  GArray        *sorted;
+  GimpBoundSeg   marker = { -1, -1, -1, -1, 0, 0 };
+  gint           i;
+
+  copy   = g_memdup2 (segs, sizeof (GimpBoundSeg) * n_segs);
+  by_xy1 = g_new (GimpBoundSeg *, n_segs);
+  by_xy2 = g_new (GimpBoundSeg *, n_segs);
+  sorted = g_array_new (FALSE, FALSE, sizeof (GimpBoundSeg));
+
+  for (i = 0; i < n_segs; i++)
+    {
+      copy[i].visited = FALSE;
+
+      by_xy1[i] = &copy[i];
+      by_xy2[i] = &copy[i];
+    }
+
+  qsort (by_xy1, n_segs, sizeof (GimpBoundSeg *),
+         (GCompareFunc) gimp_test_boundary_cmp_xy1_addr);
+  qsort (by_xy2, n_segs, sizeof (GimpBoundSeg *),
+         (GCompareFunc) gimp_test_boundary_cmp_xy2_addr);
+
+  *n_groups = 0;
+
+  for (i = 0; i < n_segs; i++)
+    {
+      GimpBoundSeg  search_seg = { 0, };
+      GimpBoundSeg *seg;
+      GimpBoundSeg  next;
+
+      if (copy[i].visited)
+        continue;
+
+      next = copy[i];
+      g_array_append_val (sorted, next);
+      copy[i].visited = TRUE;
+
+      for (;;)
+        {
+          GimpBoundSeg *seg1;
+          GimpBoundSeg *seg2;
+
+          search_seg.x1 = search_seg.x2 = next.x2;
+          search_seg.y1 = search_seg.y2 = next.y2;
+
+          seg1 = gimp_test_boundary_find_with_func (
+                   by_xy1, n_segs, &search_seg,
+                   (GCompareFunc) gimp_test_boundary_cmp_xy1);
+          seg2 = gimp_test_boundary_find_with_func (
+                   by_xy2, n_segs, &search_seg,
+                   (GCompareFunc) gimp_test_boundary_cmp_xy2);
+
+          /* use the segment with the smaller address */
+          if (seg1 && seg2)
+            seg = MIN (seg1, seg2);
+          else
+            seg = seg1 ? seg1 : seg2;
+
+          if (! seg)
+            break;
+
+          next = *seg;
+
+          if (next.x1 != search_seg.x1 || next.y1 != search_seg.y1)
+            {
+              next.x1 = seg->x2;
+              next.y1 = seg->y2;
+              next.x2 = seg->x1;
+              next.y2 = seg->y1;
+            }
+
+          g_array_append_val (sorted, next);
+          seg->visited = TRUE;
+        }
+
+      g_array_append_val (sorted, marker);
+      (*n_groups)++;
+    }
+
+  g_free (by_xy2);
+  g_free (by_xy1);
+  g_free (copy);
+
+  return (GimpBoundSeg *) g_array_free (sorted, FALSE);
+}
+
+static GimpBoundSeg *
+gimp_test_boundary_find (GeglBuffer       *mask,
+                         GimpBoundaryFind  find,
+                         GimpBoundaryType  type,
+                         gint             *n_segs,
+                         gint64           *time)
+{
+  GimpBoundSeg *segs;
+  gint64        start;
+
+  start = g_get_monotonic_time ();
+
+  segs = gimp_boundary_find_with_method (mask, NULL,
+                                         babl_format ("Y float"),
+                                         type,
+                                         GIMP_TEST_BOUNDARY_X1,
+                                         GIMP_TEST_BOUNDARY_Y1,
+                                         GIMP_TEST_BOUNDARY_X2,
+                                         GIMP_TEST_BOUNDARY_Y2,
+                                         GIMP_BOUNDARY_HALF_WAY,
+                                         find,
+                                         n_segs);
+
+  if (time)
+    *time = g_get_monotonic_time () - start;
+
+  return segs;
+}
+
+static void
+gimp_test_assert_segs_equal (const GimpBoundSeg *segs,
+                             const GimpBoundSeg *expected,
+                             gint                n_segs,
+                             gboolean            open)
+{
+  gint i;
+
+  for (i = 0; i < n_segs; i++)
+    {
+      g_assert_cmpint (segs[i].x1, ==, expected[i].x1);
+      g_assert_cmpint (segs[i].y1, ==, expected[i].y1);
+      g_assert_cmpint (segs[i].x2, ==, expected[i].x2);
+      g_assert_cmpint (segs[i].y2, ==, expected[i].y2);
+
+      if (open)
+        g_assert_cmpint (segs[i].open, ==, expected[i].open);
+    }
+}
+
+/**
+ * boundary_find_parallel:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure finding a boundary serially, in parallel, and in as many
+ * bands as possible gives exactly the same segments, in the same
+ * order, that they outline the mask along pixel edges, and that
+ * sorting them gives the same closed loops as the bsearch()-based
+ * sort did.
+ **/
+static void
+boundary_find_parallel (GimpTestFixture *fixture,
+                        gconstpointer    data)
+{
+  const GimpBoundaryFind  finds[] = { GIMP_BOUNDARY_FIND_PARALLEL,
+                                      GIMP_BOUNDARY_FIND_AUTO };
+  GeglBuffer             *mask;
+  GimpBoundaryType        type;
+
+  mask = gimp_test_boundary_mask_new (GIMP_TEST_FILL_WIDTH,
+                                      GIMP_TEST_FILL_HEIGHT);
+
+  for (type = GIMP_BOUNDARY_WITHIN_BOUNDS;
+       type <= GIMP_BOUNDARY_IGNORE_BOUNDS;
+       type++)
+    {
+      GimpBoundSeg *serial;
+      GimpBoundSeg *sorted;
+      GimpBoundSeg *expected;
+      gint          n_serial;
+      gint          n_groups;
+      gint          n_expected_groups;
+      gint          i;
+
+      serial = gimp_test_boundary_find (mask, GIMP_BOUNDARY_FIND_SERIAL,
+                                        type, &n_serial, NULL);
+
+      g_assert_cmpint (n_serial, >, 0);
+
+      gimp_test_assert_boundary_segs (mask, type, serial, n_serial);
+
+      for (i = 0; i < G_N_ELEMENTS (finds); i++)
+        {
+          GimpBoundSeg *segs;
+          gint          n_segs;
+
+          segs = gimp_test_boundary_find (mask, finds[i], type,
+                                          &n_segs, NULL);
+
+          g_assert_cmpint (n_segs, ==, n_serial);
+          gimp_test_assert_segs_equal (segs, serial, n_segs, TRUE);
+
+          g_free (segs);
+        }
+
+      sorted   = gimp_boundary_sort (serial, n_serial, &n_groups);
+      expected = gimp_test_boundary_sort_reference (serial, n_serial,
+                                                    &n_expected_groups);
+
+      g_assert_cmpint (n_groups, ==, n_expected_groups);
+      gimp_test_assert_segs_equal (sorted, expected, n_serial + n_groups,
+                                   FALSE);
+
+      gimp_test_assert_boundary_loops (sorted, n_serial, n_groups);
+
+      g_free (expected);
+      g_free (sorted);
+      g_free (serial);
+    }
+
+  g_object_unref (mask);
+}
+
+/**
+ * boundary_find_parallel_perf:
+ * @fixture:
+ * @data:
+ *
+ * Compares the time it takes to find the boundary of a large noise
+ * mask serially and in parallel, and measures sorting it.
+ **/
+static void
+boundary_find_parallel_perf (GimpTestFixture *fixture,
+                             gconstpointer    data)
+{
+  GeglBuffer   *mask;
+  GimpBoundSeg *segs;
+  GimpBoundSeg *sorted;
+  gint          n_segs;
+  gint          n_groups;
+  gint64        serial_time;
+  gint64        parallel_time;
+  gint64        sort_time;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  mask = gimp_test_boundary_mask_new (GIMP_TEST_FILL_PERF_SIZE,
+                                      GIMP_TEST_FILL_PERF_SIZE);
+
+  segs = gimp_test_boundary_find (mask, GIMP_BOUNDARY_FIND_SERIAL,
+                                  GIMP_BOUNDARY_IGNORE_BOUNDS,
+                                  &n_segs, &serial_time);
+  g_free (segs);
+
+  segs = gimp_test_boundary_find (mask, GIMP_BOUNDARY_FIND_AUTO,
+                                  GIMP_BOUNDARY_IGNORE_BOUNDS,
+                                  &n_segs, &parallel_time);
+
+  gimp_test_report_times ("serial",   serial_time,
+                          "parallel", parallel_time,
+                          "finding %d segments in %dx%d",
+                          n_segs,
+                          GIMP_TEST_FILL_PERF_SIZE,
+                          GIMP_TEST_FILL_PERF_SIZE);
+
+  sort_time = g_get_monotonic_time ();
+  sorted    = gimp_boundary_sort (segs, n_segs, &n_groups);
+  sort_time = g_get_monotonic_time () - sort_time;
+
+  g_test_message ("sorting into %d groups: %.3f s",
+                  n_groups, sort_time / 1000000.0);
+
+  g_free (sorted);
+  g_free (segs);
+  g_object_unref (mask);
+}
+
+/* creates a star-shaped cage of @n_points points inside a square of
+ * @size pixels, and drags every other point outwards
+ */
+static GimpCageConfig *
+gimp_test_cage_config_new (gint n_points,
+                           gint size)
+{
+  GimpCageConfig *config = g_object_new (GIMP_TYPE_CAGE_CONFIG, NULL);
+  gint            i;
+
+  for (i = 0; i < n_points; i++)
+    {
+      gdouble angle  = 2.0 * G_PI * i / n_points;
+      gdouble radius = size * (i % 2 ? 0.3 : 0.4);
+
+      gimp_cage_config_add_cage_point (config,
+                                       size / 2 + radius * cos (angle),
+                                       size / 2 + radius * sin (angle));
+    }
+
+  gimp_cage_config_reverse_cage_if_needed (config);
+
+  gimp_cage_config_deselect_points (config);
+
+  for (i = 0; i < n_points; i += 2)
+    gimp_cage_config_toggle_point_selection (config, i);
+
+  gimp_cage_config_add_displacement (config, GIMP_CAGE_MODE_DEFORM,
+                                     size * 0.05, size * 0.03);
+  gimp_cage_config_commit_displacement (config);
+
+  return config;
+}
+
+/* reference versions of gimp:cage-coef-calc and gimp:cage-transform,
+ * which compute everything for each pixel and cell of the cage, in
+ * order, on the calling thread
+ */
+
+static gboolean
+gimp_test_cage_is_on_straight (GimpVector2 *d1,
+                               GimpVector2 *d2,
+                               GimpVector2 *p)
+{
+  GimpVector2 v1, v2;
+  gfloat      deter;
+
+  v1.x = p->x - d1->x;
+  v1.y = p->y - d1->y;
+  v2.x = d2->x - d1->x;
+  v2.y = d2->y - d1->y;
+
+  gimp_vector2_normalize (&v1);
+  gimp_vector2_normalize (&v2);
+
+  deter = v1.x * v2.y - v2.x * v1.y;
+
+  return (deter < 0.000000001) && (deter > -0.000000001);
+}
+
+static void
+gimp_test_cage_coef_calc_reference (GimpCageConfig *config,
+                                    GeglBuffer     *output)
+{
+  const GeglRectangle *roi             = gegl_buffer_get_extent (output);
+  guint                n_cage_vertices = gimp_cage_config_get_n_points (config);
+  gfloat              *coef;
+  gfloat              *c;
+  gint                 x, y;
+  gint                 j;
+
+  coef = g_new0 (gfloat, (gsize) roi->width * roi->height *
+                         2 * n_cage_vertices);
+  c    = coef;
+
+  for (y = roi->y; y < roi->y + roi->height; y++)
+    {
+      for (x = roi->x; x < roi->x + roi->width; x++)
+        {
+          if (gimp_cage_config_point_inside (config, x, y))
+            {
+              GimpCagePoint *last;
+              GimpCagePoint *current;
+
+              last = &g_array_index (config->cage_points, GimpCagePoint, 0);
+
+              for (j = 0; j < n_cage_vertices; j++)
+                {
+                  GimpVector2 v1, v2, a, b, p;
+                  gdouble     BA, SRT, L0, L1, A0, A1, A10, L10, Q, S, R, absa;
+
+                  current = &g_array_index (config->cage_points, GimpCagePoint,
+                                            (j + 1) % n_cage_vertices);
+                  v1 = last->src_point;
+                  v2 = current->src_point;
+                  p.x = x;
+                  p.y = y;
+                  a.x = v2.x - v1.x;
+                  a.y = v2.y - v1.y;
+                  absa = gimp_vector2_length (&a);
+
+                  b.x = v1.x - x;
+                  b.y = v1.y - y;
+                  Q = a.x * a.x + a.y * a.y;
+                  S = b.x * b.x + b.y * b.y;
+                  R = 2.0 * (a.x * b.x + a.y * b.y);
+                  BA = b.x * a.y - b.y * a.x;
+                  SRT = sqrt (4.0 * S * Q - R * R);
+
+                  L0 = log (S);
+                  L1 = log (S + Q + R);
+                  A0 = atan2 (R, SRT) / SRT;
+                  A1 = atan2 (2.0 * Q + R, SRT) / SRT;
+                  A10 = A1 - A0;
+                  L10 = L1 - L0;
+
+                  /* edge coef */
+                  c[j + n_cage_vertices] = (-absa / (4.0 * G_PI)) * ((4.0 * S - (R * R) / Q) * A10 + (R / (2.0 * Q)) * L10 + L1 - 2.0);
+
+                  if (isnan (c[j + n_cage_vertices]))
+                    c[j + n_cage_vertices] = 0.0;
+
+                  /* vertex coef */
+                  if (! gimp_test_cage_is_on_straight (&v1, &v2, &p))
+                    {
+                      c[j] += (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (2.0 + R / Q));
+                      c[(j + 1) % n_cage_vertices] -= (BA / (2.0 * G_PI)) * (L10 / (2.0 * Q) - A10 * (R / Q));
+                    }
+
+                  last = current;
+                }
+            }
+
+          c += 2 * n_cage_vertices;
+        }
+    }
+
+  gegl_buffer_set (output, roi, 0,
+                   babl_format_n (babl_type ("float"), 2 * n_cage_vertices),
+                   coef, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (coef);
+}
+
+static GimpVector2
+gimp_test_cage_compute_destination (GimpCageConfig *config,
+                                    const gfloat   *coef)
+{
+  GimpVector2 result          = { 0, 0 };
+  gint        n_cage_vertices = gimp_cage_config_get_n_points (config);
+  gint        i;
+
+  for (i = 0; i < n_cage_vertices; i++)
+    {
+      GimpCagePoint *point = &g_array_index (config->cage_points,
+                                             GimpCagePoint, i);
+
+      result.x += coef[i] * point->dest_point.x;
+      result.y += coef[i] * point->dest_point.y;
+
+      result.x += coef[i + n_cage_vertices] * point->edge_scaling_factor * point->edge_normal.x;
+      result.y += coef[i + n_cage_vertices] * point->edge_scaling_factor * point->edge_normal.y;
+    }
+
+  return result;
+}
+
+static void
+gimp_test_cage_interpolate (const GeglRectangle *roi,
+                            gfloat              *output,
+                            GimpVector2          p1_s,
+                            GimpVector2          p1_d,
+                            GimpVector2          p2_s,
+                            GimpVector2          p2_d,
+                            GimpVector2          p3_s,
+                            GimpVector2          p3_d,
+                            gint                 recursion_depth)
+{
+  gint xmin, xmax, ymin, ymax, x, y;
+
+  /* stop if all 3 vertices of the triangle are outside the roi */
+  if (p1_d.x >= roi->x + roi->width &&
+      p2_d.x >= roi->x + roi->width &&
+      p3_d.x >= roi->x + roi->width) return;
+  if (p1_d.y >= roi->y + roi->height &&
+      p2_d.y >= roi->y + roi->height &&
+      p3_d.y >= roi->y + roi->height) return;
+
+  if (p1_d.x < roi->x &&
+      p2_d.x < roi->x &&
+      p3_d.x < roi->x) return;
+  if (p1_d.y < roi->y &&
+      p2_d.y < roi->y &&
+      p3_d.y < roi->y) return;
+
+  xmin = xmax = lrint (p1_d.x);
+  ymin = ymax = lrint (p1_d.y);
+
+  x = lrint (p2_d.x);
+  xmin = MIN (x, xmin);
+  xmax = MAX (x, xmax);
+
+  x = lrint (p3_d.x);
+  xmin = MIN (x, xmin);
+  xmax = MAX (x, xmax);
+
+  y = lrint (p2_d.y);
+  ymin = MIN (y, ymin);
+  ymax = MAX (y, ymax);
+
+  y = lrint (p3_d.y);
+  ymin = MIN (y, ymin);
+  ymax = MAX (y, ymax);
+
+  /* no more pixel in the triangle, or too deep a recursion */
+  if (xmin == xmax || ymin == ymax || recursion_depth > 5)
+    return;
+
+  if (xmax - xmin == 1 && ymax - ymin == 1)
+    {
+      gdouble a, b, c, denom, x, y;
+
+      x = (gdouble) xmin + 0.5;
+      y = (gdouble) ymin + 0.5;
+
+      denom = (p2_d.x - p1_d.x) * p3_d.y + (p1_d.x - p3_d.x) * p2_d.y + (p3_d.x - p2_d.x) * p1_d.y;
+      a = ((p2_d.x - x) * p3_d.y + (x - p3_d.x) * p2_d.y + (p3_d.x - p2_d.x) * y) / denom;
+      b = - ((p1_d.x - x) * p3_d.y + (x - p3_d.x) * p1_d.y + (p3_d.x - p1_d.x) * y) / denom;
+      c = 1.0 - a - b;
+
+      if (((a > 0 && b > 0 && c > 0) || (a < 0 && b < 0 && c < 0)) &&
+          xmin >= roi->x && xmin < roi->x + roi->width &&
+          ymin >= roi->y && ymin < roi->y + roi->height)
+        {
+          gfloat *coords = output + 2 * ((ymin - roi->y) * roi->width +
+                                         (xmin - roi->x));
+
+          coords[0] = (a * p1_s.x + b * p2_s.x + c * p3_s.x);
+          coords[1] = (a * p1_s.y + b * p2_s.y + c * p3_s.y);
+        }
+    }
+  else
+    {
+      GimpVector2 pm1_d, pm2_d, pm3_d;
+      GimpVector2 pm1_s, pm2_s, pm3_s;
+
+      pm1_d.x = (p1_d.x + p2_d.x) / 2.0;
+      pm1_d.y = (p1_d.y + p2_d.y) / 2.0;
+
+      pm2_d.x = (p2_d.x + p3_d.x) / 2.0;
+      pm2_d.y = (p2_d.y + p3_d.y) / 2.0;
+
+      pm3_d.x = (p3_d.x + p1_d.x) / 2.0;
+      pm3_d.y = (p3_d.y + p1_d.y) / 2.0;
+
+      pm1_s.x = (p1_s.x + p2_s.x) / 2.0;
+      pm1_s.y = (p1_s.y + p2_s.y) / 2.0;
+
+      pm2_s.x = (p2_s.x + p3_s.x) / 2.0;
+      pm2_s.y = (p2_s.y + p3_s.y) / 2.0;
+
+      pm3_s.x = (p3_s.x + p1_s.x) / 2.0;
+      pm3_s.y = (p3_s.y + p1_s.y) / 2.0;
+
+      gimp_test_cage_interpolate (roi, output,
+                                  p1_s, p1_d, pm1_s, pm1_d, pm3_s, pm3_d,
+                                  recursion_depth + 1);
+      gimp_test_cage_interpolate (roi, output,
+                                  pm1_s, pm1_d, p2_s, p2_d, pm2_s, pm2_d,
+                                  recursion_depth + 1);
+      gimp_test_cage_interpolate (roi, output,
+                                  pm1_s, pm1_d, pm2_s, pm2_d, pm3_s, pm3_d,
+                                  recursion_depth + 1);
+      gimp_test_cage_interpolate (roi, output,
+                                  pm3_s, pm3_d, pm2_s, pm2_d, p3_s, p3_d,
+                                  recursion_depth + 1);
+    }
+}
+
+static void
+gimp_test_cage_transform_reference (GimpCageConfig *config,
+                                    GeglBuffer     *coef_buffer,
+                                    GeglBuffer     *output_buffer)
+{
+  const GeglRectangle *roi     = gegl_buffer_get_extent (output_buffer);
+  GeglRectangle        cage_bb = gimp_cage_config_get_bounding_box (config);
+  guint                n_cage_vertices;
+  const Babl          *format_coef;
+  gfloat              *output;
+  gfloat              *coef;
+  gint                 x, y;
+
+  n_cage_vertices = gimp_cage_config_get_n_points (config);
+  format_coef     = babl_format_n (babl_type ("float"), 2 * n_cage_vertices);
+
+  /* pre-fill the output with no-displacement coordinates */
+  output = g_new (gfloat, (gsize) roi->width * roi->height * 2);
+
+  for (y = 0; y < roi->height; y++)
+    {
+      for (x = 0; x < roi->width; x++)
+        {
+          output[2 * (y * roi->width + x) + 0] = roi->x + x + 0.5;
+          output[2 * (y * roi->width + x) + 1] = roi->y + y + 0.5;
+        }
+    }
+
+  coef = g_new (gfloat, 2 * n_cage_vertices);
+
+  /* compute, reverse and interpolate the transformation */
+  for (y = cage_bb.y; y < cage_bb.y + cage_bb.height - 1; y++)
+    {
+      GimpVector2 p1_d, p2_d, p3_d, p4_d;
+      GimpVector2 p1_s, p2_s, p3_s, p4_s;
+
+      p3_s.x = cage_bb.x;
+      p3_s.y = y + 1;
+      p4_s.x = cage_bb.x;
+      p4_s.y = y;
+
+      gegl_buffer_get (coef_buffer, GEGL_RECTANGLE (p3_s.x, p3_s.y, 1, 1),
+                       1.0, format_coef, coef,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      p3_d = gimp_test_cage_compute_destination (config, coef);
+      gegl_buffer_get (coef_buffer, GEGL_RECTANGLE (p4_s.x, p4_s.y, 1, 1),
+                       1.0, format_coef, coef,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      p4_d = gimp_test_cage_compute_destination (config, coef);
+
+      for (x = cage_bb.x; x < cage_bb.x + cage_bb.width - 1; x++)
+        {
+          p1_s = p4_s;
+          p2_s = p3_s;
+          p3_s.x = x + 1;
+          p4_s.x = x + 1;
+
+          p1_d = p4_d;
+          p2_d = p3_d;
+          gegl_buffer_get (coef_buffer, GEGL_RECTANGLE (p3_s.x, p3_s.y, 1, 1),
+                           1.0, format_coef, coef,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          p3_d = gimp_test_cage_compute_destination (config, coef);
+          gegl_buffer_get (coef_buffer, GEGL_RECTANGLE (p4_s.x, p4_s.y, 1, 1),
+                           1.0, format_coef, coef,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          p4_d = gimp_test_cage_compute_destination (config, coef);
+
+          if (gimp_cage_config_point_inside (config, x, y))
+            {
+              gimp_test_cage_interpolate (roi, output,
+                                          p1_s, p1_d, p2_s, p2_d, p3_s, p3_d,
+                                          0);
+              gimp_test_cage_interpolate (roi, output,
+                                          p1_s, p1_d, p3_s, p3_d, p4_s, p4_d,
+                                          0);
+            }
+        }
+    }
+
+  gegl_buffer_set (output_buffer, roi, 0,
+                   babl_format_n (babl_type ("float"), 2),
+                   output, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (coef);
+  g_free (output);
+}
+
+typedef struct
+{
+  GimpCageConfig *config;
+  gint            size;
+} GimpTestCage;
+
+static GeglBuffer *
+gimp_test_cage_transform (GimpTestCage *cage,
+                          gboolean      original)
+{
+  GimpCageConfig *config = cage->config;
+  GeglNode       *graph;
+  GeglNode       *node;
+  GeglNode       *input;
+  GeglNode       *coef;
+  GeglNode       *transform;
+  GeglNode       *output;
+  GeglBuffer     *input_buffer;
+  GeglBuffer     *coef_buffer;
+  GeglBuffer     *buffer;
+  GeglRectangle   cage_bb = gimp_cage_config_get_bounding_box (config);
+
+  input_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, cage->size, cage->size),
+                                  babl_format ("R'G'B'A u8"));
+  coef_buffer  = gegl_buffer_new (&cage_bb,
+                                  babl_format_n (babl_type ("float"),
+                                                 2 * gimp_cage_config_get_n_points (config)));
+  buffer       = gegl_buffer_new (GEGL_RECTANGLE (0, 0, cage->size, cage->size),
+                                  babl_format_n (babl_type ("float"), 2));
+
+  if (original)
+    {
+      gimp_test_cage_coef_calc_reference (config, coef_buffer);
+      gimp_test_cage_transform_reference (config, coef_buffer, buffer);
+
+      g_object_unref (coef_buffer);
+      g_object_unref (input_buffer);
+
+      return buffer;
+    }
+
+  graph = gegl_node_new ();
+
+  node   = gegl_node_new_child (graph,
+                                "operation", "gimp:cage-coef-calc",
+                                "config",    config,
+                                NULL);
+  output = gegl_node_new_child (graph,
+                                "operation", "gegl:write-buffer",
+                                "buffer",    coef_buffer,
+                                NULL);
+
+  gegl_node_link (node, output);
+  gegl_node_process (output);
+
+  g_object_unref (graph);
+
+  graph = gegl_node_new ();
+
+  input     = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    input_buffer,
+                                   NULL);
+  coef      = gegl_node_new_child (graph,
+                                   "operation", "gegl:buffer-source",
+                                   "buffer",    coef_buffer,
+                                   NULL);
+  transform = gegl_node_new_child (graph,
+                                   "operation", "gimp:cage-transform",
+                                   "config",    config,
+                                   NULL);
+  output    = gegl_node_new_child (graph,
+                                   "operation", "gegl:write-buffer",
+                                   "buffer",    buffer,
+                                   NULL);
+
+  gegl_node_link (input, transform);
+  gegl_node_connect (coef, "output",
+                     transform, "aux");
+  gegl_node_link (transform, output);
+  gegl_node_process (output);
+
+  g_object_unref (graph);
+
+  g_object_unref (coef_buffer);
+  g_object_unref (input_buffer);
+
+  return buffer;
+}
+
+static void
+gimp_test_cage_compare (gint n_points,
+                        gint size)
+{
+  GimpTestCage cage;
+
+  cage.config = gimp_test_cage_config_new (n_points, size);
+  cage.size   = size;
+
+  gimp_test_compare_implementations (
+    (GimpTestRenderFunc) gimp_test_cage_transform, &cage,
+    "reference", "parallel",
+    "%d cage points in %dx%d", n_points, size, size);
+
+  g_object_unref (cage.config);
+}
+
+/**
+ * cage_transform_parallel:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure computing the cage coefficients and transform coordinates
+ * in parallel gives exactly the same result as the reference
+ * implementation.
+ **/
+static void
+cage_transform_parallel (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  gimp_test_cage_compare (12, GIMP_TEST_CAGE_SIZE);
+}
+
+/**
+ * cage_transform_parallel_perf:
+ * @fixture:
+ * @data:
+ *
+ * Compares the time it takes to compute the cage transform coordinates
+ * of a large area serially and in parallel, for an increasing number
+ * of cage points.
+ **/
+static void
+cage_transform_parallel_perf (GimpTestFixture *fixture,
+                              gconstpointer    data)
+{
+  gint n_points;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  for (n_points = 4; n_points <= 64; n_points *= 2)
+    gimp_test_cage_compare (n_points, GIMP_TEST_CAGE_PERF_SIZE);
+}
+
+static GeglBuffer *
+gimp_test_distance_mask_new (gint size)
+{
+  GeglBuffer *mask;
+  gfloat     *data;
+  GRand      *rand = g_rand_new_with_seed (size);
+  gint        i, x, y;
+
+  mask = gegl_buffer_new (GEGL_RECTANGLE (0, 0, size, size),
+                          babl_format ("Y float"));
+  data = g_new0 (gfloat, (gsize) size * size);
+
+  /*  some large blobs, touching the edges, and some isolated pixels  */
+  for (i = 0; i < 40; i++)
+    {
+      gint x1 = g_rand_int_range (rand, -size / 8, size);
+      gint y1 = g_rand_int_range (rand, -size / 8, size);
+      gint x2 = MIN (x1 + g_rand_int_range (rand, 1, size / 4), size);
+      gint y2 = MIN (y1 + g_rand_int_range (rand, 1, size / 4), size);
+
+      for (y = MAX (y1, 0); y < y2; y++)
+        for (x = MAX (x1, 0); x < x2; x++)
+          data[y * size + x] = i % 4 ? 1.0 : 0.0;
+    }
+
+  for (i = 0; i < size; i++)
+    {
+      x = g_rand_int_range (rand, 0, size);
+      y = g_rand_int_range (rand, 0, size);
+
+      data[y * size + x] = 1.0 - data[y * size + x];
+    }
+
+  gegl_buffer_set (mask, NULL, 0, NULL, data, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (data);
+  g_rand_free (rand);
+
+  return mask;
+}
+
+/* the original row-by-row filter of gimp:border, which looks for the
+ * transitional pixels within the ellipse around each pixel in a window
+ * of rows, as a reference for the distance transform which replaced it
+ */
+
+static inline void
+gimp_test_border_rotate_pointers (gfloat  **p,
+                                  guint32   n)
+{
+  guint32  i;
+  gfloat  *tmp;
+
+  tmp = p[0];
+
+  for (i = 0; i < n - 1; i++)
+    p[i] = p[i + 1];
+
+  p[i] = tmp;
+}
+
+/* Computes whether pixels in `buf[1]', if they are selected, have neighbouring
+   pixels that are unselected. Put result in `transition'. */
+static void
+gimp_test_border_compute_transition (gfloat    *transition,
+                                     gfloat   **buf,
+                                     gint32     width,
+                                     gboolean   edge_lock)
+{
+  register gint32 x = 0;
+
+  if (width == 1)
+    {
+      if (buf[1][0] >= 0.5 && (buf[0][0] < 0.5 || buf[2][0] < 0.5))
+        transition[0] = 1.0;
+      else
+        transition[0] = 0.0;
+      return;
+    }
+
+  if (buf[1][0] >= 0.5 && edge_lock)
+    {
+      /* The pixel to the left (outside of the canvas) is considered selected,
+         so we check if there are any unselected pixels in neighbouring pixels
+         _on_ the canvas. */
+      if (buf[0][x] < 0.5 || buf[0][x + 1] < 0.5 ||
+                             buf[1][x + 1] < 0.5 ||
+          buf[2][x] < 0.5 || buf[2][x + 1] < 0.5 )
+        {
+          transition[x] = 1.0;
+        }
+      else
+        {
+          transition[x] = 0.0;
+        }
+    }
+  else if (buf[1][0] >= 0.5 && !edge_lock)
+    {
+      /* We must not care about neighbouring pixels on the image canvas since
+         there always are unselected pixels to the left (which is outside of
+         the image canvas). */
+      transition[x] = 1.0;
+    }
+  else
+    {
+      transition[x] = 0.0;
+    }
+
+  for (x = 1; x < width - 1; x++)
+    {
+      if (buf[1][x] >= 0.5)
+        {
+          if (buf[0][x - 1] < 0.5 || buf[0][x] < 0.5 || buf[0][x + 1] < 0.5 ||
+              buf[1][x - 1] < 0.5 ||                    buf[1][x + 1] < 0.5 ||
+              buf[2][x - 1] < 0.5 || buf[2][x] < 0.5 || buf[2][x + 1] < 0.5)
+            transition[x] = 1.0;
+          else
+            transition[x] = 0.0;
+        }
+      else
+        {
+          transition[x] = 0.0;
+        }
+    }
+
+  if (buf[1][width - 1] >= 0.5 && edge_lock)
+    {
+      /* The pixel to the right (outside of the canvas) is considered selected,
+         so we check if there are any unselected pixels in neighbouring pixels
+         _on_ the canvas. */
+      if ( buf[0][x - 1] < 0.5 || buf[0][x] < 0.5 ||
+           buf[1][x - 1] < 0.5 ||
+           buf[2][x - 1] < 0.5 || buf[2][x] < 0.5)
+        {
+          transition[width - 1] = 1.0;
+        }
+      else
+        {
+          transition[width - 1] = 0.0;
+        }
+    }
+  else if (buf[1][width - 1] >= 0.5 && !edge_lock)
+    {
+      /* We must not care about neighbouring pixels on the image canvas since
+         there always are unselected pixels to the right (which is outside of
+         the image canvas). */
+      transition[width - 1] = 1.0;
+    }
+  else
+    {
+      transition[width - 1] = 0.0;
+    }
+}
+
+static void
+gimp_test_border_reference (GeglBuffer *input,
+                            GeglBuffer *output,
+                            gint        radius_x,
+                            gint        radius_y,
+                            gboolean    feather,
+                            gboolean    edge_lock)
+{
+  const GeglRectangle *roi           = gegl_buffer_get_extent (input);
+  const Babl          *input_format  = babl_format ("Y float");
+  const Babl          *output_format = babl_format ("Y float");
+
+  gint32 i, j, x, y;
+
+  /* A cache used in the algorithm as it works its way down. `buf[1]' is the
+     current row. Thus, at algorithm initialization, `buf[0]' represents the
+     row 'above' the first row of the region. */
+  gfloat  *buf[3];
+
+  /* The resulting selection is calculated row by row, and this buffer holds the
+     output for each individual row, on each iteration. */
+  gfloat  *out;
+
+  /* Keeps track of transitional pixels (pixels that are selected and have
+     unselected neighbouring pixels). */
+  gfloat **transition;
+
+  /* TODO: Figure out role clearly in algorithm. */
+  gint16  *max;
+
+  /* TODO: Figure out role clearly in algorithm. */
+  gfloat **density;
+
+  gint16   last_index;
+
+  max = g_new (gint16, roi->width + 2 * radius_x);
+
+  for (i = 0; i < (roi->width + 2 * radius_x); i++)
+    max[i] = radius_y + 2;
+
+  max += radius_x;
+
+  for (i = 0; i < 3; i++)
+    buf[i] = g_new (gfloat, roi->width);
+
+  transition = g_new (gfloat *, radius_y + 1);
+
+  for (i = 0; i < radius_y + 1; i++)
+    {
+      transition[i] = g_new (gfloat, roi->width + 2 * radius_x);
+      memset (transition[i], 0,
+              (roi->width + 2 * radius_x) * sizeof (gfloat));
+      transition[i] += radius_x;
+    }
+
+  out = g_new (gfloat, roi->width);
+
+  density = g_new (gfloat *, 2 * radius_x + 1);
+  density += radius_x;
+
+  /* allocate density[][] */
+  for (x = 0; x < (radius_x + 1); x++)
+    {
+      density[ x]  = g_new (gfloat, 2 * radius_y + 1);
+      density[ x] += radius_y;
+      density[-x]  = density[x];
+    }
+
+  /* compute density[][] */
+  for (x = 0; x < (radius_x + 1); x++)
+    {
+      gdouble tmpx, tmpy, dist;
+      gfloat  a;
+
+      if (x > 0)
+        tmpx = x - 0.5;
+      else if (x < 0)
+        tmpx = x + 0.5;
+      else
+        tmpx = 0.0;
+
+      for (y = 0; y < (radius_y + 1); y++)
+        {
+          if (y > 0)
+            tmpy = y - 0.5;
+          else if (y < 0)
+            tmpy = y + 0.5;
+          else
+            tmpy = 0.0;
+
+          dist = ((tmpy * tmpy) / (radius_y * radius_y) +
+                  (tmpx * tmpx) / (radius_x * radius_x));
+
+          if (dist < 1.0)
+            {
+              if (feather)
+                a = 1.0 - sqrt (dist);
+              else
+                a = 1.0;
+            }
+          else
+            {
+              a = 0.0;
+            }
+
+          density[ x][ y] = a;
+          density[ x][-y] = a;
+          density[-x][ y] = a;
+          density[-x][-y] = a;
+        }
+    }
+
+  /* Since the algorithm considerers `buf[0]' to be 'over' the row
+   * currently calculated, we must start with `buf[0]' as non-selected
+   * if there is no `edge_lock. If there is an
+   * 'edge_lock', initialize the first row to 'selected'. Refer
+   * to bug #350009.
+   */
+  if (edge_lock)
+    {
+      for (i = 0; i < roi->width; i++)
+        buf[0][i] = 1.0;
+    }
+  else
+    {
+      memset (buf[0], 0, roi->width * sizeof (gfloat));
+    }
+
+  gegl_buffer_get (input,
+                   GEGL_RECTANGLE (roi->x, roi->y + 0,
+                                   roi->width, 1),
+                   1.0, input_format, buf[1],
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (roi->height > 1)
+    gegl_buffer_get (input,
+                     GEGL_RECTANGLE (roi->x, roi->y + 1,
+                                     roi->width, 1),
+                     1.0, input_format, buf[2],
+                     GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  else
+    memcpy (buf[2], buf[1], roi->width * sizeof (gfloat));
+
+  gimp_test_border_compute_transition (transition[1], buf, roi->width, edge_lock);
+
+   /* set up top of image */
+  for (y = 1; y < radius_y && y + 1 < roi->height; y++)
+    {
+      gimp_test_border_rotate_pointers (buf, 3);
+      gegl_buffer_get (input,
+                       GEGL_RECTANGLE (roi->x, roi->y + y + 1,
+                                       roi->width, 1),
+                       1.0, input_format, buf[2],
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      gimp_test_border_compute_transition (transition[y + 1], buf, roi->width, edge_lock);
+    }
+
+  /* set up max[] for top of image */
+  for (x = 0; x < roi->width; x++)
+    {
+      max[x] = -(radius_y + 7);
+
+      for (j = 1; j < radius_y + 1; j++)
+        if (transition[j][x])
+          {
+            max[x] = j;
+            break;
+          }
+    }
+
+  /* main calculation loop */
+  for (y = 0; y < roi->height; y++)
+    {
+      gimp_test_border_rotate_pointers (buf, 3);
+      gimp_test_border_rotate_pointers (transition, radius_y + 1);
+
+      if (y < roi->height - (radius_y + 1))
+        {
+          gegl_buffer_get (input,
+                           GEGL_RECTANGLE (roi->x,
+                                           roi->y + y + radius_y + 1,
+                                           roi->width, 1),
+                           1.0, input_format, buf[2],
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          gimp_test_border_compute_transition (transition[radius_y], buf, roi->width, edge_lock);
+        }
+      else
+        {
+          if (edge_lock)
+            {
+              memcpy (transition[radius_y], transition[radius_y - 1], roi->width * sizeof (gfloat));
+            }
+          else
+            {
+              /* No edge lock, set everything 'below canvas' as seen
+               * from the algorithm as unselected.
+               */
+              memset (buf[2], 0, roi->width * sizeof (gfloat));
+              gimp_test_border_compute_transition (transition[radius_y], buf, roi->width, edge_lock);
+            }
+        }
+
+      /* update max array */
+      for (x = 0; x < roi->width; x++)
+        {
+          if (max[x] < 1)
+            {
+              if (max[x] <= -radius_y)
+                {
+                  if (transition[radius_y][x])
+                    max[x] = radius_y;
+                  else
+                    max[x]--;
+                }
+              else
+                {
+                  if (transition[-max[x]][x])
+                    max[x] = -max[x];
+                  else if (transition[-max[x] + 1][x])
+                    max[x] = -max[x] + 1;
+                  else
+                    max[x]--;
+                }
+            }
+          else
+            {
+              max[x]--;
+            }
+
+          if (max[x] < -radius_y - 1)
+            max[x] = -radius_y - 1;
+        }
+
+      last_index = 1;
+
+       /* render scan line */
+      for (x = 0 ; x < roi->width; x++)
+        {
+          gfloat last_max;
+
+          last_index--;
+
+          if (last_index >= 0)
+            {
+              last_max = 0.0;
+
+              for (i = radius_x; i >= 0; i--)
+                if (max[x + i] <= radius_y && max[x + i] >= -radius_y &&
+                    density[i][max[x+i]] > last_max)
+                  {
+                    last_max = density[i][max[x + i]];
+                    last_index = i;
+                  }
+
+              out[x] = last_max;
+            }
+          else
+            {
+              last_max = 0.0;
+
+              for (i = radius_x; i >= -radius_x; i--)
+                if (max[x + i] <= radius_y && max[x + i] >= -radius_y &&
+                    density[i][max[x + i]] > last_max)
+                  {
+                    last_max = density[i][max[x + i]];
+                    last_index = i;
+                  }
+
+              out[x] = last_max;
+            }
+
+          if (last_max <= 0.0)
+            {
+              for (i = x + 1; i < roi->width; i++)
+                {
+                  if (max[i] >= -radius_y)
+                    break;
+                }
+
+              if (i - x > radius_x)
+                {
+                  for (; x < i - radius_x; x++)
+                    out[x] = 0;
+
+                  x--;
+                }
+
+              last_index = radius_x;
+            }
+        }
+
+      gegl_buffer_set (output,
+                       GEGL_RECTANGLE (roi->x, roi->y + y,
+                                       roi->width, 1),
+                       0, output_format, out,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (out);
+
+  for (i = 0; i < 3; i++)
+    g_free (buf[i]);
+
+  max -= radius_x;
+  g_free (max);
+
+  for (i = 0; i < radius_y + 1; i++)
+    {
+      transition[i] -= radius_x;
+      g_free (transition[i]);
+    }
+
+  g_free (transition);
+
+  for (i = 0; i < radius_x + 1 ; i++)
+    {
+      density[i] -= radius_y;
+      g_free (density[i]);
+    }
+
+  density -= radius_x;
+  g_free (density);
+}
+
+typedef struct
+{
+  GeglBuffer  *mask;
+  const gchar *operation;
+  gint         radius_x;
+  gint         radius_y;
+  gboolean     edge_lock;
+  gboolean     feather;
+} GimpTestDistance;
+
+/* returns a copy of @buffer, with all its values multiplied by @factor */
+static GeglBuffer *
+gimp_test_distance_multiply (GeglBuffer *buffer,
+                             gfloat      factor)
+{
+  GeglBuffer         *result = gegl_buffer_dup (buffer);
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (result, NULL, 0, babl_format ("Y float"),
+                                   GEGL_ACCESS_READWRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gfloat *data = iter->items[0].data;
+      gint    i;
+
+      for (i = 0; i < iter->length; i++)
+        data[i] *= factor;
+    }
+
+  return result;
+}
+
+static GeglBuffer *
+gimp_test_distance_process (GimpTestDistance *distance,
+                            GeglBuffer       *mask)
+{
+  GeglNode   *graph;
+  GeglNode   *input;
+  GeglNode   *node;
+  GeglNode   *output;
+  GeglBuffer *buffer;
+
+  buffer = gegl_buffer_new (gegl_buffer_get_extent (mask),
+                            babl_format ("Y float"));
+
+  graph = gegl_node_new ();
+
+  input  = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    mask,
+                                NULL);
+  node   = gegl_node_new_child (graph,
+                                "operation", distance->operation,
+                                "radius-x",  distance->radius_x,
+                                "radius-y",  distance->radius_y,
+                                NULL);
+  output = gegl_node_new_child (graph,
+                                "operation", "gegl:write-buffer",
+                                "buffer",    buffer,
+                                NULL);
+
+  if (strcmp (distance->operation, "gimp:grow"))
+    gegl_node_set (node, "edge-lock", distance->edge_lock, NULL);
+
+  if (! strcmp (distance->operation, "gimp:border"))
+    gegl_node_set (node, "feather", distance->feather, NULL);
+
+  gegl_node_link_many (input, node, output, NULL);
+  gegl_node_process (output);
+
+  g_object_unref (graph);
+
+  return buffer;
+}
+
+/* the original gimp:grow and gimp:shrink filters still handle masks
+ * which are not binary, and, since their maximum and minimum commute
+ * with scaling, give the original result for a mask of 0.0 and 1.0 when
+ * run on the same mask of 0.0 and 0.5, and scaled back.  gimp:border
+ * lost its original filter, which is above.
+ */
+static GeglBuffer *
+gimp_test_distance_apply (GimpTestDistance *distance,
+                          gboolean          original)
+{
+  GeglBuffer *half_mask;
+  GeglBuffer *half_buffer;
+  GeglBuffer *buffer;
+
+  if (! original)
+    return gimp_test_distance_process (distance, distance->mask);
+
+  if (! strcmp (distance->operation, "gimp:border"))
+    {
+      buffer = gegl_buffer_new (gegl_buffer_get_extent (distance->mask),
+                                babl_format ("Y float"));
+
+      gimp_test_border_reference (distance->mask, buffer,
+                                  distance->radius_x, distance->radius_y,
+                                  distance->feather, distance->edge_lock);
+
+      return buffer;
+    }
+
+  half_mask   = gimp_test_distance_multiply (distance->mask, 0.5);
+  half_buffer = gimp_test_distance_process (distance, half_mask);
+  buffer      = gimp_test_distance_multiply (half_buffer, 2.0);
+
+  g_object_unref (half_buffer);
+  g_object_unref (half_mask);
+
+  return buffer;
+}
+
+static void
+gimp_test_distance_compare (GeglBuffer  *mask,
+                            const gchar *operation,
+                            gint         radius_x,
+                            gint         radius_y,
+                            gboolean     edge_lock,
+                            gboolean     feather)
+{
+  GimpTestDistance distance;
+
+  distance.mask      = mask;
+  distance.operation = operation;
+  distance.radius_x  = radius_x;
+  distance.radius_y  = radius_y;
+  distance.edge_lock = edge_lock;
+  distance.feather   = feather;
+
+  gimp_test_compare_implementations (
+    (GimpTestRenderFunc) gimp_test_distance_apply, &distance,
+    "filter", "distance transform",
+    "%s radius %dx%d in %dx%d",
+    operation, radius_x, radius_y,
+    gegl_buffer_get_width (mask), gegl_buffer_get_height (mask));
+}
+
+/**
+ * distance_transform_grow_shrink_border:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure growing, shrinking and bordering a mask using a distance
+ * transform gives exactly the same result as the original filters, for
+ * elliptic and circular radii and all the combinations of edge lock and
+ * feathering.
+ **/
+static void
+distance_transform_grow_shrink_border (GimpTestFixture *fixture,
+                                       gconstpointer    data)
+{
+  const gchar *operations[] = { "gimp:grow", "gimp:shrink", "gimp:border" };
+  GeglBuffer  *mask;
+  gint         i;
+
+  mask = gimp_test_distance_mask_new (GIMP_TEST_DISTANCE_SIZE);
+
+  for (i = 0; i < G_N_ELEMENTS (operations); i++)
+    {
+      gint radius;
+      gint shape;
+      gint flags;
+
+      for (radius = 2; radius <= 50; radius = radius * 2 + 1)
+        {
+          /*  wider than high, higher than wide, and circular  */
+          for (shape = 0; shape < 3; shape++)
+            {
+              gint radius_x = shape == 1 ? radius / 2 + 1 : radius;
+              gint radius_y = shape == 0 ? radius / 2 + 1 : radius;
+
+              for (flags = 0; flags < 4; flags++)
+                {
+                  gboolean edge_lock = flags & 1;
+                  gboolean feather   = flags & 2;
+
+                  if ((edge_lock && ! strcmp (operations[i], "gimp:grow")) ||
+                      (feather   &&   strcmp (operations[i], "gimp:border")))
+                    continue;
+
+                  gimp_test_distance_compare (mask, operations[i],
+                                              radius_x, radius_y,
+                                              edge_lock, feather);
+                }
+            }
+        }
+    }
+
+  g_object_unref (mask);
+}
+
+/**
+ * distance_transform_grow_shrink_border_perf:
+ * @fixture:
+ * @data:
+ *
+ * Compares the time it takes to grow and border a large mask using the
+ * original filters and using a distance transform, for an increasing
+ * radius.
+ **/
+static void
+distance_transform_grow_shrink_border_perf (GimpTestFixture *fixture,
+                                            gconstpointer    data)
+{
+  const gchar *operations[] = { "gimp:grow", "gimp:shrink", "gimp:border" };
+  GeglBuffer  *mask;
+  gint         i;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  mask = gimp_test_distance_mask_new (GIMP_TEST_DISTANCE_PERF_SIZE);
+
+  for (i = 0; i < G_N_ELEMENTS (operations); i++)
+    {
+      gint radius;
+
+      for (radius = 10; radius <= 160; radius *= 2)
+        gimp_test_distance_compare (mask, operations[i],
+                                    radius, radius / 2 + 1,
+                                    FALSE, FALSE);
+    }
+
+  g_object_unref (mask);
+}
+
+typedef struct
+{
+  Gimp             *gimp;
+  GimpGradientType  type;
+  gint              size;
+} GimpTestGradient;
+
+static GeglBuffer *
+gimp_test_gradient_render (GimpTestGradient *gradient,
+                           gboolean          original)
+{
+  Gimp        *gimp    = gradient->gimp;
+  GimpContext *context = gimp_get_user_context (gimp);
+  gint         size    = gradient->size;
+  GeglNode    *node;
+  GeglBuffer  *buffer;
+  gint         num_processors;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, size, size),
+                            babl_format ("R'G'B'A float"));
+
+  /*  on a single thread, the whole result is supersampled as a single
+   *  area, like it was before supersampling was split between threads
+   */
+  g_object_get (gimp->config,
+                "num-processors", &num_processors,
+                NULL);
+  g_object_set (gimp->config,
+                "num-processors",
+                original ? 1 : MAX (g_get_num_processors (), 2),
+                NULL);
+
+  node = gegl_node_new_child (NULL,
+                              "operation",             "gimp:gradient",
+                              "context",               context,
+                              "gradient",              gimp_context_get_gradient (context),
+                              "start-x",               size / 3.0,
+                              "start-y",               size / 2.0,
+                              "end-x",                 size / 2.0,
+                              "end-y",                 size / 5.0,
+                              "gradient-type",         gradient->type,
+                              "gradient-repeat",       GIMP_REPEAT_SAWTOOTH,
+                              "supersample",           TRUE,
+                              "supersample-depth",     3,
+                              "supersample-threshold", 0.2,
+                              NULL);
+
+  gegl_node_blit_buffer (node, buffer, GEGL_RECTANGLE (0, 0, size, size),
+                         0, GEGL_ABYSS_NONE);
+
+  g_object_unref (node);
+
+  g_object_set (gimp->config,
+                "num-processors", num_processors,
+                NULL);
+
+  return buffer;
+}
+
+static void
+gimp_test_gradient_compare (Gimp             *gimp,
+                            GimpGradientType  type,
+                            gint              size)
+{
+  GimpTestGradient gradient;
+
+  gradient.gimp = gimp;
+  gradient.type = type;
+  gradient.size = size;
+
+  gimp_test_compare_implementations (
+    (GimpTestRenderFunc) gimp_test_gradient_render, &gradient,
+    "single thread", "parallel",
+    "gradient type %d in %dx%d", type, size, size);
+}
+
+/**
+ * gradient_supersample_parallel:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure supersampling a gradient in parallel gives exactly the
+ * same result as supersampling it on a single thread, for all the
+ * gradient shapes which don't need a distance map.
+ **/
+static void
+gradient_supersample_parallel (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  Gimp             *gimp = GIMP (data);
+  GimpGradientType  type;
+
+  for (type = GIMP_GRADIENT_LINEAR;
+       type <= GIMP_GRADIENT_SPIRAL_ANTICLOCKWISE;
+       type++)
+    {
+      if (type >= GIMP_GRADIENT_SHAPEBURST_ANGULAR &&
+          type <= GIMP_GRADIENT_SHAPEBURST_DIMPLED)
+        continue;
+
+      gimp_test_gradient_compare (gimp, type, GIMP_TEST_GRADIENT_SIZE);
+    }
+}
+
+/**
+ * gradient_supersample_parallel_perf:
+ * @fixture:
+ * @data:
+ *
+ * Compares the time it takes to supersample common gradient shapes
+ * over a large area serially and in parallel.
+ **/
+static void
+gradient_supersample_parallel_perf (GimpTestFixture *fixture,
+                                    gconstpointer    data)
+{
+  const GimpGradientType  types[] = { GIMP_GRADIENT_LINEAR,
+                                      GIMP_GRADIENT_RADIAL,
+                                      GIMP_GRADIENT_CONICAL_SYMMETRIC,
+                                      GIMP_GRADIENT_SPIRAL_CLOCKWISE };
+  Gimp                   *gimp    = GIMP (data);
+  gint                    i;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (types); i++)
+    gimp_test_gradient_compare (gimp, types[i], GIMP_TEST_GRADIENT_PERF_SIZE);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -278,6 +3984,25 @@ main (int    argc,
   ADD_IMAGE_TEST (remove_layer);
   ADD_IMAGE_TEST (rotate_non_overlapping);
   ADD_TEST (white_graypoint_in_red_levels);
+  ADD_TEST (scale_image_parallel);
+  ADD_TEST (scale_image_parallel_perf);
+  ADD_TEST (drawable_undo_compression);
+  ADD_TEST (undo_stack_size);
+  ADD_TEST (projection_render_async);
+  ADD_TEST (contiguous_region_parallel);
+  ADD_TEST (contiguous_region_parallel_perf);
+  ADD_TEST (drawable_histogram_incremental);
+  ADD_TEST (text_layer_partial_render);
+  ADD_TEST (invalidate_preview_area);
+  ADD_TEST (convert_indexed_parallel);
+  ADD_TEST (boundary_find_parallel);
+  ADD_TEST (boundary_find_parallel_perf);
+  ADD_TEST (cage_transform_parallel);
+  ADD_TEST (cage_transform_parallel_perf);
+  ADD_TEST (distance_transform_grow_shrink_border);
+  ADD_TEST (distance_transform_grow_shrink_border_perf);
+  ADD_TEST (gradient_supersample_parallel);
+  ADD_TEST (gradient_supersample_parallel_perf);
 
   /* Run the tests */
   result = g_test_run ();
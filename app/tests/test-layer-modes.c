@@ -0,0 +1,317 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "operations/operations-types.h"
+
+#include "operations/layer-modes/gimpoperationlayermode-blend.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimp-layer-modes/" #function, \
+                   gimp_test_layer_modes_ ## function);
+
+/* odd, so the AVX2 versions' single pixel tail gets tested too */
+#define N_PIXELS       1021
+#define N_PERF_PIXELS  (256 * 1024)
+#define N_PERF_RUNS    64
+
+
+typedef struct
+{
+  const gchar            *name;
+  GimpLayerModeBlendFunc  blend_function;
+} BlendFunction;
+
+
+#define BLEND_FUNCTION(name) { #name, gimp_operation_layer_mode_blend_##name }
+
+static const BlendFunction blend_functions[] =
+{
+  BLEND_FUNCTION (addition),
+  BLEND_FUNCTION (burn),
+  BLEND_FUNCTION (darken_only),
+  BLEND_FUNCTION (difference),
+  BLEND_FUNCTION (divide),
+  BLEND_FUNCTION (dodge),
+  BLEND_FUNCTION (exclusion),
+  BLEND_FUNCTION (grain_extract),
+  BLEND_FUNCTION (grain_merge),
+  BLEND_FUNCTION (hard_mix),
+  BLEND_FUNCTION (hardlight),
+  BLEND_FUNCTION (lighten_only),
+  BLEND_FUNCTION (linear_burn),
+  BLEND_FUNCTION (linear_light),
+  BLEND_FUNCTION (multiply),
+  BLEND_FUNCTION (overlay),
+  BLEND_FUNCTION (pin_light),
+  BLEND_FUNCTION (screen),
+  BLEND_FUNCTION (softlight),
+  BLEND_FUNCTION (subtract),
+  BLEND_FUNCTION (vivid_light)
+};
+
+/* values around the blend functions' special cases */
+static const gfloat special_values[] =
+{
+  0.0f, 1e-7f, 1e-6f, 0.25f, 0.5f, 0.5f + 1e-6f, 0.75f, 1.0f - 1e-6f, 1.0f,
+  -0.5f, 1.5f
+};
+
+
+static void
+gimp_test_fill_pixels (gfloat  *in,
+                       gfloat  *layer,
+                       gint     n_pixels,
+                       guint32  seed)
+{
+  GRand *rand = g_rand_new_with_seed (seed);
+  gint   n    = G_N_ELEMENTS (special_values);
+  gint   i;
+
+  for (i = 0; i < n_pixels * 4; i++)
+    {
+      if (i < n * n * 4)
+        {
+          /* all pairs of special values first */
+          in[i]    = special_values[(i / 4) / n];
+          layer[i] = special_values[(i / 4) % n];
+        }
+      else
+        {
+          in[i]    = g_rand_double_range (rand, -0.25, 1.25);
+          layer[i] = g_rand_double_range (rand, -0.25, 1.25);
+        }
+    }
+
+  /* include some pixels with zero alpha */
+  for (i = 0; i < n_pixels; i += 7)
+    {
+      in[i * 4 + ALPHA] = 0.0f;
+
+      if (i + 3 < n_pixels)
+        layer[(i + 3) * 4 + ALPHA] = 0.0f;
+    }
+
+  g_rand_free (rand);
+}
+
+static void
+gimp_test_compare_blend_function (const BlendFunction    *function,
+                                  GimpLayerModeBlendFunc  accelerated,
+                                  const gchar            *accel_name)
+{
+  gfloat *in         = g_new (gfloat, N_PIXELS * 4);
+  gfloat *layer      = g_new (gfloat, N_PIXELS * 4);
+  gfloat *comp       = g_new (gfloat, N_PIXELS * 4);
+  gfloat *accel_comp = g_new (gfloat, N_PIXELS * 4);
+  gint    i;
+
+  g_assert_nonnull (accelerated);
+
+  gimp_test_fill_pixels (in, layer, N_PIXELS, 1234);
+
+  function->blend_function (NULL, in, layer, comp, N_PIXELS);
+  accelerated (NULL, in, layer, accel_comp, N_PIXELS);
+
+  for (i = 0; i < N_PIXELS; i++)
+    {
+      const gfloat *p = comp       + i * 4;
+      const gfloat *q = accel_comp + i * 4;
+      gint          c;
+
+      if (p[ALPHA] != q[ALPHA])
+        {
+          g_error ("%s (%s): alpha of pixel %d is %g, expected %g",
+                   function->name, accel_name, i, q[ALPHA], p[ALPHA]);
+        }
+
+      /* the color is unconstrained when either alpha is zero */
+      if (in[i * 4 + ALPHA] == 0.0f || layer[i * 4 + ALPHA] == 0.0f)
+        continue;
+
+      for (c = 0; c < 3; c++)
+        {
+          if (fabsf (p[c] - q[c]) > 1e-6f * MAX (1.0f, fabsf (p[c])))
+            {
+              g_error ("%s (%s): component %d of pixel %d is %g, expected %g "
+                       "(in = %g, layer = %g)",
+                       function->name, accel_name, c, i, q[c], p[c],
+                       in[i * 4 + c], layer[i * 4 + c]);
+            }
+        }
+    }
+
+  g_free (in);
+  g_free (layer);
+  g_free (comp);
+  g_free (accel_comp);
+}
+
+/**
+ * gimp_test_layer_modes_blend_sse2:
+ *
+ * Test that the SSE2 blend functions give the same results as the
+ * plain C ones.
+ **/
+static void
+gimp_test_layer_modes_blend_sse2 (void)
+{
+#if COMPILE_SSE2_INTRINISICS
+  gint i;
+
+  if (! (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_SSE2))
+    {
+      g_test_skip ("CPU doesn't support SSE2");
+      return;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (blend_functions); i++)
+    {
+      const BlendFunction *function = &blend_functions[i];
+
+      gimp_test_compare_blend_function (
+        function,
+        gimp_operation_layer_mode_blend_get_sse2 (function->blend_function),
+        "SSE2");
+    }
+#else
+  g_test_skip ("SSE2 support not compiled in");
+#endif
+}
+
+/**
+ * gimp_test_layer_modes_blend_avx2:
+ *
+ * Test that the AVX2 blend functions give the same results as the
+ * plain C ones.
+ **/
+static void
+gimp_test_layer_modes_blend_avx2 (void)
+{
+#if COMPILE_AVX2_INTRINISICS
+  gint i;
+
+  if (! (gimp_cpu_accel_get_support () & GIMP_CPU_ACCEL_X86_AVX2))
+    {
+      g_test_skip ("CPU doesn't support AVX2");
+      return;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (blend_functions); i++)
+    {
+      const BlendFunction *function = &blend_functions[i];
+
+      gimp_test_compare_blend_function (
+        function,
+        gimp_operation_layer_mode_blend_get_avx2 (function->blend_function),
+        "AVX2");
+    }
+#else
+  g_test_skip ("AVX2 support not compiled in");
+#endif
+}
+
+static gdouble
+gimp_test_time_blend_function (GimpLayerModeBlendFunc  blend_function,
+                               const gfloat           *in,
+                               const gfloat           *layer,
+                               gfloat                 *comp)
+{
+  gint64 start;
+  gint   i;
+
+  start = g_get_monotonic_time ();
+
+  for (i = 0; i < N_PERF_RUNS; i++)
+    blend_function (NULL, in, layer, comp, N_PERF_PIXELS);
+
+  /* Mpixels per second */
+  return (gdouble) N_PERF_PIXELS * N_PERF_RUNS /
+         MAX (g_get_monotonic_time () - start, 1);
+}
+
+/**
+ * gimp_test_layer_modes_blend_throughput:
+ *
+ * Compare the throughput of the plain C blend functions with the
+ * ones picked by gimp_operation_layer_mode_blend_get_accelerated().
+ **/
+static void
+gimp_test_layer_modes_blend_throughput (void)
+{
+  gfloat *in;
+  gfloat *layer;
+  gfloat *comp;
+  gint    i;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  in    = g_new (gfloat, N_PERF_PIXELS * 4);
+  layer = g_new (gfloat, N_PERF_PIXELS * 4);
+  comp  = g_new (gfloat, N_PERF_PIXELS * 4);
+
+  gimp_test_fill_pixels (in, layer, N_PERF_PIXELS, 4321);
+
+  for (i = 0; i < G_N_ELEMENTS (blend_functions); i++)
+    {
+      const BlendFunction    *function = &blend_functions[i];
+      GimpLayerModeBlendFunc  accelerated;
+      gdouble                 plain_rate;
+      gdouble                 accel_rate;
+
+      accelerated =
+        gimp_operation_layer_mode_blend_get_accelerated (function->blend_function);
+
+      plain_rate = gimp_test_time_blend_function (function->blend_function,
+                                                  in, layer, comp);
+      accel_rate = gimp_test_time_blend_function (accelerated,
+                                                  in, layer, comp);
+
+      g_test_message ("%-14s  plain %8.1f Mpixels/s  "
+                      "accelerated %8.1f Mpixels/s  (%.2fx)",
+                      function->name, plain_rate, accel_rate,
+                      accel_rate / plain_rate);
+    }
+
+  g_free (in);
+  g_free (layer);
+  g_free (comp);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (blend_sse2);
+  ADD_TEST (blend_avx2);
+  ADD_TEST (blend_throughput);
+
+  return g_test_run ();
+}
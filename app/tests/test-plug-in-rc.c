@@ -0,0 +1,895 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "libgimp/gimpgpparams.h"
+
+#include "plug-in/plug-in-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpdrawable.h"
+#include "core/gimpparamspecs.h"
+
+#include "plug-in/gimpplugindef.h"
+#include "plug-in/gimppluginprocedure.h"
+#include "plug-in/plug-in-rc.h"
+#include "plug-in/plug-in-rc-cache.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-plug-in-rc/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_plug_in_rc_setup, \
+              function, \
+              gimp_test_plug_in_rc_teardown);
+
+
+/*  The start of a cache file, this must match CacheHeader in
+ *  plug-in-rc-cache.c
+ */
+typedef struct
+{
+  gchar   magic[8];
+  guint32 byte_order;
+  guint32 version;
+  guint32 protocol_version;
+  guint32 n_plug_in_defs;
+  gint64  pluginrc_mtime;
+  guint64 pluginrc_size;
+  guint8  checksum[16];
+} TestCacheHeader;
+
+typedef struct
+{
+  gchar  *dir;
+  GFile  *pluginrc;
+  GFile  *cache;
+  GSList *plug_in_defs;  /*  as parsed from pluginrc      */
+  gchar  *cache_data;    /*  the cache file, as written   */
+  gsize   cache_size;
+} GimpTestFixture;
+
+
+static GimpPlugInProcedure *
+gimp_test_procedure_new (GimpPlugInDef   *plug_in_def,
+                         GimpPDBProcType  proc_type,
+                         const gchar     *name)
+{
+  GimpProcedure *procedure;
+
+  procedure = gimp_plug_in_procedure_new (proc_type, plug_in_def->file);
+  gimp_object_set_name (GIMP_OBJECT (procedure), name);
+
+  procedure->blurb     = g_strdup_printf ("Blurb of %s", name);
+  procedure->help      = g_strdup ("Help with \"quotes\",\nnewlines and ümlauts");
+  procedure->authors   = g_strdup ("Some Author");
+  procedure->copyright = g_strdup ("Some Copyright");
+  procedure->date      = g_strdup ("2023");
+
+  return GIMP_PLUG_IN_PROCEDURE (procedure);
+}
+
+/*  Creates plug-in-defs using every field and argument type which
+ *  pluginrc stores.
+ */
+static GSList *
+gimp_test_plug_in_defs_new (const gchar *dir)
+{
+  GSList              *plug_in_defs = NULL;
+  GimpPlugInDef       *plug_in_def;
+  GimpPlugInProcedure *proc;
+  GimpProcedure       *procedure;
+  GFile               *file;
+  gchar               *path;
+  GdkPixbuf           *pixbuf;
+  gchar               *icon_data;
+  gsize                icon_data_length;
+  GimpRGB              color = { 0.1, 0.2, 0.3, 0.4 };
+
+  /*  a filter and an extension, with a help domain and init  */
+  path = g_build_filename (dir, "test-filter", "test-filter", NULL);
+  file = g_file_new_for_path (path);
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+  g_free (path);
+
+  plug_in_def->mtime = 1234567890;
+
+  proc = gimp_test_procedure_new (plug_in_def, GIMP_PDB_PROC_TYPE_PLUGIN,
+                                  "plug-in-test-filter");
+  procedure = GIMP_PROCEDURE (proc);
+
+  proc->menu_label = g_strdup ("_Test Filter...");
+  proc->menu_paths = g_list_append (proc->menu_paths,
+                                    g_strdup ("<Image>/Filters/Test"));
+  proc->menu_paths = g_list_append (proc->menu_paths,
+                                    g_strdup ("<Layers>/Test"));
+
+  gimp_plug_in_procedure_take_icon (proc, GIMP_ICON_TYPE_ICON_NAME,
+                                    (guint8 *) g_strdup ("gimp-test"), -1,
+                                    NULL);
+  gimp_plug_in_procedure_set_image_types (proc, "RGB*, GRAY*");
+  gimp_plug_in_procedure_set_sensitivity_mask (proc,
+                                               GIMP_PROCEDURE_SENSITIVE_DRAWABLE |
+                                               GIMP_PROCEDURE_SENSITIVE_DRAWABLES);
+
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_enum ("run-mode",
+                                                  "Run mode",
+                                                  "The run mode",
+                                                  GIMP_TYPE_RUN_MODE,
+                                                  GIMP_RUN_NONINTERACTIVE,
+                                                  GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_image ("image",
+                                                      "Image",
+                                                      "The input image",
+                                                      TRUE,
+                                                      GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_object_array ("drawables",
+                                                             "Drawables",
+                                                             "The input drawables",
+                                                             GIMP_TYPE_DRAWABLE,
+                                                             GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_int ("int",
+                                                 "Int",
+                                                 "An integer",
+                                                 -5, 100, 7,
+                                                 GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_double ("double",
+                                                    "Double",
+                                                    "A double",
+                                                    -1.5, 1e6, 0.1,
+                                                    GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               g_param_spec_boolean ("boolean",
+                                                     "Boolean",
+                                                     "A boolean",
+                                                     TRUE,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("string",
+                                                       "String",
+                                                       "A string",
+                                                       FALSE, TRUE, FALSE,
+                                                       "with \"quotes\"",
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_rgb ("color",
+                                                    "Color",
+                                                    "A color",
+                                                    TRUE, &color,
+                                                    GIMP_PARAM_READWRITE));
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_unit ("unit",
+                                                     "Unit",
+                                                     "A unit",
+                                                     TRUE, TRUE,
+                                                     GIMP_UNIT_INCH,
+                                                     GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   g_param_spec_int ("result",
+                                                     "Result",
+                                                     "The result",
+                                                     G_MININT32, G_MAXINT32, 0,
+                                                     GIMP_PARAM_READWRITE));
+
+  gimp_plug_in_def_add_procedure (plug_in_def, proc);
+  g_object_unref (proc);
+
+  proc = gimp_test_procedure_new (plug_in_def, GIMP_PDB_PROC_TYPE_EXTENSION,
+                                  "extension-test");
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 16, 16);
+  gdk_pixbuf_fill (pixbuf, 0x336699ff);
+  g_assert_true (gdk_pixbuf_save_to_buffer (pixbuf,
+                                            &icon_data, &icon_data_length,
+                                            "png", NULL, NULL));
+  g_object_unref (pixbuf);
+
+  gimp_plug_in_procedure_take_icon (proc, GIMP_ICON_TYPE_PIXBUF,
+                                    (guint8 *) icon_data, icon_data_length,
+                                    NULL);
+
+  gimp_plug_in_def_add_procedure (plug_in_def, proc);
+  g_object_unref (proc);
+
+  gimp_plug_in_def_set_help_domain (plug_in_def,
+                                    "gimp-test-help",
+                                    "https://example.org/help");
+  gimp_plug_in_def_set_has_init (plug_in_def, TRUE);
+
+  plug_in_defs = g_slist_append (plug_in_defs, plug_in_def);
+
+  /*  a load and a save procedure  */
+  path = g_build_filename (dir, "file-test", "file-test", NULL);
+  file = g_file_new_for_path (path);
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+  g_free (path);
+
+  plug_in_def->mtime = 1234567891;
+
+  proc = gimp_test_procedure_new (plug_in_def, GIMP_PDB_PROC_TYPE_PLUGIN,
+                                  "file-test-load");
+  procedure = GIMP_PROCEDURE (proc);
+
+  gimp_plug_in_procedure_take_icon (proc, GIMP_ICON_TYPE_ICON_NAME,
+                                    (guint8 *) g_strdup ("gimp-test-file"), -1,
+                                    NULL);
+
+  proc->file_proc  = TRUE;
+  proc->extensions = g_strdup ("tst,test");
+  proc->prefixes   = g_strdup ("test:");
+  proc->magics     = g_strdup ("0,string,TEST");
+
+  gimp_plug_in_procedure_set_priority (proc, 5);
+  gimp_plug_in_procedure_set_mime_types (proc, "image/x-test");
+  gimp_plug_in_procedure_set_handles_remote (proc);
+  gimp_plug_in_procedure_set_handles_raw (proc);
+  gimp_plug_in_procedure_set_thumb_loader (proc, "file-test-load-thumb");
+
+  gimp_procedure_add_argument (procedure,
+                               gimp_param_spec_string ("uri",
+                                                       "URI",
+                                                       "The URI to load",
+                                                       FALSE, FALSE, FALSE,
+                                                       NULL,
+                                                       GIMP_PARAM_READWRITE));
+  gimp_procedure_add_return_value (procedure,
+                                   gimp_param_spec_image ("image",
+                                                          "Image",
+                                                          "The loaded image",
+                                                          FALSE,
+                                                          GIMP_PARAM_READWRITE));
+
+  gimp_plug_in_def_add_procedure (plug_in_def, proc);
+  g_object_unref (proc);
+
+  proc = gimp_test_procedure_new (plug_in_def, GIMP_PDB_PROC_TYPE_PLUGIN,
+                                  "file-test-save");
+
+  gimp_plug_in_procedure_take_icon (proc, GIMP_ICON_TYPE_ICON_NAME,
+                                    (guint8 *) g_strdup ("gimp-test-file"), -1,
+                                    NULL);
+
+  proc->file_proc  = TRUE;
+  proc->extensions = g_strdup ("tst");
+
+  gimp_plug_in_procedure_set_image_types (proc, "*");
+
+  gimp_plug_in_def_add_procedure (plug_in_def, proc);
+  g_object_unref (proc);
+
+  plug_in_defs = g_slist_append (plug_in_defs, plug_in_def);
+
+  /*  a batch interpreter  */
+  path = g_build_filename (dir, "test-batch", "test-batch", NULL);
+  file = g_file_new_for_path (path);
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+  g_free (path);
+
+  proc = gimp_test_procedure_new (plug_in_def, GIMP_PDB_PROC_TYPE_PLUGIN,
+                                  "test-batch-eval");
+
+  gimp_plug_in_procedure_take_icon (proc, GIMP_ICON_TYPE_ICON_NAME,
+                                    (guint8 *) g_strdup ("gimp-test-batch"), -1,
+                                    NULL);
+  gimp_plug_in_procedure_set_batch_interpreter (proc, "Test Interpreter");
+
+  gimp_plug_in_def_add_procedure (plug_in_def, proc);
+  g_object_unref (proc);
+
+  plug_in_defs = g_slist_append (plug_in_defs, plug_in_def);
+
+  /*  a plug-in without procedures, which is not stored  */
+  path = g_build_filename (dir, "test-empty", "test-empty", NULL);
+  file = g_file_new_for_path (path);
+  plug_in_def = gimp_plug_in_def_new (file);
+  g_object_unref (file);
+  g_free (path);
+
+  plug_in_defs = g_slist_append (plug_in_defs, plug_in_def);
+
+  return plug_in_defs;
+}
+
+static void
+gimp_test_assert_param_specs_equal (GParamSpec *pspec,
+                                    GParamSpec *expected)
+{
+  GPParamDef param_def          = { 0, };
+  GPParamDef expected_param_def = { 0, };
+
+  _gimp_param_spec_to_gp_param_def (pspec,    &param_def);
+  _gimp_param_spec_to_gp_param_def (expected, &expected_param_def);
+
+  g_assert_cmpint (param_def.param_def_type, ==,
+                   expected_param_def.param_def_type);
+  g_assert_cmpstr (param_def.type_name,       ==, expected_param_def.type_name);
+  g_assert_cmpstr (param_def.value_type_name, ==,
+                   expected_param_def.value_type_name);
+  g_assert_cmpstr (param_def.name,  ==, expected_param_def.name);
+  g_assert_cmpstr (param_def.nick,  ==, expected_param_def.nick);
+  g_assert_cmpstr (param_def.blurb, ==, expected_param_def.blurb);
+  g_assert_cmpuint (param_def.flags, ==, expected_param_def.flags);
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      g_assert_cmpint (param_def.meta.m_int.min_val, ==,
+                       expected_param_def.meta.m_int.min_val);
+      g_assert_cmpint (param_def.meta.m_int.max_val, ==,
+                       expected_param_def.meta.m_int.max_val);
+      g_assert_cmpint (param_def.meta.m_int.default_val, ==,
+                       expected_param_def.meta.m_int.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      g_assert_cmpint (param_def.meta.m_unit.allow_pixels, ==,
+                       expected_param_def.meta.m_unit.allow_pixels);
+      g_assert_cmpint (param_def.meta.m_unit.allow_percent, ==,
+                       expected_param_def.meta.m_unit.allow_percent);
+      g_assert_cmpint (param_def.meta.m_unit.default_val, ==,
+                       expected_param_def.meta.m_unit.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      g_assert_cmpint (param_def.meta.m_enum.default_val, ==,
+                       expected_param_def.meta.m_enum.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      g_assert_cmpint (param_def.meta.m_boolean.default_val, ==,
+                       expected_param_def.meta.m_boolean.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FLOAT:
+      g_assert_cmpfloat (param_def.meta.m_float.min_val, ==,
+                         expected_param_def.meta.m_float.min_val);
+      g_assert_cmpfloat (param_def.meta.m_float.max_val, ==,
+                         expected_param_def.meta.m_float.max_val);
+      g_assert_cmpfloat (param_def.meta.m_float.default_val, ==,
+                         expected_param_def.meta.m_float.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      g_assert_cmpstr (param_def.meta.m_string.default_val, ==,
+                       expected_param_def.meta.m_string.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_COLOR:
+      g_assert_cmpint (param_def.meta.m_color.has_alpha, ==,
+                       expected_param_def.meta.m_color.has_alpha);
+      g_assert_cmpfloat (param_def.meta.m_color.default_val.r, ==,
+                         expected_param_def.meta.m_color.default_val.r);
+      g_assert_cmpfloat (param_def.meta.m_color.default_val.g, ==,
+                         expected_param_def.meta.m_color.default_val.g);
+      g_assert_cmpfloat (param_def.meta.m_color.default_val.b, ==,
+                         expected_param_def.meta.m_color.default_val.b);
+      g_assert_cmpfloat (param_def.meta.m_color.default_val.a, ==,
+                         expected_param_def.meta.m_color.default_val.a);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      g_assert_cmpint (param_def.meta.m_id.none_ok, ==,
+                       expected_param_def.meta.m_id.none_ok);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      g_assert_cmpstr (param_def.meta.m_id_array.type_name, ==,
+                       expected_param_def.meta.m_id_array.type_name);
+      break;
+    }
+}
+
+static void
+gimp_test_assert_procedures_equal (GimpPlugInProcedure *proc,
+                                   GimpPlugInProcedure *expected)
+{
+  GimpProcedure *procedure          = GIMP_PROCEDURE (proc);
+  GimpProcedure *expected_procedure = GIMP_PROCEDURE (expected);
+  GList         *list;
+  GList         *expected_list;
+  gint           i;
+
+  g_assert_cmpstr (gimp_object_get_name (proc), ==,
+                   gimp_object_get_name (expected));
+  g_assert_cmpint (procedure->proc_type, ==, expected_procedure->proc_type);
+  g_assert_cmpstr (procedure->blurb,     ==, expected_procedure->blurb);
+  g_assert_cmpstr (procedure->help,      ==, expected_procedure->help);
+  g_assert_cmpstr (procedure->authors,   ==, expected_procedure->authors);
+  g_assert_cmpstr (procedure->copyright, ==, expected_procedure->copyright);
+  g_assert_cmpstr (procedure->date,      ==, expected_procedure->date);
+
+  g_assert_true (g_file_equal (proc->file, expected->file));
+  g_assert_cmpint (proc->mtime, ==, expected->mtime);
+  g_assert_cmpstr (proc->menu_label, ==, expected->menu_label);
+
+  g_assert_cmpuint (g_list_length (proc->menu_paths), ==,
+                    g_list_length (expected->menu_paths));
+
+  for (list = proc->menu_paths, expected_list = expected->menu_paths;
+       list && expected_list;
+       list = g_list_next (list), expected_list = g_list_next (expected_list))
+    {
+      g_assert_cmpstr (list->data, ==, expected_list->data);
+    }
+
+  g_assert_cmpint (proc->icon_type, ==, expected->icon_type);
+
+  switch (proc->icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      g_assert_cmpstr ((const gchar *) proc->icon_data, ==,
+                       (const gchar *) expected->icon_data);
+      break;
+
+    case GIMP_ICON_TYPE_PIXBUF:
+      g_assert_cmpmem (proc->icon_data,     proc->icon_data_length,
+                       expected->icon_data, expected->icon_data_length);
+      break;
+    }
+
+  g_assert_cmpstr (proc->image_types, ==, expected->image_types);
+  g_assert_cmpint (proc->image_types_val, ==, expected->image_types_val);
+  g_assert_cmpint (proc->sensitivity_mask, ==, expected->sensitivity_mask);
+
+  g_assert_cmpint (proc->file_proc, ==, expected->file_proc);
+  g_assert_cmpstr (proc->extensions, ==, expected->extensions);
+  g_assert_cmpstr (proc->prefixes,   ==, expected->prefixes);
+  g_assert_cmpstr (proc->magics,     ==, expected->magics);
+  g_assert_cmpint (proc->priority,   ==, expected->priority);
+  g_assert_cmpstr (proc->mime_types, ==, expected->mime_types);
+  g_assert_cmpint (proc->handles_remote, ==, expected->handles_remote);
+  g_assert_cmpint (proc->handles_raw,    ==, expected->handles_raw);
+  g_assert_cmpstr (proc->thumb_loader, ==, expected->thumb_loader);
+  g_assert_cmpint (proc->batch_interpreter, ==, expected->batch_interpreter);
+  g_assert_cmpstr (proc->batch_interpreter_name, ==,
+                   expected->batch_interpreter_name);
+
+  g_assert_cmpint (procedure->num_args, ==, expected_procedure->num_args);
+  g_assert_cmpint (procedure->num_values, ==, expected_procedure->num_values);
+
+  for (i = 0; i < procedure->num_args; i++)
+    gimp_test_assert_param_specs_equal (procedure->args[i],
+                                        expected_procedure->args[i]);
+
+  for (i = 0; i < procedure->num_values; i++)
+    gimp_test_assert_param_specs_equal (procedure->values[i],
+                                        expected_procedure->values[i]);
+}
+
+static void
+gimp_test_assert_plug_in_defs_equal (GSList *plug_in_defs,
+                                     GSList *expected)
+{
+  g_assert_cmpuint (g_slist_length (plug_in_defs), ==,
+                    g_slist_length (expected));
+
+  for (; plug_in_defs && expected;
+       plug_in_defs = g_slist_next (plug_in_defs),
+       expected     = g_slist_next (expected))
+    {
+      GimpPlugInDef *plug_in_def          = plug_in_defs->data;
+      GimpPlugInDef *expected_plug_in_def = expected->data;
+      GSList        *list;
+      GSList        *expected_list;
+
+      g_assert_true (g_file_equal (plug_in_def->file,
+                                   expected_plug_in_def->file));
+      g_assert_cmpint (plug_in_def->mtime, ==, expected_plug_in_def->mtime);
+      g_assert_cmpstr (plug_in_def->help_domain_name, ==,
+                       expected_plug_in_def->help_domain_name);
+      g_assert_cmpstr (plug_in_def->help_domain_uri, ==,
+                       expected_plug_in_def->help_domain_uri);
+      g_assert_cmpint (plug_in_def->has_init, ==,
+                       expected_plug_in_def->has_init);
+
+      g_assert_cmpuint (g_slist_length (plug_in_def->procedures), ==,
+                        g_slist_length (expected_plug_in_def->procedures));
+
+      for (list = plug_in_def->procedures,
+           expected_list = expected_plug_in_def->procedures;
+           list && expected_list;
+           list = g_slist_next (list),
+           expected_list = g_slist_next (expected_list))
+        {
+          gimp_test_assert_procedures_equal (list->data, expected_list->data);
+        }
+    }
+}
+
+/*  Writes @data as the cache file, and checks that the plug-in-defs
+ *  are then parsed from pluginrc instead.
+ */
+static void
+gimp_test_assert_cache_falls_back (Gimp            *gimp,
+                                   GimpTestFixture *fixture,
+                                   const gchar     *data,
+                                   gsize            size)
+{
+  GSList   *plug_in_defs;
+  gchar    *path;
+  gboolean  cache_valid = TRUE;
+  GError   *error       = NULL;
+
+  path = g_file_get_path (fixture->cache);
+  g_assert_true (g_file_set_contents (path, data, size, NULL));
+  g_free (path);
+
+  plug_in_defs = plug_in_rc_cache_parse (gimp,
+                                         fixture->pluginrc, fixture->cache,
+                                         &cache_valid, &error);
+
+  g_assert_no_error (error);
+  g_assert_false (cache_valid);
+
+  gimp_test_assert_plug_in_defs_equal (plug_in_defs, fixture->plug_in_defs);
+
+  g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+}
+
+/*  Updates the checksum of a modified cache file, so that the file
+ *  gets as far as being read.
+ */
+static void
+gimp_test_cache_update_checksum (gchar *data,
+                                 gsize  size)
+{
+  TestCacheHeader *header = (TestCacheHeader *) data;
+  GChecksum       *md5    = g_checksum_new (G_CHECKSUM_MD5);
+  gsize            length = sizeof (header->checksum);
+
+  g_assert_cmpuint (size, >=, sizeof (TestCacheHeader));
+
+  g_checksum_update (md5,
+                     (const guchar *) data + sizeof (TestCacheHeader),
+                     size - sizeof (TestCacheHeader));
+  g_checksum_get_digest (md5, header->checksum, &length);
+  g_checksum_free (md5);
+}
+
+/**
+ * gimp_test_plug_in_rc_setup:
+ * @fixture:
+ * @data:
+ *
+ * Writes a pluginrc and its cache to a temporary directory, and
+ * parses the pluginrc back.
+ **/
+static void
+gimp_test_plug_in_rc_setup (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  Gimp   *gimp = GIMP (data);
+  GSList *plug_in_defs;
+  gchar  *path;
+  GError *error = NULL;
+
+  fixture->dir = g_dir_make_tmp ("gimp-test-XXXXXX", NULL);
+  g_assert_nonnull (fixture->dir);
+
+  path = g_build_filename (fixture->dir, "pluginrc", NULL);
+  fixture->pluginrc = g_file_new_for_path (path);
+  g_free (path);
+
+  path = g_build_filename (fixture->dir, "pluginrc.cache", NULL);
+  fixture->cache = g_file_new_for_path (path);
+  g_free (path);
+
+  plug_in_defs = gimp_test_plug_in_defs_new (fixture->dir);
+
+  g_assert_true (plug_in_rc_write (plug_in_defs, fixture->pluginrc, &error));
+  g_assert_no_error (error);
+
+  fixture->plug_in_defs = plug_in_rc_parse (gimp, fixture->pluginrc, &error);
+  g_assert_no_error (error);
+
+  /*  all but the plug-in without procedures  */
+  g_assert_cmpuint (g_slist_length (fixture->plug_in_defs), ==,
+                    g_slist_length (plug_in_defs) - 1);
+
+  g_assert_true (plug_in_rc_cache_write (plug_in_defs,
+                                         fixture->cache, fixture->pluginrc,
+                                         &error));
+  g_assert_no_error (error);
+
+  g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+
+  path = g_file_get_path (fixture->cache);
+  g_assert_true (g_file_get_contents (path,
+                                      &fixture->cache_data,
+                                      &fixture->cache_size,
+                                      NULL));
+  g_free (path);
+}
+
+static void
+gimp_test_plug_in_rc_teardown (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  g_file_delete (fixture->cache, NULL, NULL);
+  g_file_delete (fixture->pluginrc, NULL, NULL);
+  g_rmdir (fixture->dir);
+
+  g_slist_free_full (fixture->plug_in_defs, (GDestroyNotify) g_object_unref);
+  g_object_unref (fixture->cache);
+  g_object_unref (fixture->pluginrc);
+  g_free (fixture->cache_data);
+  g_free (fixture->dir);
+}
+
+/**
+ * cache_round_trip:
+ * @fixture:
+ * @data:
+ *
+ * The plug-in-defs read from the cache must be the same, field by
+ * field, as the ones parsed from pluginrc.
+ **/
+static void
+cache_round_trip (GimpTestFixture *fixture,
+                  gconstpointer    data)
+{
+  Gimp     *gimp = GIMP (data);
+  GSList   *plug_in_defs;
+  gboolean  cache_valid = FALSE;
+  GError   *error       = NULL;
+
+  plug_in_defs = plug_in_rc_cache_load (gimp,
+                                        fixture->cache, fixture->pluginrc,
+                                        &error);
+  g_assert_no_error (error);
+
+  gimp_test_assert_plug_in_defs_equal (plug_in_defs, fixture->plug_in_defs);
+
+  g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+
+  plug_in_defs = plug_in_rc_cache_parse (gimp,
+                                         fixture->pluginrc, fixture->cache,
+                                         &cache_valid, &error);
+  g_assert_no_error (error);
+  g_assert_true (cache_valid);
+
+  gimp_test_assert_plug_in_defs_equal (plug_in_defs, fixture->plug_in_defs);
+
+  g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+}
+
+/**
+ * cache_missing:
+ * @fixture:
+ * @data:
+ *
+ * Without a cache, pluginrc must be parsed.
+ **/
+static void
+cache_missing (GimpTestFixture *fixture,
+               gconstpointer    data)
+{
+  Gimp     *gimp = GIMP (data);
+  GSList   *plug_in_defs;
+  gboolean  cache_valid = TRUE;
+  GError   *error       = NULL;
+
+  g_assert_true (g_file_delete (fixture->cache, NULL, NULL));
+
+  plug_in_defs = plug_in_rc_cache_parse (gimp,
+                                         fixture->pluginrc, fixture->cache,
+                                         &cache_valid, &error);
+  g_assert_no_error (error);
+  g_assert_false (cache_valid);
+
+  gimp_test_assert_plug_in_defs_equal (plug_in_defs, fixture->plug_in_defs);
+
+  g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+}
+
+/**
+ * cache_corrupt:
+ * @fixture:
+ * @data:
+ *
+ * A cache with any byte of its contents changed must fail its
+ * checksum, and pluginrc be parsed instead.
+ **/
+static void
+cache_corrupt (GimpTestFixture *fixture,
+               gconstpointer    data)
+{
+  Gimp  *gimp = GIMP (data);
+  gchar *corrupt;
+  gsize  i;
+
+  corrupt = g_memdup2 (fixture->cache_data, fixture->cache_size);
+
+  for (i = sizeof (TestCacheHeader);
+       i < fixture->cache_size;
+       i += 1 + fixture->cache_size / 16)
+    {
+      corrupt[i] ^= 0x55;
+
+      gimp_test_assert_cache_falls_back (gimp, fixture,
+                                         corrupt, fixture->cache_size);
+
+      corrupt[i] ^= 0x55;
+    }
+
+  g_free (corrupt);
+}
+
+/**
+ * cache_truncated:
+ * @fixture:
+ * @data:
+ *
+ * A cache cut short anywhere must make pluginrc be parsed instead,
+ * both when its checksum catches it and when the checksum is right,
+ * and reading runs out of data.
+ **/
+static void
+cache_truncated (GimpTestFixture *fixture,
+                 gconstpointer    data)
+{
+  Gimp  *gimp = GIMP (data);
+  gchar *truncated;
+  gsize  size;
+
+  truncated = g_memdup2 (fixture->cache_data, fixture->cache_size);
+
+  for (size = 0; size < sizeof (TestCacheHeader); size += 7)
+    gimp_test_assert_cache_falls_back (gimp, fixture, truncated, size);
+
+  for (size = sizeof (TestCacheHeader);
+       size < fixture->cache_size;
+       size += 1 + fixture->cache_size / 64)
+    {
+      gimp_test_assert_cache_falls_back (gimp, fixture, truncated, size);
+
+      gimp_test_cache_update_checksum (truncated, size);
+      gimp_test_assert_cache_falls_back (gimp, fixture, truncated, size);
+
+      memcpy (truncated, fixture->cache_data, sizeof (TestCacheHeader));
+    }
+
+  /*  one byte short  */
+  size = fixture->cache_size - 1;
+
+  gimp_test_assert_cache_falls_back (gimp, fixture, truncated, size);
+
+  gimp_test_cache_update_checksum (truncated, size);
+  gimp_test_assert_cache_falls_back (gimp, fixture, truncated, size);
+
+  g_free (truncated);
+}
+
+/**
+ * cache_version_mismatch:
+ * @fixture:
+ * @data:
+ *
+ * A cache of another format or protocol version, of the other byte
+ * order, or written for another pluginrc, must make pluginrc be
+ * parsed instead.
+ **/
+static void
+cache_version_mismatch (GimpTestFixture *fixture,
+                        gconstpointer    data)
+{
+  Gimp            *gimp = GIMP (data);
+  TestCacheHeader *header;
+  gchar           *modified;
+  GSList          *plug_in_defs;
+  GError          *error = NULL;
+
+  modified = g_memdup2 (fixture->cache_data, fixture->cache_size);
+  header   = (TestCacheHeader *) modified;
+
+  header->version++;
+  gimp_test_assert_cache_falls_back (gimp, fixture,
+                                     modified, fixture->cache_size);
+  header->version--;
+
+  header->protocol_version++;
+  gimp_test_assert_cache_falls_back (gimp, fixture,
+                                     modified, fixture->cache_size);
+  header->protocol_version--;
+
+  header->byte_order = GUINT32_SWAP_LE_BE (header->byte_order);
+  gimp_test_assert_cache_falls_back (gimp, fixture,
+                                     modified, fixture->cache_size);
+  header->byte_order = GUINT32_SWAP_LE_BE (header->byte_order);
+
+  header->magic[0] = 'X';
+  gimp_test_assert_cache_falls_back (gimp, fixture,
+                                     modified, fixture->cache_size);
+
+  g_free (modified);
+
+  /*  a pluginrc rewritten since the cache was, without one of the
+   *  plug-ins
+   */
+  plug_in_defs = g_slist_copy_deep (fixture->plug_in_defs->next,
+                                    (GCopyFunc) g_object_ref, NULL);
+
+  g_assert_true (plug_in_rc_write (plug_in_defs, fixture->pluginrc, &error));
+  g_assert_no_error (error);
+
+  g_slist_free_full (fixture->plug_in_defs, (GDestroyNotify) g_object_unref);
+  fixture->plug_in_defs = plug_in_defs;
+
+  gimp_test_assert_cache_falls_back (gimp, fixture,
+                                     fixture->cache_data, fixture->cache_size);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (cache_round_trip);
+  ADD_TEST (cache_missing);
+  ADD_TEST (cache_corrupt);
+  ADD_TEST (cache_truncated);
+  ADD_TEST (cache_version_mismatch);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,506 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpbase/gimpwire.h"
+
+#include "plug-in/plug-in-types.h"
+
+#include "pdb/pdb-types.h"
+
+#include "config/gimpcoreconfig.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+
+#include "pdb/gimppdbcontext.h"
+
+#include "plug-in/gimpplugin.h"
+#include "plug-in/gimpplugin-message.h"
+#include "plug-in/gimppluginmanager.h"
+#include "plug-in/gimppluginshm.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_TEST_IMAGE_WIDTH  300
+#define GIMP_TEST_IMAGE_HEIGHT 200
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-plug-in/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_plug_in_setup, \
+              function, \
+              gimp_test_plug_in_teardown);
+
+
+typedef struct
+{
+  GimpImage   *image;
+  GimpLayer   *layer;
+  GimpContext *context;
+  GimpPlugIn  *plug_in;
+  gboolean     use_shm;
+} GimpTestFixture;
+
+
+/**
+ * gimp_test_plug_in_setup:
+ * @fixture:
+ * @data:
+ *
+ * Sets up an image with a layer filled with a pattern, and an open
+ * plug-in without a process, whose messages are passed to
+ * gimp_plug_in_handle_message() directly and whose replies are read
+ * from the other end of its pipe.
+ **/
+static void
+gimp_test_plug_in_setup (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  Gimp   *gimp = GIMP (data);
+  GFile  *file;
+  guchar *pixels;
+  gint    fds[2];
+  gint    i;
+
+  fixture->image = gimp_image_new (gimp,
+                                   GIMP_TEST_IMAGE_WIDTH,
+                                   GIMP_TEST_IMAGE_HEIGHT,
+                                   GIMP_RGB,
+                                   GIMP_PRECISION_U8_NON_LINEAR);
+
+  fixture->layer = gimp_layer_new (fixture->image,
+                                   GIMP_TEST_IMAGE_WIDTH,
+                                   GIMP_TEST_IMAGE_HEIGHT,
+                                   babl_format ("R'G'B' u8"),
+                                   "Test Layer",
+                                   GIMP_OPACITY_OPAQUE,
+                                   GIMP_LAYER_MODE_NORMAL);
+
+  gimp_image_add_layer (fixture->image,
+                        fixture->layer,
+                        GIMP_IMAGE_ACTIVE_PARENT,
+                        0,
+                        FALSE);
+
+  pixels = g_malloc (GIMP_TEST_IMAGE_WIDTH * GIMP_TEST_IMAGE_HEIGHT * 3);
+
+  for (i = 0; i < GIMP_TEST_IMAGE_WIDTH * GIMP_TEST_IMAGE_HEIGHT * 3; i++)
+    pixels[i] = (i * 7) % 251;
+
+  gegl_buffer_set (gimp_drawable_get_buffer (GIMP_DRAWABLE (fixture->layer)),
+                   NULL, 0, babl_format ("R'G'B' u8"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (pixels);
+
+  /*  the test instance doesn't use shared memory for tiles, buffer
+   *  mappings only need it to be allowed
+   */
+  fixture->use_shm = gimp->use_shm;
+  gimp->use_shm    = TRUE;
+
+  fixture->context = gimp_pdb_context_new (gimp,
+                                           gimp_get_user_context (gimp),
+                                           FALSE);
+
+  file = g_file_new_for_path ("test-plug-in");
+
+  fixture->plug_in = gimp_plug_in_new (gimp->plug_in_manager,
+                                       fixture->context, NULL, NULL, file);
+
+  g_object_unref (file);
+
+  g_assert_true (pipe (fds) == 0);
+
+  fixture->plug_in->my_write = g_io_channel_unix_new (fds[1]);
+  fixture->plug_in->his_read = g_io_channel_unix_new (fds[0]);
+
+  g_io_channel_set_encoding (fixture->plug_in->my_write, NULL, NULL);
+  g_io_channel_set_encoding (fixture->plug_in->his_read, NULL, NULL);
+
+  g_io_channel_set_buffered (fixture->plug_in->my_write, FALSE);
+  g_io_channel_set_buffered (fixture->plug_in->his_read, FALSE);
+
+  g_io_channel_set_close_on_unref (fixture->plug_in->my_write, TRUE);
+  g_io_channel_set_close_on_unref (fixture->plug_in->his_read, TRUE);
+
+  fixture->plug_in->open = TRUE;
+
+  gimp_plug_in_manager_add_open_plug_in (gimp->plug_in_manager,
+                                         fixture->plug_in);
+}
+
+static void
+gimp_test_plug_in_teardown (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  if (fixture->plug_in->open)
+    gimp_plug_in_close (fixture->plug_in, FALSE);
+
+  g_object_unref (fixture->plug_in);
+  g_object_unref (fixture->context);
+  g_object_unref (fixture->image);
+
+  gimp->use_shm = fixture->use_shm;
+}
+
+/*  Sends a GP_BUFFER_MAP_REQ for the fixture's layer and returns the
+ *  core's GP_BUFFER_MAP_DATA reply.
+ */
+static void
+gimp_test_plug_in_map (GimpTestFixture *fixture,
+                       GPBufferMapData *buffer_map_data)
+{
+  GPBufferMapReq  request;
+  GimpWireMessage msg;
+
+  request.drawable_id = gimp_item_get_id (GIMP_ITEM (fixture->layer));
+  request.shadow      = FALSE;
+
+  msg.type = GP_BUFFER_MAP_REQ;
+  msg.data = &request;
+
+  gimp_plug_in_handle_message (fixture->plug_in, &msg);
+
+  g_assert_true (fixture->plug_in->open);
+
+  g_assert_true (gimp_wire_read_msg (fixture->plug_in->his_read, &msg, NULL));
+  g_assert_cmpuint (msg.type, ==, GP_BUFFER_MAP_DATA);
+  g_assert_nonnull (msg.data);
+
+  *buffer_map_data = *(GPBufferMapData *) msg.data;
+  buffer_map_data->map_name = NULL;
+
+  g_assert_cmpint (buffer_map_data->drawable_id, ==, request.drawable_id);
+  g_assert_cmpuint (buffer_map_data->shadow, ==, FALSE);
+
+  gimp_wire_destroy (&msg);
+}
+
+static void
+gimp_test_plug_in_unmap (GimpTestFixture *fixture,
+                         gint             map_id,
+                         gint             x,
+                         gint             y,
+                         gint             width,
+                         gint             height)
+{
+  GPBufferUnmap   unmap = { map_id, x, y, width, height };
+  GimpWireMessage msg;
+
+  msg.type = GP_BUFFER_UNMAP;
+  msg.data = &unmap;
+
+  gimp_plug_in_handle_message (fixture->plug_in, &msg);
+}
+
+/**
+ * buffer_map_round_trip:
+ * @fixture:
+ * @data:
+ *
+ * A mapped segment must hold the drawable's pixels, and unmapping it
+ * must write back exactly the area the plug-in reports as changed,
+ * and release the segment.
+ **/
+static void
+buffer_map_round_trip (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  GeglBuffer          *buffer;
+  GimpPlugInBufferMap *map;
+  GPBufferMapData      buffer_map_data;
+  GeglRectangle        rect = { 10, 20, 30, 40 };
+  const gint           rowstride = GIMP_TEST_IMAGE_WIDTH * 3;
+  guchar              *expected;
+  guchar              *result;
+  guchar              *addr;
+  gint                 y;
+
+  buffer = gimp_drawable_get_buffer (GIMP_DRAWABLE (fixture->layer));
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data);
+
+  g_assert_cmpint (buffer_map_data.map_id, !=, -1);
+  g_assert_cmpuint (buffer_map_data.width, ==, GIMP_TEST_IMAGE_WIDTH);
+  g_assert_cmpuint (buffer_map_data.height, ==, GIMP_TEST_IMAGE_HEIGHT);
+  g_assert_cmpuint (buffer_map_data.bpp, ==, 3);
+
+  map = gimp_plug_in_find_buffer_map (fixture->plug_in,
+                                      buffer_map_data.map_id);
+  g_assert_nonnull (map);
+  g_assert_cmpuint (fixture->plug_in->buffer_maps_size, ==,
+                    GIMP_TEST_IMAGE_HEIGHT * rowstride);
+
+  expected = g_malloc (GIMP_TEST_IMAGE_HEIGHT * rowstride);
+  result   = g_malloc (GIMP_TEST_IMAGE_HEIGHT * rowstride);
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("R'G'B' u8"),
+                   expected, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  addr = gimp_plug_in_shm_get_addr (map->shm);
+
+  g_assert_true (memcmp (addr, expected,
+                         GIMP_TEST_IMAGE_HEIGHT * rowstride) == 0);
+
+  /*  change a larger area than the one reported, only the reported
+   *  area may be written back
+   */
+  for (y = 0; y < GIMP_TEST_IMAGE_HEIGHT; y++)
+    memset (addr + y * rowstride, 0xff, rowstride / 2);
+
+  for (y = rect.y; y < rect.y + rect.height; y++)
+    memset (expected + y * rowstride + rect.x * 3, 0xff, rect.width * 3);
+
+  gimp_test_plug_in_unmap (fixture, buffer_map_data.map_id,
+                           rect.x, rect.y, rect.width, rect.height);
+
+  g_assert_true (fixture->plug_in->open);
+  g_assert_null (gimp_plug_in_find_buffer_map (fixture->plug_in,
+                                               buffer_map_data.map_id));
+  g_assert_null (fixture->plug_in->buffer_maps);
+  g_assert_cmpuint (fixture->plug_in->buffer_maps_size, ==, 0);
+
+  gegl_buffer_get (buffer, NULL, 1.0, babl_format ("R'G'B' u8"),
+                   result, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  g_assert_true (memcmp (result, expected,
+                         GIMP_TEST_IMAGE_HEIGHT * rowstride) == 0);
+
+  g_free (expected);
+  g_free (result);
+}
+
+/**
+ * buffer_map_extent_mismatch:
+ * @fixture:
+ * @data:
+ *
+ * Writing back a mapping of a drawable that was resized meanwhile
+ * must kill the plug-in and release its mappings.
+ **/
+static void
+buffer_map_extent_mismatch (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  GPBufferMapData buffer_map_data;
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data);
+
+  g_assert_cmpint (buffer_map_data.map_id, !=, -1);
+
+  gimp_item_resize (GIMP_ITEM (fixture->layer), fixture->context,
+                    GIMP_FILL_TRANSPARENT,
+                    GIMP_TEST_IMAGE_WIDTH / 2, GIMP_TEST_IMAGE_HEIGHT / 2,
+                    0, 0);
+
+  gimp_test_plug_in_unmap (fixture, buffer_map_data.map_id,
+                           0, 0, 10, 10);
+
+  g_assert_false (fixture->plug_in->open);
+  g_assert_null (fixture->plug_in->buffer_maps);
+  g_assert_cmpuint (fixture->plug_in->buffer_maps_size, ==, 0);
+}
+
+/**
+ * buffer_map_format_mismatch:
+ * @fixture:
+ * @data:
+ *
+ * Same as buffer_map_extent_mismatch(), for a drawable whose format
+ * changed to one of a different size.
+ **/
+static void
+buffer_map_format_mismatch (GimpTestFixture *fixture,
+                            gconstpointer    data)
+{
+  GPBufferMapData buffer_map_data;
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data);
+
+  g_assert_cmpint (buffer_map_data.map_id, !=, -1);
+  g_assert_cmpuint (buffer_map_data.bpp, ==, 3);
+
+  gimp_layer_add_alpha (fixture->layer);
+
+  gimp_test_plug_in_unmap (fixture, buffer_map_data.map_id,
+                           0, 0, 10, 10);
+
+  g_assert_false (fixture->plug_in->open);
+  g_assert_null (fixture->plug_in->buffer_maps);
+}
+
+/**
+ * buffer_map_invalid_area:
+ * @fixture:
+ * @data:
+ *
+ * Writing back an area outside the mapping must kill the plug-in.
+ **/
+static void
+buffer_map_invalid_area (GimpTestFixture *fixture,
+                         gconstpointer    data)
+{
+  GPBufferMapData buffer_map_data;
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data);
+
+  g_assert_cmpint (buffer_map_data.map_id, !=, -1);
+
+  gimp_test_plug_in_unmap (fixture, buffer_map_data.map_id,
+                           GIMP_TEST_IMAGE_WIDTH - 5, 0, 10, 10);
+
+  g_assert_false (fixture->plug_in->open);
+  g_assert_null (fixture->plug_in->buffer_maps);
+}
+
+/**
+ * buffer_map_close:
+ * @fixture:
+ * @data:
+ *
+ * Mappings a plug-in didn't release must be released when it is
+ * closed, e.g. because it crashed, without touching the drawable.
+ **/
+static void
+buffer_map_close (GimpTestFixture *fixture,
+                  gconstpointer    data)
+{
+  GimpPlugInBufferMap *map;
+  GPBufferMapData      buffer_map_data[2];
+  guchar               before[3];
+  guchar               after[3];
+
+  gegl_buffer_sample (gimp_drawable_get_buffer (GIMP_DRAWABLE (fixture->layer)),
+                      0, 0, NULL, before, babl_format ("R'G'B' u8"),
+                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data[0]);
+  gimp_test_plug_in_map (fixture, &buffer_map_data[1]);
+
+  g_assert_cmpint (buffer_map_data[0].map_id, !=, -1);
+  g_assert_cmpint (buffer_map_data[1].map_id, !=, -1);
+  g_assert_cmpint (buffer_map_data[0].map_id, !=, buffer_map_data[1].map_id);
+  g_assert_cmpuint (g_list_length (fixture->plug_in->buffer_maps), ==, 2);
+
+  map = fixture->plug_in->buffer_maps->data;
+
+  memset (gimp_plug_in_shm_get_addr (map->shm), 0xff, 3);
+
+  gimp_plug_in_close (fixture->plug_in, TRUE);
+
+  g_assert_null (fixture->plug_in->buffer_maps);
+  g_assert_cmpuint (fixture->plug_in->buffer_maps_size, ==, 0);
+
+  gegl_buffer_sample (gimp_drawable_get_buffer (GIMP_DRAWABLE (fixture->layer)),
+                      0, 0, NULL, after, babl_format ("R'G'B' u8"),
+                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+  g_assert_true (memcmp (before, after, 3) == 0);
+}
+
+/**
+ * buffer_map_size_limit:
+ * @fixture:
+ * @data:
+ *
+ * A mapping that would make the plug-in's mappings take more memory
+ * than the tile cache must be refused, without closing the plug-in,
+ * so it falls back to tiles.
+ **/
+static void
+buffer_map_size_limit (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  Gimp            *gimp = GIMP (data);
+  GPBufferMapData  buffer_map_data;
+  guint64          tile_cache_size;
+
+  g_object_get (gimp->config,
+                "tile-cache-size", &tile_cache_size,
+                NULL);
+
+  /*  room for exactly one mapping of the layer  */
+  g_object_set (gimp->config,
+                "tile-cache-size",
+                (guint64) GIMP_TEST_IMAGE_WIDTH * GIMP_TEST_IMAGE_HEIGHT * 3,
+                NULL);
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data);
+
+  g_assert_cmpint (buffer_map_data.map_id, !=, -1);
+
+  gimp_test_plug_in_map (fixture, &buffer_map_data);
+
+  g_assert_cmpint (buffer_map_data.map_id, ==, -1);
+  g_assert_cmpuint (g_list_length (fixture->plug_in->buffer_maps), ==, 1);
+
+  g_object_set (gimp->config,
+                "tile-cache-size", tile_cache_size,
+                NULL);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (buffer_map_round_trip);
+  ADD_TEST (buffer_map_extent_mismatch);
+  ADD_TEST (buffer_map_format_mismatch);
+  ADD_TEST (buffer_map_invalid_area);
+  ADD_TEST (buffer_map_close);
+  ADD_TEST (buffer_map_size_limit);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
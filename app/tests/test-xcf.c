@@ -47,6 +47,7 @@
 #include "core/gimpgrouplayer.h"
 #include "core/gimpguide.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-convert-precision.h"
 #include "core/gimpimage-grid.h"
 #include "core/gimpimage-guides.h"
 #include "core/gimpimage-sample-points.h"
@@ -151,6 +152,10 @@
                                           { 921.0, 922.0, /* pad zeroes */ },\
                                           { 931.0, 932.0, /* pad zeroes */ }, }
 
+#define GIMP_PERFIMAGE_WIDTH            4096
+#define GIMP_PERFIMAGE_HEIGHT           4096
+#define GIMP_PERFIMAGE_N_LAYERS         4
+
 #define ADD_TEST(function) \
   g_test_add_data_func ("/gimp-xcf/" #function, gimp, function);
 
@@ -169,6 +174,17 @@ static void        gimp_assert_mainimage                       (GimpImage
                                                                 gboolean         with_unusual_stuff,
                                                                 gboolean         compat_paths,
                                                                 gboolean         use_gimp_2_8_features);
+static void        gimp_assert_layers_equal                    (GimpImage       *image,
+                                                                GimpImage       *loaded_image,
+                                                                gint             max_level);
+static GimpImage * gimp_create_perfimage                       (Gimp            *gimp,
+                                                                gint             width,
+                                                                gint             height);
+static GFile     * gimp_save_perfimage                         (GimpImage       *image,
+                                                                gboolean         zlib_compression);
+static void        gimp_time_load_by_num_processors            (Gimp            *gimp,
+                                                                GFile           *file,
+                                                                const gchar     *description);
 
 
 /**
@@ -262,6 +278,359 @@ write_and_read_gimp_2_8_format (gconstpointer data)
                             TRUE /*use_gimp_2_8_features*/);
 }
 
+/**
+ * load_compressed_file_scaling:
+ * @data:
+ *
+ * Benchmark, only run in perf mode: writes a large RLE and a large
+ * zlib compressed XCF file, and reports how long loading them takes
+ * with an increasing number of threads.
+ **/
+static void
+load_compressed_file_scaling (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GFile     *file;
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  image = gimp_create_perfimage (gimp,
+                                 GIMP_PERFIMAGE_WIDTH, GIMP_PERFIMAGE_HEIGHT);
+
+  file = gimp_save_perfimage (image, FALSE);
+  gimp_time_load_by_num_processors (gimp, file, "RLE");
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+
+  file = gimp_save_perfimage (image, TRUE);
+  gimp_time_load_by_num_processors (gimp, file, "zlib");
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+
+  g_object_unref (image);
+}
+
+/**
+ * write_and_read_mipmaps:
+ * @data:
+ *
+ * Write an image along with its mipmap levels, and make sure that the
+ * loaded image matches the original both zoomed-out, where it is
+ * rendered from the stored levels, and at full resolution, which is
+ * loaded on demand.
+ **/
+static void
+write_and_read_mipmaps (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpImage *loaded_image;
+  GFile     *file;
+
+  image = gimp_create_perfimage (gimp, 1000, 700);
+  gimp_image_set_xcf_mipmaps (image, TRUE);
+
+  file = gimp_save_perfimage (image, FALSE);
+  loaded_image = gimp_test_load_image (gimp, file);
+
+  g_assert_nonnull (loaded_image);
+  g_assert_true (gimp_image_get_xcf_mipmaps (loaded_image));
+
+  gimp_assert_layers_equal (image, loaded_image, 2);
+
+  g_object_unref (loaded_image);
+  g_object_unref (image);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+/**
+ * save_over_progressively_loaded:
+ * @data:
+ *
+ * Save an image over the file it is still being progressively loaded
+ * from, and make sure that reloading the file gives back the original
+ * image.
+ **/
+static void
+save_over_progressively_loaded (gconstpointer data)
+{
+  Gimp                *gimp = GIMP (data);
+  GimpImage           *image;
+  GimpImage           *loaded_image;
+  GimpImage           *reloaded_image;
+  GimpPlugInProcedure *proc;
+  GFile               *file;
+
+  image = gimp_create_perfimage (gimp, 1000, 700);
+  gimp_image_set_xcf_mipmaps (image, TRUE);
+
+  file = gimp_save_perfimage (image, TRUE);
+
+  /*  the main loop doesn't run, so nothing is loaded in the background  */
+  loaded_image = gimp_test_load_image (gimp, file);
+  g_assert_nonnull (loaded_image);
+
+  proc = gimp_plug_in_manager_file_procedure_find (gimp->plug_in_manager,
+                                                   GIMP_FILE_PROCEDURE_GROUP_SAVE,
+                                                   file,
+                                                   NULL /*error*/);
+  g_assert_cmpint (file_save (gimp,
+                              loaded_image,
+                              NULL /*progress*/,
+                              file,
+                              proc,
+                              GIMP_RUN_NONINTERACTIVE,
+                              FALSE /*change_saved_state*/,
+                              FALSE /*export_backward*/,
+                              FALSE /*export_forward*/,
+                              NULL /*error*/),
+                   ==, GIMP_PDB_SUCCESS);
+
+  reloaded_image = gimp_test_load_image (gimp, file);
+  g_assert_nonnull (reloaded_image);
+
+  gimp_assert_layers_equal (image, loaded_image,   0);
+  gimp_assert_layers_equal (image, reloaded_image, 2);
+
+  g_object_unref (reloaded_image);
+  g_object_unref (loaded_image);
+  g_object_unref (image);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+/**
+ * load_mipmaps_not_progressively:
+ * @data:
+ *
+ * Load a file with mipmap levels with progressive loading disabled,
+ * and make sure that the loaded image matches the original.
+ **/
+static void
+load_mipmaps_not_progressively (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpImage *loaded_image;
+  GFile     *file;
+
+  image = gimp_create_perfimage (gimp, 1000, 700);
+  gimp_image_set_xcf_mipmaps (image, TRUE);
+
+  file = gimp_save_perfimage (image, TRUE);
+
+  g_object_set (gimp->config,
+                "xcf-progressive-load", FALSE,
+                NULL);
+
+  loaded_image = gimp_test_load_image (gimp, file);
+
+  g_object_set (gimp->config,
+                "xcf-progressive-load", TRUE,
+                NULL);
+
+  g_assert_nonnull (loaded_image);
+  g_assert_true (gimp_image_get_xcf_mipmaps (loaded_image));
+
+  gimp_assert_layers_equal (image, loaded_image, 0);
+
+  g_object_unref (loaded_image);
+  g_object_unref (image);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+/**
+ * load_lazily:
+ * @data:
+ *
+ * Load a file in lazy mode, where tiles are only read from the file
+ * when accessed, and make sure that the loaded image matches the
+ * original.
+ **/
+static void
+load_lazily (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpImage *loaded_image;
+  GFile     *file;
+
+  image = gimp_create_perfimage (gimp, 1000, 700);
+
+  file = gimp_save_perfimage (image, TRUE);
+
+  g_object_set (gimp->config,
+                "xcf-lazy-load", TRUE,
+                NULL);
+
+  loaded_image = gimp_test_load_image (gimp, file);
+
+  g_object_set (gimp->config,
+                "xcf-lazy-load", FALSE,
+                NULL);
+
+  g_assert_nonnull (loaded_image);
+  g_assert_false (gimp_image_get_xcf_mipmaps (loaded_image));
+
+  gimp_assert_layers_equal (image, loaded_image, 0);
+
+  g_object_unref (loaded_image);
+  g_object_unref (image);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+/**
+ * write_and_read_zstd:
+ * @data:
+ *
+ * Write a floating point image using zstd compression, and make sure
+ * that the loaded image matches the original.
+ **/
+static void
+write_and_read_zstd (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  GimpImage *loaded_image;
+  GFile     *file;
+
+  image = gimp_create_perfimage (gimp, 1000, 700);
+  gimp_image_convert_precision (image, GIMP_PRECISION_FLOAT_LINEAR,
+                                GEGL_DITHER_NONE,
+                                GEGL_DITHER_NONE,
+                                GEGL_DITHER_NONE,
+                                NULL);
+
+  g_object_set (gimp->config,
+                "xcf-zstd-compression", TRUE,
+                NULL);
+
+  g_assert_cmpint (gimp_image_get_xcf_version (image, TRUE, FALSE,
+                                               NULL, NULL, NULL), ==, 20);
+
+  file = gimp_save_perfimage (image, TRUE);
+
+  g_object_set (gimp->config,
+                "xcf-zstd-compression", FALSE,
+                NULL);
+
+  loaded_image = gimp_test_load_image (gimp, file);
+
+  g_assert_nonnull (loaded_image);
+  g_assert_true (gimp_image_get_xcf_compression (loaded_image));
+
+  gimp_assert_layers_equal (image, loaded_image, 0);
+
+  g_object_unref (loaded_image);
+  g_object_unref (image);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+/**
+ * compare_compression_timing:
+ * @data:
+ *
+ * Benchmark, only run in perf mode: saves and loads a large floating
+ * point image with each compression type, and reports the timings
+ * and file sizes.
+ **/
+static void
+compare_compression_timing (gconstpointer data)
+{
+  Gimp      *gimp = GIMP (data);
+  GimpImage *image;
+  gint       i;
+
+  const struct
+  {
+    const gchar *name;
+    gboolean     compression;
+    gboolean     zstd;
+  } codecs[] =
+  {
+    { "RLE",  FALSE, FALSE },
+    { "zlib", TRUE,  FALSE },
+    { "zstd", TRUE,  TRUE  }
+  };
+
+  if (! g_test_perf ())
+    {
+      g_test_skip ("only run in perf mode");
+      return;
+    }
+
+  image = gimp_create_perfimage (gimp,
+                                 GIMP_PERFIMAGE_WIDTH, GIMP_PERFIMAGE_HEIGHT);
+  gimp_image_convert_precision (image, GIMP_PRECISION_FLOAT_LINEAR,
+                                GEGL_DITHER_NONE,
+                                GEGL_DITHER_NONE,
+                                GEGL_DITHER_NONE,
+                                NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (codecs); i++)
+    {
+      GimpImage *loaded_image;
+      GFile     *file;
+      GFileInfo *file_info;
+      GTimer    *timer;
+      gdouble    save_time;
+      gdouble    load_time;
+
+      g_object_set (gimp->config,
+                    "xcf-zstd-compression", codecs[i].zstd,
+                    NULL);
+
+      timer = g_timer_new ();
+      file = gimp_save_perfimage (image, codecs[i].compression);
+      save_time = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      loaded_image = gimp_test_load_image (gimp, file);
+      load_time = g_timer_elapsed (timer, NULL);
+
+      g_assert_nonnull (loaded_image);
+
+      file_info = g_file_query_info (file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                     G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+      g_test_message ("%s: saved %dx%d float image with %d layers "
+                      "in %.3f s, loaded in %.3f s, "
+                      "file size %" G_GOFFSET_FORMAT " bytes",
+                      codecs[i].name,
+                      GIMP_PERFIMAGE_WIDTH, GIMP_PERFIMAGE_HEIGHT,
+                      GIMP_PERFIMAGE_N_LAYERS,
+                      save_time, load_time,
+                      file_info ? g_file_info_get_size (file_info) : 0);
+
+      g_clear_object (&file_info);
+      g_timer_destroy (timer);
+      g_object_unref (loaded_image);
+
+      g_file_delete (file, NULL, NULL);
+      g_object_unref (file);
+    }
+
+  g_object_set (gimp->config,
+                "xcf-zstd-compression", FALSE,
+                NULL);
+
+  g_object_unref (image);
+}
+
 GimpImage *
 gimp_test_load_image (Gimp  *gimp,
                       GFile *file)
@@ -359,6 +728,222 @@ gimp_write_and_read_file (Gimp     *gimp,
   g_object_unref (file);
 }
 
+/**
+ * gimp_assert_layers_equal:
+ *
+ * Asserts that the layers of @image and @loaded_image have the same
+ * pixels, when read at full resolution and at each of the first
+ * @max_level mipmap levels.  The mipmap levels are compared first, so
+ * that they are read before the full-resolution data.
+ **/
+static void
+gimp_assert_layers_equal (GimpImage *image,
+                          GimpImage *loaded_image,
+                          gint       max_level)
+{
+  GList *layers;
+  GList *loaded_layers;
+
+  layers        = gimp_image_get_layer_iter (image);
+  loaded_layers = gimp_image_get_layer_iter (loaded_image);
+
+  g_assert_cmpint (g_list_length (layers), ==, g_list_length (loaded_layers));
+
+  for (;
+       layers;
+       layers = g_list_next (layers), loaded_layers = g_list_next (loaded_layers))
+    {
+      GeglBuffer *buffer;
+      GeglBuffer *loaded_buffer;
+      gint        level;
+
+      buffer        = gimp_drawable_get_buffer (layers->data);
+      loaded_buffer = gimp_drawable_get_buffer (loaded_layers->data);
+
+      for (level = max_level; level >= 0; level--)
+        {
+          GeglRectangle  rect;
+          gdouble        scale = 1.0 / (1 << level);
+          guchar        *pixels;
+          guchar        *loaded_pixels;
+          gint           i;
+
+          rect.x      = 0;
+          rect.y      = 0;
+          rect.width  = gegl_buffer_get_width  (buffer) >> level;
+          rect.height = gegl_buffer_get_height (buffer) >> level;
+
+          pixels        = g_malloc (rect.width * rect.height * 4);
+          loaded_pixels = g_malloc (rect.width * rect.height * 4);
+
+          gegl_buffer_get (buffer, &rect, scale,
+                           babl_format ("R'G'B'A u8"), pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          gegl_buffer_get (loaded_buffer, &rect, scale,
+                           babl_format ("R'G'B'A u8"), loaded_pixels,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          for (i = 0; i < rect.width * rect.height * 4; i++)
+            g_assert_cmpint (ABS (pixels[i] - loaded_pixels[i]), <=, 1);
+
+          g_free (pixels);
+          g_free (loaded_pixels);
+        }
+    }
+}
+
+/**
+ * gimp_create_perfimage:
+ *
+ * Creates a large image with a few layers of noisy content, which
+ * neither compresses away to nothing nor is incompressible.
+ *
+ * Returns: The #GimpImage
+ **/
+static GimpImage *
+gimp_create_perfimage (Gimp *gimp,
+                       gint  width,
+                       gint  height)
+{
+  GimpImage *image;
+  GRand     *rand;
+  gint       i;
+
+  image = gimp_image_new (gimp,
+                          width,
+                          height,
+                          GIMP_RGB,
+                          GIMP_PRECISION_U8_NON_LINEAR);
+
+  rand = g_rand_new_with_seed (42);
+
+  for (i = 0; i < GIMP_PERFIMAGE_N_LAYERS; i++)
+    {
+      GimpLayer          *layer;
+      GeglBufferIterator *iter;
+
+      layer = gimp_layer_new (image,
+                              width,
+                              height,
+                              babl_format ("R'G'B'A u8"),
+                              "perf-layer",
+                              GIMP_OPACITY_OPAQUE,
+                              GIMP_LAYER_MODE_NORMAL);
+      gimp_image_add_layer (image,
+                            layer,
+                            NULL,
+                            0,
+                            FALSE /*push_undo*/);
+
+      iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                                       NULL, 0, babl_format ("R'G'B'A u8"),
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          guchar *dest  = iter->items[0].data;
+          gint    count = iter->length;
+
+          while (count--)
+            {
+              /* a base color per chunk with some noise on top */
+              dest[0] = (iter->items[0].roi.x >> 4) + g_rand_int_range (rand, 0, 8);
+              dest[1] = (iter->items[0].roi.y >> 4) + g_rand_int_range (rand, 0, 8);
+              dest[2] = i * 64;
+              dest[3] = 255;
+
+              dest += 4;
+            }
+        }
+    }
+
+  g_rand_free (rand);
+
+  return image;
+}
+
+static GFile *
+gimp_save_perfimage (GimpImage *image,
+                     gboolean   zlib_compression)
+{
+  GimpPlugInProcedure *proc;
+  gchar               *filename = NULL;
+  gint                 file_handle;
+  GFile               *file;
+
+  gimp_image_set_xcf_compression (image, zlib_compression);
+
+  file_handle = g_file_open_tmp ("gimp-test-XXXXXX.xcf", &filename, NULL);
+  g_assert (file_handle != -1);
+  close (file_handle);
+  file = g_file_new_for_path (filename);
+  g_free (filename);
+
+  proc = gimp_plug_in_manager_file_procedure_find (image->gimp->plug_in_manager,
+                                                   GIMP_FILE_PROCEDURE_GROUP_SAVE,
+                                                   file,
+                                                   NULL /*error*/);
+  file_save (image->gimp,
+             image,
+             NULL /*progress*/,
+             file,
+             proc,
+             GIMP_RUN_NONINTERACTIVE,
+             FALSE /*change_saved_state*/,
+             FALSE /*export_backward*/,
+             FALSE /*export_forward*/,
+             NULL /*error*/);
+
+  return file;
+}
+
+static void
+gimp_time_load_by_num_processors (Gimp        *gimp,
+                                  GFile       *file,
+                                  const gchar *description)
+{
+  gint num_processors;
+  gint max_processors = g_get_num_processors ();
+  gint n;
+
+  g_object_get (gimp->config,
+                "num-processors", &num_processors,
+                NULL);
+
+  for (n = 1;
+       n <= max_processors;
+       n = (n < max_processors && n * 2 > max_processors) ?
+           max_processors : n * 2)
+    {
+      GimpImage *loaded_image;
+      GTimer    *timer;
+
+      g_object_set (gimp->config,
+                    "num-processors", n,
+                    NULL);
+
+      timer = g_timer_new ();
+      loaded_image = gimp_test_load_image (gimp, file);
+      g_timer_stop (timer);
+
+      g_assert_nonnull (loaded_image);
+
+      g_test_message ("%s: loaded %dx%d image with %d layers "
+                      "using %d thread(s) in %.3f s",
+                      description,
+                      GIMP_PERFIMAGE_WIDTH, GIMP_PERFIMAGE_HEIGHT,
+                      GIMP_PERFIMAGE_N_LAYERS,
+                      n, g_timer_elapsed (timer, NULL));
+
+      g_timer_destroy (timer);
+      g_object_unref (loaded_image);
+    }
+
+  g_object_set (gimp->config,
+                "num-processors", num_processors,
+                NULL);
+}
+
 /**
  * gimp_create_mainimage:
  *
@@ -1028,6 +1613,13 @@ main (int    argc,
   ADD_TEST (write_and_read_gimp_2_6_format_unusual);
   ADD_TEST (load_gimp_2_6_file);
   ADD_TEST (write_and_read_gimp_2_8_format);
+  ADD_TEST (load_compressed_file_scaling);
+  ADD_TEST (write_and_read_mipmaps);
+  ADD_TEST (save_over_progressively_loaded);
+  ADD_TEST (load_mipmaps_not_progressively);
+  ADD_TEST (load_lazily);
+  ADD_TEST (write_and_read_zstd);
+  ADD_TEST (compare_compression_timing);
 
   /* Don't write files to the source dir */
   gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
@@ -42,6 +42,7 @@
 
 #include "gimpfont.h"
 #include "gimpfontfactory.h"
+#include "gimptextlayout.h"
 
 #include "gimp-intl.h"
 
@@ -255,6 +256,9 @@ gimp_font_factory_load_async_callback (GimpAsync       *async,
 
       FcConfigSetCurrent (config);
 
+      /*  make text layouts use the new configuration  */
+      gimp_text_layout_reset_font_maps ();
+
       fontmap = pango_cairo_font_map_new_for_font_type (CAIRO_FONT_TYPE_FT);
       if (! fontmap)
         g_error ("You are using a Pango that has been built against a cairo "
@@ -70,7 +70,12 @@ enum
 
 struct _GimpTextLayerPrivate
 {
-  GimpTextDirection base_dir;
+  GimpTextDirection   base_dir;
+
+  /*  what the layer's pixels were last rendered from  */
+  GimpTextLayout     *layout;
+  GimpText           *layout_text;
+  GimpColorTransform *layout_transform;
 };
 
 static void       gimp_text_layer_finalize       (GObject           *object);
@@ -120,6 +125,16 @@ static void       gimp_text_layer_text_changed   (GimpTextLayer     *layer);
 static gboolean   gimp_text_layer_render         (GimpTextLayer     *layer);
 static void       gimp_text_layer_render_layout  (GimpTextLayer     *layer,
                                                   GimpTextLayout    *layout);
+static void       gimp_text_layer_render_rect    (GimpTextLayer     *layer,
+                                                  GimpTextLayout    *layout,
+                                                  GimpColorTransform *transform,
+                                                  const cairo_rectangle_int_t *rect);
+static cairo_region_t *
+                  gimp_text_layer_get_dirty_region
+                                                 (GimpTextLayer     *layer,
+                                                  GimpTextLayout    *layout,
+                                                  GimpColorTransform *transform);
+static void       gimp_text_layer_clear_layout   (GimpTextLayer     *layer);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTextLayer, gimp_text_layer, GIMP_TYPE_LAYER)
@@ -201,6 +216,8 @@ gimp_text_layer_finalize (GObject *object)
 {
   GimpTextLayer *layer = GIMP_TEXT_LAYER (object);
 
+  gimp_text_layer_clear_layout (layer);
+
   g_clear_object (&layer->text);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -334,6 +351,9 @@ gimp_text_layer_set_buffer (GimpDrawable        *drawable,
   GimpTextLayer *layer = GIMP_TEXT_LAYER (drawable);
   GimpImage     *image = gimp_item_get_image (GIMP_ITEM (layer));
 
+  /*  the new pixels didn't come from the last rendered layout  */
+  gimp_text_layer_clear_layout (layer);
+
   if (push_undo && ! layer->modified)
     gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_DRAWABLE_MOD,
                                  undo_desc);
@@ -364,6 +384,8 @@ gimp_text_layer_push_undo (GimpDrawable *drawable,
   GimpTextLayer *layer = GIMP_TEXT_LAYER (drawable);
   GimpImage     *image = gimp_item_get_image (GIMP_ITEM (layer));
 
+  gimp_text_layer_clear_layout (layer);
+
   if (! layer->modified)
     gimp_image_undo_group_start (image, GIMP_UNDO_GROUP_DRAWABLE, undo_desc);
 
@@ -415,6 +437,7 @@ gimp_text_layer_convert_type (GimpLayer         *layer,
 
       text_layer->convert_format = new_format;
 
+      gimp_text_layer_clear_layout (text_layer);
       gimp_text_layer_render (text_layer);
 
       text_layer->convert_format = NULL;
@@ -919,29 +942,77 @@ gimp_temp_buf_create_cairo_surface (GimpTempBuf *temp_buf)
 static void
 gimp_text_layer_render_layout (GimpTextLayer  *layer,
                                GimpTextLayout *layout)
+{
+  GimpDrawable          *drawable = GIMP_DRAWABLE (layer);
+  GimpItem              *item     = GIMP_ITEM (layer);
+  GimpImage             *image    = gimp_item_get_image (item);
+  GimpColorTransform    *transform;
+  cairo_region_t        *region;
+  gint                   n_rects;
+  gint                   i;
+
+  g_return_if_fail (gimp_drawable_has_alpha (drawable));
+
+  transform = gimp_image_get_color_transform_from_srgb_u8 (image);
+
+  /*  only render the lines that changed since the last time, if the
+   *  layer's pixels are still what we rendered back then
+   */
+  region = gimp_text_layer_get_dirty_region (layer, layout, transform);
+
+  if (! region)
+    {
+      cairo_rectangle_int_t rect;
+
+      rect.x      = 0;
+      rect.y      = 0;
+      rect.width  = gimp_item_get_width  (item);
+      rect.height = gimp_item_get_height (item);
+
+      region = cairo_region_create_rectangle (&rect);
+    }
+
+  n_rects = cairo_region_num_rectangles (region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (region, i, &rect);
+
+      gimp_text_layer_render_rect (layer, layout, transform, &rect);
+    }
+
+  cairo_region_destroy (region);
+
+  gimp_text_layer_clear_layout (layer);
+
+  layer->private->layout      = g_object_ref (layout);
+  layer->private->layout_text = gimp_config_duplicate (GIMP_CONFIG (layer->text));
+
+  if (transform)
+    layer->private->layout_transform = g_object_ref (transform);
+}
+
+static void
+gimp_text_layer_render_rect (GimpTextLayer               *layer,
+                             GimpTextLayout              *layout,
+                             GimpColorTransform          *transform,
+                             const cairo_rectangle_int_t *rect)
 {
   GimpDrawable       *drawable = GIMP_DRAWABLE (layer);
-  GimpItem           *item     = GIMP_ITEM (layer);
-  GimpImage          *image    = gimp_item_get_image (item);
   GeglBuffer         *buffer;
-  GimpColorTransform *transform;
   cairo_t            *cr;
   cairo_surface_t    *surface;
-  gint                width;
-  gint                height;
   cairo_status_t      status;
 
-  g_return_if_fail (gimp_drawable_has_alpha (drawable));
-
-  width  = gimp_item_get_width  (item);
-  height = gimp_item_get_height (item);
-
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        rect->width, rect->height);
   status = cairo_surface_status (surface);
 
   if (status != CAIRO_STATUS_SUCCESS)
     {
-      GimpImage *image = gimp_item_get_image (item);
+      GimpImage *image = gimp_item_get_image (GIMP_ITEM (layer));
 
       gimp_message_literal (image->gimp, NULL, GIMP_MESSAGE_ERROR,
                             _("Your text cannot be rendered. It is likely too big. "
@@ -951,6 +1022,8 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
     }
 
   cr = cairo_create (surface);
+  cairo_translate (cr, -rect->x, -rect->y);
+
   if (layer->text->outline != GIMP_TEXT_OUTLINE_STROKE_ONLY)
     {
       cairo_save (cr);
@@ -1011,24 +1084,71 @@ gimp_text_layer_render_layout (GimpTextLayer  *layer,
 
   buffer = gimp_cairo_surface_create_buffer (surface);
 
-  transform = gimp_image_get_color_transform_from_srgb_u8 (image);
-
   if (transform)
     {
       gimp_color_transform_process_buffer (transform,
                                            buffer,
                                            NULL,
                                            gimp_drawable_get_buffer (drawable),
-                                           NULL);
+                                           GEGL_RECTANGLE (rect->x,
+                                                           rect->y,
+                                                           rect->width,
+                                                           rect->height));
     }
   else
     {
       gimp_gegl_buffer_copy (buffer, NULL, GEGL_ABYSS_NONE,
-                             gimp_drawable_get_buffer (drawable), NULL);
+                             gimp_drawable_get_buffer (drawable),
+                             GEGL_RECTANGLE (rect->x, rect->y,
+                                             rect->width, rect->height));
     }
 
   g_object_unref (buffer);
   cairo_surface_destroy (surface);
 
-  gimp_drawable_update (drawable, 0, 0, width, height);
+  gimp_drawable_update (drawable,
+                        rect->x, rect->y, rect->width, rect->height);
+}
+
+static cairo_region_t *
+gimp_text_layer_get_dirty_region (GimpTextLayer      *layer,
+                                  GimpTextLayout     *layout,
+                                  GimpColorTransform *transform)
+{
+  GimpTextLayerPrivate *private = layer->private;
+  cairo_region_t       *region  = NULL;
+  GList                *diff;
+  GList                *list;
+
+  if (! private->layout || transform != private->layout_transform)
+    return NULL;
+
+  /*  everything but the text itself has to be the same, the layout
+   *  only knows about changes to the lines
+   */
+  diff = gimp_config_diff (G_OBJECT (private->layout_text),
+                           G_OBJECT (layer->text), 0);
+
+  for (list = diff; list; list = g_list_next (list))
+    {
+      GParamSpec *pspec = list->data;
+
+      if (strcmp (pspec->name, "text") && strcmp (pspec->name, "markup"))
+        break;
+    }
+
+  if (! list)
+    region = gimp_text_layout_get_dirty_region (layout, private->layout);
+
+  g_list_free (diff);
+
+  return region;
+}
+
+static void
+gimp_text_layer_clear_layout (GimpTextLayer *layer)
+{
+  g_clear_object (&layer->private->layout);
+  g_clear_object (&layer->private->layout_text);
+  g_clear_object (&layer->private->layout_transform);
 }
@@ -61,12 +61,27 @@ static PangoContext * gimp_text_get_pango_context (GimpText       *text,
                                                    gdouble         xres,
                                                    gdouble         yres);
 
+static gboolean       gimp_text_layout_line_equal (PangoLayoutIter *iter1,
+                                                   PangoLayoutIter *iter2);
+static void           gimp_text_layout_add_line   (GimpTextLayout  *layout,
+                                                   PangoLayoutIter *iter,
+                                                   cairo_region_t  *region);
+
 
 G_DEFINE_TYPE (GimpTextLayout, gimp_text_layout, G_TYPE_OBJECT)
 
 #define parent_class gimp_text_layout_parent_class
 
 
+/*  font maps shared by all layouts, one per resolution.  pango keeps
+ *  the fonts it loaded alive for as long as their font map, and each
+ *  font keeps a cache of its rasterized glyphs, so sharing the font
+ *  maps lets all text layers reuse glyphs already rendered for the
+ *  same font and size.
+ */
+static GHashTable *font_maps = NULL;
+
+
 static void
 gimp_text_layout_class_init (GimpTextLayoutClass *klass)
 {
@@ -456,6 +471,290 @@ gimp_text_layout_untransform_distance (GimpTextLayout *layout,
     }
 }
 
+/**
+ * gimp_text_layout_get_dirty_region:
+ * @layout:     a #GimpTextLayout
+ * @old_layout: the #GimpTextLayout previously rendered in @layout's place
+ *
+ * Compares the lines of @layout against the lines of @old_layout, and
+ * returns the area that has to be rendered again to turn a rendering
+ * of @old_layout into a rendering of @layout.  Unchanged lines that
+ * merely moved count as changed.
+ *
+ * The caller is responsible for making sure that the text properties
+ * other than the text itself did not change in between.
+ *
+ * Returns: (nullable): the region to update, in the coordinates of the
+ *          layout's extents, or %NULL if the layouts can't be compared
+ *          and everything has to be rendered again.  Free the result
+ *          with cairo_region_destroy().
+ **/
+cairo_region_t *
+gimp_text_layout_get_dirty_region (GimpTextLayout *layout,
+                                   GimpTextLayout *old_layout)
+{
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  extents;
+  PangoLayoutIter       *iter;
+  PangoLayoutIter       *old_iter;
+  cairo_matrix_t         matrix;
+  cairo_matrix_t         old_matrix;
+  gboolean               more     = TRUE;
+  gboolean               old_more = TRUE;
+
+  g_return_val_if_fail (GIMP_IS_TEXT_LAYOUT (layout), NULL);
+  g_return_val_if_fail (GIMP_IS_TEXT_LAYOUT (old_layout), NULL);
+
+  /*  vertical text is rotated on top of the layout's transform, don't
+   *  bother
+   */
+  if (PANGO_GRAVITY_IS_VERTICAL (pango_context_get_base_gravity (
+        pango_layout_get_context (layout->layout))) ||
+      PANGO_GRAVITY_IS_VERTICAL (pango_context_get_base_gravity (
+        pango_layout_get_context (old_layout->layout))))
+    {
+      return NULL;
+    }
+
+  gimp_text_layout_get_transform (layout,     &matrix);
+  gimp_text_layout_get_transform (old_layout, &old_matrix);
+
+  if (layout->xres              != old_layout->xres              ||
+      layout->yres              != old_layout->yres              ||
+      layout->extents.x         != old_layout->extents.x         ||
+      layout->extents.y         != old_layout->extents.y         ||
+      layout->extents.width     != old_layout->extents.width     ||
+      layout->extents.height    != old_layout->extents.height    ||
+      memcmp (&matrix, &old_matrix, sizeof (cairo_matrix_t)))
+    {
+      return NULL;
+    }
+
+  region = cairo_region_create ();
+
+  iter     = pango_layout_get_iter (layout->layout);
+  old_iter = pango_layout_get_iter (old_layout->layout);
+
+  while (more || old_more)
+    {
+      if (! more)
+        {
+          gimp_text_layout_add_line (old_layout, old_iter, region);
+        }
+      else if (! old_more)
+        {
+          gimp_text_layout_add_line (layout, iter, region);
+        }
+      else if (! gimp_text_layout_line_equal (iter, old_iter))
+        {
+          gimp_text_layout_add_line (layout,     iter,     region);
+          gimp_text_layout_add_line (old_layout, old_iter, region);
+        }
+
+      if (more)
+        more = pango_layout_iter_next_line (iter);
+
+      if (old_more)
+        old_more = pango_layout_iter_next_line (old_iter);
+    }
+
+  pango_layout_iter_free (iter);
+  pango_layout_iter_free (old_iter);
+
+  extents.x      = 0;
+  extents.y      = 0;
+  extents.width  = layout->extents.width;
+  extents.height = layout->extents.height;
+
+  cairo_region_intersect_rectangle (region, &extents);
+
+  return region;
+}
+
+/**
+ * gimp_text_layout_reset_font_maps:
+ *
+ * Drops the font maps shared by all text layouts, so that layouts
+ * created from now on pick up the current fontconfig configuration.
+ * Must be called whenever the set of available fonts changes.
+ **/
+void
+gimp_text_layout_reset_font_maps (void)
+{
+  g_clear_pointer (&font_maps, g_hash_table_unref);
+}
+
+static gboolean
+gimp_text_layout_glyph_item_equal (PangoGlyphItem *run1,
+                                   PangoGlyphItem *run2)
+{
+  PangoGlyphString *glyphs1;
+  PangoGlyphString *glyphs2;
+  GSList           *list1;
+  GSList           *list2;
+  gint              i;
+
+  if (! run1 || ! run2)
+    return run1 == run2;
+
+  /*  fonts come from the shared font map and are cached by it, so
+   *  equal fonts are the same object
+   */
+  if (run1->item->analysis.font  != run2->item->analysis.font  ||
+      run1->item->analysis.level != run2->item->analysis.level ||
+      run1->y_offset             != run2->y_offset)
+    {
+      return FALSE;
+    }
+
+  glyphs1 = run1->glyphs;
+  glyphs2 = run2->glyphs;
+
+  if (glyphs1->num_glyphs != glyphs2->num_glyphs)
+    return FALSE;
+
+  for (i = 0; i < glyphs1->num_glyphs; i++)
+    {
+      const PangoGlyphInfo *info1 = &glyphs1->glyphs[i];
+      const PangoGlyphInfo *info2 = &glyphs2->glyphs[i];
+
+      if (info1->glyph             != info2->glyph             ||
+          info1->geometry.width    != info2->geometry.width    ||
+          info1->geometry.x_offset != info2->geometry.x_offset ||
+          info1->geometry.y_offset != info2->geometry.y_offset)
+        {
+          return FALSE;
+        }
+    }
+
+  /*  colors, underline, strikethrough and friends  */
+  for (list1 = run1->item->analysis.extra_attrs,
+       list2 = run2->item->analysis.extra_attrs;
+       list1 && list2;
+       list1 = g_slist_next (list1), list2 = g_slist_next (list2))
+    {
+      if (! pango_attribute_equal (list1->data, list2->data))
+        return FALSE;
+    }
+
+  return list1 == list2;
+}
+
+static gboolean
+gimp_text_layout_line_equal (PangoLayoutIter *iter1,
+                             PangoLayoutIter *iter2)
+{
+  PangoLayoutLine *line1 = pango_layout_iter_get_line_readonly (iter1);
+  PangoLayoutLine *line2 = pango_layout_iter_get_line_readonly (iter2);
+  PangoRectangle   logical1;
+  PangoRectangle   logical2;
+  GSList          *list1;
+  GSList          *list2;
+
+  pango_layout_iter_get_line_extents (iter1, NULL, &logical1);
+  pango_layout_iter_get_line_extents (iter2, NULL, &logical2);
+
+  if (logical1.x      != logical2.x      ||
+      logical1.y      != logical2.y      ||
+      logical1.width  != logical2.width  ||
+      logical1.height != logical2.height ||
+      pango_layout_iter_get_baseline (iter1) !=
+      pango_layout_iter_get_baseline (iter2))
+    {
+      return FALSE;
+    }
+
+  for (list1 = line1->runs, list2 = line2->runs;
+       list1 && list2;
+       list1 = g_slist_next (list1), list2 = g_slist_next (list2))
+    {
+      if (! gimp_text_layout_glyph_item_equal (list1->data, list2->data))
+        return FALSE;
+    }
+
+  return list1 == list2;
+}
+
+static void
+gimp_text_layout_add_line (GimpTextLayout  *layout,
+                           PangoLayoutIter *iter,
+                           cairo_region_t  *region)
+{
+  PangoRectangle        ink;
+  PangoRectangle        logical;
+  cairo_matrix_t        matrix;
+  cairo_rectangle_int_t rect;
+  gdouble               x1, y1;
+  gdouble               x2, y2;
+  gint                  margin;
+  gint                  i;
+
+  pango_layout_iter_get_line_extents (iter, &ink, &logical);
+
+  pango_extents_to_pixels (&ink,     NULL);
+  pango_extents_to_pixels (&logical, NULL);
+
+  /*  backgrounds are drawn across the logical extents  */
+  x1 = MIN (ink.x, logical.x);
+  y1 = MIN (ink.y, logical.y);
+  x2 = MAX (ink.x + ink.width,  logical.x + logical.width);
+  y2 = MAX (ink.y + ink.height, logical.y + logical.height);
+
+  ink.x      = x1;
+  ink.y      = y1;
+  ink.width  = x2 - x1;
+  ink.height = y2 - y1;
+
+  gimp_text_layout_get_transform (layout, &matrix);
+
+  /*  the bounding box of the transformed line, as rendered by
+   *  gimp_text_layout_render()
+   */
+  x1 = y1 = G_MAXDOUBLE;
+  x2 = y2 = -G_MAXDOUBLE;
+
+  for (i = 0; i < 4; i++)
+    {
+      gdouble x = ink.x + ((i & 1) ? ink.width  : 0);
+      gdouble y = ink.y + ((i & 2) ? ink.height : 0);
+
+      cairo_matrix_transform_point (&matrix, &x, &y);
+
+      x1 = MIN (x1, x);
+      y1 = MIN (y1, y);
+      x2 = MAX (x2, x);
+      y2 = MAX (y2, y);
+    }
+
+  /*  the ink extents are rounded outwards to whole pixels, so they
+   *  include antialiased edges, but they come from the hinted glyph
+   *  metrics, which the rasterized glyphs can exceed by up to a pixel
+   */
+  margin = 1;
+
+  /*  the outline is stroked in image space with twice outline_width,
+   *  centered on the glyph outlines, so it reaches outline_width
+   *  beyond them, up to miter_limit times that at miter joins, and
+   *  sqrt(2) times that at the corners of square dash caps
+   */
+  if (layout->text->outline != GIMP_TEXT_OUTLINE_NONE)
+    {
+      gdouble reach = G_SQRT2;
+
+      if (layout->text->outline_join_style == GIMP_JOIN_MITER)
+        reach = MAX (reach, layout->text->outline_miter_limit);
+
+      margin += ceil (layout->text->outline_width * reach);
+    }
+
+  rect.x      = floor (x1) + layout->extents.x - margin;
+  rect.y      = floor (y1) + layout->extents.y - margin;
+  rect.width  = ceil (x2) - floor (x1) + 2 * margin;
+  rect.height = ceil (y2) - floor (y1) + 2 * margin;
+
+  cairo_region_union_rectangle (region, &rect);
+}
+
 static gboolean
 gimp_text_layout_split_markup (const gchar  *markup,
                                gchar       **open_tag,
@@ -744,15 +1043,27 @@ gimp_text_get_pango_context (GimpText *text,
   PangoFontMap         *fontmap;
   cairo_font_options_t *options;
 
-  fontmap = pango_cairo_font_map_new_for_font_type (CAIRO_FONT_TYPE_FT);
+  if (! font_maps)
+    font_maps = g_hash_table_new_full (g_double_hash, g_double_equal,
+                                       g_free, g_object_unref);
+
+  fontmap = g_hash_table_lookup (font_maps, &yres);
+
   if (! fontmap)
-    g_error ("You are using a Pango that has been built against a cairo "
-             "that lacks the Freetype font backend");
+    {
+      fontmap = pango_cairo_font_map_new_for_font_type (CAIRO_FONT_TYPE_FT);
+      if (! fontmap)
+        g_error ("You are using a Pango that has been built against a cairo "
+                 "that lacks the Freetype font backend");
+
+      pango_cairo_font_map_set_resolution (PANGO_CAIRO_FONT_MAP (fontmap),
+                                           yres);
 
-  pango_cairo_font_map_set_resolution (PANGO_CAIRO_FONT_MAP (fontmap), yres);
+      g_hash_table_insert (font_maps, g_memdup2 (&yres, sizeof (gdouble)),
+                           fontmap);
+    }
 
   context = pango_font_map_create_context (fontmap);
-  g_object_unref (fontmap);
 
   options = gimp_text_get_font_options (text);
   pango_cairo_context_set_font_options (context, options);
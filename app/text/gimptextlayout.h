@@ -75,5 +75,10 @@ void             gimp_text_layout_untransform_distance (GimpTextLayout *layout,
                                                         gdouble        *x,
                                                         gdouble        *y);
 
+cairo_region_t * gimp_text_layout_get_dirty_region     (GimpTextLayout *layout,
+                                                        GimpTextLayout *old_layout);
+
+void             gimp_text_layout_reset_font_maps      (void);
+
 
 #endif /* __GIMP_TEXT_LAYOUT_H__ */
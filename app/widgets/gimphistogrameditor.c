@@ -28,7 +28,7 @@
 #include "core/gimp.h"
 #include "core/gimpasync.h"
 #include "core/gimpdrawable.h"
-#include "core/gimpdrawable-histogram.h"
+#include "core/gimpdrawablehistogram.h"
 #include "core/gimphistogram.h"
 #include "core/gimpimage.h"
 
@@ -241,6 +241,8 @@ gimp_histogram_editor_finalize (GObject *object)
   if (GIMP_HISTOGRAM_EDITOR (object)->idle_id)
     g_source_remove (GIMP_HISTOGRAM_EDITOR (object)->idle_id);
 
+  g_clear_object (&GIMP_HISTOGRAM_EDITOR (object)->drawable_histogram);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -260,6 +262,7 @@ gimp_histogram_editor_set_property (GObject      *object,
 
       if (editor->histogram)
         {
+          g_clear_object (&editor->drawable_histogram);
           g_clear_object (&editor->histogram);
           gimp_histogram_view_set_histogram (view, NULL);
         }
@@ -359,6 +362,7 @@ gimp_histogram_editor_set_image (GimpImageEditor *image_editor,
 
       if (editor->histogram)
         {
+          g_clear_object (&editor->drawable_histogram);
           g_clear_object (&editor->histogram);
           gimp_histogram_view_set_histogram (view, NULL);
         }
@@ -404,6 +408,7 @@ gimp_histogram_editor_layer_changed (GimpImage           *image,
 
       if (editor->histogram)
         {
+          g_clear_object (&editor->drawable_histogram);
           g_clear_object (&editor->histogram);
           gimp_histogram_view_set_histogram (view, NULL);
         }
@@ -539,9 +544,26 @@ gimp_histogram_editor_validate (GimpHistogramEditor *editor)
               gimp_histogram_view_set_histogram (view, editor->histogram);
             }
 
-          async = gimp_drawable_calculate_histogram_async (editor->drawable,
-                                                           editor->histogram,
-                                                           TRUE);
+          /*  keep the histogram up to date incrementally, so that only
+           *  the tiles touched since the last update are recalculated
+           */
+          if (editor->drawable_histogram &&
+              gimp_drawable_histogram_get_drawable (
+                editor->drawable_histogram) != editor->drawable)
+            {
+              g_clear_object (&editor->drawable_histogram);
+            }
+
+          if (! editor->drawable_histogram)
+            {
+              editor->drawable_histogram =
+                gimp_drawable_histogram_new (editor->drawable,
+                                             editor->histogram,
+                                             TRUE);
+            }
+
+          async = gimp_drawable_histogram_calculate_async (
+            editor->drawable_histogram);
 
           editor->calculate_async = async;
 
@@ -47,6 +47,7 @@ struct _GimpSaveDialogState
 {
   gchar    *filter_name;
   gboolean  compression;
+  gboolean  mipmaps;
 };
 
 
@@ -61,6 +62,9 @@ static void     gimp_save_dialog_add_extra_widgets (GimpSaveDialog      *dialog)
 static void     gimp_save_dialog_compression_toggled
                                                    (GtkToggleButton     *button,
                                                     GimpSaveDialog      *dialog);
+static void     gimp_save_dialog_mipmaps_toggled   (GtkToggleButton     *button,
+                                                    GimpSaveDialog      *dialog);
+static void     gimp_save_dialog_update_compat     (GimpSaveDialog      *dialog);
 
 static GimpSaveDialogState
               * gimp_save_dialog_get_state         (GimpSaveDialog      *dialog);
@@ -250,9 +254,9 @@ gimp_save_dialog_set_image (GimpSaveDialog *dialog,
   else
     ext_file = g_file_new_for_uri ("file:///we/only/care/about/extension.xcf");
 
-  gimp_image_get_xcf_version (image, FALSE, &rle_version,
+  gimp_image_get_xcf_version (image, FALSE, FALSE, &rle_version,
                               &version_string, NULL);
-  gimp_image_get_xcf_version (image, TRUE,  &zlib_version,
+  gimp_image_get_xcf_version (image, TRUE,  FALSE, &zlib_version,
                               NULL, NULL);
   if (rle_version != zlib_version)
     {
@@ -281,6 +285,10 @@ gimp_save_dialog_set_image (GimpSaveDialog *dialog,
    */
   gtk_toggle_button_toggled (GTK_TOGGLE_BUTTON (compression_toggle));
 
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (dialog->mipmaps_toggle),
+                                gimp_image_get_xcf_mipmaps (image));
+  gtk_toggle_button_toggled (GTK_TOGGLE_BUTTON (dialog->mipmaps_toggle));
+
   if (ext_file)
     {
       GFile *tmp_file = gimp_file_with_new_extension (name_file, ext_file);
@@ -335,6 +343,20 @@ gimp_save_dialog_add_extra_widgets (GimpSaveDialog *dialog)
                                      FALSE, FALSE, 0);
   gtk_widget_show (dialog->compression_frame);
 
+  /* Mipmaps toggle. */
+  dialog->mipmaps_toggle =
+    gtk_check_button_new_with_mnemonic (_("Save _mipmap levels for faster "
+                                          "opening of large images"));
+  gtk_widget_set_tooltip_text (dialog->mipmaps_toggle,
+                               _("Stores downscaled copies of all layers, "
+                                 "so that the image can be shown zoomed "
+                                 "out before it is fully loaded; this makes "
+                                 "the file about a third bigger"));
+  gimp_file_dialog_add_extra_widget (GIMP_FILE_DIALOG (dialog),
+                                     dialog->mipmaps_toggle,
+                                     FALSE, FALSE, 0);
+  gtk_widget_show (dialog->mipmaps_toggle);
+
   /* Additional information explaining file compatibility things */
   dialog->compat_info = gtk_expander_new (NULL);
   label = gtk_label_new ("");
@@ -356,11 +378,37 @@ gimp_save_dialog_add_extra_widgets (GimpSaveDialog *dialog)
   g_signal_connect (compression_toggle, "toggled",
                     G_CALLBACK (gimp_save_dialog_compression_toggled),
                     dialog);
+  g_signal_connect (dialog->mipmaps_toggle, "toggled",
+                    G_CALLBACK (gimp_save_dialog_mipmaps_toggled),
+                    dialog);
 }
 
 static void
 gimp_save_dialog_compression_toggled (GtkToggleButton *button,
                                       GimpSaveDialog  *dialog)
+{
+  if (! GIMP_FILE_DIALOG (dialog)->image)
+    return;
+
+  dialog->compression = gtk_toggle_button_get_active (button);
+
+  gimp_save_dialog_update_compat (dialog);
+}
+
+static void
+gimp_save_dialog_mipmaps_toggled (GtkToggleButton *button,
+                                  GimpSaveDialog  *dialog)
+{
+  if (! GIMP_FILE_DIALOG (dialog)->image)
+    return;
+
+  dialog->mipmaps = gtk_toggle_button_get_active (button);
+
+  gimp_save_dialog_update_compat (dialog);
+}
+
+static void
+gimp_save_dialog_update_compat (GimpSaveDialog *dialog)
 {
   const gchar    *version_string = NULL;
   GimpFileDialog *file_dialog    = GIMP_FILE_DIALOG (dialog);
@@ -370,17 +418,9 @@ gimp_save_dialog_compression_toggled (GtkToggleButton *button,
   GtkTextBuffer  *text_buffer;
   gint            version;
 
-  if (! file_dialog->image)
-    return;
-
-  dialog->compression = gtk_toggle_button_get_active (button);
-
-  if (dialog->compression)
-    gimp_image_get_xcf_version (file_dialog->image, TRUE,  &version,
-                                &version_string, &reason);
-  else
-    gimp_image_get_xcf_version (file_dialog->image, FALSE, &version,
-                                &version_string, &reason);
+  gimp_image_get_xcf_version (file_dialog->image,
+                              dialog->compression, dialog->mipmaps,
+                              &version, &version_string, &reason);
 
   /* Only show compatibility information for GIMP over 2.6. The reason
    * is mostly that we don't have details to make a compatibility list
@@ -436,6 +476,7 @@ gimp_save_dialog_get_state (GimpSaveDialog *dialog)
     state->filter_name = g_strdup (gtk_file_filter_get_name (filter));
 
   state->compression = dialog->compression;
+  state->mipmaps     = dialog->mipmaps;
 
   return state;
 }
@@ -467,6 +508,7 @@ gimp_save_dialog_set_state (GimpSaveDialog      *dialog,
     }
 
   dialog->compression = state->compression;
+  dialog->mipmaps     = state->mipmaps;
 }
 
 static void
@@ -44,8 +44,10 @@ struct _GimpSaveDialog
   GimpObject          *display_to_close;
 
   GtkWidget           *compression_frame;
+  GtkWidget           *mipmaps_toggle;
   GtkWidget           *compat_info;
   gboolean             compression;
+  gboolean             mipmaps;
 };
 
 struct _GimpSaveDialogClass
@@ -71,6 +71,7 @@ struct _GimpViewRendererPrivate
   GimpColorTransform *profile_transform;
 
   gboolean            needs_render;
+  gboolean            area_invalidated;
   guint               idle_id;
 };
 
@@ -90,6 +91,16 @@ static void      gimp_view_renderer_real_draw         (GimpViewRenderer   *rende
 static void      gimp_view_renderer_real_render       (GimpViewRenderer   *renderer,
                                                        GtkWidget          *widget);
 
+static void      gimp_view_renderer_invalidate_preview
+                                                      (GimpViewRenderer   *renderer,
+                                                       GimpViewable       *viewable);
+static void      gimp_view_renderer_invalidate_preview_area
+                                                      (GimpViewRenderer   *renderer,
+                                                       gint                x,
+                                                       gint                y,
+                                                       gint                width,
+                                                       gint                height,
+                                                       GimpViewable       *viewable);
 static void      gimp_view_renderer_size_changed      (GimpViewRenderer   *renderer,
                                                        GimpViewable       *viewable);
 static void      gimp_view_renderer_profile_changed   (GimpViewRenderer   *renderer,
@@ -146,6 +157,7 @@ gimp_view_renderer_class_init (GimpViewRendererClass *klass)
   klass->update          = NULL;
   klass->set_context     = gimp_view_renderer_real_set_context;
   klass->invalidate      = gimp_view_renderer_real_invalidate;
+  klass->invalidate_area = NULL;
   klass->draw            = gimp_view_renderer_real_draw;
   klass->render          = gimp_view_renderer_real_render;
 
@@ -337,7 +349,11 @@ gimp_view_renderer_set_viewable (GimpViewRenderer *renderer,
                            renderer);
 
       g_signal_handlers_disconnect_by_func (renderer->viewable,
-                                            G_CALLBACK (gimp_view_renderer_invalidate),
+                                            G_CALLBACK (gimp_view_renderer_invalidate_preview),
+                                            renderer);
+
+      g_signal_handlers_disconnect_by_func (renderer->viewable,
+                                            G_CALLBACK (gimp_view_renderer_invalidate_preview_area),
                                             renderer);
 
       g_signal_handlers_disconnect_by_func (renderer->viewable,
@@ -360,7 +376,12 @@ gimp_view_renderer_set_viewable (GimpViewRenderer *renderer,
 
       g_signal_connect_swapped (renderer->viewable,
                                 "invalidate-preview",
-                                G_CALLBACK (gimp_view_renderer_invalidate),
+                                G_CALLBACK (gimp_view_renderer_invalidate_preview),
+                                renderer);
+
+      g_signal_connect_swapped (renderer->viewable,
+                                "invalidate-preview-area",
+                                G_CALLBACK (gimp_view_renderer_invalidate_preview_area),
                                 renderer);
 
       g_signal_connect_swapped (renderer->viewable,
@@ -822,6 +843,42 @@ gimp_view_renderer_real_render (GimpViewRenderer *renderer,
   gimp_view_renderer_render_icon (renderer, widget, icon_name);
 }
 
+static void
+gimp_view_renderer_invalidate_preview (GimpViewRenderer *renderer,
+                                       GimpViewable     *viewable)
+{
+  /*  the preview was already taken care of by invalidate_area()  */
+  if (renderer->priv->area_invalidated)
+    {
+      renderer->priv->area_invalidated = FALSE;
+
+      return;
+    }
+
+  gimp_view_renderer_invalidate (renderer);
+}
+
+static void
+gimp_view_renderer_invalidate_preview_area (GimpViewRenderer *renderer,
+                                            gint              x,
+                                            gint              y,
+                                            gint              width,
+                                            gint              height,
+                                            GimpViewable     *viewable)
+{
+  GimpViewRendererClass *klass = GIMP_VIEW_RENDERER_GET_CLASS (renderer);
+
+  /*  "invalidate-preview" follows right away, let it do a full
+   *  invalidation unless the renderer can update the area by itself
+   */
+  if (klass->invalidate_area && ! renderer->priv->needs_render)
+    {
+      renderer->priv->area_invalidated =
+        klass->invalidate_area (renderer,
+                                GEGL_RECTANGLE (x, y, width, height));
+    }
+}
+
 static void
 gimp_view_renderer_size_changed (GimpViewRenderer *renderer,
                                  GimpViewable     *viewable)
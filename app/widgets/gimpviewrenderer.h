@@ -80,6 +80,9 @@ struct _GimpViewRendererClass
   void (* set_context) (GimpViewRenderer *renderer,
                         GimpContext      *context);
   void (* invalidate)  (GimpViewRenderer *renderer);
+  gboolean (* invalidate_area)
+                       (GimpViewRenderer    *renderer,
+                        const GeglRectangle *area);
   void (* draw)        (GimpViewRenderer *renderer,
                         GtkWidget        *widget,
                         cairo_t          *cr,
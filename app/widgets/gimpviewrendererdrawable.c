@@ -20,6 +20,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 #include <gtk/gtk.h>
 
@@ -40,29 +42,69 @@
 
 #include "gimpviewrendererdrawable.h"
 
+#include "gimp-priorities.h"
+
+
+/*  the minimal interval between updates of part of the preview, in ms  */
+#define AREA_UPDATE_INTERVAL 100
+
+
+typedef struct
+{
+  gint     src_x;
+  gint     src_y;
+  gint     src_width;
+  gint     src_height;
+  gint     dst_x;
+  gint     dst_y;
+  gint     dst_width;
+  gint     dst_height;
+  gboolean empty;
+} RenderGeometry;
 
 struct _GimpViewRendererDrawablePrivate
 {
-  GimpAsync *render_async;
-  GtkWidget *render_widget;
-  gint       render_buf_x;
-  gint       render_buf_y;
-  gboolean   render_update;
-
-  gint       prev_width;
-  gint       prev_height;
+  GimpAsync      *render_async;
+  GtkWidget      *render_widget;
+  gint            render_buf_x;
+  gint            render_buf_y;
+  gboolean        render_update;
+
+  gint            prev_width;
+  gint            prev_height;
+
+  /*  the last rendered preview, and what it was rendered from, so
+   *  that changes to part of the drawable only need to render that
+   *  part of the preview again
+   */
+  GimpTempBuf    *preview_buf;
+  RenderGeometry  preview_geometry;
+  GtkWidget      *preview_widget;
+
+  cairo_region_t *dirty_region;
+  GimpAsync      *area_async;
+  GeglRectangle   area_rect;
+  guint           area_timeout_id;
 };
 
 
 /*  local function prototypes  */
 
-static void   gimp_view_renderer_drawable_dispose       (GObject                  *object);
+static void     gimp_view_renderer_drawable_dispose         (GObject                  *object);
 
-static void   gimp_view_renderer_drawable_invalidate    (GimpViewRenderer         *renderer);
-static void   gimp_view_renderer_drawable_render        (GimpViewRenderer         *renderer,
-                                                         GtkWidget                *widget);
+static void     gimp_view_renderer_drawable_invalidate      (GimpViewRenderer         *renderer);
+static gboolean gimp_view_renderer_drawable_invalidate_area (GimpViewRenderer         *renderer,
+                                                             const GeglRectangle      *area);
+static void     gimp_view_renderer_drawable_render          (GimpViewRenderer         *renderer,
+                                                             GtkWidget                *widget);
 
-static void   gimp_view_renderer_drawable_cancel_render (GimpViewRendererDrawable *renderdrawable);
+static gboolean gimp_view_renderer_drawable_get_geometry    (GimpViewRendererDrawable *renderdrawable,
+                                                             RenderGeometry           *geometry);
+
+static void     gimp_view_renderer_drawable_cancel_render   (GimpViewRendererDrawable *renderdrawable);
+static void     gimp_view_renderer_drawable_queue_area      (GimpViewRendererDrawable *renderdrawable);
+static gboolean gimp_view_renderer_drawable_render_area     (GimpViewRendererDrawable *renderdrawable);
+static void     gimp_view_renderer_drawable_cancel_area     (GimpViewRendererDrawable *renderdrawable);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpViewRendererDrawable,
@@ -81,10 +123,11 @@ gimp_view_renderer_drawable_class_init (GimpViewRendererDrawableClass *klass)
   GObjectClass          *object_class   = G_OBJECT_CLASS (klass);
   GimpViewRendererClass *renderer_class = GIMP_VIEW_RENDERER_CLASS (klass);
 
-  object_class->dispose      = gimp_view_renderer_drawable_dispose;
+  object_class->dispose           = gimp_view_renderer_drawable_dispose;
 
-  renderer_class->invalidate = gimp_view_renderer_drawable_invalidate;
-  renderer_class->render     = gimp_view_renderer_drawable_render;
+  renderer_class->invalidate      = gimp_view_renderer_drawable_invalidate;
+  renderer_class->invalidate_area = gimp_view_renderer_drawable_invalidate_area;
+  renderer_class->render          = gimp_view_renderer_drawable_render;
 }
 
 static void
@@ -100,6 +143,10 @@ gimp_view_renderer_drawable_dispose (GObject *object)
   GimpViewRendererDrawable *renderdrawable = GIMP_VIEW_RENDERER_DRAWABLE (object);
 
   gimp_view_renderer_drawable_cancel_render (renderdrawable);
+  gimp_view_renderer_drawable_cancel_area (renderdrawable);
+
+  g_clear_pointer (&renderdrawable->priv->preview_buf, gimp_temp_buf_unref);
+  g_clear_weak_pointer (&renderdrawable->priv->preview_widget);
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
@@ -110,10 +157,44 @@ gimp_view_renderer_drawable_invalidate (GimpViewRenderer *renderer)
   GimpViewRendererDrawable *renderdrawable = GIMP_VIEW_RENDERER_DRAWABLE (renderer);
 
   gimp_view_renderer_drawable_cancel_render (renderdrawable);
+  gimp_view_renderer_drawable_cancel_area (renderdrawable);
+
+  g_clear_pointer (&renderdrawable->priv->preview_buf, gimp_temp_buf_unref);
 
   GIMP_VIEW_RENDERER_CLASS (parent_class)->invalidate (renderer);
 }
 
+static gboolean
+gimp_view_renderer_drawable_invalidate_area (GimpViewRenderer    *renderer,
+                                             const GeglRectangle *area)
+{
+  GimpViewRendererDrawable *renderdrawable = GIMP_VIEW_RENDERER_DRAWABLE (renderer);
+  cairo_rectangle_int_t     rect;
+
+  /*  without a preview to update, or a full render in progress, which
+   *  will be followed by an update of the area, render everything
+   */
+  if (! renderdrawable->priv->preview_buf &&
+      ! renderdrawable->priv->render_async)
+    {
+      return FALSE;
+    }
+
+  if (! renderdrawable->priv->dirty_region)
+    renderdrawable->priv->dirty_region = cairo_region_create ();
+
+  rect.x      = area->x;
+  rect.y      = area->y;
+  rect.width  = area->width;
+  rect.height = area->height;
+
+  cairo_region_union_rectangle (renderdrawable->priv->dirty_region, &rect);
+
+  gimp_view_renderer_drawable_queue_area (renderdrawable);
+
+  return TRUE;
+}
+
 static void
 gimp_view_renderer_drawable_render_async_callback (GimpAsync                *async,
                                                    GimpViewRendererDrawable *renderdrawable)
@@ -146,6 +227,17 @@ gimp_view_renderer_drawable_render_async_callback (GimpAsync                *asy
         GIMP_VIEW_BG_CHECKS,
         GIMP_VIEW_BG_CHECKS);
 
+      if (! renderdrawable->priv->preview_geometry.empty)
+        {
+          /*  keep our own copy, the area updates modify it  */
+          renderdrawable->priv->preview_buf = gimp_temp_buf_copy (render_buf);
+
+          g_set_weak_pointer (&renderdrawable->priv->preview_widget, widget);
+
+          /*  the drawable changed while we were rendering  */
+          gimp_view_renderer_drawable_queue_area (renderdrawable);
+        }
+
       if (renderdrawable->priv->render_update)
         gimp_view_renderer_update (renderer);
     }
@@ -163,21 +255,7 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
   GimpImage                *image;
   const gchar              *icon_name;
   GimpAsync                *async;
-  gint                      image_width;
-  gint                      image_height;
-  gint                      view_width;
-  gint                      view_height;
-  gint                      src_x;
-  gint                      src_y;
-  gint                      src_width;
-  gint                      src_height;
-  gint                      dst_x;
-  gint                      dst_y;
-  gint                      dst_width;
-  gint                      dst_height;
-  gdouble                   xres  = 1.0;
-  gdouble                   yres  = 1.0;
-  gboolean                  empty = FALSE;
+  RenderGeometry            geometry;
 
   /* render is already in progress */
   if (renderdrawable->priv->render_async)
@@ -188,6 +266,11 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
   image     = gimp_item_get_image (item);
   icon_name = gimp_viewable_get_icon_name (renderer->viewable);
 
+  /*  whatever changed so far will be part of the new preview  */
+  gimp_view_renderer_drawable_cancel_area (renderdrawable);
+
+  g_clear_pointer (&renderdrawable->priv->preview_buf, gimp_temp_buf_unref);
+
   if (image && ! image->gimp->config->layer_previews)
     {
       renderdrawable->priv->prev_width  = 0;
@@ -198,92 +281,17 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
       return;
     }
 
-  if (image)
-    gimp_image_get_resolution (image, &xres, &yres);
-
-  if (renderer->is_popup)
-    image = NULL;
+  gimp_view_renderer_drawable_get_geometry (renderdrawable, &geometry);
 
-  if (image)
-    {
-      image_width  = gimp_image_get_width  (image);
-      image_height = gimp_image_get_height (image);
-    }
-  else
-    {
-      image_width  = gimp_item_get_width  (item);
-      image_height = gimp_item_get_height (item);
-    }
-
-  gimp_viewable_calc_preview_size (image_width,
-                                   image_height,
-                                   renderer->width,
-                                   renderer->height,
-                                   renderer->dot_for_dot,
-                                   xres,
-                                   yres,
-                                   &view_width,
-                                   &view_height,
-                                   NULL);
-
-  src_x      = 0;
-  src_y      = 0;
-  src_width  = gimp_item_get_width  (item);
-  src_height = gimp_item_get_height (item);
-
-  if (image)
-    {
-      gint offset_x;
-      gint offset_y;
-
-      gimp_item_get_offset (item, &offset_x, &offset_y);
-
-      if (gimp_rectangle_intersect (src_x, src_y,
-                                    src_width, src_height,
-                                    -offset_x, -offset_y,
-                                    image_width, image_height,
-                                    &src_x, &src_y,
-                                    &src_width, &src_height))
-        {
-          offset_x += src_x;
-          offset_y += src_y;
-
-          dst_x      = ROUND (((gdouble) view_width  / image_width)  *
-                              offset_x);
-          dst_y      = ROUND (((gdouble) view_height / image_height) *
-                              offset_y);
-          dst_width  = ROUND (((gdouble) view_width  / image_width)  *
-                              src_width);
-          dst_height = ROUND (((gdouble) view_height / image_height) *
-                              src_height);
-        }
-      else
-        {
-          dst_x      = 0;
-          dst_y      = 0;
-          dst_width  = 1;
-          dst_height = 1;
-
-          empty = TRUE;
-        }
-    }
-  else
-    {
-      dst_x      = (renderer->width  - view_width)  / 2;
-      dst_y      = (renderer->height - view_height) / 2;
-      dst_width  = view_width;
-      dst_height = view_height;
-    }
-
-  dst_width  = MAX (dst_width,  1);
-  dst_height = MAX (dst_height, 1);
-
-  if (! empty)
+  if (! geometry.empty)
     {
       async = gimp_drawable_get_sub_preview_async (drawable,
-                                                   src_x, src_y,
-                                                   src_width, src_height,
-                                                   dst_width, dst_height);
+                                                   geometry.src_x,
+                                                   geometry.src_y,
+                                                   geometry.src_width,
+                                                   geometry.src_height,
+                                                   geometry.dst_width,
+                                                   geometry.dst_height);
     }
   else
     {
@@ -292,7 +300,9 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
 
       async = gimp_async_new ();
 
-      render_buf = gimp_temp_buf_new (dst_width, dst_height, format);
+      render_buf = gimp_temp_buf_new (geometry.dst_width,
+                                      geometry.dst_height,
+                                      format);
       gimp_temp_buf_data_clear (render_buf);
 
       gimp_async_finish_full (async,
@@ -302,11 +312,12 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
 
   if (async)
     {
-      renderdrawable->priv->render_async  = async;
-      renderdrawable->priv->render_widget = g_object_ref (widget);
-      renderdrawable->priv->render_buf_x  = dst_x;
-      renderdrawable->priv->render_buf_y  = dst_y;
-      renderdrawable->priv->render_update = FALSE;
+      renderdrawable->priv->render_async     = async;
+      renderdrawable->priv->render_widget    = g_object_ref (widget);
+      renderdrawable->priv->render_buf_x     = geometry.dst_x;
+      renderdrawable->priv->render_buf_y     = geometry.dst_y;
+      renderdrawable->priv->render_update    = FALSE;
+      renderdrawable->priv->preview_geometry = geometry;
 
       gimp_async_add_callback_for_object (
         async,
@@ -343,6 +354,107 @@ gimp_view_renderer_drawable_render (GimpViewRenderer *renderer,
     }
 }
 
+static gboolean
+gimp_view_renderer_drawable_get_geometry (GimpViewRendererDrawable *renderdrawable,
+                                          RenderGeometry           *geometry)
+{
+  GimpViewRenderer *renderer = GIMP_VIEW_RENDERER (renderdrawable);
+  GimpDrawable     *drawable = GIMP_DRAWABLE (renderer->viewable);
+  GimpItem         *item     = GIMP_ITEM (drawable);
+  GimpImage        *image    = gimp_item_get_image (item);
+  gint              image_width;
+  gint              image_height;
+  gint              view_width;
+  gint              view_height;
+  gdouble           xres     = 1.0;
+  gdouble           yres     = 1.0;
+
+  memset (geometry, 0, sizeof (RenderGeometry));
+
+  if (image)
+    gimp_image_get_resolution (image, &xres, &yres);
+
+  if (renderer->is_popup)
+    image = NULL;
+
+  if (image)
+    {
+      image_width  = gimp_image_get_width  (image);
+      image_height = gimp_image_get_height (image);
+    }
+  else
+    {
+      image_width  = gimp_item_get_width  (item);
+      image_height = gimp_item_get_height (item);
+    }
+
+  gimp_viewable_calc_preview_size (image_width,
+                                   image_height,
+                                   renderer->width,
+                                   renderer->height,
+                                   renderer->dot_for_dot,
+                                   xres,
+                                   yres,
+                                   &view_width,
+                                   &view_height,
+                                   NULL);
+
+  geometry->src_x      = 0;
+  geometry->src_y      = 0;
+  geometry->src_width  = gimp_item_get_width  (item);
+  geometry->src_height = gimp_item_get_height (item);
+
+  if (image)
+    {
+      gint offset_x;
+      gint offset_y;
+
+      gimp_item_get_offset (item, &offset_x, &offset_y);
+
+      if (gimp_rectangle_intersect (geometry->src_x, geometry->src_y,
+                                    geometry->src_width, geometry->src_height,
+                                    -offset_x, -offset_y,
+                                    image_width, image_height,
+                                    &geometry->src_x, &geometry->src_y,
+                                    &geometry->src_width,
+                                    &geometry->src_height))
+        {
+          offset_x += geometry->src_x;
+          offset_y += geometry->src_y;
+
+          geometry->dst_x      = ROUND (((gdouble) view_width  / image_width)  *
+                                        offset_x);
+          geometry->dst_y      = ROUND (((gdouble) view_height / image_height) *
+                                        offset_y);
+          geometry->dst_width  = ROUND (((gdouble) view_width  / image_width)  *
+                                        geometry->src_width);
+          geometry->dst_height = ROUND (((gdouble) view_height / image_height) *
+                                        geometry->src_height);
+        }
+      else
+        {
+          geometry->dst_x      = 0;
+          geometry->dst_y      = 0;
+          geometry->dst_width  = 1;
+          geometry->dst_height = 1;
+
+          geometry->empty = TRUE;
+        }
+    }
+  else
+    {
+      geometry->dst_x      = (renderer->width  - view_width)  / 2;
+      geometry->dst_y      = (renderer->height - view_height) / 2;
+      geometry->dst_width  = view_width;
+      geometry->dst_height = view_height;
+    }
+
+  geometry->dst_width  = MAX (geometry->dst_width,  1);
+  geometry->dst_height = MAX (geometry->dst_height, 1);
+
+  return ! geometry->empty;
+}
+
 static void
 gimp_view_renderer_drawable_cancel_render (GimpViewRendererDrawable *renderdrawable)
 {
@@ -364,3 +476,188 @@ gimp_view_renderer_drawable_cancel_render (GimpViewRendererDrawable *renderdrawa
 
   g_clear_object (&renderdrawable->priv->render_widget);
 }
+
+static void
+gimp_view_renderer_drawable_queue_area (GimpViewRendererDrawable *renderdrawable)
+{
+  /*  changes are accumulated while a render is in progress, and the
+   *  preview is updated at most every AREA_UPDATE_INTERVAL ms
+   */
+  if (renderdrawable->priv->dirty_region     &&
+      renderdrawable->priv->preview_buf      &&
+      ! renderdrawable->priv->render_async   &&
+      ! renderdrawable->priv->area_async     &&
+      ! renderdrawable->priv->area_timeout_id)
+    {
+      renderdrawable->priv->area_timeout_id =
+        g_timeout_add_full (GIMP_PRIORITY_VIEWABLE_IDLE,
+                            AREA_UPDATE_INTERVAL,
+                            (GSourceFunc) gimp_view_renderer_drawable_render_area,
+                            renderdrawable, NULL);
+    }
+}
+
+static void
+gimp_view_renderer_drawable_render_area_async_callback (GimpAsync                *async,
+                                                        GimpViewRendererDrawable *renderdrawable)
+{
+  /* see gimp_view_renderer_drawable_render_async_callback()  */
+  if (gimp_async_is_canceled (async))
+    return;
+
+  renderdrawable->priv->area_async = NULL;
+
+  if (gimp_async_is_finished (async))
+    {
+      GimpViewRenderer *renderer = GIMP_VIEW_RENDERER (renderdrawable);
+      GimpTempBuf      *area_buf = gimp_async_get_result (async);
+      GimpTempBuf      *dest_buf = renderdrawable->priv->preview_buf;
+      GeglRectangle    *rect     = &renderdrawable->priv->area_rect;
+      gint              bpp;
+      gint              src_stride;
+      gint              dest_stride;
+      const guchar     *src;
+      guchar           *dest;
+      gint              y;
+
+      /*  patch the area into the preview  */
+      bpp         = babl_format_get_bytes_per_pixel (
+                      gimp_temp_buf_get_format (dest_buf));
+      src_stride  = gimp_temp_buf_get_width (area_buf) * bpp;
+      dest_stride = gimp_temp_buf_get_width (dest_buf) * bpp;
+
+      src  = gimp_temp_buf_get_data (area_buf);
+      dest = gimp_temp_buf_get_data (dest_buf) +
+             rect->y * dest_stride + rect->x * bpp;
+
+      for (y = 0; y < rect->height; y++)
+        {
+          memcpy (dest, src, rect->width * bpp);
+
+          src  += src_stride;
+          dest += dest_stride;
+        }
+
+      if (renderdrawable->priv->preview_widget)
+        {
+          gimp_view_renderer_render_temp_buf (
+            renderer,
+            renderdrawable->priv->preview_widget,
+            dest_buf,
+            renderdrawable->priv->preview_geometry.dst_x,
+            renderdrawable->priv->preview_geometry.dst_y,
+            -1,
+            GIMP_VIEW_BG_CHECKS,
+            GIMP_VIEW_BG_CHECKS);
+
+          gimp_view_renderer_update (renderer);
+        }
+
+      gimp_view_renderer_drawable_queue_area (renderdrawable);
+    }
+}
+
+static gboolean
+gimp_view_renderer_drawable_render_area (GimpViewRendererDrawable *renderdrawable)
+{
+  GimpViewRenderer      *renderer = GIMP_VIEW_RENDERER (renderdrawable);
+  GimpDrawable          *drawable = GIMP_DRAWABLE (renderer->viewable);
+  RenderGeometry        *preview  = &renderdrawable->priv->preview_geometry;
+  RenderGeometry         geometry;
+  cairo_rectangle_int_t  extents;
+  GimpAsync             *async;
+  gdouble                scale;
+  gint                   scaled_x;
+  gint                   scaled_y;
+  gint                   x1, y1;
+  gint                   x2, y2;
+
+  renderdrawable->priv->area_timeout_id = 0;
+
+  cairo_region_get_extents (renderdrawable->priv->dirty_region, &extents);
+  g_clear_pointer (&renderdrawable->priv->dirty_region, cairo_region_destroy);
+
+  /*  if the preview would be laid out differently now, it needs a full
+   *  render anyway
+   */
+  if (! gimp_view_renderer_drawable_get_geometry (renderdrawable, &geometry) ||
+      memcmp (&geometry, preview, sizeof (RenderGeometry)))
+    {
+      gimp_view_renderer_invalidate (renderer);
+
+      return G_SOURCE_REMOVE;
+    }
+
+  /*  map the changed area to the preview, the same way
+   *  gimp_drawable_get_sub_preview_async() does, plus a pixel for the
+   *  downscaling filter
+   */
+  scale = MIN ((gdouble) preview->dst_width  / (gdouble) preview->src_width,
+               (gdouble) preview->dst_height / (gdouble) preview->src_height);
+
+  scaled_x = RINT ((gdouble) preview->src_x * scale);
+  scaled_y = RINT ((gdouble) preview->src_y * scale);
+
+  x1 = floor (extents.x * scale) - scaled_x - 1;
+  y1 = floor (extents.y * scale) - scaled_y - 1;
+  x2 = ceil ((extents.x + extents.width)  * scale) - scaled_x + 1;
+  y2 = ceil ((extents.y + extents.height) * scale) - scaled_y + 1;
+
+  x1 = CLAMP (x1, 0, preview->dst_width);
+  y1 = CLAMP (y1, 0, preview->dst_height);
+  x2 = CLAMP (x2, 0, preview->dst_width);
+  y2 = CLAMP (y2, 0, preview->dst_height);
+
+  if (x1 >= x2 || y1 >= y2)
+    return G_SOURCE_REMOVE;
+
+  renderdrawable->priv->area_rect = *GEGL_RECTANGLE (x1, y1, x2 - x1, y2 - y1);
+
+  async = gimp_drawable_get_sub_preview_area_async (
+    drawable,
+    preview->src_x,     preview->src_y,
+    preview->src_width, preview->src_height,
+    preview->dst_width, preview->dst_height,
+    &renderdrawable->priv->area_rect);
+
+  if (! async)
+    {
+      gimp_view_renderer_invalidate (renderer);
+
+      return G_SOURCE_REMOVE;
+    }
+
+  renderdrawable->priv->area_async = async;
+
+  gimp_async_add_callback_for_object (
+    async,
+    (GimpAsyncCallback) gimp_view_renderer_drawable_render_area_async_callback,
+    renderdrawable,
+    renderdrawable);
+
+  g_object_unref (async);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_view_renderer_drawable_cancel_area (GimpViewRendererDrawable *renderdrawable)
+{
+  /*  see gimp_view_renderer_drawable_cancel_render()  */
+  if (renderdrawable->priv->area_async)
+    {
+      gimp_cancelable_cancel (
+        GIMP_CANCELABLE (renderdrawable->priv->area_async));
+
+      renderdrawable->priv->area_async = NULL;
+    }
+
+  if (renderdrawable->priv->area_timeout_id)
+    {
+      g_source_remove (renderdrawable->priv->area_timeout_id);
+
+      renderdrawable->priv->area_timeout_id = 0;
+    }
+
+  g_clear_pointer (&renderdrawable->priv->dirty_region, cairo_region_destroy);
+}
@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include <cairo.h>
 #include <gegl.h>
@@ -75,6 +76,7 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-seek.h"
+#include "xcf-tile-handler.h"
 #include "xcf-utils.h"
 
 #include "gimp-log.h"
@@ -86,6 +88,31 @@
 /* #define GIMP_XCF_PATH_DEBUG */
 
 
+/* Per job data for xcf_load_tile_parallel() */
+typedef struct
+{
+  /* Common to all jobs. */
+  GeglBuffer         *buffer;
+  gint                file_version;
+  DecompressTileFunc  decompress;
+
+  /* Job specific. */
+  gint                tile;
+  gint                batch_size;
+
+  /* Compressed data of the batch, tile after tile. */
+  guchar             *in_data;
+  gsize               in_data_size;
+  gint                in_data_len[XCF_TILE_LOAD_BATCH_SIZE];
+
+  /* Temp data to avoid too many allocations. */
+  guchar             *tile_data;
+
+  /* Return data. */
+  gboolean            failed;
+} XcfLoadJobData;
+
+
 static void            xcf_load_add_masks     (GimpImage     *image);
 static gboolean        xcf_load_image_props   (XcfInfo       *info,
                                                GimpImage     *image);
@@ -122,22 +149,39 @@ static GimpLayerMask * xcf_load_layer_mask    (XcfInfo       *info,
                                                GimpImage     *image);
 static gboolean        xcf_load_buffer        (XcfInfo       *info,
                                                GeglBuffer    *buffer);
+static gboolean        xcf_load_buffer_on_demand
+                                              (XcfInfo       *info,
+                                               GeglBuffer    *buffer,
+                                               goffset        offset,
+                                               gboolean      *on_demand);
 static gboolean        xcf_load_level         (XcfInfo       *info,
                                                GeglBuffer    *buffer);
 static gboolean        xcf_load_tile          (XcfInfo       *info,
                                                GeglBuffer    *buffer,
                                                GeglRectangle *tile_rect,
                                                const Babl    *format);
-static gboolean        xcf_load_tile_rle      (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
-                                               const Babl    *format,
-                                               gint           data_length);
-static gboolean        xcf_load_tile_zlib     (XcfInfo       *info,
-                                               GeglBuffer    *buffer,
-                                               GeglRectangle *tile_rect,
-                                               const Babl    *format,
-                                               gint           data_length);
+static gboolean        xcf_load_level_parallel
+                                              (XcfInfo            *info,
+                                               GeglBuffer         *buffer,
+                                               DecompressTileFunc  decompress,
+                                               goffset             first_offset,
+                                               guint               ntiles,
+                                               goffset             max_data_length,
+                                               gint                num_processors);
+static void            xcf_load_tile_parallel (XcfLoadJobData     *job_data,
+                                               GAsyncQueue        *queue);
+static gboolean        xcf_load_tile_compressed
+                                              (XcfInfo            *info,
+                                               GeglBuffer         *buffer,
+                                               GeglRectangle      *tile_rect,
+                                               const Babl         *format,
+                                               gint                data_length,
+                                               DecompressTileFunc  decompress);
+static void            xcf_load_store_tile    (GeglBuffer          *buffer,
+                                               const GeglRectangle *tile_rect,
+                                               const Babl          *format,
+                                               gint                 file_version,
+                                               guchar              *tile_data);
 static GimpParasite  * xcf_load_parasite      (XcfInfo       *info);
 static gboolean        xcf_load_old_paths     (XcfInfo       *info,
                                                GimpImage     *image);
@@ -921,6 +965,8 @@ xcf_load_image (Gimp     *gimp,
   if (info->file)
     gimp_image_set_file (image, info->file);
 
+  gimp_image_set_xcf_mipmaps (image, info->mipmaps);
+
   if (info->tattoo_state > 0)
     gimp_image_set_tattoo_state (image, info->tattoo_state);
 
@@ -1093,7 +1139,8 @@ xcf_load_image_props (XcfInfo   *info,
             if ((compression != COMPRESS_NONE) &&
                 (compression != COMPRESS_RLE) &&
                 (compression != COMPRESS_ZLIB) &&
-                (compression != COMPRESS_FRACTAL))
+                (compression != COMPRESS_FRACTAL) &&
+                (compression != COMPRESS_ZSTD))
               {
                 gimp_message (info->gimp, G_OBJECT (info->progress),
                               GIMP_MESSAGE_ERROR,
@@ -3072,6 +3119,20 @@ xcf_load_buffer (XcfInfo    *info,
       return FALSE;
     }
 
+  /* buffers stored along with their mipmap levels, and all buffers in
+   * lazy mode, are loaded on demand.
+   */
+  if (info->file_version >= 19 || info->lazy)
+    {
+      gboolean on_demand;
+
+      if (! xcf_load_buffer_on_demand (info, buffer, offset, &on_demand))
+        return FALSE;
+
+      if (on_demand)
+        return TRUE;
+    }
+
   /* seek to the level offset */
   if (! xcf_seek_pos (info, offset, NULL))
     return FALSE;
@@ -3086,24 +3147,168 @@ xcf_load_buffer (XcfInfo    *info,
   return TRUE;
 }
 
+/* sets @on_demand to whether the buffer is loaded on demand, in which
+ * case the rest of the buffer's data is skipped, and returns FALSE if
+ * the file is broken.
+ */
+static gboolean
+xcf_load_buffer_on_demand (XcfInfo    *info,
+                           GeglBuffer *buffer,
+                           goffset     offset,
+                           gboolean   *on_demand)
+{
+  XcfTileLevel     levels[XCF_MAX_LEVELS] = {};
+  goffset          level_offsets[XCF_MAX_LEVELS];
+  GeglTileHandler *handler;
+  gint             n_offsets;
+  gint             n_levels;
+  gint             i;
+
+  *on_demand = FALSE;
+
+  /* read in the rest of the level offsets.  files older than version
+   * 19 only store dummy levels after the first one, which are skipped.
+   */
+  level_offsets[0] = offset;
+
+  for (n_offsets = 1;
+       n_offsets < XCF_MAX_LEVELS && info->file_version >= 19;
+       n_offsets++)
+    {
+      if (xcf_read_offset (info, &level_offsets[n_offsets], 1) !=
+          info->bytes_per_offset)
+        {
+          return FALSE;
+        }
+
+      if (level_offsets[n_offsets] == 0)
+        break;
+    }
+
+  /* read in the tile offset tables of all the non-empty levels */
+  for (n_levels = 0; n_levels < n_offsets; n_levels++)
+    {
+      XcfTileLevel *level = &levels[n_levels];
+      gint          width;
+      gint          height;
+      gint          n_tiles;
+      gint          j;
+
+      if (n_levels == 0)
+        {
+          width  = gegl_buffer_get_width  (buffer);
+          height = gegl_buffer_get_height (buffer);
+        }
+      else
+        {
+          width  = (levels[n_levels - 1].width  + 1) / 2;
+          height = (levels[n_levels - 1].height + 1) / 2;
+        }
+
+      if (! xcf_seek_pos (info, level_offsets[n_levels], NULL))
+        break;
+
+      xcf_read_int32 (info, (guint32 *) &level->width,  1);
+      xcf_read_int32 (info, (guint32 *) &level->height, 1);
+
+      if (level->width != width || level->height != height)
+        break;
+
+      n_tiles = ((width  + XCF_TILE_WIDTH  - 1) / XCF_TILE_WIDTH) *
+                ((height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT);
+
+      level->offsets = g_new (goffset, n_tiles + 1);
+
+      /* the whole table is kept in memory, but read in batches */
+      for (j = 0; j < n_tiles + 1; j += XCF_TILE_LOAD_BATCH_SIZE)
+        {
+          gint count = MIN (n_tiles + 1 - j, XCF_TILE_LOAD_BATCH_SIZE);
+
+          if (xcf_read_offset (info, level->offsets + j, count) !=
+              count * info->bytes_per_offset)
+            {
+              break;
+            }
+        }
+
+      if (j < n_tiles + 1)
+        break;
+
+      for (j = 0; j < n_tiles; j++)
+        {
+          if (level->offsets[j] == 0)
+            break;
+        }
+
+      if (j < n_tiles || level->offsets[n_tiles] != 0)
+        break;
+    }
+
+  if (n_levels > 1)
+    info->mipmaps = TRUE;
+
+  /* in lazy mode, any buffer is loaded as far as it is accessed.
+   * otherwise, buffers with mipmap levels are shown from the mipmap
+   * levels while they are loaded in the background.
+   */
+  *on_demand = n_levels > 0 &&
+               (info->lazy || (n_levels > 1 && info->progressive));
+
+  if (*on_demand && ! info->tile_reader && info->file)
+    {
+      info->tile_reader = xcf_tile_reader_new (info->gimp,
+                                               info->file,
+                                               info->file_version,
+                                               info->compression);
+    }
+
+  /* if the file can't be read from while editing, load the buffer
+   * the usual way.
+   */
+  if (! *on_demand || ! info->tile_reader)
+    {
+      for (i = 0; i < XCF_MAX_LEVELS; i++)
+        g_free (levels[i].offsets);
+
+      *on_demand = FALSE;
+
+      return TRUE;
+    }
+
+  /* the handler takes ownership of the offset tables */
+  for (i = n_levels; i < XCF_MAX_LEVELS; i++)
+    g_free (levels[i].offsets);
+
+  handler = xcf_tile_handler_new (info->tile_reader, levels, n_levels);
+
+  xcf_tile_handler_assign (XCF_TILE_HANDLER (handler), buffer,
+                           ! info->lazy);
+
+  g_object_unref (handler);
+
+  return TRUE;
+}
+
 
 static gboolean
 xcf_load_level (XcfInfo    *info,
                 GeglBuffer *buffer)
 {
-  const Babl *format;
-  gint        bpp;
-  goffset     saved_pos;
-  goffset     offset;
-  goffset     offset2;
-  goffset     max_data_length;
-  gint        n_tile_rows;
-  gint        n_tile_cols;
-  guint       ntiles;
-  gint        width;
-  gint        height;
-  gint        i;
-  gint        fail;
+  const Babl         *format;
+  DecompressTileFunc  decompress = NULL;
+  gint                bpp;
+  goffset             saved_pos;
+  goffset             offset;
+  goffset             offset2;
+  goffset             max_data_length;
+  gint                n_tile_rows;
+  gint                n_tile_cols;
+  guint               ntiles;
+  gint                num_processors;
+  gint                width;
+  gint                height;
+  gint                i;
+  gint                fail;
 
   format = gegl_buffer_get_format (buffer);
   bpp    = babl_format_get_bytes_per_pixel (format);
@@ -3134,6 +3339,31 @@ xcf_load_level (XcfInfo    *info,
   n_tile_cols = gimp_gegl_buffer_get_n_tile_cols (buffer, XCF_TILE_WIDTH);
 
   ntiles = n_tile_rows * n_tile_cols;
+
+  switch (info->compression)
+    {
+    case COMPRESS_RLE:
+      decompress = xcf_load_decompress_tile_rle;
+      break;
+    case COMPRESS_ZLIB:
+      decompress = xcf_load_decompress_tile_zlib;
+      break;
+    case COMPRESS_ZSTD:
+      decompress = xcf_load_decompress_tile_zstd;
+      break;
+    default:
+      break;
+    }
+
+  num_processors = GIMP_GEGL_CONFIG (info->gimp->config)->num_processors;
+
+  if (decompress && num_processors > 1 && ntiles > 1)
+    {
+      return xcf_load_level_parallel (info, buffer, decompress,
+                                      offset, ntiles, max_data_length,
+                                      num_processors);
+    }
+
   for (i = 0; i < ntiles; i++)
     {
       GeglRectangle rect;
@@ -3192,13 +3422,10 @@ xcf_load_level (XcfInfo    *info,
             fail = TRUE;
           break;
         case COMPRESS_RLE:
-          if (! xcf_load_tile_rle (info, buffer, &rect, format,
-                                   offset2 - offset))
-            fail = TRUE;
-          break;
         case COMPRESS_ZLIB:
-          if (! xcf_load_tile_zlib (info, buffer, &rect, format,
-                                    offset2 - offset))
+        case COMPRESS_ZSTD:
+          if (! xcf_load_tile_compressed (info, buffer, &rect, format,
+                                          offset2 - offset, decompress))
             fail = TRUE;
           break;
         case COMPRESS_FRACTAL:
@@ -3239,6 +3466,224 @@ xcf_load_level (XcfInfo    *info,
   return TRUE;
 }
 
+/* Reads the compressed data of XCF_TILE_LOAD_BATCH_SIZE tiles at a
+ * time sequentially from the file, and lets a thread pool decompress
+ * them into the buffer while the next batch is being read.
+ */
+static gboolean
+xcf_load_level_parallel (XcfInfo            *info,
+                         GeglBuffer         *buffer,
+                         DecompressTileFunc  decompress,
+                         goffset             first_offset,
+                         guint               ntiles,
+                         goffset             max_data_length,
+                         gint                num_processors)
+{
+  XcfLoadJobData  *jobs;
+  XcfLoadJobData  *job_data;
+  GThreadPool     *pool;
+  GAsyncQueue     *queue;
+  goffset         *offset_table;
+  gint             num_tasks = num_processors * 2;
+  gint             tile_size;
+  gboolean         success   = TRUE;
+  guint            i;
+  gint             j;
+
+  tile_size = XCF_TILE_WIDTH * XCF_TILE_HEIGHT *
+              babl_format_get_bytes_per_pixel (gegl_buffer_get_format (buffer));
+
+  /* read the whole offset table at once.  it is followed by a '0'
+   * terminator, which we read as well to detect trailing garbage.
+   * Do not use g_alloca, the table may be huge, see issue #6138.
+   */
+  offset_table = g_new0 (goffset, ntiles + 1);
+  offset_table[0] = first_offset;
+
+  xcf_read_offset (info, offset_table + 1, ntiles);
+
+  for (i = 0; i < ntiles; i++)
+    {
+      if (offset_table[i] == 0)
+        {
+          gimp_message_literal (info->gimp, G_OBJECT (info->progress),
+                                GIMP_MESSAGE_ERROR,
+                                "not enough tiles found in level");
+          g_free (offset_table);
+          return FALSE;
+        }
+    }
+
+  if (offset_table[ntiles] != 0)
+    {
+      gimp_message (info->gimp, G_OBJECT (info->progress), GIMP_MESSAGE_ERROR,
+                    "encountered garbage after reading level: %" G_GOFFSET_FORMAT,
+                    offset_table[ntiles]);
+      g_free (offset_table);
+      return FALSE;
+    }
+
+  /* jobs which are not being processed by the pool wait in the queue,
+   * so popping from it both gives us an idle job and limits the amount
+   * of compressed data read ahead.
+   */
+  queue = g_async_queue_new ();
+  pool  = g_thread_pool_new ((GFunc) xcf_load_tile_parallel, queue,
+                             num_processors, TRUE, NULL);
+
+  jobs = g_new0 (XcfLoadJobData, num_tasks);
+
+  for (j = 0; j < num_tasks; j++)
+    {
+      jobs[j].buffer       = buffer;
+      jobs[j].file_version = info->file_version;
+      jobs[j].decompress   = decompress;
+      jobs[j].tile_data    = g_malloc (tile_size);
+
+      g_async_queue_push (queue, &jobs[j]);
+    }
+
+  i = 0;
+
+  while (i < ntiles)
+    {
+      gsize in_data_len = 0;
+      gint  k;
+
+      job_data = g_async_queue_pop (queue);
+
+      if (job_data->failed)
+        {
+          success = FALSE;
+          break;
+        }
+
+      job_data->tile       = i;
+      job_data->batch_size = MIN (XCF_TILE_LOAD_BATCH_SIZE, ntiles - i);
+
+      for (k = 0; k < job_data->batch_size; k++, i++)
+        {
+          goffset offset  = offset_table[i];
+          goffset offset2 = offset_table[i + 1];
+          gsize   bytes_read;
+
+          /* if the offset is 0 then we need to read in the maximum
+           * possible allowing for negative compression
+           */
+          if (offset2 == 0)
+            offset2 = offset + max_data_length;
+
+          if (offset2 < offset || offset2 - offset > max_data_length)
+            {
+              gimp_message (info->gimp, G_OBJECT (info->progress),
+                            GIMP_MESSAGE_ERROR,
+                            "invalid tile data length: %" G_GOFFSET_FORMAT,
+                            offset2 - offset);
+              success = FALSE;
+              break;
+            }
+
+          /* tiles are usually contiguous, so this is mostly a no-op */
+          if (info->cp != offset && ! xcf_seek_pos (info, offset, NULL))
+            {
+              success = FALSE;
+              break;
+            }
+
+          if (in_data_len + (offset2 - offset) > job_data->in_data_size)
+            {
+              job_data->in_data_size = in_data_len + (offset2 - offset);
+              job_data->in_data      = g_realloc (job_data->in_data,
+                                                  job_data->in_data_size);
+            }
+
+          /* we have to read directly instead of xcf_read_* because we
+           * may be reading past the end of the file here
+           */
+          bytes_read = 0;
+          g_input_stream_read_all (info->input,
+                                   job_data->in_data + in_data_len,
+                                   offset2 - offset,
+                                   &bytes_read, NULL, NULL);
+          info->cp += bytes_read;
+
+          job_data->in_data_len[k] = bytes_read;
+          in_data_len += bytes_read;
+        }
+
+      if (! success)
+        {
+          g_async_queue_push (queue, job_data);
+          break;
+        }
+
+      GIMP_LOG (XCF, "decompressing tiles %d-%d/%d",
+                job_data->tile + 1, i, ntiles);
+
+      g_thread_pool_push (pool, job_data, NULL);
+    }
+
+  /* wait for all pending jobs */
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  for (j = 0; j < num_tasks; j++)
+    {
+      if (jobs[j].failed)
+        success = FALSE;
+
+      g_free (jobs[j].in_data);
+      g_free (jobs[j].tile_data);
+    }
+
+  g_free (jobs);
+  g_async_queue_unref (queue);
+  g_free (offset_table);
+
+  return success;
+}
+
+static void
+xcf_load_tile_parallel (XcfLoadJobData *job_data,
+                        GAsyncQueue    *queue)
+{
+  const Babl   *format  = gegl_buffer_get_format (job_data->buffer);
+  const guchar *in_data = job_data->in_data;
+  gint          i;
+
+  for (i = 0; i < job_data->batch_size && ! job_data->failed; i++)
+    {
+      GeglRectangle tile_rect;
+      gint          in_data_len = job_data->in_data_len[i];
+
+      /* Workaround for bug #357809, see xcf_load_tile_compressed() */
+      if (in_data_len > 0)
+        {
+          gimp_gegl_buffer_get_tile_rect (job_data->buffer,
+                                          XCF_TILE_WIDTH,
+                                          XCF_TILE_HEIGHT,
+                                          job_data->tile + i,
+                                          &tile_rect);
+
+          if (job_data->decompress (&tile_rect, format,
+                                    in_data, in_data_len,
+                                    job_data->tile_data))
+            {
+              xcf_load_store_tile (job_data->buffer, &tile_rect, format,
+                                   job_data->file_version,
+                                   job_data->tile_data);
+            }
+          else
+            {
+              job_data->failed = TRUE;
+            }
+        }
+
+      in_data += in_data_len;
+    }
+
+  g_async_queue_push (queue, job_data);
+}
+
 static gboolean
 xcf_load_tile (XcfInfo       *info,
                GeglBuffer    *buffer,
@@ -3271,21 +3716,18 @@ xcf_load_tile (XcfInfo       *info,
 }
 
 static gboolean
-xcf_load_tile_rle (XcfInfo       *info,
-                   GeglBuffer    *buffer,
-                   GeglRectangle *tile_rect,
-                   const Babl    *format,
-                   gint           data_length)
+xcf_load_tile_compressed (XcfInfo            *info,
+                          GeglBuffer         *buffer,
+                          GeglRectangle      *tile_rect,
+                          const Babl         *format,
+                          gint                data_length,
+                          DecompressTileFunc  decompress)
 {
   gint    bpp       = babl_format_get_bytes_per_pixel (format);
   gint    tile_size = bpp * tile_rect->width * tile_rect->height;
   guchar *tile_data = g_alloca (tile_size);
-  guchar  nonzero   = FALSE;
   gsize   bytes_read;
-  gint    i;
   guchar *xcfdata;
-  guchar *xcfodata;
-  guchar *xcfdatalimit;
 
   /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
    * this tile (return TRUE without storing data) as if it did not
@@ -3296,7 +3738,7 @@ xcf_load_tile_rle (XcfInfo       *info,
   if (data_length <= 0)
     return TRUE;
 
-  xcfdata = xcfodata = g_alloca (data_length);
+  xcfdata = g_alloca (data_length);
 
   /* we have to read directly instead of xcf_read_* because we may be
    * reading past the end of the file here
@@ -3308,7 +3750,52 @@ xcf_load_tile_rle (XcfInfo       *info,
   if (bytes_read == 0)
     return TRUE;
 
-  xcfdatalimit = &xcfodata[bytes_read - 1];
+  if (! decompress (tile_rect, format, xcfdata, bytes_read, tile_data))
+    return FALSE;
+
+  xcf_load_store_tile (buffer, tile_rect, format, info->file_version,
+                       tile_data);
+
+  return TRUE;
+}
+
+static void
+xcf_load_store_tile (GeglBuffer          *buffer,
+                     const GeglRectangle *tile_rect,
+                     const Babl          *format,
+                     gint                 file_version,
+                     guchar              *tile_data)
+{
+  gint bpp       = babl_format_get_bytes_per_pixel (format);
+  gint tile_size = bpp * tile_rect->width * tile_rect->height;
+
+  if (! xcf_data_is_zero (tile_data, tile_size))
+    {
+      if (file_version >= 12)
+        {
+          gint n_components = babl_format_get_n_components (format);
+
+          xcf_read_from_be (bpp / n_components, tile_data,
+                            tile_size / bpp * n_components);
+        }
+
+      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
+                       GEGL_AUTO_ROWSTRIDE);
+    }
+}
+
+gboolean
+xcf_load_decompress_tile_rle (const GeglRectangle *tile_rect,
+                              const Babl          *format,
+                              const guchar        *xcfdata,
+                              gint                 data_length,
+                              guchar              *tile_data)
+{
+  gint          bpp = babl_format_get_bytes_per_pixel (format);
+  gint          i;
+  const guchar *xcfdatalimit;
+
+  xcfdatalimit = &xcfdata[data_length - 1];
 
   for (i = 0; i < bpp; i++)
     {
@@ -3359,7 +3846,6 @@ xcf_load_tile_rle (XcfInfo       *info,
               while (length-- > 0)
                 {
                   *data = *xcfdata++;
-                  nonzero |= *data;
                   data += bpp;
                 }
             }
@@ -3391,7 +3877,6 @@ xcf_load_tile_rle (XcfInfo       *info,
                 }
 
               val = *xcfdata++;
-              nonzero |= val;
 
               for (j = 0; j < length; j++)
                 {
@@ -3402,62 +3887,24 @@ xcf_load_tile_rle (XcfInfo       *info,
         }
     }
 
-  if (nonzero)
-    {
-      if (info->file_version >= 12)
-        {
-          gint n_components = babl_format_get_n_components (format);
-
-          xcf_read_from_be (bpp / n_components, tile_data,
-                            tile_size / bpp * n_components);
-        }
-
-      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                       GEGL_AUTO_ROWSTRIDE);
-    }
-
   return TRUE;
 
  bogus_rle:
   return FALSE;
 }
 
-static gboolean
-xcf_load_tile_zlib (XcfInfo       *info,
-                    GeglBuffer    *buffer,
-                    GeglRectangle *tile_rect,
-                    const Babl    *format,
-                    gint           data_length)
+gboolean
+xcf_load_decompress_tile_zlib (const GeglRectangle *tile_rect,
+                               const Babl          *format,
+                               const guchar        *xcfdata,
+                               gint                 data_length,
+                               guchar              *tile_data)
 {
   z_stream  strm;
   int       action;
   int       status;
   gint      bpp       = babl_format_get_bytes_per_pixel (format);
   gint      tile_size = bpp * tile_rect->width * tile_rect->height;
-  guchar   *tile_data = g_alloca (tile_size);
-  gsize     bytes_read;
-  guchar   *xcfdata;
-
-  /* Workaround for bug #357809: avoid crashing on g_malloc() and skip
-   * this tile (return TRUE without storing data) as if it did not
-   * contain any data.  It is better than returning FALSE, which would
-   * skip the whole hierarchy while there may still be some valid
-   * tiles in the file.
-   */
-  if (data_length <= 0)
-    return TRUE;
-
-  xcfdata = g_alloca (data_length);
-
-  /* we have to read directly instead of xcf_read_* because we may be
-   * reading past the end of the file here
-   */
-  g_input_stream_read_all (info->input, xcfdata, data_length,
-                           &bytes_read, NULL, NULL);
-  info->cp += bytes_read;
-
-  if (bytes_read == 0)
-    return TRUE;
 
   strm.next_out  = tile_data;
   strm.avail_out = tile_size;
@@ -3465,8 +3912,8 @@ xcf_load_tile_zlib (XcfInfo       *info,
   strm.zalloc    = Z_NULL;
   strm.zfree     = Z_NULL;
   strm.opaque    = Z_NULL;
-  strm.next_in   = xcfdata;
-  strm.avail_in  = bytes_read;
+  strm.next_in   = (Bytef *) xcfdata;
+  strm.avail_in  = data_length;
 
   /* Initialize the stream decompression. */
   status = inflateInit (&strm);
@@ -3503,21 +3950,63 @@ xcf_load_tile_zlib (XcfInfo       *info,
         }
     }
 
-  if (! xcf_data_is_zero (tile_data, tile_size))
+  inflateEnd (&strm);
+
+  return TRUE;
+}
+
+gboolean
+xcf_load_decompress_tile_zstd (const GeglRectangle *tile_rect,
+                               const Babl          *format,
+                               const guchar        *xcfdata,
+                               gint                 data_length,
+                               guchar              *tile_data)
+{
+  /* decompression contexts are reused by each loading thread */
+  static GPrivate  dctx_private = G_PRIVATE_INIT ((GDestroyNotify) ZSTD_freeDCtx);
+  ZSTD_DCtx       *dctx;
+  gsize            frame_size;
+  gsize            size;
+  gint             bpp       = babl_format_get_bytes_per_pixel (format);
+  gint             tile_size = bpp * tile_rect->width * tile_rect->height;
+
+  dctx = g_private_get (&dctx_private);
+
+  if (! dctx)
     {
-      if (info->file_version >= 12)
-        {
-          gint n_components = babl_format_get_n_components (format);
+      dctx = ZSTD_createDCtx ();
 
-          xcf_read_from_be (bpp / n_components, tile_data,
-                            tile_size / bpp * n_components);
-        }
+      if (! dctx)
+        return FALSE;
 
-      gegl_buffer_set (buffer, tile_rect, 0, format, tile_data,
-                       GEGL_AUTO_ROWSTRIDE);
+      g_private_set (&dctx_private, dctx);
     }
 
-  inflateEnd (&strm);
+  /* the data of the last tile of a level may be followed by anything, see
+   * xcf_load_level().
+   */
+  frame_size = ZSTD_findFrameCompressedSize (xcfdata, data_length);
+
+  if (ZSTD_isError (frame_size))
+    {
+      g_printerr ("xcf: tile decompression failed: %s",
+                  ZSTD_getErrorName (frame_size));
+      return FALSE;
+    }
+
+  size = ZSTD_decompressDCtx (dctx, tile_data, tile_size, xcfdata, frame_size);
+
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile decompression failed: %s",
+                  ZSTD_getErrorName (size));
+      return FALSE;
+    }
+  else if (size != tile_size)
+    {
+      g_printerr ("xcf: decompressed tile size doesn't match the expected size.");
+      return FALSE;
+    }
 
   return TRUE;
 }
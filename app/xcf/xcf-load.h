@@ -19,9 +19,25 @@
 #define __XCF_LOAD_H__
 
 
-GimpImage * xcf_load_image (Gimp     *gimp,
-                            XcfInfo  *info,
-                            GError  **error);
+GimpImage * xcf_load_image                (Gimp                *gimp,
+                                           XcfInfo             *info,
+                                           GError             **error);
+
+gboolean    xcf_load_decompress_tile_rle  (const GeglRectangle *tile_rect,
+                                           const Babl          *format,
+                                           const guchar        *xcfdata,
+                                           gint                 data_length,
+                                           guchar              *tile_data);
+gboolean    xcf_load_decompress_tile_zlib (const GeglRectangle *tile_rect,
+                                           const Babl          *format,
+                                           const guchar        *xcfdata,
+                                           gint                 data_length,
+                                           guchar              *tile_data);
+gboolean    xcf_load_decompress_tile_zstd (const GeglRectangle *tile_rect,
+                                           const Babl          *format,
+                                           const guchar        *xcfdata,
+                                           gint                 data_length,
+                                           guchar              *tile_data);
 
 
 #endif  /* __XCF_LOAD_H__ */
@@ -23,6 +23,8 @@
 #define XCF_TILE_HEIGHT                 64
 #define XCF_TILE_MAX_DATA_LENGTH_FACTOR 1.5
 #define XCF_TILE_SAVE_BATCH_SIZE        128
+#define XCF_TILE_LOAD_BATCH_SIZE        128
+#define XCF_MAX_LEVELS                  32
 
 typedef enum
 {
@@ -76,8 +78,9 @@ typedef enum
 {
   COMPRESS_NONE              =  0,
   COMPRESS_RLE               =  1,
-  COMPRESS_ZLIB              =  2,  /* unused */
-  COMPRESS_FRACTAL           =  3   /* unused */
+  COMPRESS_ZLIB              =  2,
+  COMPRESS_FRACTAL           =  3,  /* unused */
+  COMPRESS_ZSTD              =  4
 } XcfCompressionType;
 
 typedef enum
@@ -97,7 +100,14 @@ typedef enum
   XCF_GROUP_ITEM_EXPANDED      = 1
 } XcfGroupItemFlagsType;
 
-typedef struct _XcfInfo  XcfInfo;
+typedef gboolean (* DecompressTileFunc) (const GeglRectangle *tile_rect,
+                                         const Babl          *format,
+                                         const guchar        *in_data,
+                                         gint                 in_data_len,
+                                         guchar              *tile_data);
+
+typedef struct _XcfInfo       XcfInfo;
+typedef struct _XcfTileReader XcfTileReader;
 
 struct _XcfInfo
 {
@@ -129,7 +139,12 @@ struct _XcfInfo
   GimpLayer          *floating_sel;
   goffset             floating_sel_offset;
   XcfCompressionType  compression;
+  gint                compression_level;
   gint                file_version;
+  gboolean            mipmaps;
+  gboolean            lazy;
+  gboolean            progressive;
+  XcfTileReader      *tile_reader;
 };
 
 
@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <zlib.h>
+#include <zstd.h>
 
 #include <cairo.h>
 #include <gegl.h>
@@ -89,7 +90,11 @@ typedef struct
   GeglBuffer       *buffer;
   gint              file_version;
   gint              max_out_data_len;
-  CompressTileFunc  compress;
+  CompressTileFunc  compress;   /* NULL for zstd compression. */
+  gint              zstd_level;
+
+  /* zstd compression context, NULL for other compression types. */
+  ZSTD_CCtx        *zstd_cctx;
 
   /* Job specific. */
   gint              tile;
@@ -139,6 +144,10 @@ static gboolean xcf_save_buffer        (XcfInfo           *info,
                                         GimpImage         *image,
                                         GeglBuffer        *buffer,
                                         GError           **error);
+static GeglBuffer * xcf_save_downscale_buffer
+                                       (GeglBuffer        *buffer,
+                                        gint               width,
+                                        gint               height);
 static gboolean xcf_save_level         (XcfInfo           *info,
                                         GimpImage         *image,
                                         GeglBuffer        *buffer,
@@ -166,6 +175,14 @@ static void     xcf_save_tile_zlib     (GeglRectangle     *tile_rect,
                                         guchar            *zlib_data,
                                         gint               zlib_data_max_len,
                                         gint              *lenptr);
+static void     xcf_save_tile_zstd     (ZSTD_CCtx         *cctx,
+                                        gint               level,
+                                        GeglRectangle     *tile_rect,
+                                        guchar            *tile_data,
+                                        const Babl        *format,
+                                        guchar            *zstd_data,
+                                        gint               zstd_data_max_len,
+                                        gint              *lenptr);
 static gboolean xcf_save_parasite      (XcfInfo           *info,
                                         GimpParasite      *parasite,
                                         GError           **error);
@@ -1770,6 +1787,7 @@ xcf_save_buffer (XcfInfo     *info,
                  GError     **error)
 {
   const Babl *format;
+  GeglBuffer *level_buffer = NULL;
   goffset     saved_pos;
   goffset     offset;
   guint32     width;
@@ -1808,20 +1826,54 @@ xcf_save_buffer (XcfInfo     *info,
       /* seek back to the next slot in the offset table and write the
        * offset of the level
        */
-      xcf_check_error (xcf_seek_pos (info, saved_pos, error), ;);
-      xcf_write_offset_check_error (info, &offset, 1, ;);
+      xcf_check_error (xcf_seek_pos (info, saved_pos, error),
+                       g_clear_object (&level_buffer));
+      xcf_write_offset_check_error (info, &offset, 1,
+                                    g_clear_object (&level_buffer));
 
       /* remember the next slot in the offset table */
       saved_pos = info->cp;
 
       /* seek to the level offset and save the level */
-      xcf_check_error (xcf_seek_pos (info, offset, error), ;);
+      xcf_check_error (xcf_seek_pos (info, offset, error),
+                       g_clear_object (&level_buffer));
 
       if (i == 0)
         {
           /* write out the level. */
           xcf_check_error (xcf_save_level (info, image, buffer, error), ;);
         }
+      else if (info->file_version >= 19)
+        {
+          /* starting with version 19, the levels above the first are
+           * real levels, each one half the size of the previous one,
+           * rounded up.  when mipmaps are disabled, they are written
+           * with an empty tile offset table.
+           */
+          width  = (width  + 1) / 2;
+          height = (height + 1) / 2;
+
+          if (info->mipmaps)
+            {
+              GeglBuffer *prev_buffer = level_buffer;
+
+              level_buffer = xcf_save_downscale_buffer (prev_buffer ?
+                                                        prev_buffer : buffer,
+                                                        width, height);
+
+              g_clear_object (&prev_buffer);
+
+              xcf_check_error (xcf_save_level (info, image, level_buffer,
+                                               error),
+                               g_clear_object (&level_buffer));
+            }
+          else
+            {
+              xcf_write_int32_check_error (info, (guint32 *) &width,  1, ;);
+              xcf_write_int32_check_error (info, (guint32 *) &height, 1, ;);
+              xcf_write_zero_offset_check_error (info, 1, ;);
+            }
+        }
       else
         {
           /* fake an empty level */
@@ -1835,9 +1887,9 @@ xcf_save_buffer (XcfInfo     *info,
            * since there are already 64-bit-offsets XCFs out there in
            * which this field is 32-bit, and since it's not actually
            * being used, we're going to keep this field 32-bit for the
-           * dummy levels, to remain consistent.  if we ever make use
-           * of levels above the first, we should turn this field into
-           * an offset, and bump the xcf version.
+           * dummy levels, to remain consistent.  version 19 files,
+           * which make use of the levels above the first, write a
+           * real offset table instead, see above.
            */
           xcf_write_int32_check_error (info, (guint32 *) &tmp1,   1, ;);
         }
@@ -1846,6 +1898,8 @@ xcf_save_buffer (XcfInfo     *info,
       offset = info->cp;
     }
 
+  g_clear_object (&level_buffer);
+
   /* there is already a '0' at the end of the offset table to indicate
    * the end of the level offsets
    */
@@ -1853,6 +1907,35 @@ xcf_save_buffer (XcfInfo     *info,
   return TRUE;
 }
 
+/* Returns a new buffer of size @width x @height, holding @buffer
+ * downscaled by a factor of 2, using the same box filter GEGL uses for
+ * its own mipmap levels.
+ */
+static GeglBuffer *
+xcf_save_downscale_buffer (GeglBuffer *buffer,
+                           gint        width,
+                           gint        height)
+{
+  const Babl         *format = gegl_buffer_get_format (buffer);
+  GeglBuffer         *level_buffer;
+  GeglBufferIterator *iter;
+
+  level_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, width, height),
+                                  format);
+
+  iter = gegl_buffer_iterator_new (level_buffer, NULL, 0, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      gegl_buffer_get (buffer, &iter->items[0].roi, 0.5, format,
+                       iter->items[0].data,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+    }
+
+  return level_buffer;
+}
+
 static gboolean
 xcf_save_level (XcfInfo     *info,
                 GimpImage   *image,
@@ -1918,8 +2001,9 @@ xcf_save_level (XcfInfo     *info,
   /* 'offset' is where we will write the next tile */
   offset = info->cp;
 
-  if (info->compression == COMPRESS_RLE ||
-      info->compression == COMPRESS_ZLIB)
+  if (info->compression == COMPRESS_RLE  ||
+      info->compression == COMPRESS_ZLIB ||
+      info->compression == COMPRESS_ZSTD)
     {
       /* parallel implementation */
       XcfJobData  *job_data;
@@ -1932,6 +2016,34 @@ xcf_save_level (XcfInfo     *info,
       gint         tile_size = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp;
       gint         out_data_max_size;
       gint         next_tile = 0;
+      ZSTD_CCtx  **zstd_cctxs = NULL;
+
+      /* Create the zstd contexts up front, so that running out of memory
+       * fails the save before any job is started.
+       */
+      if (info->compression == COMPRESS_ZSTD)
+        {
+          zstd_cctxs = g_new0 (ZSTD_CCtx *, num_tasks);
+
+          for (j = 0; j < num_tasks; j++)
+            {
+              zstd_cctxs[j] = ZSTD_createCCtx ();
+
+              if (! zstd_cctxs[j])
+                {
+                  while (j--)
+                    ZSTD_freeCCtx (zstd_cctxs[j]);
+
+                  g_free (zstd_cctxs);
+                  g_free (offset_table);
+
+                  g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_NOMEM,
+                                       _("Failed to create a zstd compression "
+                                         "context"));
+                  return FALSE;
+                }
+            }
+        }
 
       out_data_max_size = tile_size * XCF_TILE_MAX_DATA_LENGTH_FACTOR;
       /* Prepare an additional out_data to quickly switch. */
@@ -1958,8 +2070,12 @@ xcf_save_level (XcfInfo     *info,
           job_data->buffer        = buffer;
           job_data->file_version  = info->file_version;
           job_data->max_out_data_len = out_data_max_size;
-          job_data->compress      = (info->compression == COMPRESS_RLE) ?
-                                      xcf_save_tile_rle : xcf_save_tile_zlib;
+          job_data->compress      = (info->compression == COMPRESS_RLE)  ?
+                                      xcf_save_tile_rle  :
+                                    (info->compression == COMPRESS_ZLIB) ?
+                                      xcf_save_tile_zlib : NULL;
+          job_data->zstd_level    = info->compression_level;
+          job_data->zstd_cctx     = zstd_cctxs ? zstd_cctxs[j] : NULL;
           job_data->tile_data     = g_malloc (tile_size);
           job_data->out_data      = g_malloc (out_data_max_size * XCF_TILE_SAVE_BATCH_SIZE);
 
@@ -1970,6 +2086,15 @@ xcf_save_level (XcfInfo     *info,
           g_thread_pool_push (pool, job_data, NULL);
         }
 
+      /* any unused contexts, when there are fewer batches than tasks */
+      if (zstd_cctxs)
+        {
+          for (; j < num_tasks; j++)
+            ZSTD_freeCCtx (zstd_cctxs[j]);
+
+          g_free (zstd_cctxs);
+        }
+
       /* Continue pushing tasks and writing tasks as long as we have tiles to
        * process.
        */
@@ -2168,6 +2293,7 @@ xcf_save_tile (XcfInfo        *info,
 static void
 xcf_save_free_job_data (XcfJobData *data)
 {
+  ZSTD_freeCCtx (data->zstd_cctx);
   g_free (data->out_data);
   g_free (data->tile_data);
   g_free (data);
@@ -2218,10 +2344,21 @@ xcf_save_tile_parallel (XcfJobData  *job_data,
                            tile_size / bpp * n_components);
         }
 
-      job_data->compress (&tile_rect, job_data->tile_data, format,
-                          job_data->out_data + job_data->max_out_data_len * i,
-                          job_data->max_out_data_len,
-                          job_data->out_data_len + i);
+      if (job_data->zstd_cctx)
+        {
+          xcf_save_tile_zstd (job_data->zstd_cctx, job_data->zstd_level,
+                              &tile_rect, job_data->tile_data, format,
+                              job_data->out_data + job_data->max_out_data_len * i,
+                              job_data->max_out_data_len,
+                              job_data->out_data_len + i);
+        }
+      else
+        {
+          job_data->compress (&tile_rect, job_data->tile_data, format,
+                              job_data->out_data + job_data->max_out_data_len * i,
+                              job_data->max_out_data_len,
+                              job_data->out_data_len + i);
+        }
     }
 
   g_async_queue_push_sorted (queue, job_data,
@@ -2411,6 +2548,36 @@ xcf_save_tile_zlib (GeglRectangle  *tile_rect,
   deflateEnd (&strm);
 }
 
+static void
+xcf_save_tile_zstd (ZSTD_CCtx      *cctx,
+                    gint            level,
+                    GeglRectangle  *tile_rect,
+                    guchar         *tile_data,
+                    const Babl     *format,
+                    guchar         *zstd_data,
+                    gint            zstd_data_max_len,
+                    gint           *lenptr)
+{
+  gint  bpp       = babl_format_get_bytes_per_pixel (format);
+  gint  tile_size = bpp * tile_rect->width * tile_rect->height;
+  gsize size;
+
+  size = ZSTD_compressCCtx (cctx,
+                            zstd_data, zstd_data_max_len,
+                            tile_data, tile_size,
+                            level);
+
+  if (ZSTD_isError (size))
+    {
+      g_printerr ("xcf: tile compression failed: %s",
+                  ZSTD_getErrorName (size));
+      *lenptr = 0;
+      return;
+    }
+
+  *lenptr = size;
+}
+
 static gboolean
 xcf_save_parasite (XcfInfo       *info,
                    GimpParasite  *parasite,
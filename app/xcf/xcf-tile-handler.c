@@ -0,0 +1,929 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <cairo.h>
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core/core-types.h"
+
+#include "core/gimp.h"
+
+#include "xcf-private.h"
+#include "xcf-load.h"
+#include "xcf-read.h"
+#include "xcf-tile-handler.h"
+
+#include "gimp-intl.h"
+
+
+/* the maximal number of tiles loaded in each idle iteration */
+#define XCF_TILE_HANDLER_IDLE_N_TILES 16
+
+
+struct _XcfTileReader
+{
+  gint                ref_count;
+
+  Gimp               *gimp;
+  GFile              *file;
+  gchar              *file_id;
+
+  GMutex              mutex;
+  GInputStream       *input;
+
+  gint                file_version;
+  XcfCompressionType  compression;
+  DecompressTileFunc  decompress;
+
+  gint                failed;
+};
+
+struct _XcfTileHandlerPrivate
+{
+  XcfTileReader  *reader;
+
+  XcfTileLevel   *levels;
+  gint            n_levels;
+
+  GWeakRef        buffer;
+  const Babl     *format;
+  gint            bpp;
+  gint            tile_width;
+  gint            tile_height;
+
+  GMutex          mutex;
+  cairo_region_t *dirty_region; /* the area of the first level which
+                                 * hasn't been loaded yet
+                                 */
+
+  guint           idle_id;
+};
+
+
+static void       xcf_tile_handler_dispose          (GObject             *object);
+static void       xcf_tile_handler_finalize         (GObject             *object);
+
+static gpointer   xcf_tile_handler_command          (GeglTileSource      *source,
+                                                     GeglTileCommand      command,
+                                                     gint                 x,
+                                                     gint                 y,
+                                                     gint                 z,
+                                                     gpointer             data);
+
+static gboolean   xcf_tile_reader_read_tile         (XcfTileReader       *reader,
+                                                     const XcfTileLevel  *level,
+                                                     gint                 tile,
+                                                     const GeglRectangle *tile_rect,
+                                                     const Babl          *format,
+                                                     guchar              *tile_data);
+static gboolean   xcf_tile_reader_report_failure    (XcfTileReader       *reader);
+static gboolean   xcf_tile_reader_matches_file      (XcfTileReader       *reader,
+                                                     GFile               *file,
+                                                     const gchar         *file_id);
+
+static void       xcf_tile_handler_read_rect        (XcfTileHandler      *handler,
+                                                     gint                 z,
+                                                     const GeglRectangle *rect,
+                                                     guchar              *data,
+                                                     gint                 stride);
+static GeglTile * xcf_tile_handler_load_tile        (XcfTileHandler      *handler,
+                                                     gint                 x,
+                                                     gint                 y,
+                                                     const GeglRectangle *rect,
+                                                     gboolean             whole);
+static GeglTile * xcf_tile_handler_load_level_tile  (XcfTileHandler      *handler,
+                                                     gint                 x,
+                                                     gint                 y,
+                                                     gint                 z);
+
+static void       xcf_tile_handler_loaded           (XcfTileHandler      *handler,
+                                                     const GeglRectangle *rect);
+
+static void       xcf_tile_handler_buffer_changed   (GeglBuffer          *buffer,
+                                                     const GeglRectangle *rect,
+                                                     XcfTileHandler      *handler);
+static gboolean   xcf_tile_handler_idle             (XcfTileHandler      *handler);
+static void       xcf_tile_handler_unassign         (XcfTileHandler      *handler,
+                                                     GeglBuffer          *buffer);
+
+static gchar    * xcf_tile_handler_get_file_id      (GFile               *file);
+
+
+G_DEFINE_TYPE_WITH_PRIVATE (XcfTileHandler, xcf_tile_handler,
+                            GEGL_TYPE_TILE_HANDLER)
+
+#define parent_class xcf_tile_handler_parent_class
+
+
+/*  the handlers which are still assigned to a buffer  */
+static GMutex  pending_handlers_mutex;
+static GList  *pending_handlers = NULL;
+
+
+static void
+xcf_tile_handler_class_init (XcfTileHandlerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose  = xcf_tile_handler_dispose;
+  object_class->finalize = xcf_tile_handler_finalize;
+}
+
+static void
+xcf_tile_handler_init (XcfTileHandler *handler)
+{
+  GeglTileSource *source = GEGL_TILE_SOURCE (handler);
+
+  handler->priv = xcf_tile_handler_get_instance_private (handler);
+
+  source->command = xcf_tile_handler_command;
+
+  g_mutex_init (&handler->priv->mutex);
+  g_weak_ref_init (&handler->priv->buffer, NULL);
+}
+
+static void
+xcf_tile_handler_dispose (GObject *object)
+{
+  /*  the buffer may be dropped without the handler being unassigned;
+   *  removing it here, rather than on finalize, lets
+   *  xcf_tile_handler_load_pending() safely ref it under the lock
+   */
+  g_mutex_lock (&pending_handlers_mutex);
+  pending_handlers = g_list_remove (pending_handlers, object);
+  g_mutex_unlock (&pending_handlers_mutex);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+xcf_tile_handler_finalize (GObject *object)
+{
+  XcfTileHandler        *handler = XCF_TILE_HANDLER (object);
+  XcfTileHandlerPrivate *priv    = handler->priv;
+  gint                   i;
+
+  g_clear_pointer (&priv->reader,       xcf_tile_reader_unref);
+  g_clear_pointer (&priv->dirty_region, cairo_region_destroy);
+
+  for (i = 0; i < priv->n_levels; i++)
+    g_free (priv->levels[i].offsets);
+
+  g_clear_pointer (&priv->levels, g_free);
+
+  g_weak_ref_clear (&priv->buffer);
+  g_mutex_clear (&priv->mutex);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gpointer
+xcf_tile_handler_command (GeglTileSource  *source,
+                          GeglTileCommand  command,
+                          gint             x,
+                          gint             y,
+                          gint             z,
+                          gpointer         data)
+{
+  if (command == GEGL_TILE_GET)
+    {
+      XcfTileHandler        *handler = XCF_TILE_HANDLER (source);
+      XcfTileHandlerPrivate *priv    = handler->priv;
+      GeglTile              *tile    = NULL;
+      GeglRectangle          tile_rect;
+      GeglRectangle          rect;
+      cairo_region_overlap_t overlap;
+
+      /*  the area covered by the tile on the first level  */
+      tile_rect.x      = x * priv->tile_width  * (1 << z);
+      tile_rect.y      = y * priv->tile_height * (1 << z);
+      tile_rect.width  = priv->tile_width      * (1 << z);
+      tile_rect.height = priv->tile_height     * (1 << z);
+
+      if (z >= priv->n_levels ||
+          ! gegl_rectangle_intersect (&rect,
+                                      &tile_rect,
+                                      GEGL_RECTANGLE (0, 0,
+                                                      priv->levels[0].width,
+                                                      priv->levels[0].height)))
+        {
+          return gegl_tile_handler_source_command (source,
+                                                   command, x, y, z, data);
+        }
+
+      g_mutex_lock (&priv->mutex);
+
+      overlap = cairo_region_contains_rectangle (
+        priv->dirty_region, (cairo_rectangle_int_t *) &rect);
+
+      if (z == 0)
+        {
+          if (overlap != CAIRO_REGION_OVERLAP_OUT)
+            {
+              tile = xcf_tile_handler_load_tile (
+                handler, x, y, &rect, overlap == CAIRO_REGION_OVERLAP_IN);
+            }
+        }
+      else if (overlap == CAIRO_REGION_OVERLAP_IN &&
+               ! gegl_tile_handler_source_command (source, GEGL_TILE_EXIST,
+                                                   x, y, z, NULL))
+        {
+          /*  none of the tile's area has been loaded yet, so the
+           *  corresponding level stored in the file matches what the
+           *  buffer would have rendered
+           */
+          tile = xcf_tile_handler_load_level_tile (handler, x, y, z);
+        }
+
+      g_mutex_unlock (&priv->mutex);
+
+      if (tile)
+        return tile;
+    }
+
+  return gegl_tile_handler_source_command (source, command, x, y, z, data);
+}
+
+static gboolean
+xcf_tile_reader_read_tile (XcfTileReader       *reader,
+                           const XcfTileLevel  *level,
+                           gint                 tile,
+                           const GeglRectangle *tile_rect,
+                           const Babl          *format,
+                           guchar              *tile_data)
+{
+  gint      bpp             = babl_format_get_bytes_per_pixel (format);
+  gsize     tile_size       = bpp * tile_rect->width * tile_rect->height;
+  goffset   max_data_length = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp *
+                              XCF_TILE_MAX_DATA_LENGTH_FACTOR;
+  goffset   offset          = level->offsets[tile];
+  goffset   offset2         = level->offsets[tile + 1];
+  guchar   *xcfdata;
+  gsize     bytes_read      = 0;
+  gboolean  success;
+
+  if (! reader->decompress)
+    offset2 = offset + tile_size;
+  else if (offset2 == 0)
+    offset2 = offset + max_data_length;
+
+  if (offset2 <= offset || offset2 - offset > max_data_length)
+    return FALSE;
+
+  xcfdata = g_malloc (offset2 - offset);
+
+  g_mutex_lock (&reader->mutex);
+
+  success = g_seekable_seek (G_SEEKABLE (reader->input), offset, G_SEEK_SET,
+                             NULL, NULL) &&
+            g_input_stream_read_all (reader->input,
+                                     xcfdata, offset2 - offset, &bytes_read,
+                                     NULL, NULL);
+
+  g_mutex_unlock (&reader->mutex);
+
+  if (success)
+    {
+      if (reader->decompress)
+        {
+          success = bytes_read > 0 &&
+                    reader->decompress (tile_rect, format,
+                                        xcfdata, bytes_read, tile_data);
+        }
+      else if (bytes_read == tile_size)
+        {
+          memcpy (tile_data, xcfdata, tile_size);
+        }
+      else
+        {
+          success = FALSE;
+        }
+    }
+
+  g_free (xcfdata);
+
+  if (success && reader->file_version >= 12)
+    {
+      gint n_components = babl_format_get_n_components (format);
+
+      xcf_read_from_be (bpp / n_components, tile_data,
+                        tile_size / bpp * n_components);
+    }
+
+  if (! success && g_atomic_int_compare_and_exchange (&reader->failed, 0, 1))
+    {
+      /*  tiles can be read from any thread, report the first failure
+       *  from the main loop
+       */
+      g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                       (GSourceFunc) xcf_tile_reader_report_failure,
+                       xcf_tile_reader_ref (reader),
+                       (GDestroyNotify) xcf_tile_reader_unref);
+    }
+
+  return success;
+}
+
+static gboolean
+xcf_tile_reader_report_failure (XcfTileReader *reader)
+{
+  gimp_message (reader->gimp, NULL, GIMP_MESSAGE_WARNING,
+                _("Parts of '%s' could not be read from the file and "
+                  "were left empty."),
+                gimp_file_get_utf8_name (reader->file));
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+xcf_tile_reader_matches_file (XcfTileReader *reader,
+                              GFile         *file,
+                              const gchar   *file_id)
+{
+  if (g_file_equal (reader->file, file))
+    return TRUE;
+
+  /*  the same file under a different name  */
+  return reader->file_id && file_id && ! strcmp (reader->file_id, file_id);
+}
+
+static void
+xcf_tile_handler_read_rect (XcfTileHandler      *handler,
+                            gint                 z,
+                            const GeglRectangle *rect,
+                            guchar              *data,
+                            gint                 stride)
+{
+  XcfTileHandlerPrivate *priv  = handler->priv;
+  const XcfTileLevel    *level = &priv->levels[z];
+  guchar                *tile_data;
+  gint                   n_tile_cols;
+  gint                   col;
+  gint                   row;
+
+  n_tile_cols = (level->width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+
+  tile_data = g_malloc (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * priv->bpp);
+
+  for (row = rect->y / XCF_TILE_HEIGHT;
+       row * XCF_TILE_HEIGHT < rect->y + rect->height;
+       row++)
+    {
+      for (col = rect->x / XCF_TILE_WIDTH;
+           col * XCF_TILE_WIDTH < rect->x + rect->width;
+           col++)
+        {
+          GeglRectangle  tile_rect;
+          GeglRectangle  area;
+          const guchar  *src;
+          guchar        *dest;
+          gint           y;
+
+          tile_rect.x      = col * XCF_TILE_WIDTH;
+          tile_rect.y      = row * XCF_TILE_HEIGHT;
+          tile_rect.width  = MIN (XCF_TILE_WIDTH,
+                                  level->width  - tile_rect.x);
+          tile_rect.height = MIN (XCF_TILE_HEIGHT,
+                                  level->height - tile_rect.y);
+
+          if (! gegl_rectangle_intersect (&area, &tile_rect, rect))
+            continue;
+
+          if (! xcf_tile_reader_read_tile (priv->reader, level,
+                                           row * n_tile_cols + col,
+                                           &tile_rect, priv->format,
+                                           tile_data))
+            {
+              memset (tile_data,
+                      0, tile_rect.width * tile_rect.height * priv->bpp);
+            }
+
+          src  = tile_data +
+                 ((area.y - tile_rect.y) * tile_rect.width +
+                  (area.x - tile_rect.x)) * priv->bpp;
+          dest = data                           +
+                 (area.y - rect->y) * stride    +
+                 (area.x - rect->x) * priv->bpp;
+
+          for (y = 0; y < area.height; y++)
+            {
+              memcpy (dest, src, area.width * priv->bpp);
+
+              src  += tile_rect.width * priv->bpp;
+              dest += stride;
+            }
+        }
+    }
+
+  g_free (tile_data);
+}
+
+static GeglTile *
+xcf_tile_handler_load_tile (XcfTileHandler      *handler,
+                            gint                 x,
+                            gint                 y,
+                            const GeglRectangle *rect,
+                            gboolean             whole)
+{
+  XcfTileHandlerPrivate *priv        = handler->priv;
+  GeglTileSource        *source      = GEGL_TILE_SOURCE (handler);
+  gint                   tile_stride = priv->bpp * priv->tile_width;
+  GeglTile              *tile;
+  guchar                *tile_data;
+  cairo_region_t        *tile_region;
+  gint                   n_rects;
+  gint                   i;
+
+  tile_region = cairo_region_copy (priv->dirty_region);
+  cairo_region_intersect_rectangle (tile_region,
+                                    (cairo_rectangle_int_t *) rect);
+
+  xcf_tile_handler_loaded (handler, rect);
+
+  if (whole)
+    {
+      tile = gegl_tile_handler_get_source_tile (GEGL_TILE_HANDLER (handler),
+                                                x, y, 0, FALSE);
+
+      gegl_tile_lock (tile);
+
+      /*  clear the part of edge tiles outside the buffer  */
+      if (rect->width  < priv->tile_width ||
+          rect->height < priv->tile_height)
+        {
+          memset (gegl_tile_get_data (tile),
+                  0, tile_stride * priv->tile_height);
+        }
+    }
+  else
+    {
+      tile = gegl_tile_handler_source_command (source,
+                                               GEGL_TILE_GET, x, y, 0, NULL);
+
+      if (! tile)
+        {
+          tile = gegl_tile_handler_create_tile (GEGL_TILE_HANDLER (handler),
+                                                x, y, 0);
+
+          memset (gegl_tile_get_data (tile),
+                  0, tile_stride * priv->tile_height);
+        }
+
+      gegl_tile_lock (tile);
+    }
+
+  tile_data = gegl_tile_get_data (tile);
+
+  n_rects = cairo_region_num_rectangles (tile_region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t blit_rect;
+
+      cairo_region_get_rectangle (tile_region, i, &blit_rect);
+
+      xcf_tile_handler_read_rect (
+        handler, 0,
+        (const GeglRectangle *) &blit_rect,
+        tile_data                                          +
+        (blit_rect.y - y * priv->tile_height) * tile_stride +
+        (blit_rect.x - x * priv->tile_width)  * priv->bpp,
+        tile_stride);
+    }
+
+  gegl_tile_unlock (tile);
+
+  cairo_region_destroy (tile_region);
+
+  return tile;
+}
+
+static GeglTile *
+xcf_tile_handler_load_level_tile (XcfTileHandler *handler,
+                                  gint            x,
+                                  gint            y,
+                                  gint            z)
+{
+  XcfTileHandlerPrivate *priv        = handler->priv;
+  const XcfTileLevel    *level       = &priv->levels[z];
+  gint                   tile_stride = priv->bpp * priv->tile_width;
+  GeglTile              *tile;
+  GeglRectangle          rect;
+
+  if (! gegl_rectangle_intersect (&rect,
+                                  GEGL_RECTANGLE (x * priv->tile_width,
+                                                  y * priv->tile_height,
+                                                  priv->tile_width,
+                                                  priv->tile_height),
+                                  GEGL_RECTANGLE (0, 0,
+                                                  level->width,
+                                                  level->height)))
+    {
+      return NULL;
+    }
+
+  tile = gegl_tile_handler_get_source_tile (GEGL_TILE_HANDLER (handler),
+                                            x, y, z, FALSE);
+
+  gegl_tile_lock (tile);
+
+  if (rect.width  < priv->tile_width ||
+      rect.height < priv->tile_height)
+    {
+      memset (gegl_tile_get_data (tile),
+              0, tile_stride * priv->tile_height);
+    }
+
+  xcf_tile_handler_read_rect (handler, z, &rect,
+                              gegl_tile_get_data (tile),
+                              tile_stride);
+
+  gegl_tile_unlock (tile);
+
+  return tile;
+}
+
+/*  called with the mutex held  */
+static void
+xcf_tile_handler_loaded (XcfTileHandler      *handler,
+                         const GeglRectangle *rect)
+{
+  XcfTileHandlerPrivate *priv = handler->priv;
+
+  cairo_region_subtract_rectangle (priv->dirty_region,
+                                   (const cairo_rectangle_int_t *) rect);
+
+  /*  when not loading in the background, the handler is removed from an
+   *  idle as soon as there is nothing left to load, which can't be done
+   *  from within the tile command
+   */
+  if (! priv->idle_id && cairo_region_is_empty (priv->dirty_region))
+    {
+      priv->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                       (GSourceFunc) xcf_tile_handler_idle,
+                                       g_object_ref (handler),
+                                       (GDestroyNotify) g_object_unref);
+    }
+}
+
+static void
+xcf_tile_handler_buffer_changed (GeglBuffer          *buffer,
+                                 const GeglRectangle *rect,
+                                 XcfTileHandler      *handler)
+{
+  XcfTileHandlerPrivate *priv = handler->priv;
+
+  /*  whatever was written to the buffer replaces the file's contents  */
+  g_mutex_lock (&priv->mutex);
+
+  xcf_tile_handler_loaded (handler, rect);
+
+  g_mutex_unlock (&priv->mutex);
+}
+
+static gboolean
+xcf_tile_handler_idle (XcfTileHandler *handler)
+{
+  XcfTileHandlerPrivate *priv = handler->priv;
+  GeglBuffer            *buffer;
+  cairo_rectangle_int_t  rect = {};
+  gboolean               done;
+
+  buffer = g_weak_ref_get (&priv->buffer);
+
+  if (! buffer)
+    return G_SOURCE_REMOVE;
+
+  g_mutex_lock (&priv->mutex);
+
+  done = cairo_region_is_empty (priv->dirty_region);
+
+  if (! done)
+    {
+      cairo_region_get_rectangle (priv->dirty_region, 0, &rect);
+
+      /*  load a single row of tiles at a time, to keep the iteration short  */
+      rect.width  = MIN (rect.width,
+                         priv->tile_width * XCF_TILE_HANDLER_IDLE_N_TILES -
+                         rect.x % priv->tile_width);
+      rect.height = MIN (rect.height,
+                         priv->tile_height - rect.y % priv->tile_height);
+    }
+
+  g_mutex_unlock (&priv->mutex);
+
+  if (! done)
+    {
+      GeglBufferIterator *iter;
+
+      /*  reading the area is enough for the tiles to be loaded  */
+      iter = gegl_buffer_iterator_new (buffer,
+                                       (const GeglRectangle *) &rect, 0,
+                                       priv->format,
+                                       GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+      while (gegl_buffer_iterator_next (iter));
+    }
+  else
+    {
+      xcf_tile_handler_unassign (handler, buffer);
+    }
+
+  g_object_unref (buffer);
+
+  return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+static void
+xcf_tile_handler_unassign (XcfTileHandler *handler,
+                           GeglBuffer     *buffer)
+{
+  XcfTileHandlerPrivate *priv = handler->priv;
+
+  g_mutex_lock (&pending_handlers_mutex);
+  pending_handlers = g_list_remove (pending_handlers, handler);
+  g_mutex_unlock (&pending_handlers_mutex);
+
+  g_signal_handlers_disconnect_by_func (buffer,
+                                        xcf_tile_handler_buffer_changed,
+                                        handler);
+
+  g_weak_ref_set (&priv->buffer, NULL);
+
+  /*  the handler is only kept alive by the idle source from now on  */
+  gegl_buffer_remove_handler (buffer, handler);
+
+  /*  close the file as soon as all of its buffers are loaded  */
+  g_clear_pointer (&priv->reader, xcf_tile_reader_unref);
+}
+
+static gchar *
+xcf_tile_handler_get_file_id (GFile *file)
+{
+  GFileInfo *info;
+  gchar     *file_id = NULL;
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_ID_FILE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+  if (info)
+    {
+      file_id = g_strdup (g_file_info_get_attribute_string (
+                            info, G_FILE_ATTRIBUTE_ID_FILE));
+
+      g_object_unref (info);
+    }
+
+  return file_id;
+}
+
+
+/*  public functions  */
+
+XcfTileReader *
+xcf_tile_reader_new (Gimp               *gimp,
+                     GFile              *file,
+                     gint                file_version,
+                     XcfCompressionType  compression)
+{
+  XcfTileReader      *reader;
+  GInputStream       *input;
+  DecompressTileFunc  decompress;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  switch (compression)
+    {
+    case COMPRESS_NONE:
+      decompress = NULL;
+      break;
+
+    case COMPRESS_RLE:
+      decompress = xcf_load_decompress_tile_rle;
+      break;
+
+    case COMPRESS_ZLIB:
+      decompress = xcf_load_decompress_tile_zlib;
+      break;
+
+    case COMPRESS_ZSTD:
+      decompress = xcf_load_decompress_tile_zstd;
+      break;
+
+    default:
+      return NULL;
+    }
+
+  input = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
+
+  if (! input)
+    return NULL;
+
+  if (! g_seekable_can_seek (G_SEEKABLE (input)))
+    {
+      g_object_unref (input);
+
+      return NULL;
+    }
+
+  reader = g_slice_new0 (XcfTileReader);
+
+  reader->ref_count    = 1;
+  reader->gimp         = gimp;
+  reader->file         = g_object_ref (file);
+  reader->file_id      = xcf_tile_handler_get_file_id (file);
+  reader->input        = input;
+  reader->file_version = file_version;
+  reader->compression  = compression;
+  reader->decompress   = decompress;
+
+  g_mutex_init (&reader->mutex);
+
+  return reader;
+}
+
+XcfTileReader *
+xcf_tile_reader_ref (XcfTileReader *reader)
+{
+  g_return_val_if_fail (reader != NULL, NULL);
+
+  g_atomic_int_inc (&reader->ref_count);
+
+  return reader;
+}
+
+void
+xcf_tile_reader_unref (XcfTileReader *reader)
+{
+  g_return_if_fail (reader != NULL);
+
+  if (g_atomic_int_dec_and_test (&reader->ref_count))
+    {
+      g_object_unref (reader->input);
+      g_object_unref (reader->file);
+      g_free (reader->file_id);
+
+      g_mutex_clear (&reader->mutex);
+
+      g_slice_free (XcfTileReader, reader);
+    }
+}
+
+GeglTileHandler *
+xcf_tile_handler_new (XcfTileReader *reader,
+                      XcfTileLevel  *levels,
+                      gint           n_levels)
+{
+  XcfTileHandler *handler;
+
+  g_return_val_if_fail (reader != NULL, NULL);
+  g_return_val_if_fail (levels != NULL, NULL);
+  g_return_val_if_fail (n_levels > 0, NULL);
+
+  handler = g_object_new (XCF_TYPE_TILE_HANDLER, NULL);
+
+  handler->priv->reader   = xcf_tile_reader_ref (reader);
+  handler->priv->levels   = g_memdup2 (levels, n_levels * sizeof (XcfTileLevel));
+  handler->priv->n_levels = n_levels;
+
+  return GEGL_TILE_HANDLER (handler);
+}
+
+void
+xcf_tile_handler_assign (XcfTileHandler *handler,
+                         GeglBuffer     *buffer,
+                         gboolean        load_in_background)
+{
+  XcfTileHandlerPrivate *priv;
+
+  g_return_if_fail (XCF_IS_TILE_HANDLER (handler));
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  priv = handler->priv;
+
+  g_return_if_fail (priv->dirty_region == NULL);
+
+  g_object_get (buffer,
+                "format",      &priv->format,
+                "tile-width",  &priv->tile_width,
+                "tile-height", &priv->tile_height,
+                NULL);
+
+  priv->bpp = babl_format_get_bytes_per_pixel (priv->format);
+
+  priv->dirty_region = cairo_region_create_rectangle (
+    &(cairo_rectangle_int_t) { .width  = priv->levels[0].width,
+                               .height = priv->levels[0].height });
+
+  g_weak_ref_set (&priv->buffer, buffer);
+
+  gegl_buffer_add_handler (buffer, handler);
+
+  g_mutex_lock (&pending_handlers_mutex);
+  pending_handlers = g_list_prepend (pending_handlers, handler);
+  g_mutex_unlock (&pending_handlers_mutex);
+
+  gegl_buffer_signal_connect (buffer, "changed",
+                              G_CALLBACK (xcf_tile_handler_buffer_changed),
+                              handler);
+
+  /*  load the rest of the buffer in the background  */
+  if (load_in_background)
+    {
+      priv->idle_id = g_idle_add_full (G_PRIORITY_LOW,
+                                       (GSourceFunc) xcf_tile_handler_idle,
+                                       g_object_ref (handler),
+                                       (GDestroyNotify) g_object_unref);
+    }
+}
+
+void
+xcf_tile_handler_load_pending (GFile *file)
+{
+  GList *handlers = NULL;
+  GList *iter;
+  gchar *file_id;
+
+  g_return_if_fail (G_IS_FILE (file));
+
+  if (! g_file_query_exists (file, NULL))
+    return;
+
+  file_id = xcf_tile_handler_get_file_id (file);
+
+  g_mutex_lock (&pending_handlers_mutex);
+
+  for (iter = pending_handlers; iter; iter = g_list_next (iter))
+    {
+      XcfTileHandler *handler = iter->data;
+
+      if (handler->priv->reader &&
+          xcf_tile_reader_matches_file (handler->priv->reader, file, file_id))
+        {
+          handlers = g_list_prepend (handlers, g_object_ref (handler));
+        }
+    }
+
+  g_mutex_unlock (&pending_handlers_mutex);
+
+  g_free (file_id);
+
+  for (iter = handlers; iter; iter = g_list_next (iter))
+    {
+      XcfTileHandler        *handler = iter->data;
+      XcfTileHandlerPrivate *priv    = handler->priv;
+      GeglBuffer            *buffer;
+      cairo_rectangle_int_t  rect;
+
+      buffer = g_weak_ref_get (&priv->buffer);
+
+      if (! buffer)
+        continue;
+
+      g_mutex_lock (&priv->mutex);
+
+      cairo_region_get_extents (priv->dirty_region, &rect);
+
+      g_mutex_unlock (&priv->mutex);
+
+      if (rect.width > 0 && rect.height > 0)
+        {
+          GeglBufferIterator *buffer_iter;
+
+          /*  reading the area is enough for the tiles to be loaded  */
+          buffer_iter = gegl_buffer_iterator_new (
+            buffer, (const GeglRectangle *) &rect, 0, priv->format,
+            GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+
+          while (gegl_buffer_iterator_next (buffer_iter));
+        }
+
+      xcf_tile_handler_unassign (handler, buffer);
+
+      g_object_unref (buffer);
+    }
+
+  g_list_free_full (handlers, g_object_unref);
+}
@@ -0,0 +1,96 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __XCF_TILE_HANDLER_H__
+#define __XCF_TILE_HANDLER_H__
+
+
+#include <gegl-buffer-backend.h>
+
+
+/***
+ * XcfTileHandler is a GeglTileHandler which loads the tiles of a
+ * drawable's buffer from an XCF file when they are first accessed.
+ * As long as an area of the buffer is not loaded, its mipmap tiles
+ * are read from the mipmap levels stored in the file, so that the
+ * buffer can be rendered zoomed-out right away.  The handler removes
+ * itself from the buffer, and closes the file, once the whole buffer
+ * has been loaded or overwritten.
+ *
+ * Before a file is written to, xcf_tile_handler_load_pending() must
+ * be called, so that the buffers still reading from it are fully
+ * loaded first.
+ */
+
+#define XCF_TYPE_TILE_HANDLER            (xcf_tile_handler_get_type ())
+#define XCF_TILE_HANDLER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), XCF_TYPE_TILE_HANDLER, XcfTileHandler))
+#define XCF_TILE_HANDLER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  XCF_TYPE_TILE_HANDLER, XcfTileHandlerClass))
+#define XCF_IS_TILE_HANDLER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), XCF_TYPE_TILE_HANDLER))
+#define XCF_IS_TILE_HANDLER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  XCF_TYPE_TILE_HANDLER))
+#define XCF_TILE_HANDLER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  XCF_TYPE_TILE_HANDLER, XcfTileHandlerClass))
+
+
+typedef struct _XcfTileLevel          XcfTileLevel;
+typedef struct _XcfTileHandler        XcfTileHandler;
+typedef struct _XcfTileHandlerClass   XcfTileHandlerClass;
+typedef struct _XcfTileHandlerPrivate XcfTileHandlerPrivate;
+
+struct _XcfTileLevel
+{
+  gint     width;
+  gint     height;
+  goffset *offsets;  /* the level's tile offset table, including the
+                      * terminating 0
+                      */
+};
+
+struct _XcfTileHandler
+{
+  GeglTileHandler        parent_instance;
+
+  XcfTileHandlerPrivate *priv;
+};
+
+struct _XcfTileHandlerClass
+{
+  GeglTileHandlerClass  parent_class;
+};
+
+
+XcfTileReader   * xcf_tile_reader_new       (Gimp               *gimp,
+                                             GFile              *file,
+                                             gint                file_version,
+                                             XcfCompressionType  compression);
+XcfTileReader   * xcf_tile_reader_ref       (XcfTileReader      *reader);
+void              xcf_tile_reader_unref     (XcfTileReader      *reader);
+
+
+GType             xcf_tile_handler_get_type (void) G_GNUC_CONST;
+
+GeglTileHandler * xcf_tile_handler_new      (XcfTileReader      *reader,
+                                             XcfTileLevel       *levels,
+                                             gint                n_levels);
+
+void              xcf_tile_handler_assign   (XcfTileHandler     *handler,
+                                             GeglBuffer         *buffer,
+                                             gboolean            load_in_background);
+
+void              xcf_tile_handler_load_pending
+                                            (GFile              *file);
+
+
+#endif /* __XCF_TILE_HANDLER_H__ */
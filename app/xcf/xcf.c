@@ -29,6 +29,8 @@
 
 #include "core/core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "core/gimp.h"
 #include "core/gimpimage.h"
 #include "core/gimpdrawable.h"
@@ -43,6 +45,7 @@
 #include "xcf-load.h"
 #include "xcf-read.h"
 #include "xcf-save.h"
+#include "xcf-tile-handler.h"
 
 #include "gimp-intl.h"
 
@@ -87,6 +90,8 @@ static GimpXcfLoaderFunc * const xcf_loaders[] =
   xcf_load_image,   /* version 16 */
   xcf_load_image,   /* version 17 */
   xcf_load_image,   /* version 18 */
+  xcf_load_image,   /* version 19 */
+  xcf_load_image,   /* version 20 */
 };
 
 
@@ -271,6 +276,8 @@ xcf_load_stream (Gimp          *gimp,
   info.progress         = progress;
   info.file             = input_file;
   info.compression      = COMPRESS_NONE;
+  info.lazy             = gimp->config->xcf_lazy_load;
+  info.progressive      = gimp->config->xcf_progressive_load;
 
   if (progress)
     gimp_progress_start (progress, FALSE, _("Opening '%s'"), filename);
@@ -311,6 +318,9 @@ xcf_load_stream (Gimp          *gimp,
             success = FALSE;
 
           g_input_stream_close (info.input, NULL, NULL);
+
+          /* progressively loaded drawables keep their own reference */
+          g_clear_pointer (&info.tile_reader, xcf_tile_reader_unref);
         }
       else
         {
@@ -360,14 +370,26 @@ xcf_save_stream (Gimp           *gimp,
   info.progress         = progress;
   info.file             = output_file;
 
-  if (gimp_image_get_xcf_compression (image))
-    info.compression = COMPRESS_ZLIB;
+  if (! gimp_image_get_xcf_compression (image))
+    {
+      info.compression = COMPRESS_RLE;
+    }
+  else if (gimp->config->xcf_zstd_compression)
+    {
+      info.compression       = COMPRESS_ZSTD;
+      info.compression_level = gimp->config->xcf_zstd_level;
+    }
   else
-    info.compression = COMPRESS_RLE;
+    {
+      info.compression = COMPRESS_ZLIB;
+    }
+
+  info.mipmaps = gimp_image_get_xcf_mipmaps (image);
 
   info.file_version = gimp_image_get_xcf_version (image,
-                                                  info.compression ==
-                                                  COMPRESS_ZLIB,
+                                                  info.compression !=
+                                                  COMPRESS_RLE,
+                                                  info.mipmaps,
                                                   NULL, NULL, NULL);
 
   if (info.file_version >= 11)
@@ -475,6 +497,11 @@ xcf_save_invoker (GimpProcedure         *procedure,
   image = g_value_get_object (gimp_value_array_index (args, 1));
   file  = g_value_get_object (gimp_value_array_index (args, 4));
 
+  /*  buffers which are still being loaded from the file would read
+   *  from it while it's being rewritten
+   */
+  xcf_tile_handler_load_pending (file);
+
   output = G_OUTPUT_STREAM (g_file_replace (file,
                                             NULL, FALSE, G_FILE_CREATE_NONE,
                                             NULL, &my_error));
@@ -63,10 +63,14 @@
 #endif
 
 #include "gimp.h"
+
+#include "libgimpbase/gimpprotocol.h"
+
 #include "gimp-shm.h"
 
 
-#define TILE_MAP_SIZE     (gimp_tile_width () * gimp_tile_height () * 32)
+#define TILE_MAP_SIZE     (gimp_tile_width () * gimp_tile_height () * 32 * \
+                           GP_SHM_N_TILES)
 #define ERRMSG_SHM_FAILED "Could not attach to gimp shared memory segment"
 
 
@@ -84,6 +88,12 @@ _gimp_shm_addr (void)
   return _shm_addr;
 }
 
+gsize
+_gimp_shm_size (void)
+{
+  return TILE_MAP_SIZE;
+}
+
 void
 _gimp_shm_open (gint shm_ID)
 {
@@ -201,3 +211,79 @@ _gimp_shm_close (void)
 
 #endif
 }
+
+/*  Maps a segment of the core's allocated by GP_BUFFER_MAP_REQ,
+ *  returns NULL on failure, the caller falls back to tiles then.
+ */
+guchar *
+_gimp_shm_map (gint         shm_ID,
+               const gchar *shm_name,
+               gsize        size)
+{
+  guchar *addr = NULL;
+
+  if (shm_ID == -1)
+    return NULL;
+
+#if defined(USE_SYSV_SHM)
+
+  addr = (guchar *) shmat (shm_ID, NULL, 0);
+
+  if (addr == (guchar *) -1)
+    {
+      g_printerr ("shmat() failed: %s\n", g_strerror (errno));
+      addr = NULL;
+    }
+
+#elif defined(USE_POSIX_SHM)
+
+  {
+    gint shm_fd;
+
+    if (! shm_name)
+      return NULL;
+
+    shm_fd = shm_open (shm_name, O_RDWR, 0600);
+
+    if (shm_fd != -1)
+      {
+        addr = (guchar *) mmap (NULL, size,
+                                PROT_READ | PROT_WRITE, MAP_SHARED,
+                                shm_fd, 0);
+
+        if (addr == MAP_FAILED)
+          {
+            g_printerr ("mmap() failed: %s\n", g_strerror (errno));
+            addr = NULL;
+          }
+
+        close (shm_fd);
+      }
+    else
+      {
+        g_printerr ("shm_open() failed: %s\n", g_strerror (errno));
+      }
+  }
+
+#endif
+
+  return addr;
+}
+
+void
+_gimp_shm_unmap (guchar *addr,
+                 gsize   size)
+{
+  if (! addr)
+    return;
+
+#if defined(USE_SYSV_SHM)
+
+  shmdt ((char *) addr);
+
+#elif defined(USE_POSIX_SHM)
+
+  munmap (addr, size);
+
+#endif
+}
@@ -0,0 +1,192 @@
+/* LIBGIMP - The GIMP Library
+ * Copyright (C) 1995-1997 Peter Mattis and Spencer Kimball
+ *
+ * gimpbuffermap.c
+ *
+ * This library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gimp.h"
+
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpbase/gimpwire.h"
+
+#include "gimp-shm.h"
+#include "gimpbuffermap.h"
+#include "gimpplugin-private.h"
+
+
+typedef struct _GimpBufferMap GimpBufferMap;
+
+struct _GimpBufferMap
+{
+  gint32         map_id;
+  guchar        *addr;
+  gsize          size;
+  GeglRectangle  extent;
+  GeglRectangle  dirty;  /* the area written to since mapping */
+};
+
+
+static void   gimp_buffer_map_changed (GeglBuffer          *buffer,
+                                       const GeglRectangle *rect,
+                                       GimpBufferMap       *map);
+static void   gimp_buffer_map_destroy (gpointer             data,
+                                       gpointer             user_data);
+
+
+/*  public functions  */
+
+/*  Asks the core to copy the drawable's pixels into a shared memory
+ *  segment once and wraps that as linear buffer, so the plug-in
+ *  accesses them without any further round trips.  Only the area
+ *  that was changed is written back when the buffer is destroyed.
+ *  Returns NULL if the core can't map the drawable.
+ */
+GeglBuffer *
+_gimp_buffer_map_new (GimpDrawable *drawable,
+                      gboolean      shadow)
+{
+  GimpPlugIn      *plug_in = gimp_get_plug_in ();
+  GPBufferMapReq   buffer_map_req;
+  GPBufferMapData *buffer_map_data;
+  GimpWireMessage  msg;
+  GimpBufferMap   *map;
+  GeglBuffer      *buffer;
+  const Babl      *format;
+  GeglRectangle    extent;
+  gint             bpp;
+
+  format = gimp_drawable_get_format (drawable);
+  bpp    = babl_format_get_bytes_per_pixel (format);
+
+  buffer_map_req.drawable_id = gimp_item_get_id (GIMP_ITEM (drawable));
+  buffer_map_req.shadow      = shadow;
+
+  if (! gp_buffer_map_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                 &buffer_map_req, plug_in))
+    gimp_quit ();
+
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_BUFFER_MAP_DATA);
+
+  buffer_map_data = msg.data;
+
+  if (buffer_map_data->drawable_id != buffer_map_req.drawable_id ||
+      buffer_map_data->shadow      != buffer_map_req.shadow)
+    {
+      g_printerr ("received buffer map info did not match requested drawable");
+      gimp_quit ();
+    }
+
+  if (buffer_map_data->map_id == -1)
+    {
+      gimp_wire_destroy (&msg);
+      return NULL;
+    }
+
+  if (buffer_map_data->bpp != bpp)
+    {
+      g_printerr ("received buffer map info did not match drawable format");
+      gimp_quit ();
+    }
+
+  map = g_slice_new0 (GimpBufferMap);
+
+  map->map_id = buffer_map_data->map_id;
+  map->size   = ((gsize) buffer_map_data->width *
+                 buffer_map_data->height * bpp);
+  map->addr   = _gimp_shm_map (buffer_map_data->map_id,
+                               buffer_map_data->map_name,
+                               map->size);
+
+  gegl_rectangle_set (&extent,
+                      0, 0,
+                      buffer_map_data->width, buffer_map_data->height);
+
+  map->extent = extent;
+
+  gimp_wire_destroy (&msg);
+
+  if (! map->addr)
+    {
+      GPBufferUnmap buffer_unmap = { map->map_id, 0, 0, 0, 0 };
+
+      /*  let the core release the segment  */
+      if (! gp_buffer_unmap_write (_gimp_plug_in_get_write_channel (plug_in),
+                                   &buffer_unmap, plug_in))
+        gimp_quit ();
+
+      g_slice_free (GimpBufferMap, map);
+
+      return NULL;
+    }
+
+  buffer = gegl_buffer_linear_new_from_data (map->addr, format, &extent,
+                                             extent.width * bpp,
+                                             gimp_buffer_map_destroy, map);
+
+  gegl_buffer_signal_connect (buffer, "changed",
+                              G_CALLBACK (gimp_buffer_map_changed),
+                              map);
+
+  return buffer;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_buffer_map_changed (GeglBuffer          *buffer,
+                         const GeglRectangle *rect,
+                         GimpBufferMap       *map)
+{
+  GeglRectangle area;
+
+  if (! gegl_rectangle_intersect (&area, rect, &map->extent))
+    return;
+
+  if (gegl_rectangle_is_empty (&map->dirty))
+    map->dirty = area;
+  else
+    gegl_rectangle_bounding_box (&map->dirty, &map->dirty, &area);
+}
+
+static void
+gimp_buffer_map_destroy (gpointer data,
+                         gpointer user_data)
+{
+  GimpBufferMap *map     = user_data;
+  GimpPlugIn    *plug_in = gimp_get_plug_in ();
+  GPBufferUnmap  buffer_unmap;
+
+  _gimp_shm_unmap (map->addr, map->size);
+
+  /*  no ack needed, the core handles this before any later message
+   *  which might read the drawable
+   */
+  buffer_unmap.map_id = map->map_id;
+  buffer_unmap.x      = map->dirty.x;
+  buffer_unmap.y      = map->dirty.y;
+  buffer_unmap.width  = map->dirty.width;
+  buffer_unmap.height = map->dirty.height;
+
+  if (! gp_buffer_unmap_write (_gimp_plug_in_get_write_channel (plug_in),
+                               &buffer_unmap, plug_in))
+    gimp_quit ();
+
+  g_slice_free (GimpBufferMap, map);
+}
@@ -22,6 +22,7 @@
 
 #include "gimp.h"
 
+#include "gimpbuffermap.h"
 #include "gimppixbuf.h"
 #include "gimptilebackendplugin.h"
 
@@ -324,6 +325,81 @@ gimp_drawable_get_shadow_buffer (GimpDrawable *drawable)
   return NULL;
 }
 
+/**
+ * gimp_drawable_get_bulk_buffer:
+ * @drawable: the ID of the #GimpDrawable to get the buffer for.
+ *
+ * Returns a #GeglBuffer holding a copy of all of a specified
+ * drawable's pixels, transferred in bulk through memory shared with
+ * the core. Unlike the buffer returned by gimp_drawable_get_buffer(),
+ * which fetches and writes back tiles as they are accessed, this
+ * buffer is filled once, when it is created, and the area changed in
+ * it is written back once, when it gets destroyed.
+ *
+ * This makes it much faster for plug-ins that process the whole
+ * drawable, at the price of keeping a copy of all of it in memory.
+ * Changes to the buffer only reach the drawable when the buffer is
+ * destroyed, gegl_buffer_flush() does not write them back, and
+ * changes the core makes to the drawable meanwhile are not seen.
+ *
+ * If the drawable is too big to be transferred in bulk, or shared
+ * memory is not available, the same buffer as
+ * gimp_drawable_get_buffer() is returned instead.
+ *
+ * Returns: (transfer full): The #GeglBuffer.
+ *
+ * See Also: gimp_drawable_get_bulk_shadow_buffer()
+ *
+ * Since: 3.0
+ */
+GeglBuffer *
+gimp_drawable_get_bulk_buffer (GimpDrawable *drawable)
+{
+  if (gimp_item_is_valid (GIMP_ITEM (drawable)))
+    {
+      GeglBuffer *buffer = _gimp_buffer_map_new (drawable, FALSE);
+
+      if (buffer)
+        return buffer;
+
+      return gimp_drawable_get_buffer (drawable);
+    }
+
+  return NULL;
+}
+
+/**
+ * gimp_drawable_get_bulk_shadow_buffer:
+ * @drawable: the ID of the #GimpDrawable to get the buffer for.
+ *
+ * Returns a #GeglBuffer holding a copy of a specified drawable's
+ * shadow tiles, transferred in bulk like
+ * gimp_drawable_get_bulk_buffer(). The area changed in it is written
+ * back to the shadow tiles when the buffer gets destroyed.
+ *
+ * If the drawable can't be transferred in bulk, the same buffer as
+ * gimp_drawable_get_shadow_buffer() is returned instead.
+ *
+ * Returns: (transfer full): The #GeglBuffer.
+ *
+ * Since: 3.0
+ */
+GeglBuffer *
+gimp_drawable_get_bulk_shadow_buffer (GimpDrawable *drawable)
+{
+  if (gimp_item_is_valid (GIMP_ITEM (drawable)))
+    {
+      GeglBuffer *buffer = _gimp_buffer_map_new (drawable, TRUE);
+
+      if (buffer)
+        return buffer;
+
+      return gimp_drawable_get_shadow_buffer (drawable);
+    }
+
+  return NULL;
+}
+
 /**
  * gimp_drawable_get_format:
  * @drawable: the ID of the #GimpDrawable to get the format for.
@@ -31,6 +31,7 @@
 #include "gimppdb_pdb.h"
 #include "gimppdbprocedure.h"
 #include "gimpplugin-private.h"
+#include "gimptilebackendplugin.h"
 
 #include "libgimp-intl.h"
 
@@ -42,12 +43,23 @@
  */
 
 
+typedef struct
+{
+  gchar              *procedure_name;
+  GimpValueArray     *arguments;
+  GimpPDBRunCallback  callback;
+  gpointer            user_data;
+  GDestroyNotify      destroy;
+} GimpPDBCall;
+
 struct _GimpPDBPrivate
 {
   GimpPlugIn         *plug_in;
 
   GHashTable         *procedures;
 
+  GQueue              pending_calls;
+
   GimpPDBStatusType   error_status;
   gchar              *error_message;
 };
@@ -59,6 +71,13 @@ static void   gimp_pdb_finalize  (GObject        *object);
 static void   gimp_pdb_set_error (GimpPDB        *pdb,
                                   GimpValueArray *return_values);
 
+static GimpValueArray **
+              gimp_pdb_run_batch (GimpPDB               *pdb,
+                                  const gchar          **procedure_names,
+                                  GimpValueArray       **arguments,
+                                  gint                   n_calls);
+static void   gimp_pdb_call_free (GimpPDBCall           *call);
+
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpPDB, gimp_pdb, G_TYPE_OBJECT)
 
@@ -83,6 +102,8 @@ gimp_pdb_init (GimpPDB *pdb)
                                                  g_free, g_object_unref);
 
   pdb->priv->error_status = GIMP_PDB_SUCCESS;
+
+  g_queue_init (&pdb->priv->pending_calls);
 }
 
 static void
@@ -90,6 +111,16 @@ gimp_pdb_dispose (GObject *object)
 {
   GimpPDB *pdb = GIMP_PDB (object);
 
+  if (! g_queue_is_empty (&pdb->priv->pending_calls))
+    {
+      g_warning ("%s: %d asynchronous procedure calls were never run, "
+                 "call gimp_pdb_flush() before quitting",
+                 G_STRFUNC, g_queue_get_length (&pdb->priv->pending_calls));
+
+      g_queue_clear_full (&pdb->priv->pending_calls,
+                          (GDestroyNotify) gimp_pdb_call_free);
+    }
+
   g_clear_pointer (&pdb->priv->procedures, g_hash_table_unref);
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
@@ -335,6 +366,14 @@ gimp_pdb_run_procedure_array (GimpPDB              *pdb,
   g_return_val_if_fail (gimp_is_canonical_identifier (procedure_name), NULL);
   g_return_val_if_fail (arguments != NULL, NULL);
 
+  /*  run pending asynchronous calls first, so calls are always run in
+   *  the order they were made
+   */
+  gimp_pdb_flush (pdb);
+
+  /*  the procedure may change drawables we fetched tiles of  */
+  _gimp_tile_backend_plugin_invalidate_read_ahead ();
+
   proc_run.name     = (gchar *) procedure_name;
   proc_run.n_params = gimp_value_array_length (arguments);
   proc_run.params   = _gimp_value_array_to_gp_params (arguments, FALSE);
@@ -402,6 +441,189 @@ gimp_pdb_run_procedure_config (GimpPDB             *pdb,
   return return_values;
 }
 
+/**
+ * gimp_pdb_run_procedure_batch:
+ * @pdb:                                              the #GimpPDB object.
+ * @procedure_names: (array length=n_calls):          the registered names
+ *                                                    to call.
+ * @arguments: (array length=n_calls):                the arguments of each
+ *                                                    call.
+ * @n_calls:                                          the number of calls.
+ *
+ * Runs the procedures named @procedure_names in order, each with its
+ * @arguments, exactly as if they were run one after the other with
+ * [method@PDB.run_procedure_array].
+ *
+ * Instead of waiting for each call to return before making the next
+ * one, the calls are sent to the core in as few messages as possible,
+ * and their return values are received together, which is much faster
+ * when making a lot of calls.
+ *
+ * The last error and status of @pdb are the ones of the last call.
+ *
+ * Returns: (array length=n_calls) (transfer full): the return values
+ *          of each call.  Free with gimp_value_array_unref() each, and
+ *          g_free() the array.
+ *
+ * Since: 3.0
+ */
+GimpValueArray **
+gimp_pdb_run_procedure_batch (GimpPDB         *pdb,
+                              const gchar    **procedure_names,
+                              GimpValueArray **arguments,
+                              gint             n_calls)
+{
+  GimpValueArray **return_values;
+  gint             i;
+
+  g_return_val_if_fail (GIMP_IS_PDB (pdb), NULL);
+  g_return_val_if_fail (n_calls >= 0, NULL);
+  g_return_val_if_fail (n_calls == 0 || procedure_names != NULL, NULL);
+  g_return_val_if_fail (n_calls == 0 || arguments != NULL, NULL);
+
+  for (i = 0; i < n_calls; i++)
+    {
+      g_return_val_if_fail (gimp_is_canonical_identifier (procedure_names[i]),
+                            NULL);
+      g_return_val_if_fail (arguments[i] != NULL, NULL);
+    }
+
+  gimp_pdb_flush (pdb);
+
+  return_values = g_new (GimpValueArray *, n_calls);
+
+  for (i = 0; i < n_calls; i += GP_PROC_BATCH_MAX_CALLS)
+    {
+      gint              n = MIN (n_calls - i, GP_PROC_BATCH_MAX_CALLS);
+      GimpValueArray  **batch_return_values;
+      gint              j;
+
+      batch_return_values = gimp_pdb_run_batch (pdb,
+                                                procedure_names + i,
+                                                arguments       + i,
+                                                n);
+
+      for (j = 0; j < n; j++)
+        return_values[i + j] = batch_return_values[j];
+
+      g_free (batch_return_values);
+    }
+
+  if (n_calls > 0)
+    gimp_pdb_set_error (pdb, return_values[n_calls - 1]);
+
+  return return_values;
+}
+
+/**
+ * gimp_pdb_run_procedure_async:
+ * @pdb:                         the #GimpPDB object.
+ * @procedure_name:              the registered name to call.
+ * @arguments:                   the call arguments.
+ * @callback: (nullable) (scope notified) (closure user_data):
+ *                               a function to call with the return values.
+ * @user_data:                   user data for @callback.
+ * @destroy: (nullable) (destroy user_data):
+ *                               a function to free @user_data.
+ *
+ * Queues a call of the procedure named @procedure_name with
+ * @arguments, and returns without waiting for it.
+ *
+ * Queued calls are sent to the core together, and run in order, when
+ * enough of them have been queued, when [method@PDB.flush] is called,
+ * or before any synchronous procedure call.  @callback is then called
+ * with their return values, in the same order.  Queued calls are also
+ * run before the plug-in procedure returns.
+ *
+ * Since the calls may run later, anything depending on their effects
+ * which doesn't go through the PDB, such as reading a drawable's
+ * buffer, must be preceded by [method@PDB.flush].
+ *
+ * Since: 3.0
+ */
+void
+gimp_pdb_run_procedure_async (GimpPDB              *pdb,
+                              const gchar          *procedure_name,
+                              const GimpValueArray *arguments,
+                              GimpPDBRunCallback    callback,
+                              gpointer              user_data,
+                              GDestroyNotify        destroy)
+{
+  GimpPDBCall *call;
+
+  g_return_if_fail (GIMP_IS_PDB (pdb));
+  g_return_if_fail (gimp_is_canonical_identifier (procedure_name));
+  g_return_if_fail (arguments != NULL);
+
+  call = g_slice_new (GimpPDBCall);
+
+  call->procedure_name = g_strdup (procedure_name);
+  call->arguments      = gimp_value_array_copy (arguments);
+  call->callback       = callback;
+  call->user_data      = user_data;
+  call->destroy        = destroy;
+
+  g_queue_push_tail (&pdb->priv->pending_calls, call);
+
+  if (g_queue_get_length (&pdb->priv->pending_calls) >= GP_PROC_BATCH_MAX_CALLS)
+    gimp_pdb_flush (pdb);
+}
+
+/**
+ * gimp_pdb_flush:
+ * @pdb: the #GimpPDB object.
+ *
+ * Runs all the calls queued by [method@PDB.run_procedure_async], and
+ * calls their callbacks, before returning.
+ *
+ * Since: 3.0
+ */
+void
+gimp_pdb_flush (GimpPDB *pdb)
+{
+  g_return_if_fail (GIMP_IS_PDB (pdb));
+
+  /*  callbacks may queue more calls, which are run too  */
+  while (! g_queue_is_empty (&pdb->priv->pending_calls))
+    {
+      GimpPDBCall     *calls[GP_PROC_BATCH_MAX_CALLS];
+      const gchar     *procedure_names[GP_PROC_BATCH_MAX_CALLS];
+      GimpValueArray  *arguments[GP_PROC_BATCH_MAX_CALLS];
+      GimpValueArray **return_values;
+      gint             n_calls = 0;
+      gint             i;
+
+      while (n_calls < GP_PROC_BATCH_MAX_CALLS &&
+             ! g_queue_is_empty (&pdb->priv->pending_calls))
+        {
+          GimpPDBCall *call = g_queue_pop_head (&pdb->priv->pending_calls);
+
+          calls[n_calls]           = call;
+          procedure_names[n_calls] = call->procedure_name;
+          arguments[n_calls]       = call->arguments;
+
+          n_calls++;
+        }
+
+      return_values = gimp_pdb_run_batch (pdb,
+                                          procedure_names, arguments,
+                                          n_calls);
+
+      for (i = 0; i < n_calls; i++)
+        {
+          gimp_pdb_set_error (pdb, return_values[i]);
+
+          if (calls[i]->callback)
+            calls[i]->callback (pdb, return_values[i], calls[i]->user_data);
+
+          gimp_value_array_unref (return_values[i]);
+          gimp_pdb_call_free (calls[i]);
+        }
+
+      g_free (return_values);
+    }
+}
+
 /**
  * gimp_pdb_temp_procedure_name:
  * @pdb: the #GimpPDB object.
@@ -701,3 +923,87 @@ gimp_pdb_set_error (GimpPDB        *pdb,
         }
     }
 }
+
+static GimpValueArray **
+gimp_pdb_run_batch (GimpPDB         *pdb,
+                    const gchar    **procedure_names,
+                    GimpValueArray **arguments,
+                    gint             n_calls)
+{
+  GPProcRunBatch     proc_run_batch;
+  GPProcReturnBatch *proc_return_batch;
+  GimpWireMessage    msg;
+  GimpValueArray   **return_values;
+  gint               i;
+
+  /*  the procedures may change drawables we fetched tiles of  */
+  _gimp_tile_backend_plugin_invalidate_read_ahead ();
+
+  proc_run_batch.n_procs = n_calls;
+  proc_run_batch.procs   = g_new (GPProcRun, n_calls);
+
+  for (i = 0; i < n_calls; i++)
+    {
+      GPProcRun *proc_run = &proc_run_batch.procs[i];
+
+      proc_run->name     = (gchar *) procedure_names[i];
+      proc_run->n_params = gimp_value_array_length (arguments[i]);
+      proc_run->params   = _gimp_value_array_to_gp_params (arguments[i],
+                                                           FALSE);
+    }
+
+  if (! gp_proc_run_batch_write (_gimp_plug_in_get_write_channel (pdb->priv->plug_in),
+                                 &proc_run_batch, pdb->priv->plug_in))
+    gimp_quit ();
+
+  for (i = 0; i < n_calls; i++)
+    {
+      _gimp_gp_params_free (proc_run_batch.procs[i].params,
+                            proc_run_batch.procs[i].n_params, FALSE);
+    }
+
+  g_free (proc_run_batch.procs);
+
+  _gimp_plug_in_read_expect_msg (pdb->priv->plug_in, &msg,
+                                 GP_PROC_RETURN_BATCH);
+
+  proc_return_batch = msg.data;
+
+  if (! proc_return_batch || proc_return_batch->n_procs != n_calls)
+    {
+      g_printerr ("%s: received %d return values for %d calls\n",
+                  G_STRFUNC,
+                  proc_return_batch ? proc_return_batch->n_procs : -1,
+                  n_calls);
+      gimp_quit ();
+    }
+
+  return_values = g_new (GimpValueArray *, n_calls);
+
+  for (i = 0; i < n_calls; i++)
+    {
+      GPProcReturn *proc_return = &proc_return_batch->procs[i];
+
+      return_values[i] = _gimp_gp_params_to_value_array (NULL,
+                                                         NULL, 0,
+                                                         proc_return->params,
+                                                         proc_return->n_params,
+                                                         TRUE);
+    }
+
+  gimp_wire_destroy (&msg);
+
+  return return_values;
+}
+
+static void
+gimp_pdb_call_free (GimpPDBCall *call)
+{
+  if (call->destroy)
+    call->destroy (call->user_data);
+
+  g_free (call->procedure_name);
+  gimp_value_array_unref (call->arguments);
+
+  g_slice_free (GimpPDBCall, call);
+}
@@ -39,6 +39,23 @@ G_BEGIN_DECLS
 #define GIMP_PDB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GIMP_TYPE_PDB, GimpPDBClass))
 
 
+/**
+ * GimpPDBRunCallback:
+ * @pdb:           the #GimpPDB object.
+ * @return_values: the return values of the procedure call.
+ * @user_data: (closure): the user_data given in
+ *                        gimp_pdb_run_procedure_async().
+ *
+ * The callback receiving the return values of a procedure call made
+ * with gimp_pdb_run_procedure_async().
+ *
+ * Since: 3.0
+ **/
+typedef void (* GimpPDBRunCallback) (GimpPDB        *pdb,
+                                     GimpValueArray *return_values,
+                                     gpointer        user_data);
+
+
 typedef struct _GimpPDBClass   GimpPDBClass;
 typedef struct _GimpPDBPrivate GimpPDBPrivate;
 
@@ -92,6 +109,19 @@ GimpValueArray * gimp_pdb_run_procedure_config (GimpPDB              *pdb,
                                                 const gchar          *procedure_name,
                                                 GimpProcedureConfig  *config);
 
+GimpValueArray ** gimp_pdb_run_procedure_batch (GimpPDB               *pdb,
+                                                const gchar          **procedure_names,
+                                                GimpValueArray       **arguments,
+                                                gint                   n_calls);
+
+void             gimp_pdb_run_procedure_async  (GimpPDB              *pdb,
+                                                const gchar          *procedure_name,
+                                                const GimpValueArray *arguments,
+                                                GimpPDBRunCallback    callback,
+                                                gpointer              user_data,
+                                                GDestroyNotify        destroy);
+void             gimp_pdb_flush                (GimpPDB              *pdb);
+
 gchar          * gimp_pdb_temp_procedure_name  (GimpPDB              *pdb);
 
 gboolean         gimp_pdb_dump_to_file         (GimpPDB              *pdb,
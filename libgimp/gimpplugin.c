@@ -1223,9 +1223,17 @@ gimp_plug_in_loop (GimpPlugIn *plug_in)
         case GP_TILE_REQ:
         case GP_TILE_ACK:
         case GP_TILE_DATA:
+        case GP_TILE_RANGE_REQ:
+        case GP_TILE_RANGE_DATA:
           g_warning ("unexpected tile message received (should not happen)");
           break;
 
+        case GP_BUFFER_MAP_REQ:
+        case GP_BUFFER_MAP_DATA:
+        case GP_BUFFER_UNMAP:
+          g_warning ("unexpected buffer map message received (should not happen)");
+          break;
+
         case GP_PROC_RUN:
           gimp_plug_in_proc_run (plug_in, msg.data);
           gimp_wire_destroy (&msg);
@@ -1285,8 +1293,15 @@ gimp_plug_in_process_message (GimpPlugIn      *plug_in,
     case GP_TILE_REQ:
     case GP_TILE_ACK:
     case GP_TILE_DATA:
+    case GP_TILE_RANGE_REQ:
+    case GP_TILE_RANGE_DATA:
       g_warning ("unexpected tile message received (should not happen)");
       break;
+    case GP_BUFFER_MAP_REQ:
+    case GP_BUFFER_MAP_DATA:
+    case GP_BUFFER_UNMAP:
+      g_warning ("unexpected buffer map message received (should not happen)");
+      break;
     case GP_PROC_RUN:
       g_warning ("unexpected proc run message received (should not happen)");
       break;
@@ -1389,6 +1404,9 @@ gimp_plug_in_proc_run_internal (GimpPlugIn    *plug_in,
 
   return_values = gimp_procedure_run (procedure, arguments);
 
+  /*  run asynchronous calls the procedure left queued before returning  */
+  gimp_pdb_flush (gimp_get_pdb ());
+
   gimp_value_array_unref (arguments);
 
   proc_return->name     = proc_run->name;
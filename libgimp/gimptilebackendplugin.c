@@ -60,9 +60,27 @@ struct _GimpTileBackendPluginPrivate
   gint     bpp;
   gint     ntile_rows;
   gint     ntile_cols;
+
+  /* tiles fetched ahead of time when reading consecutive tiles */
+  gint     last_read_tile;
+  guint    read_tile_num;
+  guint    read_n_tiles;
+  gint     read_stamp;
+  guchar  *read_data;
+  gsize    read_data_size;
+  gsize    read_offsets[GP_TILE_RANGE_MAX_TILES];
+
+  /* consecutive written tiles, sent to the core in one go */
+  guint    write_tile_num;
+  guint    write_n_tiles;
+  guchar  *write_data;
+  gsize    write_data_size;
+  gsize    write_length;
 };
 
 
+static void       gimp_tile_backend_plugin_finalize (GObject        *object);
+
 static gpointer   gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
                                                     GeglTileCommand  command,
                                                     gint             x,
@@ -86,8 +104,14 @@ static void       gimp_tile_unset (GimpTileBackendPlugin *backend_plugin,
                                    GimpTile              *tile);
 static void       gimp_tile_get   (GimpTileBackendPlugin *backend_plugin,
                                    GimpTile              *tile);
-static void       gimp_tile_put   (GimpTileBackendPlugin *backend_plugin,
-                                   GimpTile              *tile);
+
+static guint      gimp_tile_range_n_tiles   (GimpTileBackendPlugin *backend_plugin,
+                                             guint                  tile_num);
+static void       gimp_tile_get_range       (GimpTileBackendPlugin *backend_plugin,
+                                             guint                  tile_num);
+static guchar   * gimp_tile_read_ahead_data (GimpTileBackendPlugin *backend_plugin,
+                                             guint                  tile_num);
+static void       gimp_tile_flush_writes    (GimpTileBackendPlugin *backend_plugin);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
@@ -98,10 +122,18 @@ G_DEFINE_TYPE_WITH_PRIVATE (GimpTileBackendPlugin, _gimp_tile_backend_plugin,
 
 static GMutex backend_plugin_mutex;
 
+/*  bumped whenever drawables may have changed in the core behind our
+ *  back, which makes all tiles fetched ahead stale
+ */
+static gint   read_ahead_stamp = 0;
+
 
 static void
 _gimp_tile_backend_plugin_class_init (GimpTileBackendPluginClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = gimp_tile_backend_plugin_finalize;
 }
 
 static void
@@ -111,9 +143,28 @@ _gimp_tile_backend_plugin_init (GimpTileBackendPlugin *backend)
 
   backend->priv = _gimp_tile_backend_plugin_get_instance_private (backend);
 
+  backend->priv->last_read_tile = -1;
+
   source->command = gimp_tile_backend_plugin_command;
 }
 
+static void
+gimp_tile_backend_plugin_finalize (GObject *object)
+{
+  GimpTileBackendPlugin *backend_plugin = GIMP_TILE_BACKEND_PLUGIN (object);
+
+  g_mutex_lock (&backend_plugin_mutex);
+
+  gimp_tile_flush_writes (backend_plugin);
+
+  g_mutex_unlock (&backend_plugin_mutex);
+
+  g_clear_pointer (&backend_plugin->priv->read_data,  g_free);
+  g_clear_pointer (&backend_plugin->priv->write_data, g_free);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gpointer
 gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
                                   GeglTileCommand  command,
@@ -156,6 +207,11 @@ gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
       break;
 
     case GEGL_TILE_FLUSH:
+      g_mutex_lock (&backend_plugin_mutex);
+
+      gimp_tile_flush_writes (backend_plugin);
+
+      g_mutex_unlock (&backend_plugin_mutex);
       break;
 
     default:
@@ -170,6 +226,15 @@ gimp_tile_backend_plugin_command (GeglTileSource  *tile_store,
 
 /*  public functions  */
 
+/*  drops the tiles all backends fetched ahead, called before anything
+ *  which may change drawables in the core, like a PDB call
+ */
+void
+_gimp_tile_backend_plugin_invalidate_read_ahead (void)
+{
+  g_atomic_int_inc (&read_ahead_stamp);
+}
+
 GeglTileBackend *
 _gimp_tile_backend_plugin_new (GimpDrawable *drawable,
                                gint          shadow)
@@ -216,19 +281,47 @@ gimp_tile_read (GimpTileBackendPlugin *backend_plugin,
   GimpTile                      gimp_tile = { 0, };
   gint                          tile_size;
   guchar                       *tile_data;
+  const guchar                 *src;
 
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return NULL;
 
+  /*  pending writes of this tile have to reach the core first  */
+  if (priv->write_n_tiles > 0                  &&
+      gimp_tile.tile_num >= priv->write_tile_num &&
+      gimp_tile.tile_num <  priv->write_tile_num + priv->write_n_tiles)
+    {
+      gimp_tile_flush_writes (backend_plugin);
+    }
+
   tile_size  = gegl_tile_backend_get_tile_size (backend);
   tile       = gegl_tile_new (tile_size);
   tile_data  = gegl_tile_get_data (tile);
 
-  gimp_tile_get (backend_plugin, &gimp_tile);
+  src = gimp_tile_read_ahead_data (backend_plugin, gimp_tile.tile_num);
+
+  /*  when tiles are accessed in order, fetch the rest of the tile row
+   *  in one round trip
+   */
+  if (! src && (gint) gimp_tile.tile_num == priv->last_read_tile + 1)
+    {
+      gimp_tile_get_range (backend_plugin, gimp_tile.tile_num);
+
+      src = gimp_tile_read_ahead_data (backend_plugin, gimp_tile.tile_num);
+    }
+
+  if (! src)
+    {
+      gimp_tile_get (backend_plugin, &gimp_tile);
+
+      src = gimp_tile.data;
+    }
+
+  priv->last_read_tile = gimp_tile.tile_num;
 
   if (gimp_tile.ewidth * gimp_tile.eheight * priv->bpp == tile_size)
     {
-      memcpy (tile_data, gimp_tile.data, tile_size);
+      memcpy (tile_data, src, tile_size);
     }
   else
     {
@@ -238,8 +331,8 @@ gimp_tile_read (GimpTileBackendPlugin *backend_plugin,
 
       for (row = 0; row < gimp_tile.eheight; row++)
         {
-          memcpy (tile_data      + row * tile_stride,
-                  gimp_tile.data + row * gimp_tile_stride,
+          memcpy (tile_data + row * tile_stride,
+                  src       + row * gimp_tile_stride,
                   gimp_tile_stride);
         }
     }
@@ -259,7 +352,9 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
   GeglTileBackend              *backend   = GEGL_TILE_BACKEND (backend_plugin);
   GimpTile                      gimp_tile = { 0, };
   gint                          tile_size;
+  gsize                         gimp_tile_size;
   guchar                       *tile_data;
+  guchar                       *dest;
 
   if (! gimp_tile_init (backend_plugin, &gimp_tile, y, x))
     return FALSE;
@@ -267,13 +362,36 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
   tile_size = gegl_tile_backend_get_tile_size (backend);
   tile_data = gegl_tile_get_data (tile);
 
-  gimp_tile.data = g_new (guchar,
-                          gimp_tile.ewidth * gimp_tile.eheight *
-                          priv->bpp);
+  gimp_tile_size = gimp_tile.ewidth * gimp_tile.eheight * priv->bpp;
 
-  if (gimp_tile.ewidth * gimp_tile.eheight * priv->bpp == tile_size)
+  /*  tiles fetched ahead are stale now  */
+  if (gimp_tile_read_ahead_data (backend_plugin, gimp_tile.tile_num))
+    priv->read_n_tiles = 0;
+
+  /*  only consecutive tiles can be sent together  */
+  if (priv->write_n_tiles > 0 &&
+      (gimp_tile.tile_num != priv->write_tile_num + priv->write_n_tiles ||
+       priv->write_n_tiles == GP_TILE_RANGE_MAX_TILES                   ||
+       priv->write_length + gimp_tile_size > _gimp_shm_size ()))
     {
-      memcpy (gimp_tile.data, tile_data, tile_size);
+      gimp_tile_flush_writes (backend_plugin);
+    }
+
+  if (priv->write_n_tiles == 0)
+    priv->write_tile_num = gimp_tile.tile_num;
+
+  if (priv->write_length + gimp_tile_size > priv->write_data_size)
+    {
+      priv->write_data_size = priv->write_length + gimp_tile_size;
+      priv->write_data      = g_realloc (priv->write_data,
+                                         priv->write_data_size);
+    }
+
+  dest = priv->write_data + priv->write_length;
+
+  if (gimp_tile_size == tile_size)
+    {
+      memcpy (dest, tile_data, tile_size);
     }
   else
     {
@@ -283,14 +401,14 @@ gimp_tile_write (GimpTileBackendPlugin *backend_plugin,
 
       for (row = 0; row < gimp_tile.eheight; row++)
         {
-          memcpy (gimp_tile.data + row * gimp_tile_stride,
-                  tile_data      + row * tile_stride,
+          memcpy (dest      + row * gimp_tile_stride,
+                  tile_data + row * tile_stride,
                   gimp_tile_stride);
         }
     }
 
-  gimp_tile_put (backend_plugin, &gimp_tile);
-  gimp_tile_unset (backend_plugin, &gimp_tile);
+  priv->write_n_tiles++;
+  priv->write_length += gimp_tile_size;
 
   return TRUE;
 }
@@ -399,59 +517,213 @@ gimp_tile_get (GimpTileBackendPlugin *backend_plugin,
   gimp_wire_destroy (&msg);
 }
 
+/*  returns how many tiles, starting at tile_num and not going beyond
+ *  the end of its tile row, fit into one tile range
+ */
+static guint
+gimp_tile_range_n_tiles (GimpTileBackendPlugin *backend_plugin,
+                         guint                  tile_num)
+{
+  GimpTileBackendPluginPrivate *priv       = backend_plugin->priv;
+  gint                          row        = tile_num / priv->ntile_cols;
+  gint                          col        = tile_num % priv->ntile_cols;
+  gsize                         max_length = _gimp_shm_size ();
+  gsize                         length     = 0;
+  gint                          n_tiles    = 0;
+
+  while (n_tiles < GP_TILE_RANGE_MAX_TILES &&
+         col + n_tiles < priv->ntile_cols)
+    {
+      GimpTile tile;
+
+      gimp_tile_init (backend_plugin, &tile, row, col + n_tiles);
+
+      length += tile.ewidth * tile.eheight * priv->bpp;
+
+      if (length > max_length)
+        break;
+
+      n_tiles++;
+    }
+
+  return n_tiles;
+}
+
 static void
-gimp_tile_put (GimpTileBackendPlugin *backend_plugin,
-               GimpTile              *tile)
+gimp_tile_get_range (GimpTileBackendPlugin *backend_plugin,
+                     guint                  tile_num)
 {
   GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
   GimpPlugIn                   *plug_in = gimp_get_plug_in ();
-  GPTileReq                     tile_req;
-  GPTileData                    tile_data;
-  GPTileData                   *tile_info;
+  GPTileRangeReq                tile_range_req;
+  GPTileRangeData              *tile_range_data;
   GimpWireMessage               msg;
+  gsize                         offset  = 0;
+  guint                         n_tiles;
+  guint                         i;
 
-  tile_req.drawable_id = -1;
-  tile_req.tile_num    = 0;
-  tile_req.shadow      = 0;
+  priv->read_n_tiles = 0;
 
-  if (! gp_tile_req_write (_gimp_plug_in_get_write_channel (plug_in),
-                           &tile_req, plug_in))
+  n_tiles = gimp_tile_range_n_tiles (backend_plugin, tile_num);
+
+  /*  a single tile is cheaper to get the old way  */
+  if (n_tiles < 2)
+    return;
+
+  tile_range_req.drawable_id = priv->drawable_id;
+  tile_range_req.tile_num    = tile_num;
+  tile_range_req.n_tiles     = n_tiles;
+  tile_range_req.shadow      = priv->shadow;
+
+  if (! gp_tile_range_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                 &tile_range_req, plug_in))
     gimp_quit ();
 
-  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_DATA);
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_RANGE_DATA);
+
+  tile_range_data = msg.data;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GimpTile tile;
+
+      gimp_tile_init (backend_plugin, &tile,
+                      (tile_num + i) / priv->ntile_cols,
+                      (tile_num + i) % priv->ntile_cols);
+
+      priv->read_offsets[i] = offset;
+
+      offset += tile.ewidth * tile.eheight * priv->bpp;
+    }
+
+  if (tile_range_data->drawable_id != priv->drawable_id ||
+      tile_range_data->tile_num    != tile_num          ||
+      tile_range_data->n_tiles     != n_tiles           ||
+      tile_range_data->shadow      != priv->shadow      ||
+      tile_range_data->bpp         != priv->bpp         ||
+      tile_range_data->length      != offset)
+    {
+      g_printerr ("received tile range info did not match computed tile info");
+      gimp_quit ();
+    }
+
+  if (tile_range_data->use_shm)
+    {
+      if (priv->read_data_size < offset)
+        {
+          g_free (priv->read_data);
+
+          priv->read_data      = g_malloc (offset);
+          priv->read_data_size = offset;
+        }
+
+      memcpy (priv->read_data, _gimp_shm_addr (), offset);
+    }
+  else
+    {
+      g_free (priv->read_data);
+
+      priv->read_data      = tile_range_data->data;
+      priv->read_data_size = offset;
+
+      tile_range_data->data = NULL;
+    }
+
+  priv->read_tile_num = tile_num;
+  priv->read_n_tiles  = n_tiles;
+  priv->read_stamp    = g_atomic_int_get (&read_ahead_stamp);
+
+  if (! gp_tile_ack_write (_gimp_plug_in_get_write_channel (plug_in),
+                           plug_in))
+    gimp_quit ();
+
+  gimp_wire_destroy (&msg);
+}
+
+static guchar *
+gimp_tile_read_ahead_data (GimpTileBackendPlugin *backend_plugin,
+                           guint                  tile_num)
+{
+  GimpTileBackendPluginPrivate *priv = backend_plugin->priv;
+
+  if (priv->read_n_tiles > 0 &&
+      priv->read_stamp != g_atomic_int_get (&read_ahead_stamp))
+    {
+      priv->read_n_tiles = 0;
+    }
+
+  if (priv->read_n_tiles > 0             &&
+      tile_num >= priv->read_tile_num &&
+      tile_num <  priv->read_tile_num + priv->read_n_tiles)
+    {
+      return priv->read_data +
+             priv->read_offsets[tile_num - priv->read_tile_num];
+    }
+
+  return NULL;
+}
+
+static void
+gimp_tile_flush_writes (GimpTileBackendPlugin *backend_plugin)
+{
+  GimpTileBackendPluginPrivate *priv    = backend_plugin->priv;
+  GimpPlugIn                   *plug_in;
+  GPTileRangeReq                tile_range_req;
+  GPTileRangeData               tile_range_data;
+  GPTileRangeData              *tile_info;
+  GimpWireMessage               msg;
+
+  if (priv->write_n_tiles == 0)
+    return;
+
+  plug_in = gimp_get_plug_in ();
+
+  tile_range_req.drawable_id = -1;
+  tile_range_req.tile_num    = 0;
+  tile_range_req.n_tiles     = 0;
+  tile_range_req.shadow      = 0;
+
+  if (! gp_tile_range_req_write (_gimp_plug_in_get_write_channel (plug_in),
+                                 &tile_range_req, plug_in))
+    gimp_quit ();
+
+  _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_RANGE_DATA);
 
   tile_info = msg.data;
 
-  tile_data.drawable_id = priv->drawable_id;
-  tile_data.tile_num    = tile->tile_num;
-  tile_data.shadow      = priv->shadow;
-  tile_data.bpp         = priv->bpp;
-  tile_data.width       = tile->ewidth;
-  tile_data.height      = tile->eheight;
-  tile_data.use_shm     = tile_info->use_shm;
-  tile_data.data        = NULL;
+  tile_range_data.drawable_id = priv->drawable_id;
+  tile_range_data.tile_num    = priv->write_tile_num;
+  tile_range_data.n_tiles     = priv->write_n_tiles;
+  tile_range_data.shadow      = priv->shadow;
+  tile_range_data.bpp         = priv->bpp;
+  tile_range_data.use_shm     = tile_info->use_shm;
+  tile_range_data.length      = priv->write_length;
+  tile_range_data.data        = NULL;
 
   if (tile_info->use_shm)
     {
       memcpy (_gimp_shm_addr (),
-              tile->data,
-              tile->ewidth * tile->eheight * priv->bpp);
+              priv->write_data,
+              priv->write_length);
     }
   else
     {
-      tile_data.data = tile->data;
+      tile_range_data.data = priv->write_data;
     }
 
-  if (! gp_tile_data_write (_gimp_plug_in_get_write_channel (plug_in),
-                            &tile_data, plug_in))
+  if (! gp_tile_range_data_write (_gimp_plug_in_get_write_channel (plug_in),
+                                  &tile_range_data, plug_in))
     gimp_quit ();
 
-  if (! tile_info->use_shm)
-    tile_data.data = NULL;
-
   gimp_wire_destroy (&msg);
 
   _gimp_plug_in_read_expect_msg (plug_in, &msg, GP_TILE_ACK);
 
   gimp_wire_destroy (&msg);
+
+  priv->write_n_tiles = 0;
+  priv->write_length  = 0;
+
+  /*  other buffers of the same drawable may have fetched these tiles  */
+  _gimp_tile_backend_plugin_invalidate_read_ahead ();
 }
@@ -55,6 +55,8 @@ GType             _gimp_tile_backend_plugin_get_type (void) G_GNUC_CONST;
 GeglTileBackend * _gimp_tile_backend_plugin_new      (GimpDrawable *drawable,
                                                       gint          shadow);
 
+void              _gimp_tile_backend_plugin_invalidate_read_ahead (void);
+
 G_END_DECLS
 
 #endif /* __GIMP_TILE_BACKEND_PLUGIN_H__ */
@@ -0,0 +1,327 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * pdb-benchmark.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Measures the round-trip cost of PDB calls made from a plug-in, by
+ * making the same cheap call a number of times synchronously, with
+ * gimp_pdb_run_procedure_async(), and with gimp_pdb_run_procedure_batch().
+ *
+ * This is a developer tool and is not installed.  Add
+ * libgimp/test/test-plug-ins of the build directory to the plug-in
+ * folders, and call "plug-in-pdb-benchmark" from the Python console to
+ * read the times it returns.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <libgimp/gimp.h>
+
+#include "libgimp/stdplugins-intl.h"
+
+
+#define PLUG_IN_PROC   "plug-in-pdb-benchmark"
+#define PLUG_IN_BINARY "pdb-benchmark"
+
+#define CALLED_PROC    "gimp-get-images"
+
+
+typedef struct _Benchmark      Benchmark;
+typedef struct _BenchmarkClass BenchmarkClass;
+
+struct _Benchmark
+{
+  GimpPlugIn      parent_instance;
+};
+
+struct _BenchmarkClass
+{
+  GimpPlugInClass parent_class;
+};
+
+
+#define BENCHMARK_TYPE  (benchmark_get_type ())
+#define BENCHMARK (obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), BENCHMARK_TYPE, Benchmark))
+
+GType                   benchmark_get_type         (void) G_GNUC_CONST;
+
+static GList          * benchmark_query_procedures (GimpPlugIn           *plug_in);
+static GimpProcedure  * benchmark_create_procedure (GimpPlugIn           *plug_in,
+                                                    const gchar          *name);
+
+static GimpValueArray * benchmark_run              (GimpProcedure        *procedure,
+                                                    const GimpValueArray *args,
+                                                    gpointer              run_data);
+
+static gboolean         benchmark_sync             (GimpPDB              *pdb,
+                                                    gint                  n_calls);
+static gboolean         benchmark_async            (GimpPDB              *pdb,
+                                                    gint                  n_calls);
+static gboolean         benchmark_batch            (GimpPDB              *pdb,
+                                                    gint                  n_calls);
+
+static void             benchmark_async_callback   (GimpPDB              *pdb,
+                                                    GimpValueArray       *return_values,
+                                                    gpointer              user_data);
+
+
+G_DEFINE_TYPE (Benchmark, benchmark, GIMP_TYPE_PLUG_IN)
+
+GIMP_MAIN (BENCHMARK_TYPE)
+DEFINE_STD_SET_I18N
+
+
+static void
+benchmark_class_init (BenchmarkClass *klass)
+{
+  GimpPlugInClass *plug_in_class = GIMP_PLUG_IN_CLASS (klass);
+
+  plug_in_class->query_procedures = benchmark_query_procedures;
+  plug_in_class->create_procedure = benchmark_create_procedure;
+  plug_in_class->set_i18n         = STD_SET_I18N;
+}
+
+static void
+benchmark_init (Benchmark *benchmark)
+{
+}
+
+static GList *
+benchmark_query_procedures (GimpPlugIn *plug_in)
+{
+  return g_list_append (NULL, g_strdup (PLUG_IN_PROC));
+}
+
+static GimpProcedure *
+benchmark_create_procedure (GimpPlugIn  *plug_in,
+                            const gchar *name)
+{
+  GimpProcedure *procedure = NULL;
+
+  if (! strcmp (name, PLUG_IN_PROC))
+    {
+      procedure = gimp_procedure_new (plug_in, name,
+                                      GIMP_PDB_PROC_TYPE_PLUGIN,
+                                      benchmark_run, NULL, NULL);
+
+      gimp_procedure_set_documentation (procedure,
+                                        "Measure the round-trip cost of "
+                                        "PDB calls",
+                                        "Calls '" CALLED_PROC "' "
+                                        "n-calls times synchronously, "
+                                        "asynchronously and in a batch, "
+                                        "and returns the time in seconds "
+                                        "each took.",
+                                        name);
+      gimp_procedure_set_attribution (procedure,
+                                      "The GIMP Team",
+                                      "The GIMP Team",
+                                      "2026");
+
+      GIMP_PROC_ARG_ENUM (procedure, "run-mode",
+                          "Run mode",
+                          "The run mode",
+                          GIMP_TYPE_RUN_MODE,
+                          GIMP_RUN_NONINTERACTIVE,
+                          G_PARAM_READWRITE);
+
+      GIMP_PROC_ARG_INT (procedure, "n-calls",
+                         "Number of calls",
+                         "The number of calls to make in each run",
+                         1, G_MAXINT, 10000,
+                         G_PARAM_READWRITE);
+
+      GIMP_PROC_VAL_DOUBLE (procedure, "sync-time",
+                            "Synchronous time",
+                            "The time taken by synchronous calls",
+                            0.0, G_MAXDOUBLE, 0.0,
+                            G_PARAM_READWRITE);
+
+      GIMP_PROC_VAL_DOUBLE (procedure, "async-time",
+                            "Asynchronous time",
+                            "The time taken by asynchronous calls",
+                            0.0, G_MAXDOUBLE, 0.0,
+                            G_PARAM_READWRITE);
+
+      GIMP_PROC_VAL_DOUBLE (procedure, "batch-time",
+                            "Batch time",
+                            "The time taken by a batch of calls",
+                            0.0, G_MAXDOUBLE, 0.0,
+                            G_PARAM_READWRITE);
+    }
+
+  return procedure;
+}
+
+static GimpValueArray *
+benchmark_run (GimpProcedure        *procedure,
+               const GimpValueArray *args,
+               gpointer              run_data)
+{
+  GimpValueArray *return_vals;
+  GimpPDB        *pdb = gimp_get_pdb ();
+  GTimer         *timer;
+  gint            n_calls;
+  gdouble         sync_time;
+  gdouble         async_time;
+  gdouble         batch_time;
+  gboolean        success = TRUE;
+
+  n_calls = GIMP_VALUES_GET_INT (args, 1);
+
+  timer = g_timer_new ();
+
+  g_timer_start (timer);
+  success = success && benchmark_sync (pdb, n_calls);
+  sync_time = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  success = success && benchmark_async (pdb, n_calls);
+  async_time = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  success = success && benchmark_batch (pdb, n_calls);
+  batch_time = g_timer_elapsed (timer, NULL);
+
+  g_timer_destroy (timer);
+
+  if (! success)
+    {
+      GError *error = NULL;
+
+      g_set_error (&error, GIMP_PLUG_IN_ERROR, 0,
+                   "Calling '%s' failed", CALLED_PROC);
+
+      return gimp_procedure_new_return_values (procedure,
+                                               GIMP_PDB_EXECUTION_ERROR,
+                                               error);
+    }
+
+  return_vals = gimp_procedure_new_return_values (procedure,
+                                                  GIMP_PDB_SUCCESS,
+                                                  NULL);
+
+  GIMP_VALUES_SET_DOUBLE (return_vals, 1, sync_time);
+  GIMP_VALUES_SET_DOUBLE (return_vals, 2, async_time);
+  GIMP_VALUES_SET_DOUBLE (return_vals, 3, batch_time);
+
+  return return_vals;
+}
+
+static gboolean
+benchmark_sync (GimpPDB *pdb,
+                gint     n_calls)
+{
+  GimpValueArray *args;
+  gboolean        success = TRUE;
+  gint            i;
+
+  args = gimp_value_array_new_from_types (NULL, G_TYPE_NONE);
+
+  for (i = 0; i < n_calls && success; i++)
+    {
+      GimpValueArray *return_vals;
+
+      return_vals = gimp_pdb_run_procedure_array (pdb, CALLED_PROC, args);
+
+      success = GIMP_VALUES_GET_ENUM (return_vals, 0) == GIMP_PDB_SUCCESS;
+
+      gimp_value_array_unref (return_vals);
+    }
+
+  gimp_value_array_unref (args);
+
+  return success;
+}
+
+static gboolean
+benchmark_async (GimpPDB *pdb,
+                 gint     n_calls)
+{
+  GimpValueArray *args;
+  gint            n_succeeded = 0;
+  gint            i;
+
+  args = gimp_value_array_new_from_types (NULL, G_TYPE_NONE);
+
+  for (i = 0; i < n_calls; i++)
+    {
+      gimp_pdb_run_procedure_async (pdb, CALLED_PROC, args,
+                                    benchmark_async_callback, &n_succeeded,
+                                    NULL);
+    }
+
+  gimp_pdb_flush (pdb);
+
+  gimp_value_array_unref (args);
+
+  return n_succeeded == n_calls;
+}
+
+static gboolean
+benchmark_batch (GimpPDB *pdb,
+                 gint     n_calls)
+{
+  const gchar     **names;
+  GimpValueArray  **args;
+  GimpValueArray  **return_vals;
+  GimpValueArray   *call_args;
+  gboolean          success = TRUE;
+  gint              i;
+
+  call_args = gimp_value_array_new_from_types (NULL, G_TYPE_NONE);
+
+  names = g_new (const gchar *, n_calls);
+  args  = g_new (GimpValueArray *, n_calls);
+
+  for (i = 0; i < n_calls; i++)
+    {
+      names[i] = CALLED_PROC;
+      args[i]  = call_args;
+    }
+
+  return_vals = gimp_pdb_run_procedure_batch (pdb, names, args, n_calls);
+
+  for (i = 0; i < n_calls; i++)
+    {
+      if (GIMP_VALUES_GET_ENUM (return_vals[i], 0) != GIMP_PDB_SUCCESS)
+        success = FALSE;
+
+      gimp_value_array_unref (return_vals[i]);
+    }
+
+  g_free (return_vals);
+  g_free (args);
+  g_free (names);
+
+  gimp_value_array_unref (call_args);
+
+  return success;
+}
+
+static void
+benchmark_async_callback (GimpPDB        *pdb,
+                          GimpValueArray *return_values,
+                          gpointer        user_data)
+{
+  gint *n_succeeded = user_data;
+
+  if (GIMP_VALUES_GET_ENUM (return_values, 0) == GIMP_PDB_SUCCESS)
+    (*n_succeeded)++;
+}
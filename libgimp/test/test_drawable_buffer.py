@@ -0,0 +1,63 @@
+"""
+Python scripts to test reading drawable buffers from libgimp.
+
+See comments about usage and setup in test-resource-class.py
+
+Tests that tiles a buffer fetched ahead of time are not returned
+after a PDB call changed the drawable.
+"""
+
+"""
+Create a test image, large enough for tiles to be fetched in ranges
+********************************************************************************
+"""
+image = Gimp.Image.new(1024, 256, Gimp.ImageBaseType.RGB)
+layer = Gimp.Layer.new(image, "test", 1024, 256,
+                       Gimp.ImageType.RGB_IMAGE, 100.0,
+                       Gimp.LayerMode.NORMAL)
+image.insert_layer(layer, None, 0)
+
+rect = Gegl.Rectangle.new(0, 0, 1024, 256)
+
+def fill_with(value):
+    color = Gimp.RGB()
+    color.set(value, value, value)
+    Gimp.context_set_foreground(color)
+    layer.fill(Gimp.FillType.FOREGROUND)
+
+"""
+Sanity check: a new buffer sees what a PDB call did.
+"""
+fill_with(0.0)
+
+buffer = layer.get_buffer()
+
+before = buffer.get(rect, 1.0, "R'G'B' u8", Gegl.AbyssPolicy.NONE)
+assert before == bytes(1024 * 256 * 3)
+
+fill_with(1.0)
+
+buffer = layer.get_buffer()
+
+after = buffer.get(rect, 1.0, "R'G'B' u8", Gegl.AbyssPolicy.NONE)
+assert after == bytes([255]) * (1024 * 256 * 3)
+
+"""
+Read the first tile of a row, which fetches the rest of the row ahead,
+change the drawable with a PDB call, and read the rest of the row
+through the same buffer.  It must not come from the tiles fetched
+before the call.
+"""
+row = Gegl.Rectangle.new(0, 0, 64, 64)
+rest = Gegl.Rectangle.new(64, 0, 1024 - 64, 64)
+
+buffer = layer.get_buffer()
+first = buffer.get(row, 1.0, "R'G'B' u8", Gegl.AbyssPolicy.NONE)
+assert first == bytes([255]) * (64 * 64 * 3)
+
+fill_with(0.0)
+
+rest_pixels = buffer.get(rest, 1.0, "R'G'B' u8", Gegl.AbyssPolicy.NONE)
+assert rest_pixels == bytes((1024 - 64) * 64 * 3)
+
+image.delete()
@@ -128,9 +128,15 @@ enum
   ARCH_X86_INTEL_FEATURE_SSSE3    = 1 << 9,
   ARCH_X86_INTEL_FEATURE_SSE4_1   = 1 << 19,
   ARCH_X86_INTEL_FEATURE_SSE4_2   = 1 << 20,
+  ARCH_X86_INTEL_FEATURE_OSXSAVE  = 1 << 27,
   ARCH_X86_INTEL_FEATURE_AVX      = 1 << 28
 };
 
+enum
+{
+  ARCH_X86_INTEL_FEATURE_AVX2     = 1 << 5
+};
+
 #if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
 #define cpuid(op,eax,ebx,ecx,edx)  \
   __asm__ ("movl %%ebx, %%esi\n\t" \
@@ -151,6 +157,28 @@ enum
            : "0" (op))
 #endif
 
+#if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("movl %%ebx, %%esi\n\t"            \
+           "cpuid\n\t"                        \
+           "xchgl %%ebx,%%esi"                \
+           : "=a" (eax),                      \
+             "=S" (ebx),                      \
+             "=c" (ecx),                      \
+             "=d" (edx)                       \
+           : "0" (op),                        \
+             "2" (count))
+#else
+#define cpuid_count(op,count,eax,ebx,ecx,edx) \
+  __asm__ ("cpuid"                            \
+           : "=a" (eax),                      \
+             "=b" (ebx),                      \
+             "=c" (ecx),                      \
+             "=d" (edx)                       \
+           : "0" (op),                        \
+             "2" (count))
+#endif
+
 
 static X86Vendor
 arch_get_vendor (void)
@@ -266,6 +294,25 @@ arch_accel_intel (void)
 
     if (ecx & ARCH_X86_INTEL_FEATURE_AVX)
       caps |= GIMP_CPU_ACCEL_X86_AVX;
+
+    /* AVX2 also needs the OS to save the YMM registers */
+    if ((ecx & ARCH_X86_INTEL_FEATURE_OSXSAVE) &&
+        (ecx & ARCH_X86_INTEL_FEATURE_AVX))
+      {
+        guint32 xcr0_lo, xcr0_hi;
+
+        __asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+
+        cpuid (0, eax, ebx, ecx, edx);
+
+        if ((xcr0_lo & 0x6) == 0x6 && eax >= 7)
+          {
+            cpuid_count (7, 0, eax, ebx, ecx, edx);
+
+            if (ebx & ARCH_X86_INTEL_FEATURE_AVX2)
+              caps |= GIMP_CPU_ACCEL_X86_AVX2;
+          }
+      }
 #endif /* USE_SSE */
   }
 #endif /* USE_MMX */
@@ -68,6 +68,46 @@ static void _gp_tile_data_write          (GIOChannel       *channel,
                                           gpointer          user_data);
 static void _gp_tile_data_destroy        (GimpWireMessage  *msg);
 
+static void _gp_tile_range_req_read      (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_range_req_write     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_range_req_destroy   (GimpWireMessage  *msg);
+
+static void _gp_tile_range_data_read     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_range_data_write    (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_tile_range_data_destroy  (GimpWireMessage  *msg);
+
+static void _gp_buffer_map_req_read      (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_buffer_map_req_write     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_buffer_map_req_destroy   (GimpWireMessage  *msg);
+
+static void _gp_buffer_map_data_read     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_buffer_map_data_write    (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_buffer_map_data_destroy  (GimpWireMessage  *msg);
+
+static void _gp_buffer_unmap_read        (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_buffer_unmap_write       (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_buffer_unmap_destroy     (GimpWireMessage  *msg);
+
 static void _gp_proc_run_read            (GIOChannel       *channel,
                                           GimpWireMessage  *msg,
                                           gpointer          user_data);
@@ -136,6 +176,22 @@ static void _gp_params_destroy           (GPParam          *params,
                                           gint              n_params);
 
 
+static void _gp_proc_run_batch_read      (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_proc_run_batch_write     (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_proc_run_batch_destroy   (GimpWireMessage  *msg);
+
+static void _gp_proc_return_batch_read   (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_proc_return_batch_write  (GIOChannel       *channel,
+                                          GimpWireMessage  *msg,
+                                          gpointer          user_data);
+static void _gp_proc_return_batch_destroy (GimpWireMessage *msg);
+
 static void _gp_has_init_read            (GIOChannel       *channel,
                                           GimpWireMessage  *msg,
                                           gpointer          user_data);
@@ -201,6 +257,34 @@ gp_init (void)
                       _gp_has_init_read,
                       _gp_has_init_write,
                       _gp_has_init_destroy);
+  gimp_wire_register (GP_TILE_RANGE_REQ,
+                      _gp_tile_range_req_read,
+                      _gp_tile_range_req_write,
+                      _gp_tile_range_req_destroy);
+  gimp_wire_register (GP_TILE_RANGE_DATA,
+                      _gp_tile_range_data_read,
+                      _gp_tile_range_data_write,
+                      _gp_tile_range_data_destroy);
+  gimp_wire_register (GP_BUFFER_MAP_REQ,
+                      _gp_buffer_map_req_read,
+                      _gp_buffer_map_req_write,
+                      _gp_buffer_map_req_destroy);
+  gimp_wire_register (GP_BUFFER_MAP_DATA,
+                      _gp_buffer_map_data_read,
+                      _gp_buffer_map_data_write,
+                      _gp_buffer_map_data_destroy);
+  gimp_wire_register (GP_BUFFER_UNMAP,
+                      _gp_buffer_unmap_read,
+                      _gp_buffer_unmap_write,
+                      _gp_buffer_unmap_destroy);
+  gimp_wire_register (GP_PROC_RUN_BATCH,
+                      _gp_proc_run_batch_read,
+                      _gp_proc_run_batch_write,
+                      _gp_proc_run_batch_destroy);
+  gimp_wire_register (GP_PROC_RETURN_BATCH,
+                      _gp_proc_return_batch_read,
+                      _gp_proc_return_batch_write,
+                      _gp_proc_return_batch_destroy);
 }
 
 /* public writing API */
@@ -298,6 +382,101 @@ gp_tile_data_write (GIOChannel *channel,
   return TRUE;
 }
 
+gboolean
+gp_tile_range_req_write (GIOChannel     *channel,
+                         GPTileRangeReq *tile_range_req,
+                         gpointer        user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILE_RANGE_REQ;
+  msg.data = tile_range_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_tile_range_data_write (GIOChannel      *channel,
+                          GPTileRangeData *tile_range_data,
+                          gpointer         user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_TILE_RANGE_DATA;
+  msg.data = tile_range_data;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_buffer_map_req_write (GIOChannel     *channel,
+                         GPBufferMapReq *buffer_map_req,
+                         gpointer        user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_BUFFER_MAP_REQ;
+  msg.data = buffer_map_req;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_buffer_map_data_write (GIOChannel      *channel,
+                          GPBufferMapData *buffer_map_data,
+                          gpointer         user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_BUFFER_MAP_DATA;
+  msg.data = buffer_map_data;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_buffer_unmap_write (GIOChannel    *channel,
+                       GPBufferUnmap *buffer_unmap,
+                       gpointer       user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_BUFFER_UNMAP;
+  msg.data = buffer_unmap;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 gboolean
 gp_proc_run_write (GIOChannel *channel,
                    GPProcRun  *proc_run,
@@ -336,6 +515,44 @@ gp_proc_return_write (GIOChannel   *channel,
   return TRUE;
 }
 
+gboolean
+gp_proc_run_batch_write (GIOChannel     *channel,
+                         GPProcRunBatch *proc_run_batch,
+                         gpointer        user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_PROC_RUN_BATCH;
+  msg.data = proc_run_batch;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gp_proc_return_batch_write (GIOChannel        *channel,
+                            GPProcReturnBatch *proc_return_batch,
+                            gpointer           user_data)
+{
+  GimpWireMessage msg;
+
+  msg.type = GP_PROC_RETURN_BATCH;
+  msg.data = proc_return_batch;
+
+  if (! gimp_wire_write_msg (channel, &msg, user_data))
+    return FALSE;
+
+  if (! gimp_wire_flush (channel, user_data))
+    return FALSE;
+
+  return TRUE;
+}
+
 gboolean
 gp_temp_proc_run_write (GIOChannel *channel,
                         GPProcRun  *proc_run,
@@ -889,6 +1106,379 @@ _gp_tile_data_destroy (GimpWireMessage *msg)
     }
 }
 
+/*  tile_range_req  */
+
+static void
+_gp_tile_range_req_read (GIOChannel      *channel,
+                         GimpWireMessage *msg,
+                         gpointer         user_data)
+{
+  GPTileRangeReq *tile_range_req = g_slice_new0 (GPTileRangeReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tile_range_req->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_req->tile_num, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_req->n_tiles, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_req->shadow, 1, user_data))
+    goto cleanup;
+
+  msg->data = tile_range_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPTileRangeReq, tile_range_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_tile_range_req_write (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPTileRangeReq *tile_range_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tile_range_req->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_req->tile_num, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_req->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_req->shadow, 1, user_data))
+    return;
+}
+
+static void
+_gp_tile_range_req_destroy (GimpWireMessage *msg)
+{
+  GPTileRangeReq *tile_range_req = msg->data;
+
+  if (tile_range_req)
+    g_slice_free (GPTileRangeReq, tile_range_req);
+}
+
+/*  tile_range_data  */
+
+static void
+_gp_tile_range_data_read (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPTileRangeData *tile_range_data = g_slice_new0 (GPTileRangeData);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &tile_range_data->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_data->tile_num, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_data->n_tiles, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_data->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_data->bpp, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_data->use_shm, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &tile_range_data->length, 1, user_data))
+    goto cleanup;
+
+  if (! tile_range_data->use_shm && tile_range_data->length > 0)
+    {
+      tile_range_data->data = g_try_malloc (tile_range_data->length);
+
+      if (! tile_range_data->data)
+        goto cleanup;
+
+      if (! _gimp_wire_read_int8 (channel,
+                                  (guint8 *) tile_range_data->data,
+                                  tile_range_data->length,
+                                  user_data))
+        goto cleanup;
+    }
+
+  msg->data = tile_range_data;
+  return;
+
+ cleanup:
+  g_free (tile_range_data->data);
+  g_slice_free (GPTileRangeData, tile_range_data);
+  msg->data = NULL;
+}
+
+static void
+_gp_tile_range_data_write (GIOChannel      *channel,
+                           GimpWireMessage *msg,
+                           gpointer         user_data)
+{
+  GPTileRangeData *tile_range_data = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &tile_range_data->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_data->tile_num, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_data->n_tiles, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_data->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_data->bpp, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_data->use_shm, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &tile_range_data->length, 1, user_data))
+    return;
+
+  if (! tile_range_data->use_shm && tile_range_data->length > 0)
+    {
+      if (! _gimp_wire_write_int8 (channel,
+                                   (const guint8 *) tile_range_data->data,
+                                   tile_range_data->length,
+                                   user_data))
+        return;
+    }
+}
+
+static void
+_gp_tile_range_data_destroy (GimpWireMessage *msg)
+{
+  GPTileRangeData *tile_range_data = msg->data;
+
+  if (tile_range_data)
+    {
+      g_free (tile_range_data->data);
+      g_slice_free (GPTileRangeData, tile_range_data);
+    }
+}
+
+/*  buffer_map_req  */
+
+static void
+_gp_buffer_map_req_read (GIOChannel      *channel,
+                         GimpWireMessage *msg,
+                         gpointer         user_data)
+{
+  GPBufferMapReq *buffer_map_req = g_slice_new0 (GPBufferMapReq);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &buffer_map_req->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_map_req->shadow, 1, user_data))
+    goto cleanup;
+
+  msg->data = buffer_map_req;
+  return;
+
+ cleanup:
+  g_slice_free (GPBufferMapReq, buffer_map_req);
+  msg->data = NULL;
+}
+
+static void
+_gp_buffer_map_req_write (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPBufferMapReq *buffer_map_req = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &buffer_map_req->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_map_req->shadow, 1, user_data))
+    return;
+}
+
+static void
+_gp_buffer_map_req_destroy (GimpWireMessage *msg)
+{
+  GPBufferMapReq *buffer_map_req = msg->data;
+
+  if (buffer_map_req)
+    g_slice_free (GPBufferMapReq, buffer_map_req);
+}
+
+/*  buffer_map_data  */
+
+static void
+_gp_buffer_map_data_read (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPBufferMapData *buffer_map_data = g_slice_new0 (GPBufferMapData);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &buffer_map_data->drawable_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_map_data->shadow, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &buffer_map_data->map_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_string (channel,
+                                &buffer_map_data->map_name, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_map_data->width, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_map_data->height, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_map_data->bpp, 1, user_data))
+    goto cleanup;
+
+  msg->data = buffer_map_data;
+  return;
+
+ cleanup:
+  g_free (buffer_map_data->map_name);
+  g_slice_free (GPBufferMapData, buffer_map_data);
+  msg->data = NULL;
+}
+
+static void
+_gp_buffer_map_data_write (GIOChannel      *channel,
+                           GimpWireMessage *msg,
+                           gpointer         user_data)
+{
+  GPBufferMapData *buffer_map_data = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &buffer_map_data->drawable_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_map_data->shadow, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &buffer_map_data->map_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_string (channel,
+                                 &buffer_map_data->map_name, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_map_data->width, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_map_data->height, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_map_data->bpp, 1, user_data))
+    return;
+}
+
+static void
+_gp_buffer_map_data_destroy (GimpWireMessage *msg)
+{
+  GPBufferMapData *buffer_map_data = msg->data;
+
+  if (buffer_map_data)
+    {
+      g_free (buffer_map_data->map_name);
+      g_slice_free (GPBufferMapData, buffer_map_data);
+    }
+}
+
+/*  buffer_unmap  */
+
+static void
+_gp_buffer_unmap_read (GIOChannel      *channel,
+                       GimpWireMessage *msg,
+                       gpointer         user_data)
+{
+  GPBufferUnmap *buffer_unmap = g_slice_new0 (GPBufferUnmap);
+
+  if (! _gimp_wire_read_int32 (channel,
+                               (guint32 *) &buffer_unmap->map_id, 1,
+                               user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_unmap->x, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_unmap->y, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_unmap->width, 1, user_data))
+    goto cleanup;
+  if (! _gimp_wire_read_int32 (channel,
+                               &buffer_unmap->height, 1, user_data))
+    goto cleanup;
+
+  msg->data = buffer_unmap;
+  return;
+
+ cleanup:
+  g_slice_free (GPBufferUnmap, buffer_unmap);
+  msg->data = NULL;
+}
+
+static void
+_gp_buffer_unmap_write (GIOChannel      *channel,
+                        GimpWireMessage *msg,
+                        gpointer         user_data)
+{
+  GPBufferUnmap *buffer_unmap = msg->data;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                (const guint32 *) &buffer_unmap->map_id, 1,
+                                user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_unmap->x, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_unmap->y, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_unmap->width, 1, user_data))
+    return;
+  if (! _gimp_wire_write_int32 (channel,
+                                &buffer_unmap->height, 1, user_data))
+    return;
+}
+
+static void
+_gp_buffer_unmap_destroy (GimpWireMessage *msg)
+{
+  GPBufferUnmap *buffer_unmap = msg->data;
+
+  if (buffer_unmap)
+    g_slice_free (GPBufferUnmap, buffer_unmap);
+}
+
 /*  proc_run  */
 
 static void
@@ -992,6 +1582,191 @@ _gp_proc_return_destroy (GimpWireMessage *msg)
     }
 }
 
+/*  proc_run_batch  */
+
+static void
+_gp_proc_run_batch_read (GIOChannel      *channel,
+                         GimpWireMessage *msg,
+                         gpointer         user_data)
+{
+  GPProcRunBatch *proc_run_batch = g_slice_new0 (GPProcRunBatch);
+  guint32         n_procs;
+  gint            i;
+
+  if (! _gimp_wire_read_int32 (channel, &n_procs, 1, user_data))
+    goto cleanup;
+
+  if (n_procs > GP_PROC_BATCH_MAX_CALLS)
+    goto cleanup;
+
+  proc_run_batch->procs = g_new0 (GPProcRun, n_procs);
+
+  for (i = 0; i < n_procs; i++)
+    {
+      GPProcRun *proc_run = &proc_run_batch->procs[i];
+
+      if (! _gimp_wire_read_string (channel, &proc_run->name, 1, user_data))
+        goto cleanup;
+
+      _gp_params_read (channel,
+                       &proc_run->params, (guint *) &proc_run->n_params,
+                       user_data);
+
+      proc_run_batch->n_procs++;
+
+      if (gimp_wire_error ())
+        goto cleanup;
+    }
+
+  msg->data = proc_run_batch;
+  return;
+
+ cleanup:
+  msg->data = proc_run_batch;
+  _gp_proc_run_batch_destroy (msg);
+  msg->data = NULL;
+}
+
+static void
+_gp_proc_run_batch_write (GIOChannel      *channel,
+                          GimpWireMessage *msg,
+                          gpointer         user_data)
+{
+  GPProcRunBatch *proc_run_batch = msg->data;
+  gint            i;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                &proc_run_batch->n_procs, 1, user_data))
+    return;
+
+  for (i = 0; i < proc_run_batch->n_procs; i++)
+    {
+      GPProcRun *proc_run = &proc_run_batch->procs[i];
+
+      if (! _gimp_wire_write_string (channel, &proc_run->name, 1, user_data))
+        return;
+
+      _gp_params_write (channel,
+                        proc_run->params, proc_run->n_params, user_data);
+    }
+}
+
+static void
+_gp_proc_run_batch_destroy (GimpWireMessage *msg)
+{
+  GPProcRunBatch *proc_run_batch = msg->data;
+
+  if (proc_run_batch)
+    {
+      gint i;
+
+      for (i = 0; i < proc_run_batch->n_procs; i++)
+        {
+          _gp_params_destroy (proc_run_batch->procs[i].params,
+                              proc_run_batch->procs[i].n_params);
+
+          g_free (proc_run_batch->procs[i].name);
+        }
+
+      g_free (proc_run_batch->procs);
+      g_slice_free (GPProcRunBatch, proc_run_batch);
+    }
+}
+
+/*  proc_return_batch  */
+
+static void
+_gp_proc_return_batch_read (GIOChannel      *channel,
+                            GimpWireMessage *msg,
+                            gpointer         user_data)
+{
+  GPProcReturnBatch *proc_return_batch = g_slice_new0 (GPProcReturnBatch);
+  guint32            n_procs;
+  gint               i;
+
+  if (! _gimp_wire_read_int32 (channel, &n_procs, 1, user_data))
+    goto cleanup;
+
+  if (n_procs > GP_PROC_BATCH_MAX_CALLS)
+    goto cleanup;
+
+  proc_return_batch->procs = g_new0 (GPProcReturn, n_procs);
+
+  for (i = 0; i < n_procs; i++)
+    {
+      GPProcReturn *proc_return = &proc_return_batch->procs[i];
+
+      if (! _gimp_wire_read_string (channel, &proc_return->name, 1,
+                                    user_data))
+        goto cleanup;
+
+      _gp_params_read (channel,
+                       &proc_return->params, (guint *) &proc_return->n_params,
+                       user_data);
+
+      proc_return_batch->n_procs++;
+
+      if (gimp_wire_error ())
+        goto cleanup;
+    }
+
+  msg->data = proc_return_batch;
+  return;
+
+ cleanup:
+  msg->data = proc_return_batch;
+  _gp_proc_return_batch_destroy (msg);
+  msg->data = NULL;
+}
+
+static void
+_gp_proc_return_batch_write (GIOChannel      *channel,
+                             GimpWireMessage *msg,
+                             gpointer         user_data)
+{
+  GPProcReturnBatch *proc_return_batch = msg->data;
+  gint               i;
+
+  if (! _gimp_wire_write_int32 (channel,
+                                &proc_return_batch->n_procs, 1, user_data))
+    return;
+
+  for (i = 0; i < proc_return_batch->n_procs; i++)
+    {
+      GPProcReturn *proc_return = &proc_return_batch->procs[i];
+
+      if (! _gimp_wire_write_string (channel, &proc_return->name, 1,
+                                     user_data))
+        return;
+
+      _gp_params_write (channel,
+                        proc_return->params, proc_return->n_params,
+                        user_data);
+    }
+}
+
+static void
+_gp_proc_return_batch_destroy (GimpWireMessage *msg)
+{
+  GPProcReturnBatch *proc_return_batch = msg->data;
+
+  if (proc_return_batch)
+    {
+      gint i;
+
+      for (i = 0; i < proc_return_batch->n_procs; i++)
+        {
+          _gp_params_destroy (proc_return_batch->procs[i].params,
+                              proc_return_batch->procs[i].n_params);
+
+          g_free (proc_return_batch->procs[i].name);
+        }
+
+      g_free (proc_return_batch->procs);
+      g_slice_free (GPProcReturnBatch, proc_return_batch);
+    }
+}
+
 /*  temp_proc_run  */
 
 static void
@@ -26,7 +26,7 @@ G_BEGIN_DECLS
 
 /* Increment every time the protocol changes
  */
-#define GIMP_PROTOCOL_VERSION  0x010F
+#define GIMP_PROTOCOL_VERSION  0x0112
 
 
 enum
@@ -43,9 +43,31 @@ enum
   GP_PROC_INSTALL,
   GP_PROC_UNINSTALL,
   GP_EXTENSION_ACK,
-  GP_HAS_INIT
+  GP_HAS_INIT,
+  GP_TILE_RANGE_REQ,
+  GP_TILE_RANGE_DATA,
+  GP_BUFFER_MAP_REQ,
+  GP_BUFFER_MAP_DATA,
+  GP_BUFFER_UNMAP,
+  GP_PROC_RUN_BATCH,
+  GP_PROC_RETURN_BATCH
 };
 
+
+/* The shared memory segment used for transferring tiles is big enough
+ * for this many tiles of the largest possible pixel size (32 bytes).
+ * It limits how many tiles fit into one GP_TILE_RANGE_DATA message.
+ */
+#define GP_SHM_N_TILES          16
+
+/* The maximum number of tiles transferred by one GP_TILE_RANGE_REQ.
+ */
+#define GP_TILE_RANGE_MAX_TILES 64
+
+/* The maximum number of procedure calls sent by one GP_PROC_RUN_BATCH.
+ */
+#define GP_PROC_BATCH_MAX_CALLS 256
+
 typedef enum
 {
   GP_PARAM_DEF_TYPE_DEFAULT,
@@ -80,6 +102,11 @@ typedef struct _GPConfig           GPConfig;
 typedef struct _GPTileReq          GPTileReq;
 typedef struct _GPTileAck          GPTileAck;
 typedef struct _GPTileData         GPTileData;
+typedef struct _GPTileRangeReq     GPTileRangeReq;
+typedef struct _GPTileRangeData    GPTileRangeData;
+typedef struct _GPBufferMapReq     GPBufferMapReq;
+typedef struct _GPBufferMapData    GPBufferMapData;
+typedef struct _GPBufferUnmap      GPBufferUnmap;
 typedef struct _GPParamDef         GPParamDef;
 typedef struct _GPParamDefInt      GPParamDefInt;
 typedef struct _GPParamDefUnit     GPParamDefUnit;
@@ -96,6 +123,8 @@ typedef struct _GPParamArray       GPParamArray;
 typedef struct _GPParamIDArray     GPParamIDArray;
 typedef struct _GPProcRun          GPProcRun;
 typedef struct _GPProcReturn       GPProcReturn;
+typedef struct _GPProcRunBatch     GPProcRunBatch;
+typedef struct _GPProcReturnBatch  GPProcReturnBatch;
 typedef struct _GPProcInstall      GPProcInstall;
 typedef struct _GPProcUninstall    GPProcUninstall;
 
@@ -151,6 +180,62 @@ struct _GPTileData
   guchar  *data;
 };
 
+/* since protocol version 0x0110: a range of consecutive tiles, in
+ * tile number order, whose pixel data is stored tile after tile.
+ */
+struct _GPTileRangeReq
+{
+  gint32   drawable_id;
+  guint32  tile_num;
+  guint32  n_tiles;
+  guint32  shadow;
+};
+
+struct _GPTileRangeData
+{
+  gint32   drawable_id;
+  guint32  tile_num;
+  guint32  n_tiles;
+  guint32  shadow;
+  guint32  bpp;
+  guint32  use_shm;
+  guint32  length;
+  guchar  *data;
+};
+
+/* since protocol version 0x0111: a drawable's (or its shadow's) whole
+ * pixel data, copied once into a shared memory segment of its own
+ * which the plug-in maps as linear buffer.  map_id is -1 if the
+ * drawable could not be mapped.  map_name is used for POSIX shared
+ * memory only.  GP_BUFFER_UNMAP writes the given area back to the
+ * drawable, if not empty, and releases the segment.
+ */
+struct _GPBufferMapReq
+{
+  gint32   drawable_id;
+  guint32  shadow;
+};
+
+struct _GPBufferMapData
+{
+  gint32   drawable_id;
+  guint32  shadow;
+  gint32   map_id;
+  gchar   *map_name;
+  guint32  width;
+  guint32  height;
+  guint32  bpp;
+};
+
+struct _GPBufferUnmap
+{
+  gint32   map_id;
+  guint32  x;
+  guint32  y;
+  guint32  width;
+  guint32  height;
+};
+
 struct _GPParamDefInt
 {
   gint64 min_val;
@@ -274,6 +359,18 @@ struct _GPProcReturn
   GPParam *params;
 };
 
+struct _GPProcRunBatch
+{
+  guint32    n_procs;
+  GPProcRun *procs;
+};
+
+struct _GPProcReturnBatch
+{
+  guint32       n_procs;
+  GPProcReturn *procs;
+};
+
 struct _GPProcInstall
 {
   gchar      *name;
@@ -305,12 +402,33 @@ gboolean  gp_tile_ack_write         (GIOChannel      *channel,
 gboolean  gp_tile_data_write        (GIOChannel      *channel,
                                      GPTileData      *tile_data,
                                      gpointer         user_data);
+gboolean  gp_tile_range_req_write   (GIOChannel      *channel,
+                                     GPTileRangeReq  *tile_range_req,
+                                     gpointer         user_data);
+gboolean  gp_tile_range_data_write  (GIOChannel      *channel,
+                                     GPTileRangeData *tile_range_data,
+                                     gpointer         user_data);
+gboolean  gp_buffer_map_req_write   (GIOChannel      *channel,
+                                     GPBufferMapReq  *buffer_map_req,
+                                     gpointer         user_data);
+gboolean  gp_buffer_map_data_write  (GIOChannel      *channel,
+                                     GPBufferMapData *buffer_map_data,
+                                     gpointer         user_data);
+gboolean  gp_buffer_unmap_write     (GIOChannel      *channel,
+                                     GPBufferUnmap   *buffer_unmap,
+                                     gpointer         user_data);
 gboolean  gp_proc_run_write         (GIOChannel      *channel,
                                      GPProcRun       *proc_run,
                                      gpointer         user_data);
 gboolean  gp_proc_return_write      (GIOChannel      *channel,
                                      GPProcReturn    *proc_return,
                                      gpointer         user_data);
+gboolean  gp_proc_run_batch_write   (GIOChannel        *channel,
+                                     GPProcRunBatch    *proc_run_batch,
+                                     gpointer           user_data);
+gboolean  gp_proc_return_batch_write (GIOChannel        *channel,
+                                      GPProcReturnBatch *proc_return_batch,
+                                      gpointer           user_data);
 gboolean  gp_temp_proc_run_write    (GIOChannel      *channel,
                                      GPProcRun       *proc_run,
                                      gpointer         user_data);
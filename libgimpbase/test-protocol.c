@@ -0,0 +1,536 @@
+/* unit tests for the batched procedure call and the buffer mapping
+ * messages in gimpprotocol.c
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "gimpbasetypes.h"
+
+#include "gimpparasite.h"
+#include "gimpprotocol.h"
+#include "gimpwire.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gimpprotocol/" #function, function);
+
+
+/*  An in-memory channel: messages are written to the end of the
+ *  buffer and read from its current position.
+ */
+typedef struct
+{
+  GByteArray *bytes;
+  gsize       pos;
+} TestChannel;
+
+
+static gboolean
+test_channel_read (GIOChannel   *channel,
+                   const guint8 *buf,
+                   gulong        count,
+                   gpointer      user_data)
+{
+  TestChannel *test_channel = user_data;
+
+  if (test_channel->pos + count > test_channel->bytes->len)
+    return FALSE;
+
+  memcpy ((guint8 *) buf, test_channel->bytes->data + test_channel->pos, count);
+  test_channel->pos += count;
+
+  return TRUE;
+}
+
+static gboolean
+test_channel_write (GIOChannel   *channel,
+                    const guint8 *buf,
+                    gulong        count,
+                    gpointer      user_data)
+{
+  TestChannel *test_channel = user_data;
+
+  g_byte_array_append (test_channel->bytes, buf, count);
+
+  return TRUE;
+}
+
+static gboolean
+test_channel_flush (GIOChannel *channel,
+                    gpointer    user_data)
+{
+  return TRUE;
+}
+
+static void
+test_channel_init (TestChannel *test_channel)
+{
+  test_channel->bytes = g_byte_array_new ();
+  test_channel->pos   = 0;
+
+  gimp_wire_clear_error ();
+}
+
+static void
+test_channel_clear (TestChannel *test_channel)
+{
+  g_byte_array_unref (test_channel->bytes);
+
+  gimp_wire_clear_error ();
+}
+
+/*  Calls the procedures "test-0", "test-1", ..., with an int, a string,
+ *  or no argument.
+ */
+static void
+test_params_init (GPParam *param,
+                  gint     i)
+{
+  switch (i % 3)
+    {
+    case 0:
+      param->param_type = GP_PARAM_TYPE_INT;
+      param->type_name  = "gint";
+      param->data.d_int = i * 10;
+      break;
+
+    case 1:
+      param->param_type    = GP_PARAM_TYPE_STRING;
+      param->type_name     = "gchararray";
+      param->data.d_string = g_strdup_printf ("value-%d", i);
+      break;
+    }
+}
+
+static void
+test_params_check (GPParam *params,
+                   guint32  n_params,
+                   gint     i)
+{
+  gchar *value;
+
+  switch (i % 3)
+    {
+    case 0:
+      g_assert_cmpuint (n_params, ==, 1);
+      g_assert_cmpint (params[0].param_type, ==, GP_PARAM_TYPE_INT);
+      g_assert_cmpstr (params[0].type_name, ==, "gint");
+      g_assert_cmpint (params[0].data.d_int, ==, i * 10);
+      break;
+
+    case 1:
+      value = g_strdup_printf ("value-%d", i);
+
+      g_assert_cmpuint (n_params, ==, 1);
+      g_assert_cmpint (params[0].param_type, ==, GP_PARAM_TYPE_STRING);
+      g_assert_cmpstr (params[0].type_name, ==, "gchararray");
+      g_assert_cmpstr (params[0].data.d_string, ==, value);
+
+      g_free (value);
+      break;
+
+    case 2:
+      g_assert_cmpuint (n_params, ==, 0);
+      break;
+    }
+}
+
+static GPProcRunBatch *
+test_proc_run_batch_new (gint n_procs)
+{
+  GPProcRunBatch *proc_run_batch = g_new0 (GPProcRunBatch, 1);
+  gint            i;
+
+  proc_run_batch->n_procs = n_procs;
+  proc_run_batch->procs   = g_new0 (GPProcRun, n_procs);
+
+  for (i = 0; i < n_procs; i++)
+    {
+      GPProcRun *proc_run = &proc_run_batch->procs[i];
+
+      proc_run->name     = g_strdup_printf ("test-%d", i);
+      proc_run->n_params = (i % 3 == 2) ? 0 : 1;
+      proc_run->params   = g_new0 (GPParam, proc_run->n_params);
+
+      if (proc_run->n_params)
+        test_params_init (proc_run->params, i);
+    }
+
+  return proc_run_batch;
+}
+
+static void
+test_proc_run_batch_free (GPProcRunBatch *proc_run_batch)
+{
+  gint i;
+
+  for (i = 0; i < proc_run_batch->n_procs; i++)
+    {
+      GPProcRun *proc_run = &proc_run_batch->procs[i];
+
+      if (proc_run->n_params &&
+          proc_run->params[0].param_type == GP_PARAM_TYPE_STRING)
+        g_free (proc_run->params[0].data.d_string);
+
+      g_free (proc_run->params);
+      g_free (proc_run->name);
+    }
+
+  g_free (proc_run_batch->procs);
+  g_free (proc_run_batch);
+}
+
+/**
+ * proc_run_batch_round_trip:
+ *
+ * A GP_PROC_RUN_BATCH message must be read back with all its calls,
+ * in order, with their arguments, and nothing left on the channel.
+ **/
+static void
+proc_run_batch_round_trip (void)
+{
+  TestChannel      channel;
+  GPProcRunBatch  *proc_run_batch;
+  GPProcRunBatch  *result;
+  GimpWireMessage  msg;
+  gint             i;
+
+  test_channel_init (&channel);
+
+  proc_run_batch = test_proc_run_batch_new (7);
+
+  g_assert_true (gp_proc_run_batch_write (NULL, proc_run_batch, &channel));
+  g_assert_true (gimp_wire_read_msg (NULL, &msg, &channel));
+
+  g_assert_cmpuint (msg.type, ==, GP_PROC_RUN_BATCH);
+  g_assert_nonnull (msg.data);
+  g_assert_cmpuint (channel.pos, ==, channel.bytes->len);
+
+  result = msg.data;
+
+  g_assert_cmpuint (result->n_procs, ==, 7);
+
+  for (i = 0; i < result->n_procs; i++)
+    {
+      g_assert_cmpstr (result->procs[i].name, ==,
+                       proc_run_batch->procs[i].name);
+
+      test_params_check (result->procs[i].params,
+                         result->procs[i].n_params, i);
+    }
+
+  gimp_wire_destroy (&msg);
+  test_proc_run_batch_free (proc_run_batch);
+  test_channel_clear (&channel);
+}
+
+/**
+ * proc_return_batch_round_trip:
+ *
+ * Same as proc_run_batch_round_trip(), for GP_PROC_RETURN_BATCH.
+ **/
+static void
+proc_return_batch_round_trip (void)
+{
+  TestChannel        channel;
+  GPProcRunBatch    *proc_run_batch;
+  GPProcReturnBatch  proc_return_batch;
+  GPProcReturnBatch *result;
+  GimpWireMessage    msg;
+  gint               i;
+
+  test_channel_init (&channel);
+
+  /*  GPProcRun and GPProcReturn have the same members, reuse the
+   *  calls as return values
+   */
+  proc_run_batch = test_proc_run_batch_new (GP_PROC_BATCH_MAX_CALLS);
+
+  proc_return_batch.n_procs = proc_run_batch->n_procs;
+  proc_return_batch.procs   = g_new0 (GPProcReturn, proc_run_batch->n_procs);
+
+  for (i = 0; i < proc_run_batch->n_procs; i++)
+    {
+      proc_return_batch.procs[i].name     = proc_run_batch->procs[i].name;
+      proc_return_batch.procs[i].n_params = proc_run_batch->procs[i].n_params;
+      proc_return_batch.procs[i].params   = proc_run_batch->procs[i].params;
+    }
+
+  g_assert_true (gp_proc_return_batch_write (NULL, &proc_return_batch,
+                                             &channel));
+  g_assert_true (gimp_wire_read_msg (NULL, &msg, &channel));
+
+  g_assert_cmpuint (msg.type, ==, GP_PROC_RETURN_BATCH);
+  g_assert_nonnull (msg.data);
+  g_assert_cmpuint (channel.pos, ==, channel.bytes->len);
+
+  result = msg.data;
+
+  g_assert_cmpuint (result->n_procs, ==, GP_PROC_BATCH_MAX_CALLS);
+
+  for (i = 0; i < result->n_procs; i++)
+    {
+      g_assert_cmpstr (result->procs[i].name, ==,
+                       proc_run_batch->procs[i].name);
+
+      test_params_check (result->procs[i].params,
+                         result->procs[i].n_params, i);
+    }
+
+  gimp_wire_destroy (&msg);
+  g_free (proc_return_batch.procs);
+  test_proc_run_batch_free (proc_run_batch);
+  test_channel_clear (&channel);
+}
+
+/**
+ * proc_run_batch_empty:
+ *
+ * An empty batch is a valid message.
+ **/
+static void
+proc_run_batch_empty (void)
+{
+  TestChannel      channel;
+  GPProcRunBatch   proc_run_batch = { 0, NULL };
+  GimpWireMessage  msg;
+
+  test_channel_init (&channel);
+
+  g_assert_true (gp_proc_run_batch_write (NULL, &proc_run_batch, &channel));
+  g_assert_true (gimp_wire_read_msg (NULL, &msg, &channel));
+
+  g_assert_cmpuint (msg.type, ==, GP_PROC_RUN_BATCH);
+  g_assert_nonnull (msg.data);
+  g_assert_cmpuint (((GPProcRunBatch *) msg.data)->n_procs, ==, 0);
+  g_assert_cmpuint (channel.pos, ==, channel.bytes->len);
+
+  gimp_wire_destroy (&msg);
+  test_channel_clear (&channel);
+}
+
+/**
+ * proc_run_batch_too_many_calls:
+ *
+ * A batch of more than GP_PROC_BATCH_MAX_CALLS calls must be read as a
+ * NULL message, which makes the core close the plug-in.
+ **/
+static void
+proc_run_batch_too_many_calls (void)
+{
+  TestChannel      channel;
+  GPProcRunBatch  *proc_run_batch;
+  GimpWireMessage  msg;
+
+  test_channel_init (&channel);
+
+  proc_run_batch = test_proc_run_batch_new (GP_PROC_BATCH_MAX_CALLS + 1);
+
+  g_assert_true (gp_proc_run_batch_write (NULL, proc_run_batch, &channel));
+  gimp_wire_read_msg (NULL, &msg, &channel);
+
+  g_assert_cmpuint (msg.type, ==, GP_PROC_RUN_BATCH);
+  g_assert_null (msg.data);
+
+  test_proc_run_batch_free (proc_run_batch);
+  test_channel_clear (&channel);
+}
+
+/**
+ * proc_run_batch_truncated:
+ *
+ * A batch cut short anywhere must fail to read, and be read as a
+ * NULL message.
+ **/
+static void
+proc_run_batch_truncated (void)
+{
+  TestChannel     channel;
+  GPProcRunBatch *proc_run_batch;
+  GByteArray     *message;
+  guint           i;
+
+  test_channel_init (&channel);
+
+  proc_run_batch = test_proc_run_batch_new (4);
+
+  g_assert_true (gp_proc_run_batch_write (NULL, proc_run_batch, &channel));
+
+  message = channel.bytes;
+
+  /*  Skip truncating the message type only, the wire would fail on it
+   *  before reaching the batch reader
+   */
+  for (i = 4; i < message->len; i++)
+    {
+      GimpWireMessage msg;
+
+      channel.bytes = g_byte_array_new ();
+      channel.pos   = 0;
+
+      g_byte_array_append (channel.bytes, message->data, i);
+
+      g_assert_false (gimp_wire_read_msg (NULL, &msg, &channel));
+      g_assert_null (msg.data);
+
+      test_channel_clear (&channel);
+    }
+
+  channel.bytes = message;
+
+  test_proc_run_batch_free (proc_run_batch);
+  test_channel_clear (&channel);
+}
+
+/**
+ * buffer_map_req_round_trip:
+ *
+ * A GP_BUFFER_MAP_REQ message must be read back unchanged.
+ **/
+static void
+buffer_map_req_round_trip (void)
+{
+  TestChannel      channel;
+  GPBufferMapReq   buffer_map_req = { 42, TRUE };
+  GPBufferMapReq  *result;
+  GimpWireMessage  msg;
+
+  test_channel_init (&channel);
+
+  g_assert_true (gp_buffer_map_req_write (NULL, &buffer_map_req, &channel));
+  g_assert_true (gimp_wire_read_msg (NULL, &msg, &channel));
+
+  g_assert_cmpuint (msg.type, ==, GP_BUFFER_MAP_REQ);
+  g_assert_nonnull (msg.data);
+  g_assert_cmpuint (channel.pos, ==, channel.bytes->len);
+
+  result = msg.data;
+
+  g_assert_cmpint (result->drawable_id, ==, 42);
+  g_assert_cmpuint (result->shadow, ==, TRUE);
+
+  gimp_wire_destroy (&msg);
+  test_channel_clear (&channel);
+}
+
+/**
+ * buffer_map_data_round_trip:
+ *
+ * A GP_BUFFER_MAP_DATA message must be read back unchanged, both for
+ * a mapped buffer and for a refused mapping, which has no segment
+ * name.
+ **/
+static void
+buffer_map_data_round_trip (void)
+{
+  GPBufferMapData buffer_map_data[] =
+  {
+    { 42, FALSE,  7, (gchar *) "/gimp-shm-1234-7", 640, 480,  4 },
+    { 43, TRUE,  -1, NULL,                         640, 480, 16 }
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (buffer_map_data); i++)
+    {
+      TestChannel      channel;
+      GPBufferMapData *result;
+      GimpWireMessage  msg;
+
+      test_channel_init (&channel);
+
+      g_assert_true (gp_buffer_map_data_write (NULL, &buffer_map_data[i],
+                                               &channel));
+      g_assert_true (gimp_wire_read_msg (NULL, &msg, &channel));
+
+      g_assert_cmpuint (msg.type, ==, GP_BUFFER_MAP_DATA);
+      g_assert_nonnull (msg.data);
+      g_assert_cmpuint (channel.pos, ==, channel.bytes->len);
+
+      result = msg.data;
+
+      g_assert_cmpint (result->drawable_id, ==, buffer_map_data[i].drawable_id);
+      g_assert_cmpuint (result->shadow, ==, buffer_map_data[i].shadow);
+      g_assert_cmpint (result->map_id, ==, buffer_map_data[i].map_id);
+      g_assert_cmpstr (result->map_name, ==, buffer_map_data[i].map_name);
+      g_assert_cmpuint (result->width, ==, buffer_map_data[i].width);
+      g_assert_cmpuint (result->height, ==, buffer_map_data[i].height);
+      g_assert_cmpuint (result->bpp, ==, buffer_map_data[i].bpp);
+
+      gimp_wire_destroy (&msg);
+      test_channel_clear (&channel);
+    }
+}
+
+/**
+ * buffer_unmap_round_trip:
+ *
+ * A GP_BUFFER_UNMAP message must be read back unchanged, including
+ * an empty area, which releases a mapping without writing back.
+ **/
+static void
+buffer_unmap_round_trip (void)
+{
+  GPBufferUnmap buffer_unmap[] =
+  {
+    { 7, 10, 20, 300, 200 },
+    { 8,  0,  0,   0,   0 }
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (buffer_unmap); i++)
+    {
+      TestChannel      channel;
+      GPBufferUnmap   *result;
+      GimpWireMessage  msg;
+
+      test_channel_init (&channel);
+
+      g_assert_true (gp_buffer_unmap_write (NULL, &buffer_unmap[i],
+                                            &channel));
+      g_assert_true (gimp_wire_read_msg (NULL, &msg, &channel));
+
+      g_assert_cmpuint (msg.type, ==, GP_BUFFER_UNMAP);
+      g_assert_nonnull (msg.data);
+      g_assert_cmpuint (channel.pos, ==, channel.bytes->len);
+
+      result = msg.data;
+
+      g_assert_cmpint (result->map_id, ==, buffer_unmap[i].map_id);
+      g_assert_cmpuint (result->x, ==, buffer_unmap[i].x);
+      g_assert_cmpuint (result->y, ==, buffer_unmap[i].y);
+      g_assert_cmpuint (result->width, ==, buffer_unmap[i].width);
+      g_assert_cmpuint (result->height, ==, buffer_unmap[i].height);
+
+      gimp_wire_destroy (&msg);
+      test_channel_clear (&channel);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  gp_init ();
+
+  gimp_wire_set_reader (test_channel_read);
+  gimp_wire_set_writer (test_channel_write);
+  gimp_wire_set_flusher (test_channel_flush);
+
+  ADD_TEST (proc_run_batch_round_trip);
+  ADD_TEST (proc_return_batch_round_trip);
+  ADD_TEST (proc_run_batch_empty);
+  ADD_TEST (proc_run_batch_too_many_calls);
+  ADD_TEST (proc_run_batch_truncated);
+  ADD_TEST (buffer_map_req_round_trip);
+  ADD_TEST (buffer_map_data_round_trip);
+  ADD_TEST (buffer_unmap_round_trip);
+
+  return g_test_run ();
+}
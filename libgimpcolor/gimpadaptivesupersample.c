@@ -256,6 +256,12 @@ gimp_render_sub_pixel (gint             max_depth,
  * @progress_func:  (scope call): function to report progress.
  * @progress_data:  user data passed to @progress_func.
  *
+ * Samples are only shared between neighboring pixels of the same area,
+ * and all the state is local to the call, so an area can be split into
+ * blocks which are supersampled independently, possibly from several
+ * threads at once, giving the same result as long as @render_func
+ * always renders the same color at the same coordinates.
+ *
  * Returns: the number of pixels processed.
  **/
 gulong
@@ -41,6 +41,10 @@
 #include "libgimp/libgimp-intl.h"
 
 
+#define PIXELS_PER_THREAD (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
+#define PIXELS_PER_CHUNK  (1024 * 1024)
+
+
 /**
  * SECTION: gimpcolortransform
  * @title: GimpColorTransform
@@ -78,7 +82,22 @@ struct _GimpColorTransformPrivate
 };
 
 
-static void   gimp_color_transform_finalize (GObject *object);
+typedef struct
+{
+  GimpColorTransform  *transform;
+  GeglBuffer          *src_buffer;
+  const Babl          *src_format;
+  GeglBuffer          *dest_buffer;
+  const Babl          *dest_format;
+  gint                 dest_offset_x;
+  gint                 dest_offset_y;
+} ProcessBufferData;
+
+
+static void   gimp_color_transform_finalize     (GObject             *object);
+
+static void   gimp_color_transform_process_area (const GeglRectangle *area,
+                                                 ProcessBufferData   *data);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpColorTransform, gimp_color_transform,
@@ -263,10 +282,15 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
 
   lcms_error_clear ();
 
+  /* cmsFLAGS_NOCACHE drops lcms' single pixel cache, which is the
+   * only thing keeping a transform from being used by several threads
+   * at once, see gimp_color_transform_process_buffer()
+   */
   priv->transform = cmsCreateTransform (src_lcms,  lcms_src_format,
                                         dest_lcms, lcms_dest_format,
                                         rendering_intent,
                                         flags |
+                                        cmsFLAGS_NOCACHE |
                                         cmsFLAGS_COPY_ALPHA);
 
   if (lcms_last_error)
@@ -361,6 +385,7 @@ gimp_color_transform_new_proofing (GimpColorProfile         *src_profile,
                                                 proof_intent,
                                                 flags                 |
                                                 cmsFLAGS_SOFTPROOFING |
+                                                cmsFLAGS_NOCACHE      |
                                                 cmsFLAGS_COPY_ALPHA);
 
   if (lcms_last_error)
@@ -504,9 +529,10 @@ gimp_color_transform_process_buffer (GimpColorTransform  *transform,
                                      const GeglRectangle *dest_rect)
 {
   GimpColorTransformPrivate *priv;
-  const Babl                *src_format;
-  const Babl                *dest_format;
-  GeglBufferIterator        *iter;
+  ProcessBufferData          data;
+  GeglRectangle              src_area;
+  GeglRectangle              chunk;
+  gint                       chunk_height;
   gint                       total_pixels;
   gint                       done_pixels = 0;
 
@@ -516,89 +542,63 @@ gimp_color_transform_process_buffer (GimpColorTransform  *transform,
 
   priv = transform->priv;
 
-  if (src_rect)
-    {
-      total_pixels = src_rect->width * src_rect->height;
-    }
-  else
+  if (! src_rect)
+    src_rect = gegl_buffer_get_extent (src_buffer);
+
+  if (! dest_rect)
+    dest_rect = gegl_buffer_get_extent (dest_buffer);
+
+  src_area     = *src_rect;
+  total_pixels = src_area.width * src_area.height;
+
+  if (total_pixels <= 0)
     {
-      total_pixels = (gegl_buffer_get_width  (src_buffer) *
-                      gegl_buffer_get_height (src_buffer));
+      g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
+                     1.0);
+      return;
     }
 
+  data.transform     = transform;
+  data.src_buffer    = src_buffer;
+  data.dest_buffer   = dest_buffer;
+  data.dest_offset_x = dest_rect->x - src_rect->x;
+  data.dest_offset_y = dest_rect->y - src_rect->y;
+
   /* we must not do any babl color transforms when reading from
    * src_buffer or writing to dest_buffer, so construct formats with
    * the transform's expected input and output encoding and
    * src_buffer's and dest_buffers's color spaces.
    */
-  src_format  = gegl_buffer_get_format (src_buffer);
-  dest_format = gegl_buffer_get_format (dest_buffer);
-
-  src_format =
+  data.src_format =
     babl_format_with_space ((const gchar *) priv->src_format,
-                            babl_format_get_space (src_format));
-  dest_format =
+                            babl_format_get_space (gegl_buffer_get_format (src_buffer)));
+  data.dest_format =
     babl_format_with_space ((const gchar *) priv->dest_format,
-                            babl_format_get_space (dest_format));
+                            babl_format_get_space (gegl_buffer_get_format (dest_buffer)));
 
-  if (src_buffer != dest_buffer)
-    {
-      iter = gegl_buffer_iterator_new (src_buffer, src_rect, 0,
-                                       src_format,
-                                       GEGL_ACCESS_READ,
-                                       GEGL_ABYSS_NONE, 2);
-
-      gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                                dest_format,
-                                GEGL_ACCESS_WRITE,
-                                GEGL_ABYSS_NONE);
-
-      while (gegl_buffer_iterator_next (iter))
-        {
-          if (priv->transform)
-            {
-              cmsDoTransform (priv->transform,
-                              iter->items[0].data, iter->items[1].data, iter->length);
-            }
-          else
-            {
-              babl_process (priv->fish,
-                            iter->items[0].data, iter->items[1].data, iter->length);
-            }
-
-          done_pixels += iter->items[0].roi.width * iter->items[0].roi.height;
+  /* process the area in chunks of rows, each distributed across
+   * threads, so "progress" is still emitted regularly and only from
+   * the calling thread
+   */
+  chunk_height = MAX (PIXELS_PER_CHUNK / src_area.width, 1);
 
-          g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
-                         (gdouble) done_pixels /
-                         (gdouble) total_pixels);
-        }
-    }
-  else
+  for (chunk = src_area;
+       chunk.y < src_area.y + src_area.height;
+       chunk.y += chunk.height)
     {
-      iter = gegl_buffer_iterator_new (src_buffer, src_rect, 0,
-                                       src_format,
-                                       GEGL_ACCESS_READWRITE,
-                                       GEGL_ABYSS_NONE, 1);
+      chunk.height = MIN (chunk_height,
+                          src_area.y + src_area.height - chunk.y);
 
-      while (gegl_buffer_iterator_next (iter))
-        {
-          if (priv->transform)
-            {
-              cmsDoTransform (priv->transform,
-                              iter->items[0].data, iter->items[0].data, iter->length);
-            }
-          else
-            {
-              babl_process (priv->fish,
-                            iter->items[0].data, iter->items[0].data, iter->length);
-            }
+      gegl_parallel_distribute_area (
+        &chunk, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) gimp_color_transform_process_area,
+        &data);
 
-          done_pixels += iter->items[0].roi.width * iter->items[0].roi.height;
+      done_pixels += chunk.width * chunk.height;
 
-          g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
-                         (gdouble) done_pixels /
-                         (gdouble) total_pixels);
-        }
+      g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
+                     (gdouble) done_pixels /
+                     (gdouble) total_pixels);
     }
 
   g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
@@ -640,3 +640,67 @@ gimp_color_transform_can_gegl_copy (GimpColorProfile *src_profile,
 
   return FALSE;
 }
+
+
+/*  private functions  */
+
+static void
+gimp_color_transform_process_area (const GeglRectangle *area,
+                                   ProcessBufferData   *data)
+{
+  GimpColorTransformPrivate *priv = data->transform->priv;
+  GeglBufferIterator        *iter;
+  GeglRectangle              dest_area;
+
+  dest_area    = *area;
+  dest_area.x += data->dest_offset_x;
+  dest_area.y += data->dest_offset_y;
+
+  if (data->src_buffer != data->dest_buffer)
+    {
+      iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                       data->src_format,
+                                       GEGL_ACCESS_READ,
+                                       GEGL_ABYSS_NONE, 2);
+
+      gegl_buffer_iterator_add (iter, data->dest_buffer, &dest_area, 0,
+                                data->dest_format,
+                                GEGL_ACCESS_WRITE,
+                                GEGL_ABYSS_NONE);
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          if (priv->transform)
+            {
+              cmsDoTransform (priv->transform,
+                              iter->items[0].data, iter->items[1].data, iter->length);
+            }
+          else
+            {
+              babl_process (priv->fish,
+                            iter->items[0].data, iter->items[1].data, iter->length);
+            }
+        }
+    }
+  else
+    {
+      iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                       data->src_format,
+                                       GEGL_ACCESS_READWRITE,
+                                       GEGL_ABYSS_NONE, 1);
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          if (priv->transform)
+            {
+              cmsDoTransform (priv->transform,
+                              iter->items[0].data, iter->items[0].data, iter->length);
+            }
+          else
+            {
+              babl_process (priv->fish,
+                            iter->items[0].data, iter->items[0].data, iter->length);
+            }
+        }
+    }
+}
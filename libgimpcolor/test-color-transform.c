@@ -0,0 +1,143 @@
+/* benchmark for gimp_color_transform_process_buffer(), prints its
+ * throughput for an increasing number of GEGL threads
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include <babl/babl.h>
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <glib-object.h>
+#include <cairo.h>
+
+#include "gimpcolor.h"
+
+
+#define WIDTH  4096
+#define HEIGHT 4096
+#define RUNS   3
+
+
+static GeglBuffer *
+create_buffer (const Babl *format)
+{
+  GeglBuffer         *buffer;
+  GeglBufferIterator *iter;
+  GRand              *rand = g_rand_new_with_seed (42);
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+
+  iter = gegl_buffer_iterator_new (buffer, NULL, 0, NULL,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      guint16 *data = iter->items[0].data;
+      gint     i;
+
+      for (i = 0; i < iter->length * 4; i++)
+        data[i] = g_rand_int_range (rand, 0, 65536);
+    }
+
+  g_rand_free (rand);
+
+  return buffer;
+}
+
+static gdouble
+time_transform (GimpColorTransform *transform,
+                GeglBuffer         *src_buffer,
+                GeglBuffer         *dest_buffer)
+{
+  gdouble best = G_MAXDOUBLE;
+  gint    i;
+
+  for (i = 0; i < RUNS; i++)
+    {
+      gint64 start = g_get_monotonic_time ();
+
+      gimp_color_transform_process_buffer (transform,
+                                           src_buffer,  NULL,
+                                           dest_buffer, NULL);
+
+      best = MIN (best, (g_get_monotonic_time () - start) / 1000000.0);
+    }
+
+  return best;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GimpColorProfile   *src_profile;
+  GimpColorProfile   *dest_profile;
+  GimpColorTransform *transform;
+  const Babl         *format;
+  GeglBuffer         *src_buffer;
+  GeglBuffer         *dest_buffer;
+  gint                max_threads;
+  gint                n_threads;
+  gdouble             base_time = 0.0;
+
+  /* benchmark the lcms code path, babl transforms are parallel
+   * anyway
+   */
+  g_setenv ("GIMP_COLOR_TRANSFORM_DISABLE_BABL", "1", TRUE);
+
+  gegl_init (&argc, &argv);
+
+  format = babl_format ("R'G'B'A u16");
+
+  src_profile  = gimp_color_profile_new_rgb_srgb ();
+  dest_profile = gimp_color_profile_new_rgb_adobe ();
+
+  transform = gimp_color_transform_new (src_profile,  format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        GIMP_COLOR_TRANSFORM_FLAGS_NOOPTIMIZE);
+  if (! transform)
+    {
+      g_printerr ("Could not create color transform\n");
+      return EXIT_FAILURE;
+    }
+
+  src_buffer  = create_buffer (format);
+  dest_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+
+  g_object_get (gegl_config (), "threads", &max_threads, NULL);
+  max_threads = MAX (max_threads, g_get_num_processors ());
+
+  g_print ("\nTransforming %dx%d u16 pixels, sRGB -> AdobeRGB (lcms)\n",
+           WIDTH, HEIGHT);
+
+  for (n_threads = 1; n_threads <= max_threads; n_threads *= 2)
+    {
+      gdouble elapsed;
+
+      g_object_set (gegl_config (), "threads", n_threads, NULL);
+
+      elapsed = time_transform (transform, src_buffer, dest_buffer);
+
+      if (n_threads == 1)
+        base_time = elapsed;
+
+      g_print ("  %2d thread(s): %7.3f s  %8.2f Mpixels/s  speedup %.2fx\n",
+               n_threads, elapsed,
+               (gdouble) WIDTH * HEIGHT / elapsed / 1000000.0,
+               base_time / elapsed);
+    }
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
+  g_object_unref (transform);
+  g_object_unref (src_profile);
+  g_object_unref (dest_profile);
+
+  gegl_exit ();
+
+  return EXIT_SUCCESS;
+}
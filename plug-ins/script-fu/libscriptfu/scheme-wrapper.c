@@ -77,6 +77,8 @@ static pointer  script_fu_register_call_filter              (scheme    *sc,
                                                              pointer    a);
 static pointer  script_fu_menu_register_call                (scheme    *sc,
                                                              pointer    a);
+static pointer  script_fu_cached_file_call                  (scheme    *sc,
+                                                             pointer    a);
 static pointer  script_fu_quit_call                         (scheme    *sc,
                                                              pointer    a);
 static pointer  script_fu_nil_call                          (scheme    *sc,
@@ -85,6 +87,11 @@ static pointer  script_fu_nil_call                          (scheme    *sc,
 static gboolean ts_load_file                                (const gchar *dirname,
                                                              const gchar *basename);
 
+static void     ts_foreach_global                           (void (* func) (const gchar *name,
+                                                                            pointer      value,
+                                                                            gpointer     data),
+                                                             gpointer   data);
+
 typedef struct
 {
   const gchar *name;
@@ -176,6 +183,9 @@ static const NamedConstant script_constants[] =
 
 static scheme sc;
 
+/* Whether script-fu-register and friends register scripts. */
+static gboolean register_scripts_enabled = FALSE;
+
 /*
  * These callbacks break the backwards compile-time dependence
  * of inner scheme-wrapper on the outer script-fu-server.
@@ -222,6 +232,8 @@ tinyscheme_init (GList    *path,
   ts_init_constants (&sc, repo);
   ts_init_procedures (&sc, register_scripts);
 
+  register_scripts_enabled = register_scripts;
+
   if (path)
     {
       GList *list;
@@ -259,6 +271,103 @@ tinyscheme_init (GList    *path,
     g_warning ("Not loading initialization or compatibility scripts.");
 }
 
+/*
+ * Return whether loaded scripts register PDB procedures,
+ * as given to tinyscheme_init.
+ */
+gboolean
+ts_get_register_scripts (void)
+{
+  return register_scripts_enabled;
+}
+
+static void
+ts_add_global_binding (const gchar *name,
+                       pointer      value,
+                       gpointer     data)
+{
+  g_hash_table_insert (data, (gpointer) name, value);
+}
+
+/*
+ * Return a table of the variables of the global environment,
+ * mapping each name to its value, to be compared later to the global
+ * environment with ts_get_new_procedures().
+ *
+ * The names belong to the interpreter's symbols.
+ */
+GHashTable *
+ts_get_global_bindings (void)
+{
+  GHashTable *bindings = g_hash_table_new (g_str_hash, g_str_equal);
+
+  ts_foreach_global (ts_add_global_binding, bindings);
+
+  return bindings;
+}
+
+typedef struct
+{
+  GHashTable *bindings;
+  GPtrArray  *names;
+  gboolean    only_procedures;
+} NewProcedures;
+
+static void
+ts_add_new_procedure (const gchar *name,
+                      pointer      value,
+                      gpointer     data)
+{
+  NewProcedures *new_procedures = data;
+  gpointer       old_value;
+
+  if (g_hash_table_lookup_extended (new_procedures->bindings, name,
+                                    NULL, &old_value))
+    {
+      if (old_value != value)
+        new_procedures->only_procedures = FALSE;
+    }
+  else if (sc.vptr->is_closure (value))
+    {
+      g_ptr_array_add (new_procedures->names, g_strdup (name));
+    }
+  else
+    {
+      new_procedures->only_procedures = FALSE;
+    }
+}
+
+/*
+ * Return the names of the procedures defined in the global environment
+ * since bindings were returned by ts_get_global_bindings(),
+ * as a NULL-terminated array the caller owns.
+ *
+ * Return NULL if other variables were defined, or existing variables
+ * changed, in the meantime.
+ */
+gchar **
+ts_get_new_procedures (GHashTable *bindings)
+{
+  NewProcedures new_procedures;
+
+  new_procedures.bindings        = bindings;
+  new_procedures.names           = g_ptr_array_new_with_free_func (g_free);
+  new_procedures.only_procedures = TRUE;
+
+  ts_foreach_global (ts_add_new_procedure, &new_procedures);
+
+  if (! new_procedures.only_procedures)
+    {
+      g_ptr_array_free (new_procedures.names, TRUE);
+
+      return NULL;
+    }
+
+  g_ptr_array_add (new_procedures.names, NULL);
+
+  return (gchar **) g_ptr_array_free (new_procedures.names, FALSE);
+}
+
 /* Create an SF-RUN-MODE constant for use in scripts.
  * It is set to the run mode state determined by GIMP.
  */
@@ -556,6 +665,7 @@ ts_define_procedure (sc, "load-extension", scm_load_ext);
       ts_define_procedure (sc, "script-fu-register",        script_fu_register_call);
       ts_define_procedure (sc, "script-fu-register-filter", script_fu_register_call_filter);
       ts_define_procedure (sc, "script-fu-menu-register",   script_fu_menu_register_call);
+      ts_define_procedure (sc, "script-fu-cached-file",     script_fu_cached_file_call);
     }
   else
     {
@@ -630,6 +740,43 @@ ts_load_file (const gchar *dirname,
   return FALSE;
 }
 
+/* Call func for each variable of the global environment.
+ *
+ * The global frame is a vector of lists of slots hashed by name,
+ * each slot a pair of the variable's symbol and value.
+ */
+static void
+ts_foreach_global (void (* func) (const gchar *name,
+                                  pointer      value,
+                                  gpointer     data),
+                   gpointer  data)
+{
+  pointer frame = sc.vptr->pair_car (sc.global_env);
+  glong   n_buckets;
+  glong   i;
+
+  n_buckets = sc.vptr->is_vector (frame) ? sc.vptr->vector_length (frame) : 1;
+
+  for (i = 0; i < n_buckets; i++)
+    {
+      pointer slots;
+
+      if (sc.vptr->is_vector (frame))
+        slots = sc.vptr->vector_elem (frame, i);
+      else
+        slots = frame;
+
+      for (; slots != sc.NIL; slots = sc.vptr->pair_cdr (slots))
+        {
+          pointer slot = sc.vptr->pair_car (slots);
+
+          func (sc.vptr->symname (sc.vptr->pair_car (slot)),
+                sc.vptr->pair_cdr (slot),
+                data);
+        }
+    }
+}
+
 /* Called by the Scheme interpreter on calls to GIMP PDB procedures */
 static pointer
 script_fu_marshal_procedure_call (scheme   *sc,
@@ -1738,6 +1885,13 @@ script_fu_menu_register_call (scheme  *sc,
   return script_fu_add_menu (sc, a);
 }
 
+static pointer
+script_fu_cached_file_call (scheme  *sc,
+                            pointer  a)
+{
+  return script_fu_get_cached_file (sc, a);
+}
+
 static pointer
 script_fu_quit_call (scheme  *sc,
                      pointer  a)
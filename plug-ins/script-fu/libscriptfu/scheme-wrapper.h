@@ -27,6 +27,11 @@ typedef pointer (*TsWrapperFunc) (scheme*, pointer);
 void          tinyscheme_init         (GList        *path,
                                        gboolean      register_scripts);
 
+gboolean      ts_get_register_scripts (void);
+
+GHashTable  * ts_get_global_bindings  (void);
+gchar      ** ts_get_new_procedures   (GHashTable   *bindings);
+
 void          ts_set_run_mode         (GimpRunMode   run_mode);
 
 void          ts_set_print_flag       (gint          print_flag);
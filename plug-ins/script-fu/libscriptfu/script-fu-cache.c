@@ -0,0 +1,1040 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include <libgimp/gimp.h>
+
+#include "script-fu-types.h"
+#include "script-fu-arg.h"
+#include "script-fu-script.h"
+#include "script-fu-cache.h"
+
+
+/*
+ * A cache of what the .scm files register, i.e. the SFScript and SFMenu
+ * their calls to script-fu-register, script-fu-register-filter and
+ * script-fu-menu-register create, and of the names of the procedures
+ * they define.
+ *
+ * Entries are keyed on the path, modification time and size of a file.
+ * When a file is unchanged, its scripts are created from the cache,
+ * without the interpreter evaluating the file.
+ *
+ * Registration evaluates translated strings, so the cache is only valid
+ * for the languages it was written with.  It is also discarded when
+ * GIMP's version changes.
+ *
+ * The cache is a GKeyFile in GIMP's cache directory, with one group
+ * per .scm file.
+ */
+
+
+#define SCRIPT_FU_CACHE_VERSION  2
+#define SCRIPT_FU_CACHE_HEADER   "Script-Fu Cache"
+
+
+struct _SFCache
+{
+  gchar      *filename;
+  GKeyFile   *key_file;
+  GHashTable *visited;   /* groups looked up or inserted by this session */
+  gboolean    dirty;
+};
+
+
+/*
+ *  Local Functions
+ */
+
+static gchar    * script_fu_cache_get_languages  (void);
+static gboolean   script_fu_cache_header_valid   (GKeyFile     *key_file);
+static void       script_fu_cache_set_header     (GKeyFile     *key_file);
+
+static gchar    * script_fu_cache_get_group      (GFile        *file);
+static gboolean   script_fu_cache_info_matches   (SFCache      *cache,
+                                                  const gchar  *group,
+                                                  GFileInfo    *info);
+
+static SFScript * script_fu_cache_read_script    (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  gint          index,
+                                                  GError      **error);
+static void       script_fu_cache_read_arg       (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  const gchar  *prefix,
+                                                  SFArg        *arg,
+                                                  GError      **error);
+static void       script_fu_cache_write_script   (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  gint          index,
+                                                  SFScript     *script);
+static void       script_fu_cache_write_arg      (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  const gchar  *prefix,
+                                                  SFArg        *arg);
+
+static gchar    * script_fu_cache_get_string     (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  const gchar  *prefix,
+                                                  const gchar  *name,
+                                                  GError      **error);
+static gint       script_fu_cache_get_integer    (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  const gchar  *prefix,
+                                                  const gchar  *name,
+                                                  GError      **error);
+static gdouble  * script_fu_cache_get_doubles    (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  const gchar  *prefix,
+                                                  const gchar  *name,
+                                                  gsize         length,
+                                                  GError      **error);
+static gchar   ** script_fu_cache_get_strings    (GKeyFile     *key_file,
+                                                  const gchar  *group,
+                                                  const gchar  *prefix,
+                                                  const gchar  *name,
+                                                  GError      **error);
+
+
+/*
+ *  Function definitions
+ */
+
+/* Return the cache as it was last saved, or an empty cache
+ * if there is none or it is not valid for this session.
+ */
+SFCache *
+script_fu_cache_new (void)
+{
+  SFCache *cache = g_slice_new0 (SFCache);
+
+  cache->filename = g_build_filename (gimp_cache_directory (),
+                                      "script-fu-cache", NULL);
+  cache->key_file = g_key_file_new ();
+  cache->visited  = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, NULL);
+
+  if (! g_key_file_load_from_file (cache->key_file, cache->filename,
+                                   G_KEY_FILE_NONE, NULL) ||
+      ! script_fu_cache_header_valid (cache->key_file))
+    {
+      g_debug ("script_fu_cache_new: starting with an empty cache");
+
+      g_key_file_free (cache->key_file);
+      cache->key_file = g_key_file_new ();
+
+      script_fu_cache_set_header (cache->key_file);
+
+      cache->dirty = TRUE;
+    }
+
+  return cache;
+}
+
+void
+script_fu_cache_free (SFCache *cache)
+{
+  g_return_if_fail (cache != NULL);
+
+  g_free (cache->filename);
+  g_key_file_free (cache->key_file);
+  g_hash_table_unref (cache->visited);
+
+  g_slice_free (SFCache, cache);
+}
+
+/* Look up the scripts registered by file, as described by info.
+ *
+ * When the cache has an entry for the same path, modification time
+ * and size, return TRUE, and return in scripts new SFScript, in
+ * menus new SFMenu referring to them, and in procedures the
+ * NULL-terminated names of the procedures the file defines.
+ * Caller owns all three.
+ *
+ * Otherwise return FALSE.
+ */
+gboolean
+script_fu_cache_lookup (SFCache    *cache,
+                        GFile      *file,
+                        GFileInfo  *info,
+                        GList     **scripts,
+                        GList     **menus,
+                        gchar    ***procedures)
+{
+  gchar   *group;
+  GError  *error       = NULL;
+  GList   *new_scripts = NULL;
+  GList   *new_menus   = NULL;
+  gint    *menu_scripts;
+  gchar  **menu_paths;
+  gchar  **new_procedures = NULL;
+  gsize    n_menu_scripts = 0;
+  gsize    n_menu_paths   = 0;
+  gint     n_scripts;
+  gint     i;
+
+  g_return_val_if_fail (cache != NULL, FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
+  g_return_val_if_fail (scripts != NULL && menus != NULL, FALSE);
+  g_return_val_if_fail (procedures != NULL, FALSE);
+
+  group = script_fu_cache_get_group (file);
+
+  if (! group)
+    return FALSE;
+
+  if (! script_fu_cache_info_matches (cache, group, info))
+    {
+      g_free (group);
+      return FALSE;
+    }
+
+  n_scripts = g_key_file_get_integer (cache->key_file, group,
+                                      "n-scripts", &error);
+
+  for (i = 0; i < n_scripts && ! error; i++)
+    {
+      SFScript *script = script_fu_cache_read_script (cache->key_file, group,
+                                                      i, &error);
+
+      if (script)
+        new_scripts = g_list_append (new_scripts, script);
+    }
+
+  menu_scripts = NULL;
+  menu_paths   = NULL;
+
+  if (! error)
+    menu_scripts = g_key_file_get_integer_list (cache->key_file, group,
+                                                "menu-scripts",
+                                                &n_menu_scripts, &error);
+  if (! error)
+    menu_paths = g_key_file_get_string_list (cache->key_file, group,
+                                             "menu-paths",
+                                             &n_menu_paths, &error);
+
+  if (! error && n_menu_scripts != n_menu_paths)
+    g_set_error_literal (&error, G_KEY_FILE_ERROR,
+                         G_KEY_FILE_ERROR_INVALID_VALUE,
+                         "number of menu scripts and paths differ");
+
+  for (i = 0; ! error && i < n_menu_scripts; i++)
+    {
+      SFMenu *menu;
+
+      if (menu_scripts[i] < 0 || menu_scripts[i] >= n_scripts)
+        {
+          g_set_error_literal (&error, G_KEY_FILE_ERROR,
+                               G_KEY_FILE_ERROR_INVALID_VALUE,
+                               "menu refers to an unknown script");
+          break;
+        }
+
+      menu = g_slice_new0 (SFMenu);
+
+      menu->script    = g_list_nth_data (new_scripts, menu_scripts[i]);
+      menu->menu_path = g_strdup (menu_paths[i]);
+
+      new_menus = g_list_prepend (new_menus, menu);
+    }
+
+  g_free (menu_scripts);
+  g_strfreev (menu_paths);
+
+  if (! error)
+    new_procedures = g_key_file_get_string_list (cache->key_file, group,
+                                                 "procedures", NULL, &error);
+
+  if (error)
+    {
+      g_debug ("script_fu_cache_lookup: invalid entry for %s: %s",
+               group, error->message);
+
+      g_clear_error (&error);
+
+      while (new_menus)
+        {
+          SFMenu *menu = new_menus->data;
+
+          g_free (menu->menu_path);
+          g_slice_free (SFMenu, menu);
+
+          new_menus = g_list_delete_link (new_menus, new_menus);
+        }
+
+      g_list_free_full (new_scripts, (GDestroyNotify) script_fu_script_free);
+
+      g_key_file_remove_group (cache->key_file, group, NULL);
+      cache->dirty = TRUE;
+
+      g_free (group);
+
+      return FALSE;
+    }
+
+  g_hash_table_add (cache->visited, group);
+
+  *scripts    = new_scripts;
+  *menus      = g_list_reverse (new_menus);
+  *procedures = new_procedures;
+
+  return TRUE;
+}
+
+/* Insert, or replace, the entry for file, as described by info,
+ * which registered scripts and menus, and defined the NULL-terminated
+ * procedures.
+ *
+ * Menus must all refer to one of scripts, otherwise the file
+ * registers menus for scripts it doesn't own, and is not cached.
+ */
+void
+script_fu_cache_insert (SFCache   *cache,
+                        GFile     *file,
+                        GFileInfo *info,
+                        GList     *scripts,
+                        GList     *menus,
+                        gchar    **procedures)
+{
+  gchar  *group;
+  gint   *menu_scripts;
+  gchar **menu_paths;
+  gint    n_menus;
+  GList  *list;
+  gint    i;
+
+  g_return_if_fail (cache != NULL);
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (G_IS_FILE_INFO (info));
+  g_return_if_fail (procedures != NULL);
+
+  group = script_fu_cache_get_group (file);
+
+  if (! group)
+    return;
+
+  if (g_key_file_has_group (cache->key_file, group))
+    {
+      g_key_file_remove_group (cache->key_file, group, NULL);
+      cache->dirty = TRUE;
+    }
+
+  n_menus      = g_list_length (menus);
+  menu_scripts = g_new (gint,    n_menus);
+  menu_paths   = g_new0 (gchar *, n_menus + 1);
+
+  for (list = menus, i = 0; list; list = g_list_next (list), i++)
+    {
+      SFMenu *menu = list->data;
+
+      menu_scripts[i] = g_list_index (scripts, menu->script);
+      menu_paths[i]   = menu->menu_path;
+
+      if (menu_scripts[i] < 0)
+        {
+          g_debug ("script_fu_cache_insert: not caching %s, "
+                   "it registers a menu for another file's script", group);
+
+          g_free (menu_scripts);
+          g_free (menu_paths);
+          g_free (group);
+
+          return;
+        }
+    }
+
+  g_key_file_set_uint64 (cache->key_file, group, "mtime",
+                         g_file_info_get_attribute_uint64 (info,
+                                                           G_FILE_ATTRIBUTE_TIME_MODIFIED));
+  g_key_file_set_integer (cache->key_file, group, "mtime-usec",
+                          g_file_info_get_attribute_uint32 (info,
+                                                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+  g_key_file_set_int64 (cache->key_file, group, "size",
+                        g_file_info_get_size (info));
+
+  g_key_file_set_integer (cache->key_file, group, "n-scripts",
+                          g_list_length (scripts));
+
+  for (list = scripts, i = 0; list; list = g_list_next (list), i++)
+    script_fu_cache_write_script (cache->key_file, group, i, list->data);
+
+  g_key_file_set_integer_list (cache->key_file, group, "menu-scripts",
+                               menu_scripts, n_menus);
+  g_key_file_set_string_list (cache->key_file, group, "menu-paths",
+                              (const gchar * const *) menu_paths, n_menus);
+  g_key_file_set_string_list (cache->key_file, group, "procedures",
+                              (const gchar * const *) procedures,
+                              g_strv_length (procedures));
+
+  g_free (menu_scripts);
+  g_free (menu_paths);
+
+  g_hash_table_add (cache->visited, group);
+  cache->dirty = TRUE;
+}
+
+/* Drop the entries of files which were not seen by this session,
+ * and write the cache if it changed.
+ */
+void
+script_fu_cache_save (SFCache *cache)
+{
+  gchar  **groups;
+  gint     i;
+  GError  *error = NULL;
+
+  g_return_if_fail (cache != NULL);
+
+  groups = g_key_file_get_groups (cache->key_file, NULL);
+
+  for (i = 0; groups[i]; i++)
+    {
+      if (strcmp (groups[i], SCRIPT_FU_CACHE_HEADER) &&
+          ! g_hash_table_contains (cache->visited, groups[i]))
+        {
+          g_key_file_remove_group (cache->key_file, groups[i], NULL);
+          cache->dirty = TRUE;
+        }
+    }
+
+  g_strfreev (groups);
+
+  if (! cache->dirty)
+    return;
+
+  if (g_mkdir_with_parents (gimp_cache_directory (), 0700) != 0 ||
+      ! g_key_file_save_to_file (cache->key_file, cache->filename, &error))
+    {
+      /* The cache is only an optimization, failing to write it is harmless. */
+      g_debug ("script_fu_cache_save: could not write %s: %s",
+               gimp_filename_to_utf8 (cache->filename),
+               error ? error->message : g_strerror (errno));
+
+      g_clear_error (&error);
+      return;
+    }
+
+  cache->dirty = FALSE;
+}
+
+
+/*  private functions  */
+
+static gchar *
+script_fu_cache_get_languages (void)
+{
+  return g_strjoinv (":", (gchar **) g_get_language_names ());
+}
+
+static gboolean
+script_fu_cache_header_valid (GKeyFile *key_file)
+{
+  gchar    *gimp_version;
+  gchar    *languages;
+  gchar    *current_languages;
+  gboolean  valid;
+
+  if (g_key_file_get_integer (key_file, SCRIPT_FU_CACHE_HEADER,
+                              "version", NULL) != SCRIPT_FU_CACHE_VERSION)
+    return FALSE;
+
+  gimp_version      = g_key_file_get_string (key_file, SCRIPT_FU_CACHE_HEADER,
+                                             "gimp-version", NULL);
+  languages         = g_key_file_get_string (key_file, SCRIPT_FU_CACHE_HEADER,
+                                             "languages", NULL);
+  current_languages = script_fu_cache_get_languages ();
+
+  valid = (! g_strcmp0 (gimp_version, GIMP_VERSION) &&
+           ! g_strcmp0 (languages, current_languages));
+
+  g_free (gimp_version);
+  g_free (languages);
+  g_free (current_languages);
+
+  return valid;
+}
+
+static void
+script_fu_cache_set_header (GKeyFile *key_file)
+{
+  gchar *languages = script_fu_cache_get_languages ();
+
+  g_key_file_set_integer (key_file, SCRIPT_FU_CACHE_HEADER,
+                          "version", SCRIPT_FU_CACHE_VERSION);
+  g_key_file_set_string (key_file, SCRIPT_FU_CACHE_HEADER,
+                         "gimp-version", GIMP_VERSION);
+  g_key_file_set_string (key_file, SCRIPT_FU_CACHE_HEADER,
+                         "languages", languages);
+
+  g_free (languages);
+}
+
+/* Return the group of file, or NULL if its path can't name a group. */
+static gchar *
+script_fu_cache_get_group (GFile *file)
+{
+  gchar *path = g_file_get_path (file);
+
+  if (path && (strpbrk (path, "[]\n\r") || ! g_utf8_validate (path, -1, NULL)))
+    g_clear_pointer (&path, g_free);
+
+  return path;
+}
+
+static gboolean
+script_fu_cache_info_matches (SFCache     *cache,
+                              const gchar *group,
+                              GFileInfo   *info)
+{
+  GError  *error = NULL;
+  guint64  mtime;
+  gint     mtime_usec;
+  gint64   size;
+
+  if (! g_key_file_has_group (cache->key_file, group))
+    return FALSE;
+
+  mtime      = g_key_file_get_uint64  (cache->key_file, group, "mtime", &error);
+  mtime_usec = error ? 0 : g_key_file_get_integer (cache->key_file, group,
+                                                   "mtime-usec", &error);
+  size       = error ? 0 : g_key_file_get_int64 (cache->key_file, group,
+                                                 "size", &error);
+
+  if (error)
+    {
+      g_clear_error (&error);
+      return FALSE;
+    }
+
+  return (mtime      == g_file_info_get_attribute_uint64 (info,
+                                                          G_FILE_ATTRIBUTE_TIME_MODIFIED) &&
+          mtime_usec == g_file_info_get_attribute_uint32 (info,
+                                                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC) &&
+          size       == g_file_info_get_size (info));
+}
+
+/* Return a new SFScript the same as the one script-fu-register
+ * created when the entry was inserted.
+ */
+static SFScript *
+script_fu_cache_read_script (GKeyFile     *key_file,
+                             const gchar  *group,
+                             gint          index,
+                             GError      **error)
+{
+  SFScript *script = NULL;
+  gchar    *prefix;
+  gchar    *name;
+  gchar    *menu_label;
+  gchar    *blurb;
+  gchar    *author;
+  gchar    *copyright;
+  gchar    *date;
+  gchar    *image_types;
+  gint      n_args;
+  gint      drawable_arity;
+  gboolean  is_filter;
+  gint      i;
+
+  prefix = g_strdup_printf ("script-%d", index);
+
+  name           = script_fu_cache_get_string  (key_file, group, prefix, "name",           error);
+  menu_label     = script_fu_cache_get_string  (key_file, group, prefix, "menu-label",     error);
+  blurb          = script_fu_cache_get_string  (key_file, group, prefix, "blurb",          error);
+  author         = script_fu_cache_get_string  (key_file, group, prefix, "author",         error);
+  copyright      = script_fu_cache_get_string  (key_file, group, prefix, "copyright",      error);
+  date           = script_fu_cache_get_string  (key_file, group, prefix, "date",           error);
+  image_types    = script_fu_cache_get_string  (key_file, group, prefix, "image-types",    error);
+  n_args         = script_fu_cache_get_integer (key_file, group, prefix, "n-args",         error);
+  drawable_arity = script_fu_cache_get_integer (key_file, group, prefix, "drawable-arity", error);
+  is_filter      = script_fu_cache_get_integer (key_file, group, prefix, "filter",         error);
+
+  if (! *error && n_args < 0)
+    g_set_error_literal (error, G_KEY_FILE_ERROR,
+                         G_KEY_FILE_ERROR_INVALID_VALUE,
+                         "invalid number of arguments");
+
+  if (! *error)
+    {
+      script = script_fu_script_new (name,
+                                     menu_label,
+                                     blurb,
+                                     author,
+                                     copyright,
+                                     date,
+                                     image_types,
+                                     n_args);
+
+      script->drawable_arity = drawable_arity;
+      script->proc_class     = is_filter ? GIMP_TYPE_IMAGE_PROCEDURE :
+                                           GIMP_TYPE_PROCEDURE;
+
+      for (i = 0; i < n_args && ! *error; i++)
+        {
+          gchar *arg_prefix = g_strdup_printf ("%s-arg-%d", prefix, i);
+
+          script_fu_cache_read_arg (key_file, group, arg_prefix,
+                                    &script->args[i], error);
+
+          g_free (arg_prefix);
+        }
+
+      if (*error)
+        {
+          g_clear_pointer (&script, script_fu_script_free);
+        }
+      else if (! is_filter)
+        {
+          /*  like script-fu-register, fill all values from defaults  */
+          script_fu_script_reset (script, TRUE);
+        }
+    }
+
+  g_free (name);
+  g_free (menu_label);
+  g_free (blurb);
+  g_free (author);
+  g_free (copyright);
+  g_free (date);
+  g_free (image_types);
+  g_free (prefix);
+
+  return script;
+}
+
+static void
+script_fu_cache_read_arg (GKeyFile     *key_file,
+                          const gchar  *group,
+                          const gchar  *prefix,
+                          SFArg        *arg,
+                          GError      **error)
+{
+  gint type = script_fu_cache_get_integer (key_file, group, prefix, "type",
+                                           error);
+
+  if (*error)
+    return;
+
+  if (type < SF_IMAGE || type > SF_DISPLAY)
+    {
+      g_set_error_literal (error, G_KEY_FILE_ERROR,
+                           G_KEY_FILE_ERROR_INVALID_VALUE,
+                           "invalid argument type");
+      return;
+    }
+
+  /*  once the type is set, script_fu_arg_free() frees what is read  */
+  arg->type  = type;
+  arg->label = script_fu_cache_get_string (key_file, group, prefix, "label",
+                                           error);
+
+  switch (arg->type)
+    {
+    case SF_IMAGE:
+    case SF_DRAWABLE:
+    case SF_LAYER:
+    case SF_CHANNEL:
+    case SF_VECTORS:
+    case SF_DISPLAY:
+      arg->default_value.sfa_image =
+        script_fu_cache_get_integer (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_COLOR:
+      {
+        gdouble *rgba = script_fu_cache_get_doubles (key_file, group, prefix,
+                                                     "default", 4, error);
+
+        if (rgba)
+          gimp_rgba_set (&arg->default_value.sfa_color,
+                         rgba[0], rgba[1], rgba[2], rgba[3]);
+
+        g_free (rgba);
+      }
+      break;
+
+    case SF_TOGGLE:
+      arg->default_value.sfa_toggle =
+        script_fu_cache_get_integer (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_VALUE:
+    case SF_STRING:
+    case SF_TEXT:
+      arg->default_value.sfa_value =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_ADJUSTMENT:
+      {
+        gdouble *adj = script_fu_cache_get_doubles (key_file, group, prefix,
+                                                    "default", 7, error);
+
+        if (adj)
+          {
+            arg->default_value.sfa_adjustment.value  = adj[0];
+            arg->default_value.sfa_adjustment.lower  = adj[1];
+            arg->default_value.sfa_adjustment.upper  = adj[2];
+            arg->default_value.sfa_adjustment.step   = adj[3];
+            arg->default_value.sfa_adjustment.page   = adj[4];
+            arg->default_value.sfa_adjustment.digits = adj[5];
+            arg->default_value.sfa_adjustment.type   = adj[6];
+          }
+
+        g_free (adj);
+      }
+      break;
+
+    case SF_FILENAME:
+    case SF_DIRNAME:
+      arg->default_value.sfa_file.filename =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_FONT:
+      arg->default_value.sfa_font =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_PALETTE:
+      arg->default_value.sfa_palette =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_PATTERN:
+      arg->default_value.sfa_pattern =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_BRUSH:
+      arg->default_value.sfa_brush =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_GRADIENT:
+      arg->default_value.sfa_gradient =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      break;
+
+    case SF_OPTION:
+      {
+        gchar **options = script_fu_cache_get_strings (key_file, group, prefix,
+                                                       "default", error);
+        gint    i;
+
+        for (i = 0; options && options[i]; i++)
+          {
+            arg->default_value.sfa_option.list =
+              g_slist_append (arg->default_value.sfa_option.list,
+                              g_strdup (options[i]));
+          }
+
+        g_strfreev (options);
+      }
+      break;
+
+    case SF_ENUM:
+      arg->default_value.sfa_enum.type_name =
+        script_fu_cache_get_string (key_file, group, prefix, "default", error);
+      arg->default_value.sfa_enum.history =
+        script_fu_cache_get_integer (key_file, group, prefix, "default-value",
+                                     error);
+      break;
+    }
+}
+
+static void
+script_fu_cache_write_script (GKeyFile    *key_file,
+                              const gchar *group,
+                              gint         index,
+                              SFScript    *script)
+{
+  gchar *prefix = g_strdup_printf ("script-%d", index);
+  gchar *key;
+  gint   i;
+
+#define SET_STRING(name, value)                                 \
+  key = g_strdup_printf ("%s-%s", prefix, name);                \
+  g_key_file_set_string (key_file, group, key, value);          \
+  g_free (key)
+
+#define SET_INTEGER(name, value)                                \
+  key = g_strdup_printf ("%s-%s", prefix, name);                \
+  g_key_file_set_integer (key_file, group, key, value);         \
+  g_free (key)
+
+  SET_STRING  ("name",           script->name);
+  SET_STRING  ("menu-label",     script->menu_label);
+  SET_STRING  ("blurb",          script->blurb);
+  SET_STRING  ("author",         script->author);
+  SET_STRING  ("copyright",      script->copyright);
+  SET_STRING  ("date",           script->date);
+  SET_STRING  ("image-types",    script->image_types);
+  SET_INTEGER ("n-args",         script->n_args);
+  SET_INTEGER ("drawable-arity", script->drawable_arity);
+  SET_INTEGER ("filter",         script->proc_class == GIMP_TYPE_IMAGE_PROCEDURE);
+
+#undef SET_STRING
+#undef SET_INTEGER
+
+  for (i = 0; i < script->n_args; i++)
+    {
+      gchar *arg_prefix = g_strdup_printf ("%s-arg-%d", prefix, i);
+
+      script_fu_cache_write_arg (key_file, group, arg_prefix,
+                                 &script->args[i]);
+
+      g_free (arg_prefix);
+    }
+
+  g_free (prefix);
+}
+
+static void
+script_fu_cache_write_arg (GKeyFile    *key_file,
+                           const gchar *group,
+                           const gchar *prefix,
+                           SFArg       *arg)
+{
+  SFArgValue *value = &arg->default_value;
+  gchar      *type_key;
+  gchar      *label_key;
+  gchar      *key;
+
+  type_key  = g_strdup_printf ("%s-type",    prefix);
+  label_key = g_strdup_printf ("%s-label",   prefix);
+  key       = g_strdup_printf ("%s-default", prefix);
+
+  g_key_file_set_integer (key_file, group, type_key,  arg->type);
+  g_key_file_set_string  (key_file, group, label_key, arg->label);
+
+  switch (arg->type)
+    {
+    case SF_IMAGE:
+    case SF_DRAWABLE:
+    case SF_LAYER:
+    case SF_CHANNEL:
+    case SF_VECTORS:
+    case SF_DISPLAY:
+      g_key_file_set_integer (key_file, group, key, value->sfa_image);
+      break;
+
+    case SF_COLOR:
+      {
+        gdouble rgba[4] = { value->sfa_color.r, value->sfa_color.g,
+                            value->sfa_color.b, value->sfa_color.a };
+
+        g_key_file_set_double_list (key_file, group, key, rgba, 4);
+      }
+      break;
+
+    case SF_TOGGLE:
+      g_key_file_set_integer (key_file, group, key, value->sfa_toggle);
+      break;
+
+    case SF_VALUE:
+    case SF_STRING:
+    case SF_TEXT:
+      g_key_file_set_string (key_file, group, key, value->sfa_value);
+      break;
+
+    case SF_ADJUSTMENT:
+      {
+        gdouble adj[7] = { value->sfa_adjustment.value,
+                           value->sfa_adjustment.lower,
+                           value->sfa_adjustment.upper,
+                           value->sfa_adjustment.step,
+                           value->sfa_adjustment.page,
+                           value->sfa_adjustment.digits,
+                           value->sfa_adjustment.type };
+
+        g_key_file_set_double_list (key_file, group, key, adj, 7);
+      }
+      break;
+
+    case SF_FILENAME:
+    case SF_DIRNAME:
+      g_key_file_set_string (key_file, group, key, value->sfa_file.filename);
+      break;
+
+    case SF_FONT:
+      g_key_file_set_string (key_file, group, key, value->sfa_font);
+      break;
+
+    case SF_PALETTE:
+      g_key_file_set_string (key_file, group, key, value->sfa_palette);
+      break;
+
+    case SF_PATTERN:
+      g_key_file_set_string (key_file, group, key, value->sfa_pattern);
+      break;
+
+    case SF_BRUSH:
+      g_key_file_set_string (key_file, group, key, value->sfa_brush);
+      break;
+
+    case SF_GRADIENT:
+      g_key_file_set_string (key_file, group, key, value->sfa_gradient);
+      break;
+
+    case SF_OPTION:
+      {
+        GSList       *list;
+        const gchar **options;
+        gint          n_options = g_slist_length (value->sfa_option.list);
+        gint          i;
+
+        options = g_new (const gchar *, n_options);
+
+        for (list = value->sfa_option.list, i = 0;
+             list;
+             list = g_slist_next (list), i++)
+          {
+            options[i] = list->data;
+          }
+
+        g_key_file_set_string_list (key_file, group, key,
+                                    options, n_options);
+
+        g_free (options);
+      }
+      break;
+
+    case SF_ENUM:
+      {
+        gchar *history_key = g_strdup_printf ("%s-default-value", prefix);
+
+        g_key_file_set_string  (key_file, group, key,
+                                value->sfa_enum.type_name);
+        g_key_file_set_integer (key_file, group, history_key,
+                                value->sfa_enum.history);
+
+        g_free (history_key);
+      }
+      break;
+    }
+
+  g_free (type_key);
+  g_free (label_key);
+  g_free (key);
+}
+
+/*  The getters do nothing once error is set, so a sequence of reads
+ *  only needs to check for an error at its end.
+ */
+
+static gchar *
+script_fu_cache_get_string (GKeyFile     *key_file,
+                            const gchar  *group,
+                            const gchar  *prefix,
+                            const gchar  *name,
+                            GError      **error)
+{
+  gchar *key;
+  gchar *value;
+
+  if (*error)
+    return NULL;
+
+  key   = g_strdup_printf ("%s-%s", prefix, name);
+  value = g_key_file_get_string (key_file, group, key, error);
+
+  g_free (key);
+
+  return value;
+}
+
+static gint
+script_fu_cache_get_integer (GKeyFile     *key_file,
+                             const gchar  *group,
+                             const gchar  *prefix,
+                             const gchar  *name,
+                             GError      **error)
+{
+  gchar *key;
+  gint   value;
+
+  if (*error)
+    return 0;
+
+  key   = g_strdup_printf ("%s-%s", prefix, name);
+  value = g_key_file_get_integer (key_file, group, key, error);
+
+  g_free (key);
+
+  return value;
+}
+
+static gdouble *
+script_fu_cache_get_doubles (GKeyFile     *key_file,
+                             const gchar  *group,
+                             const gchar  *prefix,
+                             const gchar  *name,
+                             gsize         length,
+                             GError      **error)
+{
+  gchar   *key;
+  gdouble *values;
+  gsize    n_values;
+
+  if (*error)
+    return NULL;
+
+  key    = g_strdup_printf ("%s-%s", prefix, name);
+  values = g_key_file_get_double_list (key_file, group, key, &n_values,
+                                       error);
+
+  g_free (key);
+
+  if (values && n_values != length)
+    {
+      g_set_error_literal (error, G_KEY_FILE_ERROR,
+                           G_KEY_FILE_ERROR_INVALID_VALUE,
+                           "wrong number of values");
+      g_clear_pointer (&values, g_free);
+    }
+
+  return values;
+}
+
+static gchar **
+script_fu_cache_get_strings (GKeyFile     *key_file,
+                             const gchar  *group,
+                             const gchar  *prefix,
+                             const gchar  *name,
+                             GError      **error)
+{
+  gchar  *key;
+  gchar **values;
+
+  if (*error)
+    return NULL;
+
+  key    = g_strdup_printf ("%s-%s", prefix, name);
+  values = g_key_file_get_string_list (key_file, group, key, NULL, error);
+
+  g_free (key);
+
+  return values;
+}
@@ -0,0 +1,44 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SCRIPT_FU_CACHE_H__
+#define __SCRIPT_FU_CACHE_H__
+
+
+typedef struct _SFCache SFCache;
+
+
+SFCache  * script_fu_cache_new    (void);
+void       script_fu_cache_free   (SFCache   *cache);
+
+gboolean   script_fu_cache_lookup (SFCache   *cache,
+                                   GFile     *file,
+                                   GFileInfo *info,
+                                   GList    **scripts,
+                                   GList    **menus,
+                                   gchar   ***procedures);
+void       script_fu_cache_insert (SFCache   *cache,
+                                   GFile     *file,
+                                   GFileInfo *info,
+                                   GList     *scripts,
+                                   GList     *menus,
+                                   gchar    **procedures);
+
+void       script_fu_cache_save   (SFCache   *cache);
+
+
+#endif /*  __SCRIPT_FU_CACHE_H__  */
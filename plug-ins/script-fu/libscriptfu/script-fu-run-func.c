@@ -64,6 +64,7 @@ script_fu_run_image_procedure ( GimpProcedure         *procedure, /* GimpImagePr
 
   GimpValueArray    *result = NULL;
   SFScript          *script;
+  GError            *error  = NULL;
 
   g_debug ("script_fu_run_image_procedure");
   script = script_fu_find_script (gimp_procedure_get_name (procedure));
@@ -71,6 +72,10 @@ script_fu_run_image_procedure ( GimpProcedure         *procedure, /* GimpImagePr
   if (! script)
     return gimp_procedure_new_return_values (procedure, GIMP_PDB_CALLING_ERROR, NULL);
 
+  /*  the script's file may not be loaded yet, when registered from the cache  */
+  if (! script_fu_ensure_script_loaded (script->name, &error))
+    return gimp_procedure_new_return_values (procedure, GIMP_PDB_EXECUTION_ERROR, error);
+
   ts_set_run_mode (run_mode);
 
   switch (run_mode)
@@ -140,6 +145,12 @@ script_fu_run_procedure (GimpProcedure        *procedure,
                                              GIMP_PDB_CALLING_ERROR,
                                              NULL);
 
+  /*  the script's file may not be loaded yet, when registered from the cache  */
+  if (! script_fu_ensure_script_loaded (script->name, &error))
+    return gimp_procedure_new_return_values (procedure,
+                                             GIMP_PDB_EXECUTION_ERROR,
+                                             error);
+
   run_mode = GIMP_VALUES_GET_ENUM (args, 0);
 
   ts_set_run_mode (run_mode);
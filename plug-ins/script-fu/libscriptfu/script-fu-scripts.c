@@ -29,7 +29,9 @@
 
 #include "tinyscheme/scheme-private.h"
 
+#include "scheme-wrapper.h"
 #include "script-fu-types.h"
+#include "script-fu-cache.h"
 #include "script-fu-script.h"
 #include "script-fu-scripts.h"
 #include "script-fu-utils.h"
@@ -44,7 +46,20 @@
  */
 
 static void             script_fu_load_directory (GFile                *directory);
-static void             script_fu_load_script    (GFile                *file);
+static void             script_fu_load_script    (GFile                *file,
+                                                  GFileInfo            *info);
+static gboolean         script_fu_load_cached_script
+                                                 (GFile                *file,
+                                                  GFileInfo            *info);
+static gboolean         script_fu_eval_file      (GFile                *file,
+                                                  GError              **error);
+static void             script_fu_define_stub    (const gchar          *name);
+static gboolean         script_fu_is_cached_registration
+                                                 (scheme               *sc,
+                                                  pointer               a);
+static const gchar    * script_fu_take_unloaded_file
+                                                 (GHashTable           *names,
+                                                  const gchar          *name);
 static gboolean         script_fu_install_script (gpointer              foo,
                                                   GList                *scripts,
                                                   gpointer              data);
@@ -67,6 +82,23 @@ static void             script_fu_append_script_to_tree  (SFScript     *script);
 static GTree *script_tree      = NULL;
 static GList *script_menu_list = NULL;
 
+/* While finding scripts to register, the cache of what files register,
+ * and what the file being loaded registered, to insert into the cache.
+ */
+static SFCache *script_cache = NULL;
+static GList   *file_scripts = NULL;
+static GList   *file_menus   = NULL;
+
+/* For the files registered from the cache, map the name of each script
+ * they register, and of each procedure they define, to the path of the
+ * file, and keep the set of those files loaded since, on demand: when
+ * one of their scripts is first run, or one of their procedures is
+ * first called.
+ */
+static GHashTable *cached_scripts    = NULL;
+static GHashTable *cached_procedures = NULL;
+static GHashTable *loaded_files      = NULL;
+
 
 /*
  *  Function definitions
@@ -101,6 +133,22 @@ script_fu_find_scripts_into_tree ( GimpPlugIn *plug_in,
 
   script_tree = g_tree_new ((GCompareFunc) g_utf8_collate);
 
+  if (cached_scripts)
+    {
+      g_hash_table_remove_all (cached_scripts);
+      g_hash_table_remove_all (cached_procedures);
+      g_hash_table_remove_all (loaded_files);
+    }
+  else
+    {
+      cached_scripts    = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, g_free);
+      cached_procedures = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, g_free);
+      loaded_files      = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, NULL);
+    }
+
   if (paths)
     {
       GList *list;
@@ -132,13 +180,27 @@ script_fu_get_menu_list (void)
 
 /* Find scripts, create and install TEMPORARY PDB procedures,
  * owned by self PDB procedure (e.g. extension-script-fu.)
+ *
+ * When scripts register, what unchanged files registered is taken
+ * from the cache, without loading them.  They are loaded
+ * by script_fu_ensure_script_loaded() when a script is first run,
+ * or by the stubs of their procedures when one is first called.
  */
 void
 script_fu_find_scripts (GimpPlugIn *plug_in,
                         GList      *path)
 {
+  if (ts_get_register_scripts ())
+    script_cache = script_fu_cache_new ();
+
   script_fu_find_scripts_into_tree (plug_in, path);
 
+  if (script_cache)
+    {
+      script_fu_cache_save (script_cache);
+      g_clear_pointer (&script_cache, script_fu_cache_free);
+    }
+
   /*  Now that all scripts are read in and sorted, tell gimp about them  */
   g_tree_foreach (script_tree,
                   (GTraverseFunc) script_fu_install_script,
@@ -168,6 +230,9 @@ script_fu_add_script (scheme  *sc,
   SFScript    *script;
   pointer      args_error;
 
+  if (script_fu_is_cached_registration (sc, a))
+    return sc->NIL;
+
   /*  Check metadata args args are present */
   if (sc->vptr->list_length (sc, a) < 7)
     return foreign_error (sc, "script-fu-register: Not enough arguments", 0);
@@ -199,6 +264,10 @@ script_fu_add_script (scheme  *sc,
 
   script_fu_try_map_menu (script);
   script_fu_append_script_to_tree (script);
+
+  if (script_cache)
+    file_scripts = g_list_append (file_scripts, script);
+
   return sc->NIL;
 }
 
@@ -218,6 +287,9 @@ script_fu_add_script_filter (scheme  *sc,
   SFScript    *script;
   pointer      args_error;  /* a foreign_error or NIL. */
 
+  if (script_fu_is_cached_registration (sc, a))
+    return sc->NIL;
+
   /* Check metadata args args are present.
    * Has one more arg than script-fu-register.
    */
@@ -246,6 +318,10 @@ script_fu_add_script_filter (scheme  *sc,
 
   script_fu_try_map_menu (script);
   script_fu_append_script_to_tree (script);
+
+  if (script_cache)
+    file_scripts = g_list_append (file_scripts, script);
+
   return sc->NIL;
 }
 
@@ -258,6 +334,9 @@ script_fu_add_menu (scheme  *sc,
   const gchar *name;
   const gchar *path;
 
+  if (script_fu_is_cached_registration (sc, a))
+    return sc->NIL;
+
   /*  Check the length of a  */
   if (sc->vptr->list_length (sc, a) != 2)
     return foreign_error (sc, "Incorrect number of arguments for script-fu-menu-register", 0);
@@ -290,9 +369,77 @@ script_fu_add_menu (scheme  *sc,
 
   script_menu_list = g_list_prepend (script_menu_list, menu);
 
+  if (script_cache)
+    file_menus = g_list_append (file_menus, menu);
+
   return sc->NIL;
 }
 
+/* Load the file of the script named name, if the script was registered
+ * from the cache and its file is not loaded yet, so that its run func
+ * is defined.
+ *
+ * Return FALSE and set error when loading the file fails.
+ */
+gboolean
+script_fu_ensure_script_loaded (const gchar  *name,
+                                GError      **error)
+{
+  const gchar *path;
+  GFile       *file;
+  gboolean     success;
+
+  path = script_fu_take_unloaded_file (cached_scripts, name);
+
+  if (! path)
+    return TRUE;
+
+  g_debug ("script_fu_ensure_script_loaded: loading %s for %s", path, name);
+
+  /*  loading the file defines the run funcs of all its scripts,
+   *  its calls to register them are ignored
+   */
+  file    = g_file_new_for_path (path);
+  success = script_fu_eval_file (file, error);
+
+  g_object_unref (file);
+
+  return success;
+}
+
+/* For a call to script-fu-cached-file, from the stub of a procedure
+ * defined by a file registered from the cache.
+ * Mark the file as loaded, for the stub to load it, which replaces
+ * the stub by the procedure.
+ *
+ * Return the path of the file, or a foreign_error
+ * if the procedure is not from a file still to load.
+ */
+pointer
+script_fu_get_cached_file (scheme  *sc,
+                           pointer  a)
+{
+  const gchar *name;
+  const gchar *path;
+
+  if (sc->vptr->list_length (sc, a) != 1 ||
+      ! sc->vptr->is_string (sc->vptr->pair_car (a)))
+    return foreign_error (sc, "script-fu-cached-file: Expected a procedure name", 0);
+
+  name = sc->vptr->string_value (sc->vptr->pair_car (a));
+  path = script_fu_take_unloaded_file (cached_procedures, name);
+
+  /*  the file was loaded, but did not define the procedure, don't
+   *  let the stub call itself forever
+   */
+  if (! path)
+    return foreign_error (sc, "script-fu-cached-file: Procedure not defined by its file", 0);
+
+  g_debug ("script_fu_get_cached_file: loading %s for %s", path, name);
+
+  return sc->vptr->mk_string (sc, path);
+}
+
 
 /*  private functions  */
 
@@ -306,7 +453,10 @@ script_fu_load_directory (GFile *directory)
   enumerator = g_file_enumerate_children (directory,
                                           G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
-                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
                                           G_FILE_QUERY_INFO_NONE,
                                           NULL, NULL);
 
@@ -327,7 +477,7 @@ script_fu_load_directory (GFile *directory)
               if (file_type == G_FILE_TYPE_DIRECTORY)
                 script_fu_load_directory (child);
               else
-                script_fu_load_script (child);
+                script_fu_load_script (child, info);
 
               g_object_unref (child);
             }
@@ -340,19 +490,31 @@ script_fu_load_directory (GFile *directory)
 }
 
 static void
-script_fu_load_script (GFile *file)
+script_fu_load_script (GFile     *file,
+                       GFileInfo *info)
 {
   if (gimp_file_has_extension (file, ".scm"))
     {
-      gchar  *path    = g_file_get_path (file);
-      gchar  *escaped = script_fu_strescape (path);
-      gchar  *command;
-      GError *error   = NULL;
+      GError      *error      = NULL;
+      GHashTable  *bindings   = NULL;
+      gchar      **procedures = NULL;
+      gboolean     success;
+
+      if (script_cache && script_fu_load_cached_script (file, info))
+        return;
+
+      if (script_cache)
+        bindings = ts_get_global_bindings ();
 
-      command = g_strdup_printf ("(load \"%s\")", escaped);
-      g_free (escaped);
+      success = script_fu_eval_file (file, &error);
 
-      if (! script_fu_run_command (command, &error))
+      if (bindings)
+        {
+          procedures = ts_get_new_procedures (bindings);
+          g_hash_table_unref (bindings);
+        }
+
+      if (! success)
         {
           gchar *message = g_strdup_printf (_("Error while loading %s:"),
                                             gimp_file_get_utf8_name (file));
@@ -363,16 +525,182 @@ script_fu_load_script (GFile *file)
           g_free (message);
         }
 
+      if (script_cache)
+        {
+          GList *list;
+
+          /*  Only cache files which registered scripts whose run funcs
+           *  they define, and which only define new procedures, which
+           *  can be stubbed until the file is loaded.  Other files,
+           *  e.g. of utility variables used by other scripts,
+           *  are always loaded.
+           */
+          for (list = file_scripts; list && success; list = g_list_next (list))
+            {
+              SFScript *script = list->data;
+
+              success = script_fu_is_defined (script->name);
+            }
+
+          if (file_scripts && success && procedures)
+            script_fu_cache_insert (script_cache, file, info,
+                                    file_scripts, file_menus,
+                                    procedures);
+
+          g_clear_pointer (&file_scripts, g_list_free);
+          g_clear_pointer (&file_menus,   g_list_free);
+          g_strfreev (procedures);
+        }
+
 #ifdef G_OS_WIN32
       /* No, I don't know why, but this is
        * necessary on NT 4.0.
        */
       Sleep (0);
 #endif
+    }
+}
+
+/* Register the scripts and menus of file from the cache,
+ * without loading it, and define stubs of the procedures it defines,
+ * for other files calling them.
+ *
+ * Return FALSE if the cache has no entry for the file as it is now.
+ */
+static gboolean
+script_fu_load_cached_script (GFile     *file,
+                              GFileInfo *info)
+{
+  GList  *scripts;
+  GList  *menus;
+  gchar **procedures;
+  GList  *list;
+  gchar  *path;
+  gint    i;
+
+  if (! script_fu_cache_lookup (script_cache, file, info,
+                                &scripts, &menus, &procedures))
+    return FALSE;
+
+  path = g_file_get_path (file);
+
+  for (list = scripts; list; list = g_list_next (list))
+    {
+      SFScript *script = list->data;
+
+      script_fu_append_script_to_tree (script);
+
+      g_hash_table_insert (cached_scripts,
+                           g_strdup (script->name), g_strdup (path));
+    }
+
+  for (i = 0; procedures[i]; i++)
+    {
+      g_hash_table_insert (cached_procedures,
+                           g_strdup (procedures[i]), g_strdup (path));
+
+      script_fu_define_stub (procedures[i]);
+    }
+
+  script_menu_list = g_list_concat (menus, script_menu_list);
+
+  g_list_free (scripts);
+  g_strfreev (procedures);
+  g_free (path);
+
+  return TRUE;
+}
+
+/* Have the interpreter load and evaluate file. */
+static gboolean
+script_fu_eval_file (GFile   *file,
+                     GError **error)
+{
+  gchar    *path    = g_file_get_path (file);
+  gchar    *escaped = script_fu_strescape (path);
+  gchar    *command;
+  gboolean  success;
+
+  command = g_strdup_printf ("(load \"%s\")", escaped);
+  g_free (escaped);
+
+  success = script_fu_run_command (command, error);
+
+  g_free (command);
+  g_free (path);
 
-      g_free (command);
-      g_free (path);
+  return success;
+}
+
+/* Define name as a procedure which loads the file defining name,
+ * which redefines name, and calls it with its arguments.
+ *
+ * The file is loaded in the global environment, as at top level.
+ */
+static void
+script_fu_define_stub (const gchar *name)
+{
+  gchar  *escaped = script_fu_strescape (name);
+  gchar  *command;
+  GError *error   = NULL;
+
+  command = g_strdup_printf ("(define (%s . args)"
+                             "  (eval (list 'load (script-fu-cached-file \"%s\"))"
+                             "        (interaction-environment))"
+                             "  (apply %s args))",
+                             name, escaped, name);
+
+  if (! script_fu_run_command (command, &error))
+    {
+      g_warning ("Could not define stub of %s: %s", name, error->message);
+      g_clear_error (&error);
     }
+
+  g_free (command);
+  g_free (escaped);
+}
+
+/* Return the path of the file, from names, of the script or procedure
+ * named name, and mark the file as loaded, or NULL if name is not from
+ * the cache, or its file was already loaded.
+ */
+static const gchar *
+script_fu_take_unloaded_file (GHashTable  *names,
+                              const gchar *name)
+{
+  const gchar *path;
+
+  if (! names)
+    return NULL;
+
+  path = g_hash_table_lookup (names, name);
+
+  if (! path || g_hash_table_contains (loaded_files, path))
+    return NULL;
+
+  g_hash_table_add (loaded_files, g_strdup (path));
+
+  return path;
+}
+
+/* Whether a, the arguments of a registration call, are for a script
+ * registered from the cache, i.e. the call is from its file being
+ * loaded on demand, and must be ignored.
+ */
+static gboolean
+script_fu_is_cached_registration (scheme  *sc,
+                                  pointer  a)
+{
+  pointer name;
+
+  if (! cached_scripts || ! sc->vptr->is_pair (a))
+    return FALSE;
+
+  name = sc->vptr->pair_car (a);
+
+  return (sc->vptr->is_string (name) &&
+          g_hash_table_contains (cached_scripts,
+                                 sc->vptr->string_value (name)));
 }
 
 /* This is-a GTraverseFunction.
@@ -393,7 +721,10 @@ script_fu_install_script (gpointer  foo G_GNUC_UNUSED,
       SFScript *script = list->data;
 
       const gchar* name = script->name;
-      if (script_fu_is_defined (name))
+
+      /*  scripts from the cache were defined when they were cached  */
+      if (g_hash_table_contains (cached_scripts, name) ||
+          script_fu_is_defined (name))
         script_fu_script_install_proc (plug_in, script);
       else
         g_warning ("Run function not defined, or does not match PDB procedure name: %s", name);
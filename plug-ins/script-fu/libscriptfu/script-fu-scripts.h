@@ -26,6 +26,8 @@ pointer   script_fu_add_script_filter (scheme     *sc,
                                        pointer     a);
 pointer   script_fu_add_menu      (scheme     *sc,
                                    pointer     a);
+pointer   script_fu_get_cached_file   (scheme     *sc,
+                                       pointer     a);
 
 GTree          * script_fu_find_scripts_into_tree (GimpPlugIn  *plug_in,
                                                    GList       *path);
@@ -33,5 +35,7 @@ SFScript       * script_fu_find_script            (const gchar *name);
 GList          * script_fu_get_menu_list          (void);
 
 gboolean         script_fu_is_defined             (const gchar          *name);
+gboolean         script_fu_ensure_script_loaded   (const gchar          *name,
+                                                   GError              **error);
 
 #endif /*  __SCRIPT_FU_SCRIPTS__  */
@@ -0,0 +1,27 @@
+; A script, and a helper procedure, called by another script's file
+;
+; Setup: copy this file, and cache-caller.scm, to /scripts
+; Example: to ~/.config/GIMP/2.99/scripts/cache-callee.scm
+;
+; See cache-caller.scm
+
+; Not registered, only called by cache-caller.scm
+(define (cache-callee-helper x)
+  (* x 2)
+)
+
+(define (script-fu-cache-callee)
+  (gimp-message "Callee")
+)
+
+(script-fu-register "script-fu-cache-callee"
+  "Cache callee"
+  "Called by Cache caller, from another file"
+  "GIMP"
+  "GIMP"
+  "2023"
+  ""  ; requires no image
+  ; no arguments or dialog
+)
+
+(script-fu-menu-register "script-fu-cache-callee" "<Image>/Test")
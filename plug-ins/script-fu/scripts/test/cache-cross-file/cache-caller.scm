@@ -0,0 +1,37 @@
+; A script that calls a procedure and a script defined in another file,
+; which are not loaded at startup when they are registered from the cache
+;
+; Setup: copy this file, and cache-callee.scm, to /scripts
+; Example: to ~/.config/GIMP/2.99/scripts/cache-caller.scm
+;
+; Start GIMP once, so that extension-script-fu caches both files.
+; Restart GIMP, so that both are registered from the cache,
+; and the procedures they define are stubs.
+
+; Expect "Test>Cache caller" and "Test>Cache callee" in the menus
+; Expect when "Cache caller" chosen, messages on GIMP message bar
+; "Callee" then "Cache caller: 42"
+; Expect the same when chosen again, when the files are loaded
+; Expect the same after touching cache-callee.scm and restarting GIMP,
+; when the callee is loaded at startup
+
+(define (script-fu-cache-caller)
+  ; calls the stub of a script's run func, which loads cache-callee.scm
+  (script-fu-cache-callee)
+  ; calls the helper cache-callee.scm defined
+  (gimp-message
+    (string-append "Cache caller: "
+                   (number->string (cache-callee-helper 21))))
+)
+
+(script-fu-register "script-fu-cache-caller"
+  "Cache caller"
+  "Expect messages Callee, then Cache caller: 42"
+  "GIMP"
+  "GIMP"
+  "2023"
+  ""  ; requires no image
+  ; no arguments or dialog
+)
+
+(script-fu-menu-register "script-fu-cache-caller" "<Image>/Test")